@@ -0,0 +1,876 @@
+/*
+ * CJelly — Benchmark suite
+ * Copyright (c) 2025
+ *
+ * Licensed under the MIT license for prototype purposes.
+ *
+ * Times the parsers on synthetic files, texture uploads, render graph
+ * recording and submission, multi-window frames, handle and atlas churn. Nothing is
+ * presented: graphs render into offscreen images, so no window or swapchain
+ * is created. Each benchmark runs its warmup iterations, then its samples,
+ * and reports min, median, mean, p95, max and standard deviation in
+ * milliseconds as JSON. With --baseline the medians are compared against an
+ * earlier report and the run fails when one regressed past the threshold.
+ *
+ * Run `bench --help` for the options; `make bench` builds and runs it.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <cjelly/atlas_packer_internal.h>
+#include <cjelly/cjelly.h>
+#include <cjelly/cj_engine.h>
+#include <cjelly/cj_handle.h>
+#include <cjelly/cj_resources.h>
+#include <cjelly/cj_rgraph.h>
+#include <cjelly/engine_internal.h>
+#include <cjelly/format/image.h>
+#include <cjelly/format/image/bmp.h>
+#include <cjelly/format/3d/obj.h>
+#include <cjelly/format/3d/mtl.h>
+
+#define BENCH_MAX_RESULTS 64
+#define BENCH_NAME_SIZE 64
+#define BENCH_MAX_SAMPLES 1000
+#define BENCH_MAX_TARGETS 8
+
+#define BENCH_OBJ_PATH "bench_synthetic.obj"
+#define BENCH_MTL_PATH "bench_synthetic.mtl"
+#define BENCH_BMP_PATH "bench_synthetic.bmp"
+
+/* Extent of the offscreen images graphs render into */
+#define BENCH_TARGET_WIDTH 1280u
+#define BENCH_TARGET_HEIGHT 720u
+
+typedef struct bench_result_t {
+  char name[BENCH_NAME_SIZE];
+  uint32_t samples;
+  double min_ms, median_ms, mean_ms, p95_ms, max_ms, stddev_ms;
+  double throughput;            /* work per second at the median, 0 if none */
+  const char* throughput_unit;
+  bool has_baseline;
+  double baseline_median_ms;
+  double delta_pct;             /* median change against the baseline */
+} bench_result_t;
+
+typedef struct bench_t {
+  uint32_t warmup;
+  uint32_t samples;
+  bool quick;
+  const char* filter;
+  bench_result_t results[BENCH_MAX_RESULTS];
+  uint32_t result_count;
+} bench_t;
+
+/* One iteration of a benchmark; returns false to abort it */
+typedef bool (*bench_fn_t)(void* user);
+
+static double bench_now_ms(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER now;
+  if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return (double)now.QuadPart * 1000.0 / (double)freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1.0e6;
+#endif
+}
+
+static int bench_compare_double(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+static bool bench_selected(const bench_t* b, const char* name) {
+  return !b->filter || strstr(name, b->filter) != NULL;
+}
+
+/* Run warmup and timed iterations of fn and record their statistics.
+ * work is the amount fn processes per iteration, reported per second in unit. */
+static void bench_measure(bench_t* b, const char* name, bench_fn_t fn, void* user,
+                          uint32_t samples, double work, const char* unit) {
+  if (!bench_selected(b, name)) return;
+  if (b->result_count >= BENCH_MAX_RESULTS) {
+    fprintf(stderr, "bench: too many results, skipping %s\n", name);
+    return;
+  }
+  if (samples > BENCH_MAX_SAMPLES) samples = BENCH_MAX_SAMPLES;
+  if (samples == 0) samples = 1;
+
+  for (uint32_t i = 0; i < b->warmup; ++i) {
+    if (!fn(user)) {
+      fprintf(stderr, "bench: %s failed during warmup\n", name);
+      return;
+    }
+  }
+
+  static double times[BENCH_MAX_SAMPLES];
+  for (uint32_t i = 0; i < samples; ++i) {
+    double start = bench_now_ms();
+    if (!fn(user)) {
+      fprintf(stderr, "bench: %s failed\n", name);
+      return;
+    }
+    times[i] = bench_now_ms() - start;
+  }
+
+  qsort(times, samples, sizeof(times[0]), bench_compare_double);
+  double sum = 0.0;
+  for (uint32_t i = 0; i < samples; ++i) sum += times[i];
+  double mean = sum / samples;
+  double var = 0.0;
+  for (uint32_t i = 0; i < samples; ++i) var += (times[i] - mean) * (times[i] - mean);
+
+  bench_result_t* r = &b->results[b->result_count++];
+  memset(r, 0, sizeof(*r));
+  snprintf(r->name, sizeof(r->name), "%s", name);
+  r->samples = samples;
+  r->min_ms = times[0];
+  r->max_ms = times[samples - 1];
+  r->median_ms = (samples & 1u) ? times[samples / 2]
+                                : 0.5 * (times[samples / 2 - 1] + times[samples / 2]);
+  r->mean_ms = mean;
+  /* Nearest rank */
+  uint32_t rank = (uint32_t)ceil(0.95 * samples);
+  r->p95_ms = times[(rank > 0 ? rank : 1) - 1];
+  r->stddev_ms = samples > 1 ? sqrt(var / (samples - 1)) : 0.0;
+  if (work > 0.0 && unit && r->median_ms > 0.0) {
+    r->throughput = work / (r->median_ms / 1000.0);
+    r->throughput_unit = unit;
+  }
+
+  if (r->throughput_unit) {
+    fprintf(stderr, "%-32s median %10.4f ms  p95 %10.4f ms  %10.2f %s\n",
+            r->name, r->median_ms, r->p95_ms, r->throughput, r->throughput_unit);
+  } else {
+    fprintf(stderr, "%-32s median %10.4f ms  p95 %10.4f ms\n", r->name, r->median_ms, r->p95_ms);
+  }
+}
+
+/* ===== Synthetic files ===== */
+
+static long bench_file_size(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return -1;
+  long size = -1;
+  if (fseek(f, 0, SEEK_END) == 0) size = ftell(f);
+  fclose(f);
+  return size;
+}
+
+/* A grid of grid x grid vertices triangulated into faces, switching material per row */
+static bool bench_write_obj(const char* path, uint32_t grid) {
+  FILE* f = fopen(path, "w");
+  if (!f) return false;
+  fprintf(f, "# CJelly benchmark mesh\no bench\n");
+  for (uint32_t y = 0; y < grid; ++y) {
+    for (uint32_t x = 0; x < grid; ++x) {
+      float fx = (float)x / (float)(grid - 1), fy = (float)y / (float)(grid - 1);
+      fprintf(f, "v %.6f %.6f %.6f\n", fx * 2.0f - 1.0f, fy * 2.0f - 1.0f, 0.25f * sinf(fx * 6.2832f) * cosf(fy * 6.2832f));
+      fprintf(f, "vt %.6f %.6f\n", fx, fy);
+      fprintf(f, "vn %.6f %.6f %.6f\n", 0.0f, 0.0f, 1.0f);
+    }
+  }
+  for (uint32_t y = 0; y + 1 < grid; ++y) {
+    fprintf(f, "usemtl material_%u\n", y % 16u);
+    for (uint32_t x = 0; x + 1 < grid; ++x) {
+      uint32_t a = y * grid + x + 1, b = a + 1, c = a + grid, d = c + 1;
+      fprintf(f, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, d, d, d);
+      fprintf(f, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, d, d, d, c, c, c);
+    }
+  }
+  return fclose(f) == 0;
+}
+
+static bool bench_write_mtl(const char* path, uint32_t count) {
+  FILE* f = fopen(path, "w");
+  if (!f) return false;
+  fprintf(f, "# CJelly benchmark materials\n");
+  for (uint32_t i = 0; i < count; ++i) {
+    float t = (float)(i % 255u) / 255.0f;
+    fprintf(f, "newmtl material_%u\n", i);
+    fprintf(f, "Ka %.4f %.4f %.4f\n", t, 0.1f, 0.1f);
+    fprintf(f, "Kd %.4f %.4f %.4f\n", 0.8f, t, 0.2f);
+    fprintf(f, "Ks %.4f %.4f %.4f\n", 0.5f, 0.5f, t);
+    fprintf(f, "Ns %.2f\nd 1.0\nillum 2\n", 10.0f + t * 100.0f);
+    fprintf(f, "map_Kd textures/diffuse_%u.bmp\n\n", i % 64u);
+  }
+  return fclose(f) == 0;
+}
+
+/* 24-bit bottom-up BMP with a gradient */
+static bool bench_write_bmp(const char* path, uint32_t width, uint32_t height) {
+  uint32_t row = (width * 3u + 3u) & ~3u;
+  uint32_t pixels = row * height;
+  unsigned char header[54] = {0};
+  uint32_t fields[][2] = {
+    {2, 54u + pixels}, {10, 54u}, {14, 40u}, {18, width}, {22, height}, {34, pixels},
+  };
+  header[0] = 'B';
+  header[1] = 'M';
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+    for (uint32_t k = 0; k < 4; ++k) header[fields[i][0] + k] = (unsigned char)(fields[i][1] >> (8u * k));
+  }
+  header[26] = 1;   /* planes */
+  header[28] = 24;  /* bits per pixel */
+
+  unsigned char* line = (unsigned char*)calloc(row, 1);
+  FILE* f = line ? fopen(path, "wb") : NULL;
+  if (!f) {
+    free(line);
+    return false;
+  }
+  bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+  for (uint32_t y = 0; y < height && ok; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      line[x * 3u + 0] = (unsigned char)(x ^ y);
+      line[x * 3u + 1] = (unsigned char)y;
+      line[x * 3u + 2] = (unsigned char)x;
+    }
+    ok = fwrite(line, row, 1, f) == 1;
+  }
+  free(line);
+  return fclose(f) == 0 && ok;
+}
+
+static void* bench_read_file(const char* path, size_t* out_size) {
+  long size = bench_file_size(path);
+  FILE* f = size > 0 ? fopen(path, "rb") : NULL;
+  if (!f) return NULL;
+  void* data = malloc((size_t)size);
+  if (data && fread(data, (size_t)size, 1, f) != 1) {
+    free(data);
+    data = NULL;
+  }
+  fclose(f);
+  *out_size = (size_t)size;
+  return data;
+}
+
+static bool bench_obj_iteration(void* user) {
+  (void)user;
+  CJellyFormat3dObjModel* model = NULL;
+  if (cjelly_format_3d_obj_load(BENCH_OBJ_PATH, &model) != CJELLY_FORMAT_3D_OBJ_SUCCESS) return false;
+  cjelly_format_3d_obj_free(model);
+  return true;
+}
+
+static bool bench_mtl_iteration(void* user) {
+  (void)user;
+  CJellyFormat3dMtl materials = {0};
+  if (cjelly_format_3d_mtl_load(BENCH_MTL_PATH, &materials) != CJELLY_FORMAT_3D_MTL_SUCCESS) return false;
+  cjelly_format_3d_mtl_free(&materials);
+  return true;
+}
+
+typedef struct bench_bmp_t {
+  const void* data;
+  size_t size;
+  unsigned char* pixels;
+  size_t capacity;
+} bench_bmp_t;
+
+static unsigned char* bench_bmp_acquire(void* user, int width, int height, size_t* stride) {
+  bench_bmp_t* bmp = (bench_bmp_t*)user;
+  *stride = (size_t)width * 4u;
+  return *stride * (size_t)height <= bmp->capacity ? bmp->pixels : NULL;
+}
+
+static bool bench_bmp_decode_iteration(void* user) {
+  bench_bmp_t* bmp = (bench_bmp_t*)user;
+  CJellyFormatImageTarget target = { bench_bmp_acquire, bmp };
+  return cjelly_format_image_bmp_load_rgba_memory(bmp->data, bmp->size, &target, NULL, NULL) == CJELLY_FORMAT_IMAGE_SUCCESS;
+}
+
+static bool bench_bmp_load_iteration(void* user) {
+  bench_bmp_t* bmp = (bench_bmp_t*)user;
+  CJellyFormatImageTarget target = { bench_bmp_acquire, bmp };
+  return cjelly_format_image_bmp_load_rgba(BENCH_BMP_PATH, &target, NULL, NULL) == CJELLY_FORMAT_IMAGE_SUCCESS;
+}
+
+static void bench_parsers(bench_t* b) {
+  uint32_t grid = b->quick ? 128u : 512u;
+  uint32_t materials = b->quick ? 2000u : 20000u;
+  uint32_t side = b->quick ? 512u : 2048u;
+  uint32_t samples = b->quick ? 3u : 10u;
+
+  if (bench_selected(b, "obj_parse")) {
+    if (bench_write_obj(BENCH_OBJ_PATH, grid)) {
+      double mb = (double)bench_file_size(BENCH_OBJ_PATH) / (1024.0 * 1024.0);
+      bench_measure(b, "obj_parse", bench_obj_iteration, NULL, samples, mb, "MB/s");
+    } else {
+      fprintf(stderr, "bench: could not write %s\n", BENCH_OBJ_PATH);
+    }
+    remove(BENCH_OBJ_PATH);
+  }
+
+  if (bench_selected(b, "mtl_parse")) {
+    if (bench_write_mtl(BENCH_MTL_PATH, materials)) {
+      double mb = (double)bench_file_size(BENCH_MTL_PATH) / (1024.0 * 1024.0);
+      bench_measure(b, "mtl_parse", bench_mtl_iteration, NULL, samples, mb, "MB/s");
+    } else {
+      fprintf(stderr, "bench: could not write %s\n", BENCH_MTL_PATH);
+    }
+    remove(BENCH_MTL_PATH);
+  }
+
+  if (bench_selected(b, "bmp_")) {
+    bench_bmp_t bmp = {0};
+    bmp.capacity = (size_t)side * side * 4u;
+    bmp.pixels = (unsigned char*)malloc(bmp.capacity);
+    void* data = NULL;
+    if (bmp.pixels && bench_write_bmp(BENCH_BMP_PATH, side, side)) data = bench_read_file(BENCH_BMP_PATH, &bmp.size);
+    if (data) {
+      double mb = (double)bmp.size / (1024.0 * 1024.0);
+      bmp.data = data;
+      bench_measure(b, "bmp_decode", bench_bmp_decode_iteration, &bmp, samples * 2u, mb, "MB/s");
+      bench_measure(b, "bmp_load", bench_bmp_load_iteration, &bmp, samples * 2u, mb, "MB/s");
+    } else {
+      fprintf(stderr, "bench: could not write %s\n", BENCH_BMP_PATH);
+    }
+    free(data);
+    free(bmp.pixels);
+    remove(BENCH_BMP_PATH);
+  }
+}
+
+/* ===== Handle churn (no device needed) ===== */
+
+#define BENCH_CHURN_HANDLES 768u
+
+typedef struct bench_churn_t {
+  cj_engine_t* engine;
+  cj_handle_t handles[BENCH_CHURN_HANDLES];
+} bench_churn_t;
+
+/* Fill most of the table, free every other handle, refill the holes, then empty it */
+static bool bench_churn_iteration(void* user) {
+  bench_churn_t* c = (bench_churn_t*)user;
+  for (uint32_t i = 0; i < BENCH_CHURN_HANDLES; ++i) {
+    c->handles[i] = cj_handle_alloc(c->engine, CJ_HANDLE_BUF, NULL);
+    if (c->handles[i].idx == 0) return false;
+  }
+  for (uint32_t i = 0; i < BENCH_CHURN_HANDLES; i += 2) cj_handle_release(c->engine, CJ_HANDLE_BUF, c->handles[i]);
+  for (uint32_t i = 0; i < BENCH_CHURN_HANDLES; i += 2) {
+    c->handles[i] = cj_handle_alloc(c->engine, CJ_HANDLE_BUF, NULL);
+    if (c->handles[i].idx == 0) return false;
+  }
+  for (uint32_t i = BENCH_CHURN_HANDLES; i-- > 0;) cj_handle_release(c->engine, CJ_HANDLE_BUF, c->handles[i]);
+  return true;
+}
+
+static void bench_handles(bench_t* b, cj_engine_t* engine) {
+  bench_churn_t churn = {0};
+  churn.engine = engine;
+  /* Allocations plus releases, in millions */
+  double mops = (BENCH_CHURN_HANDLES * 3.0) / 1.0e6;
+  bench_measure(b, "handle_churn", bench_churn_iteration, &churn, b->quick ? 20u : 200u, mops, "Mops/s");
+}
+
+/* ===== Atlas churn (no device needed) ===== */
+
+#define BENCH_ATLAS_SIZE 1024u
+#define BENCH_ATLAS_ENTRIES 1024u
+#define BENCH_ATLAS_OPS 256u
+
+typedef struct bench_atlas_t {
+  cj_atlas_packer_t* packer;
+  uint32_t ids[BENCH_ATLAS_ENTRIES];
+  uint32_t rng;
+} bench_atlas_t;
+
+static uint32_t bench_atlas_next(bench_atlas_t* a) {
+  a->rng = a->rng * 1664525u + 1013904223u;
+  return a->rng >> 8;
+}
+
+/* Glyph-sized entries on a page a third full: each op evicts a random slot and packs a new entry into it */
+static bool bench_atlas_iteration(void* user) {
+  bench_atlas_t* a = (bench_atlas_t*)user;
+  for (uint32_t i = 0; i < BENCH_ATLAS_OPS; ++i) {
+    uint32_t slot = bench_atlas_next(a) % BENCH_ATLAS_ENTRIES;
+    if (a->ids[slot]) cj_atlas_packer_remove(a->packer, a->ids[slot]);
+    a->ids[slot] = cj_atlas_packer_insert(a->packer, 8u + bench_atlas_next(a) % 32u, 8u + bench_atlas_next(a) % 32u, NULL);
+    if (a->ids[slot] == 0) return false;
+  }
+  return true;
+}
+
+static void bench_atlas(bench_t* b) {
+  static bench_atlas_t atlas;
+  memset(&atlas, 0, sizeof(atlas));
+  atlas.rng = 1u;
+  atlas.packer = cj_atlas_packer_create(BENCH_ATLAS_SIZE, BENCH_ATLAS_SIZE, 1u, BENCH_ATLAS_ENTRIES);
+  if (!atlas.packer) {
+    fprintf(stderr, "bench: could not create an atlas packer\n");
+    return;
+  }
+  for (uint32_t i = 0; i < BENCH_ATLAS_ENTRIES; ++i) {
+    atlas.ids[i] = cj_atlas_packer_insert(atlas.packer, 8u + bench_atlas_next(&atlas) % 32u, 8u + bench_atlas_next(&atlas) % 32u, NULL);
+  }
+  /* Removals plus insertions, in millions */
+  double mops = (BENCH_ATLAS_OPS * 2.0) / 1.0e6;
+  bench_measure(b, "atlas_churn", bench_atlas_iteration, &atlas, b->quick ? 10u : 100u, mops, "Mops/s");
+  cj_atlas_packer_destroy(atlas.packer);
+}
+
+/* ===== GPU ===== */
+
+typedef struct bench_target_t {
+  VkImage image;
+  VkDeviceMemory memory;
+  VkImageView view;
+  VkFramebuffer framebuffer;
+  VkCommandBuffer cmd;
+  cj_rgraph_t* graph;
+} bench_target_t;
+
+typedef struct bench_gpu_t {
+  cj_engine_t* engine;
+  VkDevice device;
+  VkQueue queue;
+  VkCommandPool pool;
+  VkFence fence;
+  VkExtent2D extent;
+  bench_target_t targets[BENCH_MAX_TARGETS];
+  uint32_t target_count;  /* targets rendered per frame */
+  cj_handle_t texture;
+  cj_texture_upload_t upload;
+  cj_handle_t buffers[256];
+  uint32_t buffer_count;
+} bench_gpu_t;
+
+static uint32_t bench_memory_type(cj_engine_t* engine, uint32_t bits, VkMemoryPropertyFlags flags) {
+  VkPhysicalDeviceMemoryProperties props;
+  vkGetPhysicalDeviceMemoryProperties(cj_engine_physical_device(engine), &props);
+  for (uint32_t i = 0; i < props.memoryTypeCount; ++i) {
+    if ((bits & (1u << i)) && (props.memoryTypes[i].propertyFlags & flags) == flags) return i;
+  }
+  return UINT32_MAX;
+}
+
+static void bench_destroy_target(bench_gpu_t* g, bench_target_t* t) {
+  if (t->graph) cj_rgraph_destroy(t->graph);
+  if (t->framebuffer) vkDestroyFramebuffer(g->device, t->framebuffer, NULL);
+  if (t->view) vkDestroyImageView(g->device, t->view, NULL);
+  if (t->image) vkDestroyImage(g->device, t->image, NULL);
+  if (t->memory) vkFreeMemory(g->device, t->memory, NULL);
+  memset(t, 0, sizeof(*t));
+}
+
+/* Color image and framebuffer compatible with the engine render pass */
+static bool bench_create_target(bench_gpu_t* g, bench_target_t* t) {
+  VkImageCreateInfo ici = {0};
+  ici.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  ici.imageType = VK_IMAGE_TYPE_2D;
+  ici.format = cj_engine_color_format(g->engine);
+  ici.extent = (VkExtent3D){ g->extent.width, g->extent.height, 1 };
+  ici.mipLevels = 1;
+  ici.arrayLayers = 1;
+  ici.samples = VK_SAMPLE_COUNT_1_BIT;
+  ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+  ici.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  if (vkCreateImage(g->device, &ici, NULL, &t->image) != VK_SUCCESS) return false;
+
+  VkMemoryRequirements req;
+  vkGetImageMemoryRequirements(g->device, t->image, &req);
+  VkMemoryAllocateInfo mai = {0};
+  mai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  mai.allocationSize = req.size;
+  mai.memoryTypeIndex = bench_memory_type(g->engine, req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  if (mai.memoryTypeIndex == UINT32_MAX) return false;
+  if (vkAllocateMemory(g->device, &mai, NULL, &t->memory) != VK_SUCCESS) return false;
+  if (vkBindImageMemory(g->device, t->image, t->memory, 0) != VK_SUCCESS) return false;
+
+  VkImageViewCreateInfo vci = {0};
+  vci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  vci.image = t->image;
+  vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+  vci.format = ici.format;
+  vci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  vci.subresourceRange.levelCount = 1;
+  vci.subresourceRange.layerCount = 1;
+  if (vkCreateImageView(g->device, &vci, NULL, &t->view) != VK_SUCCESS) return false;
+
+  VkFramebufferCreateInfo fci = {0};
+  fci.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+  fci.renderPass = cj_engine_render_pass(g->engine);
+  fci.attachmentCount = 1;
+  fci.pAttachments = &t->view;
+  fci.width = g->extent.width;
+  fci.height = g->extent.height;
+  fci.layers = 1;
+  if (vkCreateFramebuffer(g->device, &fci, NULL, &t->framebuffer) != VK_SUCCESS) return false;
+
+  VkCommandBufferAllocateInfo cai = {0};
+  cai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  cai.commandPool = g->pool;
+  cai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  cai.commandBufferCount = 1;
+  return vkAllocateCommandBuffers(g->device, &cai, &t->cmd) == VK_SUCCESS;
+}
+
+/* Replace the target's graph with one of node_count color nodes */
+static bool bench_build_graph(bench_gpu_t* g, bench_target_t* t, uint32_t node_count) {
+  if (t->graph) cj_rgraph_destroy(t->graph);
+  cj_rgraph_desc_t desc = {0};
+  t->graph = cj_rgraph_create(g->engine, &desc);
+  if (!t->graph) return false;
+  for (uint32_t i = 0; i < node_count; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "color_%u", i);
+    if (cj_rgraph_add_color_node(t->graph, name) != CJ_SUCCESS) return false;
+  }
+  return cj_rgraph_prepare(t->graph, g->extent) == CJ_SUCCESS;
+}
+
+static bool bench_record(bench_gpu_t* g, bench_target_t* t) {
+  if (vkResetCommandBuffer(t->cmd, 0) != VK_SUCCESS) return false;
+  VkCommandBufferBeginInfo bi = {0};
+  bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkBeginCommandBuffer(t->cmd, &bi) != VK_SUCCESS) return false;
+  if (cj_rgraph_execute_offscreen(t->graph, t->cmd, g->extent) != CJ_SUCCESS) return false;
+
+  VkClearValue clear = {0};
+  VkRenderPassBeginInfo rp = {0};
+  rp.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  rp.renderPass = cj_engine_render_pass(g->engine);
+  rp.framebuffer = t->framebuffer;
+  rp.renderArea.extent = g->extent;
+  rp.clearValueCount = 1;
+  rp.pClearValues = &clear;
+  vkCmdBeginRenderPass(t->cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+  cj_result_t result = cj_rgraph_execute(t->graph, t->cmd, g->extent);
+  vkCmdEndRenderPass(t->cmd);
+  return vkEndCommandBuffer(t->cmd) == VK_SUCCESS && result == CJ_SUCCESS;
+}
+
+static bool bench_record_iteration(void* user) {
+  bench_gpu_t* g = (bench_gpu_t*)user;
+  return bench_record(g, &g->targets[0]);
+}
+
+/* Record every target, submit them together and wait, like one event loop frame */
+static bool bench_frame_iteration(void* user) {
+  bench_gpu_t* g = (bench_gpu_t*)user;
+  VkCommandBuffer cmds[BENCH_MAX_TARGETS];
+  for (uint32_t i = 0; i < g->target_count; ++i) {
+    if (!bench_record(g, &g->targets[i])) return false;
+    cmds[i] = g->targets[i].cmd;
+  }
+  VkSubmitInfo si = {0};
+  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  si.commandBufferCount = g->target_count;
+  si.pCommandBuffers = cmds;
+  if (vkQueueSubmit(g->queue, 1, &si, g->fence) != VK_SUCCESS) return false;
+  bool ok = vkWaitForFences(g->device, 1, &g->fence, VK_TRUE, UINT64_MAX) == VK_SUCCESS;
+  vkResetFences(g->device, 1, &g->fence);
+  return ok;
+}
+
+static bool bench_upload_iteration(void* user) {
+  bench_gpu_t* g = (bench_gpu_t*)user;
+  if (!cj_upload_texture(g->engine, g->texture, &g->upload)) return false;
+  cj_upload_wait(g->engine, cj_upload_flush(g->engine));
+  return true;
+}
+
+static bool bench_buffer_iteration(void* user) {
+  bench_gpu_t* g = (bench_gpu_t*)user;
+  cj_buffer_desc_t desc = {0};
+  desc.size = 64u * 1024u;
+  desc.usage = CJ_BUFFER_VERTEX | CJ_BUFFER_TRANSFER_DST;
+  for (uint32_t i = 0; i < g->buffer_count; ++i) {
+    g->buffers[i] = cj_buffer_create(g->engine, &desc);
+    if (g->buffers[i].idx == 0) return false;
+  }
+  for (uint32_t i = 0; i < g->buffer_count; ++i) cj_buffer_release(g->engine, g->buffers[i]);
+  return true;
+}
+
+static void bench_uploads(bench_t* b, bench_gpu_t* g) {
+  static const uint32_t sides[] = { 256u, 2048u };
+  for (size_t s = 0; s < sizeof(sides) / sizeof(sides[0]); ++s) {
+    uint32_t side = b->quick ? sides[s] / 4u : sides[s];
+    char name[BENCH_NAME_SIZE];
+    snprintf(name, sizeof(name), "texture_upload_%ux%u", side, side);
+    if (!bench_selected(b, name)) continue;
+
+    cj_texture_desc_t desc = {0};
+    desc.width = side;
+    desc.height = side;
+    desc.layers = 1;
+    desc.mips = 1;
+    desc.format = CJ_FORMAT_RGBA8_UNORM;
+    desc.usage = CJ_IMAGE_SAMPLED;
+    size_t bytes = (size_t)side * side * 4u;
+    unsigned char* texels = (unsigned char*)malloc(bytes);
+    g->texture = texels ? cj_texture_create(g->engine, &desc) : (cj_handle_t){0};
+    if (g->texture.idx == 0) {
+      fprintf(stderr, "bench: could not create a %ux%u texture\n", side, side);
+      free(texels);
+      continue;
+    }
+    for (size_t i = 0; i < bytes; ++i) texels[i] = (unsigned char)(i * 31u);
+    memset(&g->upload, 0, sizeof(g->upload));
+    g->upload.data = texels;
+    bench_measure(b, name, bench_upload_iteration, g, b->quick ? 5u : 30u, (double)bytes / (1024.0 * 1024.0), "MB/s");
+    vkDeviceWaitIdle(g->device);
+    cj_texture_release(g->engine, g->texture);
+    free(texels);
+  }
+
+  g->buffer_count = b->quick ? 64u : 256u;
+  bench_measure(b, "buffer_create_release", bench_buffer_iteration, g, b->quick ? 5u : 30u,
+                (double)g->buffer_count * 2.0 / 1.0e3, "kops/s");
+}
+
+static void bench_graphs(bench_t* b, bench_gpu_t* g) {
+  static const uint32_t node_counts[] = { 1u, 16u, 64u, 256u };
+  uint32_t samples = b->quick ? 20u : 200u;
+  size_t counts = b->quick ? 3u : sizeof(node_counts) / sizeof(node_counts[0]);
+
+  g->target_count = 1;
+  for (size_t i = 0; i < counts; ++i) {
+    char record[BENCH_NAME_SIZE], frame[BENCH_NAME_SIZE];
+    snprintf(record, sizeof(record), "rgraph_record_%u_nodes", node_counts[i]);
+    snprintf(frame, sizeof(frame), "rgraph_frame_%u_nodes", node_counts[i]);
+    if (!bench_selected(b, record) && !bench_selected(b, frame)) continue;
+    if (!bench_build_graph(g, &g->targets[0], node_counts[i])) {
+      fprintf(stderr, "bench: could not build a graph of %u nodes\n", node_counts[i]);
+      continue;
+    }
+    /* CPU cost of recording alone, then recording plus the GPU finishing it */
+    bench_measure(b, record, bench_record_iteration, g, samples, node_counts[i], "nodes/s");
+    bench_measure(b, frame, bench_frame_iteration, g, samples, node_counts[i], "nodes/s");
+  }
+
+  /* Several windows of a few nodes each, submitted in one batch per frame */
+  static const uint32_t windows[] = { 1u, 2u, 4u, 8u };
+  for (size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); ++i) {
+    char name[BENCH_NAME_SIZE];
+    snprintf(name, sizeof(name), "multiwindow_frame_%u", windows[i]);
+    if (!bench_selected(b, name)) continue;
+    bool ok = true;
+    for (uint32_t w = 0; w < windows[i] && ok; ++w) ok = bench_build_graph(g, &g->targets[w], 4u);
+    if (!ok) {
+      fprintf(stderr, "bench: could not build the graphs for %u windows\n", windows[i]);
+      continue;
+    }
+    g->target_count = windows[i];
+    bench_measure(b, name, bench_frame_iteration, g, samples, windows[i], "window frames/s");
+  }
+  g->target_count = 1;
+}
+
+static void bench_gpu(bench_t* b, cj_engine_t* engine) {
+  bench_gpu_t g = {0};
+  g.engine = engine;
+  g.device = cj_engine_device(engine);
+  g.queue = cj_engine_graphics_queue(engine);
+  g.extent = (VkExtent2D){ BENCH_TARGET_WIDTH, BENCH_TARGET_HEIGHT };
+
+  VkCommandPoolCreateInfo pci = {0};
+  pci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  pci.queueFamilyIndex = cj_engine_graphics_family(engine);
+  VkFenceCreateInfo fci = {0};
+  fci.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  bool ok = vkCreateCommandPool(g.device, &pci, NULL, &g.pool) == VK_SUCCESS &&
+            vkCreateFence(g.device, &fci, NULL, &g.fence) == VK_SUCCESS;
+  for (uint32_t i = 0; i < BENCH_MAX_TARGETS && ok; ++i) ok = bench_create_target(&g, &g.targets[i]);
+
+  if (ok) {
+    bench_uploads(b, &g);
+    bench_graphs(b, &g);
+  } else {
+    fprintf(stderr, "bench: could not create the offscreen targets, skipping GPU benchmarks\n");
+  }
+
+  vkDeviceWaitIdle(g.device);
+  for (uint32_t i = 0; i < BENCH_MAX_TARGETS; ++i) bench_destroy_target(&g, &g.targets[i]);
+  if (g.fence) vkDestroyFence(g.device, g.fence, NULL);
+  if (g.pool) vkDestroyCommandPool(g.device, g.pool, NULL);
+}
+
+/* ===== Baseline ===== */
+
+/* Read the medians of an earlier report. Only understands the layout bench_write_json() emits. */
+static bool bench_apply_baseline(bench_t* b, const char* path) {
+  size_t size = 0;
+  char* text = (char*)bench_read_file(path, &size);
+  if (!text) {
+    fprintf(stderr, "bench: could not read baseline %s\n", path);
+    return false;
+  }
+  char* json = (char*)realloc(text, size + 1);
+  if (!json) {
+    free(text);
+    return false;
+  }
+  json[size] = '\0';
+
+  static const char name_key[] = "\"name\": \"";
+  static const char median_key[] = "\"median_ms\": ";
+  for (char* p = strstr(json, name_key); p; p = strstr(p, name_key)) {
+    p += sizeof(name_key) - 1;
+    char* end = strchr(p, '"');
+    char* median = strstr(p, median_key);
+    if (!end || !median) break;
+    double base = strtod(median + sizeof(median_key) - 1, NULL);
+    for (uint32_t i = 0; i < b->result_count; ++i) {
+      bench_result_t* r = &b->results[i];
+      if (strlen(r->name) != (size_t)(end - p) || strncmp(r->name, p, (size_t)(end - p)) != 0) continue;
+      if (base <= 0.0) break;
+      r->has_baseline = true;
+      r->baseline_median_ms = base;
+      r->delta_pct = (r->median_ms - base) / base * 100.0;
+      break;
+    }
+    p = end;
+  }
+  free(json);
+  return true;
+}
+
+static uint32_t bench_report_baseline(const bench_t* b, double threshold_pct) {
+  uint32_t regressions = 0;
+  fprintf(stderr, "\n%-32s %12s %12s %9s\n", "benchmark", "baseline ms", "median ms", "change");
+  for (uint32_t i = 0; i < b->result_count; ++i) {
+    const bench_result_t* r = &b->results[i];
+    if (!r->has_baseline) {
+      fprintf(stderr, "%-32s %12s %12.4f %9s\n", r->name, "-", r->median_ms, "new");
+      continue;
+    }
+    bool regressed = r->delta_pct > threshold_pct;
+    if (regressed) ++regressions;
+    fprintf(stderr, "%-32s %12.4f %12.4f %+8.1f%%%s\n", r->name, r->baseline_median_ms, r->median_ms,
+            r->delta_pct, regressed ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+
+static bool bench_write_json(const bench_t* b, const char* path) {
+  FILE* f = path ? fopen(path, "w") : stdout;
+  if (!f) {
+    fprintf(stderr, "bench: could not write %s\n", path);
+    return false;
+  }
+  fprintf(f, "{\n  \"version\": \"%s\",\n  \"warmup\": %u,\n  \"results\": [", CJELLY_VERSION_STRING, b->warmup);
+  for (uint32_t i = 0; i < b->result_count; ++i) {
+    const bench_result_t* r = &b->results[i];
+    fprintf(f, "%s\n    {\n", i ? "," : "");
+    fprintf(f, "      \"name\": \"%s\",\n", r->name);
+    fprintf(f, "      \"samples\": %u,\n", r->samples);
+    fprintf(f, "      \"min_ms\": %.6f,\n", r->min_ms);
+    fprintf(f, "      \"median_ms\": %.6f,\n", r->median_ms);
+    fprintf(f, "      \"mean_ms\": %.6f,\n", r->mean_ms);
+    fprintf(f, "      \"p95_ms\": %.6f,\n", r->p95_ms);
+    fprintf(f, "      \"max_ms\": %.6f,\n", r->max_ms);
+    fprintf(f, "      \"stddev_ms\": %.6f", r->stddev_ms);
+    if (r->throughput_unit) {
+      fprintf(f, ",\n      \"throughput\": %.3f,\n      \"throughput_unit\": \"%s\"", r->throughput, r->throughput_unit);
+    }
+    if (r->has_baseline) {
+      fprintf(f, ",\n      \"baseline_median_ms\": %.6f,\n      \"delta_pct\": %.2f", r->baseline_median_ms, r->delta_pct);
+    }
+    fprintf(f, "\n    }");
+  }
+  fprintf(f, "\n  ]\n}\n");
+  return path ? fclose(f) == 0 : fflush(f) == 0;
+}
+
+static void bench_usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --out FILE        write the JSON report to FILE instead of stdout\n"
+          "  --baseline FILE   compare medians against an earlier report\n"
+          "  --threshold PCT   median increase counted as a regression (default 10)\n"
+          "  --filter TEXT     run only benchmarks whose name contains TEXT\n"
+          "  --warmup N        untimed iterations per benchmark (default 3)\n"
+          "  --quick           smaller inputs and fewer samples\n"
+          "  --no-gpu          skip the benchmarks that need a Vulkan device\n"
+          "  --validation      enable the Vulkan validation layers\n",
+          argv0);
+}
+
+int main(int argc, char** argv) {
+  static bench_t b;
+  const char* out_path = NULL;
+  const char* baseline_path = NULL;
+  double threshold = 10.0;
+  bool use_gpu = true;
+  int use_validation = 0;
+  b.warmup = 3;
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (!strcmp(arg, "--out") && has_value) out_path = argv[++i];
+    else if (!strcmp(arg, "--baseline") && has_value) baseline_path = argv[++i];
+    else if (!strcmp(arg, "--threshold") && has_value) threshold = strtod(argv[++i], NULL);
+    else if (!strcmp(arg, "--filter") && has_value) b.filter = argv[++i];
+    else if (!strcmp(arg, "--warmup") && has_value) b.warmup = (uint32_t)strtoul(argv[++i], NULL, 10);
+    else if (!strcmp(arg, "--quick")) b.quick = true;
+    else if (!strcmp(arg, "--no-gpu")) use_gpu = false;
+    else if (!strcmp(arg, "--validation")) use_validation = 1;
+    else {
+      bench_usage(argv[0]);
+      return strcmp(arg, "--help") ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+  }
+  if (b.quick && b.warmup > 1) b.warmup = 1;
+
+  bench_parsers(&b);
+  bench_atlas(&b);
+
+  cj_engine_desc_t desc = {0};
+  cj_engine_t* engine = cj_engine_create(&desc);
+  if (!engine) {
+    fprintf(stderr, "bench: could not create an engine\n");
+    return EXIT_FAILURE;
+  }
+  bench_handles(&b, engine);
+  if (use_gpu) {
+    if (cj_engine_init(engine, use_validation)) {
+      cj_engine_set_current(engine);
+      bench_gpu(&b, engine);
+      cj_engine_shutdown_device(engine);
+    } else {
+      fprintf(stderr, "bench: no Vulkan device, skipping GPU benchmarks\n");
+    }
+  }
+  cj_engine_shutdown(engine);
+
+  uint32_t regressions = 0;
+  if (baseline_path && bench_apply_baseline(&b, baseline_path)) {
+    regressions = bench_report_baseline(&b, threshold);
+  }
+  if (!bench_write_json(&b, out_path)) return EXIT_FAILURE;
+  if (regressions) {
+    fprintf(stderr, "\n%u benchmark(s) regressed by more than %.1f%%\n", regressions, threshold);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -225,16 +225,26 @@ struct CJellyApplication {
   int computeQueueFamilyIndex;
   bool supportsBindlessRendering;
 
-  // Window tracking (for future mutex protection when multi-threaded)
-  void** windows;  // Window list for tracking (opaque pointers to cj_window_t*)
-  uint32_t window_count;
+  // Window tracking (for future mutex protection when multi-threaded).
+  // A window keeps its slot for its lifetime; a freed slot bumps its
+  // generation so a stale (slot, generation) pair never matches a new window.
+  struct {
+    void* window;         // Opaque pointer to cj_window_t*, NULL for a free slot
+    uint32_t generation;  // Bumped each time the slot is freed
+    uint32_t next_free;   // Next free slot + 1 (0 ends the free list)
+  }* windows;
+  uint32_t window_count;     // Live windows
+  uint32_t window_slots;     // Slots handed out so far (bound for iteration)
   uint32_t window_capacity;
+  uint32_t window_free;      // First free slot + 1 (0 when none)
 
-  // Handle mapping for event routing
+  // Handle mapping for event routing: open addressing with linear probing,
+  // keyed by native handle. The capacity is a power of two, at most half full.
   struct {
-    void* handle;  // HWND or Window (cast to void*)
+    void* handle;  // HWND or Window (cast to void*), NULL for an empty bucket
     void* window;  // Opaque pointer to cj_window_t*
-  }* handle_map;  // Array of handle->window mappings
+    uint32_t slot; // The window's slot in windows
+  }* handle_map;
   uint32_t handle_map_count;
   uint32_t handle_map_capacity;
 
@@ -466,9 +476,52 @@ CJ_API uint32_t cjelly_application_get_windows(const CJellyApplication * app,
                                         void** out_windows,
                                         uint32_t window_count);
 
+/**
+ * @brief Get the number of window slots, for iterating windows in place.
+ *
+ * Slots are stable: a window keeps its slot until it is unregistered, and
+ * windows created during an iteration take free or new slots without moving
+ * the others.  Unlike cjelly_application_get_windows(), nothing is copied.
+ *
+ * @code
+ * for (uint32_t i = 0; i < cjelly_application_window_slots(app); i++) {
+ *   cj_window_t* window = cjelly_application_window_at(app, i, NULL);
+ *   if (window) draw(window);  // May destroy any window, including this one
+ * }
+ * @endcode
+ *
+ * @param app The application object.
+ * @return One past the highest slot that may hold a window.
+ */
+CJ_API uint32_t cjelly_application_window_slots(const CJellyApplication * app);
+
+/**
+ * @brief Get the window in a slot.
+ *
+ * @param app The application object.
+ * @param slot Slot index, below cjelly_application_window_slots().
+ * @param out_generation Receives the slot's generation, for
+ *        cjelly_application_window_alive(). Can be NULL.
+ * @return The window, or NULL if the slot is free or out of range.
+ */
+CJ_API void* cjelly_application_window_at(const CJellyApplication * app, uint32_t slot, uint32_t* out_generation);
+
+/**
+ * @brief Check that a window seen through cjelly_application_window_at() still exists.
+ *
+ * @param app The application object.
+ * @param slot The window's slot.
+ * @param generation The generation returned with the window.
+ * @return true if the slot still holds that window.
+ */
+CJ_API bool cjelly_application_window_alive(const CJellyApplication * app, uint32_t slot, uint32_t generation);
+
 /**
  * @brief Find a window by its platform handle.
  *
+ * A hash lookup, so routing each OS event costs the same with any number of
+ * windows.
+ *
  * @param app The application object.
  * @param handle Platform window handle (HWND on Windows, Window on Linux).
  * @return Window pointer if found, NULL if not found or window destroyed.
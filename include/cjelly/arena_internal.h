@@ -0,0 +1,46 @@
+/*
+ * CJelly — Internal arena lifetime and frame heap accounting
+ * Copyright (c) 2025
+ *
+ * Creation and reset of cj_arena_t (see cj_arena.h), and a process-wide count
+ * of the heap allocations the frame path makes: arena blocks, and the growth of
+ * the arrays frames reuse. Steady frames should not move it.
+ * Not part of the public API.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cjelly/cj_arena.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Create an arena; its first block of capacity bytes (0 = default) is allocated on first use.
+ *  @return The arena, or NULL when out of memory.
+ */
+cj_arena_t* cj_arena_create(size_t capacity);
+
+/** Free an arena and all of its memory. Safe with NULL. */
+void cj_arena_destroy(cj_arena_t* arena);
+
+/** Drop everything allocated. If the arena spilled into more than one block since
+ *  the last reset, they are replaced by one block holding all of them. */
+void cj_arena_reset(cj_arena_t* arena);
+
+/** Count a heap allocation made on the frame path; only counted while the calling
+ *  thread is inside frame work (see cj_heap_count_thread()). Any thread. */
+void cj_heap_note_alloc(void);
+
+/** Whether the calling thread is inside frame work; returns the previous setting so
+ *  nested scopes (a recording job run on the main thread) can restore it. */
+bool cj_heap_count_thread(bool counted);
+
+/** Heap allocations counted so far. */
+uint64_t cj_heap_alloc_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,26 @@
+/*
+ * CJelly — Internal asset cache
+ * Copyright (c) 2025
+ *
+ * State behind cj_asset.h, owned by the engine. Not part of the public API.
+ */
+#pragma once
+
+#include <cjelly/cj_asset.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cj_asset_cache_t cj_asset_cache_t;
+
+/* Empty cache; the decode workers start with the first load. NULL when out of memory. */
+cj_asset_cache_t* cj_asset_cache_create(cj_engine_t* engine);
+
+/* Stop the workers (abandoning decodes not yet started) and free every asset, releasing
+ * their textures and meshes. References applications still hold become dangling. */
+void cj_asset_cache_destroy(cj_asset_cache_t* cache);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+/*
+ * CJelly — Internal texture atlas packer
+ * Copyright (c) 2025
+ *
+ * Places rectangles on fixed-size atlas pages with the maxrects algorithm
+ * (best short side fit). Entries can be removed again; their space goes back
+ * on the page's free list right away, bridged to the free rectangles it
+ * touches, and only defragmentation and stats rebuild a page in full. Pages
+ * are added on request, entries are kept in
+ * least-recently-used order for eviction, and defragmentation plans a repack
+ * of every entry for the caller to copy before committing it.
+ * The packer only does the bookkeeping; it never touches the GPU.
+ * Not part of the public API; like the rest of the engine it is not thread-safe.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cj_atlas_packer_t cj_atlas_packer_t;
+
+/** Where an entry lives: texel rectangle on one page (array layer). */
+typedef struct cj_atlas_rect_t {
+  uint32_t page;
+  uint32_t x, y;
+  uint32_t width, height;
+} cj_atlas_rect_t;
+
+/** An entry relocated by defragmentation. */
+typedef struct cj_atlas_move_t {
+  uint32_t id;
+  cj_atlas_rect_t from;
+  cj_atlas_rect_t to;
+} cj_atlas_move_t;
+
+/** Occupancy of the packer. Areas are in texels. */
+typedef struct cj_atlas_packer_stats_t {
+  uint32_t pages;
+  uint32_t entries;
+  uint64_t used_area;      /**< Sum of entry areas. */
+  uint64_t free_area;      /**< Page area not covered by entries. */
+  uint64_t largest_free;   /**< Area of the largest free rectangle on any page. */
+} cj_atlas_packer_stats_t;
+
+/** Create a packer with one page.
+ *  @param padding Texels kept free to the right of and below every entry, so filtering does not
+ *         bleed between neighbors.
+ *  @param max_entries Number of ids handed out at most; ids run from 1 to max_entries.
+ *  @return The packer, or NULL on failure.
+ */
+cj_atlas_packer_t* cj_atlas_packer_create(uint32_t width, uint32_t height, uint32_t padding, uint32_t max_entries);
+
+/** Free the packer. */
+void cj_atlas_packer_destroy(cj_atlas_packer_t* packer);
+
+/** Place a width x height entry on the first page with room and make it the most recently used.
+ *  @return The new entry id, or 0 when no page has room (or width/height is 0 or too large).
+ */
+uint32_t cj_atlas_packer_insert(cj_atlas_packer_t* packer, uint32_t width, uint32_t height, cj_atlas_rect_t* out_rect);
+
+/** Free an entry's rectangle and id. No-op for an unknown id. */
+void cj_atlas_packer_remove(cj_atlas_packer_t* packer, uint32_t id);
+
+/** Look up an entry. @return false for an unknown id. */
+bool cj_atlas_packer_get(const cj_atlas_packer_t* packer, uint32_t id, cj_atlas_rect_t* out_rect);
+
+/** Mark an entry as used now; eviction picks the entry touched longest ago. */
+void cj_atlas_packer_touch(cj_atlas_packer_t* packer, uint32_t id);
+
+/** Least recently used entry, or 0 when the packer is empty. */
+uint32_t cj_atlas_packer_lru(const cj_atlas_packer_t* packer);
+
+/** Append an empty page. @return false on allocation failure. */
+bool cj_atlas_packer_add_page(cj_atlas_packer_t* packer);
+
+/** Number of pages. */
+uint32_t cj_atlas_packer_page_count(const cj_atlas_packer_t* packer);
+
+/** Plan a repack of every entry from scratch, largest first, onto the existing pages.
+ *  Nothing changes until the plan is committed. No plan is made when the repack does not fit
+ *  or would not leave a larger free rectangle than the current layout.
+ *  @param out_moves Receives a malloc'd array with every entry's old and new rectangle
+ *         (including entries that stay put); free() it. Set to NULL when 0 is returned.
+ *  @return Number of moves, or 0 without a plan.
+ */
+uint32_t cj_atlas_packer_plan_defragment(cj_atlas_packer_t* packer, cj_atlas_move_t** out_moves);
+
+/** Adopt a plan from cj_atlas_packer_plan_defragment(). Must be the packer's latest plan with no
+ *  insert or remove in between. */
+void cj_atlas_packer_commit_moves(cj_atlas_packer_t* packer, const cj_atlas_move_t* moves, uint32_t count);
+
+/** Fill out_stats; rebuilds the free lists of pages with removed entries. */
+void cj_atlas_packer_stats(cj_atlas_packer_t* packer, cj_atlas_packer_stats_t* out_stats);
+
+#ifdef __cplusplus
+}
+#endif
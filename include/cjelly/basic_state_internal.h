@@ -1,12 +1,13 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <cjelly/gpu_alloc_internal.h>
 
 /* Internal-only basic pipeline state (migration) */
 typedef struct CJellyBasicState {
   VkPipeline pipeline;
   VkPipelineLayout pipelineLayout;
   VkBuffer vertexBuffer;
-  VkDeviceMemory vertexBufferMemory;
+  cj_gpu_alloc_t vertexBufferAlloc;
 } CJellyBasicState;
 
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <cjelly/gpu_alloc_internal.h>
 
 /* Forward declaration for atlas used by bindless resources */
 typedef struct CJellyTextureAtlas CJellyTextureAtlas;
@@ -10,7 +11,7 @@ typedef struct CJellyBindlessResources {
   VkPipelineLayout pipelineLayout;
   CJellyTextureAtlas* textureAtlas;
   VkBuffer vertexBuffer;
-  VkDeviceMemory vertexBufferMemory;
+  cj_gpu_alloc_t vertexBufferAlloc;
   float uv[4];
   float colorMul[4];
 } CJellyBindlessResources;
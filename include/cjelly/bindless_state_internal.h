@@ -1,12 +1,13 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <cjelly/gpu_alloc_internal.h>
 
 /* Internal-only bindless state owned by the Engine during migration */
 typedef struct CJellyBindlessState {
   VkPipeline pipeline;
   VkPipelineLayout pipelineLayout;
   VkBuffer vertexBuffer;
-  VkDeviceMemory vertexBufferMemory;
+  cj_gpu_alloc_t vertexBufferAlloc;
 } CJellyBindlessState;
 
 
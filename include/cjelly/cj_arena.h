@@ -0,0 +1,41 @@
+/*
+ * CJelly — Per-frame memory
+ * Copyright (c) 2025
+ *
+ * Licensed under the MIT license for prototype purposes.
+ */
+#pragma once
+#include <stddef.h>
+#include "cj_macros.h"
+#include "cj_types.h"
+
+/** @file cj_arena.h
+ *  @brief Linear memory that lives until the next frame starts.
+ *
+ *  Frame callbacks receive the engine's frame arena in cj_frame_info_t.arena.
+ *  Allocating from it bumps a pointer, and everything allocated is dropped at
+ *  once when the next frame starts (each event loop iteration, or
+ *  cj_engine_begin_frame()); nothing is freed individually. The arena keeps its
+ *  memory across frames, and when a frame outgrows it, it grows to that frame's
+ *  size, so steady frames do not touch the heap. Main thread only.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Allocate from an arena.
+ *  @param arena The arena.
+ *  @param size Bytes to allocate.
+ *  @param align Power-of-two alignment; 0 = suitable for any type.
+ *  @return Uninitialized memory valid until the arena is reset, or NULL when
+ *          out of memory, arena is NULL or align is not a power of two.
+ */
+CJ_API void* cj_arena_alloc(cj_arena_t* arena, size_t size, size_t align);
+
+/** Bytes allocated from an arena since it was last reset, alignment padding included. */
+CJ_API size_t cj_arena_used(const cj_arena_t* arena);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,110 @@
+/*
+ * CJelly — Asynchronous asset loading
+ * Copyright (c) 2025
+ *
+ * Licensed under the MIT license for prototype purposes.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "cj_macros.h"
+#include "cj_types.h"
+#include "cj_result.h"
+#include "cj_resources.h"
+#include "cj_mesh.h"
+
+/** @file cj_asset.h
+ *  @brief Textures and meshes loaded from files on background threads, and cached.
+ *
+ *  cj_asset_load() returns at once with a reference to an asset. Engine worker
+ *  threads read and decode the file: images to RGBA8, OBJ models through the
+ *  mesh cache, KTX2 files by mapping them. cj_asset_update(), which the event
+ *  loop calls every iteration, then creates the GPU objects on the engine thread
+ *  and queues their contents on the upload queue. The asset itself is the
+ *  future: cj_asset_state() tells how far it got and cj_asset_wait() blocks
+ *  until it is usable.
+ *
+ *  Loads are cached by path, type and options, and by the file's modification
+ *  time and size. Loading a file again while an asset for it is alive returns
+ *  that asset, at whatever state it has reached. Once a file changes on disk,
+ *  new loads decode it afresh; earlier assets keep the old contents.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Opaque, reference-counted asset. */
+typedef struct cj_asset_t cj_asset_t;
+
+/** What an asset file becomes. */
+typedef enum cj_asset_type_t {
+  CJ_ASSET_TEXTURE = 0,  /**< BMP or KTX2 file; see cj_asset_texture(). */
+  CJ_ASSET_MESH,         /**< OBJ file with its MTL library; see cj_asset_mesh(). */
+} cj_asset_type_t;
+
+/** How far an asset got. */
+typedef enum cj_asset_state_t {
+  CJ_ASSET_LOADING = 0,  /**< A worker is reading or decoding the file, or will be. */
+  CJ_ASSET_UPLOADING,    /**< GPU objects exist; their contents are on the upload queue. */
+  CJ_ASSET_READY,        /**< The uploads completed. */
+  CJ_ASSET_FAILED,       /**< Loading failed; see cj_asset_result(). */
+} cj_asset_state_t;
+
+/** Asset load descriptor. Fields other than type and path are part of the cache key. */
+typedef struct cj_asset_desc_t {
+  cj_asset_type_t type;
+  const char* path;        /**< Copied. */
+  uint32_t usage;          /**< Textures: OR of cj_image_usage_t; 0 = CJ_IMAGE_SAMPLED. */
+  bool     linear;         /**< Textures decoded to RGBA8: UNORM instead of sRGB. */
+  bool     generate_mips;  /**< Textures decoded to RGBA8: build the mip chain on the GPU. */
+  uint32_t mesh_flags;     /**< Meshes: OR of CJellyFormat3dMeshFlags. */
+} cj_asset_desc_t;
+
+/** Start loading an asset, or find it in the cache.
+ *  Call on the engine thread. A file that does not exist fails here; errors
+ *  found while decoding show in cj_asset_state() later.
+ *  @param out_asset Receives a reference; release it with cj_asset_release().
+ *  @return CJ_SUCCESS, CJ_E_INVALID_ARGUMENT, CJ_E_NOT_FOUND, or CJ_E_OUT_OF_MEMORY.
+ */
+CJ_API cj_result_t cj_asset_load(cj_engine_t*, const cj_asset_desc_t* desc, cj_asset_t** out_asset);
+
+/** Add a reference to an asset. */
+CJ_API void cj_asset_retain(cj_asset_t* asset);
+
+/** Drop a reference. The last one removes the asset from the cache and releases
+ *  its texture or mesh; a decode still running is abandoned. */
+CJ_API void cj_asset_release(cj_engine_t*, cj_asset_t* asset);
+
+/** Finish decoded assets: create their textures and meshes and queue the uploads.
+ *  The event loop calls it every iteration; applications driving the engine
+ *  otherwise should call it once per frame.
+ */
+CJ_API void cj_asset_update(cj_engine_t*);
+
+/** State of an asset; CJ_ASSET_UPLOADING turns into CJ_ASSET_READY once the uploads completed. */
+CJ_API cj_asset_state_t cj_asset_state(cj_engine_t*, const cj_asset_t* asset);
+
+/** Block until the asset is ready or failed, helping the workers decode while waiting.
+ *  @return CJ_SUCCESS once it is ready, or the error it failed with.
+ */
+CJ_API cj_result_t cj_asset_wait(cj_engine_t*, cj_asset_t* asset);
+
+/** Error an asset failed with; CJ_SUCCESS otherwise. */
+CJ_API cj_result_t cj_asset_result(const cj_asset_t* asset);
+
+/** Ticket of the asset's uploads; 0 before they are queued. */
+CJ_API cj_upload_ticket_t cj_asset_ticket(const cj_asset_t* asset);
+
+/** Texture of a texture asset, owned by the asset; nil until it is uploading. */
+CJ_API cj_handle_t cj_asset_texture(const cj_asset_t* asset);
+
+/** Mesh of a mesh asset, owned by the asset; NULL until it is uploading. */
+CJ_API const cj_mesh_t* cj_asset_mesh(const cj_asset_t* asset);
+
+/** CPU mesh and materials of a mesh asset (CJellyFormat3dMeshAsset); NULL until it is uploading. */
+CJ_API const struct CJellyFormat3dMeshAsset* cj_asset_mesh_data(const cj_asset_t* asset);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
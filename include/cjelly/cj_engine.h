@@ -34,6 +34,10 @@ typedef enum cj_engine_flags_t {
   CJ_ENGINE_ENABLE_VALIDATION   = CJ_BIT(0),
   CJ_ENGINE_ENABLE_DIAGNOSTICS  = CJ_BIT(1),
   CJ_ENGINE_ENABLE_THREADING    = CJ_BIT(2),
+  /** Watch the GLSL sources of the built-in shaders ($CJELLY_SHADER_DIR, else src/shaders)
+   *  and swap the render graph pipelines built from a changed file while running.
+   *  Needs glslangValidator ($CJELLY_GLSLANG overrides the path). For development. */
+  CJ_ENGINE_ENABLE_SHADER_RELOAD = CJ_BIT(3),
 } cj_engine_flags_t;
 
 /** Optional custom allocator. All fields optional. */
@@ -57,6 +61,10 @@ typedef struct cj_engine_desc_t {
   uint32_t           bindless_limits_buffers;  /**< 0 = default. */
 
   const cj_allocator_t* allocator;             /**< Optional custom allocator. */
+
+  uint64_t           memory_budget;            /**< Bytes of each device-local heap the engine
+                                                    may fill; 0 = the driver's budget when the
+                                                    device has VK_EXT_memory_budget, else the heap. */
 } cj_engine_desc_t;
 
 /** Create the engine.
@@ -71,20 +79,76 @@ CJ_API cj_engine_t* cj_engine_create(const cj_engine_desc_t* desc);
 CJ_API void cj_engine_shutdown(cj_engine_t* engine);
 
 /** Block until the device is idle.
- *  This waits for all pending GPU operations to complete.
+ *  This waits for all pending GPU operations to complete and then destroys every
+ *  released resource still queued for deletion.
  *  @param engine The engine to wait for.
  */
 CJ_API void cj_engine_wait_idle(cj_engine_t* engine);
 
+/** Start gathering window frames into one submission.
+ *  Until cj_engine_end_frame(), cj_window_execute() only queues the window; a
+ *  window queued twice draws once. The event loop does this itself every
+ *  iteration; applications driving the engine otherwise may bracket their
+ *  cj_window_execute() calls with it. Main thread only.
+ *  @param engine The engine.
+ *  @return CJ_SUCCESS, CJ_E_INVALID_ARGUMENT without an engine, or CJ_E_BUSY
+ *          if a frame is already open.
+ */
+CJ_API cj_result_t cj_engine_begin_frame(cj_engine_t* engine);
+
+/** Record every window queued since cj_engine_begin_frame(), on the worker
+ *  threads when the engine has them, and submit their command buffers in one
+ *  vkQueueSubmit, which completes at a value of the engine timeline semaphore
+ *  (a fence on devices without timeline semaphores), then present all of their
+ *  swapchains with one vkQueuePresentKHR.
+ *  @param engine The engine the frame was begun on.
+ *  @return CJ_SUCCESS, CJ_E_INVALID_ARGUMENT if no frame is open on it, or
+ *          CJ_E_UNKNOWN if the submission failed.
+ */
+CJ_API cj_result_t cj_engine_end_frame(cj_engine_t* engine);
+
+/** Heap allocations the engine's frame path made during the previous frame.
+ *  Counts arena blocks and the growth of arrays that frames reuse; after the
+ *  first frames it should stay 0. With CJ_ENGINE_ENABLE_DIAGNOSTICS, frames
+ *  that still allocate once the warm-up frames ran are reported on stderr.
+ *  @param engine The engine.
+ */
+CJ_API uint32_t cj_engine_frame_heap_allocs(const cj_engine_t* engine);
+
+/** Destroy released resources the GPU has finished with.
+ *  The last release of a handle only queues its Vulkan objects; this frees those
+ *  whose submissions completed, oldest first, and never waits for the GPU. The
+ *  event loop and cj_offscreen_render() call it every iteration; applications
+ *  driving the engine otherwise should call it once per frame.
+ *  @param engine The engine.
+ *  @param budget_us Stop after this many microseconds, 0 = no limit. The rest is
+ *         freed by later calls.
+ *  @return Number of resources destroyed.
+ */
+CJ_API uint32_t cj_engine_collect_garbage(cj_engine_t* engine, uint32_t budget_us);
+
+/** Stream mip levels of streamed textures (cj_texture_desc_t.stream).
+ *  Loads the levels that cj_texture_request_extent() asked for since the last
+ *  call, as far as the memory budget allows, evicting the detail of the least
+ *  recently requested textures when it does not. Textures switch to their new
+ *  levels in a later call, once the uploads finished and no frame in flight
+ *  reads the texture table. The event loop calls it every iteration;
+ *  headless applications and those driving the engine otherwise should call
+ *  it once per frame, after the frames sampling the textures were submitted
+ *  through engine batches or finished.
+ *  @param engine The engine.
+ */
+CJ_API void cj_engine_update_streaming(cj_engine_t* engine);
+
 /** Return the selected device index.
  *  @param engine The engine to query.
  *  @return The index of the selected GPU device.
  */
 CJ_API uint32_t cj_engine_device_index(const cj_engine_t* engine);
 
-/** Global descriptor slot counts (bindless). */
+/** Global descriptor slot counts (bindless). 0 when the category has no global table. */
 typedef struct cj_bindless_info_t {
-  uint32_t images_capacity;
+  uint32_t images_capacity;     /**< Texture table slots; 0 without descriptor indexing. */
   uint32_t buffers_capacity;
   uint32_t samplers_capacity;
 } cj_bindless_info_t;
@@ -95,6 +159,44 @@ typedef struct cj_bindless_info_t {
  */
 CJ_API void cj_engine_get_bindless_info(const cj_engine_t* engine, cj_bindless_info_t* out_info);
 
+/** GPU memory usage of the engine allocator. */
+typedef struct cj_memory_stats_t {
+  uint64_t bytes_reserved;      /**< Device memory obtained from the driver. */
+  uint64_t bytes_used;          /**< Bytes requested by live allocations. */
+  uint32_t device_allocations;  /**< Live vkAllocateMemory objects (blocks + dedicated). */
+  uint32_t block_count;         /**< Shared blocks that sub-allocations come from. */
+  uint32_t dedicated_count;     /**< Allocations that own their memory. */
+  uint32_t allocation_count;    /**< Live allocations of any kind. */
+} cj_memory_stats_t;
+
+/** Query GPU memory statistics.
+ *  @param engine The engine to query.
+ *  @param out_stats Pointer to receive the statistics (zeroed before the device exists).
+ */
+CJ_API void cj_engine_get_memory_stats(const cj_engine_t* engine, cj_memory_stats_t* out_stats);
+
+/** Usage of one device memory heap. */
+typedef struct cj_memory_heap_t {
+  uint64_t size;          /**< Heap size. */
+  uint64_t budget;        /**< Bytes the engine may allocate from the heap: the smaller of
+                               cj_engine_desc_t.memory_budget (device-local heaps) and what the
+                               driver's budget leaves after other allocations, else size. */
+  uint64_t usage;         /**< Bytes of the heap the process uses as the driver reports it,
+                               or allocated without VK_EXT_memory_budget. */
+  uint64_t allocated;     /**< Device memory the engine allocator obtained from the heap. */
+  uint64_t used;          /**< Part of allocated held by live allocations. */
+  bool     device_local;
+  bool     driver_budget; /**< usage and budget come from VK_EXT_memory_budget. */
+} cj_memory_heap_t;
+
+/** Query per-heap memory usage and budgets.
+ *  @param engine The engine to query.
+ *  @param out_heaps Array receiving up to capacity heaps; may be NULL to count them.
+ *  @param capacity Size of out_heaps.
+ *  @return Number of heaps the device has (0 before the device exists).
+ */
+CJ_API uint32_t cj_engine_get_memory_heaps(const cj_engine_t* engine, cj_memory_heap_t* out_heaps, uint32_t capacity);
+
 /** Initialize GPU device and core Vulkan objects.
  *  @param engine The engine to initialize.
  *  @param use_validation Whether to enable Vulkan validation layers.
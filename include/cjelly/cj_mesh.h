@@ -0,0 +1,55 @@
+/*
+ * CJelly — GPU meshes
+ * Copyright (c) 2025
+ *
+ * Licensed under the MIT license for prototype purposes.
+ */
+#pragma once
+#include <stdint.h>
+#include "cj_macros.h"
+#include "cj_types.h"
+#include "cj_result.h"
+#include "cj_resources.h"
+
+/** @file cj_mesh.h
+ *  @brief Vertex and index buffers built from a CPU mesh (see cjelly/format/3d/mesh.h).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct CJellyFormat3dMesh;
+
+/** A run of indices drawn with one material. */
+typedef struct cj_mesh_range_t {
+  uint32_t first_index;
+  uint32_t index_count;
+  int32_t  material_index;  /**< -1 = no material. */
+} cj_mesh_range_t;
+
+/** A mesh resident in GPU buffers. */
+typedef struct cj_mesh_t {
+  cj_handle_t vertex_buffer;   /**< Interleaved position, normal, texcoord (CJellyFormat3dMeshVertex). */
+  cj_handle_t index_buffer;
+  uint32_t vertex_count;
+  uint32_t vertex_stride;      /**< Bytes per vertex. */
+  uint32_t index_count;
+  uint32_t index_size;         /**< 2 or 4 bytes. */
+  cj_mesh_range_t* ranges;     /**< Owned by the mesh; sorted by material. */
+  uint32_t range_count;
+  cj_upload_ticket_t ticket;   /**< Covers both buffers; wait on it or draw after the next frame. */
+} cj_mesh_t;
+
+/** Create device-local vertex and index buffers for a mesh and queue their contents.
+ *  The mesh data is copied before returning, so it may be freed right away.
+ *  @return CJ_SUCCESS, CJ_E_INVALID_ARGUMENT for an empty mesh, or CJ_E_OUT_OF_MEMORY.
+ */
+CJ_API cj_result_t cj_mesh_upload(cj_engine_t*, const struct CJellyFormat3dMesh* mesh, cj_mesh_t* out_mesh);
+
+/** Release the buffers and ranges of a mesh and zero it. The GPU must be done drawing it. */
+CJ_API void cj_mesh_release(cj_engine_t*, cj_mesh_t* mesh);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,89 @@
+/*
+ * CJelly — Offscreen render targets
+ * Copyright (c) 2025
+ *
+ * Licensed under the MIT license for prototype purposes.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "cj_macros.h"
+#include "cj_types.h"
+#include "cj_result.h"
+#include "cj_resources.h"
+
+/** @file cj_offscreen.h
+ *  @brief Render graphs into images without a window, with asynchronous readback.
+ *
+ *  An offscreen target renders on the engine device through the same render
+ *  pass and cj_rgraph_execute() path as a window, so it works on machines
+ *  without a display. It keeps a ring of images (two by default). After each
+ *  frame is rendered, the GPU copies it into a persistently mapped host buffer.
+ *  cj_offscreen_read() returns the newest frame the GPU has finished. The CPU
+ *  can therefore read frame N-1 while frame N renders, without stalling.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Opaque offscreen render target. */
+typedef struct cj_offscreen_target_t cj_offscreen_target_t;
+
+/** Most images an offscreen target cycles through. */
+#define CJ_OFFSCREEN_MAX_BUFFERS 4u
+
+/** Offscreen target descriptor. */
+typedef struct cj_offscreen_desc_t {
+  uint32_t width, height;  /**< Image size in pixels. */
+  uint32_t buffer_count;   /**< Images in flight, 0 = 2; at most CJ_OFFSCREEN_MAX_BUFFERS. */
+  bool     no_readback;    /**< Skip the host copies; cj_offscreen_read() then reports nothing. */
+  cj_str_t debug_name;
+} cj_offscreen_desc_t;
+
+/** Pixels of a finished frame. */
+typedef struct cj_offscreen_frame_t {
+  uint64_t frame_index;   /**< Frame number counted by cj_offscreen_render(), starting at 1. */
+  uint32_t width, height;
+  uint32_t row_pitch;     /**< Bytes between rows. */
+  cj_format_t format;     /**< Format of the engine render pass, usually BGRA8 or RGBA8. */
+  const void* pixels;     /**< Valid until the next cj_offscreen_render() or cj_offscreen_resize(). */
+} cj_offscreen_frame_t;
+
+/** Create an offscreen target on an initialized engine.
+ *  @return The target, or NULL on failure.
+ */
+CJ_API cj_offscreen_target_t* cj_offscreen_create(cj_engine_t* engine, const cj_offscreen_desc_t* desc);
+
+/** Wait for the target's frames to finish on the GPU and destroy it. */
+CJ_API void cj_offscreen_destroy(cj_offscreen_target_t* target);
+
+/** Set the render graph executed by cj_offscreen_render(). The graph may be shared with windows. */
+CJ_API void cj_offscreen_set_render_graph(cj_offscreen_target_t* target, cj_rgraph_t* graph);
+
+/** Change the image size. Waits for frames in flight; earlier frames can no longer be read.
+ *  @return CJ_SUCCESS, CJ_E_INVALID_ARGUMENT for a zero size, or CJ_E_OUT_OF_MEMORY.
+ */
+CJ_API cj_result_t cj_offscreen_resize(cj_offscreen_target_t* target, uint32_t width, uint32_t height);
+
+/** Record the render graph into the next image and submit it, with queued uploads.
+ *  Waits only when the GPU is still working on the frame that last used that image.
+ *  @return CJ_SUCCESS, CJ_E_NOT_READY without a render graph, or the graph's error.
+ */
+CJ_API cj_result_t cj_offscreen_render(cj_offscreen_target_t* target);
+
+/** Get the newest frame whose pixels reached host memory.
+ *  @param wait Block until the newest submitted frame has finished, instead of returning
+ *         the newest frame that already has.
+ *  @param out_frame Receives the frame.
+ *  @return CJ_SUCCESS, CJ_E_NOT_READY when no frame has finished yet (or readback is off),
+ *          or CJ_E_INVALID_ARGUMENT.
+ */
+CJ_API cj_result_t cj_offscreen_read(cj_offscreen_target_t* target, bool wait, cj_offscreen_frame_t* out_frame);
+
+/** Number of frames cj_offscreen_render() has submitted. */
+CJ_API uint64_t cj_offscreen_frame_index(const cj_offscreen_target_t* target);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -0,0 +1,131 @@
+/*
+ * CJelly — Profiling API
+ * Copyright (c) 2025
+ *
+ * Licensed under the MIT license for prototype purposes.
+ */
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "cj_macros.h"
+#include "cj_types.h"
+#include "cj_result.h"
+
+/** @file cj_profiler.h
+ *  @brief CPU zones, per-window GPU timings and trace export.
+ *
+ *  CPU zones are recorded into a lock-free ring owned by the recording thread
+ *  and drained on the main thread once per event loop iteration (or by the
+ *  capture and stats calls). GPU timings come from timestamp queries written
+ *  around every render graph node; they are read back once the GPU finished
+ *  the frame, so they trail the CPU numbers by the frames in flight.
+ *
+ *  Everything records only while cj_profiler_set_enabled(true). Building with
+ *  CJ_ENABLE_PROFILER defined to 0 compiles the zone macros and the library's
+ *  own instrumentation out; the functions then report nothing.
+ */
+
+#ifndef CJ_ENABLE_PROFILER
+#define CJ_ENABLE_PROFILER 1
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Most GPU zones kept per window frame. */
+#define CJ_PROFILER_MAX_GPU_ZONES 32u
+
+/** Longest zone name kept for GPU zones, including the terminator. */
+#define CJ_PROFILER_NAME_SIZE 48u
+
+/** Aggregate of one CPU zone name since the last reset. */
+typedef struct cj_profiler_zone_stat_t {
+  const char* name;   /**< Name passed to the zone (not copied). */
+  uint32_t count;     /**< Number of completed zones. */
+  uint64_t total_ns;  /**< Summed duration. */
+  uint64_t max_ns;    /**< Longest duration. */
+} cj_profiler_zone_stat_t;
+
+/** GPU time of one render graph node. */
+typedef struct cj_profiler_gpu_zone_t {
+  char name[CJ_PROFILER_NAME_SIZE];  /**< Node name. */
+  double ms;                         /**< Time between the timestamps around the node. */
+} cj_profiler_gpu_zone_t;
+
+/** Timings of a window's latest frames. */
+typedef struct cj_profiler_frame_stats_t {
+  uint64_t frame_index;      /**< Frame the CPU time belongs to, 0 if none yet. */
+  double cpu_ms;             /**< cj_window_begin_frame() to the frame's submission. */
+  uint64_t gpu_frame_index;  /**< Frame the GPU times belong to, 0 if none yet. */
+  double gpu_ms;             /**< First to last timestamp of that frame. */
+  uint32_t gpu_zone_count;   /**< Valid entries in gpu_zones. */
+  cj_profiler_gpu_zone_t gpu_zones[CJ_PROFILER_MAX_GPU_ZONES];
+} cj_profiler_frame_stats_t;
+
+/** Check whether the profiler is compiled in. */
+CJ_API bool cj_profiler_available(void);
+
+/** Start or stop recording CPU zones and GPU timestamps. Off by default. */
+CJ_API void cj_profiler_set_enabled(bool enabled);
+
+/** Check whether the profiler is recording. */
+CJ_API bool cj_profiler_is_enabled(void);
+
+/** Begin a CPU zone; prefer CJ_PROFILE_ZONE_BEGIN().
+ *  @param name Zone name; must stay valid while the profiler may report it (use a literal).
+ *  @return Start timestamp to pass to cj_profiler_zone_end(), 0 when not recording.
+ */
+CJ_API uint64_t cj_profiler_zone_begin(const char* name);
+
+/** End a CPU zone begun on the same thread; prefer CJ_PROFILE_ZONE_END(). */
+CJ_API void cj_profiler_zone_end(const char* name, uint64_t start);
+
+/** Drain every thread's zone ring into the aggregates and an active capture.
+ *  The event loop calls this each iteration. Main thread only.
+ */
+CJ_API void cj_profiler_collect(void);
+
+/** Copy the CPU zone aggregates. Collects first. Main thread only.
+ *  @param out_stats Receives up to max_stats entries; may be NULL to count.
+ *  @param max_stats Capacity of out_stats.
+ *  @param reset Start new aggregates afterwards.
+ *  @return Number of distinct zone names.
+ */
+CJ_API uint32_t cj_profiler_zone_stats(cj_profiler_zone_stat_t* out_stats, uint32_t max_stats, bool reset);
+
+/** Get a window's latest CPU and GPU frame timings.
+ *  @param window The window to query.
+ *  @param out_stats Receives the timings.
+ *  @return CJ_SUCCESS, or CJ_E_INVALID_ARGUMENT.
+ */
+CJ_API cj_result_t cj_profiler_window_stats(cj_window_t* window, cj_profiler_frame_stats_t* out_stats);
+
+/** Start keeping every CPU zone for export. Discards a previous capture. Main thread only. */
+CJ_API void cj_profiler_begin_capture(void);
+
+/** Stop the capture and write it in Chrome trace event format (JSON).
+ *  Load it in chrome://tracing or Perfetto, or convert it for Tracy with its
+ *  import-chrome tool.
+ *  @param path File to write.
+ *  @return CJ_SUCCESS, CJ_E_INVALID_ARGUMENT without a capture, CJ_E_UNKNOWN if the file could not
+ *          be written, or CJ_E_UNSUPPORTED when the profiler is compiled out.
+ */
+CJ_API cj_result_t cj_profiler_end_capture(const char* path);
+
+/** @def CJ_PROFILE_ZONE_BEGIN(var, name)
+ *  @brief Begin a CPU zone, keeping its start in a local variable.
+ *  @def CJ_PROFILE_ZONE_END(var, name)
+ *  @brief End the zone begun with the same variable and name.
+ */
+#if CJ_ENABLE_PROFILER
+#define CJ_PROFILE_ZONE_BEGIN(var, name) uint64_t var = cj_profiler_zone_begin(name)
+#define CJ_PROFILE_ZONE_END(var, name) cj_profiler_zone_end((name), (var))
+#else
+#define CJ_PROFILE_ZONE_BEGIN(var, name) ((void)0)
+#define CJ_PROFILE_ZONE_END(var, name) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
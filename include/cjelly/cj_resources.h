@@ -20,7 +20,9 @@
 extern "C" {
 #endif
 
-/** Image formats (subset; expanded later). */
+/** Image formats (subset; expanded later).
+ *  The block-compressed formats each need a device feature: BC (desktop GPUs),
+ *  ETC2 or ASTC (mobile GPUs). Check with cj_texture_format_supported(). */
 typedef enum cj_format_t {
   CJ_FORMAT_UNDEFINED = 0,
   CJ_FORMAT_R8_UNORM,
@@ -35,6 +37,24 @@ typedef enum cj_format_t {
   CJ_FORMAT_RGBA32_FLOAT,
   CJ_FORMAT_D24S8,
   CJ_FORMAT_D32F,
+  CJ_FORMAT_RGBA8_SRGB,
+  CJ_FORMAT_BC1_RGBA_UNORM,   /**< 4x4 blocks of 8 bytes, 1-bit alpha. */
+  CJ_FORMAT_BC1_RGBA_SRGB,
+  CJ_FORMAT_BC3_UNORM,        /**< 4x4 blocks of 16 bytes, interpolated alpha. */
+  CJ_FORMAT_BC3_SRGB,
+  CJ_FORMAT_BC5_UNORM,        /**< 4x4 blocks of 16 bytes, two channels (normal maps). */
+  CJ_FORMAT_BC7_UNORM,        /**< 4x4 blocks of 16 bytes, high quality RGBA. */
+  CJ_FORMAT_BC7_SRGB,
+  CJ_FORMAT_ETC2_RGB8_UNORM,  /**< 4x4 blocks of 8 bytes. */
+  CJ_FORMAT_ETC2_RGB8_SRGB,
+  CJ_FORMAT_ETC2_RGBA8_UNORM, /**< 4x4 blocks of 16 bytes. */
+  CJ_FORMAT_ETC2_RGBA8_SRGB,
+  CJ_FORMAT_ASTC_4x4_UNORM,   /**< 16-byte blocks; larger blocks trade quality for size. */
+  CJ_FORMAT_ASTC_4x4_SRGB,
+  CJ_FORMAT_ASTC_6x6_UNORM,
+  CJ_FORMAT_ASTC_6x6_SRGB,
+  CJ_FORMAT_ASTC_8x8_UNORM,
+  CJ_FORMAT_ASTC_8x8_SRGB,
 } cj_format_t;
 
 typedef enum cj_image_usage_t {
@@ -65,14 +85,31 @@ typedef enum cj_sampler_address_t {
   CJ_ADDRESS_BORDER,
 } cj_sampler_address_t;
 
+/** Source of a streamed texture's mip levels. */
+typedef struct cj_texture_stream_t {
+  /** Write mip level mip of a layer, tightly packed (rows of blocks for compressed formats),
+   *  to out. Called on the engine thread from cj_texture_create() and
+   *  cj_engine_update_streaming(), possibly many times for the same level.
+   *  @return false on failure; the texture then keeps the levels it has. */
+  bool (*load)(void* user, uint32_t mip, uint32_t layer, void* out, size_t size);
+  void* user;
+  uint32_t resident_mips; /**< Smallest levels that are always resident; 0 = those of at most
+                               64 texels a side. */
+} cj_texture_stream_t;
+
 /** Texture descriptor. */
 typedef struct cj_texture_desc_t {
   uint32_t width, height, layers;
-  uint32_t mips;
+  uint32_t mips;     /**< Mip levels; 0 = 1, or the full chain with generate_mips. */
   cj_format_t format;
   uint32_t usage;    /**< OR of cj_image_usage_t. */
   bool     cube;     /**< Treat layers=6 as cubemap if true. */
   bool     transient;/**< Swapchain-dependent or temp (hint). */
+  bool     generate_mips; /**< Rebuild the smaller levels of a layer on the GPU whenever its
+                               mip 0 is uploaded; see cj_texture_can_generate_mips(). */
+  const cj_texture_stream_t* stream; /**< Stream the mips from this source (copied), starting
+                                          with the resident ones; NULL = not streamed. Streamed
+                                          textures are sampled 2D textures that take no uploads. */
   cj_str_t debug_name;
 } cj_texture_desc_t;
 
@@ -84,7 +121,8 @@ typedef struct cj_buffer_desc_t {
   cj_str_t debug_name;
 } cj_buffer_desc_t;
 
-/** Sampler descriptor (cached; identical descriptors dedup). */
+/** Sampler descriptor. Samplers are cached: creating one equal to a live sampler
+ *  (debug_name aside) returns another reference to the same sampler. */
 typedef struct cj_sampler_desc_t {
   cj_sampler_filter_t min_filter;
   cj_sampler_filter_t mag_filter;
@@ -96,13 +134,139 @@ typedef struct cj_sampler_desc_t {
   cj_str_t debug_name;
 } cj_sampler_desc_t;
 
-/** Create, retain, release, and descriptor slot queries. */
+/** Create, retain, release, and descriptor slot queries.
+ *  Handles are reference counted: create returns one reference and the last
+ *  release destroys the resource. Release never waits for the GPU: the handle
+ *  is invalid at once, and the Vulkan objects are freed by
+ *  cj_engine_collect_garbage() after the frames that may use them finished.
+ *  Retain and release may be called from any thread; when the last release
+ *  happens elsewhere, the engine thread picks the resource up at its next frame.
+ */
 CJ_API cj_handle_t cj_texture_create(cj_engine_t*, const cj_texture_desc_t*);
 CJ_API void        cj_texture_retain(cj_engine_t*, cj_handle_t);
 CJ_API void        cj_texture_release(cj_engine_t*, cj_handle_t);
+
+/** Element of the engine's texture table holding a texture, for shaders that
+ *  index textures by slot. Sampled textures are written to the table when they
+ *  are created; the slot is reused once the texture is released.
+ *  The table holds cj_bindless_info_t.images_capacity textures; those created
+ *  while it is full are not in it.
+ *  @return The slot, or 0 for an invalid handle or a texture not in the table.
+ */
 CJ_API uint32_t    cj_texture_descriptor_slot(cj_engine_t*, cj_handle_t);
 
+/** Report the size in pixels a streamed texture is drawn at, for every frame that draws it.
+ *  cj_engine_update_streaming() then loads the levels needed for that size, and the textures
+ *  reported least recently are the first to lose detail when memory runs short.
+ *  Does nothing for other textures.
+ */
+CJ_API void        cj_texture_request_extent(cj_engine_t*, cj_handle_t texture, uint32_t width, uint32_t height);
+
+/** Most detailed mip level of a streamed texture that shaders can sample, counting from
+ *  the full-size level 0; 0 for textures that are not streamed. */
+CJ_API uint32_t    cj_texture_resident_mip(cj_engine_t*, cj_handle_t texture);
+
+/** Check whether sampled textures of a format can be created on the engine's device. */
+CJ_API bool        cj_texture_format_supported(cj_engine_t*, cj_format_t format);
+
+/** Check whether textures of a format can use cj_texture_desc_t.generate_mips, which
+ *  downsamples with blits. Compressed formats cannot; encode their mips offline. */
+CJ_API bool        cj_texture_can_generate_mips(cj_engine_t*, cj_format_t format);
+
+/** Pick the first format of a preference list that the device supports, such as
+ *  { CJ_FORMAT_BC7_UNORM, CJ_FORMAT_ASTC_4x4_UNORM, CJ_FORMAT_ETC2_RGBA8_UNORM, CJ_FORMAT_RGBA8_UNORM }.
+ *  @return The format, or CJ_FORMAT_UNDEFINED when none is supported.
+ */
+CJ_API cj_format_t cj_texture_pick_format(cj_engine_t*, const cj_format_t* formats, uint32_t count);
+
+/** Identifies queued uploads. Tickets increase monotonically; 0 means nothing to wait for. */
+typedef uint64_t cj_upload_ticket_t;
+
+/** Texel data for one region of one mip level and layer of a texture.
+ *  For block-compressed formats the region is aligned to blocks (it may end at the
+ *  edge of the mip level instead) and data holds rows of blocks. */
+typedef struct cj_texture_upload_t {
+  uint32_t x, y;           /**< Region origin in texels. */
+  uint32_t width, height;  /**< Region size; 0 = the whole mip level. */
+  uint32_t mip;
+  uint32_t layer;
+  const void* data;        /**< Texels in the texture format. */
+  uint32_t row_pitch;      /**< Bytes between rows (of blocks) of data; 0 = tightly packed. */
+} cj_texture_upload_t;
+
+/** Queue texel data for a texture. The data is copied before returning, but
+ *  the GPU copy happens asynchronously: uploads are batched and submitted
+ *  with the next frame (or cj_upload_flush), on a dedicated transfer queue
+ *  when the device has one. Frames submitted afterwards see the new texels.
+ *  For a texture created with generate_mips, an upload to mip 0 also regenerates
+ *  the layer's smaller levels, once per batch and in the same submission.
+ *  @return Ticket to poll or wait on, or 0 on failure.
+ */
+CJ_API cj_upload_ticket_t cj_upload_texture(cj_engine_t*, cj_handle_t texture, const cj_texture_upload_t* upload);
+
+/** Decoder for supercompressed KTX2 files (Basis Universal ETC1S and UASTC, Zstandard),
+ *  typically a thin wrapper around the Basis Universal transcoder. CJelly itself
+ *  reads only KTX2 files without supercompression. */
+typedef struct cj_ktx2_transcoder_t {
+  /** Start decoding a file; returns state passed to the other calls, or NULL on failure. */
+  void* (*open)(void* user, const void* file, size_t size);
+  /** Write one image (tightly packed blocks of format) of a level, layer and face to out. */
+  bool  (*transcode)(void* state, uint32_t level, uint32_t layer, uint32_t face,
+                     cj_format_t format, void* out, size_t out_size);
+  void  (*close)(void* state);
+  /** Formats Basis Universal data can become, best first; the first one the device
+   *  supports is used. Zstandard files keep the format they store. */
+  const cj_format_t* formats;
+  uint32_t format_count;
+  void* user;
+} cj_ktx2_transcoder_t;
+
+/** KTX2 texture loading options. */
+typedef struct cj_ktx2_load_desc_t {
+  uint32_t usage;       /**< OR of cj_image_usage_t; 0 = CJ_IMAGE_SAMPLED. */
+  uint32_t skip_mips;   /**< Leave out this many of the largest mip levels (always keeps one). */
+  const cj_ktx2_transcoder_t* transcoder; /**< NULL = supercompressed files are unsupported. */
+  cj_str_t debug_name;
+} cj_ktx2_load_desc_t;
+
+/** Create a texture from a KTX2 file with its mip chain, array layers and cube faces.
+ *  The file is memory mapped and each level is copied (or transcoded) straight into
+ *  staging memory of the upload queue; the texture is usable once the ticket completes.
+ *  @param desc Options; NULL = defaults.
+ *  @param out_texture Receives the texture.
+ *  @param out_ticket Optional; receives the ticket of the last upload.
+ *  @return CJ_SUCCESS, CJ_E_NOT_FOUND, CJ_E_INVALID_ARGUMENT for a malformed file,
+ *          CJ_E_UNSUPPORTED for a format the device (or a missing transcoder) cannot
+ *          handle, or CJ_E_OUT_OF_MEMORY.
+ */
+CJ_API cj_result_t cj_texture_load_ktx2(cj_engine_t*, const char* path, const cj_ktx2_load_desc_t* desc,
+                                        cj_handle_t* out_texture, cj_upload_ticket_t* out_ticket);
+
+/** Like cj_texture_load_ktx2(), from a KTX2 file in memory. The data is not kept. */
+CJ_API cj_result_t cj_texture_load_ktx2_memory(cj_engine_t*, const void* data, size_t size,
+                                               const cj_ktx2_load_desc_t* desc,
+                                               cj_handle_t* out_texture, cj_upload_ticket_t* out_ticket);
+
+/** Submit all queued uploads now instead of with the next frame.
+ *  @return Ticket covering everything submitted so far.
+ */
+CJ_API cj_upload_ticket_t cj_upload_flush(cj_engine_t*);
+
+/** Check without blocking whether the uploads of a ticket are resident on the GPU. */
+CJ_API bool cj_upload_is_complete(cj_engine_t*, cj_upload_ticket_t ticket);
+
+/** Block until the uploads of a ticket are resident, submitting them if needed. */
+CJ_API void cj_upload_wait(cj_engine_t*, cj_upload_ticket_t ticket);
+
 CJ_API cj_handle_t cj_buffer_create(cj_engine_t*, const cj_buffer_desc_t*);
+
+/** Queue bytes for a buffer created with CJ_BUFFER_TRANSFER_DST. The data is
+ *  copied before returning and reaches the buffer with the next batch of
+ *  uploads, like cj_upload_texture. The GPU must not be reading the range.
+ *  @return Ticket to poll or wait on, or 0 on failure.
+ */
+CJ_API cj_upload_ticket_t cj_upload_buffer(cj_engine_t*, cj_handle_t buffer, uint64_t offset, const void* data, uint64_t size);
+
 CJ_API void        cj_buffer_retain(cj_engine_t*, cj_handle_t);
 CJ_API void        cj_buffer_release(cj_engine_t*, cj_handle_t);
 CJ_API uint32_t    cj_buffer_descriptor_slot(cj_engine_t*, cj_handle_t);
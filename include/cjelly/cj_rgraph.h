@@ -13,6 +13,7 @@
 #include "cj_types.h"
 #include "cj_result.h"
 #include "cj_resources.h"
+#include "cj_mesh.h"
 
 /** @file cj_rgraph.h
  *  @brief Minimal render-graph hooks (stub). Concrete API TBD.
@@ -22,6 +23,9 @@
 extern "C" {
 #endif
 
+/** Name of the imported swapchain image. Nodes write it unless told otherwise. */
+#define CJ_RGRAPH_BACKBUFFER "backbuffer"
+
 /** Render graph creation descriptor. */
 typedef struct cj_rgraph_desc_t {
   uint32_t reserved;  /**< Reserved for future use. */
@@ -41,11 +45,47 @@ CJ_API cj_rgraph_t* cj_rgraph_create(cj_engine_t* engine, const cj_rgraph_desc_t
 CJ_API void         cj_rgraph_destroy(cj_rgraph_t* graph);
 
 /** Recompile the graph after a window resize or pipeline cache change.
+ *  Orders nodes by their declared reads and writes, culls nodes that do not
+ *  contribute to the backbuffer, assigns transients with disjoint lifetimes to
+ *  shared memory and plans the barriers between writers and readers. Called
+ *  automatically by cj_rgraph_execute() when nodes or resources changed.
  *  @param graph The render graph to recompile.
- *  @return CJ_SUCCESS on success, or an error code.
+ *  @return CJ_SUCCESS on success, CJ_E_INVALID_ARGUMENT if the graph has a
+ *          cycle, a transient with more than one writer, or a read of a
+ *          resource nothing writes; or another error code.
  */
 CJ_API cj_result_t  cj_rgraph_recompile(cj_rgraph_t* graph);
 
+/** Declare a graph-owned color target that nodes can render into and sample.
+ *  The image uses the engine color format and is sized relative to the
+ *  execute extent. Redeclaring an existing transient updates its scale.
+ *  @param graph The render graph to declare the resource in.
+ *  @param name Resource name; must not be CJ_RGRAPH_BACKBUFFER.
+ *  @param scale Size relative to the execute extent, in (0, 1].
+ *  @return CJ_SUCCESS on success, or an error code.
+ */
+CJ_API cj_result_t  cj_rgraph_declare_transient(cj_rgraph_t* graph, cj_str_t name, float scale);
+
+/** Declare that a node samples a transient.
+ *  Blur and textured nodes sample their first declared read instead of the
+ *  default texture.
+ *  @param graph The render graph containing the node.
+ *  @param node_name Name the node was added with.
+ *  @param resource Name of a declared transient.
+ *  @return CJ_SUCCESS on success, CJ_E_NOT_FOUND for an unknown node or
+ *          resource, or another error code.
+ */
+CJ_API cj_result_t  cj_rgraph_node_read(cj_rgraph_t* graph, const char* node_name, cj_str_t resource);
+
+/** Declare the resource a node renders into (CJ_RGRAPH_BACKBUFFER by default).
+ *  @param graph The render graph containing the node.
+ *  @param node_name Name the node was added with.
+ *  @param resource CJ_RGRAPH_BACKBUFFER or the name of a declared transient.
+ *  @return CJ_SUCCESS on success, CJ_E_NOT_FOUND for an unknown node or
+ *          resource, or another error code.
+ */
+CJ_API cj_result_t  cj_rgraph_node_write(cj_rgraph_t* graph, const char* node_name, cj_str_t resource);
+
 /** Bind a named external resource (e.g., texture) into the graph.
  *  @param graph The render graph to bind the resource to.
  *  @param name Name of the binding point.
@@ -62,14 +102,98 @@ CJ_API cj_result_t  cj_rgraph_bind_texture(cj_rgraph_t* graph, cj_str_t name, cj
  */
 CJ_API cj_result_t  cj_rgraph_set_i32(cj_rgraph_t* graph, cj_str_t name, int32_t value);
 
+/** Value type of a render graph parameter, fixed when it is first declared. */
+typedef enum cj_rgraph_param_type_t {
+  CJ_RGRAPH_PARAM_I32 = 0,  /**< int32_t; starts at 0. */
+  CJ_RGRAPH_PARAM_F32,      /**< float; starts at 0. */
+  CJ_RGRAPH_PARAM_VEC4,     /**< float[4]; starts at 0. */
+  CJ_RGRAPH_PARAM_MAT4,     /**< float[16], column-major as in GLSL; starts as the identity. */
+} cj_rgraph_param_type_t;
+
+/** Dense ID of a render graph parameter; 0 is never a valid ID. */
+typedef uint32_t cj_rgraph_param_id_t;
+
+/** Resolve a parameter name to an ID once, declaring the parameter if needed,
+ *  so per-frame updates go through the cj_rgraph_set_param_*() setters
+ *  without name lookups. IDs stay valid for the lifetime of the graph.
+ *  @param graph The render graph to resolve the parameter in.
+ *  @param name Name of the parameter; at most 63 bytes.
+ *  @param type Value type; must match the type the parameter was declared with.
+ *  @return The ID, or 0 on a type mismatch, an invalid name or out of memory.
+ */
+CJ_API cj_rgraph_param_id_t cj_rgraph_param_id(cj_rgraph_t* graph, cj_str_t name, cj_rgraph_param_type_t type);
+
+/** Set a parameter by ID. Each setter requires the parameter's declared type.
+ *  Nodes read the values when the graph is next executed.
+ *  @return CJ_SUCCESS on success, or CJ_E_INVALID_ARGUMENT for an unknown ID
+ *          or another type.
+ */
+CJ_API cj_result_t  cj_rgraph_set_param_i32(cj_rgraph_t* graph, cj_rgraph_param_id_t id, int32_t value);
+CJ_API cj_result_t  cj_rgraph_set_param_f32(cj_rgraph_t* graph, cj_rgraph_param_id_t id, float value);
+CJ_API cj_result_t  cj_rgraph_set_param_vec4(cj_rgraph_t* graph, cj_rgraph_param_id_t id, const float value[4]);
+CJ_API cj_result_t  cj_rgraph_set_param_mat4(cj_rgraph_t* graph, cj_rgraph_param_id_t id, const float value[16]);
+
+/** Set a float, vector or matrix parameter by name, declaring it if needed.
+ *  Convenient for occasional changes; resolve an ID for per-frame ones.
+ *  @return CJ_SUCCESS on success, CJ_E_INVALID_ARGUMENT if the parameter was
+ *          declared with another type, or another error code.
+ */
+CJ_API cj_result_t  cj_rgraph_set_f32(cj_rgraph_t* graph, cj_str_t name, float value);
+CJ_API cj_result_t  cj_rgraph_set_vec4(cj_rgraph_t* graph, cj_str_t name, const float value[4]);
+CJ_API cj_result_t  cj_rgraph_set_mat4(cj_rgraph_t* graph, cj_str_t name, const float value[16]);
+
 /** Add a blur post-processing node to the render graph.
+ *  The node blurs its first declared read, or the default texture, with a
+ *  separable Gaussian into its write target. It starts with the defaults of
+ *  cj_rgraph_blur_desc_t; see cj_rgraph_set_blur().
  *  @param graph The render graph to add the node to.
  *  @param name Name for the blur node.
  *  @return CJ_SUCCESS on success, or an error code.
  */
 CJ_API cj_result_t  cj_rgraph_add_blur_node(cj_rgraph_t* graph, const char* name);
 
+/** Let a blur node pick its downsample level from the radius. */
+#define CJ_RGRAPH_BLUR_DOWNSAMPLE_AUTO (-1)
+/** Blur radius, in pixels, of a "blur_intensity" parameter of 1000. */
+#define CJ_RGRAPH_BLUR_INTENSITY_RADIUS 32.0f
+
+/** How a blur node filters. Zero-initialize, then set downsample to
+ *  CJ_RGRAPH_BLUR_DOWNSAMPLE_AUTO for the defaults nodes are added with.
+ */
+typedef struct cj_rgraph_blur_desc_t {
+  float radius;          /**< Pixels of the target the blur reaches to each side (about three
+                              standard deviations); 0 follows the graph's "blur_intensity"
+                              parameter: an i32 in thousandths of CJ_RGRAPH_BLUR_INTENSITY_RADIUS,
+                              or an f32 as a fraction of it. */
+  int32_t downsample;    /**< Times the input is halved (dual-Kawase) before blurring: 0, 1 or 2,
+                              or CJ_RGRAPH_BLUR_DOWNSAMPLE_AUTO to halve as the radius grows. */
+  bool use_compute;      /**< Blur in a compute shader with shared-memory tiles when the device
+                              can write RGBA8 storage images; otherwise fragment passes are used. */
+  bool async_compute;    /**< With use_compute: run the compute passes on the engine's async compute
+                              queue, overlapping the next frame's geometry, and show their result a
+                              frame later. Frames without a previous result (the first one, or after
+                              a resize or level change) blur on the graphics queue. Ignored without a
+                              dedicated compute family or timeline semaphores. Unlike sprite nodes, it
+                              requires the graph to be executed by one window at most once per frame. */
+} cj_rgraph_blur_desc_t;
+
+/** Change how a blur node filters, starting with the next execute.
+ *  Images the node keeps at its previous downsample levels or path are
+ *  released after waiting for the device.
+ *  @param graph The render graph containing the node.
+ *  @param node_name Name the blur node was added with.
+ *  @param desc Filter settings.
+ *  @return CJ_SUCCESS on success, CJ_E_NOT_FOUND if no blur node has that
+ *          name, or CJ_E_INVALID_ARGUMENT for a negative radius or an unknown
+ *          downsample level.
+ */
+CJ_API cj_result_t  cj_rgraph_set_blur(cj_rgraph_t* graph, const char* node_name, const cj_rgraph_blur_desc_t* desc);
+
 /** Add a textured rendering node to the render graph.
+ *  The node draws its first declared read if it has one, else the texture
+ *  bound with cj_rgraph_bind_texture() under the node's name, else the
+ *  default texture. Bound textures are sampled from the engine's texture
+ *  table by descriptor slot when the device supports descriptor indexing.
  *  @param graph The render graph to add the node to.
  *  @param name Name for the textured node.
  *  @return CJ_SUCCESS on success, or an error code.
@@ -83,14 +207,170 @@ CJ_API cj_result_t  cj_rgraph_add_textured_node(cj_rgraph_t* graph, const char*
  */
 CJ_API cj_result_t  cj_rgraph_add_color_node(cj_rgraph_t* graph, const char* name);
 
+/** One quad drawn by a sprite node. The layout matches the instance data the
+ *  node uploads, so arrays can be handed over without conversion.
+ */
+typedef struct cj_rgraph_sprite_t {
+  float rect[4];          /**< x, y, width, height in pixels of the render target; origin top-left. */
+  float uv_rect[4];       /**< u0, v0, u1, v1 sampled across the rect, e.g. an atlas entry's uMin, vMin, uMax, vMax. */
+  float color[4];         /**< RGBA multiplier; the sprite's color when untextured. */
+  uint32_t texture_slot;  /**< cj_texture_descriptor_slot() of the texture; 0 = solid color. */
+} cj_rgraph_sprite_t;
+
+/** Add a sprite batch node: draws every sprite set with cj_rgraph_set_sprites()
+ *  in one instanced draw, alpha blended in array order. Textures are sampled
+ *  from the engine's texture table, so the node needs descriptor indexing.
+ *  The whole batch follows two parameters, "<name>.transform" (mat4 applied to
+ *  pixel positions) and "<name>.tint" (vec4 multiplied into sprite colors),
+ *  which reach the shaders through the graph's per-frame uniform buffer. They
+ *  are declared with the node as the identity and opaque white.
+ *  @param graph The render graph to add the node to.
+ *  @param name Name for the sprite node.
+ *  @return CJ_SUCCESS on success, CJ_E_UNSUPPORTED without a texture table,
+ *          or another error code.
+ */
+CJ_API cj_result_t  cj_rgraph_add_sprite_node(cj_rgraph_t* graph, const char* name);
+
+/** Replace the sprites a sprite node draws, starting with the next execute.
+ *  The sprites are copied straight into a persistently mapped instance
+ *  buffer that no frame in flight reads; the node keeps a ring of them, so
+ *  windows sharing the graph may each have their frames in flight. When every
+ *  buffer is still read, this waits for the device. Calling this again before
+ *  the next execute overwrites the same buffer.
+ *  @param graph The render graph containing the node.
+ *  @param node_name Name the sprite node was added with.
+ *  @param sprites Sprites to draw; may be NULL when count is 0.
+ *  @param count Number of sprites.
+ *  @return CJ_SUCCESS on success, CJ_E_NOT_FOUND if no sprite node has that
+ *          name, or another error code.
+ */
+CJ_API cj_result_t  cj_rgraph_set_sprites(cj_rgraph_t* graph, const char* node_name,
+                                          const cj_rgraph_sprite_t* sprites, uint32_t count);
+
+/** One object drawn by a mesh node: a range of the node's mesh placed in the
+ *  scene. The layout matches the storage buffer the culling pass and vertex
+ *  shader read (std430), so arrays can be handed over without conversion.
+ */
+typedef struct cj_rgraph_mesh_object_t {
+  float transform[16];    /**< Object to world, column-major. */
+  float bounds_min[3];    /**< Object-space bounding box the culling pass tests. */
+  uint32_t first_index;   /**< First index of the range drawn, e.g. a cj_mesh_range_t's. */
+  float bounds_max[3];
+  uint32_t index_count;   /**< Indices drawn; 0 skips the object. */
+  float color[4];         /**< RGBA; alpha covers the target when composited. */
+} cj_rgraph_mesh_object_t;
+
+/** Add a GPU-driven mesh node. Every frame a compute pass tests each object
+ *  set with cj_rgraph_set_mesh_objects() against the view frustum and writes
+ *  the indirect draws of the visible ones, which a single
+ *  vkCmdDrawIndexedIndirectCount draws, so recording costs the same for any
+ *  number of objects. Without VK_KHR_draw_indirect_count the node issues one
+ *  multi-draw over every object instead, and culled objects draw no
+ *  instances. The objects are depth tested in images the node owns, which
+ *  are then blended over the node's target. The view and projection come from
+ *  "<name>.view_proj" (mat4, Vulkan clip space), declared with the node as
+ *  the identity.
+ *  @param graph The render graph to add the node to.
+ *  @param name Name for the mesh node.
+ *  @return CJ_SUCCESS on success, CJ_E_UNSUPPORTED when the device lacks
+ *          multi-draw indirect or compute on the graphics queue, or another
+ *          error code.
+ */
+CJ_API cj_result_t  cj_rgraph_add_mesh_node(cj_rgraph_t* graph, const char* name);
+
+/** Set the mesh a mesh node draws its objects from. The node only refers to
+ *  the mesh, which must outlive it or be replaced first.
+ *  @param graph The render graph containing the node.
+ *  @param node_name Name the mesh node was added with.
+ *  @param mesh Mesh from cj_mesh_upload(), or NULL to draw nothing.
+ *  @return CJ_SUCCESS on success, CJ_E_NOT_FOUND if no mesh node has that
+ *          name, CJ_E_INVALID_ARGUMENT for a mesh of another vertex layout.
+ */
+CJ_API cj_result_t  cj_rgraph_set_mesh(cj_rgraph_t* graph, const char* node_name, const cj_mesh_t* mesh);
+
+/** Replace the objects a mesh node draws, starting with the next execute.
+ *  Like cj_rgraph_set_sprites(), the objects are copied into a ring of
+ *  persistently mapped buffers, taking one no frame in flight reads; objects
+ *  that do not change need not be set again.
+ *  @param graph The render graph containing the node.
+ *  @param node_name Name the mesh node was added with.
+ *  @param objects Objects to draw; may be NULL when count is 0.
+ *  @param count Number of objects, at most the device's maxDrawIndirectCount.
+ *  @return CJ_SUCCESS on success, CJ_E_NOT_FOUND if no mesh node has that
+ *          name, or another error code.
+ */
+CJ_API cj_result_t  cj_rgraph_set_mesh_objects(cj_rgraph_t* graph, const char* node_name,
+                                               const cj_rgraph_mesh_object_t* objects, uint32_t count);
+
+/** Compile the graph, build its transient images for an extent and plan the
+ *  next frame drawn at it (blur levels and their images) without recording
+ *  anything. Call it on the engine thread before each frame is recorded at the
+ *  extent; recording only reads what it prepared, so it may run on worker
+ *  threads. A graph keeps the images of up to four extents, for windows of
+ *  different sizes sharing it; a fifth replaces the one prepared longest ago.
+ *  @param graph The render graph to prepare.
+ *  @param extent Backbuffer extent transients are scaled from.
+ *  @return CJ_SUCCESS on success, or an error code.
+ */
+CJ_API cj_result_t  cj_rgraph_prepare(cj_rgraph_t* graph, VkExtent2D extent);
+
+/** Record the nodes that render into transients, and the passes blur nodes
+ *  run before their final one (downsampling and the horizontal pass).
+ *  Must be called outside of any render pass, before the backbuffer pass that
+ *  cj_rgraph_execute() records into. Does nothing for graphs without
+ *  transients or blur nodes. Uses the images cj_rgraph_prepare() built for the
+ *  extent.
+ *  @param graph The render graph to execute.
+ *  @param cmd Command buffer in the recording state.
+ *  @param extent Backbuffer extent transients are scaled from.
+ *  @return CJ_SUCCESS on success, CJ_E_NOT_READY if the graph was not prepared
+ *          for the extent since it last changed, or an error code.
+ */
+CJ_API cj_result_t  cj_rgraph_execute_offscreen(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent);
+
 /** Execute the render graph with the given command buffer and extent.
+ *  Records the live nodes that write the backbuffer, in compiled order, into
+ *  the currently open render pass.
  *  @param graph The render graph to execute.
  *  @param cmd Command buffer to record rendering commands into.
  *  @param extent Viewport extent for rendering.
- *  @return CJ_SUCCESS on success, or an error code.
+ *  @return CJ_SUCCESS on success, CJ_E_NOT_READY if the graph has transients
+ *          or blur nodes and cj_rgraph_execute_offscreen() was not recorded
+ *          first, or an error code.
  */
 CJ_API cj_result_t  cj_rgraph_execute(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent);
 
+/** Execute the render graph for part of the backbuffer.
+ *  Like cj_rgraph_execute(), but every node draw is scissored to the region,
+ *  so pixels outside it keep what the render pass loaded. Used for partial
+ *  redraws of damaged window areas.
+ *  @param graph The render graph to execute.
+ *  @param cmd Command buffer to record rendering commands into.
+ *  @param extent Viewport extent for rendering.
+ *  @param region Backbuffer rectangle to redraw, or NULL for all of it.
+ *  @return The same results as cj_rgraph_execute().
+ */
+CJ_API cj_result_t  cj_rgraph_execute_region(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent,
+                                             const VkRect2D* region);
+
+/** Check whether the graph's backbuffer commands can be recorded once and replayed.
+ *  True when every live backbuffer node draws the same commands until the
+ *  graph changes (no self-animating or pass-through nodes). Recompiles the
+ *  graph if needed.
+ *  @param graph The render graph to inspect.
+ *  @return true if the output of cj_rgraph_execute() may be cached.
+ */
+CJ_API bool         cj_rgraph_is_static(cj_rgraph_t* graph);
+
+/** Get a counter that changes whenever cj_rgraph_execute() would record
+ *  different commands: texture bindings, parameter changes, recompiles,
+ *  transient rebuilds and engine color multiplier updates.
+ *  A recording is reusable while this value and the extent are unchanged.
+ *  @param graph The render graph to inspect.
+ *  @return The current content version.
+ */
+CJ_API uint64_t     cj_rgraph_content_version(cj_rgraph_t* graph);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
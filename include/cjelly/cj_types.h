@@ -31,6 +31,9 @@ typedef struct cj_rgraph_t      cj_rgraph_t;
 /** @brief Optional custom allocator callbacks. */
 typedef struct cj_allocator_t   cj_allocator_t;
 
+/** @brief Opaque linear allocator for per-frame memory (see cj_arena.h). */
+typedef struct cj_arena_t       cj_arena_t;
+
 /** Generic handle: (index:32 | generation:32).
  *  Used to reference resources in a type-safe way with generation tracking.
  */
@@ -66,8 +69,11 @@ typedef enum cj_render_reason_t {
  */
 typedef struct cj_frame_info_t {
   uint64_t frame_index;              /**< Monotonically increasing frame number for this window. */
-  double   delta_seconds;            /**< Time since last frame in seconds (currently stubbed). */
+  double   delta_seconds;            /**< Smoothed time since the window's previous frame in seconds
+                                          (from present timestamps where the display reports them), 0 for the first frame. */
   cj_render_reason_t render_reason;   /**< Why this frame is being rendered. */
+  cj_arena_t* arena;                  /**< Memory dropped when the next frame starts (cj_arena_alloc());
+                                           NULL until the engine started a frame. */
 } cj_frame_info_t;
 
 /** Bool tri-state for feature requests. */
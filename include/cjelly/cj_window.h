@@ -22,14 +22,33 @@
 extern "C" {
 #endif
 
-/** Swapchain present mode preference. */
+/** Swapchain present mode preference.
+ *  If the surface does not support the requested mode, the backend falls back:
+ *  VSYNC_RELAXED -> VSYNC; MAILBOX -> IMMEDIATE -> VSYNC;
+ *  IMMEDIATE -> MAILBOX -> VSYNC. VSYNC (FIFO) is always available.
+ *  MAILBOX requests three swapchain images; the other modes request two
+ *  (both subject to surface limits).
+ */
 typedef enum cj_present_mode_t {
   CJ_PRESENT_VSYNC = 0,     /**< FIFO. */
   CJ_PRESENT_MAILBOX,       /**< Low-latency, potentially higher power. */
   CJ_PRESENT_IMMEDIATE,     /**< Tearing allowed. */
+  CJ_PRESENT_VSYNC_RELAXED, /**< FIFO relaxed: tears instead of stalling when a frame misses vblank. */
   CJ_PRESENT_DEFAULT = CJ_PRESENT_VSYNC
 } cj_present_mode_t;
 
+/** Swapchain color format preference.
+ *  Surfaces that lack the requested format fall back to the default, and the
+ *  default to the first 8-bit sRGB format the surface offers. Windows with
+ *  different formats share the engine's pipelines: the renderer builds a
+ *  variant of each pipeline per format on first use.
+ */
+typedef enum cj_surface_format_t {
+  CJ_SURFACE_FORMAT_DEFAULT = 0, /**< 8-bit sRGB (B8G8R8A8_SRGB where available). */
+  CJ_SURFACE_FORMAT_10BIT,       /**< 10 bits per color channel (A2B10G10R10 or A2R10G10B10 UNORM).
+                                      UNORM has no sRGB encoding: shader output is stored as is. */
+} cj_surface_format_t;
+
 /** Window state. */
 typedef enum cj_window_state_t {
   CJ_WINDOW_STATE_NORMAL = 0,    /**< Normal windowed state. */
@@ -41,6 +60,10 @@ typedef enum cj_window_state_t {
 /** Window position constants. */
 #define CJ_WINDOW_POSITION_DEFAULT INT32_MIN  /**< Let platform choose position. */
 
+/** Frames-in-flight limits. */
+#define CJ_WINDOW_DEFAULT_FRAMES_IN_FLIGHT 2u  /**< Used when cj_window_desc_t.frames_in_flight is 0. */
+#define CJ_WINDOW_MAX_FRAMES_IN_FLIGHT 4u      /**< Larger requests are clamped to this value. */
+
 /** Window creation descriptor (platform-agnostic). */
 typedef struct cj_window_desc_t {
   uint32_t width;
@@ -51,8 +74,9 @@ typedef struct cj_window_desc_t {
   int32_t y;                      /**< Initial Y position (screen coordinates). Use CJ_WINDOW_POSITION_DEFAULT to let platform choose. */
   cj_window_state_t initial_state; /**< Initial window state. Defaults to CJ_WINDOW_STATE_NORMAL. */
 
-  cj_present_mode_t present_mode; /**< Preference; backend may override. */
-  uint32_t frames_in_flight;      /**< 0 = default (typically 2 or 3). */
+  cj_present_mode_t present_mode; /**< Preference; falls back per cj_present_mode_t if unsupported. */
+  cj_surface_format_t surface_format; /**< Preference; falls back per cj_surface_format_t if unsupported. */
+  uint32_t frames_in_flight;      /**< Frames the CPU may record ahead of the GPU. 0 = CJ_WINDOW_DEFAULT_FRAMES_IN_FLIGHT; clamped to CJ_WINDOW_MAX_FRAMES_IN_FLIGHT. */
 
   /** Optional native surface hookup (created externally).
    *  If NULL, CJelly will create an OS surface for you (where supported).
@@ -116,6 +140,12 @@ CJ_API void cj_window_set_render_graph(cj_window_t* win, cj_rgraph_t* graph);
  */
 CJ_API void cj_window_get_size(const cj_window_t* win, uint32_t* out_w, uint32_t* out_h);
 
+/** Query the color format the window's swapchain uses after fallback.
+ *  @param win The window to query.
+ *  @return CJ_SURFACE_FORMAT_10BIT for a 10-bit swapchain, otherwise CJ_SURFACE_FORMAT_DEFAULT.
+ */
+CJ_API cj_surface_format_t cj_window_get_surface_format(const cj_window_t* win);
+
 /** Get the per-window frame index (monotonically increasing).
  *  @param win The window to query.
  *  @return The current frame index for this window.
@@ -305,6 +335,39 @@ CJ_API void cj_window_on_focus(cj_window_t* window,
                                cj_focus_callback_t callback,
                                void* user_data);
 
+/** Keep the pointer motion samples merged into each delivered CJ_MOUSE_MOVE.
+ *  Input callbacks run when cj_poll_events() delivers the window's queued input;
+ *  consecutive motion events (with the same modifiers) then arrive as one, with
+ *  the latest position and the summed deltas. Off by default.
+ *  @param window The window to configure.
+ *  @param enabled True to record the merged samples.
+ */
+CJ_API void cj_window_set_input_history(cj_window_t* window, bool enabled);
+
+/** Get the motion samples merged into the mouse event being delivered.
+ *  Only valid inside a mouse callback, and only while history is enabled.
+ *  @param window The window whose mouse callback is running.
+ *  @param out_samples Receives the samples, oldest first and ending with the
+ *         delivered event. Can be NULL.
+ *  @return Number of samples; 0 outside a CJ_MOUSE_MOVE callback.
+ */
+CJ_API uint32_t cj_window_get_input_history(cj_window_t* window, const cj_mouse_event_t** out_samples);
+
+/** Deliver the window's input on a dedicated thread instead of the polling one.
+ *  Callbacks then run as soon as cj_poll_events() has read the platform events,
+ *  without waiting for the caller to finish its frame. They must not call the
+ *  window API or record GPU work, and must synchronize with the main thread.
+ *  The exceptions are cj_window_post_redraw() and cj_window_destroy() on the
+ *  callback's own window: the window stops receiving input and the next
+ *  cj_poll_events() destroys it, so it stays valid until then. Registering an
+ *  input callback from another thread stops the input thread while it changes.
+ *  Disabling the thread delivers what it still holds first.
+ *  @param window The window to configure.
+ *  @param enabled True to start the input thread, false to stop it.
+ *  @return CJ_SUCCESS, or an error if the thread could not be started.
+ */
+CJ_API cj_result_t cj_window_set_input_thread(cj_window_t* window, bool enabled);
+
 /** Get the current mouse position in window coordinates.
  *  @param window The window to query mouse position for.
  *  @param out_x Pointer to receive X coordinate (0 = left edge). Can be NULL.
@@ -350,6 +413,30 @@ CJ_API void cj_window_mark_dirty(cj_window_t* window);
  */
 CJ_API void cj_window_mark_dirty_with_reason(cj_window_t* window, cj_render_reason_t reason);
 
+/** Request a redraw from any thread.
+ *  Background work uses this instead of cj_window_mark_dirty(), which is main
+ *  thread only. Wakes an event loop blocked in cj_wait_events(); the loop marks
+ *  the window dirty with CJ_RENDER_REASON_FORCED on its next iteration.
+ *  The window must not be destroyed while the call is in progress.
+ *  @param window The window to redraw.
+ */
+CJ_API void cj_window_post_redraw(cj_window_t* window);
+
+/** Mark part of a window as needing redraw.
+ *  Rectangles marked before the next frame accumulate; that frame redraws only
+ *  their union and keeps the rest of the previous contents, and presents tell
+ *  the compositor which rectangles changed where the device supports
+ *  VK_KHR_incremental_present. Any full-window mark (cj_window_mark_dirty(),
+ *  resize, expose) takes precedence. Windows with CJ_REDRAW_ALWAYS always
+ *  redraw in full. The render reason is set to CJ_RENDER_REASON_FORCED.
+ *  @param window The window to mark as dirty.
+ *  @param x Left edge in framebuffer pixels.
+ *  @param y Top edge in framebuffer pixels.
+ *  @param width Width in framebuffer pixels; 0 marks nothing.
+ *  @param height Height in framebuffer pixels; 0 marks nothing.
+ */
+CJ_API void cj_window_mark_dirty_rect(cj_window_t* window, int32_t x, int32_t y, uint32_t width, uint32_t height);
+
 /** Clear the dirty flag for a window.
  *  @param window The window to clear the dirty flag for.
  */
@@ -7,9 +7,14 @@
 #include "cj_types.h"
 #include "cj_result.h"
 #include "cj_engine.h"
+#include "cj_arena.h"
 #include "cj_platform.h"
 #include "cj_window.h"
 #include "cj_resources.h"
+#include "cj_mesh.h"
+#include "cj_asset.h"
 #include "cj_rgraph.h"
+#include "cj_offscreen.h"
+#include "cj_profiler.h"
 #include "runtime.h"
 
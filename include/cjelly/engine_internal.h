@@ -1,7 +1,15 @@
 #pragma once
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <vulkan/vulkan.h>
 #include <cjelly/cj_engine.h>
+#include <cjelly/cj_resources.h>
 #include <cjelly/runtime.h>
+#include <cjelly/worker_pool_internal.h>
+#include <cjelly/gpu_alloc_internal.h>
+#include <cjelly/upload_internal.h>
+#include <cjelly/pipeline_cache_internal.h>
+#include <cjelly/asset_internal.h>
 
 /* Internal engine API during migration */
 
@@ -20,13 +28,142 @@ CJ_API VkDevice cj_engine_device(const cj_engine_t*);
 CJ_API VkQueue cj_engine_graphics_queue(const cj_engine_t*);
 CJ_API VkQueue cj_engine_present_queue(const cj_engine_t*);
 CJ_API VkRenderPass cj_engine_render_pass(const cj_engine_t*);
+/* Render pass compatible with cj_engine_render_pass over an image that was presented
+ * before: it clears only the render area and keeps the rest. VK_NULL_HANDLE for an
+ * imported legacy context */
+CJ_API VkRenderPass cj_engine_partial_render_pass(const cj_engine_t*);
+/* VK_KHR_incremental_present is enabled, so presents may chain VkPresentRegionsKHR */
+CJ_API bool cj_engine_incremental_present(const cj_engine_t*);
+/* VK_GOOGLE_display_timing is enabled: swapchains report refresh duration and present times */
+CJ_API bool cj_engine_display_timing(const cj_engine_t*);
 CJ_API VkCommandPool cj_engine_command_pool(const cj_engine_t*);
-/* Ensure render pass in engine matches specified color format */
+/* Queue family of the graphics (and present) queue */
+CJ_API uint32_t cj_engine_graphics_family(const cj_engine_t*);
+/* Queue for async compute and its family. Without a compute family apart from graphics, or
+ * without timeline semaphores, this is the graphics queue and cj_engine_async_compute() is false */
+CJ_API VkQueue cj_engine_compute_queue(const cj_engine_t*);
+CJ_API uint32_t cj_engine_compute_family(const cj_engine_t*);
+CJ_API bool cj_engine_async_compute(const cj_engine_t*);
+/* VK_KHR_timeline_semaphore is enabled */
+CJ_API bool cj_engine_timeline_semaphores(const cj_engine_t*);
+/* Block until a timeline semaphore reaches value; false without timeline semaphores or on failure */
+CJ_API bool cj_engine_wait_timeline(const cj_engine_t*, VkSemaphore semaphore, uint64_t value);
+/* multiDrawIndirect and drawIndirectFirstInstance are enabled */
+CJ_API bool cj_engine_indirect_draws(const cj_engine_t*);
+/* vkCmdDrawIndexedIndirectCountKHR of VK_KHR_draw_indirect_count; NULL without the extension */
+CJ_API PFN_vkCmdDrawIndexedIndirectCountKHR cj_engine_draw_indexed_indirect_count(const cj_engine_t*);
+/* cj_engine_desc_t.flags the engine was created with */
+CJ_API uint32_t cj_engine_flags(const cj_engine_t*);
+/* Worker threads started for CJ_ENGINE_ENABLE_THREADING; NULL when rendering serially */
+CJ_API cj_worker_pool_t* cj_engine_workers(const cj_engine_t*);
+/* The same threads for background jobs, started on first use without CJ_ENGINE_ENABLE_THREADING;
+ * NULL when they could not be started */
+CJ_API cj_worker_pool_t* cj_engine_job_workers(cj_engine_t*);
+/* Device memory allocator every engine-owned buffer and image draws from */
+CJ_API cj_gpu_allocator_t* cj_engine_gpu_allocator(const cj_engine_t*);
+/* Upload queue for texel data; flushed before every frame submission */
+CJ_API cj_upload_queue_t* cj_engine_uploads(const cj_engine_t*);
+/* Persistent pipeline cache and shared pipelines */
+CJ_API cj_pipeline_cache_t* cj_engine_pipelines(const cj_engine_t*);
+/* Asset cache behind cj_asset.h, created on first use; NULL when out of memory */
+CJ_API cj_asset_cache_t* cj_engine_asset_cache(cj_engine_t*);
+/* Install shader reload rebuilds that finished (CJ_ENGINE_ENABLE_SHADER_RELOAD). Call
+ * between frames on the main thread, before preparing graphs; true when pipelines got
+ * replacements, so windows should redraw. The replaced pipelines retire through the
+ * deletion queue */
+CJ_API bool cj_engine_poll_shader_reload(cj_engine_t*);
+/* VkPipelineCache every pipeline creation should pass */
+CJ_API VkPipelineCache cj_engine_pipeline_cache(const cj_engine_t*);
+/* Color attachment format of the engine render pass */
+CJ_API VkFormat cj_engine_color_format(const cj_engine_t*);
+/* Create the window passes for a swapchain format (see cj_engine_window_render_pass) */
 CJ_API int cj_engine_ensure_render_pass(cj_engine_t* e, VkFormat fmt);
 
+/* Single color attachment render pass; zero unused fields, keys are compared bytewise */
+typedef struct cj_render_pass_key_t {
+  VkFormat format;
+  VkSampleCountFlagBits samples;   /* 0 = VK_SAMPLE_COUNT_1_BIT */
+  VkAttachmentLoadOp load_op;
+  VkAttachmentStoreOp store_op;
+  VkImageLayout initial_layout;
+  VkImageLayout final_layout;
+} cj_render_pass_key_t;
+/* Shared render pass for key, created on first use and kept until shutdown, so
+ * pipelines and framebuffers built against it never go stale. Main thread only */
+CJ_API VkRenderPass cj_engine_get_render_pass(cj_engine_t*, const cj_render_pass_key_t* key);
+/* Pass windows with swapchain format fmt render into: cj_engine_render_pass (or, if
+ * partial, cj_engine_partial_render_pass) for the engine format, otherwise a cached pass
+ * compatible with pipeline variants for fmt. Main thread only */
+CJ_API VkRenderPass cj_engine_window_render_pass(cj_engine_t*, VkFormat fmt, bool partial);
+
+/* Per-frame memory. cj_engine_start_frame_memory() begins a frame: it resets the
+ * frame arena (creating it the first time) and starts counting the frame path's
+ * heap allocations on the calling thread; cj_engine_end_frame_memory() stops and
+ * records them. With CJ_ENGINE_ENABLE_DIAGNOSTICS, frames that still allocate once
+ * CJ_ENGINE_FRAME_WARMUP frames ran are reported. Main thread only. */
+#define CJ_ENGINE_FRAME_WARMUP 120u
+CJ_API void        cj_engine_start_frame_memory(cj_engine_t* e);
+CJ_API void        cj_engine_end_frame_memory(cj_engine_t* e);
+CJ_API cj_arena_t* cj_engine_frame_arena(const cj_engine_t* e);
+
+/* Batched submissions: one vkQueueSubmit covering several windows, completing at a
+ * serial of the engine timeline or, without timeline semaphores, with a ring fence.
+ * Submit and begin on the main thread only; done/wait may be called from worker
+ * threads as long as no batch is being submitted concurrently. Serials start at 1,
+ * 0 = none. cj_engine_submit_batch returns 0 when the submission failed. */
+#define CJ_ENGINE_BATCH_FENCES 8u
+CJ_API uint64_t cj_engine_submit_batch(cj_engine_t* e, uint32_t count, const VkSubmitInfo* submits);
+CJ_API VkFence cj_engine_begin_batch(cj_engine_t* e, uint64_t* out_serial);
+CJ_API bool    cj_engine_batch_done(const cj_engine_t* e, uint64_t serial);
+CJ_API void    cj_engine_wait_batch(const cj_engine_t* e, uint64_t serial);
+
 /* Shared bindless descriptor objects (engine-owned) */
 CJ_API VkDescriptorSetLayout cj_engine_bindless_layout(const cj_engine_t*);
 CJ_API VkDescriptorPool      cj_engine_bindless_pool(const cj_engine_t*);
+/* Texture table: every sampled texture as a combined image sampler at element
+ * cj_texture_descriptor_slot() of binding 0, visible to the fragment stage.
+ * Update-after-bind and partially bound; shaders may index it per draw or, with
+ * nonuniformEXT, per instance. VK_NULL_HANDLE when the device lacks
+ * descriptor indexing or the engine imported a legacy context. */
+CJ_API VkDescriptorSetLayout cj_engine_texture_table_layout(const cj_engine_t*);
+CJ_API VkDescriptorSet       cj_engine_texture_table(const cj_engine_t*);
+
+/* Quads shared by render graph nodes, packed into one device-local vertex buffer */
+typedef enum cj_engine_quad_t {
+  CJ_ENGINE_QUAD_TEXTURED = 0, /* 6 vertices of { vec2 pos; vec2 uv; } covering [-0.5, 0.5] */
+  CJ_ENGINE_QUAD_COLOR,        /* 6 vertices of { vec2 pos; vec3 color; uint32_t texture_id; } */
+  CJ_ENGINE_QUAD_COUNT
+} cj_engine_quad_t;
+/* Buffer holding a shared quad and its byte offset; uploaded on first use. VK_NULL_HANDLE on failure */
+CJ_API VkBuffer cj_engine_shared_quad(cj_engine_t* e, cj_engine_quad_t quad, VkDeviceSize* out_offset);
+
+/* Descriptor sets for render graph nodes: one combined image sampler at binding 0 read by
+ * the fragment stage. Sets come from engine-owned pools that grow on demand, so sets are
+ * freed with the pool they came from. */
+CJ_API VkDescriptorSetLayout cj_engine_node_set_layout(cj_engine_t* e);
+CJ_API VkDescriptorSet cj_engine_alloc_node_set(cj_engine_t* e, VkDescriptorPool* out_pool);
+CJ_API void cj_engine_free_node_set(cj_engine_t* e, VkDescriptorPool pool, VkDescriptorSet set);
+
+/* Objects frames in flight may still use. cj_engine_retire() queues them for deletion;
+ * cj_engine_collect_garbage() destroys them once every batch submitted before finished.
+ * Unset members are skipped, alloc is taken over and set is freed to set_pool (a node
+ * set pool). Engine thread only. */
+typedef struct cj_engine_garbage_t {
+  VkFramebuffer framebuffer;
+  VkImageView view;
+  VkImage image;
+  VkBuffer buffer;
+  cj_gpu_alloc_t alloc;
+  VkDeviceMemory memory;           /* Raw allocation the image was bound to */
+  VkDescriptorPool set_pool;
+  VkDescriptorSet set;
+  VkDescriptorPool pool;           /* Owned pool, destroyed with the sets it holds */
+} cj_engine_garbage_t;
+CJ_API void cj_engine_retire(cj_engine_t* e, const cj_engine_garbage_t* garbage);
+
+/* Layout of the per-frame uniform sets of render graphs: one dynamic uniform buffer at
+ * binding 0 read by the vertex and fragment stages. Created on first use. */
+CJ_API VkDescriptorSetLayout cj_engine_uniform_set_layout(cj_engine_t* e);
 
 /* Color pipeline state (engine-owned) */
 CJ_API CJellyBindlessResources* cj_engine_color_pipeline(const cj_engine_t*);
@@ -43,44 +180,130 @@ CJ_API struct CJellyBindlessState* cj_engine_bindless(const cj_engine_t*);
 struct CJellyBasicState;
 CJ_API struct CJellyBasicState* cj_engine_basic(const cj_engine_t*);
 
-/* === Internal resource tables for Phase 3 === */
-typedef struct cj_res_entry_t {
-  uint32_t generation;
-  uint32_t refcount;
-  uint32_t slot;      /* descriptor slot when applicable */
-  uint8_t  in_use;
+/* === Internal resource tables ===
+ * One table per resource kind. Entries live in fixed-size pages added as the
+ * table grows; pages never move, so lookups take no lock. Each entry is split:
+ * the hot half is everything handle validation reads (8 bytes, so a check
+ * touches one cache line), the cold half holds the Vulkan objects. Free entries
+ * form a LIFO list threaded through the cold halves, making alloc and release O(1).
+ * Retain and release are atomic and may be called from any thread; the release
+ * dropping the last reference only pushes the entry on a lock-free pending list,
+ * which the engine thread drains once per frame to queue the Vulkan objects for
+ * deletion. Alloc stays on the thread using the engine. */
+#define CJ_RES_PAGE_SHIFT 8u
+#define CJ_RES_PAGE_SIZE  (1u << CJ_RES_PAGE_SHIFT)
+#define CJ_RES_MAX_PAGES  256u  /* Up to 65535 live entries per kind; index 0 stays null */
+
+/* Textures are published at their index in the texture table while it is
+ * below this; later ones are only reachable through their own descriptors */
+#define CJ_ENGINE_TEXTURE_TABLE_SIZE 1024u
+
+/* Generation and refcount share one word so a retain can never revive an entry
+ * freed and reused between checking the generation and counting the reference */
+typedef struct cj_res_hot_t {
+  _Atomic uint64_t state;  /* generation << 32 | refcount; the generation is bumped
+                              when the count drops to 0 (= free) and is never 0 */
+} cj_res_hot_t;
+
+/* Streamed textures keep the levels of at most this many texels a side unless told otherwise */
+#define CJ_ENGINE_STREAM_RESIDENT_SIZE 64u
+
+/* Streaming state of a texture created with cj_texture_desc_t.stream. The resident image holds
+ * levels base..levels-1 of the full chain; a replacement with other levels is filled off to the
+ * side and swapped in once its uploads finished. */
+typedef struct cj_tex_stream_t {
+  cj_texture_stream_t source;
+  VkExtent2D extent;           /* Size of level 0 of the full chain */
+  uint32_t levels;             /* Levels of the full chain */
+  uint32_t base;               /* Level of the full chain that is mip 0 of the resident image */
+  uint32_t floor;              /* Base of the always-resident levels, which eviction returns to */
+  uint32_t wanted;             /* Lowest base requested since the last update, UINT32_MAX = none */
+  uint64_t last_request;       /* Streaming update of the last request, for LRU eviction */
+  VkImageCreateInfo image_info;/* Resident image parameters; extent and levels follow base */
+  VkImage next_image;          /* Replacement being filled, VK_NULL_HANDLE = none */
+  VkImageView next_view;
+  cj_gpu_alloc_t next_alloc;
+  uint32_t next_base;
+  uint64_t next_ticket;        /* Upload ticket of the replacement's levels */
+  uint32_t next_waits;         /* Updates the swap has waited for frames in flight */
+} cj_tex_stream_t;
+
+/* What makes two samplers interchangeable: cj_sampler_desc_t without the debug name */
+typedef struct cj_sampler_key_t {
+  uint8_t min_filter, mag_filter;
+  uint8_t address_u, address_v, address_w;
+  uint8_t reserved[3];  /* Zero, so keys compare bytewise */
+  float mip_lod_bias;
+  float max_anisotropy;
+} cj_sampler_key_t;
+
+typedef struct cj_res_cold_t {
+  uint32_t next_free;     /* Next free entry while on the free list, 0 = end */
+  uint32_t pending_next;  /* Next entry on the pending list, written by the releasing thread */
 
   /* Actual Vulkan objects (union based on resource type) */
   union {
     struct {
       VkImage image;
-      VkDeviceMemory memory;
+      cj_gpu_alloc_t alloc;
       VkImageView imageView;
-      VkSampler sampler;
+      VkSampler sampler;           /* Borrowed from the shared sampler below */
+      uint64_t sampler_handle;     /* Reference on the shared sampler, 0 = none */
+      VkExtent2D extent;
+      uint32_t mips, layers;
+      uint32_t texel_size;         /* Bytes per block (per texel when uncompressed) */
+      uint32_t block_width, block_height;
+      bool generate_mips;          /* Uploads to mip 0 regenerate the other levels */
+      VkFilter mip_filter;         /* Blit filter for generated levels */
+      cj_tex_stream_t* stream;     /* Streaming state, NULL unless streamed */
+      VkImageLayout layout;        /* Layout after the last queued upload */
+      VkImageLayout ready_layout;  /* Layout uploads leave the image in */
     } texture;
     struct {
       VkBuffer buffer;
-      VkDeviceMemory memory;
+      cj_gpu_alloc_t alloc;
+      VkDeviceSize size;
     } buffer;
     struct {
       VkSampler sampler;
+      cj_sampler_key_t key;  /* Entry in the engine sampler cache */
     } sampler;
   } vulkan;
-} cj_res_entry_t;
+} cj_res_cold_t;
 
-#define CJ_ENGINE_MAX_TEXTURES 1024u
-#define CJ_ENGINE_MAX_BUFFERS  1024u
-#define CJ_ENGINE_MAX_SAMPLERS 256u
+typedef struct cj_res_table_t {
+  _Atomic(cj_res_hot_t*) hot[CJ_RES_MAX_PAGES];
+  cj_res_cold_t* cold[CJ_RES_MAX_PAGES];
+  uint32_t page_count;
+  uint32_t free_head[2];  /* First free entry below CJ_ENGINE_TEXTURE_TABLE_SIZE (handed out
+                             first, so the texture table fills up) and above it; 0 = none */
+  uint32_t live;          /* Entries in use */
+  _Atomic uint32_t pending_head;  /* Entries whose last reference was dropped, waiting for the
+                                     engine thread to queue their objects for deletion; 0 = none */
+} cj_res_table_t;
 
 typedef enum cj_res_kind_t { CJ_RES_TEX = 0, CJ_RES_BUF = 1, CJ_RES_SMP = 2 } cj_res_kind_t;
 
 /* Allocate a new entry, returning 64-bit handle (index|generation). Returns 0 on failure. */
-CJ_API uint64_t cj_engine_res_alloc(cj_engine_t* e, cj_res_kind_t kind, uint32_t* out_slot);
+CJ_API uint64_t cj_engine_res_alloc(cj_engine_t* e, cj_res_kind_t kind, uint32_t* out_index);
 /* Retain existing handle (no-op if invalid) */
 CJ_API void     cj_engine_res_retain(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle);
-/* Release existing handle (no-op if invalid) */
-CJ_API void     cj_engine_res_release(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle);
-/* Query descriptor slot for a handle; returns 0 if invalid. */
+/* Release existing handle (no-op if invalid); any thread. The last release invalidates
+ * the handle and hands the entry to the engine thread without waiting; returns true when
+ * that happened. The next frame (or cj_engine_collect_garbage()) queues it for deletion,
+ * and cj_engine_collect_garbage() destroys its Vulkan objects and returns it to the free
+ * list once the GPU finished every submission made before that. */
+CJ_API bool     cj_engine_res_release(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle);
+/* Shared samplers: descriptors equal apart from the debug name share one entry,
+ * so a device only ever holds one VkSampler per distinct state. Returns a new
+ * reference (release it with cj_engine_res_release) and writes the VkSampler,
+ * or returns 0 on failure. Engine thread only. */
+CJ_API uint64_t cj_engine_acquire_sampler(cj_engine_t* e, const cj_sampler_desc_t* desc, VkSampler* out_sampler);
+/* Table index of a live handle; returns 0 if invalid. */
+CJ_API uint32_t cj_engine_res_index(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle);
+/* VkBuffer of a live buffer entry (by table index); VK_NULL_HANDLE otherwise */
+CJ_API VkBuffer cj_engine_buffer(cj_engine_t* e, uint32_t index);
+/* Query descriptor slot for a handle; returns 0 if invalid (or, for textures, not in the table). */
 CJ_API uint32_t cj_engine_res_slot(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle);
 
 
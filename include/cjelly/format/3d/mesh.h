@@ -0,0 +1,123 @@
+#ifndef CJELLY_FORMAT_3D_MESH_H
+#define CJELLY_FORMAT_3D_MESH_H
+
+#include <stdint.h>
+#include <cjelly/macros.h>
+#include <cjelly/format/3d/obj.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @file mesh.h
+ * @brief Conversion of OBJ models into GPU-ready indexed triangle meshes.
+ *
+ * An OBJ face indexes positions, texture coordinates and normals separately.
+ * A GPU vertex is one combination of the three, so every distinct
+ * (position, texcoord, normal) triple becomes one interleaved vertex, and the
+ * faces become a single index buffer of triangles grouped by material.
+ */
+
+/**
+ * @brief Enumeration of error codes for the mesh builder.
+ */
+typedef enum {
+  CJELLY_FORMAT_3D_MESH_SUCCESS = 0,          /**< No error */
+  CJELLY_FORMAT_3D_MESH_ERR_OUT_OF_MEMORY,    /**< Memory allocation failure */
+  CJELLY_FORMAT_3D_MESH_ERR_INVALID_MODEL,    /**< A face refers to an element the model does not have */
+  CJELLY_FORMAT_3D_MESH_ERR_TOO_LARGE         /**< The mesh needs more than 2^32 indices */
+} CJellyFormat3dMeshError;
+
+/**
+ * @brief Options for cjelly_format_3d_mesh_from_obj().
+ */
+typedef enum {
+  /**
+   * Reorder the triangles of each range for the post-transform vertex cache
+   * (Forsyth's linear-speed algorithm), then renumber the vertices in the
+   * order they are first used so vertex fetches walk memory forwards.
+   */
+  CJELLY_FORMAT_3D_MESH_OPTIMIZE = 1u << 0,
+  /** Emit 32-bit indices even when 16 bits would do. */
+  CJELLY_FORMAT_3D_MESH_32BIT_INDICES = 1u << 1,
+} CJellyFormat3dMeshFlags;
+
+/**
+ * @brief An interleaved vertex, 32 bytes.
+ */
+struct CJellyFormat3dMeshVertex {
+  float position[3]; /**< Object-space position */
+  float normal[3];   /**< Normal, from the model or generated */
+  float texcoord[2]; /**< Texture coordinate, with v = 0 at the top of the image */
+};
+
+/**
+ * @brief A run of triangles that share a material.
+ */
+struct CJellyFormat3dMeshRange {
+  uint32_t first_index;  /**< Index of the first index of the range */
+  uint32_t index_count;  /**< Number of indices (three per triangle) */
+  int material_index;    /**< Material index from the OBJ model, or -1 if none */
+};
+
+/**
+ * @brief An indexed triangle mesh.
+ *
+ * The ranges are sorted by material index and cover the whole index buffer.
+ */
+struct CJellyFormat3dMesh {
+  CJellyFormat3dMeshVertex * vertices; /**< Array of vertices */
+  uint32_t vertex_count;               /**< Number of vertices */
+
+  void * indices;                      /**< uint16_t or uint32_t indices, see index_size */
+  uint32_t index_count;                /**< Number of indices */
+  uint32_t index_size;                 /**< Size of one index in bytes: 2 or 4 */
+
+  CJellyFormat3dMeshRange * ranges;    /**< Array of material ranges */
+  uint32_t range_count;                /**< Number of material ranges */
+
+  float bounds_min[3];                 /**< Smallest coordinates of any vertex */
+  float bounds_max[3];                 /**< Largest coordinates of any vertex */
+};
+
+/**
+ * @brief Builds an indexed triangle mesh from an OBJ model.
+ *
+ * Identical (position, texcoord, normal) corners are merged into one vertex.
+ * Faces with more than three corners are triangulated as fans, which is
+ * correct for the convex polygons that exporters write; faces with fewer
+ * than three corners are skipped.  Corners without a texture coordinate get
+ * (0, 0).  Corners without a normal get the area-weighted average of the
+ * normals of the faces that share their position.  Indices are 16-bit when
+ * every vertex fits, unless CJELLY_FORMAT_3D_MESH_32BIT_INDICES is given.
+ *
+ * @param model The OBJ model.
+ * @param flags Bitwise OR of CJellyFormat3dMeshFlags.
+ * @param outMesh Output pointer that will point to the allocated mesh on success.
+ * @return CJellyFormat3dMeshError Error code indicating success or the type of failure.
+ */
+CJellyFormat3dMeshError cjelly_format_3d_mesh_from_obj(const CJellyFormat3dObjModel * model,
+    unsigned flags, CJellyFormat3dMesh * * outMesh);
+
+/**
+ * @brief Frees a mesh returned by cjelly_format_3d_mesh_from_obj().
+ *
+ * @param mesh The mesh to free.
+ */
+void cjelly_format_3d_mesh_free(CJellyFormat3dMesh * mesh);
+
+/**
+ * @brief Converts a mesh error code to a human-readable error message.
+ *
+ * @param err The CJellyFormat3dMeshError code.
+ * @return A constant string describing the error.
+ */
+const char * cjelly_format_3d_mesh_strerror(CJellyFormat3dMeshError err);
+
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // CJELLY_FORMAT_3D_MESH_H
@@ -0,0 +1,116 @@
+#ifndef CJELLY_FORMAT_3D_MESH_CACHE_H
+#define CJELLY_FORMAT_3D_MESH_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <cjelly/macros.h>
+#include <cjelly/format/file.h>
+#include <cjelly/format/3d/mesh.h>
+#include <cjelly/format/3d/mtl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @file mesh_cache.h
+ * @brief Binary cache of built meshes, used as a fast path for OBJ/MTL files.
+ *
+ * A cache file holds everything cjelly_format_3d_mesh_from_obj() produces
+ * for a model, plus the MTL parameters of every material the model uses, in
+ * a versioned little-endian container.  Its sections have the layout of the
+ * in-memory structures, so a cache hit maps the file and points the mesh
+ * straight at it: there is nothing to parse, and cj_mesh_upload() copies the
+ * vertices and indices from the mapping into staging memory.
+ *
+ * The cache is keyed on the modification time and size of the OBJ file and
+ * its MTL library.  When a time differs, the file's contents are hashed and
+ * compared with the hash in the cache, so touching a file does not force a
+ * rebuild.  On big-endian hosts the cache is never used.
+ */
+
+/**
+ * @brief Version of the cache format; files of other versions are rebuilt.
+ */
+#define CJELLY_FORMAT_3D_MESH_CACHE_VERSION 1
+
+/**
+ * @brief Enumeration of error codes for the mesh cache.
+ */
+typedef enum {
+  CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS = 0,        /**< No error */
+  CJELLY_FORMAT_3D_MESH_CACHE_ERR_FILE_NOT_FOUND, /**< Unable to open the file */
+  CJELLY_FORMAT_3D_MESH_CACHE_ERR_OUT_OF_MEMORY,  /**< Memory allocation failure */
+  CJELLY_FORMAT_3D_MESH_CACHE_ERR_INVALID_FORMAT, /**< Not a cache file, another version, or corrupt */
+  CJELLY_FORMAT_3D_MESH_CACHE_ERR_SOURCE,         /**< The OBJ file could not be loaded or built */
+  CJELLY_FORMAT_3D_MESH_CACHE_ERR_IO,             /**< I/O error while reading or writing a file */
+  CJELLY_FORMAT_3D_MESH_CACHE_ERR_UNSUPPORTED     /**< The host is big-endian */
+} CJellyFormat3dMeshCacheError;
+
+/**
+ * @brief A mesh and its materials, loaded from a cache file or built from an OBJ file.
+ *
+ * Use the public fields only; the arrays may point into a read-only mapping.
+ */
+struct CJellyFormat3dMeshAsset {
+  CJellyFormat3dMesh mesh;               /**< The mesh */
+  const CJellyFormat3dMtlMaterial * materials; /**< One per material index of the mesh ranges */
+  uint32_t material_count;               /**< Number of materials */
+  bool from_cache;                       /**< Whether the asset came from a cache file */
+
+  CJellyFormatFileMapping mapping;       /**< Cache file mapping, if from_cache */
+  CJellyFormat3dMesh * built_mesh;       /**< Heap mesh, if built from the OBJ file */
+  CJellyFormat3dMtlMaterial * built_materials; /**< Heap materials, if built from the OBJ file */
+};
+
+/**
+ * @brief Loads a mesh through the cache, building it from the OBJ file on a miss.
+ *
+ * On a hit, the cache file is mapped and used in place.  On a miss, the OBJ
+ * file and its MTL library are parsed, the mesh is built with `flags`, and
+ * the cache file is rewritten for next time; failing to write it is not an
+ * error.  A cache built with different flags is a miss.
+ *
+ * Materials the MTL library does not define, or all of them when the model
+ * has no library, get a white default (Kd = 1, d = 1, illum = 1).
+ *
+ * @param obj_path Path to the OBJ file.
+ * @param cache_path Path to the cache file, or NULL for obj_path with ".cjmesh" appended.
+ * @param flags Bitwise OR of CJellyFormat3dMeshFlags.
+ * @param outAsset Output pointer that will point to the allocated asset on success.
+ * @return CJellyFormat3dMeshCacheError Error code indicating success or the type of failure.
+ */
+CJellyFormat3dMeshCacheError cjelly_format_3d_mesh_cache_load(const char * obj_path,
+    const char * cache_path, unsigned flags, CJellyFormat3dMeshAsset * * outAsset);
+
+/**
+ * @brief Maps and validates a cache file without checking its source files.
+ *
+ * @param cache_path Path to the cache file.
+ * @param outAsset Output pointer that will point to the allocated asset on success.
+ * @return CJellyFormat3dMeshCacheError Error code indicating success or the type of failure.
+ */
+CJellyFormat3dMeshCacheError cjelly_format_3d_mesh_cache_open(const char * cache_path,
+    CJellyFormat3dMeshAsset * * outAsset);
+
+/**
+ * @brief Frees an asset and releases its mapping.
+ *
+ * @param asset The asset to free.
+ */
+void cjelly_format_3d_mesh_asset_free(CJellyFormat3dMeshAsset * asset);
+
+/**
+ * @brief Converts a mesh cache error code to a human-readable error message.
+ *
+ * @param err The CJellyFormat3dMeshCacheError code.
+ * @return A constant string describing the error.
+ */
+const char * cjelly_format_3d_mesh_cache_strerror(CJellyFormat3dMeshCacheError err);
+
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // CJELLY_FORMAT_3D_MESH_CACHE_H
@@ -1,6 +1,7 @@
 #ifndef CJELLY_FORMAT_3D_OBJ_H
 #define CJELLY_FORMAT_3D_OBJ_H
 
+#include <stdio.h>
 #include <cjelly/macros.h>
 
 #ifdef __cplusplus
@@ -148,6 +149,12 @@ struct CJellyFormat3dObjModel {
  * CJellyFormat3dObjModel structure with vertices, texture coordinates, normals, faces,
  * and groups. The parsed model is returned via the outModel output parameter.
  *
+ * The file is memory-mapped and parsed in place.  Files of a few megabytes or
+ * more are split into newline-aligned chunks that are parsed on worker threads
+ * and merged in file order, so the result is the same as a sequential parse.
+ * Face indices may be positive or negative (relative to the elements read so
+ * far); both are stored as 0-based indices.
+ *
  * @param filename Path to the OBJ file.
  * @param outModel Output pointer that will point to the allocated CJellyFormat3dObjModel on success.
  * @return CJellyFormat3dObjError Error code indicating success or the type of failure.
@@ -0,0 +1,75 @@
+#ifndef CJELLY_FORMAT_FILE_H
+#define CJELLY_FORMAT_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <cjelly/macros.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @file file.h
+ * @brief Read-only file mappings shared by the CJelly format loaders.
+ *
+ * Loaders parse the mapped bytes in place, so reading a file costs a handful
+ * of system calls instead of one per line or row.
+ */
+
+/**
+ * @brief Enumeration of error codes for file mappings.
+ */
+typedef enum {
+  CJELLY_FORMAT_FILE_SUCCESS = 0,     /**< No error */
+  CJELLY_FORMAT_FILE_ERR_NOT_FOUND,   /**< Unable to open the file */
+  CJELLY_FORMAT_FILE_ERR_EMPTY,       /**< The file is empty, so there is nothing to map */
+  CJELLY_FORMAT_FILE_ERR_TOO_LARGE,   /**< The file does not fit in the address space */
+  CJELLY_FORMAT_FILE_ERR_IO           /**< The file could not be mapped */
+} CJellyFormatFileError;
+
+/**
+ * @brief A read-only memory mapping of a file.
+ */
+typedef struct CJellyFormatFileMapping {
+  const unsigned char * data; /**< The file contents. */
+  size_t size;                /**< The file size in bytes. */
+  void * handle;              /**< Platform mapping object, if any. */
+} CJellyFormatFileMapping;
+
+/**
+ * @brief Maps a file into memory for reading.
+ *
+ * The contents are not NUL-terminated; parsers must stop at data + size.
+ *
+ * @param filename Path to the file.
+ * @param out_mapping Receives the mapping; release it with cjelly_format_file_unmap().
+ *        It is zeroed on failure.
+ * @return CJELLY_FORMAT_FILE_SUCCESS on success, or an error code on failure.
+ */
+CJellyFormatFileError cjelly_format_file_map(const char * filename, CJellyFormatFileMapping * out_mapping);
+
+/**
+ * @brief Releases a mapping made by cjelly_format_file_map().
+ *
+ * @param mapping The mapping to release; it is zeroed.
+ */
+void cjelly_format_file_unmap(CJellyFormatFileMapping * mapping);
+
+/**
+ * @brief Reads the modification time and size of a file without opening it.
+ *
+ * @param filename Path to the file.
+ * @param out_mtime Optional; receives the modification time in nanoseconds
+ *        since the epoch (whole seconds on Windows).
+ * @param out_size Optional; receives the size in bytes.
+ * @return CJELLY_FORMAT_FILE_SUCCESS, or CJELLY_FORMAT_FILE_ERR_NOT_FOUND if
+ *         the file does not exist; the outputs are then zeroed.
+ */
+CJellyFormatFileError cjelly_format_file_stat(const char * filename, int64_t * out_mtime, uint64_t * out_size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif // CJELLY_FORMAT_FILE_H
@@ -2,6 +2,7 @@
 #define CJELLY_FORMAT_IMAGE_H
 
 #include <cjelly/macros.h>
+#include <cjelly/format/file.h>
 
 
 #ifdef __cplusplus
@@ -30,6 +31,7 @@ typedef enum {
 typedef enum {
   CJELLY_FORMAT_IMAGE_UNKNOWN, /**< Unknown image format */
   CJELLY_FORMAT_IMAGE_BMP,     /**< BMP image format */
+  CJELLY_FORMAT_IMAGE_KTX2,    /**< KTX2 texture container (GPU formats; see ktx2.h) */
 } CJellyFormatImageType;
 
 /**
@@ -59,6 +61,51 @@ typedef struct CJellyFormatImage {
   CJellyFormatImageType type; /**< Image format type. */
 } CJellyFormatImage;
 
+/**
+ * @brief A read-only memory mapping of an image file.
+ */
+typedef CJellyFormatFileMapping CJellyFormatImageMapping;
+
+/**
+ * @brief Maps an image file into memory for reading.
+ *
+ * Decoders read the mapping in place, so loading a file costs a handful of
+ * system calls instead of one read per row.
+ *
+ * @param filename Path to the image file.
+ * @param out_mapping Receives the mapping; release it with cjelly_format_image_unmap().
+ * @return CJELLY_FORMAT_IMAGE_SUCCESS on success, CJELLY_FORMAT_IMAGE_ERR_FILE_NOT_FOUND
+ *         if the file cannot be opened, CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT if it
+ *         is empty, or CJELLY_FORMAT_IMAGE_ERR_IO if it cannot be mapped.
+ */
+CJellyFormatImageError cjelly_format_image_map(const char * filename, CJellyFormatImageMapping * out_mapping);
+
+/**
+ * @brief Releases a mapping made by cjelly_format_image_map().
+ *
+ * @param mapping The mapping to release; it is zeroed.
+ */
+void cjelly_format_image_unmap(CJellyFormatImageMapping * mapping);
+
+/**
+ * @brief Caller-provided memory for decoding an image straight to RGBA8.
+ *
+ * Loaders call acquire() once, after parsing the header and before reading
+ * any pixels, so that the pixels are decoded directly into their final
+ * location (such as mapped staging memory) instead of into an intermediate
+ * allocation.  Rows are written top-down.
+ */
+typedef struct CJellyFormatImageTarget {
+  /**
+   * Returns memory for height rows of width RGBA8 pixels and stores the bytes
+   * between rows (at least width * 4) in *stride, or returns NULL to abort the
+   * load.  Loaders may read back what they wrote, but the memory may be
+   * write-combined, so they avoid doing so.
+   */
+  unsigned char * (*acquire)(void * user, int width, int height, size_t * stride);
+  void * user;  /**< Passed to acquire(). */
+} CJellyFormatImageTarget;
+
 /**
  * @brief Loads an image from file.
  *
@@ -71,6 +118,22 @@ typedef struct CJellyFormatImage {
  */
 CJellyFormatImageError cjelly_format_image_load(const char * filename, CJellyFormatImage * * out_image);
 
+/**
+ * @brief Loads an image from file and decodes it to RGBA8 in caller memory.
+ *
+ * Like cjelly_format_image_load(), but without allocating the pixel data:
+ * the pixels are written to the memory returned by target->acquire().
+ *
+ * @param filename Path to the image file.
+ * @param target Where to decode the pixels.
+ * @param out_width Optional; receives the width in pixels.
+ * @param out_height Optional; receives the height in pixels.
+ * @return CJELLY_FORMAT_IMAGE_SUCCESS on success, or an error code on failure.
+ *         CJELLY_FORMAT_IMAGE_ERR_OUT_OF_MEMORY if acquire() returned NULL.
+ */
+CJellyFormatImageError cjelly_format_image_load_rgba(const char * filename,
+    const CJellyFormatImageTarget * target, int * out_width, int * out_height);
+
 /**
  * @brief Deallocates the memory used by an image.  The image pointer will be
  * set to NULL.
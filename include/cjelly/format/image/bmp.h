@@ -3,6 +3,7 @@
 
 #include <cjelly/macros.h>
 #include <cjelly/format/image.h>
+#include <cjelly/format/image/convert.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,12 +25,73 @@ typedef struct CJellyFormatImageBMP {
     // BMP-specific fields can be added here if needed.
 } CJellyFormatImageBMP;
 
+/**
+ * @brief Parsed layout of a BMP image held in memory.
+ *
+ * Produced by cjelly_format_image_bmp_parse().  The pointers refer into the
+ * span that was parsed, which must outlive the structure.
+ */
+typedef struct CJellyFormatImageBMPInfo {
+  int width;                       /**< Width in pixels. */
+  int height;                      /**< Height in pixels. */
+  bool top_down;                   /**< Rows are stored top row first. */
+  unsigned int bits_per_pixel;     /**< 1, 4, 8, 16, 24 or 32. */
+  unsigned int compression;        /**< 0 (none), 1 (RLE8), 2 (RLE4) or 3 (bit fields). */
+  CJellyFormatImagePixel layout;   /**< Source layout of true-color pixels. */
+  const unsigned char * palette;   /**< Blue, green, red, reserved entries, or NULL for true color. */
+  unsigned int palette_size;       /**< Number of palette entries. */
+  const unsigned char * pixels;    /**< Start of the pixel data. */
+  size_t pixels_size;              /**< Bytes from pixels to the end of the span. */
+  size_t row_size;                 /**< Bytes per stored row; 0 for RLE data. */
+} CJellyFormatImageBMPInfo;
+
+/**
+ * @brief Parses the headers of a BMP image held in memory.
+ *
+ * Nothing is copied or allocated; the span is typically a file mapping from
+ * cjelly_format_image_map() or an embedded resource.  All offsets are
+ * checked against the span, so cjelly_format_image_bmp_decode() cannot read
+ * past its end.
+ *
+ * @param data The encoded BMP file.
+ * @param size Size of the span in bytes.
+ * @param out_info Receives the parsed layout.
+ * @return CJELLY_FORMAT_IMAGE_SUCCESS on success, CJELLY_FORMAT_IMAGE_ERR_IO
+ *         if the span is truncated, or CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT.
+ */
+CJellyFormatImageError cjelly_format_image_bmp_parse(const void * data, size_t size, CJellyFormatImageBMPInfo * out_info);
+
+/**
+ * @brief Returns the pixels of a BMP that needs no decoding.
+ *
+ * A 32-bit, top-down bitmap already stores tightly packed BGRA8 rows, which
+ * can be uploaded as is to a VK_FORMAT_B8G8R8A8_UNORM texture.
+ *
+ * @param info A parsed BMP.
+ * @return width * height * 4 bytes of BGRA8 pixels within the parsed span, or
+ *         NULL if the bitmap has any other layout.
+ */
+const unsigned char * cjelly_format_image_bmp_bgra_pixels(const CJellyFormatImageBMPInfo * info);
+
+/**
+ * @brief Decodes a parsed BMP to top-down RGBA8 in a single pass.
+ *
+ * @param info A parsed BMP.
+ * @param dest Destination for info->height rows of info->width RGBA8 pixels.
+ * @param dest_stride Bytes between destination rows; at least width * 4.
+ * @return CJELLY_FORMAT_IMAGE_SUCCESS on success, or an error code if the
+ *         pixel data is corrupt or truncated.
+ */
+CJellyFormatImageError cjelly_format_image_bmp_decode(const CJellyFormatImageBMPInfo * info,
+    unsigned char * dest, size_t dest_stride);
+
 /**
  * @brief Loads a BMP image from a file.
  *
  * This function reads a BMP image from the specified file, parses the BMP header,
  * allocates the necessary memory for the raw image data, and populates a CJellyFormatImage.
- * This implementation currently supports only uncompressed 24-bit BMP images.
+ * Every supported layout (1/4/8-bit palette, RLE4, RLE8, 16, 24 and 32-bit) is
+ * decoded to top-down RGBA8, so the image always has 4 channels.
  *
  * @param filename The path to the BMP image file.
  * @param out_image Output pointer that will point to the allocated CJellyFormatImage on success.
@@ -38,6 +100,36 @@ typedef struct CJellyFormatImageBMP {
  */
 CJellyFormatImageError cjelly_format_image_bmp_load(const char * filename, CJellyFormatImage * * out_image);
 
+/**
+ * @brief Loads a BMP image from a file straight into caller memory as RGBA8.
+ *
+ * The file is memory-mapped and decoded in place, without reading it into
+ * an intermediate buffer.
+ *
+ * @param filename The path to the BMP image file.
+ * @param target Where to decode the pixels; see CJellyFormatImageTarget.
+ * @param out_width Optional; receives the width in pixels.
+ * @param out_height Optional; receives the height in pixels.
+ * @return CJellyFormatImageError CJELLY_FORMAT_IMAGE_SUCCESS on success,
+ *         or an appropriate error code on failure.
+ */
+CJellyFormatImageError cjelly_format_image_bmp_load_rgba(const char * filename,
+    const CJellyFormatImageTarget * target, int * out_width, int * out_height);
+
+/**
+ * @brief Decodes a BMP image held in memory straight into caller memory as RGBA8.
+ *
+ * @param data The encoded BMP file.
+ * @param size Size of the span in bytes.
+ * @param target Where to decode the pixels; see CJellyFormatImageTarget.
+ * @param out_width Optional; receives the width in pixels.
+ * @param out_height Optional; receives the height in pixels.
+ * @return CJellyFormatImageError CJELLY_FORMAT_IMAGE_SUCCESS on success,
+ *         or an appropriate error code on failure.
+ */
+CJellyFormatImageError cjelly_format_image_bmp_load_rgba_memory(const void * data, size_t size,
+    const CJellyFormatImageTarget * target, int * out_width, int * out_height);
+
 /**
  * @brief Frees a BMP image and all associated memory.
  */
@@ -0,0 +1,95 @@
+#ifndef CJELLY_FORMAT_IMAGE_CONVERT_H
+#define CJELLY_FORMAT_IMAGE_CONVERT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <cjelly/macros.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @file convert.h
+ * @brief Pixel format conversion to RGBA8 for the CJelly image loaders.
+ *
+ * Every conversion produces tightly packed R, G, B, A bytes, which is the
+ * layout of VK_FORMAT_R8G8B8A8_UNORM, so decoders can write straight into
+ * mapped staging memory.  The row kernels use SSE2, SSSE3 or AVX2 on x86 and
+ * NEON on ARM, picked once at runtime from what the CPU supports, and fall
+ * back to portable C elsewhere.  All backends produce identical bytes.
+ */
+
+/**
+ * @brief Source pixel layouts understood by the converter.
+ *
+ * Multi-byte layouts are little-endian, as they are stored in BMP files.
+ */
+typedef enum {
+  CJELLY_FORMAT_IMAGE_PIXEL_RGBA32,  /**< R, G, B, A bytes (copied as is). */
+  CJELLY_FORMAT_IMAGE_PIXEL_BGRA32,  /**< B, G, R, A bytes. */
+  CJELLY_FORMAT_IMAGE_PIXEL_RGB24,   /**< R, G, B bytes; alpha becomes 255. */
+  CJELLY_FORMAT_IMAGE_PIXEL_BGR24,   /**< B, G, R bytes; alpha becomes 255. */
+  CJELLY_FORMAT_IMAGE_PIXEL_RGB565,  /**< 16-bit, red in the top 5 bits; alpha becomes 255. */
+  CJELLY_FORMAT_IMAGE_PIXEL_RGB555,  /**< 16-bit, red in bits 10-14, top bit unused; alpha becomes 255. */
+  CJELLY_FORMAT_IMAGE_PIXEL_COUNT,   /**< Number of layouts; not a layout. */
+} CJellyFormatImagePixel;
+
+/**
+ * @brief Returns the size in bytes of one pixel of a source layout.
+ *
+ * @param layout The source layout.
+ * @return Bytes per pixel, or 0 for an invalid layout.
+ */
+size_t cjelly_format_image_pixel_size(CJellyFormatImagePixel layout);
+
+/**
+ * @brief Converts one row of pixels to RGBA8.
+ *
+ * @param layout Layout of the source pixels.
+ * @param src Source pixels; no alignment is required.
+ * @param dst Destination for width * 4 bytes; must not overlap src.
+ * @param width Number of pixels in the row.
+ */
+void cjelly_format_image_convert_row(CJellyFormatImagePixel layout,
+    const unsigned char * src, unsigned char * dst, size_t width);
+
+/**
+ * @brief Converts a block of rows to RGBA8, optionally flipping it vertically.
+ *
+ * Rows are read from src at src_stride byte intervals and written to dst at
+ * dst_stride byte intervals.  When flip is true, the first source row is
+ * written to the last destination row, which turns a bottom-up bitmap into a
+ * top-down texture in the same pass.  Converting from
+ * CJELLY_FORMAT_IMAGE_PIXEL_RGBA32 with flip set is a plain row flip.
+ *
+ * @param layout Layout of the source pixels.
+ * @param src First source row.
+ * @param src_stride Bytes between source rows.
+ * @param dst First destination row.
+ * @param dst_stride Bytes between destination rows; at least width * 4.
+ * @param width Pixels per row.
+ * @param height Number of rows.
+ * @param flip Whether to reverse the order of the rows.
+ */
+void cjelly_format_image_convert(CJellyFormatImagePixel layout,
+    const unsigned char * src, size_t src_stride,
+    unsigned char * dst, size_t dst_stride,
+    size_t width, size_t height, bool flip);
+
+/**
+ * @brief Returns the name of the conversion backend in use.
+ *
+ * The backend is chosen on first use.  Setting the CJELLY_PIXEL_CONVERT
+ * environment variable to "scalar", "sse2", "ssse3", "avx2" or "neon" forces
+ * a backend, if the CPU supports it, which helps when comparing them.
+ *
+ * @return A constant string such as "avx2" or "scalar".
+ */
+const char * cjelly_format_image_convert_backend(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif // CJELLY_FORMAT_IMAGE_CONVERT_H
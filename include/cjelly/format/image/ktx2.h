@@ -0,0 +1,102 @@
+#ifndef CJELLY_FORMAT_IMAGE_KTX2_H
+#define CJELLY_FORMAT_IMAGE_KTX2_H
+
+#include <stdbool.h>
+#include <cjelly/macros.h>
+#include <cjelly/format/image.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @file ktx2.h
+ * @brief KTX2 container parser for the CJelly library.
+ *
+ * KTX2 files hold GPU-ready texel data (including block-compressed formats)
+ * for every mip level, array layer and cube face, so they are uploaded
+ * without decoding.  Supercompressed files (Basis Universal, Zstandard) are
+ * only described here; their levels are decoded by a transcoder.
+ */
+
+/** @brief Most mip levels a KTX2 file may have (enough for 2^31 texels per side). */
+#define CJELLY_FORMAT_IMAGE_KTX2_MAX_LEVELS 32
+
+/**
+ * @brief Supercompression schemes of a KTX2 file.
+ */
+typedef enum {
+  CJELLY_FORMAT_IMAGE_KTX2_SUPERCOMPRESSION_NONE = 0,    /**< Levels hold texels as is */
+  CJELLY_FORMAT_IMAGE_KTX2_SUPERCOMPRESSION_BASISLZ = 1, /**< Basis Universal ETC1S */
+  CJELLY_FORMAT_IMAGE_KTX2_SUPERCOMPRESSION_ZSTD = 2,    /**< Zstandard */
+  CJELLY_FORMAT_IMAGE_KTX2_SUPERCOMPRESSION_ZLIB = 3     /**< zlib */
+} CJellyFormatImageKTX2Supercompression;
+
+/**
+ * @brief Where one mip level is stored in a KTX2 file.
+ */
+typedef struct CJellyFormatImageKTX2Level {
+  const unsigned char * data; /**< Level data (every layer, face and slice) within the parsed span. */
+  size_t size;                /**< Stored bytes. */
+  size_t uncompressed_size;   /**< Bytes once supercompression is undone. */
+} CJellyFormatImageKTX2Level;
+
+/**
+ * @brief Parsed layout of a KTX2 file held in memory.
+ *
+ * Produced by cjelly_format_image_ktx2_parse().  The pointers refer into the
+ * span that was parsed, which must outlive the structure.
+ */
+typedef struct CJellyFormatImageKTX2Info {
+  unsigned int vk_format;        /**< VkFormat of the texels; 0 for Basis Universal data. */
+  unsigned int type_size;        /**< Bytes per component for endian swapping; 1 for block formats. */
+  unsigned int width;            /**< Width of level 0 in texels. */
+  unsigned int height;           /**< Height of level 0 in texels; at least 1. */
+  unsigned int depth;            /**< Depth of level 0; 1 unless the texture is 3D. */
+  unsigned int layers;           /**< Array layers; at least 1. */
+  unsigned int faces;            /**< 6 for cube maps, otherwise 1. */
+  unsigned int levels;           /**< Mip levels stored, level 0 (largest) first; at least 1. */
+  bool generate_mips;            /**< The file asks for its mip chain to be generated at load time. */
+  unsigned int supercompression; /**< A CJellyFormatImageKTX2Supercompression value. */
+  bool basis;                    /**< Basis Universal data: ETC1S (BasisLZ) or UASTC. */
+  bool uastc;                    /**< The Basis Universal data is UASTC rather than ETC1S. */
+  bool srgb;                     /**< The data format descriptor names the sRGB transfer function. */
+  CJellyFormatImageKTX2Level level[CJELLY_FORMAT_IMAGE_KTX2_MAX_LEVELS]; /**< Stored levels. */
+} CJellyFormatImageKTX2Info;
+
+/**
+ * @brief Parses the headers of a KTX2 file held in memory.
+ *
+ * Nothing is copied or allocated.  The level index is checked against the
+ * span, so the level pointers are always safe to read.
+ *
+ * @param data The KTX2 file.
+ * @param size Size of the span in bytes.
+ * @param out_info Receives the parsed layout.
+ * @return CJELLY_FORMAT_IMAGE_SUCCESS on success, CJELLY_FORMAT_IMAGE_ERR_IO
+ *         if the span is truncated, or CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT.
+ */
+CJellyFormatImageError cjelly_format_image_ktx2_parse(const void * data, size_t size, CJellyFormatImageKTX2Info * out_info);
+
+/**
+ * @brief Returns the texels of one image of a KTX2 file without supercompression.
+ *
+ * Levels store their images layer by layer, each layer face by face.  The
+ * image of a 3D texture holds all of its slices.
+ *
+ * @param info A parsed KTX2 file.
+ * @param level Mip level.
+ * @param layer Array layer.
+ * @param face Cube face, or 0.
+ * @param out_size Receives the size of the image in bytes.
+ * @return The image within the parsed span, or NULL if it does not exist or
+ *         the file is supercompressed.
+ */
+const unsigned char * cjelly_format_image_ktx2_image(const CJellyFormatImageKTX2Info * info,
+    unsigned int level, unsigned int layer, unsigned int face, size_t * out_size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif // CJELLY_FORMAT_IMAGE_KTX2_H
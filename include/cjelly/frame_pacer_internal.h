@@ -0,0 +1,59 @@
+/*
+ * CJelly — Internal frame pacing
+ * Copyright (c) 2025
+ *
+ * Precise waits for the event loop and smoothed per-window frame deltas.
+ * Waits sleep through the OS for all but the last stretch and spin the rest;
+ * the spin margin follows how late the OS has been waking. Frame timing
+ * prefers presentation timestamps (VK_GOOGLE_display_timing) over CPU time
+ * when the swapchain reports them.
+ * Not part of the public API; main thread only.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Monotonic time in microseconds (CLOCK_MONOTONIC, or QueryPerformanceCounter on Win32). */
+uint64_t cj_pacer_now_us(void);
+
+/** Block until deadline_us on the cj_pacer_now_us() clock. Returns at once for past deadlines.
+ *  Uses clock_nanosleep() on POSIX and a high-resolution waitable timer on Win32 where available.
+ */
+void cj_pacer_sleep_until_us(uint64_t deadline_us);
+
+/** Microseconds before a deadline at which an OS wait must end for cj_pacer_sleep_until_us()
+ *  to hit it; callers waiting on something else (events) can stop early by this much. */
+uint64_t cj_pacer_spin_margin_us(void);
+
+/** Frame timing of one window. Zero-initialize before the first frame. */
+typedef struct cj_frame_timing_t {
+  uint64_t last_begin_us;      /**< Start of the previous frame, 0 = none yet. */
+  uint64_t last_present_ns;    /**< Newest reported actual present time, 0 = none yet. */
+  uint32_t last_present_id;    /**< presentID of last_present_ns. */
+  uint64_t present_delta_ns;   /**< Present-to-present interval reported since the last frame, 0 = none. */
+  uint64_t refresh_ns;         /**< Display refresh duration, 0 = unknown. */
+  double smoothed_delta_s;     /**< Exponential average of frame deltas. */
+} cj_frame_timing_t;
+
+/** Start a frame and return the smoothed time since the previous one, in seconds.
+ *  Steady intervals are averaged; an interval far from the average (a stall, or an
+ *  event-driven window waking after idling) replaces it, so animation stays in step.
+ *  @return 0 for the first frame.
+ */
+double cj_frame_timing_begin(cj_frame_timing_t* timing, uint64_t now_us);
+
+/** Record when a present reached the display (nanoseconds on the CLOCK_MONOTONIC timebase). */
+void cj_frame_timing_presented(cj_frame_timing_t* timing, uint32_t present_id, uint64_t actual_present_ns);
+
+/** Round an interval to whole refresh cycles when it is within 10% of a multiple, so frames
+ *  land on the same vblank phase. Unchanged when the refresh duration is unknown. */
+uint64_t cj_frame_timing_snap_interval_us(const cj_frame_timing_t* timing, uint64_t interval_us);
+
+#ifdef __cplusplus
+}
+#endif
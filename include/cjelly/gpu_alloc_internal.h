@@ -0,0 +1,96 @@
+/*
+ * CJelly — Internal GPU memory allocator
+ * Copyright (c) 2025
+ *
+ * Sub-allocates buffers and images out of large VkDeviceMemory blocks so that
+ * thousands of small resources cost a handful of vkAllocateMemory calls.
+ * Each memory type keeps its own block lists: buddy blocks for general use,
+ * linear blocks for small long-lived buffers, and dedicated allocations for
+ * large images. Host-visible blocks stay persistently mapped.
+ * Not part of the public API; like the rest of the engine it is not thread-safe.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+#include <cjelly/cj_engine.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cj_gpu_allocator_t cj_gpu_allocator_t;
+typedef struct cj_gpu_block_t cj_gpu_block_t;
+
+/** Allocation flags. */
+enum {
+  CJ_GPU_ALLOC_OPTIMAL   = 1u << 0,  /**< Backs an optimally tiled image (kept apart from buffers). */
+  CJ_GPU_ALLOC_LINEAR    = 1u << 1,  /**< Bump-allocate; memory returns once the whole block is free. */
+  CJ_GPU_ALLOC_DEDICATED = 1u << 2,  /**< Always use a VkDeviceMemory of its own. */
+};
+
+/** A range of device memory handed out by the allocator. Zero-initialized means empty. */
+typedef struct cj_gpu_alloc_t {
+  VkDeviceMemory memory;   /**< Memory to bind; shared with other allocations unless dedicated. */
+  VkDeviceSize offset;     /**< Offset of the range inside memory. */
+  VkDeviceSize size;       /**< Requested size in bytes. */
+  void* mapped;            /**< Host pointer to offset for host-visible memory, else NULL. */
+  cj_gpu_block_t* block;   /**< Owning block, NULL for dedicated allocations. */
+  uint32_t memory_type;
+  uint32_t order;          /**< Buddy order of the range (buddy blocks only). */
+} cj_gpu_alloc_t;
+
+/** Create an allocator for a device.
+ *  @param host Optional host allocator for bookkeeping; NULL or NULL fields use malloc/free.
+ *  @return The allocator, or NULL on failure.
+ */
+cj_gpu_allocator_t* cj_gpu_allocator_create(VkPhysicalDevice physical, VkDevice device, const cj_allocator_t* host);
+
+/** Free every block. Allocations still alive are reported on stderr. */
+void cj_gpu_allocator_destroy(cj_gpu_allocator_t* allocator);
+
+/** Allocate memory satisfying reqs with at least the given properties.
+ *  @return true on success; out is left zeroed on failure.
+ */
+bool cj_gpu_alloc(cj_gpu_allocator_t* allocator, const VkMemoryRequirements* reqs,
+                  VkMemoryPropertyFlags props, uint32_t flags, cj_gpu_alloc_t* out);
+
+/** Return an allocation and zero it. Safe on an empty allocation. */
+void cj_gpu_free(cj_gpu_allocator_t* allocator, cj_gpu_alloc_t* alloc);
+
+/** Allocate and bind memory for an existing buffer. */
+bool cj_gpu_alloc_buffer(cj_gpu_allocator_t* allocator, VkBuffer buffer,
+                         VkMemoryPropertyFlags props, uint32_t flags, cj_gpu_alloc_t* out);
+
+/** Allocate and bind memory for an existing image (pass CJ_GPU_ALLOC_OPTIMAL for optimal tiling). */
+bool cj_gpu_alloc_image(cj_gpu_allocator_t* allocator, VkImage image,
+                        VkMemoryPropertyFlags props, uint32_t flags, cj_gpu_alloc_t* out);
+
+/** Create an exclusive buffer and bind freshly allocated memory to it.
+ *  @return true on success; nothing is left behind on failure.
+ */
+bool cj_gpu_create_buffer(cj_gpu_allocator_t* allocator, VkDeviceSize size, VkBufferUsageFlags usage,
+                          VkMemoryPropertyFlags props, uint32_t flags,
+                          VkBuffer* out_buffer, cj_gpu_alloc_t* out_alloc);
+
+/** Destroy a buffer made by cj_gpu_create_buffer and free its memory. Both are reset. */
+void cj_gpu_destroy_buffer(cj_gpu_allocator_t* allocator, VkBuffer* buffer, cj_gpu_alloc_t* alloc);
+
+/** Fill in current memory statistics. */
+void cj_gpu_allocator_stats(const cj_gpu_allocator_t* allocator, cj_memory_stats_t* out);
+
+/** Memory types and heaps of the device. */
+const VkPhysicalDeviceMemoryProperties* cj_gpu_allocator_memory_properties(const cj_gpu_allocator_t* allocator);
+
+/** Heap that an allocation with these memory type bits and properties would come from,
+ *  UINT32_MAX when no type matches. */
+uint32_t cj_gpu_allocator_heap(const cj_gpu_allocator_t* allocator, uint32_t type_bits, VkMemoryPropertyFlags props);
+
+/** Device memory obtained from a heap, and the part of it live allocations use. */
+void cj_gpu_allocator_heap_usage(const cj_gpu_allocator_t* allocator, uint32_t heap,
+                                 VkDeviceSize* out_reserved, VkDeviceSize* out_used);
+
+#ifdef __cplusplus
+}
+#endif
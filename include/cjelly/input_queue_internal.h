@@ -0,0 +1,91 @@
+/*
+ * CJelly — Internal per-window input queue
+ * Copyright (c) 2025
+ *
+ * The platform layer pushes raw input into a lock-free single-producer
+ * single-consumer ring instead of calling the window callbacks. The consumer
+ * (the event loop once per frame, or an optional input thread) drains the ring,
+ * coalesces runs of pointer motion, resizes and moves, and delivers the result.
+ * Not part of the public API.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <cjelly/cj_input.h>
+#include <cjelly/cj_window.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Events a window can hold between two dispatches (power of two) */
+#define CJ_INPUT_QUEUE_SIZE 512u
+
+typedef enum cj_input_kind_t {
+  CJ_INPUT_MOUSE,
+  CJ_INPUT_KEY,
+  CJ_INPUT_FOCUS,
+  CJ_INPUT_RESIZE,
+  CJ_INPUT_MOVE,
+  CJ_INPUT_STATE,
+} cj_input_kind_t;
+
+typedef struct cj_input_event_t {
+  cj_input_kind_t kind;
+  union {
+    cj_mouse_event_t mouse;
+    cj_key_event_t key;
+    cj_focus_action_t focus;
+    struct { uint32_t width, height; } size;
+    struct { int32_t x, y; } position;
+    cj_window_state_t state;
+  } u;
+} cj_input_event_t;
+
+/* Delivers one coalesced event. The callback may destroy the queue. */
+typedef void (*cj_input_deliver_fn_t)(void* target, const cj_input_event_t* event);
+
+typedef struct cj_input_queue_t cj_input_queue_t;
+
+/* Create an empty queue that delivers to target. Returns NULL when out of memory. */
+cj_input_queue_t* cj_input_queue_create(cj_input_deliver_fn_t deliver, void* target);
+
+/* Stop the input thread, if any, and free the queue; undelivered events are dropped. */
+void cj_input_queue_destroy(cj_input_queue_t* queue);
+
+/* Producer: append an event. Motion is dropped first once the ring is three
+ * quarters full, so buttons and keys still fit; returns false for a dropped event. */
+bool cj_input_queue_push(cj_input_queue_t* queue, const cj_input_event_t* event);
+
+/* Producer: the current batch of events is complete. Wakes the input thread. */
+void cj_input_queue_notify(cj_input_queue_t* queue);
+
+/* Consumer: deliver everything queued so far. Does nothing while an input
+ * thread owns the queue. */
+void cj_input_queue_dispatch(cj_input_queue_t* queue);
+
+/* Keep the merged motion samples for the delivered events. */
+void cj_input_queue_set_history(cj_input_queue_t* queue, bool enabled);
+
+/* Consumer, while delivering pointer motion: every sample merged into the
+ * event, oldest first and ending with the event itself (1 when nothing was
+ * merged). Returns 0 for other events or when history is off. */
+uint32_t cj_input_queue_history(const cj_input_queue_t* queue, const cj_mouse_event_t** out_samples);
+
+/* Start or stop the input thread, which then is the only consumer. Stopping
+ * delivers what the thread has not yet. Returns false if the thread cannot start. */
+bool cj_input_queue_set_thread(cj_input_queue_t* queue, bool enabled);
+
+/* An input thread owns the queue. Only for the thread that starts and stops it. */
+bool cj_input_queue_threaded(const cj_input_queue_t* queue);
+
+/* The caller is the queue's input thread, e.g. a callback it delivers to. */
+bool cj_input_queue_on_thread(const cj_input_queue_t* queue);
+
+/* Events dropped because the ring was full, since the queue was created. */
+uint32_t cj_input_queue_dropped(const cj_input_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
@@ -46,6 +46,10 @@ typedef struct CJellyFormat3dObjGroup CJellyFormat3dObjGroup;
 typedef struct CJellyFormat3dObjMaterialMapping
     CJellyFormat3dObjMaterialMapping;
 typedef struct CJellyFormat3dObjModel CJellyFormat3dObjModel;
+typedef struct CJellyFormat3dMeshVertex CJellyFormat3dMeshVertex;
+typedef struct CJellyFormat3dMeshRange CJellyFormat3dMeshRange;
+typedef struct CJellyFormat3dMesh CJellyFormat3dMesh;
+typedef struct CJellyFormat3dMeshAsset CJellyFormat3dMeshAsset;
 
 /**
  * A cross-compiler macro for marking a function parameter as unused.
@@ -0,0 +1,160 @@
+/*
+ * CJelly — Internal pipeline cache
+ * Copyright (c) 2025
+ *
+ * Owns the engine's VkPipelineCache, which is loaded from disk when the
+ * engine starts and written back when it shuts down, so pipelines compiled
+ * by one run are cheap to create in the next. The file is keyed by the
+ * device's pipeline cache UUID and driver version; a file written by another
+ * device or driver is ignored.
+ *
+ * On top of that, pipelines and pipeline layouts can be shared: requests with
+ * the same shader code and state return the same reference-counted object.
+ * Requests are matched on the full state, not on a hash of it.
+ * Keys include the handles of the layout, render pass and descriptor set
+ * layouts involved, so those must outlive the objects built from them.
+ *
+ * The cache remembers how each graphics pipeline was built, so it can make a
+ * variant for another render pass, e.g. for a window whose surface format
+ * differs from the pass the pipeline was first made for.
+ *
+ * For shader hot reload it remembers compute pipelines as well. When a named shader changes, rebuild jobs recreate the pipelines
+ * using it (on any thread), and the results replace the old pipelines for
+ * holders that call cj_pipeline_cache_current().
+ * Not part of the public API; apart from cj_pipeline_rebuild_run() it is not
+ * thread-safe, like the rest of the engine.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cj_pipeline_cache_t cj_pipeline_cache_t;
+
+/** SPIR-V code for one stage of a shared pipeline. */
+typedef struct cj_pipeline_shader_t {
+  VkShaderStageFlagBits stage;
+  const void* code;          /**< SPIR-V words; read only while the pipeline is created. */
+  size_t size;               /**< Size of code in bytes. */
+  const char* entry;         /**< Entry point; NULL = "main". */
+  const char* name;          /**< Source file name under src/shaders ("blur.frag") so hot reload can
+                                  replace the code; NULL = fixed code. */
+} cj_pipeline_shader_t;
+
+/** Create the cache for a device and load its file.
+ *  The file lives in $CJELLY_CACHE_DIR, else the user's cache directory
+ *  ($XDG_CACHE_HOME/cjelly, ~/.cache/cjelly or %LOCALAPPDATA%\cjelly).
+ *  A missing or unusable file starts an empty cache.
+ *  @return The cache, or NULL on failure.
+ */
+cj_pipeline_cache_t* cj_pipeline_cache_create(VkPhysicalDevice physical, VkDevice device);
+
+/** Save the cache, then destroy it. Shared objects still referenced are reported on stderr and destroyed. */
+void cj_pipeline_cache_destroy(cj_pipeline_cache_t* cache);
+
+/** Write the cache file if the driver's data changed since it was loaded or last saved.
+ *  The file is replaced atomically. @return true if the file is up to date.
+ */
+bool cj_pipeline_cache_save(cj_pipeline_cache_t* cache);
+
+/** VkPipelineCache to pass to every pipeline creation. VK_NULL_HANDLE for a NULL cache. */
+VkPipelineCache cj_pipeline_cache_handle(const cj_pipeline_cache_t* cache);
+
+/** Return a shared pipeline layout for info, creating it on first use.
+ *  info->pNext must be NULL. Each successful call takes a reference.
+ *  @return The layout, or VK_NULL_HANDLE on failure.
+ */
+VkPipelineLayout cj_pipeline_cache_layout(cj_pipeline_cache_t* cache, const VkPipelineLayoutCreateInfo* info);
+
+/** Drop a reference taken by cj_pipeline_cache_layout; the last one destroys the layout. */
+void cj_pipeline_cache_release_layout(cj_pipeline_cache_t* cache, VkPipelineLayout layout);
+
+/** Return a shared graphics pipeline, creating it on first use.
+ *  The stages come from shaders; info->stageCount and info->pStages are ignored, and shader
+ *  modules are only created on a miss. The key covers the shader code and every piece of
+ *  state info points to, so pNext chains (on info or its states) must be NULL.
+ *  Each successful call takes a reference.
+ *  @return The pipeline, or VK_NULL_HANDLE on failure.
+ */
+VkPipeline cj_pipeline_cache_graphics(cj_pipeline_cache_t* cache, const VkGraphicsPipelineCreateInfo* info,
+                                      const cj_pipeline_shader_t* shaders, uint32_t shader_count);
+
+/** Return a shared compute pipeline, creating it on first use.
+ *  The stage comes from shader, which must be a compute shader; info->stage is ignored.
+ *  The key covers the shader code, info->flags and info->layout, so info->pNext must be NULL.
+ *  Each successful call takes a reference.
+ *  @return The pipeline, or VK_NULL_HANDLE on failure.
+ */
+VkPipeline cj_pipeline_cache_compute(cj_pipeline_cache_t* cache, const VkComputePipelineCreateInfo* info,
+                                     const cj_pipeline_shader_t* shader);
+
+/** Return a shared pipeline built like pipeline (the newest build of the same code) but for
+ *  render_pass, creating it on first use. Each successful call takes a reference.
+ *  @return The variant, or VK_NULL_HANDLE when pipeline is not a graphics pipeline of this
+ *          cache whose state it could remember, or creation failed.
+ */
+VkPipeline cj_pipeline_cache_variant(cj_pipeline_cache_t* cache, VkPipeline pipeline, VkRenderPass render_pass);
+
+/** Receives a pipeline once no holder uses it; the GPU may still be executing it. */
+typedef void (*cj_pipeline_retire_fn_t)(void* user, VkPipeline pipeline);
+
+/** Hand pipelines nobody holds any more to retire instead of destroying them at once. */
+void cj_pipeline_cache_set_retire(cj_pipeline_cache_t* cache, cj_pipeline_retire_fn_t retire, void* user);
+
+/** Drop a reference taken by cj_pipeline_cache_graphics, cj_pipeline_cache_compute or
+ *  cj_pipeline_cache_variant; the last one retires the pipeline. Without a retire callback
+ *  it is destroyed at once, so the GPU must be done with it.
+ */
+void cj_pipeline_cache_release(cj_pipeline_cache_t* cache, VkPipeline pipeline);
+
+/* === Hot reload === */
+
+/** Rebuild of one pipeline with new shader code. */
+typedef struct cj_pipeline_rebuild_t cj_pipeline_rebuild_t;
+
+/** Start remembering the creation state of new pipelines so they can be rebuilt.
+ *  Replaced pipelines go to the retire callback like released ones.
+ */
+void cj_pipeline_cache_enable_reload(cj_pipeline_cache_t* cache);
+
+/** Use code for the shader name in every pipeline created from now on, and list the
+ *  current pipelines built from that shader. The code is copied.
+ *  @return Rebuild jobs linked through cj_pipeline_rebuild_next(), NULL when none.
+ */
+cj_pipeline_rebuild_t* cj_pipeline_cache_set_shader(cj_pipeline_cache_t* cache, const char* name,
+                                                    const void* code, size_t size);
+
+/** Next job of a list returned by cj_pipeline_cache_set_shader(). */
+cj_pipeline_rebuild_t* cj_pipeline_rebuild_next(const cj_pipeline_rebuild_t* job);
+
+/** Create the job's pipeline through the VkPipelineCache. Touches only the job, so it may
+ *  run on any thread while the cache is in use.
+ */
+void cj_pipeline_rebuild_run(cj_pipeline_rebuild_t* job);
+
+/** Make the pipeline of a job that ran the replacement of the one it rebuilt, and free the job.
+ *  Jobs must finish in the order they were returned.
+ *  @return true if holders of the old pipeline now have a replacement to adopt.
+ */
+bool cj_pipeline_cache_finish_rebuild(cj_pipeline_cache_t* cache, cj_pipeline_rebuild_t* job);
+
+/** Free a job without installing it, destroying its pipeline if it ran. */
+void cj_pipeline_rebuild_discard(cj_pipeline_rebuild_t* job);
+
+/** Counter bumped whenever a replacement is installed; holders compare it to skip adoption. */
+uint64_t cj_pipeline_cache_generation(const cj_pipeline_cache_t* cache);
+
+/** Move a reference from pipeline to its newest replacement and return that, or return
+ *  pipeline when it has none. The old pipeline is retired when its last holder moves on.
+ */
+VkPipeline cj_pipeline_cache_current(cj_pipeline_cache_t* cache, VkPipeline pipeline);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+/*
+ * CJelly — Internal GPU timing
+ * Copyright (c) 2025
+ *
+ * Timestamp queries written around the render graph nodes of one frame. Each
+ * window keeps a timer per ring slot and reads it back once the slot's fence
+ * signaled, so reading never waits on the GPU. With CJ_ENABLE_PROFILER set to
+ * 0 every function is an inline no-op.
+ * Not part of the public API; a timer is used by one thread at a time.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+#include <cjelly/cj_profiler.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Query 0 and 1 bracket the frame; zone i uses 2 + 2i and 3 + 2i. */
+#define CJ_GPU_TIMER_QUERY_COUNT (2u + 2u * CJ_PROFILER_MAX_GPU_ZONES)
+
+/** Returned by cj_gpu_timer_begin() when nothing was written. */
+#define CJ_GPU_TIMER_NO_ZONE UINT32_MAX
+
+typedef struct cj_gpu_timer_t {
+  VkDevice device;
+  VkQueryPool pool;           /**< VK_NULL_HANDLE when the queue has no timestamps. */
+  double period_ns;           /**< Nanoseconds per timestamp tick. */
+  uint64_t valid_mask;        /**< Bits of a timestamp the queue writes. */
+  uint64_t frame_index;       /**< Frame whose queries were recorded. */
+  bool pending;               /**< Queries of frame_index await reading. */
+  uint32_t zone_count;        /**< Zones begun in that frame. */
+  char names[CJ_PROFILER_MAX_GPU_ZONES][CJ_PROFILER_NAME_SIZE];
+} cj_gpu_timer_t;
+
+#if CJ_ENABLE_PROFILER
+
+/** Create the query pool. Returns false when the queue family writes no timestamps. */
+bool cj_gpu_timer_init(cj_gpu_timer_t* timer, VkDevice device, VkPhysicalDevice physical, uint32_t queue_family);
+
+/** Destroy the query pool. The GPU must be done with it. */
+void cj_gpu_timer_destroy(cj_gpu_timer_t* timer);
+
+/** Reset the queries and write the frame's first timestamp. Outside any render pass. */
+void cj_gpu_timer_begin_frame(cj_gpu_timer_t* timer, VkCommandBuffer cmd, uint64_t frame_index);
+
+/** Write the frame's last timestamp. Every begun zone must have ended. */
+void cj_gpu_timer_end_frame(cj_gpu_timer_t* timer, VkCommandBuffer cmd);
+
+/** Forget the recorded frame, e.g. when its command buffer is not submitted. */
+void cj_gpu_timer_discard(cj_gpu_timer_t* timer);
+
+/** Begin a zone; returns CJ_GPU_TIMER_NO_ZONE without a frame or when all zones are used. */
+uint32_t cj_gpu_timer_begin(cj_gpu_timer_t* timer, VkCommandBuffer cmd, const char* name);
+
+/** End a zone returned by cj_gpu_timer_begin(). */
+void cj_gpu_timer_end(cj_gpu_timer_t* timer, VkCommandBuffer cmd, uint32_t zone);
+
+/** Read the recorded frame into the GPU fields of out_stats once its submission finished.
+ *  The frame is consumed either way. Returns false when nothing was available. */
+bool cj_gpu_timer_read(cj_gpu_timer_t* timer, cj_profiler_frame_stats_t* out_stats);
+
+#else
+
+static inline bool cj_gpu_timer_init(cj_gpu_timer_t* timer, VkDevice device, VkPhysicalDevice physical, uint32_t queue_family) {
+  (void)timer; (void)device; (void)physical; (void)queue_family;
+  return false;
+}
+static inline void cj_gpu_timer_destroy(cj_gpu_timer_t* timer) { (void)timer; }
+static inline void cj_gpu_timer_begin_frame(cj_gpu_timer_t* timer, VkCommandBuffer cmd, uint64_t frame_index) {
+  (void)timer; (void)cmd; (void)frame_index;
+}
+static inline void cj_gpu_timer_end_frame(cj_gpu_timer_t* timer, VkCommandBuffer cmd) { (void)timer; (void)cmd; }
+static inline void cj_gpu_timer_discard(cj_gpu_timer_t* timer) { (void)timer; }
+static inline uint32_t cj_gpu_timer_begin(cj_gpu_timer_t* timer, VkCommandBuffer cmd, const char* name) {
+  (void)timer; (void)cmd; (void)name;
+  return CJ_GPU_TIMER_NO_ZONE;
+}
+static inline void cj_gpu_timer_end(cj_gpu_timer_t* timer, VkCommandBuffer cmd, uint32_t zone) {
+  (void)timer; (void)cmd; (void)zone;
+}
+static inline bool cj_gpu_timer_read(cj_gpu_timer_t* timer, cj_profiler_frame_stats_t* out_stats) {
+  (void)timer; (void)out_stats;
+  return false;
+}
+
+#endif
+
+/** Timer the render graph writes node zones into while recording; NULL for none.
+ *  Set per recording, since a graph may be shared by several windows. */
+void cj_rgraph__set_gpu_timer(cj_rgraph_t* graph, cj_gpu_timer_t* timer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,10 +4,30 @@
 /* Forward declaration to avoid circular dependency */
 typedef struct cj_engine_t cj_engine_t;
 
-/* Vulkan resource creation helpers */
-CJ_API int cj_engine_create_texture(cj_engine_t* e, uint32_t slot, const cj_texture_desc_t* desc);
-CJ_API int cj_engine_create_buffer(cj_engine_t* e, uint32_t slot, const cj_buffer_desc_t* desc);
-CJ_API int cj_engine_create_sampler(cj_engine_t* e, uint32_t slot, const cj_sampler_desc_t* desc);
-CJ_API void cj_engine_destroy_texture(cj_engine_t* e, uint32_t slot);
-CJ_API void cj_engine_destroy_buffer(cj_engine_t* e, uint32_t slot);
-CJ_API void cj_engine_destroy_sampler(cj_engine_t* e, uint32_t slot);
+/* Vulkan resource creation helpers; index is the entry's resource table index */
+CJ_API int cj_engine_create_texture(cj_engine_t* e, uint32_t index, const cj_texture_desc_t* desc);
+CJ_API int cj_engine_create_buffer(cj_engine_t* e, uint32_t index, const cj_buffer_desc_t* desc);
+CJ_API int cj_engine_create_sampler(cj_engine_t* e, uint32_t index, const cj_sampler_desc_t* desc);
+/* Queue texel data for a texture; returns the upload ticket, 0 on failure */
+CJ_API cj_upload_ticket_t cj_engine_upload_texture(cj_engine_t* e, uint32_t index, const cj_texture_upload_t* upload);
+/* Queue a copy of a whole mip level of one layer and return staging memory for its
+ * tightly packed texels (rows of blocks for compressed formats) and their size; NULL on failure */
+CJ_API void* cj_engine_stage_texture_level(cj_engine_t* e, uint32_t index, uint32_t mip, uint32_t layer,
+                                           size_t* out_size, cj_upload_ticket_t* out_ticket);
+/* Streamed textures: note the size a texture is drawn at this frame, and its resident level */
+CJ_API void cj_engine_request_texture_extent(cj_engine_t* e, uint32_t index, uint32_t width, uint32_t height);
+CJ_API uint32_t cj_engine_texture_resident_mip(cj_engine_t* e, uint32_t index);
+/* Whether the device supports a format for sampling (or depth attachments) */
+CJ_API bool cj_engine_format_supported(cj_engine_t* e, cj_format_t format);
+/* Whether the device can blit (and so generate mips of) optimal images of a format */
+CJ_API bool cj_engine_format_can_generate_mips(cj_engine_t* e, cj_format_t format);
+/* cj_format_t of a VkFormat value, CJ_FORMAT_UNDEFINED when there is none */
+CJ_API cj_format_t cj_engine_format_from_vk(uint32_t vk_format);
+/* Block size of a format in texels and bytes (1x1 for uncompressed formats); false if unknown */
+CJ_API bool cj_engine_format_block(cj_format_t format, uint32_t* out_width, uint32_t* out_height, uint32_t* out_bytes);
+/* Queue bytes for a buffer; returns the upload ticket, 0 on failure */
+CJ_API cj_upload_ticket_t cj_engine_upload_buffer(cj_engine_t* e, uint32_t index, uint64_t offset, const void* data, uint64_t size);
+/* Destroy the Vulkan objects of an entry (safe to repeat); the deletion queue calls these once the GPU is done with them */
+CJ_API void cj_engine_destroy_texture(cj_engine_t* e, uint32_t index);
+CJ_API void cj_engine_destroy_buffer(cj_engine_t* e, uint32_t index);
+CJ_API void cj_engine_destroy_sampler(cj_engine_t* e, uint32_t index);
@@ -0,0 +1,47 @@
+/*
+ * CJelly — Internal render graph hooks
+ * Copyright (c) 2025
+ *
+ * Functions the window layer uses to point a render graph at its backbuffer
+ * and frame slot, and to order its submissions with the graph's async compute work.
+ * Not part of the public API.
+ */
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cjelly/cj_rgraph.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Render pass the backbuffer nodes are recorded into; VK_NULL_HANDLE = the engine pass.
+ * Node pipelines are built for the engine pass, so for a pass of another format
+ * cj_rgraph_prepare() builds variants and recording binds those. Set before preparing
+ * and again before recording, since a graph may be shared by several windows. */
+void cj_rgraph__set_backbuffer_pass(cj_rgraph_t* graph, VkRenderPass pass);
+
+/* Frame slot the next recorded frame is submitted from, one per owner (window or
+ * offscreen target). The per-frame buffers it reads are rewritten only once the
+ * owner records from that slot again, after waiting for it. Without a call, the
+ * frames take CJ_WINDOW_MAX_FRAMES_IN_FLIGHT slots in turn. */
+void cj_rgraph__set_frame(cj_rgraph_t* graph, const void* owner, uint32_t slot);
+
+/* Timeline values the submission of a recorded frame waits for and signals */
+typedef struct cj_rgraph_async_sync_t {
+    VkSemaphore semaphore;  /* VK_NULL_HANDLE = nothing to add to the submission */
+    uint64_t wait_value;    /* 0 = no wait; else wait at VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT */
+    uint64_t signal_value;  /* 0 = no signal */
+} cj_rgraph_async_sync_t;
+
+/* Semaphore operations to add to the submission of the frame the graph was just
+ * recorded for: it samples the compute queue's previous results and feeds the next */
+void cj_rgraph__async_sync(cj_rgraph_t* graph, cj_rgraph_async_sync_t* out);
+
+/* After that submission: submit the compute work the frame recorded, or drop it
+ * when submitted is false */
+void cj_rgraph__submit_async(cj_rgraph_t* graph, bool submitted);
+
+#ifdef __cplusplus
+}
+#endif
@@ -71,10 +71,30 @@ CJ_API void cj_bindless_set_color(CJellyBindlessResources* resources, float r, f
 CJ_API void cj_bindless_update_split_from_colorMul(CJellyBindlessResources* resources);
 
 /** Poll window events (alias for processWindowEvents).
- *  Processes pending window events such as resize, close, etc.
+ *  Processes pending window events such as resize, close, etc., then delivers
+ *  the input queued for each window. Runs of pointer motion, resizes and moves
+ *  reach the callbacks as one event each (see cj_window_set_input_history()).
  */
 CJ_API void cj_poll_events(void);
 
+/** Timeout for cj_wait_events() that waits until an event or a wakeup arrives. */
+#define CJ_WAIT_FOREVER UINT32_MAX
+
+/** Block until window events are pending, cj_wake() is called, or the timeout passes.
+ *  Waits on the X11 connection (and a wakeup pipe) with poll(), or with
+ *  MsgWaitForMultipleObjectsEx() on Win32, so an idle thread uses no CPU.
+ *  Events are not dispatched; call cj_poll_events() afterwards.
+ *  @param timeout_ms Longest wait in milliseconds, 0 to only check, or CJ_WAIT_FOREVER.
+ *  @return true if events or a wakeup are pending, false on timeout.
+ */
+CJ_API bool cj_wait_events(uint32_t timeout_ms);
+
+/** Wake a thread blocked in cj_wait_events().
+ *  Safe to call from any thread. A wakeup posted while nobody waits makes the
+ *  next cj_wait_events() return at once; wakeups posted in between coalesce.
+ */
+CJ_API void cj_wake(void);
+
 /** @defgroup event_loop Event Loop
  *  @{
  */
@@ -84,7 +104,13 @@ typedef struct cj_run_config_t {
   uint32_t target_fps;        /**< Target FPS (0 = unlimited). */
   bool     vsync;             /**< Use VSync for timing (skip sleep when VSync active). */
   bool     run_when_minimized;/**< Continue running when all windows are minimized. */
-  bool     enable_fps_profiling; /**< Print FPS statistics to stdout every second. */
+  bool     enable_fps_profiling; /**< Enable the profiler (cj_profiler.h) and print its statistics every second. */
+  bool     wait_for_events;   /**< Block in cj_wait_events() between iterations instead of sleeping.
+                                   The wait ends at the next window deadline (per-window max_fps,
+                                   target_fps for CJ_REDRAW_ON_EVENTS callbacks), on any OS event,
+                                   or on cj_wake()/cj_window_post_redraw(). Clean CJ_REDRAW_ON_DIRTY
+                                   windows, and CJ_REDRAW_ON_EVENTS ones when target_fps is 0, then
+                                   wait on events alone. */
 } cj_run_config_t;
 
 /** Run the event loop until all windows are closed or shutdown requested.
@@ -0,0 +1,39 @@
+/*
+ * CJelly — Internal shader hot reload
+ * Copyright (c) 2025
+ *
+ * Watches the GLSL sources of the built-in shaders. A background thread
+ * compiles changed files to SPIR-V and rebuilds the pipelines of the pipeline
+ * cache that use them; the main thread installs the results between frames.
+ * Not part of the public API.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <cjelly/pipeline_cache_internal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cj_shader_reload_t cj_shader_reload_t;
+
+/** Start watching a shader source directory.
+ *  @param pipelines Cache whose pipelines get rebuilt; reload must already be enabled on it.
+ *  @param dir Directory to watch; NULL = $CJELLY_SHADER_DIR, else "src/shaders".
+ *  @return The watcher, or NULL when the thread could not start.
+ */
+cj_shader_reload_t* cj_shader_reload_create(cj_pipeline_cache_t* pipelines, const char* dir);
+
+/** Stop the thread and drop rebuilds not installed yet. The device must still exist. */
+void cj_shader_reload_destroy(cj_shader_reload_t* reload);
+
+/** Queue rebuilds for newly compiled shaders and install the rebuilds that finished,
+ *  in order. Never waits for the thread's work. Main thread only.
+ *  @return true when a pipeline got a replacement that holders can adopt.
+ */
+bool cj_shader_reload_poll(cj_shader_reload_t* reload);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,19 +1,22 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <cjelly/gpu_alloc_internal.h>
 
 /* Internal-only textured resources owned by the Engine during migration */
 typedef struct CJellyTexturedResources {
   VkPipeline pipeline;
   VkPipelineLayout pipelineLayout;
   VkImage image;
-  VkDeviceMemory imageMemory;
+  VkFormat imageFormat;
+  cj_gpu_alloc_t imageAlloc;
   VkImageView imageView;
-  VkSampler sampler;
+  VkSampler sampler;          /* Engine shared sampler, referenced by samplerHandle */
+  uint64_t samplerHandle;
   VkDescriptorPool descriptorPool;
   VkDescriptorSetLayout descriptorSetLayout;
   VkDescriptorSet descriptorSet;
   VkBuffer vertexBuffer;
-  VkDeviceMemory vertexBufferMemory;
+  cj_gpu_alloc_t vertexBufferAlloc;
 } CJellyTexturedResources;
 
 
@@ -0,0 +1,114 @@
+/*
+ * CJelly — Internal upload queue
+ * Copyright (c) 2025
+ *
+ * Streams texel data to images, and bytes to buffers, through a persistently mapped staging ring.
+ * Copies queued during a frame are recorded into one command buffer and
+ * submitted together, on a dedicated transfer queue when the device has one.
+ * Each submission is tracked by a fence and identified by a serial ticket.
+ * Mip chains can be generated on the GPU from the uploaded base level, in the same submission.
+ * Not part of the public API; like the rest of the engine it is not thread-safe.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+#include <cjelly/gpu_alloc_internal.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cj_upload_queue_t cj_upload_queue_t;
+
+/** Destination of a staged image copy. */
+typedef struct cj_upload_image_t {
+  VkImage image;
+  VkImageLayout old_layout;   /**< Layout before the copy. UNDEFINED discards the contents and
+                                   promises the GPU is not using the image. */
+  VkImageLayout new_layout;   /**< Layout the image is left in. */
+  VkOffset3D offset;
+  VkExtent3D extent;
+  uint32_t mip_level;
+  uint32_t array_layer;
+  uint32_t texel_size;        /**< Bytes per texel, or per block of a compressed format. */
+  uint32_t block_width;       /**< Block size of a compressed format in texels; 0 = 1. */
+  uint32_t block_height;
+} cj_upload_image_t;
+
+/** An image layer whose mip levels are generated from mip 0. */
+typedef struct cj_upload_mips_t {
+  VkImage image;
+  VkImageLayout layout;       /**< Layout mip 0 is left in by its copies; every level ends up in it. */
+  VkExtent2D extent;          /**< Size of mip 0. */
+  uint32_t levels;            /**< Levels to fill, mip 0 included. */
+  uint32_t array_layer;
+  VkFilter filter;            /**< Blit filter; LINEAR needs the format's linear filtering feature. */
+} cj_upload_mips_t;
+
+/** Create an upload queue.
+ *  @param transfer_queue Queue for discarding uploads; pass the graphics queue when there is no
+ *         dedicated transfer family.
+ *  @param ring_size Staging ring size in bytes (0 = default). The ring is allocated on first use.
+ *  @return The queue, or NULL on failure.
+ */
+cj_upload_queue_t* cj_upload_queue_create(VkDevice device, cj_gpu_allocator_t* gpu,
+                                          VkQueue graphics_queue, uint32_t graphics_family,
+                                          VkQueue transfer_queue, uint32_t transfer_family,
+                                          VkDeviceSize ring_size);
+
+/** Wait for every submitted upload, drop pending ones, and free the queue. */
+void cj_upload_queue_destroy(cj_upload_queue_t* queue);
+
+/** Queue a copy into an image and return where to write its texels.
+ *  The returned memory holds extent.width * height * depth * texel_size tightly packed bytes
+ *  (counting blocks instead of texels for compressed formats, rounded up) and must be filled
+ *  before the next call into the queue.
+ *  @param out_ticket Optional; receives the ticket of the submission that will carry the copy.
+ *  @return Pointer into mapped staging memory, or NULL on failure.
+ */
+void* cj_upload_queue_stage_image(cj_upload_queue_t* queue, const cj_upload_image_t* dst, uint64_t* out_ticket);
+
+/** Queue a copy into a buffer and return where to write its bytes.
+ *  The buffer needs VK_BUFFER_USAGE_TRANSFER_DST_BIT and the GPU must not be using the range.
+ *  The copy runs on the graphics queue and is made visible to vertex input and shader reads.
+ *  The returned memory holds size bytes and must be filled before the next call into the queue.
+ *  @param out_ticket Optional; receives the ticket of the submission that will carry the copy.
+ *  @return Pointer into mapped staging memory, or NULL on failure.
+ */
+void* cj_upload_queue_stage_buffer(cj_upload_queue_t* queue, VkBuffer dst, VkDeviceSize offset, VkDeviceSize size,
+                                   uint64_t* out_ticket);
+
+/** Regenerate mips 1..levels-1 of a layer from mip 0 with a chain of blits.
+ *  Recorded on the graphics queue after the copies of the same submission, so a layer whose
+ *  mip 0 was just staged is downsampled from the new texels. Queuing the same layer twice
+ *  before a flush generates it once. The image needs VK_IMAGE_USAGE_TRANSFER_SRC_BIT and
+ *  _DST_BIT and a format with the blit features; the previous contents of the smaller levels
+ *  are discarded.
+ *  @param out_ticket Optional; receives the ticket of the submission that will carry the blits.
+ *  @return false when out of memory.
+ */
+bool cj_upload_queue_generate_mips(cj_upload_queue_t* queue, const cj_upload_mips_t* mips, uint64_t* out_ticket);
+
+/** Submit every pending copy.
+ *  Must be called before graphics work that reads the images is submitted.
+ *  @return Ticket of the newest submission (0 if nothing was ever submitted).
+ */
+uint64_t cj_upload_queue_flush(cj_upload_queue_t* queue);
+
+/** True once the copies carried by a ticket have finished on the GPU. */
+bool cj_upload_queue_done(cj_upload_queue_t* queue, uint64_t ticket);
+
+/** Block until a ticket is done, submitting it first if it is still pending. */
+void cj_upload_queue_wait(cj_upload_queue_t* queue, uint64_t ticket);
+
+/** Drop pending copies into (and mip generation for) an image that is about to be destroyed. */
+void cj_upload_queue_discard_image(cj_upload_queue_t* queue, VkImage image);
+
+/** Drop pending copies into a buffer that is about to be destroyed. */
+void cj_upload_queue_discard_buffer(cj_upload_queue_t* queue, VkBuffer buffer);
+
+#ifdef __cplusplus
+}
+#endif
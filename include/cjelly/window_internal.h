@@ -9,6 +9,7 @@
 
 #include "cj_window.h"
 #include <stdbool.h>
+#include "frame_pacer_internal.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -84,6 +85,19 @@ void cj_window__dispatch_state_callback(cj_window_t* window, cj_window_state_t n
  *  @return DPI scale factor (1.0 = 96 DPI).
  */
 float cj_window__get_dpi_scale_linux(Display* display, Window root, int32_t win_x, int32_t win_y);
+
+/** Internal helper to note RandR screen and CRTC change events for cj_window__refresh_monitors_linux().
+ *  @param display X11 display.
+ *  @param event The event just read.
+ *  @return True if the event was one of them.
+ */
+bool cj_window__handle_randr_event_linux(Display* display, const XEvent* event);
+
+/** Internal helper to rebuild the monitor DPI cache once after the change events read so far.
+ *  @param display X11 display.
+ *  @return True if it was rebuilt; window DPI scales may have changed.
+ */
+bool cj_window__refresh_monitors_linux(Display* display);
 #endif
 
 /** Internal helper to get window position.
@@ -173,12 +187,46 @@ bool cj_window__uses_always_redraw(cj_window_t* window);
  */
 bool cj_window__should_bypass_fps_limit(cj_render_reason_t reason);
 
+/** Internal helper to consume a redraw posted with cj_window_post_redraw().
+ *  Marks the window dirty with CJ_RENDER_REASON_FORCED. Main thread only.
+ *  @param window The window to check.
+ *  @return true if a redraw had been posted, false otherwise.
+ */
+bool cj_window__take_posted_redraw(cj_window_t* window);
+
+/** Internal helper to find when the event loop next has to run for a window.
+ *  Dirty windows are due when their FPS limit allows; clean CJ_REDRAW_ON_EVENTS
+ *  windows with a frame callback are due one loop interval from now.
+ *  @param window The window to check.
+ *  @param current_time_us Current time in microseconds.
+ *  @param loop_interval_us Target frame time of the event loop (0 = none).
+ *  @return Due time in microseconds, or UINT64_MAX if only an event or a posted redraw can give it work.
+ */
+uint64_t cj_window__next_wake_time_us(cj_window_t* window, uint64_t current_time_us, uint64_t loop_interval_us);
+
+/** Internal helper to read a window's frame timing (refresh duration, smoothed delta).
+ *  @param window The window to query.
+ *  @return The timing state, or NULL for an invalid window.
+ */
+const cj_frame_timing_t* cj_window__frame_timing(cj_window_t* window);
+
 /** Internal helper to update the last render time for a window (used for FPS limiting).
  *  @param window The window to update.
  *  @param render_time_us The time when the frame was rendered (in microseconds).
  */
 void cj_window__update_last_render_time(cj_window_t* window, uint64_t render_time_us);
 
+/** Internal helper to execute and present several windows as one batch.
+ *  Swapchain and graph preparation run on the calling (main) thread, command
+ *  recording fans out over the engine worker pool, and all frames go out in a
+ *  single vkQueueSubmit and vkQueuePresentKHR. Windows sharing a render graph
+ *  are recorded on the same thread. The array is reordered in place.
+ *  @param windows The windows to render.
+ *  @param count Number of entries in windows.
+ *  @return CJ_SUCCESS, or an error if the batch could not be submitted.
+ */
+cj_result_t cj_window__execute_batch(cj_window_t** windows, uint32_t count);
+
 /** Internal helper to check if a key is currently pressed (for repeat detection).
  *  @param window The window to check.
  *  @param keycode The keycode to check.
@@ -234,6 +282,13 @@ void cj_window__dispatch_mouse_callback(cj_window_t* window, const cj_mouse_even
  */
 void cj_window__dispatch_focus_callback(cj_window_t* window, cj_focus_action_t action);
 
+/** Internal helper to deliver the input queued for a window since the last call.
+ *  The dispatch helpers above only queue their events; this runs the callbacks, once
+ *  per run of motion, resize or move events. With an input thread it only wakes it.
+ *  @param window The window to deliver input for.
+ */
+void cj_window__dispatch_input(cj_window_t* window);
+
 /** Internal helper to clear all input state (keys and mouse buttons) on focus loss.
  *  @param window The window to clear state for.
  */
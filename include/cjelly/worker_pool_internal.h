@@ -0,0 +1,67 @@
+/*
+ * CJelly — Internal worker pool
+ * Copyright (c) 2025
+ *
+ * Fixed set of OS threads used to fan per-frame work out across cores. In
+ * between, the same threads run independent background jobs (asset decoding
+ * and the like) from per-worker work-stealing queues; submitting a job returns
+ * at once. Not part of the public API.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct cj_worker_pool_t cj_worker_pool_t;
+
+/** Work item callback: invoked once for every index in [0, count). */
+typedef void (*cj_worker_fn_t)(void* user, uint32_t index);
+
+/** Background job callback; runs once, on a worker or on a thread helping in cj_worker_pool_run_one(). */
+typedef void (*cj_worker_job_fn_t)(void* user);
+
+/** Number of worker threads to use when none is requested (CPU count - 1, capped). */
+uint32_t cj_worker_pool_default_threads(void);
+
+/** Create a pool of worker threads.
+ *  @param thread_count Number of threads to start (the caller of parallel_for also works).
+ *  @return The pool, or NULL on failure or when thread_count is 0.
+ */
+cj_worker_pool_t* cj_worker_pool_create(uint32_t thread_count);
+
+/** Stop and join all worker threads and free the pool. Background jobs that are
+ *  running finish first; jobs that have not started are dropped, so their owners
+ *  free whatever the jobs would have.
+ */
+void cj_worker_pool_destroy(cj_worker_pool_t* pool);
+
+/** Number of worker threads in the pool (0 for NULL). */
+uint32_t cj_worker_pool_size(const cj_worker_pool_t* pool);
+
+/** Run fn(user, i) for every i in [0, count) and return when all calls finished.
+ *  The calling thread takes work items as well. Calls for different indices may
+ *  run concurrently and in any order. With a NULL pool the items run inline.
+ *  Workers busy with a background job join once it finished. Must not be called
+ *  concurrently or from inside a work item or a background job.
+ */
+void cj_worker_pool_parallel_for(cj_worker_pool_t* pool, uint32_t count, cj_worker_fn_t fn, void* user);
+
+/** Queue fn(user) as a background job. Any thread may submit. A job submitted from
+ *  a worker goes on that worker's queue and runs next there unless another worker
+ *  steals it. Others are spread over the queues. Idle workers take the oldest jobs of busy ones.
+ *  @return false for a NULL pool or when out of memory; the job then never runs.
+ */
+bool cj_worker_pool_submit(cj_worker_pool_t* pool, cj_worker_job_fn_t fn, void* user);
+
+/** Run one queued background job on the calling thread, so a thread waiting for a
+ *  job's result helps instead of blocking. Returns false when no job was queued.
+ */
+bool cj_worker_pool_run_one(cj_worker_pool_t* pool);
+
+#ifdef __cplusplus
+}
+#endif
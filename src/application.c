@@ -50,8 +50,21 @@
 typedef struct {
   void* handle;
   void* window;
+  uint32_t slot;
 } HandleMapEntry;
 
+// Window slot type (matches anonymous struct in application.h)
+typedef struct {
+  void* window;
+  uint32_t generation;
+  uint32_t next_free;
+} WindowSlotEntry;
+
+/**
+ * @brief Buckets allocated for the first registered handle.
+ */
+#define INITIAL_HANDLE_MAP_CAPACITY 16
+
 
 /**
  * @brief Debug callback function for Vulkan validation layers.
@@ -425,7 +438,9 @@ CJ_API CJellyApplicationError cjelly_application_create(
   // Initialize window tracking
   newApp->windows = NULL;
   newApp->window_count = 0;
+  newApp->window_slots = 0;
   newApp->window_capacity = 0;
+  newApp->window_free = 0;
   newApp->handle_map = NULL;
   newApp->handle_map_count = 0;
   newApp->handle_map_capacity = 0;
@@ -1174,24 +1189,103 @@ CJ_API uint32_t cjelly_application_get_windows(const CJellyApplication * app,
   if (!app || !out_windows || window_count == 0)
     return 0;
 
-  uint32_t count = (window_count < app->window_count) ? window_count : app->window_count;
-  for (uint32_t i = 0; i < count; i++) {
-    out_windows[i] = app->windows[i];
+  WindowSlotEntry* slots = (WindowSlotEntry*)app->windows;
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < app->window_slots && count < window_count; i++) {
+    if (slots[i].window) {
+      out_windows[count++] = slots[i].window;
+    }
   }
   return count;
 }
 
-CJ_API void* cjelly_application_find_window_by_handle(CJellyApplication * app, void* handle) {
-  if (!app || !handle || !app->handle_map)
+CJ_API uint32_t cjelly_application_window_slots(const CJellyApplication * app) {
+  if (!app)
+    return 0;
+  return app->window_slots;
+}
+
+CJ_API void* cjelly_application_window_at(const CJellyApplication * app, uint32_t slot, uint32_t* out_generation) {
+  if (!app || slot >= app->window_slots) {
+    if (out_generation) *out_generation = 0;
     return NULL;
+  }
+  WindowSlotEntry* entry = &((WindowSlotEntry*)app->windows)[slot];
+  if (out_generation) *out_generation = entry->generation;
+  return entry->window;
+}
 
+CJ_API bool cjelly_application_window_alive(const CJellyApplication * app, uint32_t slot, uint32_t generation) {
+  if (!app || slot >= app->window_slots)
+    return false;
+  WindowSlotEntry* entry = &((WindowSlotEntry*)app->windows)[slot];
+  return entry->window && entry->generation == generation;
+}
+
+// Helper: spread the bits of a handle over the bucket index. X11 window IDs and
+// HWNDs are small, nearly consecutive integers, which would otherwise cluster.
+static uint32_t handle_map_bucket(const void* handle, uint32_t capacity) {
+  uint64_t h = (uint64_t)(uintptr_t)handle;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return (uint32_t)h & (capacity - 1);
+}
+
+// Helper: bucket holding handle, or the empty bucket where it would go.
+static uint32_t handle_map_find(const HandleMapEntry* map, uint32_t capacity, const void* handle) {
+  uint32_t i = handle_map_bucket(handle, capacity);
+  while (map[i].handle && map[i].handle != handle) {
+    i = (i + 1) & (capacity - 1);
+  }
+  return i;
+}
+
+// Helper: rehash into a table of new_capacity buckets. Returns false on OOM.
+static bool handle_map_resize(CJellyApplication * app, uint32_t new_capacity) {
+  HandleMapEntry* new_map = calloc(new_capacity, sizeof(HandleMapEntry));
+  if (!new_map)
+    return false;
   HandleMapEntry* map = (HandleMapEntry*)app->handle_map;
-  for (uint32_t i = 0; i < app->handle_map_count; i++) {
-    if (map[i].handle == handle) {
-      return map[i].window;
+  for (uint32_t i = 0; i < app->handle_map_capacity; i++) {
+    if (map[i].handle) {
+      new_map[handle_map_find(new_map, new_capacity, map[i].handle)] = map[i];
+    }
+  }
+  free(map);
+  // Cast through void* to work around anonymous struct type mismatch
+  app->handle_map = (void*)new_map;
+  app->handle_map_capacity = new_capacity;
+  return true;
+}
+
+// Helper: remove the entry in bucket i, shifting later entries of its probe
+// run back so that lookups never need tombstones.
+static void handle_map_erase(HandleMapEntry* map, uint32_t capacity, uint32_t i) {
+  uint32_t mask = capacity - 1;
+  uint32_t j = i;
+  for (;;) {
+    j = (j + 1) & mask;
+    if (!map[j].handle)
+      break;
+    uint32_t home = handle_map_bucket(map[j].handle, capacity);
+    // Entry j may fill the hole unless its home lies cyclically in (i, j]
+    bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+    if (!stays) {
+      map[i] = map[j];
+      i = j;
     }
   }
-  return NULL;
+  map[i].handle = NULL;
+  map[i].window = NULL;
+}
+
+CJ_API void* cjelly_application_find_window_by_handle(CJellyApplication * app, void* handle) {
+  if (!app || !handle || !app->handle_map)
+    return NULL;
+
+  HandleMapEntry* map = (HandleMapEntry*)app->handle_map;
+  return map[handle_map_find(map, app->handle_map_capacity, handle)].window;
 }
 
 // Global current application pointer (similar to engine)
@@ -1210,34 +1304,45 @@ static bool add_window_to_application(CJellyApplication * app, void* window, voi
   if (!app || !window || !handle)
     return false;
 
-  // Add to window list
-  if (app->window_count >= app->window_capacity) {
+  // Grow both structures first, so a failure leaves the registry unchanged
+  if (!app->window_free && app->window_slots >= app->window_capacity) {
     uint32_t new_capacity = (app->window_capacity == 0) ? 4 : app->window_capacity * 2;
-    void** new_windows = realloc(app->windows, sizeof(void*) * new_capacity);
+    WindowSlotEntry* new_windows = realloc(app->windows, sizeof(WindowSlotEntry) * new_capacity);
     if (!new_windows)
       return false;  // Out of memory - window list allocation failed
-    app->windows = new_windows;
+    // Cast through void* to work around anonymous struct type mismatch
+    app->windows = (void*)new_windows;
     app->window_capacity = new_capacity;
   }
-
-  // Add to handle map BEFORE adding to window list, so we can rollback if handle map fails
-  if (app->handle_map_count >= app->handle_map_capacity) {
-    uint32_t new_capacity = (app->handle_map_capacity == 0) ? 4 : app->handle_map_capacity * 2;
-    HandleMapEntry* new_map = realloc(app->handle_map, sizeof(HandleMapEntry) * new_capacity);
-    if (!new_map)
+  if ((app->handle_map_count + 1) * 2 > app->handle_map_capacity) {
+    uint32_t new_capacity = (app->handle_map_capacity == 0) ? INITIAL_HANDLE_MAP_CAPACITY : app->handle_map_capacity * 2;
+    if (!handle_map_resize(app, new_capacity))
       return false;  // Out of memory - handle map allocation failed
-    // Cast through void* to work around anonymous struct type mismatch
-    app->handle_map = (void*)new_map;
-    app->handle_map_capacity = new_capacity;
   }
 
-  // Both allocations succeeded, now add to both structures atomically
-  HandleMapEntry* map = (HandleMapEntry*)app->handle_map;
-  map[app->handle_map_count].handle = handle;
-  map[app->handle_map_count].window = window;
-  app->handle_map_count++;
+  // Both allocations succeeded, now add to both structures atomically.
+  // Reuse the most recently freed slot, or hand out the next one
+  WindowSlotEntry* slots = (WindowSlotEntry*)app->windows;
+  uint32_t slot;
+  if (app->window_free) {
+    slot = app->window_free - 1;
+    app->window_free = slots[slot].next_free;
+  } else {
+    slot = app->window_slots++;
+    slots[slot].generation = 0;
+  }
+  slots[slot].window = window;
+  slots[slot].next_free = 0;
+  app->window_count++;
 
-  app->windows[app->window_count++] = window;
+  HandleMapEntry* map = (HandleMapEntry*)app->handle_map;
+  uint32_t bucket = handle_map_find(map, app->handle_map_capacity, handle);
+  if (!map[bucket].handle) {
+    map[bucket].handle = handle;
+    app->handle_map_count++;
+  }
+  map[bucket].window = window;
+  map[bucket].slot = slot;
 
   return true;
 }
@@ -1246,31 +1351,31 @@ static void remove_window_from_application(CJellyApplication * app, void* window
   if (!app || !window)
     return;
 
-  // Remove from window list
-  for (uint32_t i = 0; i < app->window_count; i++) {
-    if (app->windows[i] == window) {
-      // Move last element to this position and clear it
-      app->windows[i] = app->windows[app->window_count - 1];
-      app->windows[app->window_count - 1] = NULL;  // Clear the moved pointer
-      app->window_count--;
-      break;
-    }
-  }
-
-  // Remove from handle map
+  // The handle map knows the window's slot; only a window without a handle is searched for
+  WindowSlotEntry* slots = (WindowSlotEntry*)app->windows;
+  uint32_t slot = app->window_slots;
   if (handle && app->handle_map) {
     HandleMapEntry* map = (HandleMapEntry*)app->handle_map;
-    for (uint32_t i = 0; i < app->handle_map_count; i++) {
-      if (map[i].handle == handle) {
-        // Move last element to this position and clear it
-        map[i] = map[app->handle_map_count - 1];
-        map[app->handle_map_count - 1].handle = NULL;
-        map[app->handle_map_count - 1].window = NULL;
-        app->handle_map_count--;
-        break;
-      }
+    uint32_t bucket = handle_map_find(map, app->handle_map_capacity, handle);
+    if (map[bucket].handle && map[bucket].window == window) {
+      slot = map[bucket].slot;
+      handle_map_erase(map, app->handle_map_capacity, bucket);
+      app->handle_map_count--;
+    }
+  }
+  if (slot == app->window_slots) {
+    for (slot = 0; slot < app->window_slots && slots[slot].window != window; slot++) {
     }
   }
+
+  // Free the window's slot; the others stay where they are
+  if (slot < app->window_slots && slots[slot].window == window) {
+    slots[slot].window = NULL;
+    slots[slot].generation++;
+    slots[slot].next_free = app->window_free;
+    app->window_free = slot + 1;
+    app->window_count--;
+  }
 }
 
 CJ_API bool cjelly_application_register_window(CJellyApplication * app, void* window, void* handle) {
@@ -1292,25 +1397,14 @@ CJ_API void cjelly_application_close_all_windows(CJellyApplication * app, bool c
   if (!app)
     return;
 
-  // Create a copy of the window list to avoid issues if windows are destroyed during iteration
-  void** windows_copy = malloc(sizeof(void*) * app->window_count);
-  if (!windows_copy)
-    return;
-
-  for (uint32_t i = 0; i < app->window_count; i++) {
-    windows_copy[i] = app->windows[i];
-  }
-  uint32_t count = app->window_count;
-
-  // Close each window
-  for (uint32_t i = 0; i < count; i++) {
-    cj_window_t* window = (cj_window_t*)windows_copy[i];
+  // Slots are stable, so windows destroyed (or created) by the close callbacks
+  // do not disturb the iteration
+  for (uint32_t i = 0; i < app->window_slots; i++) {
+    cj_window_t* window = (cj_window_t*)cjelly_application_window_at(app, i, NULL);
     if (window) {
       cj_window_close_with_callback(window, cancellable);
     }
   }
-
-  free(windows_copy);
 }
 
 
@@ -0,0 +1,124 @@
+/*
+ * CJelly — Per-frame linear arena
+ * Copyright (c) 2025
+ */
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cjelly/arena_internal.h>
+
+/* First block when the creator does not size it */
+#define CJ_ARENA_DEFAULT_CAPACITY ((size_t)64 * 1024)
+/* Alignment of align = 0 */
+#define CJ_ARENA_MAX_ALIGN (sizeof(max_align_t))
+
+/* A block of arena memory; its bytes follow the header */
+typedef struct cj_arena_block_t {
+  struct cj_arena_block_t* next;  /* Older, full block */
+  size_t capacity;
+  size_t used;
+} cj_arena_block_t;
+
+struct cj_arena_t {
+  cj_arena_block_t* head;  /* Block allocations are bumped from; NULL until first use */
+  size_t used;             /* Bytes handed out since the reset */
+  size_t capacity;         /* Size of the next block */
+};
+
+static atomic_uint_fast64_t g_heap_allocs;
+static _Thread_local bool t_heap_counted;
+
+/* Allocate a block and make it the head */
+static bool arena_push_block(cj_arena_t* arena, size_t capacity) {
+  cj_arena_block_t* block = (cj_arena_block_t*)malloc(sizeof(cj_arena_block_t) + capacity);
+  if (!block) return false;
+  cj_heap_note_alloc();
+  block->next = arena->head;
+  block->capacity = capacity;
+  block->used = 0;
+  arena->head = block;
+  return true;
+}
+
+cj_arena_t* cj_arena_create(size_t capacity) {
+  cj_arena_t* arena = (cj_arena_t*)calloc(1, sizeof(*arena));
+  if (!arena) return NULL;
+  arena->capacity = capacity ? capacity : CJ_ARENA_DEFAULT_CAPACITY;
+  return arena;
+}
+
+void cj_arena_destroy(cj_arena_t* arena) {
+  if (!arena) return;
+  while (arena->head) {
+    cj_arena_block_t* next = arena->head->next;
+    free(arena->head);
+    arena->head = next;
+  }
+  free(arena);
+}
+
+void cj_arena_reset(cj_arena_t* arena) {
+  if (!arena) return;
+  arena->used = 0;
+  if (!arena->head) return;
+  if (!arena->head->next) {
+    arena->head->used = 0;
+    return;
+  }
+
+  /* The last frame needed all of it; the next one gets it in a single block */
+  size_t total = 0;
+  while (arena->head) {
+    cj_arena_block_t* next = arena->head->next;
+    total += arena->head->capacity;
+    free(arena->head);
+    arena->head = next;
+  }
+  arena->capacity = total;
+  arena_push_block(arena, total);  /* Retried from the first allocation when out of memory */
+}
+
+CJ_API void* cj_arena_alloc(cj_arena_t* arena, size_t size, size_t align) {
+  if (!arena) return NULL;
+  if (align == 0) align = CJ_ARENA_MAX_ALIGN;
+  if ((align & (align - 1)) != 0) return NULL;
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    cj_arena_block_t* block = arena->head;
+    if (block) {
+      uintptr_t base = (uintptr_t)(block + 1);
+      uintptr_t start = (base + block->used + (align - 1)) & ~(uintptr_t)(align - 1);
+      size_t end = (size_t)(start - base);
+      if (end <= block->capacity && size <= block->capacity - end) {
+        arena->used += end + size - block->used;
+        block->used = end + size;
+        return (void*)start;
+      }
+    }
+    /* Spill into a new block; the next reset merges them */
+    if (size > SIZE_MAX / 2 - align) return NULL;
+    size_t capacity = block ? block->capacity * 2 : arena->capacity;
+    if (capacity < size + align) capacity = size + align;
+    if (!arena_push_block(arena, capacity)) return NULL;
+  }
+  return NULL;
+}
+
+CJ_API size_t cj_arena_used(const cj_arena_t* arena) {
+  return arena ? arena->used : 0;
+}
+
+void cj_heap_note_alloc(void) {
+  if (t_heap_counted) atomic_fetch_add_explicit(&g_heap_allocs, 1, memory_order_relaxed);
+}
+
+bool cj_heap_count_thread(bool counted) {
+  bool was = t_heap_counted;
+  t_heap_counted = counted;
+  return was;
+}
+
+uint64_t cj_heap_alloc_count(void) {
+  return (uint64_t)atomic_load_explicit(&g_heap_allocs, memory_order_relaxed);
+}
@@ -0,0 +1,458 @@
+/* CJelly assets: files decoded on engine workers, finished on the engine thread, cached by path and mtime */
+
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <cjelly/asset_internal.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <cjelly/engine_internal.h>
+#include <cjelly/worker_pool_internal.h>
+#include <cjelly/format/file.h>
+#include <cjelly/format/image.h>
+#include <cjelly/format/3d/mesh_cache.h>
+
+/* Hash buckets of an empty cache (power of two); doubled past one asset per bucket */
+#define CJ_ASSET_CACHE_BUCKETS 64u
+
+struct cj_asset_t {
+  cj_asset_cache_t* cache;
+  uint32_t refs;                /* Engine thread only */
+
+  /* Cache key */
+  cj_asset_desc_t desc;         /* desc.path points at path */
+  char* path;
+  int64_t mtime;
+  uint64_t size;
+  uint64_t hash;
+
+  cj_asset_t* bucket_next;      /* Hash chain; unlinked once the last reference is gone */
+  cj_asset_t* prev;             /* Every asset the cache owns */
+  cj_asset_t* next;
+  bool pending;                 /* In cache->pending: decoding or waiting for cj_asset_update() */
+  bool abandoned;               /* Released while a worker still decodes it */
+
+  /* Written by the worker before decoded is set */
+  atomic_bool decoded;
+  cj_result_t decode_result;
+  unsigned char* pixels;        /* RGBA8 images */
+  int width, height;
+  CJellyFormatFileMapping ktx2; /* KTX2 files, staged on the engine thread */
+  CJellyFormat3dMeshAsset* mesh_data;
+
+  /* Engine thread, once finished */
+  cj_asset_state_t state;
+  cj_result_t result;
+  cj_handle_t texture;
+  cj_mesh_t mesh;
+  cj_upload_ticket_t ticket;
+};
+
+struct cj_asset_cache_t {
+  cj_engine_t* engine;
+  atomic_bool closing;          /* Workers skip decodes once the cache goes away */
+
+  cj_asset_t** buckets;
+  uint32_t bucket_count;
+  uint32_t keyed_count;         /* Assets in the buckets */
+  cj_asset_t* assets;           /* Every asset, live or abandoned */
+
+  cj_asset_t** pending;
+  uint32_t pending_count, pending_capacity;
+
+  /* Signaled whenever a decode finishes, for cj_asset_wait() */
+#ifdef _WIN32
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE decoded_cv;
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t decoded_cv;
+#endif
+};
+
+static void cache_lock(cj_asset_cache_t* c) {
+#ifdef _WIN32
+  EnterCriticalSection(&c->lock);
+#else
+  pthread_mutex_lock(&c->lock);
+#endif
+}
+
+static void cache_unlock(cj_asset_cache_t* c) {
+#ifdef _WIN32
+  LeaveCriticalSection(&c->lock);
+#else
+  pthread_mutex_unlock(&c->lock);
+#endif
+}
+
+/* FNV-1a over the path, folded with the rest of the key */
+static uint64_t asset_hash(const cj_asset_desc_t* desc, int64_t mtime, uint64_t size) {
+  uint64_t h = 14695981039346656037ull;
+  for (const unsigned char* p = (const unsigned char*)desc->path; *p; p++) h = (h ^ *p) * 1099511628211ull;
+  uint64_t fields[4] = {
+    (uint64_t)desc->type | ((uint64_t)desc->usage << 8) | ((uint64_t)desc->linear << 40) | ((uint64_t)desc->generate_mips << 41),
+    (uint64_t)desc->mesh_flags, (uint64_t)mtime, size,
+  };
+  for (uint32_t i = 0; i < 4; i++) h = (h ^ fields[i]) * 1099511628211ull;
+  return h;
+}
+
+static bool asset_matches(const cj_asset_t* a, const cj_asset_desc_t* desc, int64_t mtime, uint64_t size, uint64_t hash) {
+  return a->hash == hash && a->mtime == mtime && a->size == size && a->desc.type == desc->type &&
+         a->desc.usage == desc->usage && a->desc.linear == desc->linear &&
+         a->desc.generate_mips == desc->generate_mips && a->desc.mesh_flags == desc->mesh_flags &&
+         strcmp(a->path, desc->path) == 0;
+}
+
+static bool cache_grow_buckets(cj_asset_cache_t* c) {
+  uint32_t count = c->bucket_count ? c->bucket_count * 2u : CJ_ASSET_CACHE_BUCKETS;
+  cj_asset_t** buckets = (cj_asset_t**)calloc(count, sizeof(*buckets));
+  if (!buckets) return false;
+  for (uint32_t i = 0; i < c->bucket_count; i++) {
+    for (cj_asset_t* a = c->buckets[i]; a;) {
+      cj_asset_t* next = a->bucket_next;
+      uint32_t b = (uint32_t)(a->hash & (count - 1u));
+      a->bucket_next = buckets[b];
+      buckets[b] = a;
+      a = next;
+    }
+  }
+  free(c->buckets);
+  c->buckets = buckets;
+  c->bucket_count = count;
+  return true;
+}
+
+static void cache_unkey(cj_asset_cache_t* c, cj_asset_t* a) {
+  cj_asset_t** link = &c->buckets[a->hash & (c->bucket_count - 1u)];
+  while (*link && *link != a) link = &(*link)->bucket_next;
+  if (*link) {
+    *link = a->bucket_next;
+    c->keyed_count--;
+  }
+  a->bucket_next = NULL;
+}
+
+static void cache_unpend(cj_asset_cache_t* c, cj_asset_t* a) {
+  for (uint32_t i = 0; i < c->pending_count; i++) {
+    if (c->pending[i] == a) {
+      c->pending[i] = c->pending[--c->pending_count];
+      break;
+    }
+  }
+  a->pending = false;
+}
+
+/* Free an asset no worker touches any more, with what it decoded or created */
+static void asset_free(cj_asset_cache_t* c, cj_asset_t* a) {
+  if (a->texture.idx != 0) cj_texture_release(c->engine, a->texture);
+  cj_mesh_release(c->engine, &a->mesh);
+  if (a->mesh_data) cjelly_format_3d_mesh_asset_free(a->mesh_data);
+  cjelly_format_file_unmap(&a->ktx2);
+  free(a->pixels);
+  if (a->prev) a->prev->next = a->next;
+  else c->assets = a->next;
+  if (a->next) a->next->prev = a->prev;
+  free(a->path);
+  free(a);
+}
+
+static unsigned char* asset_acquire_pixels(void* user, int width, int height, size_t* stride) {
+  cj_asset_t* a = (cj_asset_t*)user;
+  *stride = (size_t)width * 4u;
+  a->pixels = (unsigned char*)malloc(*stride * (size_t)height);
+  return a->pixels;
+}
+
+static cj_result_t asset_image_result(CJellyFormatImageError err) {
+  switch (err) {
+    case CJELLY_FORMAT_IMAGE_SUCCESS:             return CJ_SUCCESS;
+    case CJELLY_FORMAT_IMAGE_ERR_FILE_NOT_FOUND:  return CJ_E_NOT_FOUND;
+    case CJELLY_FORMAT_IMAGE_ERR_OUT_OF_MEMORY:   return CJ_E_OUT_OF_MEMORY;
+    case CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT:  return CJ_E_UNSUPPORTED;
+    default:                                      return CJ_E_INVALID_ARGUMENT;
+  }
+}
+
+/* Job: read and decode the file. Touches nothing but the asset's decode fields */
+static void asset_decode(void* user) {
+  cj_asset_t* a = (cj_asset_t*)user;
+  cj_asset_cache_t* c = a->cache;
+  cj_result_t result = CJ_E_UNKNOWN;
+
+  if (!atomic_load_explicit(&c->closing, memory_order_relaxed)) {
+    if (a->desc.type == CJ_ASSET_MESH) {
+      CJellyFormat3dMeshCacheError err = cjelly_format_3d_mesh_cache_load(a->path, NULL, a->desc.mesh_flags, &a->mesh_data);
+      result = err == CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS          ? CJ_SUCCESS
+             : err == CJELLY_FORMAT_3D_MESH_CACHE_ERR_FILE_NOT_FOUND ? CJ_E_NOT_FOUND
+             : err == CJELLY_FORMAT_3D_MESH_CACHE_ERR_OUT_OF_MEMORY  ? CJ_E_OUT_OF_MEMORY
+                                                                      : CJ_E_INVALID_ARGUMENT;
+      if (result != CJ_SUCCESS) {
+        fprintf(stderr, "cj_asset_load: %s: %s\n", a->path, cjelly_format_3d_mesh_cache_strerror(err));
+      }
+    } else {
+      CJellyFormatImageType type = CJELLY_FORMAT_IMAGE_UNKNOWN;
+      CJellyFormatImageError err = cjelly_format_image_detect_type(a->path, &type);
+      if (err == CJELLY_FORMAT_IMAGE_SUCCESS && type == CJELLY_FORMAT_IMAGE_KTX2) {
+        /* Mapped here so the pages are read on the worker; staging happens on the engine thread */
+        CJellyFormatFileError ferr = cjelly_format_file_map(a->path, &a->ktx2);
+        err = ferr == CJELLY_FORMAT_FILE_SUCCESS     ? CJELLY_FORMAT_IMAGE_SUCCESS
+            : ferr == CJELLY_FORMAT_FILE_ERR_NOT_FOUND ? CJELLY_FORMAT_IMAGE_ERR_FILE_NOT_FOUND
+                                                       : CJELLY_FORMAT_IMAGE_ERR_IO;
+        for (size_t i = 0; err == CJELLY_FORMAT_IMAGE_SUCCESS && i < a->ktx2.size; i += 4096) {
+          (void)*(volatile const unsigned char*)(a->ktx2.data + i);
+        }
+      } else if (err == CJELLY_FORMAT_IMAGE_SUCCESS) {
+        CJellyFormatImageTarget target = { asset_acquire_pixels, a };
+        err = cjelly_format_image_load_rgba(a->path, &target, &a->width, &a->height);
+      }
+      result = asset_image_result(err);
+      if (result != CJ_SUCCESS) fprintf(stderr, "cj_asset_load: %s: %s\n", a->path, cjelly_format_image_strerror(err));
+    }
+  }
+
+  a->decode_result = result;
+  cache_lock(c);
+  atomic_store_explicit(&a->decoded, true, memory_order_release);
+#ifdef _WIN32
+  WakeAllConditionVariable(&c->decoded_cv);
+#else
+  pthread_cond_broadcast(&c->decoded_cv);
+#endif
+  cache_unlock(c);
+}
+
+/* Block until the asset's decode job ran, running other queued jobs meanwhile */
+static void asset_wait_decoded(cj_asset_cache_t* c, cj_asset_t* a) {
+  cj_worker_pool_t* workers = cj_engine_job_workers(c->engine);
+  while (!atomic_load_explicit(&a->decoded, memory_order_acquire)) {
+    if (cj_worker_pool_run_one(workers)) continue;
+    /* Nothing left to help with: the asset is decoding on a worker */
+    cache_lock(c);
+    while (!atomic_load_explicit(&a->decoded, memory_order_acquire)) {
+#ifdef _WIN32
+      SleepConditionVariableCS(&c->decoded_cv, &c->lock, INFINITE);
+#else
+      pthread_cond_wait(&c->decoded_cv, &c->lock);
+#endif
+    }
+    cache_unlock(c);
+  }
+}
+
+/* Engine thread: turn a decoded asset into GPU objects and queue their contents */
+static void asset_finish(cj_asset_cache_t* c, cj_asset_t* a) {
+  cj_engine_t* e = c->engine;
+  cache_unpend(c, a);
+  cj_result_t result = a->decode_result;
+
+  if (result == CJ_SUCCESS && a->desc.type == CJ_ASSET_MESH) {
+    result = cj_mesh_upload(e, &a->mesh_data->mesh, &a->mesh);
+    a->ticket = a->mesh.ticket;
+  } else if (result == CJ_SUCCESS && a->ktx2.data) {
+    cj_ktx2_load_desc_t kd = {0};
+    kd.usage = a->desc.usage;
+    result = cj_texture_load_ktx2_memory(e, a->ktx2.data, a->ktx2.size, &kd, &a->texture, &a->ticket);
+    cjelly_format_file_unmap(&a->ktx2);
+  } else if (result == CJ_SUCCESS) {
+    cj_texture_desc_t td = {0};
+    td.width = (uint32_t)a->width;
+    td.height = (uint32_t)a->height;
+    td.format = a->desc.linear ? CJ_FORMAT_RGBA8_UNORM : CJ_FORMAT_RGBA8_SRGB;
+    td.usage = a->desc.usage ? a->desc.usage : CJ_IMAGE_SAMPLED;
+    td.generate_mips = a->desc.generate_mips && cj_texture_can_generate_mips(e, td.format);
+    a->texture = cj_texture_create(e, &td);
+    cj_texture_upload_t up = {0};
+    up.data = a->pixels;
+    a->ticket = a->texture.idx != 0 ? cj_upload_texture(e, a->texture, &up) : 0;
+    if (a->ticket == 0) result = CJ_E_OUT_OF_MEMORY;
+    free(a->pixels);
+    a->pixels = NULL;
+  }
+
+  a->result = result;
+  a->state = result == CJ_SUCCESS ? CJ_ASSET_UPLOADING : CJ_ASSET_FAILED;
+}
+
+cj_asset_cache_t* cj_asset_cache_create(cj_engine_t* engine) {
+  cj_asset_cache_t* c = (cj_asset_cache_t*)calloc(1, sizeof(*c));
+  if (!c) return NULL;
+  c->engine = engine;
+  atomic_init(&c->closing, false);
+#ifdef _WIN32
+  InitializeCriticalSection(&c->lock);
+  InitializeConditionVariable(&c->decoded_cv);
+#else
+  pthread_mutex_init(&c->lock, NULL);
+  pthread_cond_init(&c->decoded_cv, NULL);
+#endif
+  return c;
+}
+
+void cj_asset_cache_destroy(cj_asset_cache_t* c) {
+  if (!c) return;
+  /* The workers outlive the cache: let queued decodes skip their files, then wait them out */
+  atomic_store_explicit(&c->closing, true, memory_order_relaxed);
+  for (uint32_t i = 0; i < c->pending_count; i++) asset_wait_decoded(c, c->pending[i]);
+  while (c->assets) asset_free(c, c->assets);
+#ifdef _WIN32
+  DeleteCriticalSection(&c->lock);
+#else
+  pthread_cond_destroy(&c->decoded_cv);
+  pthread_mutex_destroy(&c->lock);
+#endif
+  free(c->buckets);
+  free(c->pending);
+  free(c);
+}
+
+CJ_API cj_result_t cj_asset_load(cj_engine_t* e, const cj_asset_desc_t* desc, cj_asset_t** out_asset) {
+  if (out_asset) *out_asset = NULL;
+  if (!e || !desc || !desc->path || !out_asset ||
+      (desc->type != CJ_ASSET_TEXTURE && desc->type != CJ_ASSET_MESH)) {
+    return CJ_E_INVALID_ARGUMENT;
+  }
+  cj_asset_cache_t* c = cj_engine_asset_cache(e);
+  if (!c) return CJ_E_OUT_OF_MEMORY;
+
+  int64_t mtime = 0;
+  uint64_t size = 0;
+  if (cjelly_format_file_stat(desc->path, &mtime, &size) != CJELLY_FORMAT_FILE_SUCCESS) {
+    fprintf(stderr, "cj_asset_load: cannot find %s\n", desc->path);
+    return CJ_E_NOT_FOUND;
+  }
+  uint64_t hash = asset_hash(desc, mtime, size);
+  if (c->bucket_count) {
+    for (cj_asset_t* a = c->buckets[hash & (c->bucket_count - 1u)]; a; a = a->bucket_next) {
+      if (asset_matches(a, desc, mtime, size, hash)) {
+        a->refs++;
+        *out_asset = a;
+        return CJ_SUCCESS;
+      }
+    }
+  }
+
+  if (c->keyed_count >= c->bucket_count && !cache_grow_buckets(c)) return CJ_E_OUT_OF_MEMORY;
+  if (c->pending_count == c->pending_capacity) {
+    uint32_t cap = c->pending_capacity ? c->pending_capacity * 2u : 64u;
+    cj_asset_t** grown = (cj_asset_t**)realloc(c->pending, sizeof(*grown) * cap);
+    if (!grown) return CJ_E_OUT_OF_MEMORY;
+    c->pending = grown;
+    c->pending_capacity = cap;
+  }
+  size_t path_len = strlen(desc->path);
+  cj_asset_t* a = (cj_asset_t*)calloc(1, sizeof(*a));
+  char* path = (char*)malloc(path_len + 1u);
+  if (!a || !path) {
+    free(a);
+    free(path);
+    return CJ_E_OUT_OF_MEMORY;
+  }
+  memcpy(path, desc->path, path_len + 1u);
+  a->cache = c;
+  a->refs = 1;
+  a->desc = *desc;
+  a->desc.path = path;
+  a->path = path;
+  a->mtime = mtime;
+  a->size = size;
+  a->hash = hash;
+  atomic_init(&a->decoded, false);
+  a->state = CJ_ASSET_LOADING;
+
+  uint32_t b = (uint32_t)(hash & (c->bucket_count - 1u));
+  a->bucket_next = c->buckets[b];
+  c->buckets[b] = a;
+  c->keyed_count++;
+  a->next = c->assets;
+  if (c->assets) c->assets->prev = a;
+  c->assets = a;
+  c->pending[c->pending_count++] = a;
+  a->pending = true;
+
+  if (!cj_worker_pool_submit(cj_engine_job_workers(e), asset_decode, a)) asset_decode(a);
+  *out_asset = a;
+  return CJ_SUCCESS;
+}
+
+CJ_API void cj_asset_retain(cj_asset_t* a) {
+  if (a) a->refs++;
+}
+
+CJ_API void cj_asset_release(cj_engine_t* e, cj_asset_t* a) {
+  (void)e;
+  if (!a || a->refs == 0 || --a->refs > 0) return;
+  cj_asset_cache_t* c = a->cache;
+  cache_unkey(c, a);
+  if (a->pending && !atomic_load_explicit(&a->decoded, memory_order_acquire)) {
+    /* cj_asset_update() frees it once the worker is done with it */
+    a->abandoned = true;
+    return;
+  }
+  if (a->pending) cache_unpend(c, a);
+  asset_free(c, a);
+}
+
+CJ_API void cj_asset_update(cj_engine_t* e) {
+  cj_asset_cache_t* c = e ? cj_engine_asset_cache(e) : NULL;
+  if (!c) return;
+  for (uint32_t i = 0; i < c->pending_count;) {
+    cj_asset_t* a = c->pending[i];
+    if (!atomic_load_explicit(&a->decoded, memory_order_acquire)) {
+      i++;
+      continue;
+    }
+    /* Both swap the last pending asset into slot i */
+    if (a->abandoned) {
+      cache_unpend(c, a);
+      asset_free(c, a);
+    } else {
+      asset_finish(c, a);
+    }
+  }
+}
+
+CJ_API cj_asset_state_t cj_asset_state(cj_engine_t* e, const cj_asset_t* a) {
+  if (!a) return CJ_ASSET_FAILED;
+  if (a->state == CJ_ASSET_UPLOADING && cj_upload_is_complete(e, a->ticket)) return CJ_ASSET_READY;
+  return a->state;
+}
+
+CJ_API cj_result_t cj_asset_wait(cj_engine_t* e, cj_asset_t* a) {
+  if (!e || !a) return CJ_E_INVALID_ARGUMENT;
+  cj_asset_cache_t* c = a->cache;
+  asset_wait_decoded(c, a);
+  if (a->pending) asset_finish(c, a);
+  if (a->state == CJ_ASSET_UPLOADING) {
+    cj_upload_flush(e);
+    cj_upload_wait(e, a->ticket);
+    a->state = CJ_ASSET_READY;
+  }
+  return a->result;
+}
+
+CJ_API cj_result_t cj_asset_result(const cj_asset_t* a) { return a ? a->result : CJ_E_INVALID_ARGUMENT; }
+CJ_API cj_upload_ticket_t cj_asset_ticket(const cj_asset_t* a) { return a ? a->ticket : 0; }
+CJ_API cj_handle_t cj_asset_texture(const cj_asset_t* a) { return a ? a->texture : cj_handle_nil(); }
+
+CJ_API const cj_mesh_t* cj_asset_mesh(const cj_asset_t* a) {
+  return (a && a->mesh.vertex_buffer.idx != 0) ? &a->mesh : NULL;
+}
+
+CJ_API const struct CJellyFormat3dMeshAsset* cj_asset_mesh_data(const cj_asset_t* a) {
+  return (a && a->state != CJ_ASSET_LOADING && a->state != CJ_ASSET_FAILED) ? a->mesh_data : NULL;
+}
@@ -0,0 +1,433 @@
+/* CJelly atlas packer: maxrects pages, id slots and LRU order */
+
+#include <cjelly/atlas_packer_internal.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Free or used rectangle in page space; used boxes include the padding */
+typedef struct cj_atlas_box_t {
+  uint32_t x, y, w, h;
+} cj_atlas_box_t;
+
+/* Maximal free rectangles of one page */
+typedef struct cj_atlas_page_t {
+  cj_atlas_box_t* free;
+  uint32_t free_count;
+  uint32_t free_capacity;
+  bool dirty;                /* Entries were moved; free list needs a rebuild before placement */
+  bool loose;                /* Entries were removed; free list is valid but may not be maximal */
+} cj_atlas_page_t;
+
+typedef struct cj_atlas_slot_t {
+  cj_atlas_rect_t rect;
+  uint32_t prev, next;       /* LRU neighbors by id; 0 ends the list */
+  bool in_use;
+} cj_atlas_slot_t;
+
+struct cj_atlas_packer_t {
+  uint32_t width, height, padding;
+  cj_atlas_page_t* pages;
+  uint32_t page_count;
+  cj_atlas_slot_t* slots;    /* Indexed by id - 1 */
+  uint32_t max_entries;
+  uint32_t* free_ids;        /* Stack of unused ids */
+  uint32_t free_id_count;
+  uint32_t entry_count;
+  uint32_t lru_head;         /* Most recently used */
+  uint32_t lru_tail;         /* Least recently used */
+};
+
+static bool packer_push_free(cj_atlas_page_t* page, cj_atlas_box_t box) {
+  if (page->free_count == page->free_capacity) {
+    uint32_t capacity = page->free_capacity ? page->free_capacity * 2u : 16u;
+    cj_atlas_box_t* grown = (cj_atlas_box_t*)realloc(page->free, sizeof(cj_atlas_box_t) * capacity);
+    if (!grown) return false;
+    page->free = grown;
+    page->free_capacity = capacity;
+  }
+  page->free[page->free_count++] = box;
+  return true;
+}
+
+/* Free space of an empty page; the padding margin past the edge lets entries touch it */
+static bool packer_reset_page(const cj_atlas_packer_t* p, cj_atlas_page_t* page) {
+  page->free_count = 0;
+  page->dirty = false;
+  page->loose = false;
+  cj_atlas_box_t all = { 0, 0, p->width + p->padding, p->height + p->padding };
+  return packer_push_free(page, all);
+}
+
+static bool packer_box_contains(const cj_atlas_box_t* a, const cj_atlas_box_t* b) {
+  return b->x >= a->x && b->y >= a->y && b->x + b->w <= a->x + a->w && b->y + b->h <= a->y + a->h;
+}
+
+/* Drop free rectangles from first on covered by another one, and older ones they cover */
+static void packer_prune_from(cj_atlas_page_t* page, uint32_t first) {
+  for (uint32_t i = first; i < page->free_count;) {
+    bool covered = false;
+    for (uint32_t j = 0; j < page->free_count && !covered; j++) {
+      covered = j != i && packer_box_contains(&page->free[j], &page->free[i]);
+    }
+    // The last rectangle is always a new one, so the swap keeps new ones past first
+    if (covered) page->free[i] = page->free[--page->free_count]; else i++;
+  }
+  uint32_t kept = 0;
+  for (uint32_t j = 0; j < page->free_count; j++) {
+    bool covered = false;
+    for (uint32_t i = first; j < first && i < page->free_count && !covered; i++) {
+      covered = packer_box_contains(&page->free[i], &page->free[j]);
+    }
+    if (!covered) page->free[kept++] = page->free[j];
+  }
+  page->free_count = kept;
+}
+
+/* The part of a's and b's union spanning both across their shared edge, if they touch */
+static bool packer_box_bridge(const cj_atlas_box_t* a, const cj_atlas_box_t* b, cj_atlas_box_t* out) {
+  if (a->x + a->w == b->x || b->x + b->w == a->x) {
+    uint32_t y0 = a->y > b->y ? a->y : b->y;
+    uint32_t y1 = a->y + a->h < b->y + b->h ? a->y + a->h : b->y + b->h;
+    if (y1 <= y0) return false;
+    uint32_t x0 = a->x < b->x ? a->x : b->x;
+    *out = (cj_atlas_box_t){ x0, y0, a->w + b->w, y1 - y0 };
+    return true;
+  }
+  if (a->y + a->h == b->y || b->y + b->h == a->y) {
+    uint32_t x0 = a->x > b->x ? a->x : b->x;
+    uint32_t x1 = a->x + a->w < b->x + b->w ? a->x + a->w : b->x + b->w;
+    if (x1 <= x0) return false;
+    uint32_t y0 = a->y < b->y ? a->y : b->y;
+    *out = (cj_atlas_box_t){ x0, y0, x1 - x0, a->h + b->h };
+    return true;
+  }
+  return false;
+}
+
+/* Carve a used box out of every free rectangle it overlaps */
+static bool packer_place(cj_atlas_page_t* page, cj_atlas_box_t used) {
+  uint32_t count = page->free_count;
+  bool ok = true;
+  for (uint32_t i = 0; i < count && ok; i++) {
+    cj_atlas_box_t f = page->free[i];
+    if (used.x >= f.x + f.w || used.x + used.w <= f.x || used.y >= f.y + f.h || used.y + used.h <= f.y) continue;
+    // Append f's parts outside the used box and empty f for the compaction below
+    page->free[i].w = 0;
+    if (used.x > f.x) {
+      ok &= packer_push_free(page, (cj_atlas_box_t){ f.x, f.y, used.x - f.x, f.h });
+    }
+    if (used.x + used.w < f.x + f.w) {
+      ok &= packer_push_free(page, (cj_atlas_box_t){ used.x + used.w, f.y, f.x + f.w - (used.x + used.w), f.h });
+    }
+    if (used.y > f.y) {
+      ok &= packer_push_free(page, (cj_atlas_box_t){ f.x, f.y, f.w, used.y - f.y });
+    }
+    if (used.y + used.h < f.y + f.h) {
+      ok &= packer_push_free(page, (cj_atlas_box_t){ f.x, used.y + used.h, f.w, f.y + f.h - (used.y + used.h) });
+    }
+  }
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    if (page->free[i].w) page->free[kept++] = page->free[i];
+  }
+  uint32_t first = kept;
+  for (uint32_t i = count; i < page->free_count; i++) page->free[kept++] = page->free[i];
+  page->free_count = kept;
+  if (!ok) return false;
+  // No part can cover an untouched rectangle, so only the parts need pruning
+  packer_prune_from(page, first);
+  return true;
+}
+
+/*
+ * Return a used box to the free list without a rebuild: the box itself plus,
+ * for every free rectangle it touches, the strip bridging both. The list stays
+ * exact about what is free but may miss larger rectangles spanning several
+ * neighbors, so the page is marked loose for defragmentation and stats.
+ */
+static bool packer_release(cj_atlas_page_t* page, cj_atlas_box_t box) {
+  uint32_t first = page->free_count;
+  if (!packer_push_free(page, box)) return false;
+  for (uint32_t i = 0; i < first; i++) {
+    cj_atlas_box_t bridge;
+    if (packer_box_bridge(&page->free[i], &box, &bridge) && !packer_push_free(page, bridge)) return false;
+  }
+  packer_prune_from(page, first);
+  page->loose = true;
+  return true;
+}
+
+static cj_atlas_box_t packer_used_box(const cj_atlas_packer_t* p, const cj_atlas_rect_t* r) {
+  cj_atlas_box_t box = { r->x, r->y, r->width + p->padding, r->height + p->padding };
+  return box;
+}
+
+/* Recompute a page's maximal free rectangles from the entries still on it */
+static bool packer_rebuild_page(cj_atlas_packer_t* p, uint32_t index) {
+  cj_atlas_page_t* page = &p->pages[index];
+  if (!packer_reset_page(p, page)) return false;
+  for (uint32_t i = 0; i < p->max_entries; i++) {
+    const cj_atlas_slot_t* s = &p->slots[i];
+    if (s->in_use && s->rect.page == index && !packer_place(page, packer_used_box(p, &s->rect))) {
+      page->dirty = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Best short side fit on one page; false when nothing fits */
+static bool packer_find(const cj_atlas_page_t* page, uint32_t w, uint32_t h, uint32_t* out_x, uint32_t* out_y) {
+  uint32_t best_short = UINT32_MAX, best_long = UINT32_MAX;
+  for (uint32_t i = 0; i < page->free_count; i++) {
+    const cj_atlas_box_t* f = &page->free[i];
+    if (f->w < w || f->h < h) continue;
+    uint32_t dw = f->w - w, dh = f->h - h;
+    uint32_t s = dw < dh ? dw : dh;
+    uint32_t l = dw < dh ? dh : dw;
+    if (s < best_short || (s == best_short && l < best_long)) {
+      best_short = s;
+      best_long = l;
+      *out_x = f->x;
+      *out_y = f->y;
+    }
+  }
+  return best_short != UINT32_MAX;
+}
+
+/* Place w x h (unpadded) on the first of count pages with room */
+static bool packer_allocate(cj_atlas_packer_t* p, cj_atlas_page_t* pages, uint32_t count,
+                            uint32_t w, uint32_t h, cj_atlas_rect_t* out) {
+  for (uint32_t i = 0; i < count; i++) {
+    if (pages[i].dirty && pages == p->pages && !packer_rebuild_page(p, i)) continue;
+    uint32_t x, y;
+    if (!packer_find(&pages[i], w + p->padding, h + p->padding, &x, &y)) continue;
+    cj_atlas_rect_t r = { i, x, y, w, h };
+    if (!packer_place(&pages[i], packer_used_box(p, &r))) return false;
+    *out = r;
+    return true;
+  }
+  return false;
+}
+
+static void packer_lru_unlink(cj_atlas_packer_t* p, uint32_t id) {
+  cj_atlas_slot_t* s = &p->slots[id - 1];
+  if (s->prev) p->slots[s->prev - 1].next = s->next; else p->lru_head = s->next;
+  if (s->next) p->slots[s->next - 1].prev = s->prev; else p->lru_tail = s->prev;
+  s->prev = s->next = 0;
+}
+
+static void packer_lru_push_front(cj_atlas_packer_t* p, uint32_t id) {
+  cj_atlas_slot_t* s = &p->slots[id - 1];
+  s->prev = 0;
+  s->next = p->lru_head;
+  if (p->lru_head) p->slots[p->lru_head - 1].prev = id; else p->lru_tail = id;
+  p->lru_head = id;
+}
+
+static const cj_atlas_slot_t* packer_slot(const cj_atlas_packer_t* p, uint32_t id) {
+  if (!p || id == 0 || id > p->max_entries || !p->slots[id - 1].in_use) return NULL;
+  return &p->slots[id - 1];
+}
+
+cj_atlas_packer_t* cj_atlas_packer_create(uint32_t width, uint32_t height, uint32_t padding, uint32_t max_entries) {
+  if (width == 0 || height == 0 || max_entries == 0) return NULL;
+  cj_atlas_packer_t* p = (cj_atlas_packer_t*)calloc(1, sizeof(cj_atlas_packer_t));
+  if (!p) return NULL;
+  p->width = width;
+  p->height = height;
+  p->padding = padding;
+  p->max_entries = max_entries;
+  p->slots = (cj_atlas_slot_t*)calloc(max_entries, sizeof(cj_atlas_slot_t));
+  p->free_ids = (uint32_t*)malloc(sizeof(uint32_t) * max_entries);
+  if (!p->slots || !p->free_ids || !cj_atlas_packer_add_page(p)) {
+    cj_atlas_packer_destroy(p);
+    return NULL;
+  }
+  // Hand out low ids first
+  for (uint32_t i = 0; i < max_entries; i++) p->free_ids[i] = max_entries - i;
+  p->free_id_count = max_entries;
+  return p;
+}
+
+void cj_atlas_packer_destroy(cj_atlas_packer_t* p) {
+  if (!p) return;
+  for (uint32_t i = 0; i < p->page_count; i++) free(p->pages[i].free);
+  free(p->pages);
+  free(p->slots);
+  free(p->free_ids);
+  free(p);
+}
+
+uint32_t cj_atlas_packer_insert(cj_atlas_packer_t* p, uint32_t width, uint32_t height, cj_atlas_rect_t* out_rect) {
+  if (!p || width == 0 || height == 0 || width > p->width || height > p->height) return 0;
+  if (p->free_id_count == 0) return 0;
+
+  cj_atlas_rect_t r;
+  if (!packer_allocate(p, p->pages, p->page_count, width, height, &r)) return 0;
+
+  uint32_t id = p->free_ids[--p->free_id_count];
+  cj_atlas_slot_t* s = &p->slots[id - 1];
+  s->rect = r;
+  s->in_use = true;
+  packer_lru_push_front(p, id);
+  p->entry_count++;
+  if (out_rect) *out_rect = r;
+  return id;
+}
+
+void cj_atlas_packer_remove(cj_atlas_packer_t* p, uint32_t id) {
+  if (!packer_slot(p, id)) return;
+  cj_atlas_slot_t* s = &p->slots[id - 1];
+  packer_lru_unlink(p, id);
+  cj_atlas_page_t* page = &p->pages[s->rect.page];
+  // A page awaiting a rebuild picks the space up then; out of memory defers to one
+  if (!page->dirty && !packer_release(page, packer_used_box(p, &s->rect))) page->dirty = true;
+  s->in_use = false;
+  p->free_ids[p->free_id_count++] = id;
+  p->entry_count--;
+}
+
+bool cj_atlas_packer_get(const cj_atlas_packer_t* p, uint32_t id, cj_atlas_rect_t* out_rect) {
+  const cj_atlas_slot_t* s = packer_slot(p, id);
+  if (!s) return false;
+  if (out_rect) *out_rect = s->rect;
+  return true;
+}
+
+void cj_atlas_packer_touch(cj_atlas_packer_t* p, uint32_t id) {
+  if (!packer_slot(p, id) || p->lru_head == id) return;
+  packer_lru_unlink(p, id);
+  packer_lru_push_front(p, id);
+}
+
+uint32_t cj_atlas_packer_lru(const cj_atlas_packer_t* p) {
+  return p ? p->lru_tail : 0;
+}
+
+bool cj_atlas_packer_add_page(cj_atlas_packer_t* p) {
+  if (!p) return false;
+  cj_atlas_page_t* pages = (cj_atlas_page_t*)realloc(p->pages, sizeof(cj_atlas_page_t) * (p->page_count + 1u));
+  if (!pages) return false;
+  p->pages = pages;
+  cj_atlas_page_t* page = &pages[p->page_count];
+  memset(page, 0, sizeof(*page));
+  if (!packer_reset_page(p, page)) return false;
+  p->page_count++;
+  return true;
+}
+
+uint32_t cj_atlas_packer_page_count(const cj_atlas_packer_t* p) {
+  return p ? p->page_count : 0;
+}
+
+/* Largest free rectangle over a set of pages, clipped to the page proper */
+static uint64_t packer_largest_free(const cj_atlas_packer_t* p, const cj_atlas_page_t* pages, uint32_t count) {
+  uint64_t best = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    for (uint32_t j = 0; j < pages[i].free_count; j++) {
+      const cj_atlas_box_t* f = &pages[i].free[j];
+      uint32_t w = f->x + f->w > p->width ? (f->x < p->width ? p->width - f->x : 0) : f->w;
+      uint32_t h = f->y + f->h > p->height ? (f->y < p->height ? p->height - f->y : 0) : f->h;
+      uint64_t area = (uint64_t)w * h;
+      if (area > best) best = area;
+    }
+  }
+  return best;
+}
+
+typedef struct cj_atlas_order_t {
+  uint32_t id;
+  uint32_t long_side;
+  uint64_t area;
+} cj_atlas_order_t;
+
+static int packer_order_cmp(const void* a, const void* b) {
+  const cj_atlas_order_t* x = (const cj_atlas_order_t*)a;
+  const cj_atlas_order_t* y = (const cj_atlas_order_t*)b;
+  if (x->long_side != y->long_side) return x->long_side > y->long_side ? -1 : 1;
+  if (x->area != y->area) return x->area > y->area ? -1 : 1;
+  return x->id < y->id ? -1 : (x->id > y->id ? 1 : 0);
+}
+
+static void packer_free_pages(cj_atlas_page_t* pages, uint32_t count) {
+  if (!pages) return;
+  for (uint32_t i = 0; i < count; i++) free(pages[i].free);
+  free(pages);
+}
+
+uint32_t cj_atlas_packer_plan_defragment(cj_atlas_packer_t* p, cj_atlas_move_t** out_moves) {
+  if (out_moves) *out_moves = NULL;
+  if (!p || !out_moves || p->entry_count == 0) return 0;
+
+  for (uint32_t i = 0; i < p->page_count; i++) {
+    if ((p->pages[i].dirty || p->pages[i].loose) && !packer_rebuild_page(p, i)) return 0;
+  }
+  uint64_t largest_before = packer_largest_free(p, p->pages, p->page_count);
+
+  uint32_t count = p->entry_count;
+  cj_atlas_order_t* order = (cj_atlas_order_t*)malloc(sizeof(cj_atlas_order_t) * count);
+  cj_atlas_move_t* moves = (cj_atlas_move_t*)malloc(sizeof(cj_atlas_move_t) * count);
+  cj_atlas_page_t* pages = (cj_atlas_page_t*)calloc(p->page_count, sizeof(cj_atlas_page_t));
+  bool ok = order && moves && pages;
+  for (uint32_t i = 0; ok && i < p->page_count; i++) ok = packer_reset_page(p, &pages[i]);
+
+  // Largest first packs tightest; ties keep id order so repeated runs are stable
+  uint32_t n = 0;
+  for (uint32_t i = 0; ok && i < p->max_entries; i++) {
+    const cj_atlas_slot_t* s = &p->slots[i];
+    if (!s->in_use) continue;
+    order[n].id = i + 1u;
+    order[n].long_side = s->rect.width > s->rect.height ? s->rect.width : s->rect.height;
+    order[n].area = (uint64_t)s->rect.width * s->rect.height;
+    n++;
+  }
+  if (ok) qsort(order, n, sizeof(cj_atlas_order_t), packer_order_cmp);
+
+  for (uint32_t i = 0; ok && i < n; i++) {
+    const cj_atlas_slot_t* s = &p->slots[order[i].id - 1];
+    moves[i].id = order[i].id;
+    moves[i].from = s->rect;
+    ok = packer_allocate(p, pages, p->page_count, s->rect.width, s->rect.height, &moves[i].to);
+  }
+
+  // Only adopt a layout that leaves a bigger hole than the current one
+  if (ok && packer_largest_free(p, pages, p->page_count) <= largest_before) ok = false;
+  free(order);
+  packer_free_pages(pages, p->page_count);
+  if (!ok) {
+    free(moves);
+    return 0;
+  }
+  *out_moves = moves;
+  return n;
+}
+
+void cj_atlas_packer_commit_moves(cj_atlas_packer_t* p, const cj_atlas_move_t* moves, uint32_t count) {
+  if (!p || !moves) return;
+  for (uint32_t i = 0; i < count; i++) {
+    if (packer_slot(p, moves[i].id)) p->slots[moves[i].id - 1].rect = moves[i].to;
+  }
+  // Free lists follow on the next placement
+  for (uint32_t i = 0; i < p->page_count; i++) p->pages[i].dirty = true;
+}
+
+
+void cj_atlas_packer_stats(cj_atlas_packer_t* p, cj_atlas_packer_stats_t* out_stats) {
+  if (!out_stats) return;
+  memset(out_stats, 0, sizeof(*out_stats));
+  if (!p) return;
+
+  for (uint32_t i = 0; i < p->page_count; i++) {
+    if (p->pages[i].dirty || p->pages[i].loose) packer_rebuild_page(p, i);
+  }
+  out_stats->pages = p->page_count;
+  out_stats->entries = p->entry_count;
+  for (uint32_t i = 0; i < p->max_entries; i++) {
+    const cj_atlas_slot_t* s = &p->slots[i];
+    if (s->in_use) out_stats->used_area += (uint64_t)s->rect.width * s->rect.height;
+  }
+  out_stats->free_area = (uint64_t)p->width * p->height * p->page_count - out_stats->used_area;
+  out_stats->largest_free = packer_largest_free(p, p->pages, p->page_count);
+}
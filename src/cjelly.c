@@ -37,10 +37,12 @@
 #include <cjelly/engine_internal.h>
 #include <cjelly/cj_input.h>
 #include <cjelly/bindless_internal.h>
+#include <cjelly/atlas_packer_internal.h>
 #include <cjelly/textured_internal.h>
 #include <cjelly/bindless_state_internal.h>
 #include <cjelly/basic_state_internal.h>
 #include <cjelly/format/image.h>
+#include <cjelly/format/image/bmp.h>
 #include <cjelly/macros.h>
 #ifdef _WIN32
 #include <windows.h>
@@ -82,9 +84,12 @@ static inline VkRenderPass cur_render_pass(void) { cj_engine_t* e = cur_eng(); r
 static inline VkQueue cur_gfx_queue(void) { cj_engine_t* e = cur_eng(); return e ? cj_engine_graphics_queue(e) : VK_NULL_HANDLE; }
 static inline VkQueue cur_present_queue(void) { cj_engine_t* e = cur_eng(); return e ? cj_engine_present_queue(e) : VK_NULL_HANDLE; }
 static inline VkCommandPool cur_cmd_pool(void) { cj_engine_t* e = cur_eng(); return e ? cj_engine_command_pool(e) : VK_NULL_HANDLE; }
+static inline VkPipelineCache cur_pipeline_cache(void) { return cj_engine_pipeline_cache(cur_eng()); }
 static inline CJellyTexturedResources* cur_tx(void) { cj_engine_t* e = cur_eng(); return e ? cj_engine_textured(e) : NULL; }
 static inline CJellyBindlessState* cur_bl(void) { cj_engine_t* e = cur_eng(); return e ? cj_engine_bindless(e) : NULL; }
 static inline CJellyBasicState* cur_basic(void) { cj_engine_t* e = cur_eng(); return e ? cj_engine_basic(e) : NULL; }
+static inline cj_gpu_allocator_t* cur_gpu(void) { cj_engine_t* e = cur_eng(); return e ? cj_engine_gpu_allocator(e) : NULL; }
+static inline cj_upload_queue_t* cur_uploads(void) { cj_engine_t* e = cur_eng(); return e ? cj_engine_uploads(e) : NULL; }
 
 
 // Vertex structure for the square.
@@ -110,7 +115,7 @@ typedef struct VertexBindless {
 // Forward declarations for helper functions still in use:
 void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties, VkBuffer * buffer,
-    VkDeviceMemory * bufferMemory);
+    cj_gpu_alloc_t * bufferAlloc);
 void transitionImageLayout(VkImage image, VkFormat format,
     VkImageLayout oldLayout, VkImageLayout newLayout);
 void createBindlessVertexBuffer(VkDevice device, VkCommandPool commandPool);
@@ -119,27 +124,40 @@ VkShaderModule createShaderModuleFromMemory(VkDevice device, const unsigned char
 
 // Forward declarations/definitions for texture atlas and application
 typedef struct CJellyTextureAtlas {
-  VkImage atlasImage;
-  VkDeviceMemory atlasImageMemory;
-  VkImageView atlasImageView;
+  VkImage atlasImage;               // One array layer per page
+  cj_gpu_alloc_t atlasImageAlloc;
+  VkImageView atlasImageView;       // Page 0; what the bindless descriptor samples
+  VkImageView atlasArrayView;       // Every page, for sampler2DArray consumers
+  VkImageLayout atlasLayout;        // Layout the image rests in between operations
   VkSampler atlasSampler;
+  uint64_t atlasSamplerHandle;      // Reference held on the shared sampler, 0 when borrowed
   VkDescriptorSetLayout bindlessDescriptorSetLayout;
   VkDescriptorPool bindlessDescriptorPool;
   VkDescriptorSet bindlessDescriptorSet;
+  bool descriptorWritten;           // Rewrite the descriptor when the image is replaced
   uint32_t atlasWidth;
   uint32_t atlasHeight;
-  uint32_t nextTextureX;
-  uint32_t nextTextureY;
-  uint32_t currentRowHeight;
+  uint32_t pageCount;
+  uint32_t maxPages;                // Pages the atlas may grow to when full
+  bool evictLRU;                    // Evict least recently used textures when full
+  cj_atlas_packer_t * packer;
   uint32_t textureCount;
-  struct CJellyTextureEntry * entries;
+  struct CJellyTextureEntry * entries;  // Indexed by packer id - 1
   uint32_t maxTextures;
 } CJellyTextureAtlas;
 struct CJellyApplication;
 
+/* Atlas texture ids hold the packer id in the low bits and the entry's
+ * generation above it, so an id kept past a removal or eviction no longer
+ * resolves once the packer hands its slot to another texture. */
+#define CJ_ATLAS_ID_INDEX_BITS 16u
+#define CJ_ATLAS_ID_INDEX_MASK ((1u << CJ_ATLAS_ID_INDEX_BITS) - 1u)
+
 /* Atlas entry type used by bindless UI helpers */
 typedef struct CJellyTextureEntry {
-  uint32_t textureID;
+  uint32_t textureID;               // 0 for an unused entry
+  uint32_t generation;              // Bumped whenever the entry is freed
+  uint32_t page;                    // Array layer of the atlas image
   uint32_t x, y, width, height;
   float uMin, uMax, vMin, vMax;
 } CJellyTextureEntry;
@@ -150,6 +168,22 @@ void cjelly_destroy_texture_atlas(CJellyTextureAtlas * atlas);
 uint32_t cjelly_atlas_add_texture(CJellyTextureAtlas * atlas, const char * filePath);
 void cjelly_atlas_update_descriptor_set(CJellyTextureAtlas * atlas);
 CJellyTextureEntry * cjelly_atlas_get_texture_entry(CJellyTextureAtlas * atlas, uint32_t textureID);
+/* Free a texture's region and ID */
+void cjelly_atlas_remove_texture(CJellyTextureAtlas * atlas, uint32_t textureID);
+/* Mark a texture as drawn; eviction picks the one touched longest ago */
+void cjelly_atlas_touch_texture(CJellyTextureAtlas * atlas, uint32_t textureID);
+/* What a full atlas may do: add pages up to maxPages, then evict LRU textures.
+ * Defaults to one page and no eviction. Entries on pages > 0 need atlasArrayView,
+ * and entries may be evicted or moved, so re-read them before drawing. */
+void cjelly_atlas_set_growth(CJellyTextureAtlas * atlas, uint32_t maxPages, bool evictLRU);
+/* 0 when the free space is one rectangle, towards 1 as it scatters */
+float cjelly_atlas_fragmentation(CJellyTextureAtlas * atlas);
+/* Repack every texture and move them on the GPU; false if nothing improved.
+ * Also run automatically when a texture does not fit but the free area would hold it.
+ * Waits for the graphics queue, so call it between frames. */
+bool cjelly_atlas_defragment(CJellyTextureAtlas * atlas);
+/* Submit queued copies and move every page to SHADER_READ_ONLY; later adds keep that layout */
+void cjelly_atlas_prepare_for_sampling(CJellyTextureAtlas * atlas);
 /* Context variants */
 CJellyTextureAtlas * cjelly_create_texture_atlas_ctx(const CJellyVulkanContext* ctx, uint32_t width, uint32_t height);
 void cjelly_destroy_texture_atlas_ctx(CJellyTextureAtlas * atlas, const CJellyVulkanContext* ctx);
@@ -167,7 +201,18 @@ static void cjelly_atlas_update_descriptor_set_ctx(CJellyTextureAtlas * atlas, c
 /* Public wrappers for runtime.h */
 /* forward declare OS function to avoid implicit warning */
 CJ_API void processWindowEvents(void);
-CJ_API void cj_poll_events(void) { processWindowEvents(); }
+CJ_API void cj_poll_events(void) {
+  processWindowEvents();
+
+  /* The platform only queued input; deliver it now, coalesced, once per poll.
+   * Slots are stable, so a callback destroying any window just empties its slot. */
+  CJellyApplication* app = cjelly_application_get_current();
+  if (!app) return;
+  for (uint32_t i = 0; i < cjelly_application_window_slots(app); i++) {
+    cj_window_t* window = (cj_window_t*)cjelly_application_window_at(app, i, NULL);
+    if (window) cj_window__dispatch_input(window);
+  }
+}
 
 /* Public convenience setter for demo color updates without exposing struct layout */
 CJ_API void cj_bindless_set_color(CJellyBindlessResources* resources, float r, float g, float b, float a) {
@@ -181,7 +226,7 @@ CJ_API void cj_bindless_set_color(CJellyBindlessResources* resources, float r, f
 /* Update vertex colors for a left/right split based on current colorMul:
  * If red>green -> left red, right green; else left green, right red. */
 CJ_API void cj_bindless_update_split_from_colorMul(CJellyBindlessResources* resources) {
-  if (!resources || resources->vertexBufferMemory == VK_NULL_HANDLE) return;
+  if (!resources || !resources->vertexBufferAlloc.mapped) return;
 
   /* Use the actual color from colorMul */
   float r = resources->colorMul[0];
@@ -197,30 +242,13 @@ CJ_API void cj_bindless_update_split_from_colorMul(CJellyBindlessResources* reso
     {{-0.5f,  0.5f}, {r, g, b}, 0},
     {{-0.5f, -0.5f}, {r, g, b}, 0},
   };
-  void* data = NULL;
-  VkDevice dev = cur_device();
-  vkMapMemory(dev, resources->vertexBufferMemory, 0, sizeof(vertices), 0, &data);
-  memcpy(data, vertices, sizeof(vertices));
-  vkUnmapMemory(dev, resources->vertexBufferMemory);
+  memcpy(resources->vertexBufferAlloc.mapped, vertices, sizeof(vertices));
 }
 
 // === Context-based utility functions ===
-static uint32_t findMemoryTypeCtx(const CJellyVulkanContext* ctx, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties memProperties;
-  vkGetPhysicalDeviceMemoryProperties(ctx->physicalDevice, &memProperties);
-  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-    if ((typeFilter & (1 << i)) &&
-        (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-      return i;
-    }
-  }
-  fprintf(stderr, "Failed to find suitable memory type (ctx)!\n");
-  exit(EXIT_FAILURE);
-}
-
 static void createImageCtx(const CJellyVulkanContext* ctx, uint32_t width, uint32_t height, VkFormat format,
     VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties,
-    VkImage * image, VkDeviceMemory * imageMemory) {
+    VkImage * image, cj_gpu_alloc_t * imageAlloc) {
   VkImageCreateInfo imageInfo = {0};
   imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -241,119 +269,18 @@ static void createImageCtx(const CJellyVulkanContext* ctx, uint32_t width, uint3
     exit(EXIT_FAILURE);
   }
 
-  VkMemoryRequirements memRequirements;
-  vkGetImageMemoryRequirements(ctx->device, *image, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryTypeCtx(ctx, memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(ctx->device, &allocInfo, NULL, imageMemory) != VK_SUCCESS) {
+  if (!cj_gpu_alloc_image(cur_gpu(), *image, properties,
+                          tiling == VK_IMAGE_TILING_OPTIMAL ? CJ_GPU_ALLOC_OPTIMAL : 0, imageAlloc)) {
     fprintf(stderr, "Failed to allocate image memory (ctx)\n");
     exit(EXIT_FAILURE);
   }
-
-  vkBindImageMemory(ctx->device, *image, *imageMemory, 0);
 }
 
-static VkCommandBuffer beginSingleTimeCommandsCtx(const CJellyVulkanContext* ctx) {
-  VkCommandBufferAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandPool = ctx->commandPool;
-  allocInfo.commandBufferCount = 1;
-
-  VkCommandBuffer commandBuffer;
-  vkAllocateCommandBuffers(ctx->device, &allocInfo, &commandBuffer);
-
-  VkCommandBufferBeginInfo beginInfo = {0};
-  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-  vkBeginCommandBuffer(commandBuffer, &beginInfo);
-  return commandBuffer;
-}
-
-static void endSingleTimeCommandsCtx(const CJellyVulkanContext* ctx, VkCommandBuffer commandBuffer) {
-  vkEndCommandBuffer(commandBuffer);
-
-  VkSubmitInfo submitInfo = {0};
-  submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-  submitInfo.commandBufferCount = 1;
-  submitInfo.pCommandBuffers = &commandBuffer;
-
-  vkQueueSubmit(ctx->graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(ctx->graphicsQueue);
-
-  vkFreeCommandBuffers(ctx->device, ctx->commandPool, 1, &commandBuffer);
-}
-
-static void transitionImageLayoutCtx(const CJellyVulkanContext* ctx, VkImage image, VkFormat format,
-    VkImageLayout oldLayout, VkImageLayout newLayout) {
-  (void)format;
-  VkCommandBuffer commandBuffer = beginSingleTimeCommandsCtx(ctx);
-
-  VkImageMemoryBarrier barrier = {0};
-  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.oldLayout = oldLayout;
-  barrier.newLayout = newLayout;
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.image = image;
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.baseMipLevel = 0;
-  barrier.subresourceRange.levelCount = 1;
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
-
-  VkPipelineStageFlags sourceStage;
-  VkPipelineStageFlags destinationStage;
-
-  if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-  } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-  } else {
-    fprintf(stderr, "Unsupported layout transition (ctx)!\n");
-    exit(EXIT_FAILURE);
-  }
-
-  vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, 0, 0, NULL, 0, NULL, 1, &barrier);
-
-  endSingleTimeCommandsCtx(ctx, commandBuffer);
-}
-
-static void copyBufferToImageCtx(const CJellyVulkanContext* ctx, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommandsCtx(ctx);
-
-  VkBufferImageCopy region = {0};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
-  region.imageOffset = (VkOffset3D){0, 0, 0};
-  region.imageExtent = (VkExtent3D){width, height, 1};
-
-  vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-  endSingleTimeCommandsCtx(ctx, commandBuffer);
-}
 // Context-friendly vertex buffer creation for bindless vertices
 static void createBindlessVertexBufferCtx(
-    VkDevice device,
     VkCommandPool commandPool,
     VkBuffer* outBuffer,
-    VkDeviceMemory* outMemory) {
+    cj_gpu_alloc_t* outAlloc) {
   (void)commandPool;
   VertexBindless verticesBindless[] = {
     {{-0.5f, -0.5f}, {1.0f, 1.0f, 1.0f}, 1},
@@ -366,11 +293,8 @@ static void createBindlessVertexBufferCtx(
   VkDeviceSize bufferSize = sizeof(verticesBindless);
   createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-               outBuffer, outMemory);
-  void* data = NULL;
-  vkMapMemory(device, *outMemory, 0, bufferSize, 0, &data);
-  memcpy(data, verticesBindless, (size_t)bufferSize);
-  vkUnmapMemory(device, *outMemory);
+               outBuffer, outAlloc);
+  memcpy(outAlloc->mapped, verticesBindless, (size_t)bufferSize);
 }
 
 // Forward decl for context-friendly pipeline helper
@@ -423,9 +347,8 @@ CJellyBindlessResources* cjelly_create_bindless_resources(void) {
     /*DEBUG*/ if(getenv("CJELLY_DEBUG")) fprintf(stderr, "DEBUG: Textures added to atlas\n");
 
     /*DEBUG*/ if(getenv("CJELLY_DEBUG")) fprintf(stderr, "DEBUG: Transition atlas to SHADER_READ_ONLY\n");
-    // Atlas image was created and filled per-texture via copyBufferToImage; ensure final layout
-    transitionImageLayout(atlas->atlasImage, VK_FORMAT_R8G8B8A8_UNORM,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // Atlas pages were filled through the upload queue; ensure final layout
+    cjelly_atlas_prepare_for_sampling(atlas);
     /*DEBUG*/ if(getenv("CJELLY_DEBUG")) fprintf(stderr, "DEBUG: Update descriptor set\n");
     // Update descriptor set
     cjelly_atlas_update_descriptor_set(atlas);
@@ -435,7 +358,7 @@ CJellyBindlessResources* cjelly_create_bindless_resources(void) {
     createBindlessVertexBuffer(cur_device(), cur_cmd_pool());
     CJellyBindlessState* bl = cur_bl();
     resources->vertexBuffer = bl->vertexBuffer;
-    resources->vertexBufferMemory = bl->vertexBufferMemory;
+    resources->vertexBufferAlloc = bl->vertexBufferAlloc;
 
     // Expose atlas via resources only
     resources->textureAtlas = atlas;
@@ -489,21 +412,19 @@ CJ_API CJellyBindlessResources* cjelly_create_bindless_resources_ctx(const CJell
         return NULL;
     }
     // Transition atlas to shader-read after all copies
-    transitionImageLayoutCtx(ctx, atlas->atlasImage, VK_FORMAT_R8G8B8A8_UNORM,
-                              VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    cjelly_atlas_prepare_for_sampling(atlas);
     cjelly_atlas_update_descriptor_set_ctx(atlas, ctx);
 
     // Create vertex buffer into resources using context
-    VkBuffer vb = VK_NULL_HANDLE; VkDeviceMemory vm = VK_NULL_HANDLE;
-    createBindlessVertexBufferCtx(ctx->device, ctx->commandPool, &vb, &vm);
+    VkBuffer vb = VK_NULL_HANDLE; cj_gpu_alloc_t vm = {0};
+    createBindlessVertexBufferCtx(ctx->commandPool, &vb, &vm);
     resources->vertexBuffer = vb;
-    resources->vertexBufferMemory = vm;
+    resources->vertexBufferAlloc = vm;
   /* Optionally mirror into engine bindless state for fallback paths */
   CJellyBindlessState* blm = cur_bl();
   if (blm && blm->vertexBuffer == VK_NULL_HANDLE) {
     blm->vertexBuffer = vb;
-    blm->vertexBufferMemory = vm;
+    blm->vertexBufferAlloc = vm;
   }
 
     // Create pipeline using the atlas' descriptor set layout (context-friendly)
@@ -538,14 +459,10 @@ void cjelly_destroy_bindless_resources(CJellyBindlessResources* resources) {
     vkDestroyPipelineLayout(cur_device(), resources->pipelineLayout, NULL);
     resources->pipelineLayout = VK_NULL_HANDLE;
   }
+  /* The vertex buffer may be the engine's shared bindless quad */
   CJellyBindlessState* bl = cur_bl();
   if (resources->vertexBuffer != VK_NULL_HANDLE && (!bl || resources->vertexBuffer != bl->vertexBuffer)) {
-    vkDestroyBuffer(cur_device(), resources->vertexBuffer, NULL);
-    resources->vertexBuffer = VK_NULL_HANDLE;
-  }
-  if (resources->vertexBufferMemory != VK_NULL_HANDLE && (!bl || resources->vertexBufferMemory != bl->vertexBufferMemory)) {
-    vkFreeMemory(cur_device(), resources->vertexBufferMemory, NULL);
-    resources->vertexBufferMemory = VK_NULL_HANDLE;
+    cj_gpu_destroy_buffer(cur_gpu(), &resources->vertexBuffer, &resources->vertexBufferAlloc);
   }
 
     if (resources->textureAtlas) {
@@ -573,11 +490,8 @@ CJellyBindlessResources* cjelly_create_bindless_color_square_resources(void) {
     VkDeviceSize vbSize = sizeof(verticesBindless);
     createBuffer(vbSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 &resources->vertexBuffer, &resources->vertexBufferMemory);
-    void* vdata = NULL;
-    vkMapMemory(cur_device(), resources->vertexBufferMemory, 0, vbSize, 0, &vdata);
-    memcpy(vdata, verticesBindless, (size_t)vbSize);
-    vkUnmapMemory(cur_device(), resources->vertexBufferMemory);
+                 &resources->vertexBuffer, &resources->vertexBufferAlloc);
+    memcpy(resources->vertexBufferAlloc.mapped, verticesBindless, (size_t)vbSize);
 
     // Prefer using the existing atlas descriptor set layout if available for layout compatibility
     VkDescriptorSetLayout tempSetLayout = VK_NULL_HANDLE;
@@ -673,7 +587,7 @@ CJellyBindlessResources* cjelly_create_bindless_color_square_resources(void) {
     gp.stageCount = 2; gp.pStages = stages;
     gp.pVertexInputState = &vi; gp.pInputAssemblyState = &ia; gp.pViewportState = &vps; gp.pRasterizationState = &rs; gp.pMultisampleState = &ms; gp.pColorBlendState = &cb;
     gp.layout = resources->pipelineLayout; gp.renderPass = cur_render_pass(); gp.subpass = 0;
-    if (vkCreateGraphicsPipelines(cur_device(), VK_NULL_HANDLE, 1, &gp, NULL, &resources->pipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(cur_device(), cur_pipeline_cache(), 1, &gp, NULL, &resources->pipeline) != VK_SUCCESS) {
         vkDestroyPipelineLayout(cur_device(), resources->pipelineLayout, NULL);
         vkDestroyShaderModule(cur_device(), vert, NULL);
         vkDestroyShaderModule(cur_device(), frag, NULL);
@@ -707,11 +621,8 @@ CJ_API CJellyBindlessResources* cjelly_create_bindless_color_square_resources_ct
     VkDeviceSize vbSize = sizeof(verticesBindless);
     createBuffer(vbSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 &resources->vertexBuffer, &resources->vertexBufferMemory);
-    void* vdata = NULL;
-    vkMapMemory(ctx->device, resources->vertexBufferMemory, 0, vbSize, 0, &vdata);
-    memcpy(vdata, verticesBindless, (size_t)vbSize);
-    vkUnmapMemory(ctx->device, resources->vertexBufferMemory);
+                 &resources->vertexBuffer, &resources->vertexBufferAlloc);
+    memcpy(resources->vertexBufferAlloc.mapped, verticesBindless, (size_t)vbSize);
 
     VkPipelineLayout outLayout = VK_NULL_HANDLE;
     VkPipeline outPipeline = VK_NULL_HANDLE;
@@ -729,7 +640,7 @@ CJ_API CJellyBindlessResources* cjelly_create_bindless_color_square_resources_ct
     pli.pPushConstantRanges = &pushRange;
     if (vkCreatePipelineLayout(ctx->device, &pli, NULL, &outLayout) != VK_SUCCESS) {
         vkDestroyBuffer(ctx->device, resources->vertexBuffer, NULL);
-        vkFreeMemory(ctx->device, resources->vertexBufferMemory, NULL);
+        cj_gpu_free(cur_gpu(), &resources->vertexBufferAlloc);
         free(resources);
         return NULL;
     }
@@ -740,7 +651,7 @@ CJ_API CJellyBindlessResources* cjelly_create_bindless_color_square_resources_ct
     if (vert == VK_NULL_HANDLE || frag == VK_NULL_HANDLE) {
         vkDestroyPipelineLayout(ctx->device, outLayout, NULL);
         vkDestroyBuffer(ctx->device, resources->vertexBuffer, NULL);
-        vkFreeMemory(ctx->device, resources->vertexBufferMemory, NULL);
+        cj_gpu_free(cur_gpu(), &resources->vertexBufferAlloc);
         free(resources);
         return NULL;
     }
@@ -791,12 +702,12 @@ CJ_API CJellyBindlessResources* cjelly_create_bindless_color_square_resources_ct
     gp.stageCount = 2; gp.pStages = stages;
     gp.pVertexInputState = &vi; gp.pInputAssemblyState = &ia; gp.pViewportState = &vps; gp.pRasterizationState = &rs; gp.pMultisampleState = &ms; gp.pColorBlendState = &cb;
     gp.layout = outLayout; gp.renderPass = ctx->renderPass; gp.subpass = 0;
-    if (vkCreateGraphicsPipelines(ctx->device, VK_NULL_HANDLE, 1, &gp, NULL, &outPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(ctx->device, cur_pipeline_cache(), 1, &gp, NULL, &outPipeline) != VK_SUCCESS) {
         vkDestroyPipelineLayout(ctx->device, outLayout, NULL);
         vkDestroyShaderModule(ctx->device, vert, NULL);
         vkDestroyShaderModule(ctx->device, frag, NULL);
         vkDestroyBuffer(ctx->device, resources->vertexBuffer, NULL);
-        vkFreeMemory(ctx->device, resources->vertexBufferMemory, NULL);
+        cj_gpu_free(cur_gpu(), &resources->vertexBufferAlloc);
         free(resources);
         return NULL;
     }
@@ -813,7 +724,7 @@ CJ_API CJellyBindlessResources* cjelly_create_bindless_color_square_resources_ct
 void createImage(uint32_t width, uint32_t height, VkFormat format,
     VkImageTiling tiling, VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties, VkImage * image,
-    VkDeviceMemory * imageMemory);
+    cj_gpu_alloc_t * imageAlloc);
 VkCommandBuffer beginSingleTimeCommands(void);
 void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 void transitionImageLayout(VkImage image, VkFormat format,
@@ -845,22 +756,6 @@ VkShaderModule createShaderModuleFromMemory(
 }
 
 
-// Finds a suitable memory type based on typeFilter and desired properties.
-uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties memProperties;
-  vkGetPhysicalDeviceMemoryProperties(cj_engine_physical_device(cur_eng()), &memProperties);
-  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-    if ((typeFilter & (1 << i)) &&
-        (memProperties.memoryTypes[i].propertyFlags & properties) ==
-            properties) {
-      return i;
-    }
-  }
-  fprintf(stderr, "Failed to find suitable memory type!\n");
-  exit(EXIT_FAILURE);
-}
-
-
 // Debug callback function for validation layers.
 VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
     GCJ_MAYBE_UNUSED(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity),
@@ -1075,6 +970,9 @@ CJ_API void processWindowEvents() {
       }
     }
 
+    /* Monitor layout changes are applied once the queue is drained */
+    if (cj_window__handle_randr_event_linux(display, &event)) continue;
+
     if (event.type == ClientMessage) {
       Atom wmDelete = XInternAtom(display, "WM_DELETE_WINDOW", False);
       if ((Atom)event.xclient.data.l[0] == wmDelete) {
@@ -1708,6 +1606,23 @@ CJ_API void processWindowEvents() {
       }
     }
   }
+
+  /* Monitor layout changed: re-resolve every window's DPI against the rebuilt table */
+  if (cj_window__refresh_monitors_linux(display)) {
+    CJellyApplication* app = cjelly_application_get_current();
+    Window root = RootWindow(display, DefaultScreen(display));
+    for (uint32_t i = 0; app && i < cjelly_application_window_slots(app); i++) {
+      cj_window_t* window = (cj_window_t*)cjelly_application_window_at(app, i, NULL);
+      if (!window) continue;
+      int32_t x, y;
+      cj_window__get_position(window, &x, &y);
+      float new_scale = cj_window__get_dpi_scale_linux(display, root, x, y);
+      if (fabsf(new_scale - cj_window__get_dpi_scale(window)) > 0.01f) {
+        cj_window__set_dpi_scale(window, new_scale);
+        cj_window__mark_swapchain_for_recreation(window);
+      }
+    }
+  }
 }
 
 #endif
@@ -1974,7 +1889,7 @@ void createTexturedGraphicsPipeline() {
   pipelineInfo.renderPass = cur_render_pass();
   pipelineInfo.subpass = 0;
 
-  if (vkCreateGraphicsPipelines(cur_device(), VK_NULL_HANDLE, 1, &pipelineInfo, NULL,
+  if (vkCreateGraphicsPipelines(cur_device(), cur_pipeline_cache(), 1, &pipelineInfo, NULL,
           &tx6->pipeline) != VK_SUCCESS) {
     fprintf(stderr, "Failed to create textured graphics pipeline\n");
     exit(EXIT_FAILURE);
@@ -2078,7 +1993,7 @@ static void createTexturedGraphicsPipelineCtx(const CJellyVulkanContext* ctx) {
   pipelineInfo.layout = tx7->pipelineLayout;
   pipelineInfo.renderPass = ctx->renderPass;
   pipelineInfo.subpass = 0;
-  if (vkCreateGraphicsPipelines(ctx->device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, &tx7->pipeline) != VK_SUCCESS) {
+  if (vkCreateGraphicsPipelines(ctx->device, cur_pipeline_cache(), 1, &pipelineInfo, NULL, &tx7->pipeline) != VK_SUCCESS) {
     fprintf(stderr, "Failed to create textured graphics pipeline (ctx)\n");
     exit(EXIT_FAILURE);
   }
@@ -2240,7 +2155,7 @@ void createBindlessGraphicsPipeline(VkDevice device __attribute__((unused)), VkR
   pipelineInfo.subpass = 0;
   pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-  if (vkCreateGraphicsPipelines(cur_device(), VK_NULL_HANDLE, 1, &pipelineInfo, NULL,
+  if (vkCreateGraphicsPipelines(cur_device(), cur_pipeline_cache(), 1, &pipelineInfo, NULL,
           &bl->pipeline) != VK_SUCCESS) {
     fprintf(stderr, "Failed to create bindless graphics pipeline\n");
     exit(EXIT_FAILURE);
@@ -2364,7 +2279,7 @@ static VkResult createBindlessGraphicsPipelineWithLayout(
   pipelineInfo.renderPass = renderPass;
   pipelineInfo.subpass = 0;
 
-  VkResult res = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, NULL, outPipeline);
+  VkResult res = vkCreateGraphicsPipelines(device, cur_pipeline_cache(), 1, &pipelineInfo, NULL, outPipeline);
   vkDestroyShaderModule(device, vertShaderModule, NULL);
   vkDestroyShaderModule(device, fragShaderModule, NULL);
   return res;
@@ -2372,79 +2287,54 @@ static VkResult createBindlessGraphicsPipelineWithLayout(
 
 /// Creates a texture image from a BMP file.
 static void createTextureImageCtx(const CJellyVulkanContext* ctx, const char * filePath) {
-  // Load BMP data (assumed to be in 24-bit RGB format)
-  CJellyFormatImage * image;
-  CJellyFormatImageError error = cjelly_format_image_load(filePath, &image);
+  // Map the file and parse it in place.
+  CJellyFormatImageMapping file;
+  CJellyFormatImageBMPInfo bmp;
+  CJellyFormatImageError error = cjelly_format_image_map(filePath, &file);
+  if (error == CJELLY_FORMAT_IMAGE_SUCCESS) {
+    error = cjelly_format_image_bmp_parse(file.data, file.size, &bmp);
+  }
   if (error != CJELLY_FORMAT_IMAGE_SUCCESS) {
     fprintf(stderr, "Failed to load BMP file: %s\n", filePath);
     fprintf(stderr, "Error: %s\n", cjelly_format_image_strerror(error));
     exit(EXIT_FAILURE);
   }
 
-  // Convert RGB to RGBA.
-  int texWidth = image->raw->width;
-  int texHeight = image->raw->height;
-  unsigned char * pixelsRGB = image->raw->data;
-  if (!pixelsRGB) {
-    fprintf(stderr, "Failed to load BMP file: %s\n", filePath);
-    exit(EXIT_FAILURE);
-  }
-
-  // Convert RGB to RGBA.
-  size_t pixelCount = texWidth * texHeight;
-  size_t rgbaImageSize = pixelCount * 4; // 4 bytes per pixel.
-  unsigned char * pixels = malloc(rgbaImageSize);
+  // Top-down 32-bit bitmaps are already BGRA, so they are uploaded as is
+  // to a BGRA image. Everything else is decoded to RGBA.
+  const unsigned char * bgra = cjelly_format_image_bmp_bgra_pixels(&bmp);
+  CJellyTexturedResources* tx = cur_tx();
+  tx->imageFormat = bgra ? VK_FORMAT_B8G8R8A8_UNORM : VK_FORMAT_R8G8B8A8_UNORM;
+  createImageCtx(ctx, bmp.width, bmp.height, tx->imageFormat,
+      VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &tx->image, &tx->imageAlloc);
+
+  // The texels are written straight into the staging ring; the copy and both
+  // layout transitions go out with the next batch of uploads.
+  cj_upload_image_t dst = {0};
+  dst.image = tx->image;
+  dst.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+  dst.new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  dst.extent = (VkExtent3D){(uint32_t)bmp.width, (uint32_t)bmp.height, 1};
+  dst.texel_size = 4;
+  unsigned char * pixels = (unsigned char *)cj_upload_queue_stage_image(cur_uploads(), &dst, NULL);
   if (!pixels) {
-    fprintf(stderr, "Failed to allocate memory for RGBA image\n");
+    fprintf(stderr, "Failed to stage texture upload: %s\n", filePath);
     exit(EXIT_FAILURE);
   }
-  for (size_t i = 0; i < pixelCount; ++i) {
-    pixels[i * 4 + 0] = pixelsRGB[i * 3 + 0];
-    pixels[i * 4 + 1] = pixelsRGB[i * 3 + 1];
-    pixels[i * 4 + 2] = pixelsRGB[i * 3 + 2];
-    pixels[i * 4 + 3] = 255; // Fully opaque.
+  size_t rowBytes = (size_t)bmp.width * 4;
+  if (bgra) {
+    memcpy(pixels, bgra, rowBytes * (size_t)bmp.height);
   }
-
-  // Clean up the original RGB image.
-  cjelly_format_image_free(image);
-
-  VkDeviceSize bufferSize = rgbaImageSize;
-
-  // Create a staging buffer to hold the pixel data.
-  VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
-  createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-      &stagingBuffer, &stagingBufferMemory);
-
-  // Map memory and copy the pixel data.
-  void * data;
-  vkMapMemory(ctx->device, stagingBufferMemory, 0, bufferSize, 0, &data);
-  memcpy(data, pixels, (size_t)bufferSize);
-  vkUnmapMemory(ctx->device, stagingBufferMemory);
-  free(pixels);
-
-  // Create the Vulkan texture image.
-  // We choose VK_FORMAT_R8G8B8A8_UNORM for the RGBA data.
-  CJellyTexturedResources* tx = cur_tx();
-  createImageCtx(ctx, texWidth, texHeight, VK_FORMAT_R8G8B8A8_UNORM,
-      VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &tx->image, &tx->imageMemory);
-
-  // Transition image layout to prepare for the data copy.
-  transitionImageLayoutCtx(ctx, tx->image, VK_FORMAT_R8G8B8A8_UNORM,
-      VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-  // Copy the pixel data from the staging buffer into the texture image.
-  copyBufferToImageCtx(ctx, stagingBuffer, tx->image, texWidth, texHeight);
-
-  // Transition the image layout for shader access.
-  transitionImageLayoutCtx(ctx, tx->image, VK_FORMAT_R8G8B8A8_UNORM,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-  vkDestroyBuffer(ctx->device, stagingBuffer, NULL);
-  vkFreeMemory(ctx->device, stagingBufferMemory, NULL);
+  else {
+    error = cjelly_format_image_bmp_decode(&bmp, pixels, rowBytes);
+    if (error != CJELLY_FORMAT_IMAGE_SUCCESS) {
+      fprintf(stderr, "Failed to decode BMP file: %s\n", filePath);
+      fprintf(stderr, "Error: %s\n", cjelly_format_image_strerror(error));
+      exit(EXIT_FAILURE);
+    }
+  }
+  cjelly_format_image_unmap(&file);
 }
 
 /// Creates an image view for the texture image.
@@ -2454,7 +2344,7 @@ static void createTextureImageViewCtx(const CJellyVulkanContext* ctx) {
   CJellyTexturedResources* tx = cur_tx();
   viewInfo.image = tx->image;
   viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-  viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+  viewInfo.format = tx->imageFormat;
   viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
   viewInfo.subresourceRange.baseMipLevel = 0;
   viewInfo.subresourceRange.levelCount = 1;
@@ -2468,34 +2358,18 @@ static void createTextureImageViewCtx(const CJellyVulkanContext* ctx) {
   }
 }
 
-/// Creates a texture sampler.
-static void createTextureSamplerCtx(const CJellyVulkanContext* ctx) {
-  VkSamplerCreateInfo samplerInfo = {0};
-  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-  samplerInfo.magFilter = VK_FILTER_LINEAR;
-  samplerInfo.minFilter = VK_FILTER_LINEAR;
-
-  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-
-  samplerInfo.anisotropyEnable = VK_FALSE;
-  samplerInfo.maxAnisotropy = 1;
-
-  samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-  samplerInfo.unnormalizedCoordinates = VK_FALSE;
-
-  samplerInfo.compareEnable = VK_FALSE;
-  samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-
-  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  samplerInfo.mipLodBias = 0.0f;
-  samplerInfo.minLod = 0.0f;
-  samplerInfo.maxLod = 0.0f;
+/// Acquires the engine's shared linear, repeating sampler for the texture.
+static void createTextureSamplerCtx(GCJ_MAYBE_UNUSED(const CJellyVulkanContext* ctx)) {
+  cj_sampler_desc_t desc = {0};
+  desc.min_filter = CJ_FILTER_LINEAR;
+  desc.mag_filter = CJ_FILTER_LINEAR;
+  desc.address_u = CJ_ADDRESS_REPEAT;
+  desc.address_v = CJ_ADDRESS_REPEAT;
+  desc.address_w = CJ_ADDRESS_REPEAT;
 
   CJellyTexturedResources* tx2 = cur_tx();
-  if (vkCreateSampler(ctx->device, &samplerInfo, NULL, &tx2->sampler) !=
-      VK_SUCCESS) {
+  tx2->samplerHandle = cj_engine_acquire_sampler(cur_eng(), &desc, &tx2->sampler);
+  if (tx2->samplerHandle == 0) {
     fprintf(stderr, "Failed to create texture sampler\n");
     exit(EXIT_FAILURE);
   }
@@ -2524,39 +2398,17 @@ static void updateTextureDescriptorSetCtx(const CJellyVulkanContext* ctx, VkDesc
 
 void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties, VkBuffer * buffer,
-    VkDeviceMemory * bufferMemory) {
-  VkBufferCreateInfo bufferInfo = {0};
-  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  bufferInfo.size = size;
-  bufferInfo.usage = usage;
-  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-  if (vkCreateBuffer(cur_device(), &bufferInfo, NULL, buffer) != VK_SUCCESS) {
+    cj_gpu_alloc_t * bufferAlloc) {
+  if (!cj_gpu_create_buffer(cur_gpu(), size, usage, properties, 0, buffer, bufferAlloc)) {
     fprintf(stderr, "Failed to create buffer\n");
     exit(EXIT_FAILURE);
   }
-
-  VkMemoryRequirements memRequirements;
-  vkGetBufferMemoryRequirements(cur_device(), *buffer, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex =
-      findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(cur_device(), &allocInfo, NULL, bufferMemory) != VK_SUCCESS) {
-    fprintf(stderr, "Failed to allocate buffer memory\n");
-    exit(EXIT_FAILURE);
-  }
-
-  vkBindBufferMemory(cur_device(), *buffer, *bufferMemory, 0);
 }
 
 void createImage(uint32_t width, uint32_t height, VkFormat format,
     VkImageTiling tiling, VkImageUsageFlags usage,
     VkMemoryPropertyFlags properties, VkImage * image,
-    VkDeviceMemory * imageMemory) {
+    cj_gpu_alloc_t * imageAlloc) {
   VkImageCreateInfo imageInfo = {0};
   imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -2577,21 +2429,11 @@ void createImage(uint32_t width, uint32_t height, VkFormat format,
     exit(EXIT_FAILURE);
   }
 
-  VkMemoryRequirements memRequirements;
-  vkGetImageMemoryRequirements(cur_device(), *image, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex =
-      findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(cur_device(), &allocInfo, NULL, imageMemory) != VK_SUCCESS) {
+  if (!cj_gpu_alloc_image(cur_gpu(), *image, properties,
+                          tiling == VK_IMAGE_TILING_OPTIMAL ? CJ_GPU_ALLOC_OPTIMAL : 0, imageAlloc)) {
     fprintf(stderr, "Failed to allocate image memory\n");
     exit(EXIT_FAILURE);
   }
-
-  vkBindImageMemory(cur_device(), *image, *imageMemory, 0);
 }
 
 VkCommandBuffer beginSingleTimeCommands(void) {
@@ -2620,6 +2462,8 @@ void endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
+  // Queued uploads come first so immediate commands see their results.
+  cj_upload_queue_flush(cur_uploads());
   vkQueueSubmit(cur_gfx_queue(), 1, &submitInfo, VK_NULL_HANDLE);
   vkQueueWaitIdle(cur_gfx_queue());
 
@@ -2713,42 +2557,15 @@ void createTexturedVertexBuffer() {
 
   VkDeviceSize bufferSize = sizeof(verticesTextured);
 
-  VkBufferCreateInfo bufferInfo = {0};
-  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  bufferInfo.size = bufferSize;
-  bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
   CJellyTexturedResources* txV = cur_tx();
-  if (vkCreateBuffer(cur_device(), &bufferInfo, NULL, &txV->vertexBuffer) !=
-      VK_SUCCESS) {
+  if (!cj_gpu_create_buffer(cur_gpu(), bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+          CJ_GPU_ALLOC_LINEAR, &txV->vertexBuffer, &txV->vertexBufferAlloc)) {
     fprintf(stderr, "Failed to create textured vertex buffer\n");
     exit(EXIT_FAILURE);
   }
 
-  VkMemoryRequirements memRequirements;
-  vkGetBufferMemoryRequirements(cur_device(), txV->vertexBuffer, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits,
-      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-  if (vkAllocateMemory(cur_device(), &allocInfo, NULL, &txV->vertexBufferMemory) !=
-      VK_SUCCESS) {
-    fprintf(stderr, "Failed to allocate textured vertex buffer memory\n");
-    exit(EXIT_FAILURE);
-  }
-
-  vkBindBufferMemory(
-      cur_device(), txV->vertexBuffer, txV->vertexBufferMemory, 0);
-
-  void * data;
-  vkMapMemory(cur_device(), txV->vertexBufferMemory, 0, bufferSize, 0, &data);
-  memcpy(data, verticesTextured, (size_t)bufferSize);
-  vkUnmapMemory(cur_device(), txV->vertexBufferMemory);
+  memcpy(txV->vertexBufferAlloc.mapped, verticesTextured, (size_t)bufferSize);
 }
 
 /* Context-based textured command buffers for a window */
@@ -2770,12 +2587,9 @@ void createBindlessVertexBuffer(VkDevice device __attribute__((unused)), VkComma
   CJellyBindlessState* bl = cur_bl();
   createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-               &bl->vertexBuffer, &bl->vertexBufferMemory);
+               &bl->vertexBuffer, &bl->vertexBufferAlloc);
 
-  void * data;
-  vkMapMemory(cur_device(), bl->vertexBufferMemory, 0, bufferSize, 0, &data);
-  memcpy(data, verticesBindless, (size_t)bufferSize);
-  vkUnmapMemory(cur_device(), bl->vertexBufferMemory);
+  memcpy(bl->vertexBufferAlloc.mapped, verticesBindless, (size_t)bufferSize);
 }
 
 //
@@ -2789,45 +2603,84 @@ void createBindlessVertexBuffer(VkDevice device __attribute__((unused)), VkComma
 //
 
 
-CJellyTextureAtlas * cjelly_create_texture_atlas(uint32_t width, uint32_t height) {
-  CJellyTextureAtlas * atlas = malloc(sizeof(CJellyTextureAtlas));
-  if (!atlas) {
-    fprintf(stderr, "Failed to allocate memory for texture atlas\n");
-    return NULL;
+/// Stage and access masks for how the atlas is used in a layout.
+static void atlasLayoutScope(VkImageLayout layout, VkPipelineStageFlags * stage, VkAccessFlags * access) {
+  switch (layout) {
+    case VK_IMAGE_LAYOUT_UNDEFINED:
+      *stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+      *access = 0;
+      break;
+    case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      *access = VK_ACCESS_TRANSFER_READ_BIT;
+      break;
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      *access = VK_ACCESS_TRANSFER_WRITE_BIT;
+      break;
+    default:
+      *stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+      *access = VK_ACCESS_SHADER_READ_BIT;
+      break;
   }
+}
 
-  memset(atlas, 0, sizeof(CJellyTextureAtlas));
-  atlas->atlasWidth = width;
-  atlas->atlasHeight = height;
-  atlas->nextTextureX = 0;
-  atlas->nextTextureY = 0;
-  atlas->currentRowHeight = 0;
-  atlas->textureCount = 0;
+/// Records a layout transition of every page of an atlas image.
+static void atlasBarrier(VkCommandBuffer cmd, VkImage image, uint32_t pages,
+    VkImageLayout oldLayout, VkImageLayout newLayout) {
+  VkImageMemoryBarrier barrier = {0};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.oldLayout = oldLayout;
+  barrier.newLayout = newLayout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.levelCount = 1;
+  barrier.subresourceRange.layerCount = pages;
 
-  // Allocate memory for texture entries (per-atlas)
-  atlas->maxTextures = 1024;
-  atlas->entries = malloc(sizeof(CJellyTextureEntry) * atlas->maxTextures);
-  if (!atlas->entries) {
-    fprintf(stderr, "Failed to allocate memory for texture entries\n");
-    free(atlas);
-    return NULL;
-  }
-  memset(atlas->entries, 0, sizeof(CJellyTextureEntry) * atlas->maxTextures);
+  VkPipelineStageFlags srcStage, dstStage;
+  atlasLayoutScope(oldLayout, &srcStage, &barrier.srcAccessMask);
+  atlasLayoutScope(newLayout, &dstStage, &barrier.dstAccessMask);
+  vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
 
-  // Create the atlas image
-  createImage(width, height, VK_FORMAT_R8G8B8A8_UNORM,
-              VK_IMAGE_TILING_OPTIMAL,
-              VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-              &atlas->atlasImage, &atlas->atlasImageMemory);
-  // Transition to TRANSFER_DST for subsequent copies
-  transitionImageLayout(atlas->atlasImage, VK_FORMAT_R8G8B8A8_UNORM,
-                        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+/// Creates an atlas image with the given number of pages (array layers),
+/// a view of page 0 and a view of every page. The image starts UNDEFINED.
+static bool atlasCreateImage(uint32_t width, uint32_t height, uint32_t pages, VkImage * image,
+    cj_gpu_alloc_t * imageAlloc, VkImageView * pageView, VkImageView * arrayView) {
+  VkImageCreateInfo imageInfo = {0};
+  imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.imageType = VK_IMAGE_TYPE_2D;
+  imageInfo.extent.width = width;
+  imageInfo.extent.height = height;
+  imageInfo.extent.depth = 1;
+  imageInfo.mipLevels = 1;
+  imageInfo.arrayLayers = pages;
+  imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+  imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+  imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+  // Transfer source so pages can be copied when the atlas grows or is defragmented
+  imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+  imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+  *image = VK_NULL_HANDLE;
+  *pageView = VK_NULL_HANDLE;
+  *arrayView = VK_NULL_HANDLE;
+  if (vkCreateImage(cur_device(), &imageInfo, NULL, image) != VK_SUCCESS) {
+    fprintf(stderr, "Failed to create atlas image\n");
+    *image = VK_NULL_HANDLE;
+    return false;
+  }
+  if (!cj_gpu_alloc_image(cur_gpu(), *image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, CJ_GPU_ALLOC_OPTIMAL, imageAlloc)) {
+    fprintf(stderr, "Failed to allocate atlas image memory\n");
+    goto ERROR_CLEANUP;
+  }
 
-  // Create image view
   VkImageViewCreateInfo viewInfo = {0};
   viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-  viewInfo.image = atlas->atlasImage;
+  viewInfo.image = *image;
   viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
   viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
   viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -2839,164 +2692,109 @@ CJellyTextureAtlas * cjelly_create_texture_atlas(uint32_t width, uint32_t height
   viewInfo.subresourceRange.levelCount = 1;
   viewInfo.subresourceRange.baseArrayLayer = 0;
   viewInfo.subresourceRange.layerCount = 1;
-
-  if (vkCreateImageView(cur_device(), &viewInfo, NULL, &atlas->atlasImageView) != VK_SUCCESS) {
+  if (vkCreateImageView(cur_device(), &viewInfo, NULL, pageView) != VK_SUCCESS) {
     fprintf(stderr, "Failed to create atlas image view\n");
-    vkDestroyImage(cur_device(), atlas->atlasImage, NULL);
-    vkFreeMemory(cur_device(), atlas->atlasImageMemory, NULL);
-    free(atlas->entries);
-    free(atlas);
-    return NULL;
+    *pageView = VK_NULL_HANDLE;
+    goto ERROR_CLEANUP;
   }
 
-  // Create sampler (reuse textured resources' sampler)
-  {
-    CJellyTexturedResources* tx = cur_tx();
-    atlas->atlasSampler = tx ? tx->sampler : VK_NULL_HANDLE;
+  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+  viewInfo.subresourceRange.layerCount = pages;
+  if (vkCreateImageView(cur_device(), &viewInfo, NULL, arrayView) != VK_SUCCESS) {
+    fprintf(stderr, "Failed to create atlas array view\n");
+    *arrayView = VK_NULL_HANDLE;
+    goto ERROR_CLEANUP;
   }
+  return true;
 
-  // Create descriptor set layout (single combined sampler)
-  atlas->bindlessDescriptorSetLayout = cj_engine_bindless_layout(cur_eng());
-
-  // Create descriptor pool
-  atlas->bindlessDescriptorPool = cj_engine_bindless_pool(cur_eng());
-
-  // Allocate descriptor set
-  VkDescriptorSetAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-  allocInfo.descriptorPool = cj_engine_bindless_pool(cur_eng());
-  allocInfo.descriptorSetCount = 1;
-  allocInfo.pSetLayouts = &atlas->bindlessDescriptorSetLayout;
-  allocInfo.pNext = NULL;
-
-  if (vkAllocateDescriptorSets(cur_device(), &allocInfo, &atlas->bindlessDescriptorSet) != VK_SUCCESS) {
-    fprintf(stderr, "Failed to allocate bindless descriptor set\n");
-    vkDestroyDescriptorPool(cur_device(), atlas->bindlessDescriptorPool, NULL);
-    vkDestroyDescriptorSetLayout(cur_device(), atlas->bindlessDescriptorSetLayout, NULL);
-    vkDestroyImageView(cur_device(), atlas->atlasImageView, NULL);
-    vkDestroyImage(cur_device(), atlas->atlasImage, NULL);
-    vkFreeMemory(cur_device(), atlas->atlasImageMemory, NULL);
-    free(atlas->entries);
-    free(atlas);
-    return NULL;
-  }
+ERROR_CLEANUP:
+  if (*pageView != VK_NULL_HANDLE) vkDestroyImageView(cur_device(), *pageView, NULL);
+  vkDestroyImage(cur_device(), *image, NULL);
+  cj_gpu_free(cur_gpu(), imageAlloc);
+  *image = VK_NULL_HANDLE;
+  *pageView = VK_NULL_HANDLE;
+  return false;
+}
 
-  return atlas;
+/// Queues the image and its views for deletion once frames in flight that
+/// sample the atlas have finished.
+static void atlasDestroyImage(CJellyTextureAtlas * atlas) {
+  cj_upload_queue_discard_image(cur_uploads(), atlas->atlasImage);
+  cj_engine_garbage_t arrayView = {0};
+  arrayView.view = atlas->atlasArrayView;
+  cj_engine_retire(cur_eng(), &arrayView);
+  cj_engine_garbage_t image = {0};
+  image.view = atlas->atlasImageView;
+  image.image = atlas->atlasImage;
+  image.alloc = atlas->atlasImageAlloc;
+  cj_engine_retire(cur_eng(), &image);
+  memset(&atlas->atlasImageAlloc, 0, sizeof(atlas->atlasImageAlloc));
+  atlas->atlasArrayView = VK_NULL_HANDLE;
+  atlas->atlasImageView = VK_NULL_HANDLE;
+  atlas->atlasImage = VK_NULL_HANDLE;
 }
 
-// Context-based atlas creation (uses context device instead of global)
-CJellyTextureAtlas * cjelly_create_texture_atlas_ctx(const CJellyVulkanContext* ctx, uint32_t width, uint32_t height) {
-  CJellyTextureAtlas * atlas = malloc(sizeof(CJellyTextureAtlas));
+/// Allocates an atlas with an empty one-page image in TRANSFER_DST_OPTIMAL.
+/// Samplers and descriptor sets are up to the caller.
+static CJellyTextureAtlas * atlasCreate(uint32_t width, uint32_t height) {
+  CJellyTextureAtlas * atlas = calloc(1, sizeof(CJellyTextureAtlas));
   if (!atlas) {
     fprintf(stderr, "Failed to allocate memory for texture atlas\n");
     return NULL;
   }
 
-  memset(atlas, 0, sizeof(CJellyTextureAtlas));
   atlas->atlasWidth = width;
   atlas->atlasHeight = height;
-  atlas->nextTextureX = 0;
-  atlas->nextTextureY = 0;
-  atlas->currentRowHeight = 0;
+  atlas->pageCount = 1;
+  atlas->maxPages = 1;
   atlas->textureCount = 0;
 
   // Allocate memory for texture entries (per-atlas)
   atlas->maxTextures = 1024;
-  atlas->entries = malloc(sizeof(CJellyTextureEntry) * atlas->maxTextures);
-  if (!atlas->entries) {
+  atlas->entries = calloc(atlas->maxTextures, sizeof(CJellyTextureEntry));
+  // One texel of padding keeps linear filtering from bleeding between neighbors
+  atlas->packer = cj_atlas_packer_create(width, height, 1, atlas->maxTextures);
+  if (!atlas->entries || !atlas->packer) {
     fprintf(stderr, "Failed to allocate memory for texture entries\n");
-    free(atlas);
-    return NULL;
+    goto ERROR_CLEANUP;
   }
-  memset(atlas->entries, 0, sizeof(CJellyTextureEntry) * atlas->maxTextures);
 
-  // Create the atlas image using context device
-  createImageCtx(ctx, width, height, VK_FORMAT_R8G8B8A8_UNORM,
-                  VK_IMAGE_TILING_OPTIMAL,
-                  VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                  &atlas->atlasImage, &atlas->atlasImageMemory);
+  if (!atlasCreateImage(width, height, 1, &atlas->atlasImage, &atlas->atlasImageAlloc,
+                        &atlas->atlasImageView, &atlas->atlasArrayView)) {
+    goto ERROR_CLEANUP;
+  }
   // Transition to TRANSFER_DST for subsequent copies
-  transitionImageLayoutCtx(ctx, atlas->atlasImage, VK_FORMAT_R8G8B8A8_UNORM,
-                            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-  // Create image view using context device
-  VkImageViewCreateInfo viewInfo = {0};
-  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-  viewInfo.image = atlas->atlasImage;
-  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-  viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
-  viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  viewInfo.subresourceRange.baseMipLevel = 0;
-  viewInfo.subresourceRange.levelCount = 1;
-  viewInfo.subresourceRange.baseArrayLayer = 0;
-  viewInfo.subresourceRange.layerCount = 1;
+  VkCommandBuffer cmd = beginSingleTimeCommands();
+  atlasBarrier(cmd, atlas->atlasImage, 1, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  endSingleTimeCommands(cmd);
+  atlas->atlasLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  return atlas;
 
-  if (vkCreateImageView(ctx->device, &viewInfo, NULL, &atlas->atlasImageView) != VK_SUCCESS) {
-    fprintf(stderr, "Failed to create atlas image view (ctx)\n");
-    vkDestroyImage(ctx->device, atlas->atlasImage, NULL);
-    vkFreeMemory(ctx->device, atlas->atlasImageMemory, NULL);
-    free(atlas->entries);
-    free(atlas);
-    return NULL;
-  }
+ERROR_CLEANUP:
+  cj_atlas_packer_destroy(atlas->packer);
+  free(atlas->entries);
+  free(atlas);
+  return NULL;
+}
 
-  // Create sampler using context device
-  VkSamplerCreateInfo samplerInfo = {0};
-  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-  samplerInfo.magFilter = VK_FILTER_LINEAR;
-  samplerInfo.minFilter = VK_FILTER_LINEAR;
-  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.anisotropyEnable = VK_FALSE;
-  samplerInfo.maxAnisotropy = 1;
-  samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-  samplerInfo.unnormalizedCoordinates = VK_FALSE;
-  samplerInfo.compareEnable = VK_FALSE;
-  samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  samplerInfo.mipLodBias = 0.0f;
-  samplerInfo.minLod = 0.0f;
-  samplerInfo.maxLod = 0.0f;
-
-  if (vkCreateSampler(ctx->device, &samplerInfo, NULL, &atlas->atlasSampler) != VK_SUCCESS) {
-    fprintf(stderr, "Failed to create atlas sampler (ctx)\n");
-    vkDestroyImageView(ctx->device, atlas->atlasImageView, NULL);
-    vkDestroyImage(ctx->device, atlas->atlasImage, NULL);
-    vkFreeMemory(ctx->device, atlas->atlasImageMemory, NULL);
-    free(atlas->entries);
-    free(atlas);
-    return NULL;
-  }
+/// Frees everything atlasCreate() made; the sampler and descriptor set are
+/// the caller's.
+static void atlasDestroy(CJellyTextureAtlas * atlas) {
+  atlasDestroyImage(atlas);
+  cj_atlas_packer_destroy(atlas->packer);
+  free(atlas->entries);
+  free(atlas);
+}
 
+static bool atlasAllocateDescriptorSet(CJellyTextureAtlas * atlas) {
   // Use the engine's shared bindless descriptor set layout and pool
   atlas->bindlessDescriptorSetLayout = cj_engine_bindless_layout(cur_eng());
-  if (atlas->bindlessDescriptorSetLayout == VK_NULL_HANDLE) {
-    fprintf(stderr, "Failed to get engine bindless descriptor set layout (ctx)\n");
-    vkDestroyImageView(ctx->device, atlas->atlasImageView, NULL);
-    vkDestroyImage(ctx->device, atlas->atlasImage, NULL);
-    vkFreeMemory(ctx->device, atlas->atlasImageMemory, NULL);
-    free(atlas->entries);
-    free(atlas);
-    return NULL;
-  }
   atlas->bindlessDescriptorPool = cj_engine_bindless_pool(cur_eng());
-  if (atlas->bindlessDescriptorPool == VK_NULL_HANDLE) {
-    fprintf(stderr, "Failed to get engine bindless descriptor pool (ctx)\n");
-    vkDestroyImageView(ctx->device, atlas->atlasImageView, NULL);
-    vkDestroyImage(ctx->device, atlas->atlasImage, NULL);
-    vkFreeMemory(ctx->device, atlas->atlasImageMemory, NULL);
-    free(atlas->entries);
-    free(atlas);
-    return NULL;
+  if (atlas->bindlessDescriptorSetLayout == VK_NULL_HANDLE || atlas->bindlessDescriptorPool == VK_NULL_HANDLE) {
+    fprintf(stderr, "Failed to get engine bindless descriptor set layout or pool\n");
+    return false;
   }
 
-  // Allocate descriptor set using context device
   VkDescriptorSetAllocateInfo allocInfo = {0};
   allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
   allocInfo.descriptorPool = atlas->bindlessDescriptorPool;
@@ -3004,273 +2802,359 @@ CJellyTextureAtlas * cjelly_create_texture_atlas_ctx(const CJellyVulkanContext*
   allocInfo.pSetLayouts = &atlas->bindlessDescriptorSetLayout;
   allocInfo.pNext = NULL;
 
-  if (vkAllocateDescriptorSets(ctx->device, &allocInfo, &atlas->bindlessDescriptorSet) != VK_SUCCESS) {
-    fprintf(stderr, "Failed to allocate bindless descriptor set (ctx)\n");
+  if (vkAllocateDescriptorSets(cur_device(), &allocInfo, &atlas->bindlessDescriptorSet) != VK_SUCCESS) {
+    fprintf(stderr, "Failed to allocate bindless descriptor set\n");
+    return false;
+  }
+  return true;
+}
+
+CJellyTextureAtlas * cjelly_create_texture_atlas(uint32_t width, uint32_t height) {
+  CJellyTextureAtlas * atlas = atlasCreate(width, height);
+  if (!atlas) return NULL;
+
+  // Create sampler (reuse textured resources' sampler)
+  {
+    CJellyTexturedResources* tx = cur_tx();
+    atlas->atlasSampler = tx ? tx->sampler : VK_NULL_HANDLE;
+  }
+
+  /* layout/pool are engine-owned; do not destroy them on failure */
+  if (!atlasAllocateDescriptorSet(atlas)) {
+    atlasDestroy(atlas);
+    return NULL;
+  }
+
+  return atlas;
+}
+
+// Context-based atlas creation (holds a reference on a shared sampler)
+CJellyTextureAtlas * cjelly_create_texture_atlas_ctx(GCJ_MAYBE_UNUSED(const CJellyVulkanContext* ctx), uint32_t width, uint32_t height) {
+  CJellyTextureAtlas * atlas = atlasCreate(width, height);
+  if (!atlas) return NULL;
+
+  // Clamp to edge so neighbouring glyphs never bleed in; shared through the engine cache
+  cj_sampler_desc_t desc = {0};
+  desc.min_filter = CJ_FILTER_LINEAR;
+  desc.mag_filter = CJ_FILTER_LINEAR;
+  desc.address_u = CJ_ADDRESS_CLAMP;
+  desc.address_v = CJ_ADDRESS_CLAMP;
+  desc.address_w = CJ_ADDRESS_CLAMP;
+  atlas->atlasSamplerHandle = cj_engine_acquire_sampler(cur_eng(), &desc, &atlas->atlasSampler);
+  if (atlas->atlasSamplerHandle == 0) {
+    fprintf(stderr, "Failed to create atlas sampler (ctx)\n");
+    atlasDestroy(atlas);
+    return NULL;
+  }
+
   /* engine-owned pool/layout are not destroyed here */
-    vkDestroyImageView(ctx->device, atlas->atlasImageView, NULL);
-    vkDestroyImage(ctx->device, atlas->atlasImage, NULL);
-    vkFreeMemory(ctx->device, atlas->atlasImageMemory, NULL);
-    free(atlas->entries);
-    free(atlas);
+  if (!atlasAllocateDescriptorSet(atlas)) {
+    cj_engine_res_release(cur_eng(), CJ_RES_SMP, atlas->atlasSamplerHandle);
+    atlasDestroy(atlas);
     return NULL;
   }
 
   return atlas;
 }
 
-// Context-based atlas destruction (uses context device instead of global)
-void cjelly_destroy_texture_atlas_ctx(CJellyTextureAtlas * atlas, const CJellyVulkanContext* ctx) {
+// Context-based atlas destruction (releases its sampler reference)
+void cjelly_destroy_texture_atlas_ctx(CJellyTextureAtlas * atlas, GCJ_MAYBE_UNUSED(const CJellyVulkanContext* ctx)) {
   if (!atlas) return;
 
-  vkDestroySampler(ctx->device, atlas->atlasSampler, NULL);
+  cj_engine_res_release(cur_eng(), CJ_RES_SMP, atlas->atlasSamplerHandle);
   /* layout/pool are engine-owned; do not destroy here */
-  vkDestroyImageView(ctx->device, atlas->atlasImageView, NULL);
-  vkDestroyImage(ctx->device, atlas->atlasImage, NULL);
-  vkFreeMemory(ctx->device, atlas->atlasImageMemory, NULL);
-
-  if (atlas->entries) { free(atlas->entries); atlas->entries = NULL; }
-
-  free(atlas);
+  atlasDestroy(atlas);
 }
 
 void cjelly_destroy_texture_atlas(CJellyTextureAtlas * atlas) {
   if (!atlas) return;
 
   /* layout/pool are engine-owned; do not destroy here */
-  vkDestroyImageView(cur_device(), atlas->atlasImageView, NULL);
-  vkDestroyImage(cur_device(), atlas->atlasImage, NULL);
-  vkFreeMemory(cur_device(), atlas->atlasImageMemory, NULL);
-
-  if (atlas->entries) { free(atlas->entries); atlas->entries = NULL; }
-
-  free(atlas);
+  atlasDestroy(atlas);
 }
 
-uint32_t cjelly_atlas_add_texture(CJellyTextureAtlas * atlas, const char * filePath) {
-  if (!atlas || atlas->textureCount >= atlas->maxTextures) {
-    return 0; // Invalid texture ID
+/// Replaces the atlas image by a new one with the given number of pages,
+/// copying the given regions from the old image on the GPU.
+static bool atlasReplaceImage(CJellyTextureAtlas * atlas, uint32_t pages,
+    const VkImageCopy * regions, uint32_t regionCount) {
+  VkImage image;
+  cj_gpu_alloc_t imageAlloc = {0};
+  VkImageView pageView, arrayView;
+  if (!atlasCreateImage(atlas->atlasWidth, atlas->atlasHeight, pages, &image, &imageAlloc, &pageView, &arrayView)) {
+    return false;
   }
 
-  // Load the image
-  CJellyFormatImage * image;
-  if (cjelly_format_image_load(filePath, &image) != CJELLY_FORMAT_IMAGE_SUCCESS) {
-    fprintf(stderr, "Failed to load texture: %s\n", filePath);
-    return 0;
-  }
+  // Land every queued upload in the old image before copying out of it
+  cj_upload_queue_wait(cur_uploads(), cj_upload_queue_flush(cur_uploads()));
 
-  uint32_t texWidth = image->raw->width;
-  uint32_t texHeight = image->raw->height;
+  VkCommandBuffer cmd = beginSingleTimeCommands();
+  atlasBarrier(cmd, atlas->atlasImage, atlas->pageCount, atlas->atlasLayout, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+  atlasBarrier(cmd, image, pages, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+  vkCmdCopyImage(cmd, atlas->atlasImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                 image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regionCount, regions);
+  if (atlas->atlasLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+    atlasBarrier(cmd, image, pages, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, atlas->atlasLayout);
+  }
+  // Waits for the queue, so nothing still reads the old image afterwards
+  endSingleTimeCommands(cmd);
 
-  // Check if texture fits in current row
-  if (atlas->nextTextureX + texWidth > atlas->atlasWidth) {
-    // Move to next row
-    atlas->nextTextureX = 0;
-    atlas->nextTextureY += atlas->currentRowHeight;
-    atlas->currentRowHeight = 0;
+  atlasDestroyImage(atlas);
+  atlas->atlasImage = image;
+  atlas->atlasImageAlloc = imageAlloc;
+  atlas->atlasImageView = pageView;
+  atlas->atlasArrayView = arrayView;
+  atlas->pageCount = pages;
+  if (atlas->descriptorWritten) {
+    cjelly_atlas_update_descriptor_set(atlas);
   }
+  return true;
+}
 
-  // Check if texture fits in atlas
-  if (atlas->nextTextureY + texHeight > atlas->atlasHeight) {
-    fprintf(stderr, "Texture atlas is full\n");
-    cjelly_format_image_free(image);
-    return 0;
+/// Adds a page to the atlas, keeping the contents of the existing ones.
+static bool atlasGrow(CJellyTextureAtlas * atlas) {
+  uint32_t pages = atlas->pageCount + 1;
+  VkImageCopy * regions = calloc(atlas->pageCount, sizeof(VkImageCopy));
+  if (!regions || !cj_atlas_packer_add_page(atlas->packer)) {
+    free(regions);
+    return false;
   }
+  for (uint32_t i = 0; i < atlas->pageCount; i++) {
+    regions[i].srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    regions[i].srcSubresource.baseArrayLayer = i;
+    regions[i].srcSubresource.layerCount = 1;
+    regions[i].dstSubresource = regions[i].srcSubresource;
+    regions[i].extent = (VkExtent3D){atlas->atlasWidth, atlas->atlasHeight, 1};
+  }
+  bool grown = atlasReplaceImage(atlas, pages, regions, atlas->pageCount);
+  free(regions);
+  // A packer page without an image layer would hand out space that does not
+  // exist, so a failed grow leaves the atlas unusable for new entries.
+  if (!grown) {
+    atlas->maxPages = atlas->pageCount;
+    fprintf(stderr, "Failed to grow texture atlas to %u pages\n", pages);
+  }
+  return grown;
+}
 
-  // Create staging buffer for the texture
-  VkDeviceSize imageSize = texWidth * texHeight * 4; // RGBA
-  VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
+static void atlasSetEntry(CJellyTextureAtlas * atlas, uint32_t index, const cj_atlas_rect_t * rect) {
+  CJellyTextureEntry * entry = &atlas->entries[index - 1];
+  entry->textureID = (entry->generation << CJ_ATLAS_ID_INDEX_BITS) | index;
+  entry->page = rect->page;
+  entry->x = rect->x;
+  entry->y = rect->y;
+  entry->width = rect->width;
+  entry->height = rect->height;
 
-  createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-               &stagingBuffer, &stagingBufferMemory);
-
-  // Copy image data to staging buffer
-  void * data;
-  vkMapMemory(cur_device(), stagingBufferMemory, 0, imageSize, 0, &data);
-
-  // Convert RGB to RGBA and copy to staging buffer
-  uint8_t * pixels = (uint8_t *)data;
-  for (uint32_t y = 0; y < texHeight; y++) {
-    for (uint32_t x = 0; x < texWidth; x++) {
-      uint32_t srcIndex = (y * texWidth + x) * 3; // RGB
-      uint32_t dstIndex = (y * texWidth + x) * 4; // RGBA
-      pixels[dstIndex] = image->raw->data[srcIndex];     // R
-      pixels[dstIndex + 1] = image->raw->data[srcIndex + 1]; // G
-      pixels[dstIndex + 2] = image->raw->data[srcIndex + 2]; // B
-      pixels[dstIndex + 3] = 255; // A
-    }
-  }
+  // Calculate UV coordinates
+  entry->uMin = (float)rect->x / (float)atlas->atlasWidth;
+  entry->uMax = (float)(rect->x + rect->width) / (float)atlas->atlasWidth;
+  entry->vMin = (float)rect->y / (float)atlas->atlasHeight;
+  entry->vMax = (float)(rect->y + rect->height) / (float)atlas->atlasHeight;
+}
 
-  vkUnmapMemory(cur_device(), stagingBufferMemory);
+/// Frees the entry with the given packer id and retires its texture id.
+static void atlasRemoveEntry(CJellyTextureAtlas * atlas, uint32_t index) {
+  CJellyTextureEntry * entry = &atlas->entries[index - 1];
+  uint32_t generation = (entry->generation + 1u) & (UINT32_MAX >> CJ_ATLAS_ID_INDEX_BITS);
+  cj_atlas_packer_remove(atlas->packer, index);
+  memset(entry, 0, sizeof(CJellyTextureEntry));
+  entry->generation = generation;
+  atlas->textureCount--;
+}
 
-  // Copy staging buffer to atlas image at the correct position
-  VkBufferImageCopy region = {0};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
-  region.imageOffset.x = atlas->nextTextureX;
-  region.imageOffset.y = atlas->nextTextureY;
-  region.imageOffset.z = 0;
-  region.imageExtent.width = texWidth;
-  region.imageExtent.height = texHeight;
-  region.imageExtent.depth = 1;
+void cjelly_atlas_remove_texture(CJellyTextureAtlas * atlas, uint32_t textureID) {
+  if (!cjelly_atlas_get_texture_entry(atlas, textureID)) return;
+  atlasRemoveEntry(atlas, textureID & CJ_ATLAS_ID_INDEX_MASK);
+}
 
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-  vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, atlas->atlasImage,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-  endSingleTimeCommands(commandBuffer);
+void cjelly_atlas_touch_texture(CJellyTextureAtlas * atlas, uint32_t textureID) {
+  if (cjelly_atlas_get_texture_entry(atlas, textureID)) {
+    cj_atlas_packer_touch(atlas->packer, textureID & CJ_ATLAS_ID_INDEX_MASK);
+  }
+}
 
-  // Store texture entry
-  uint32_t textureID = atlas->textureCount + 1; // Start from 1, 0 means no texture
-  CJellyTextureEntry * entry = &atlas->entries[atlas->textureCount];
-  entry->textureID = textureID;
-  entry->x = atlas->nextTextureX;
-  entry->y = atlas->nextTextureY;
-  entry->width = texWidth;
-  entry->height = texHeight;
+void cjelly_atlas_set_growth(CJellyTextureAtlas * atlas, uint32_t maxPages, bool evictLRU) {
+  if (!atlas) return;
+  atlas->maxPages = maxPages > atlas->pageCount ? maxPages : atlas->pageCount;
+  atlas->evictLRU = evictLRU;
+}
 
-  // Calculate UV coordinates
-  entry->uMin = (float)atlas->nextTextureX / (float)atlas->atlasWidth;
-  entry->uMax = (float)(atlas->nextTextureX + texWidth) / (float)atlas->atlasWidth;
-  entry->vMin = (float)atlas->nextTextureY / (float)atlas->atlasHeight;
-  entry->vMax = (float)(atlas->nextTextureY + texHeight) / (float)atlas->atlasHeight;
+float cjelly_atlas_fragmentation(CJellyTextureAtlas * atlas) {
+  if (!atlas) return 0.0f;
+  cj_atlas_packer_stats_t stats;
+  cj_atlas_packer_stats(atlas->packer, &stats);
+  if (stats.free_area == 0) return 0.0f;
+  return 1.0f - (float)((double)stats.largest_free / (double)stats.free_area);
+}
 
-  // Update atlas position
-  atlas->nextTextureX += texWidth;
-  if (texHeight > atlas->currentRowHeight) {
-    atlas->currentRowHeight = texHeight;
-  }
-  atlas->textureCount++;
+bool cjelly_atlas_defragment(CJellyTextureAtlas * atlas) {
+  if (!atlas) return false;
 
-  // Clean up
-  vkDestroyBuffer(cur_device(), stagingBuffer, NULL);
-  vkFreeMemory(cur_device(), stagingBufferMemory, NULL);
-  cjelly_format_image_free(image);
+  cj_atlas_move_t * moves = NULL;
+  uint32_t count = cj_atlas_packer_plan_defragment(atlas->packer, &moves);
+  if (count == 0) return false;
 
-  return textureID;
+  VkImageCopy * regions = calloc(count, sizeof(VkImageCopy));
+  if (!regions) {
+    free(moves);
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    regions[i].srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    regions[i].srcSubresource.baseArrayLayer = moves[i].from.page;
+    regions[i].srcSubresource.layerCount = 1;
+    regions[i].srcOffset = (VkOffset3D){(int32_t)moves[i].from.x, (int32_t)moves[i].from.y, 0};
+    regions[i].dstSubresource = regions[i].srcSubresource;
+    regions[i].dstSubresource.baseArrayLayer = moves[i].to.page;
+    regions[i].dstOffset = (VkOffset3D){(int32_t)moves[i].to.x, (int32_t)moves[i].to.y, 0};
+    regions[i].extent = (VkExtent3D){moves[i].from.width, moves[i].from.height, 1};
+  }
+
+  // Copy every entry into a fresh image, so moves never overlap their sources
+  bool moved = atlasReplaceImage(atlas, atlas->pageCount, regions, count);
+  if (moved) {
+    cj_atlas_packer_commit_moves(atlas->packer, moves, count);
+    for (uint32_t i = 0; i < count; i++) {
+      atlasSetEntry(atlas, moves[i].id, &moves[i].to);
+    }
+  }
+  free(regions);
+  free(moves);
+  return moved;
 }
 
-// Context-based texture addition (uses context device instead of global)
-uint32_t cjelly_atlas_add_texture_ctx(CJellyTextureAtlas * atlas, const char * filePath, const CJellyVulkanContext* ctx) {
-  if (!atlas || atlas->textureCount >= atlas->maxTextures) {
-    return 0; // Invalid texture ID
+/// Finds room for a texture: repacks when the space exists but is scattered,
+/// then adds a page, then evicts least recently used textures.
+static uint32_t atlasReserve(CJellyTextureAtlas * atlas, uint32_t width, uint32_t height, cj_atlas_rect_t * rect) {
+  uint32_t textureID = cj_atlas_packer_insert(atlas->packer, width, height, rect);
+  if (textureID || width > atlas->atlasWidth || height > atlas->atlasHeight) {
+    return textureID;
   }
 
-  // Load the image
-  CJellyFormatImage * image;
-  if (cjelly_format_image_load(filePath, &image) != CJELLY_FORMAT_IMAGE_SUCCESS) {
-    fprintf(stderr, "Failed to load texture: %s\n", filePath);
-    return 0;
+  if (atlas->textureCount < atlas->maxTextures) {
+    cj_atlas_packer_stats_t stats;
+    cj_atlas_packer_stats(atlas->packer, &stats);
+    if (stats.free_area >= (uint64_t)width * height && cjelly_atlas_defragment(atlas)) {
+      textureID = cj_atlas_packer_insert(atlas->packer, width, height, rect);
+      if (textureID) return textureID;
+    }
+    if (atlas->pageCount < atlas->maxPages && atlasGrow(atlas)) {
+      textureID = cj_atlas_packer_insert(atlas->packer, width, height, rect);
+      if (textureID) return textureID;
+    }
   }
 
-  uint32_t texWidth = image->raw->width;
-  uint32_t texHeight = image->raw->height;
+  while (atlas->evictLRU && !textureID) {
+    uint32_t victim = cj_atlas_packer_lru(atlas->packer);
+    if (!victim) break;
+    atlasRemoveEntry(atlas, victim);
+    textureID = cj_atlas_packer_insert(atlas->packer, width, height, rect);
+  }
+  return textureID;
+}
 
-  // Check if texture fits in current row
-  if (atlas->nextTextureX + texWidth > atlas->atlasWidth) {
-    // Move to next row
-    atlas->nextTextureX = 0;
-    atlas->nextTextureY += atlas->currentRowHeight;
-    atlas->currentRowHeight = 0;
+/// Decode target that reserves space in an atlas for a texture and hands
+/// back staging memory for its texels.
+typedef struct CJellyAtlasUpload {
+  CJellyTextureAtlas * atlas;
+  const char * failure;   ///< Why acquire() gave up, if it did.
+  uint32_t textureID;     ///< Packer id reserved by acquire(), 0 if none.
+  cj_atlas_rect_t rect;   ///< Where the entry landed.
+} CJellyAtlasUpload;
+
+static unsigned char * acquireAtlasRegion(void * user, int width, int height, size_t * stride) {
+  CJellyAtlasUpload * upload = (CJellyAtlasUpload *)user;
+  CJellyTextureAtlas * atlas = upload->atlas;
+  uint32_t texWidth = (uint32_t)width;
+  uint32_t texHeight = (uint32_t)height;
+
+  uint32_t textureID = atlasReserve(atlas, texWidth, texHeight, &upload->rect);
+  if (!textureID) {
+    upload->failure = "Texture atlas is full";
+    return NULL;
   }
 
-  // Check if texture fits in atlas
-  if (atlas->nextTextureY + texHeight > atlas->atlasHeight) {
-    fprintf(stderr, "Texture atlas is full\n");
-    cjelly_format_image_free(image);
-    return 0;
+  // Queue the copy into the atlas, leaving the image in the layout it is
+  // currently used in.
+  cj_upload_image_t dst = {0};
+  dst.image = atlas->atlasImage;
+  dst.old_layout = atlas->atlasLayout;
+  dst.new_layout = atlas->atlasLayout;
+  dst.offset = (VkOffset3D){(int32_t)upload->rect.x, (int32_t)upload->rect.y, 0};
+  dst.extent = (VkExtent3D){texWidth, texHeight, 1};
+  dst.array_layer = upload->rect.page;
+  dst.texel_size = 4;
+  unsigned char * pixels = (unsigned char *)cj_upload_queue_stage_image(cur_uploads(), &dst, NULL);
+  if (!pixels) {
+    cj_atlas_packer_remove(atlas->packer, textureID);
+    upload->failure = "Failed to stage texture";
+    return NULL;
   }
+  upload->textureID = textureID;
+  *stride = (size_t)texWidth * 4;
+  return pixels;
+}
 
-  // Create staging buffer for the texture using context device
-  VkDeviceSize imageSize = texWidth * texHeight * 4; // RGBA
-  VkBuffer stagingBuffer;
-  VkDeviceMemory stagingBufferMemory;
+/// Decodes an image file straight into the staging ring and records where
+/// it lands in the atlas.
+static uint32_t atlasAddTexture(CJellyTextureAtlas * atlas, const char * filePath) {
+  if (!atlas) {
+    return 0; // Invalid texture ID
+  }
 
-  createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-               &stagingBuffer, &stagingBufferMemory);
-
-  // Copy image data to staging buffer using context device
-  void * data;
-  vkMapMemory(ctx->device, stagingBufferMemory, 0, imageSize, 0, &data);
-
-  // Convert RGB to RGBA and copy to staging buffer
-  uint8_t * pixels = (uint8_t *)data;
-  for (uint32_t y = 0; y < texHeight; y++) {
-    for (uint32_t x = 0; x < texWidth; x++) {
-      uint32_t srcIndex = (y * texWidth + x) * 3; // RGB
-      uint32_t dstIndex = (y * texWidth + x) * 4; // RGBA
-      pixels[dstIndex] = image->raw->data[srcIndex];     // R
-      pixels[dstIndex + 1] = image->raw->data[srcIndex + 1]; // G
-      pixels[dstIndex + 2] = image->raw->data[srcIndex + 2]; // B
-      pixels[dstIndex + 3] = 255; // A
+  // Load the image
+  CJellyAtlasUpload upload = { atlas, NULL, 0, {0} };
+  CJellyFormatImageTarget target = { acquireAtlasRegion, &upload };
+  int width = 0, height = 0;
+  if (cjelly_format_image_load_rgba(filePath, &target, &width, &height) != CJELLY_FORMAT_IMAGE_SUCCESS) {
+    if (upload.textureID) {
+      // The decoder failed after the region was reserved
+      cj_atlas_packer_remove(atlas->packer, upload.textureID);
+    }
+    if (upload.failure) {
+      fprintf(stderr, "%s: %s\n", upload.failure, filePath);
     }
+    else {
+      fprintf(stderr, "Failed to load texture: %s\n", filePath);
+    }
+    return 0;
   }
 
-  vkUnmapMemory(ctx->device, stagingBufferMemory);
-
-  // Copy staging buffer to atlas image at the correct position using context command buffer
-  VkBufferImageCopy region = {0};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = 1;
-  region.imageOffset.x = atlas->nextTextureX;
-  region.imageOffset.y = atlas->nextTextureY;
-  region.imageOffset.z = 0;
-  region.imageExtent.width = texWidth;
-  region.imageExtent.height = texHeight;
-  region.imageExtent.depth = 1;
-
-  VkCommandBuffer commandBuffer = beginSingleTimeCommandsCtx(ctx);
-  vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, atlas->atlasImage,
-                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-  endSingleTimeCommandsCtx(ctx, commandBuffer);
-
-  // Store texture entry
-  uint32_t textureID = atlas->textureCount + 1; // Start from 1, 0 means no texture
-  CJellyTextureEntry * entry = &atlas->entries[atlas->textureCount];
-  entry->textureID = textureID;
-  entry->x = atlas->nextTextureX;
-  entry->y = atlas->nextTextureY;
-  entry->width = texWidth;
-  entry->height = texHeight;
-
-  // Calculate UV coordinates
-  entry->uMin = (float)atlas->nextTextureX / (float)atlas->atlasWidth;
-  entry->uMax = (float)(atlas->nextTextureX + texWidth) / (float)atlas->atlasWidth;
-  entry->vMin = (float)atlas->nextTextureY / (float)atlas->atlasHeight;
-  entry->vMax = (float)(atlas->nextTextureY + texHeight) / (float)atlas->atlasHeight;
-
-  // Update atlas position
-  atlas->nextTextureX += texWidth;
-  if (texHeight > atlas->currentRowHeight) {
-    atlas->currentRowHeight = texHeight;
-  }
+  // Store texture entry (IDs start from 1, 0 means no texture)
+  atlasSetEntry(atlas, upload.textureID, &upload.rect);
   atlas->textureCount++;
 
-  // Clean up
-  vkDestroyBuffer(ctx->device, stagingBuffer, NULL);
-  vkFreeMemory(ctx->device, stagingBufferMemory, NULL);
-  cjelly_format_image_free(image);
+  return atlas->entries[upload.textureID - 1].textureID;
+}
 
-  return textureID;
+uint32_t cjelly_atlas_add_texture(CJellyTextureAtlas * atlas, const char * filePath) {
+  return atlasAddTexture(atlas, filePath);
+}
+
+// Context-based texture addition (uses context device instead of global)
+uint32_t cjelly_atlas_add_texture_ctx(CJellyTextureAtlas * atlas, const char * filePath, const CJellyVulkanContext* ctx) {
+  (void)ctx; // Copies go through the engine upload queue.
+  return atlasAddTexture(atlas, filePath);
 }
 
 CJellyTextureEntry * cjelly_atlas_get_texture_entry(CJellyTextureAtlas * atlas, uint32_t textureID) {
-  if (!atlas || textureID == 0 || textureID > atlas->textureCount) {
+  uint32_t index = textureID & CJ_ATLAS_ID_INDEX_MASK;
+  if (!atlas || index == 0 || index > atlas->maxTextures ||
+      atlas->entries[index - 1].textureID != textureID) {
     return NULL;
   }
 
-  return &atlas->entries[textureID - 1];
+  return &atlas->entries[index - 1];
+}
+
+void cjelly_atlas_prepare_for_sampling(CJellyTextureAtlas * atlas) {
+  if (!atlas || atlas->atlasLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) return;
+
+  // Submits every queued copy into the atlas first
+  VkCommandBuffer cmd = beginSingleTimeCommands();
+  atlasBarrier(cmd, atlas->atlasImage, atlas->pageCount, atlas->atlasLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+  endSingleTimeCommands(cmd);
+  atlas->atlasLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 }
 
 void cjelly_atlas_update_descriptor_set(CJellyTextureAtlas * atlas) {
@@ -3293,6 +3177,7 @@ void cjelly_atlas_update_descriptor_set(CJellyTextureAtlas * atlas) {
   descriptorWrite.pImageInfo = &imageInfo;
 
   vkUpdateDescriptorSets(cur_device(), 1, &descriptorWrite, 0, NULL);
+  atlas->descriptorWritten = true;
 }
 
 // Context-based descriptor set update (uses context device instead of global)
@@ -3315,6 +3200,7 @@ static void cjelly_atlas_update_descriptor_set_ctx(CJellyTextureAtlas * atlas, c
   descriptorWrite.pImageInfo = &imageInfo;
 
   vkUpdateDescriptorSets(ctx->device, 1, &descriptorWrite, 0, NULL);
+  atlas->descriptorWritten = true;
 }
 
 /* Public wrapper used by window API to build textured path using a context */
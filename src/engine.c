@@ -15,6 +15,11 @@
 #include <cjelly/cj_handle.h>
 #include <cjelly/cj_resources.h>
 #include <cjelly/resource_helpers_internal.h>
+#include <cjelly/worker_pool_internal.h>
+#include <cjelly/gpu_alloc_internal.h>
+#include <cjelly/frame_pacer_internal.h>
+#include <cjelly/shader_reload_internal.h>
+#include <cjelly/arena_internal.h>
 
 // Generated shader headers - use extern declarations to avoid multiple definitions
 extern unsigned char color_vert_spv[];
@@ -23,6 +28,23 @@ extern unsigned char color_frag_spv[];
 extern unsigned int color_frag_spv_len;
 
 
+/* Node descriptor pools the engine grows to, and sets in each */
+#define CJ_ENGINE_NODE_POOLS 16u
+#define CJ_ENGINE_NODE_POOL_SETS 64u
+
+/* Entry whose last reference was dropped while the GPU may still use its objects */
+typedef struct cj_res_retired_t {
+  uint64_t serial;     /* Batch whose completion frees the entry, 0 until one was submitted */
+  uint32_t index;
+  cj_res_kind_t kind;
+  VkPipeline pipeline; /* Replaced by shader reload; set instead of a table entry */
+  VkImage image;       /* Storage a streamed texture replaced; set instead of a table entry */
+  VkImageView view;
+  cj_gpu_alloc_t alloc;
+  bool has_garbage;    /* Queued by cj_engine_retire; set instead of a table entry */
+  cj_engine_garbage_t garbage;
+} cj_res_retired_t;
+
 /* Internal definition of the opaque engine type */
 struct cj_engine_t {
   uint32_t selected_device_index;
@@ -34,14 +56,94 @@ struct cj_engine_t {
   VkDevice device;
   VkQueue graphics_queue;
   VkQueue present_queue;
+  /* Window passes for color_format; entries of render_passes unless imported */
   VkRenderPass render_pass;
+  /* render_pass keeping the image outside the render area, for partial redraws */
+  VkRenderPass partial_render_pass;
   VkCommandPool command_pool;
   VkFormat color_format;
-
-  /* Phase 3: simple resource tables */
-  cj_res_entry_t textures[CJ_ENGINE_MAX_TEXTURES];
-  cj_res_entry_t buffers[CJ_ENGINE_MAX_BUFFERS];
-  cj_res_entry_t samplers[CJ_ENGINE_MAX_SAMPLERS];
+  /* Render pass cache: created on first use, destroyed at shutdown so pipelines stay valid */
+  struct { cj_render_pass_key_t key; VkRenderPass pass; }* render_passes;
+  uint32_t render_pass_count, render_pass_capacity;
+  uint32_t graphics_family;
+  /* Queue for texture uploads; equals graphics_queue without a dedicated transfer family */
+  VkQueue transfer_queue;
+  uint32_t transfer_family;
+  /* Queue for async compute; equals graphics_queue without a compute family apart from graphics */
+  VkQueue compute_queue;
+  uint32_t compute_family;
+  /* VK_KHR_timeline_semaphore is enabled; vkWaitSemaphoresKHR (NULL without it) */
+  PFN_vkWaitSemaphoresKHR wait_semaphores;
+  /* VK_KHR_incremental_present is enabled: presents may list the changed rectangles */
+  int incremental_present;
+  /* VK_GOOGLE_display_timing is enabled: swapchains report refresh and present times */
+  int display_timing;
+  /* Block compression families enabled on the device (ENG_COMPRESS_*) */
+  uint32_t compression;
+  /* multiDrawIndirect and drawIndirectFirstInstance are enabled, and vkCmdDrawIndexedIndirectCountKHR
+   * of VK_KHR_draw_indirect_count (NULL without it) */
+  int indirect_draws;
+  PFN_vkCmdDrawIndexedIndirectCountKHR draw_indexed_indirect_count;
+
+  /* Fences signaled by batched multi-window submissions, reused round-robin */
+  VkFence batch_fences[CJ_ENGINE_BATCH_FENCES];
+  uint64_t batch_fence_serials[CJ_ENGINE_BATCH_FENCES]; /* Serial last submitted with each fence, 0 if unused */
+  uint64_t batch_serial;                                /* Serial of the most recent batch */
+  uint64_t batch_completed;                             /* Every batch up to this serial has finished */
+  /* With timeline semaphores, batches signal this timeline with their serial instead of a fence */
+  VkSemaphore batch_timeline;
+  PFN_vkGetSemaphoreCounterValueKHR get_semaphore_counter_value;
+  VkSubmitInfo* batch_submits;  /* The caller's submissions plus the timeline signal */
+  uint32_t batch_submit_capacity;
+
+  /* Worker threads: frame work with CJ_ENGINE_ENABLE_THREADING, background jobs always.
+   * Started at creation with the flag, else by the first job */
+  cj_worker_pool_t* workers;
+  bool workers_started;
+
+  /* Per-frame memory, reset when a frame starts (NULL before the first), and the
+   * frame path's heap allocations: the count when the frame started, and during the last */
+  cj_arena_t* frame_arena;
+  uint64_t frame_heap_mark;
+  uint32_t frame_heap_allocs;
+  uint64_t frames_started;
+
+  /* Host allocator from cj_engine_desc_t (fields NULL = malloc/free) and the
+   * device memory allocator built on it once a device exists */
+  cj_allocator_t host_allocator;
+  cj_gpu_allocator_t* gpu;
+
+  /* Staging ring and batched copies for texture data */
+  cj_upload_queue_t* uploads;
+
+  /* cj_engine_desc_t.memory_budget, and the query of VK_EXT_memory_budget (NULL without it) */
+  uint64_t memory_budget;
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR get_memory_properties2;
+  /* Streamed texture indices, streaming updates so far, and bytes of replaced storage
+   * waiting in the deletion queue */
+  uint32_t* streamed;
+  uint32_t streamed_count, streamed_capacity;
+  uint64_t stream_frame;
+  VkDeviceSize stream_retired_bytes;
+
+  /* Pipeline cache saved across runs, and pipelines shared between graphs */
+  cj_pipeline_cache_t* pipelines;
+  /* Shader source watcher for CJ_ENGINE_ENABLE_SHADER_RELOAD (NULL when disabled) */
+  cj_shader_reload_t* shader_reload;
+  /* Assets loaded through cj_asset.h; created by the first load */
+  cj_asset_cache_t* assets;
+
+  /* Resource tables, indexed by cj_res_kind_t */
+  cj_res_table_t tables[3];
+  /* Deletion queue, oldest first. Entries keep their objects and index until their batch
+   * finished; the newest retired_untagged ones are not covered by a batch yet. */
+  cj_res_retired_t* retired;
+  uint32_t retired_head, retired_count, retired_capacity;
+  uint32_t retired_untagged;
+  /* Sampler cache: sampler indices open-addressed by the hash of their key, 0 = empty */
+  uint32_t* sampler_cache;
+  uint32_t sampler_cache_capacity;  /* Power of two, 0 until the first sampler */
+  uint32_t sampler_cache_count;
 
   /* Internal-only textured resources (migration) */
   CJellyTexturedResources textured;
@@ -56,10 +158,32 @@ struct cj_engine_t {
   /* Shared bindless descriptor resources (engine-owned) */
   VkDescriptorSetLayout bindless_layout;
   VkDescriptorPool      bindless_pool;
+
+  /* Texture table: one update-after-bind set holding every texture at its slot.
+   * Only created when the device supports descriptor indexing. */
+  int texture_table_supported;
+  VkDescriptorSetLayout texture_table_layout;
+  VkDescriptorPool      texture_table_pool;
+  VkDescriptorSet       texture_table;
+
+  /* Geometry and input descriptor sets shared by render graph nodes, created on first use */
+  VkBuffer shared_quads;
+  cj_gpu_alloc_t shared_quads_alloc;
+  VkDescriptorSetLayout node_set_layout;
+  VkDescriptorPool node_pools[CJ_ENGINE_NODE_POOLS];
+  uint32_t node_pool_count;
+  VkDescriptorSetLayout uniform_set_layout;
 };
 
 static cj_engine_t* g_current_engine = NULL;
 
+static void eng_destroy_live_resources(cj_engine_t* e);
+static void eng_free_tables(cj_engine_t* e);
+static void eng_drain_retired(cj_engine_t* e);
+static void res_drain_released(cj_engine_t* e);
+static void eng_start_shader_reload(cj_engine_t* e);
+static void eng_retire_pipeline(void* user, VkPipeline pipeline);
+
 /* --- Engine-owned Vulkan bootstrap (migration of legacy init) --- */
 static int eng_create_instance(cj_engine_t* e, int use_validation) {
   VkApplicationInfo appInfo = {0};
@@ -68,7 +192,12 @@ static int eng_create_instance(cj_engine_t* e, int use_validation) {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "CJellyEngine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  /* 1.1 when the loader has it, to query descriptor indexing support */
+  uint32_t loaderVersion = VK_API_VERSION_1_0;
+  PFN_vkEnumerateInstanceVersion enumerateVersion =
+      (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(NULL, "vkEnumerateInstanceVersion");
+  if (enumerateVersion && enumerateVersion(&loaderVersion) != VK_SUCCESS) loaderVersion = VK_API_VERSION_1_0;
+  appInfo.apiVersion = (loaderVersion >= VK_API_VERSION_1_1) ? VK_API_VERSION_1_1 : VK_API_VERSION_1_0;
 
   const char* extensions[8];
   uint32_t extCount = 0;
@@ -114,6 +243,122 @@ static int eng_pick_physical_device(cj_engine_t* e) {
   return 1;
 }
 
+/* Check whether the physical device offers a device extension */
+static int eng_has_device_extension(cj_engine_t* e, const char* name) {
+  uint32_t count = 0;
+  vkEnumerateDeviceExtensionProperties(e->physical_device, NULL, &count, NULL);
+  VkExtensionProperties* available = (VkExtensionProperties*)malloc(sizeof(*available) * (count ? count : 1));
+  if (!available) return 0;
+  vkEnumerateDeviceExtensionProperties(e->physical_device, NULL, &count, available);
+  int found = 0;
+  for (uint32_t i = 0; i < count && !found; ++i) {
+    if (strcmp(available[i].extensionName, name) == 0) found = 1;
+  }
+  free(available);
+  return found;
+}
+
+/* Check whether the device can back the texture table: descriptor indexing with partially
+ * bound, update-after-bind, non-uniformly indexed sampled images and room for the whole
+ * table in one stage.
+ * Fills the features to enable and appends the extensions it needs. */
+static int eng_query_texture_table(cj_engine_t* e, VkPhysicalDeviceFeatures2* features,
+                                   VkPhysicalDeviceDescriptorIndexingFeaturesEXT* indexing,
+                                   const char** extensions, uint32_t* extension_count) {
+  PFN_vkGetPhysicalDeviceFeatures2 getFeatures2 =
+      (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(e->instance, "vkGetPhysicalDeviceFeatures2");
+  PFN_vkGetPhysicalDeviceProperties2 getProperties2 =
+      (PFN_vkGetPhysicalDeviceProperties2)vkGetInstanceProcAddr(e->instance, "vkGetPhysicalDeviceProperties2");
+  if (!getFeatures2 || !getProperties2) return 0;
+
+  if (!eng_has_device_extension(e, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) ||
+      !eng_has_device_extension(e, VK_KHR_MAINTENANCE3_EXTENSION_NAME)) return 0;
+
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported = {0};
+  supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+  VkPhysicalDeviceFeatures2 supported2 = {0};
+  supported2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supported2.pNext = &supported;
+  getFeatures2(e->physical_device, &supported2);
+  if (!supported.descriptorBindingPartiallyBound || !supported.descriptorBindingSampledImageUpdateAfterBind ||
+      !supported.shaderSampledImageArrayNonUniformIndexing ||
+      !supported2.features.shaderSampledImageArrayDynamicIndexing) return 0;
+
+  VkPhysicalDeviceDescriptorIndexingPropertiesEXT limits = {0};
+  limits.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+  VkPhysicalDeviceProperties2 props2 = {0};
+  props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  props2.pNext = &limits;
+  getProperties2(e->physical_device, &props2);
+  if (limits.maxPerStageDescriptorUpdateAfterBindSamplers < CJ_ENGINE_TEXTURE_TABLE_SIZE ||
+      limits.maxPerStageDescriptorUpdateAfterBindSampledImages < CJ_ENGINE_TEXTURE_TABLE_SIZE ||
+      limits.maxPerStageUpdateAfterBindResources < CJ_ENGINE_TEXTURE_TABLE_SIZE ||
+      limits.maxDescriptorSetUpdateAfterBindSamplers < CJ_ENGINE_TEXTURE_TABLE_SIZE ||
+      limits.maxDescriptorSetUpdateAfterBindSampledImages < CJ_ENGINE_TEXTURE_TABLE_SIZE) return 0;
+
+  memset(indexing, 0, sizeof(*indexing));
+  indexing->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+  indexing->descriptorBindingPartiallyBound = VK_TRUE;
+  indexing->descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  indexing->shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  memset(features, 0, sizeof(*features));
+  features->sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features->pNext = indexing;
+  features->features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+  extensions[(*extension_count)++] = VK_KHR_MAINTENANCE3_EXTENSION_NAME;
+  extensions[(*extension_count)++] = VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME;
+  return 1;
+}
+
+/* Block compression families; each needs its device feature enabled */
+enum { ENG_COMPRESS_BC = 1u, ENG_COMPRESS_ETC2 = 2u, ENG_COMPRESS_ASTC = 4u };
+
+/* Vulkan format and block size of each cj_format_t; uncompressed formats have 1x1 blocks */
+typedef struct eng_format_t {
+  VkFormat vk_format;
+  uint8_t block_width, block_height;
+  uint8_t block_bytes;   /* 0 = not a valid format */
+  uint8_t compression;   /* ENG_COMPRESS_* family, 0 = none */
+} eng_format_t;
+
+static const eng_format_t eng_formats[] = {
+  [CJ_FORMAT_R8_UNORM]          = { VK_FORMAT_R8_UNORM, 1, 1, 1, 0 },
+  [CJ_FORMAT_RG8_UNORM]         = { VK_FORMAT_R8G8_UNORM, 1, 1, 2, 0 },
+  [CJ_FORMAT_RGBA8_UNORM]       = { VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 4, 0 },
+  [CJ_FORMAT_BGRA8_UNORM]       = { VK_FORMAT_B8G8R8A8_UNORM, 1, 1, 4, 0 },
+  [CJ_FORMAT_R16_FLOAT]         = { VK_FORMAT_R16_SFLOAT, 1, 1, 2, 0 },
+  [CJ_FORMAT_RG16_FLOAT]        = { VK_FORMAT_R16G16_SFLOAT, 1, 1, 4, 0 },
+  [CJ_FORMAT_RGBA16_FLOAT]      = { VK_FORMAT_R16G16B16A16_SFLOAT, 1, 1, 8, 0 },
+  [CJ_FORMAT_R32_FLOAT]         = { VK_FORMAT_R32_SFLOAT, 1, 1, 4, 0 },
+  [CJ_FORMAT_RG32_FLOAT]        = { VK_FORMAT_R32G32_SFLOAT, 1, 1, 8, 0 },
+  [CJ_FORMAT_RGBA32_FLOAT]      = { VK_FORMAT_R32G32B32A32_SFLOAT, 1, 1, 16, 0 },
+  [CJ_FORMAT_D24S8]             = { VK_FORMAT_D24_UNORM_S8_UINT, 1, 1, 4, 0 },
+  [CJ_FORMAT_D32F]              = { VK_FORMAT_D32_SFLOAT, 1, 1, 4, 0 },
+  [CJ_FORMAT_RGBA8_SRGB]        = { VK_FORMAT_R8G8B8A8_SRGB, 1, 1, 4, 0 },
+  [CJ_FORMAT_BC1_RGBA_UNORM]    = { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 4, 8, ENG_COMPRESS_BC },
+  [CJ_FORMAT_BC1_RGBA_SRGB]     = { VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 4, 8, ENG_COMPRESS_BC },
+  [CJ_FORMAT_BC3_UNORM]         = { VK_FORMAT_BC3_UNORM_BLOCK, 4, 4, 16, ENG_COMPRESS_BC },
+  [CJ_FORMAT_BC3_SRGB]          = { VK_FORMAT_BC3_SRGB_BLOCK, 4, 4, 16, ENG_COMPRESS_BC },
+  [CJ_FORMAT_BC5_UNORM]         = { VK_FORMAT_BC5_UNORM_BLOCK, 4, 4, 16, ENG_COMPRESS_BC },
+  [CJ_FORMAT_BC7_UNORM]         = { VK_FORMAT_BC7_UNORM_BLOCK, 4, 4, 16, ENG_COMPRESS_BC },
+  [CJ_FORMAT_BC7_SRGB]          = { VK_FORMAT_BC7_SRGB_BLOCK, 4, 4, 16, ENG_COMPRESS_BC },
+  [CJ_FORMAT_ETC2_RGB8_UNORM]   = { VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, 4, 4, 8, ENG_COMPRESS_ETC2 },
+  [CJ_FORMAT_ETC2_RGB8_SRGB]    = { VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK, 4, 4, 8, ENG_COMPRESS_ETC2 },
+  [CJ_FORMAT_ETC2_RGBA8_UNORM]  = { VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, 4, 4, 16, ENG_COMPRESS_ETC2 },
+  [CJ_FORMAT_ETC2_RGBA8_SRGB]   = { VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, 4, 4, 16, ENG_COMPRESS_ETC2 },
+  [CJ_FORMAT_ASTC_4x4_UNORM]    = { VK_FORMAT_ASTC_4x4_UNORM_BLOCK, 4, 4, 16, ENG_COMPRESS_ASTC },
+  [CJ_FORMAT_ASTC_4x4_SRGB]     = { VK_FORMAT_ASTC_4x4_SRGB_BLOCK, 4, 4, 16, ENG_COMPRESS_ASTC },
+  [CJ_FORMAT_ASTC_6x6_UNORM]    = { VK_FORMAT_ASTC_6x6_UNORM_BLOCK, 6, 6, 16, ENG_COMPRESS_ASTC },
+  [CJ_FORMAT_ASTC_6x6_SRGB]     = { VK_FORMAT_ASTC_6x6_SRGB_BLOCK, 6, 6, 16, ENG_COMPRESS_ASTC },
+  [CJ_FORMAT_ASTC_8x8_UNORM]    = { VK_FORMAT_ASTC_8x8_UNORM_BLOCK, 8, 8, 16, ENG_COMPRESS_ASTC },
+  [CJ_FORMAT_ASTC_8x8_SRGB]     = { VK_FORMAT_ASTC_8x8_SRGB_BLOCK, 8, 8, 16, ENG_COMPRESS_ASTC },
+};
+
+static const eng_format_t* eng_format(cj_format_t format) {
+  if ((unsigned)format >= sizeof(eng_formats) / sizeof(eng_formats[0])) return NULL;
+  return eng_formats[format].block_bytes ? &eng_formats[format] : NULL;
+}
+
 static int eng_create_logical_device(cj_engine_t* e) {
   uint32_t qCount = 0; VkQueueFamilyProperties qProps[16];
   vkGetPhysicalDeviceQueueFamilyProperties(e->physical_device, &qCount, NULL);
@@ -124,55 +369,228 @@ static int eng_create_logical_device(cj_engine_t* e) {
     if (qProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) { gfxIndex = i; found = 1; break; }
   }
   if (!found) return 0;
-  float prio = 1.0f;
-  VkDeviceQueueCreateInfo qci = {0};
-  qci.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-  qci.queueFamilyIndex = gfxIndex;
-  qci.queueCount = 1;
-  qci.pQueuePriorities = &prio;
-  const char* devExt[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+  /* Prefer a transfer-only family (DMA engine), then any non-graphics one that
+   * can copy at texel granularity; otherwise uploads share the graphics queue */
+  uint32_t xferIndex = gfxIndex; int xferScore = 0;
+  for (uint32_t i = 0; i < qCount; ++i) {
+    VkQueueFlags f = qProps[i].queueFlags;
+    VkExtent3D g = qProps[i].minImageTransferGranularity;
+    if ((f & VK_QUEUE_GRAPHICS_BIT) || !(f & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT))) continue;
+    if (g.width != 1 || g.height != 1 || g.depth != 1) continue;
+    int score = (f & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+    if (score > xferScore) { xferIndex = i; xferScore = score; }
+  }
+
+  /* Async compute: a compute family without graphics, preferably apart from uploads.
+   * Sharing the transfer family takes a second queue when it has one */
+  uint32_t computeIndex = gfxIndex, computeQueue = 0; int computeScore = 0;
+  for (uint32_t i = 0; i < qCount; ++i) {
+    VkQueueFlags f = qProps[i].queueFlags;
+    if ((f & VK_QUEUE_GRAPHICS_BIT) || !(f & VK_QUEUE_COMPUTE_BIT)) continue;
+    int score = (i != xferIndex) ? 3 : (qProps[i].queueCount > 1 ? 2 : 1);
+    if (score > computeScore) { computeIndex = i; computeScore = score; }
+  }
+  if (computeScore == 2) computeQueue = 1;
+
+  float prio[2] = { 1.0f, 1.0f };
+  VkDeviceQueueCreateInfo qci[3] = {{0}, {0}, {0}};
+  uint32_t qciCount = 1;
+  qci[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+  qci[0].queueFamilyIndex = gfxIndex;
+  qci[0].queueCount = 1;
+  qci[0].pQueuePriorities = prio;
+  if (xferIndex != gfxIndex) {
+    qci[qciCount] = qci[0];
+    qci[qciCount].queueFamilyIndex = xferIndex;
+    qci[qciCount].queueCount = (computeIndex == xferIndex) ? computeQueue + 1u : 1u;
+    qciCount++;
+  }
+  if (computeIndex != gfxIndex && computeIndex != xferIndex) {
+    qci[qciCount] = qci[0];
+    qci[qciCount].queueFamilyIndex = computeIndex;
+    qciCount++;
+  }
+  const char* devExt[8] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+  uint32_t devExtCount = 1;
+  VkPhysicalDeviceFeatures2 features = {0};
+  VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexing = {0};
+  e->texture_table_supported = eng_query_texture_table(e, &features, &indexing, devExt, &devExtCount);
+  e->incremental_present = eng_has_device_extension(e, VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME);
+  if (e->incremental_present) devExt[devExtCount++] = VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME;
+  e->display_timing = eng_has_device_extension(e, VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+  if (e->display_timing) devExt[devExtCount++] = VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME;
+  /* Per-heap budgets for texture streaming */
+  e->get_memory_properties2 = NULL;
+  if (eng_has_device_extension(e, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+    e->get_memory_properties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(
+        e->instance, "vkGetPhysicalDeviceMemoryProperties2");
+    if (e->get_memory_properties2) devExt[devExtCount++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+  }
+  /* Timeline semaphores order async compute against the frames that feed and consume it */
+  VkPhysicalDeviceTimelineSemaphoreFeatures timeline = {0};
+  timeline.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+  int timelineSupported = 0;
+  PFN_vkGetPhysicalDeviceFeatures2 getFeatures2 =
+      (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(e->instance, "vkGetPhysicalDeviceFeatures2");
+  if (getFeatures2 && eng_has_device_extension(e, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+    VkPhysicalDeviceFeatures2 supported2 = {0};
+    supported2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supported2.pNext = &timeline;
+    getFeatures2(e->physical_device, &supported2);
+    timeline.pNext = NULL;
+    timelineSupported = timeline.timelineSemaphore == VK_TRUE;
+    if (timelineSupported) devExt[devExtCount++] = VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME;
+  }
+
+  /* Enable every block compression family the device samples, for compressed textures */
+  VkPhysicalDeviceFeatures supported = {0};
+  vkGetPhysicalDeviceFeatures(e->physical_device, &supported);
+  VkPhysicalDeviceFeatures* enabled = &features.features;
+  e->compression = 0;
+  if (supported.textureCompressionBC) { enabled->textureCompressionBC = VK_TRUE; e->compression |= ENG_COMPRESS_BC; }
+  if (supported.textureCompressionETC2) { enabled->textureCompressionETC2 = VK_TRUE; e->compression |= ENG_COMPRESS_ETC2; }
+  if (supported.textureCompressionASTC_LDR) { enabled->textureCompressionASTC_LDR = VK_TRUE; e->compression |= ENG_COMPRESS_ASTC; }
+  /* GPU-driven mesh nodes: culling writes one indirect command per object, and the count when it can */
+  e->indirect_draws = supported.multiDrawIndirect && supported.drawIndirectFirstInstance;
+  if (e->indirect_draws) {
+    enabled->multiDrawIndirect = VK_TRUE;
+    enabled->drawIndirectFirstInstance = VK_TRUE;
+  }
+  int indirectCount = e->indirect_draws && eng_has_device_extension(e, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+  if (indirectCount) devExt[devExtCount++] = VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME;
+
   VkDeviceCreateInfo dci = {0};
   dci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-  dci.queueCreateInfoCount = 1;
-  dci.pQueueCreateInfos = &qci;
-  dci.enabledExtensionCount = 1;
+  /* Features go in the features2 chain when there is one */
+  dci.pNext = e->texture_table_supported ? &features : NULL;
+  dci.pEnabledFeatures = e->texture_table_supported ? NULL : enabled;
+  if (timelineSupported) {
+    timeline.pNext = (void*)dci.pNext;
+    dci.pNext = &timeline;
+  }
+  dci.queueCreateInfoCount = qciCount;
+  dci.pQueueCreateInfos = qci;
+  dci.enabledExtensionCount = devExtCount;
   dci.ppEnabledExtensionNames = devExt;
   if (vkCreateDevice(e->physical_device, &dci, NULL, &e->device) != VK_SUCCESS) return 0;
   vkGetDeviceQueue(e->device, gfxIndex, 0, &e->graphics_queue);
   e->present_queue = e->graphics_queue;
+  e->graphics_family = gfxIndex;
+  e->transfer_queue = e->graphics_queue;
+  if (xferIndex != gfxIndex) vkGetDeviceQueue(e->device, xferIndex, 0, &e->transfer_queue);
+  e->transfer_family = xferIndex;
+  e->wait_semaphores = timelineSupported
+      ? (PFN_vkWaitSemaphoresKHR)vkGetDeviceProcAddr(e->device, "vkWaitSemaphoresKHR") : NULL;
+  e->get_semaphore_counter_value = timelineSupported
+      ? (PFN_vkGetSemaphoreCounterValueKHR)vkGetDeviceProcAddr(e->device, "vkGetSemaphoreCounterValueKHR") : NULL;
+  if (e->wait_semaphores && e->get_semaphore_counter_value) {
+    VkSemaphoreTypeCreateInfo type_info = {0};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    VkSemaphoreCreateInfo sem_info = {0};
+    sem_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    sem_info.pNext = &type_info;
+    /* Batches fall back to fences without it */
+    if (vkCreateSemaphore(e->device, &sem_info, NULL, &e->batch_timeline) != VK_SUCCESS) e->batch_timeline = VK_NULL_HANDLE;
+  }
+  e->draw_indexed_indirect_count = indirectCount
+      ? (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(e->device, "vkCmdDrawIndexedIndirectCountKHR") : NULL;
+  /* Without timeline semaphores the compute family has nothing to synchronize with */
+  e->compute_queue = e->graphics_queue;
+  e->compute_family = gfxIndex;
+  if (computeIndex != gfxIndex && e->wait_semaphores) {
+    vkGetDeviceQueue(e->device, computeIndex, computeQueue, &e->compute_queue);
+    e->compute_family = computeIndex;
+  }
   return 1;
 }
 
-static int eng_create_render_pass(cj_engine_t* e) {
+CJ_API VkRenderPass cj_engine_get_render_pass(cj_engine_t* e, const cj_render_pass_key_t* key) {
+  if (!e || !key || e->device == VK_NULL_HANDLE) return VK_NULL_HANDLE;
+  for (uint32_t i = 0; i < e->render_pass_count; i++) {
+    if (memcmp(&e->render_passes[i].key, key, sizeof(*key)) == 0) return e->render_passes[i].pass;
+  }
+  if (e->render_pass_count == e->render_pass_capacity) {
+    uint32_t cap = e->render_pass_capacity ? e->render_pass_capacity * 2u : 4u;
+    void* grown = realloc(e->render_passes, cap * sizeof(*e->render_passes));
+    if (!grown) return VK_NULL_HANDLE;
+    e->render_passes = grown;
+    e->render_pass_capacity = cap;
+  }
+
   VkAttachmentDescription color = {0};
-  VkFormat fmt = (e->color_format != 0) ? e->color_format : VK_FORMAT_B8G8R8A8_SRGB;
-  color.format = fmt;
-  color.samples = VK_SAMPLE_COUNT_1_BIT;
-  color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-  color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-  color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  color.format = key->format;
+  color.samples = key->samples ? key->samples : VK_SAMPLE_COUNT_1_BIT;
+  color.loadOp = key->load_op;
+  color.storeOp = key->store_op;
+  color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+  color.initialLayout = key->initial_layout;
+  color.finalLayout = key->final_layout;
   VkAttachmentReference colorRef = {0}; colorRef.attachment = 0; colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
   VkSubpassDescription sub = {0}; sub.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS; sub.colorAttachmentCount = 1; sub.pColorAttachments = &colorRef;
   VkRenderPassCreateInfo rp = {0}; rp.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO; rp.attachmentCount = 1; rp.pAttachments = &color; rp.subpassCount = 1; rp.pSubpasses = &sub;
-  if (vkCreateRenderPass(e->device, &rp, NULL, &e->render_pass) != VK_SUCCESS) return 0;
+  VkRenderPass pass = VK_NULL_HANDLE;
+  if (vkCreateRenderPass(e->device, &rp, NULL, &pass) != VK_SUCCESS) {
+    fprintf(stderr, "cj_engine_get_render_pass: failed to create a render pass for format %d\n", (int)key->format);
+    return VK_NULL_HANDLE;
+  }
+  e->render_passes[e->render_pass_count].key = *key;
+  e->render_passes[e->render_pass_count].pass = pass;
+  e->render_pass_count++;
+  return pass;
+}
+
+CJ_API VkRenderPass cj_engine_window_render_pass(cj_engine_t* e, VkFormat fmt, bool partial) {
+  if (!e) return VK_NULL_HANDLE;
+  /* An imported context brings its own pass for the engine format */
+  if (fmt == cj_engine_color_format(e) && e->render_pass != VK_NULL_HANDLE) {
+    return partial ? e->partial_render_pass : e->render_pass;
+  }
+  cj_render_pass_key_t key;
+  memset(&key, 0, sizeof(key));  /* Keys are compared bytewise */
+  key.format = fmt;
+  key.samples = VK_SAMPLE_COUNT_1_BIT;
+  key.load_op = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  key.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+  /* Over a presented image the clear is limited to the render area and the rest
+   * keeps its contents. Only layouts differ, so the passes stay compatible. */
+  key.initial_layout = partial ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_UNDEFINED;
+  key.final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  return cj_engine_get_render_pass(e, &key);
+}
+
+static int eng_create_render_pass(cj_engine_t* e) {
+  VkFormat fmt = cj_engine_color_format(e);
+  VkRenderPass full = cj_engine_window_render_pass(e, fmt, false);
+  if (full == VK_NULL_HANDLE) return 0;
+  e->partial_render_pass = cj_engine_window_render_pass(e, fmt, true);
+  e->render_pass = full;
   return 1;
 }
 
-/* Recreate engine render pass if format changed or not created */
+static bool eng_render_pass_cached(const cj_engine_t* e, VkRenderPass pass) {
+  for (uint32_t i = 0; i < e->render_pass_count; i++) {
+    if (e->render_passes[i].pass == pass) return true;
+  }
+  return false;
+}
+
+/* Create the window passes for a swapchain format. Existing passes are never replaced,
+ * so pipelines built against them stay valid. */
 CJ_API int cj_engine_ensure_render_pass(cj_engine_t* e, VkFormat fmt) {
   if (!e) return 0;
-  if (e->render_pass != VK_NULL_HANDLE && e->color_format == fmt) return 1;
-  if (e->render_pass != VK_NULL_HANDLE) {
-    vkDestroyRenderPass(e->device, e->render_pass, NULL);
-    e->render_pass = VK_NULL_HANDLE;
-  }
-  e->color_format = fmt;
-  return eng_create_render_pass(e);
+  if (e->render_pass == VK_NULL_HANDLE && !eng_create_render_pass(e)) return 0;
+  if (cj_engine_window_render_pass(e, fmt, false) == VK_NULL_HANDLE) return 0;
+  cj_engine_window_render_pass(e, fmt, true);
+  return 1;
 }
 
 static int eng_create_command_pool(cj_engine_t* e) {
-  VkCommandPoolCreateInfo pci = {0}; pci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO; pci.queueFamilyIndex = 0;
+  VkCommandPoolCreateInfo pci = {0}; pci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO; pci.queueFamilyIndex = e->graphics_family;
+  /* Per-frame command buffers are re-recorded individually every frame */
+  pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
   if (vkCreateCommandPool(e->device, &pci, NULL, &e->command_pool) != VK_SUCCESS) return 0;
   return 1;
 }
@@ -195,7 +613,7 @@ static int eng_ensure_bindless_descriptors(cj_engine_t* e) {
   if (e->bindless_pool == VK_NULL_HANDLE) {
     VkDescriptorPoolSize poolSize = {0};
     poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSize.descriptorCount = CJ_ENGINE_MAX_TEXTURES;
+    poolSize.descriptorCount = CJ_ENGINE_TEXTURE_TABLE_SIZE;
     VkDescriptorPoolCreateInfo poolInfo = {0};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     poolInfo.poolSizeCount = 1;
@@ -206,39 +624,89 @@ static int eng_ensure_bindless_descriptors(cj_engine_t* e) {
   return 1;
 }
 
+/* The texture table set. Nothing to do when the device cannot back it; textures are then
+ * only reachable through per-node sets. */
+static int eng_ensure_texture_table(cj_engine_t* e) {
+  if (!e || !e->texture_table_supported) return 1;
+  if (e->texture_table != VK_NULL_HANDLE) return 1;
+
+  VkDescriptorSetLayoutBinding binding = {0};
+  binding.binding = 0;
+  binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  binding.descriptorCount = CJ_ENGINE_TEXTURE_TABLE_SIZE;
+  binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+  /* Slots without a live texture are never sampled, and textures are written while
+   * frames that sample other slots are in flight */
+  VkDescriptorBindingFlagsEXT bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+  VkDescriptorSetLayoutBindingFlagsCreateInfoEXT flagsInfo = {0};
+  flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+  flagsInfo.bindingCount = 1;
+  flagsInfo.pBindingFlags = &bindingFlags;
+  VkDescriptorSetLayoutCreateInfo li = {0};
+  li.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  li.pNext = &flagsInfo;
+  li.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+  li.bindingCount = 1;
+  li.pBindings = &binding;
+  if (vkCreateDescriptorSetLayout(e->device, &li, NULL, &e->texture_table_layout) != VK_SUCCESS) return 0;
+
+  VkDescriptorPoolSize size = {0};
+  size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  size.descriptorCount = CJ_ENGINE_TEXTURE_TABLE_SIZE;
+  VkDescriptorPoolCreateInfo pi = {0};
+  pi.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pi.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+  pi.maxSets = 1;
+  pi.poolSizeCount = 1;
+  pi.pPoolSizes = &size;
+  if (vkCreateDescriptorPool(e->device, &pi, NULL, &e->texture_table_pool) != VK_SUCCESS) return 0;
+
+  VkDescriptorSetAllocateInfo ai = {0};
+  ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  ai.descriptorPool = e->texture_table_pool;
+  ai.descriptorSetCount = 1;
+  ai.pSetLayouts = &e->texture_table_layout;
+  if (vkAllocateDescriptorSets(e->device, &ai, &e->texture_table) != VK_SUCCESS) return 0;
+  return 1;
+}
+
 CJ_API cj_engine_t* cj_engine_create(const cj_engine_desc_t* desc) {
   cj_engine_t* engine = (cj_engine_t*)malloc(sizeof(*engine));
   if (!engine) return NULL;
   memset(engine, 0, sizeof(*engine));
   engine->flags = desc ? desc->flags : 0u;
+  if (desc && desc->allocator) engine->host_allocator = *desc->allocator;
+  engine->memory_budget = desc ? desc->memory_budget : 0u;
   if (desc && desc->device_select == CJ_DEVICE_SELECT_INDEX) {
     engine->selected_device_index = desc->requested_device_index;
   } else {
     engine->selected_device_index = 0u; /* default device index for now */
   }
+  if (engine->flags & CJ_ENGINE_ENABLE_THREADING) {
+    /* Without workers the event loop simply keeps rendering windows serially */
+    engine->workers_started = true;
+    engine->workers = cj_worker_pool_create(cj_worker_pool_default_threads());
+    if (!engine->workers) fprintf(stderr, "Warning: Failed to start worker threads, rendering serially\n");
+  }
   return engine;
 }
 
 CJ_API void cj_engine_shutdown(cj_engine_t* engine) {
   if (!engine) return;
   if (g_current_engine == engine) g_current_engine = NULL;
+  cj_asset_cache_destroy(engine->assets);
+  cj_worker_pool_destroy(engine->workers);
+  cj_arena_destroy(engine->frame_arena);
+  res_drain_released(engine);
+  eng_free_tables(engine);
   free(engine);
 }
 
 CJ_API void cj_engine_wait_idle(cj_engine_t* engine) {
-  (void)engine; /* no-op in stub */
-}
-
-static uint32_t eng_find_memory_type(cj_engine_t* e, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties memProperties;
-  vkGetPhysicalDeviceMemoryProperties(e->physical_device, &memProperties);
-
-  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-    if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-      return i;
-    }
-  }
-  return 0; // fallback
+  if (!engine || engine->device == VK_NULL_HANDLE) return;
+  vkDeviceWaitIdle(engine->device);
+  res_drain_released(engine);
+  eng_drain_retired(engine);
 }
 
 static int eng_create_color_pipeline(cj_engine_t* e) {
@@ -257,32 +725,13 @@ static int eng_create_color_pipeline(cj_engine_t* e) {
   };
   VkDeviceSize vbSize = sizeof(vertices);
 
-  VkBufferCreateInfo bufferInfo = {0};
-  bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  bufferInfo.size = vbSize;
-  bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-  bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-  if (vkCreateBuffer(e->device, &bufferInfo, NULL, &cp->vertexBuffer) != VK_SUCCESS) {
+  if (!cj_gpu_create_buffer(e->gpu, vbSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            CJ_GPU_ALLOC_LINEAR, &cp->vertexBuffer, &cp->vertexBufferAlloc)) {
     fprintf(stderr, "Failed to create color pipeline vertex buffer\n");
     return 0;
   }
-
-  VkMemoryRequirements memRequirements;
-  vkGetBufferMemoryRequirements(e->device, cp->vertexBuffer, &memRequirements);
-  VkMemoryAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = eng_find_memory_type(e, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-  if (vkAllocateMemory(e->device, &allocInfo, NULL, &cp->vertexBufferMemory) != VK_SUCCESS) {
-    fprintf(stderr, "Failed to allocate color pipeline vertex buffer memory\n");
-    return 0;
-  }
-  vkBindBufferMemory(e->device, cp->vertexBuffer, cp->vertexBufferMemory, 0);
-
-  void* vdata = NULL;
-  vkMapMemory(e->device, cp->vertexBufferMemory, 0, vbSize, 0, &vdata);
-  memcpy(vdata, vertices, (size_t)vbSize);
-  vkUnmapMemory(e->device, cp->vertexBufferMemory);
+  memcpy(cp->vertexBufferAlloc.mapped, vertices, (size_t)vbSize);
 
   // Create pipeline layout with push constants only
   VkPushConstantRange pushRange = {0};
@@ -301,40 +750,14 @@ static int eng_create_color_pipeline(cj_engine_t* e) {
     return 0;
   }
 
-  // Create shader modules (using generated headers)
-
-  VkShaderModuleCreateInfo vertInfo = {0};
-  vertInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-  vertInfo.codeSize = color_vert_spv_len;
-  vertInfo.pCode = (const uint32_t*)color_vert_spv;
-  VkShaderModule vert = VK_NULL_HANDLE;
-  if (vkCreateShaderModule(e->device, &vertInfo, NULL, &vert) != VK_SUCCESS) {
-    fprintf(stderr, "Failed to create color vertex shader module\n");
-    return 0;
-  }
-
-  VkShaderModuleCreateInfo fragInfo = {0};
-  fragInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-  fragInfo.codeSize = color_frag_spv_len;
-  fragInfo.pCode = (const uint32_t*)color_frag_spv;
-  VkShaderModule frag = VK_NULL_HANDLE;
-  if (vkCreateShaderModule(e->device, &fragInfo, NULL, &frag) != VK_SUCCESS) {
-    fprintf(stderr, "Failed to create color fragment shader module\n");
-    vkDestroyShaderModule(e->device, vert, NULL);
-    return 0;
-  }
+  // Shaders from the generated headers. Through the pipeline cache so windows with other
+  // surface formats get variants; unnamed, as the engine keeps this pipeline for good.
+  cj_pipeline_shader_t shaders[2] = {
+    { VK_SHADER_STAGE_VERTEX_BIT, color_vert_spv, color_vert_spv_len, "main", NULL },
+    { VK_SHADER_STAGE_FRAGMENT_BIT, color_frag_spv, color_frag_spv_len, "main", NULL },
+  };
 
   // Create pipeline
-  VkPipelineShaderStageCreateInfo stages[2] = {0};
-  stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-  stages[0].module = vert;
-  stages[0].pName = "main";
-  stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-  stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-  stages[1].module = frag;
-  stages[1].pName = "main";
-
   VkVertexInputBindingDescription binding = {0};
   binding.binding = 0;
   binding.stride = sizeof(VertexBindless);
@@ -386,20 +809,15 @@ static int eng_create_color_pipeline(cj_engine_t* e) {
 
   VkGraphicsPipelineCreateInfo gp = {0};
   gp.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-  gp.stageCount = 2; gp.pStages = stages;
   gp.pVertexInputState = &vi; gp.pInputAssemblyState = &ia; gp.pViewportState = &vps; gp.pRasterizationState = &rs; gp.pMultisampleState = &ms; gp.pColorBlendState = &cb; gp.pDynamicState = &dynamicState;
   gp.layout = cp->pipelineLayout; gp.renderPass = e->render_pass; gp.subpass = 0;
 
-  if (vkCreateGraphicsPipelines(e->device, VK_NULL_HANDLE, 1, &gp, NULL, &cp->pipeline) != VK_SUCCESS) {
+  cp->pipeline = cj_pipeline_cache_graphics(e->pipelines, &gp, shaders, 2);
+  if (cp->pipeline == VK_NULL_HANDLE) {
     fprintf(stderr, "Failed to create color graphics pipeline\n");
-    vkDestroyShaderModule(e->device, vert, NULL);
-    vkDestroyShaderModule(e->device, frag, NULL);
     return 0;
   }
 
-  vkDestroyShaderModule(e->device, vert, NULL);
-  vkDestroyShaderModule(e->device, frag, NULL);
-
   cp->uv[0]=1.0f; cp->uv[1]=1.0f; cp->uv[2]=0.0f; cp->uv[3]=0.0f;
   cp->colorMul[0]=1.0f; cp->colorMul[1]=1.0f; cp->colorMul[2]=1.0f; cp->colorMul[3]=1.0f;
   return 1;
@@ -411,13 +829,26 @@ CJ_API int cj_engine_init_vulkan(cj_engine_t* engine, int use_validation) {
   if (!eng_create_instance(engine, use_validation)) return 0;
   if (!eng_pick_physical_device(engine)) return 0;
   if (!eng_create_logical_device(engine)) return 0;
+  engine->gpu = cj_gpu_allocator_create(engine->physical_device, engine->device, &engine->host_allocator);
+  if (!engine->gpu) return 0;
+  engine->pipelines = cj_pipeline_cache_create(engine->physical_device, engine->device);
+  if (!engine->pipelines) return 0;
+  cj_pipeline_cache_set_retire(engine->pipelines, eng_retire_pipeline, engine);
   if (!eng_create_render_pass(engine)) return 0;
   if (!eng_create_command_pool(engine)) return 0;
+  engine->uploads = cj_upload_queue_create(engine->device, engine->gpu, engine->graphics_queue, engine->graphics_family,
+                                           engine->transfer_queue, engine->transfer_family, 0);
+  if (!engine->uploads) return 0;
   if (!eng_ensure_bindless_descriptors(engine)) return 0;
+  if (!eng_ensure_texture_table(engine)) {
+    fprintf(stderr, "Failed to create texture table\n");
+    return 0;
+  }
   if (!eng_create_color_pipeline(engine)) {
     fprintf(stderr, "Failed to create color pipeline\n");
     return 0;
   }
+  eng_start_shader_reload(engine);
   return 1;
 }
 
@@ -427,6 +858,14 @@ CJ_API void cj_engine_shutdown_vulkan(cj_engine_t* engine) {
   VkDevice dev = engine->device;
   if (dev != VK_NULL_HANDLE) {
     vkDeviceWaitIdle(dev);
+    /* Assets release their textures and meshes while the resource tables still exist */
+    cj_asset_cache_destroy(engine->assets);
+    engine->assets = NULL;
+    /* Rebuilds not installed yet are dropped; their pipelines were never bound */
+    cj_shader_reload_destroy(engine->shader_reload);
+    engine->shader_reload = NULL;
+    cj_upload_queue_destroy(engine->uploads);
+    engine->uploads = NULL;
     /* Destroy internal pipelines/buffers owned by engine (migration containers) */
     /* Textured */
     {
@@ -434,11 +873,11 @@ CJ_API void cj_engine_shutdown_vulkan(cj_engine_t* engine) {
       if (tx->pipeline) vkDestroyPipeline(dev, tx->pipeline, NULL);
       if (tx->pipelineLayout) vkDestroyPipelineLayout(dev, tx->pipelineLayout, NULL);
       if (tx->vertexBuffer) vkDestroyBuffer(dev, tx->vertexBuffer, NULL);
-      if (tx->vertexBufferMemory) vkFreeMemory(dev, tx->vertexBufferMemory, NULL);
+      cj_gpu_free(engine->gpu, &tx->vertexBufferAlloc);
       if (tx->imageView) vkDestroyImageView(dev, tx->imageView, NULL);
-      if (tx->sampler) vkDestroySampler(dev, tx->sampler, NULL);
+      if (tx->samplerHandle) cj_engine_res_release(engine, CJ_RES_SMP, tx->samplerHandle);
       if (tx->image) vkDestroyImage(dev, tx->image, NULL);
-      if (tx->imageMemory) vkFreeMemory(dev, tx->imageMemory, NULL);
+      cj_gpu_free(engine->gpu, &tx->imageAlloc);
       if (tx->descriptorPool) vkDestroyDescriptorPool(dev, tx->descriptorPool, NULL);
       if (tx->descriptorSetLayout) vkDestroyDescriptorSetLayout(dev, tx->descriptorSetLayout, NULL);
       memset(tx, 0, sizeof(*tx));
@@ -449,48 +888,77 @@ CJ_API void cj_engine_shutdown_vulkan(cj_engine_t* engine) {
       if (bl->pipeline) vkDestroyPipeline(dev, bl->pipeline, NULL);
       if (bl->pipelineLayout) vkDestroyPipelineLayout(dev, bl->pipelineLayout, NULL);
       if (bl->vertexBuffer) vkDestroyBuffer(dev, bl->vertexBuffer, NULL);
-      if (bl->vertexBufferMemory) vkFreeMemory(dev, bl->vertexBufferMemory, NULL);
+      cj_gpu_free(engine->gpu, &bl->vertexBufferAlloc);
       memset(bl, 0, sizeof(*bl));
     }
     /* Color pipeline */
     {
       CJellyBindlessResources* cp = &engine->color_pipeline;
-      if (cp->pipeline) vkDestroyPipeline(dev, cp->pipeline, NULL);
+      cj_pipeline_cache_release(engine->pipelines, cp->pipeline);
       if (cp->pipelineLayout) vkDestroyPipelineLayout(dev, cp->pipelineLayout, NULL);
       if (cp->vertexBuffer) vkDestroyBuffer(dev, cp->vertexBuffer, NULL);
-      if (cp->vertexBufferMemory) vkFreeMemory(dev, cp->vertexBufferMemory, NULL);
+      cj_gpu_free(engine->gpu, &cp->vertexBufferAlloc);
       memset(cp, 0, sizeof(*cp));
     }
+    /* Retired objects may return sets to the node pools */
+    eng_drain_retired(engine);
+    /* Shared node resources */
+    cj_gpu_destroy_buffer(engine->gpu, &engine->shared_quads, &engine->shared_quads_alloc);
+    for (uint32_t i = 0; i < engine->node_pool_count; i++) vkDestroyDescriptorPool(dev, engine->node_pools[i], NULL);
+    engine->node_pool_count = 0;
+    if (engine->node_set_layout) { vkDestroyDescriptorSetLayout(dev, engine->node_set_layout, NULL); engine->node_set_layout = VK_NULL_HANDLE; }
+    if (engine->uniform_set_layout) { vkDestroyDescriptorSetLayout(dev, engine->uniform_set_layout, NULL); engine->uniform_set_layout = VK_NULL_HANDLE; }
     /* Basic */
     {
       CJellyBasicState* bs = &engine->basic;
       if (bs->pipeline) vkDestroyPipeline(dev, bs->pipeline, NULL);
       if (bs->pipelineLayout) vkDestroyPipelineLayout(dev, bs->pipelineLayout, NULL);
       if (bs->vertexBuffer) vkDestroyBuffer(dev, bs->vertexBuffer, NULL);
-      if (bs->vertexBufferMemory) vkFreeMemory(dev, bs->vertexBufferMemory, NULL);
+      cj_gpu_free(engine->gpu, &bs->vertexBufferAlloc);
       memset(bs, 0, sizeof(*bs));
     }
-    /* Destroy all remaining resources in resource tables */
-    for (uint32_t i = 0; i < CJ_ENGINE_MAX_TEXTURES; i++) {
-      if (engine->textures[i].in_use) {
-        cj_engine_destroy_texture(engine, i);
-      }
+    /* Destroy all remaining resources in resource tables, released ones first */
+    res_drain_released(engine);
+    eng_drain_retired(engine);
+    eng_destroy_live_resources(engine);
+    /* Textures destroyed above released their shared samplers */
+    res_drain_released(engine);
+    eng_drain_retired(engine);
+
+    if (engine->flags & CJ_ENGINE_ENABLE_DIAGNOSTICS) {
+      cj_memory_stats_t ms;
+      cj_gpu_allocator_stats(engine->gpu, &ms);
+      printf("GPU memory at shutdown: %u allocations, %llu bytes used of %llu reserved in %u device allocations\n",
+             ms.allocation_count, (unsigned long long)ms.bytes_used, (unsigned long long)ms.bytes_reserved,
+             ms.device_allocations);
     }
-    for (uint32_t i = 0; i < CJ_ENGINE_MAX_BUFFERS; i++) {
-      if (engine->buffers[i].in_use) {
-        cj_engine_destroy_buffer(engine, i);
-      }
+    cj_gpu_allocator_destroy(engine->gpu);
+    engine->gpu = NULL;
+    cj_pipeline_cache_destroy(engine->pipelines);
+    engine->pipelines = NULL;
+
+    for (uint32_t i = 0; i < CJ_ENGINE_BATCH_FENCES; i++) {
+      if (engine->batch_fences[i]) { vkDestroyFence(dev, engine->batch_fences[i], NULL); engine->batch_fences[i] = VK_NULL_HANDLE; }
+      engine->batch_fence_serials[i] = 0;
     }
-    for (uint32_t i = 0; i < CJ_ENGINE_MAX_SAMPLERS; i++) {
-      if (engine->samplers[i].in_use) {
-        cj_engine_destroy_sampler(engine, i);
-      }
-    }
-
+    if (engine->batch_timeline) { vkDestroySemaphore(dev, engine->batch_timeline, NULL); engine->batch_timeline = VK_NULL_HANDLE; }
+    free(engine->batch_submits);
+    engine->batch_submits = NULL;
+    engine->batch_submit_capacity = 0;
     if (engine->command_pool) { vkDestroyCommandPool(dev, engine->command_pool, NULL); engine->command_pool = VK_NULL_HANDLE; }
     if (engine->bindless_pool) { vkDestroyDescriptorPool(dev, engine->bindless_pool, NULL); engine->bindless_pool = VK_NULL_HANDLE; }
     if (engine->bindless_layout) { vkDestroyDescriptorSetLayout(dev, engine->bindless_layout, NULL); engine->bindless_layout = VK_NULL_HANDLE; }
-    if (engine->render_pass) { vkDestroyRenderPass(dev, engine->render_pass, NULL); engine->render_pass = VK_NULL_HANDLE; }
+    if (engine->texture_table_pool) { vkDestroyDescriptorPool(dev, engine->texture_table_pool, NULL); engine->texture_table_pool = VK_NULL_HANDLE; }
+    if (engine->texture_table_layout) { vkDestroyDescriptorSetLayout(dev, engine->texture_table_layout, NULL); engine->texture_table_layout = VK_NULL_HANDLE; }
+    engine->texture_table = VK_NULL_HANDLE;
+    /* Passes of an imported context are not in the cache */
+    if (engine->render_pass && !eng_render_pass_cached(engine, engine->render_pass)) vkDestroyRenderPass(dev, engine->render_pass, NULL);
+    if (engine->partial_render_pass && !eng_render_pass_cached(engine, engine->partial_render_pass)) vkDestroyRenderPass(dev, engine->partial_render_pass, NULL);
+    engine->render_pass = engine->partial_render_pass = VK_NULL_HANDLE;
+    for (uint32_t i = 0; i < engine->render_pass_count; i++) vkDestroyRenderPass(dev, engine->render_passes[i].pass, NULL);
+    free(engine->render_passes);
+    engine->render_passes = NULL;
+    engine->render_pass_count = engine->render_pass_capacity = 0;
     vkDestroyDevice(dev, NULL);
     engine->device = VK_NULL_HANDLE;
   }
@@ -519,9 +987,9 @@ CJ_API uint32_t cj_engine_device_index(const cj_engine_t* engine) {
 }
 
 CJ_API void cj_engine_get_bindless_info(const cj_engine_t* engine, cj_bindless_info_t* out_info) {
-  (void)engine;
   if (!out_info) return;
-  out_info->images_capacity = 0u;
+  /* Slot 0 of the texture table stays null */
+  out_info->images_capacity = (engine && engine->texture_table != VK_NULL_HANDLE) ? CJ_ENGINE_TEXTURE_TABLE_SIZE - 1u : 0u;
   out_info->buffers_capacity = 0u;
   out_info->samplers_capacity = 0u;
 }
@@ -535,16 +1003,302 @@ CJ_API VkDevice cj_engine_device(const cj_engine_t* e) { return e ? e->device :
 CJ_API VkQueue cj_engine_graphics_queue(const cj_engine_t* e) { return e ? e->graphics_queue : VK_NULL_HANDLE; }
 CJ_API VkQueue cj_engine_present_queue(const cj_engine_t* e) { return e ? e->present_queue : VK_NULL_HANDLE; }
 CJ_API VkRenderPass cj_engine_render_pass(const cj_engine_t* e) { return e ? e->render_pass : VK_NULL_HANDLE; }
+CJ_API VkRenderPass cj_engine_partial_render_pass(const cj_engine_t* e) { return e ? e->partial_render_pass : VK_NULL_HANDLE; }
+CJ_API bool cj_engine_incremental_present(const cj_engine_t* e) { return e && e->incremental_present; }
+CJ_API bool cj_engine_display_timing(const cj_engine_t* e) { return e && e->display_timing; }
 CJ_API VkCommandPool cj_engine_command_pool(const cj_engine_t* e) { return e ? e->command_pool : VK_NULL_HANDLE; }
+CJ_API uint32_t cj_engine_graphics_family(const cj_engine_t* e) { return e ? e->graphics_family : 0u; }
+CJ_API VkQueue cj_engine_compute_queue(const cj_engine_t* e) { return e ? e->compute_queue : VK_NULL_HANDLE; }
+CJ_API uint32_t cj_engine_compute_family(const cj_engine_t* e) { return e ? e->compute_family : 0u; }
+CJ_API bool cj_engine_async_compute(const cj_engine_t* e) { return e && e->compute_family != e->graphics_family; }
+CJ_API bool cj_engine_timeline_semaphores(const cj_engine_t* e) { return e && e->wait_semaphores; }
+CJ_API bool cj_engine_indirect_draws(const cj_engine_t* e) { return e && e->indirect_draws; }
+CJ_API PFN_vkCmdDrawIndexedIndirectCountKHR cj_engine_draw_indexed_indirect_count(const cj_engine_t* e) {
+  return e ? e->draw_indexed_indirect_count : NULL;
+}
+CJ_API bool cj_engine_wait_timeline(const cj_engine_t* e, VkSemaphore semaphore, uint64_t value) {
+  if (!e || !e->wait_semaphores || semaphore == VK_NULL_HANDLE) return false;
+  VkSemaphoreWaitInfo wi = {0};
+  wi.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  wi.semaphoreCount = 1;
+  wi.pSemaphores = &semaphore;
+  wi.pValues = &value;
+  return e->wait_semaphores(e->device, &wi, UINT64_MAX) == VK_SUCCESS;
+}
+CJ_API uint32_t cj_engine_flags(const cj_engine_t* e) { return e ? e->flags : 0u; }
+CJ_API cj_worker_pool_t* cj_engine_workers(const cj_engine_t* e) {
+  return e && (e->flags & CJ_ENGINE_ENABLE_THREADING) ? e->workers : NULL;
+}
+CJ_API cj_worker_pool_t* cj_engine_job_workers(cj_engine_t* e) {
+  if (e && !e->workers_started) {
+    e->workers_started = true;
+    e->workers = cj_worker_pool_create(cj_worker_pool_default_threads());
+    if (!e->workers) fprintf(stderr, "Warning: Failed to start worker threads, running jobs inline\n");
+  }
+  return e ? e->workers : NULL;
+}
+CJ_API cj_asset_cache_t* cj_engine_asset_cache(cj_engine_t* e) {
+  if (e && !e->assets) e->assets = cj_asset_cache_create(e);
+  return e ? e->assets : NULL;
+}
+CJ_API cj_gpu_allocator_t* cj_engine_gpu_allocator(const cj_engine_t* e) { return e ? e->gpu : NULL; }
+CJ_API cj_arena_t* cj_engine_frame_arena(const cj_engine_t* e) { return e ? e->frame_arena : NULL; }
+CJ_API uint32_t cj_engine_frame_heap_allocs(const cj_engine_t* e) { return e ? e->frame_heap_allocs : 0u; }
+
+CJ_API void cj_engine_start_frame_memory(cj_engine_t* e) {
+  if (!e) return;
+  /* Entries other threads released since the last frame */
+  res_drain_released(e);
+
+  if (!e->frame_arena) e->frame_arena = cj_arena_create(0);
+  else cj_arena_reset(e->frame_arena);
+  /* Growing the arena to last frame's size is warm-up too, so it is not counted */
+  e->frame_heap_mark = cj_heap_alloc_count();
+  e->frames_started++;
+  cj_heap_count_thread(true);
+}
+
+CJ_API void cj_engine_end_frame_memory(cj_engine_t* e) {
+  if (!e || e->frames_started == 0) return;
+  cj_heap_count_thread(false);
+  e->frame_heap_allocs = (uint32_t)(cj_heap_alloc_count() - e->frame_heap_mark);
+  if ((e->flags & CJ_ENGINE_ENABLE_DIAGNOSTICS) && e->frames_started > CJ_ENGINE_FRAME_WARMUP &&
+      e->frame_heap_allocs != 0) {
+    fprintf(stderr, "cj_engine: frame %llu made %u heap allocations after warm-up\n",
+            (unsigned long long)e->frames_started, e->frame_heap_allocs);
+  }
+}
+CJ_API cj_upload_queue_t* cj_engine_uploads(const cj_engine_t* e) { return e ? e->uploads : NULL; }
+CJ_API cj_pipeline_cache_t* cj_engine_pipelines(const cj_engine_t* e) { return e ? e->pipelines : NULL; }
+CJ_API VkPipelineCache cj_engine_pipeline_cache(const cj_engine_t* e) { return cj_pipeline_cache_handle(e ? e->pipelines : NULL); }
+CJ_API void cj_engine_get_memory_stats(const cj_engine_t* e, cj_memory_stats_t* out_stats) { cj_gpu_allocator_stats(e ? e->gpu : NULL, out_stats); }
+CJ_API VkFormat cj_engine_color_format(const cj_engine_t* e) { return (e && e->color_format != 0) ? e->color_format : VK_FORMAT_B8G8R8A8_SRGB; }
 CJ_API VkDescriptorSetLayout cj_engine_bindless_layout(const cj_engine_t* e) { return e ? e->bindless_layout : VK_NULL_HANDLE; }
 CJ_API VkDescriptorPool      cj_engine_bindless_pool(const cj_engine_t* e) { return e ? e->bindless_pool : VK_NULL_HANDLE; }
+CJ_API VkDescriptorSetLayout cj_engine_texture_table_layout(const cj_engine_t* e) { return e ? e->texture_table_layout : VK_NULL_HANDLE; }
+CJ_API VkDescriptorSet       cj_engine_texture_table(const cj_engine_t* e) { return e ? e->texture_table : VK_NULL_HANDLE; }
 CJ_API CJellyBindlessResources* cj_engine_color_pipeline(const cj_engine_t* e) { return e ? (CJellyBindlessResources*)&e->color_pipeline : NULL; }
 
+CJ_API VkBuffer cj_engine_shared_quad(cj_engine_t* e, cj_engine_quad_t quad, VkDeviceSize* out_offset) {
+  typedef struct { float pos[2]; float uv[2]; } TexturedVertex;
+  typedef struct { float pos[2]; float color[3]; uint32_t texture_id; } ColorVertex;
+  static const TexturedVertex textured[6] = {
+    {{-0.5f, -0.5f}, {0.0f, 0.0f}}, {{ 0.5f, -0.5f}, {1.0f, 0.0f}}, {{ 0.5f,  0.5f}, {1.0f, 1.0f}},
+    {{ 0.5f,  0.5f}, {1.0f, 1.0f}}, {{-0.5f,  0.5f}, {0.0f, 1.0f}}, {{-0.5f, -0.5f}, {0.0f, 0.0f}},
+  };
+  static const ColorVertex color[6] = {
+    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, 0}, {{ 0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, 0}, {{ 0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}, 0},
+    {{ 0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}, 0}, {{-0.5f,  0.5f}, {1.0f, 1.0f, 0.0f}, 0}, {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, 0},
+  };
+  const VkDeviceSize offsets[CJ_ENGINE_QUAD_COUNT] = { 0, sizeof(textured) };
+  if (!e || !e->gpu || !e->uploads || (unsigned)quad >= CJ_ENGINE_QUAD_COUNT) return VK_NULL_HANDLE;
+
+  if (e->shared_quads == VK_NULL_HANDLE) {
+    VkDeviceSize size = sizeof(textured) + sizeof(color);
+    if (!cj_gpu_create_buffer(e->gpu, size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, CJ_GPU_ALLOC_LINEAR,
+                              &e->shared_quads, &e->shared_quads_alloc)) {
+      fprintf(stderr, "cj_engine_shared_quad: failed to create the shared quad buffer\n");
+      return VK_NULL_HANDLE;
+    }
+    /* The copy is submitted with the first frame that draws from the buffer */
+    unsigned char* staged = (unsigned char*)cj_upload_queue_stage_buffer(e->uploads, e->shared_quads, 0, size, NULL);
+    if (!staged) {
+      cj_gpu_destroy_buffer(e->gpu, &e->shared_quads, &e->shared_quads_alloc);
+      return VK_NULL_HANDLE;
+    }
+    memcpy(staged + offsets[CJ_ENGINE_QUAD_TEXTURED], textured, sizeof(textured));
+    memcpy(staged + offsets[CJ_ENGINE_QUAD_COLOR], color, sizeof(color));
+  }
+  if (out_offset) *out_offset = offsets[quad];
+  return e->shared_quads;
+}
+
+CJ_API VkDescriptorSetLayout cj_engine_node_set_layout(cj_engine_t* e) {
+  if (!e || !e->device) return VK_NULL_HANDLE;
+  if (e->node_set_layout == VK_NULL_HANDLE) {
+    VkDescriptorSetLayoutBinding binding = {0};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutCreateInfo li = {0};
+    li.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    li.bindingCount = 1;
+    li.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(e->device, &li, NULL, &e->node_set_layout) != VK_SUCCESS) {
+      e->node_set_layout = VK_NULL_HANDLE;
+    }
+  }
+  return e->node_set_layout;
+}
+
+CJ_API VkDescriptorSetLayout cj_engine_uniform_set_layout(cj_engine_t* e) {
+  if (!e || !e->device) return VK_NULL_HANDLE;
+  if (e->uniform_set_layout == VK_NULL_HANDLE) {
+    VkDescriptorSetLayoutBinding binding = {0};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutCreateInfo li = {0};
+    li.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    li.bindingCount = 1;
+    li.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(e->device, &li, NULL, &e->uniform_set_layout) != VK_SUCCESS) {
+      e->uniform_set_layout = VK_NULL_HANDLE;
+    }
+  }
+  return e->uniform_set_layout;
+}
+
+CJ_API VkDescriptorSet cj_engine_alloc_node_set(cj_engine_t* e, VkDescriptorPool* out_pool) {
+  VkDescriptorSetLayout layout = cj_engine_node_set_layout(e);
+  if (layout == VK_NULL_HANDLE || !out_pool) return VK_NULL_HANDLE;
+
+  VkDescriptorSetAllocateInfo ai = {0};
+  ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  ai.descriptorSetCount = 1;
+  ai.pSetLayouts = &layout;
+  VkDescriptorSet set = VK_NULL_HANDLE;
+  /* Newest pool first: older ones are usually full */
+  for (uint32_t i = e->node_pool_count; i-- > 0;) {
+    ai.descriptorPool = e->node_pools[i];
+    if (vkAllocateDescriptorSets(e->device, &ai, &set) == VK_SUCCESS) {
+      *out_pool = e->node_pools[i];
+      return set;
+    }
+  }
+  if (e->node_pool_count == CJ_ENGINE_NODE_POOLS) {
+    fprintf(stderr, "cj_engine_alloc_node_set: all %u node descriptor pools are full\n", CJ_ENGINE_NODE_POOLS);
+    return VK_NULL_HANDLE;
+  }
+
+  VkDescriptorPoolSize size = {0};
+  size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  size.descriptorCount = CJ_ENGINE_NODE_POOL_SETS;
+  VkDescriptorPoolCreateInfo pi = {0};
+  pi.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pi.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+  pi.maxSets = CJ_ENGINE_NODE_POOL_SETS;
+  pi.poolSizeCount = 1;
+  pi.pPoolSizes = &size;
+  VkDescriptorPool pool = VK_NULL_HANDLE;
+  if (vkCreateDescriptorPool(e->device, &pi, NULL, &pool) != VK_SUCCESS) return VK_NULL_HANDLE;
+  e->node_pools[e->node_pool_count++] = pool;
+  ai.descriptorPool = pool;
+  if (vkAllocateDescriptorSets(e->device, &ai, &set) != VK_SUCCESS) return VK_NULL_HANDLE;
+  *out_pool = pool;
+  return set;
+}
+
+CJ_API void cj_engine_free_node_set(cj_engine_t* e, VkDescriptorPool pool, VkDescriptorSet set) {
+  if (!e || !e->device || pool == VK_NULL_HANDLE || set == VK_NULL_HANDLE) return;
+  vkFreeDescriptorSets(e->device, pool, 1, &set);
+}
+
 /* Internal access to textured resources */
 CJ_API CJellyTexturedResources* cj_engine_textured(const cj_engine_t* e) { return (CJellyTexturedResources*)(e ? &e->textured : NULL); }
 CJ_API CJellyBindlessState* cj_engine_bindless(const cj_engine_t* e) { return (CJellyBindlessState*)(e ? &e->bindless : NULL); }
 CJ_API CJellyBasicState* cj_engine_basic(const cj_engine_t* e) { return (CJellyBasicState*)(e ? &e->basic : NULL); }
 
+/*
+ * Pick the fence for the next batched submission. The ring slot's previous batch
+ * is waited for before the fence is reset, so a serial that no longer owns its
+ * slot is known to have finished.
+ */
+CJ_API VkFence cj_engine_begin_batch(cj_engine_t* e, uint64_t* out_serial) {
+  if (!e || !e->device || !out_serial) return VK_NULL_HANDLE;
+  uint32_t slot = (uint32_t)(e->batch_serial % CJ_ENGINE_BATCH_FENCES);
+
+  if (e->batch_fences[slot] == VK_NULL_HANDLE) {
+    VkFenceCreateInfo fi = {0};
+    fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(e->device, &fi, NULL, &e->batch_fences[slot]) != VK_SUCCESS) {
+      e->batch_fences[slot] = VK_NULL_HANDLE;
+      return VK_NULL_HANDLE;
+    }
+  } else if (e->batch_fence_serials[slot] != 0) {
+    vkWaitForFences(e->device, 1, &e->batch_fences[slot], VK_TRUE, UINT64_MAX);
+    if (e->batch_fence_serials[slot] > e->batch_completed) e->batch_completed = e->batch_fence_serials[slot];
+    vkResetFences(e->device, 1, &e->batch_fences[slot]);
+  }
+
+  e->batch_fence_serials[slot] = ++e->batch_serial;
+  *out_serial = e->batch_serial;
+  return e->batch_fences[slot];
+}
+
+/*
+ * Submit to the graphics queue in one call and return the batch serial. With the
+ * timeline, a trailing signal-only submission sets it to the serial; like a fence,
+ * that signal covers everything submitted to the queue before it.
+ */
+CJ_API uint64_t cj_engine_submit_batch(cj_engine_t* e, uint32_t count, const VkSubmitInfo* submits) {
+  if (!e || !e->device || !e->graphics_queue || (count > 0 && !submits)) return 0;
+
+  if (e->batch_timeline == VK_NULL_HANDLE) {
+    uint32_t slot = (uint32_t)(e->batch_serial % CJ_ENGINE_BATCH_FENCES);
+    uint64_t serial = 0;
+    VkFence fence = cj_engine_begin_batch(e, &serial);
+    if (fence == VK_NULL_HANDLE) return 0;
+    if (vkQueueSubmit(e->graphics_queue, count, submits, fence) != VK_SUCCESS) {
+      /* Nothing will signal the fence; leave the slot unused */
+      e->batch_fence_serials[slot] = 0;
+      return 0;
+    }
+    return serial;
+  }
+
+  if (count + 1u > e->batch_submit_capacity) {
+    uint32_t capacity = e->batch_submit_capacity ? e->batch_submit_capacity : 8u;
+    while (capacity < count + 1u) capacity *= 2u;
+    VkSubmitInfo* grown = (VkSubmitInfo*)realloc(e->batch_submits, capacity * sizeof(VkSubmitInfo));
+    if (!grown) return 0;
+    cj_heap_note_alloc();
+    e->batch_submits = grown;
+    e->batch_submit_capacity = capacity;
+  }
+  if (count > 0) memcpy(e->batch_submits, submits, count * sizeof(VkSubmitInfo));
+
+  uint64_t serial = e->batch_serial + 1u;
+  VkTimelineSemaphoreSubmitInfo timeline = {0};
+  timeline.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  timeline.signalSemaphoreValueCount = 1;
+  timeline.pSignalSemaphoreValues = &serial;
+  VkSubmitInfo* signal = &e->batch_submits[count];
+  memset(signal, 0, sizeof(*signal));
+  signal->sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  signal->pNext = &timeline;
+  signal->signalSemaphoreCount = 1;
+  signal->pSignalSemaphores = &e->batch_timeline;
+  if (vkQueueSubmit(e->graphics_queue, count + 1u, e->batch_submits, VK_NULL_HANDLE) != VK_SUCCESS) return 0;
+  e->batch_serial = serial;
+  return serial;
+}
+
+CJ_API bool cj_engine_batch_done(const cj_engine_t* e, uint64_t serial) {
+  if (!e || serial == 0 || serial <= e->batch_completed) return true;
+  if (e->batch_timeline != VK_NULL_HANDLE) {
+    uint64_t value = 0;
+    return e->get_semaphore_counter_value(e->device, e->batch_timeline, &value) == VK_SUCCESS && value >= serial;
+  }
+  uint32_t slot = (uint32_t)((serial - 1) % CJ_ENGINE_BATCH_FENCES);
+  if (e->batch_fence_serials[slot] != serial) return true;
+  return vkGetFenceStatus(e->device, e->batch_fences[slot]) == VK_SUCCESS;
+}
+
+CJ_API void cj_engine_wait_batch(const cj_engine_t* e, uint64_t serial) {
+  if (!e || serial == 0 || serial <= e->batch_completed) return;
+  if (e->batch_timeline != VK_NULL_HANDLE) {
+    cj_engine_wait_timeline(e, e->batch_timeline, serial);
+    return;
+  }
+  uint32_t slot = (uint32_t)((serial - 1) % CJ_ENGINE_BATCH_FENCES);
+  if (e->batch_fence_serials[slot] != serial) return;
+  vkWaitForFences(e->device, 1, &e->batch_fences[slot], VK_TRUE, UINT64_MAX);
+}
+
 CJ_API void cj_engine_import_context(cj_engine_t* engine, const CJellyVulkanContext* ctx) {
   if (!engine || !ctx) return;
   engine->instance = ctx->instance;
@@ -554,11 +1308,23 @@ CJ_API void cj_engine_import_context(cj_engine_t* engine, const CJellyVulkanCont
   engine->present_queue = ctx->presentQueue;
   engine->render_pass = ctx->renderPass;
   engine->command_pool = ctx->commandPool;
-
-  /* Initialize resource tables */
-  memset(engine->textures, 0, sizeof(engine->textures));
-  memset(engine->buffers, 0, sizeof(engine->buffers));
-  memset(engine->samplers, 0, sizeof(engine->samplers));
+  if (!engine->gpu && engine->device) {
+    engine->gpu = cj_gpu_allocator_create(engine->physical_device, engine->device, &engine->host_allocator);
+  }
+  if (!engine->pipelines && engine->device) {
+    engine->pipelines = cj_pipeline_cache_create(engine->physical_device, engine->device);
+    cj_pipeline_cache_set_retire(engine->pipelines, eng_retire_pipeline, engine);
+    eng_start_shader_reload(engine);
+  }
+  engine->transfer_queue = engine->graphics_queue;
+  engine->transfer_family = engine->graphics_family;
+  engine->compute_queue = engine->graphics_queue;
+  engine->compute_family = engine->graphics_family;
+  engine->wait_semaphores = NULL;
+  if (!engine->uploads && engine->gpu) {
+    engine->uploads = cj_upload_queue_create(engine->device, engine->gpu, engine->graphics_queue, engine->graphics_family,
+                                             engine->transfer_queue, engine->transfer_family, 0);
+  }
 
   /* Initialize internal textured container */
   memset(&engine->textured, 0, sizeof(engine->textured));
@@ -568,13 +1334,8 @@ CJ_API void cj_engine_import_context(cj_engine_t* engine, const CJellyVulkanCont
   memset(&engine->basic, 0, sizeof(engine->basic));
 }
 
-static inline cj_res_entry_t* table_for(cj_engine_t* e, cj_res_kind_t kind, size_t* out_cap) {
-  switch (kind) {
-    case CJ_RES_TEX: *out_cap = CJ_ENGINE_MAX_TEXTURES; return e->textures;
-    case CJ_RES_BUF: *out_cap = CJ_ENGINE_MAX_BUFFERS;  return e->buffers;
-    case CJ_RES_SMP: *out_cap = CJ_ENGINE_MAX_SAMPLERS; return e->samplers;
-  }
-  *out_cap = 0; return NULL;
+static inline cj_res_table_t* table_for(cj_engine_t* e, cj_res_kind_t kind) {
+  return ((unsigned)kind < 3u) ? &e->tables[kind] : NULL;
 }
 
 static inline uint64_t make_handle(uint32_t index, uint32_t gen) {
@@ -586,57 +1347,540 @@ static inline void split_handle(uint64_t h, uint32_t* out_index, uint32_t* out_g
   *out_gen = (uint32_t)(h & 0xffffffffu);
 }
 
-CJ_API uint64_t cj_engine_res_alloc(cj_engine_t* e, cj_res_kind_t kind, uint32_t* out_slot) {
+/* Fields of cj_res_hot_t.state */
+static inline uint64_t res_state(uint32_t gen, uint32_t count) {
+  return ((uint64_t)gen << 32) | (uint64_t)count;
+}
+static inline uint32_t res_state_gen(uint64_t state) { return (uint32_t)(state >> 32); }
+static inline uint32_t res_state_count(uint64_t state) { return (uint32_t)(state & 0xffffffffu); }
+
+static void* eng_host_alloc(const cj_engine_t* e, size_t size) {
+  const cj_allocator_t* host = &e->host_allocator;
+  void* p = host->alloc ? host->alloc(host->user, size, 64) : malloc(size);
+  if (p) memset(p, 0, size);
+  return p;
+}
+
+static void eng_host_free(const cj_engine_t* e, void* p) {
+  if (!p) return;
+  if (e->host_allocator.free) e->host_allocator.free(e->host_allocator.user, p);
+  else free(p);
+}
+
+/* Hot half of an entry; any thread. NULL past the allocated pages. */
+static inline cj_res_hot_t* res_hot(cj_res_table_t* t, uint32_t index) {
+  uint32_t page = index >> CJ_RES_PAGE_SHIFT;
+  if (page >= CJ_RES_MAX_PAGES) return NULL;
+  cj_res_hot_t* hot = atomic_load_explicit(&t->hot[page], memory_order_acquire);
+  return hot ? &hot[index & (CJ_RES_PAGE_SIZE - 1u)] : NULL;
+}
+
+/* Cold half of an entry; engine thread only */
+static inline cj_res_cold_t* res_cold(cj_res_table_t* t, uint32_t index) {
+  uint32_t page = index >> CJ_RES_PAGE_SHIFT;
+  if (page >= t->page_count) return NULL;
+  return &t->cold[page][index & (CJ_RES_PAGE_SIZE - 1u)];
+}
+
+/* Hot half of the live entry a handle names, or NULL */
+static inline cj_res_hot_t* res_lookup(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle, uint32_t* out_index) {
+  cj_res_table_t* t = (e && handle) ? table_for(e, kind) : NULL;
+  if (!t) return NULL;
+  uint32_t idx, gen; split_handle(handle, &idx, &gen);
+  cj_res_hot_t* hot = res_hot(t, idx);
+  if (!hot) return NULL;
+  uint64_t state = atomic_load_explicit(&hot->state, memory_order_acquire);
+  if (res_state_count(state) == 0 || res_state_gen(state) != gen) return NULL;
+  if (out_index) *out_index = idx;
+  return hot;
+}
+
+/* Cold half of a live entry by index, or NULL */
+static inline cj_res_cold_t* res_live(cj_engine_t* e, cj_res_kind_t kind, uint32_t index) {
+  cj_res_table_t* t = table_for(e, kind);
+  cj_res_hot_t* hot = t ? res_hot(t, index) : NULL;
+  if (!hot || res_state_count(atomic_load_explicit(&hot->state, memory_order_acquire)) == 0) return NULL;
+  return res_cold(t, index);
+}
+
+static inline void res_push_free(cj_res_table_t* t, uint32_t index) {
+  uint32_t* head = &t->free_head[index >= CJ_ENGINE_TEXTURE_TABLE_SIZE];
+  res_cold(t, index)->next_free = *head;
+  *head = index;
+}
+
+/* Add a page and push its entries on the free lists, lowest index first out */
+static bool res_grow(cj_engine_t* e, cj_res_table_t* t) {
+  if (t->page_count >= CJ_RES_MAX_PAGES) return false;
+  uint32_t page = t->page_count;
+  cj_res_hot_t* hot = (cj_res_hot_t*)eng_host_alloc(e, sizeof(cj_res_hot_t) * CJ_RES_PAGE_SIZE);
+  cj_res_cold_t* cold = (cj_res_cold_t*)eng_host_alloc(e, sizeof(cj_res_cold_t) * CJ_RES_PAGE_SIZE);
+  if (!hot || !cold) {
+    eng_host_free(e, hot);
+    eng_host_free(e, cold);
+    return false;
+  }
+  t->cold[page] = cold;
+  t->page_count = page + 1u;
+  uint32_t base = page << CJ_RES_PAGE_SHIFT;
+  for (uint32_t i = CJ_RES_PAGE_SIZE; i-- > 0;) {
+    atomic_init(&hot[i].state, res_state(1u, 0u));
+    if (base + i != 0) res_push_free(t, base + i); /* 0 stays null */
+  }
+  atomic_store_explicit(&t->hot[page], hot, memory_order_release);
+  return true;
+}
+
+static void res_destroy_objects(cj_engine_t* e, cj_res_kind_t kind, uint32_t index) {
+  switch (kind) {
+    case CJ_RES_TEX: cj_engine_destroy_texture(e, index); break;
+    case CJ_RES_BUF: cj_engine_destroy_buffer(e, index); break;
+    case CJ_RES_SMP: cj_engine_destroy_sampler(e, index); break;
+  }
+}
+
+static void res_discard_uploads(cj_engine_t* e, cj_res_kind_t kind, uint32_t index) {
+  cj_res_cold_t* entry = res_cold(table_for(e, kind), index);
+  if (!entry || !e->uploads) return;
+  if (kind == CJ_RES_TEX && entry->vulkan.texture.image) cj_upload_queue_discard_image(e->uploads, entry->vulkan.texture.image);
+  if (kind == CJ_RES_BUF && entry->vulkan.buffer.buffer) cj_upload_queue_discard_buffer(e->uploads, entry->vulkan.buffer.buffer);
+}
+
+static void eng_destroy_live_resources(cj_engine_t* e) {
+  for (uint32_t k = 0; k < 3u; ++k) {
+    cj_res_table_t* t = &e->tables[k];
+    uint32_t count = t->page_count << CJ_RES_PAGE_SHIFT;
+    for (uint32_t i = 1; i < count; ++i) {
+      if (res_state_count(atomic_load_explicit(&res_hot(t, i)->state, memory_order_relaxed)) != 0) {
+        res_destroy_objects(e, (cj_res_kind_t)k, i);
+      }
+    }
+  }
+}
+
+static void eng_free_tables(cj_engine_t* e) {
+  for (uint32_t k = 0; k < 3u; ++k) {
+    cj_res_table_t* t = &e->tables[k];
+    for (uint32_t p = 0; p < t->page_count; ++p) {
+      eng_host_free(e, atomic_load_explicit(&t->hot[p], memory_order_relaxed));
+      eng_host_free(e, t->cold[p]);
+    }
+    memset(t, 0, sizeof(*t));
+  }
+  eng_host_free(e, e->retired);
+  e->retired = NULL;
+  free(e->streamed);
+  e->streamed = NULL;
+  e->streamed_count = e->streamed_capacity = 0;
+  eng_host_free(e, e->sampler_cache);
+  e->sampler_cache = NULL;
+  e->sampler_cache_capacity = e->sampler_cache_count = 0;
+  e->retired_head = e->retired_count = e->retired_capacity = e->retired_untagged = 0;
+}
+
+/* Destroy a released entry's objects and make its index available again */
+static void res_free_retired(cj_engine_t* e, cj_res_kind_t kind, uint32_t index) {
+  cj_res_table_t* t = table_for(e, kind);
+  res_destroy_objects(e, kind, index);
+  res_push_free(t, index);
+  --t->live;
+}
+
+/* Destroy a texture image and view with their memory */
+static void eng_destroy_storage(cj_engine_t* e, VkImage image, VkImageView view, cj_gpu_alloc_t* alloc) {
+  if (view != VK_NULL_HANDLE) vkDestroyImageView(e->device, view, NULL);
+  if (image != VK_NULL_HANDLE) vkDestroyImage(e->device, image, NULL);
+  cj_gpu_free(e->gpu, alloc);
+}
+
+/* Destroy objects handed to cj_engine_retire */
+static void eng_destroy_garbage(cj_engine_t* e, const cj_engine_garbage_t* g) {
+  cj_engine_free_node_set(e, g->set_pool, g->set);
+  if (g->pool != VK_NULL_HANDLE) vkDestroyDescriptorPool(e->device, g->pool, NULL);
+  if (g->framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(e->device, g->framebuffer, NULL);
+  if (g->view != VK_NULL_HANDLE) vkDestroyImageView(e->device, g->view, NULL);
+  if (g->image != VK_NULL_HANDLE) vkDestroyImage(e->device, g->image, NULL);
+  if (g->buffer != VK_NULL_HANDLE) vkDestroyBuffer(e->device, g->buffer, NULL);
+  cj_gpu_alloc_t alloc = g->alloc;
+  cj_gpu_free(e->gpu, &alloc);
+  if (g->memory != VK_NULL_HANDLE) vkFreeMemory(e->device, g->memory, NULL);
+}
+
+/* Destroy a deletion queue entry whose batch finished */
+static void res_free_entry(cj_engine_t* e, const cj_res_retired_t* r) {
+  if (r->has_garbage) {
+    eng_destroy_garbage(e, &r->garbage);
+  } else if (r->pipeline != VK_NULL_HANDLE) {
+    vkDestroyPipeline(e->device, r->pipeline, NULL);
+  } else if (r->image != VK_NULL_HANDLE) {
+    cj_gpu_alloc_t alloc = r->alloc;
+    e->stream_retired_bytes -= alloc.size;
+    eng_destroy_storage(e, r->image, r->view, &alloc);
+  } else {
+    res_free_retired(e, r->kind, r->index);
+  }
+}
+
+/* Append a released entry (or a replaced pipeline) to the deletion queue; false when it cannot grow */
+static bool res_retire(cj_engine_t* e, cj_res_kind_t kind, uint32_t index, VkPipeline pipeline) {
+  if (e->retired_count == e->retired_capacity) {
+    uint32_t cap = e->retired_capacity ? e->retired_capacity * 2u : 64u;
+    cj_res_retired_t* grown = (cj_res_retired_t*)eng_host_alloc(e, sizeof(cj_res_retired_t) * cap);
+    if (!grown) return false;
+    for (uint32_t i = 0; i < e->retired_count; ++i) {
+      grown[i] = e->retired[(e->retired_head + i) % e->retired_capacity];
+    }
+    eng_host_free(e, e->retired);
+    e->retired = grown;
+    e->retired_head = 0;
+    e->retired_capacity = cap;
+  }
+  cj_res_retired_t* r = &e->retired[(e->retired_head + e->retired_count) % e->retired_capacity];
+  memset(r, 0, sizeof(*r));
+  r->index = index;
+  r->kind = kind;
+  r->pipeline = pipeline;
+  ++e->retired_count;
+  ++e->retired_untagged;
+  return true;
+}
+
+/* Queue storage a streamed texture replaced, which frames in flight may still sample */
+static void res_retire_storage(cj_engine_t* e, VkImage image, VkImageView view, cj_gpu_alloc_t* alloc) {
+  if (!res_retire(e, CJ_RES_TEX, 0, VK_NULL_HANDLE)) {
+    fprintf(stderr, "res_retire_storage: could not grow the deletion queue, waiting for the device\n");
+    vkDeviceWaitIdle(e->device);
+    eng_destroy_storage(e, image, view, alloc);
+    return;
+  }
+  cj_res_retired_t* r = &e->retired[(e->retired_head + e->retired_count - 1u) % e->retired_capacity];
+  r->image = image;
+  r->view = view;
+  r->alloc = *alloc;
+  e->stream_retired_bytes += alloc->size;
+  memset(alloc, 0, sizeof(*alloc));
+}
+
+CJ_API void cj_engine_retire(cj_engine_t* e, const cj_engine_garbage_t* garbage) {
+  if (!e || !garbage || e->device == VK_NULL_HANDLE) return;
+  if (!res_retire(e, CJ_RES_TEX, 0, VK_NULL_HANDLE)) {
+    fprintf(stderr, "cj_engine_retire: could not grow the deletion queue, waiting for the device\n");
+    vkDeviceWaitIdle(e->device);
+    eng_destroy_garbage(e, garbage);
+    return;
+  }
+  cj_res_retired_t* r = &e->retired[(e->retired_head + e->retired_count - 1u) % e->retired_capacity];
+  r->has_garbage = true;
+  r->garbage = *garbage;
+}
+
+/*
+ * Cover the untagged entries with an empty batch. A batch submitted without work
+ * completes once everything submitted to the queue before it has finished, whichever
+ * path submitted it (windows, offscreen targets, uploads). With fences, skipped while
+ * the batch ring slot is still busy, so this never waits.
+ */
+static void res_tag_retired(cj_engine_t* e) {
+  if (e->retired_untagged == 0 || e->device == VK_NULL_HANDLE || e->graphics_queue == VK_NULL_HANDLE) return;
+  if (e->batch_timeline == VK_NULL_HANDLE) {
+    uint32_t slot = (uint32_t)(e->batch_serial % CJ_ENGINE_BATCH_FENCES);
+    if (!cj_engine_batch_done(e, e->batch_fence_serials[slot])) return;
+  }
+
+  /* On failure the entries stay untagged and are retried next time */
+  uint64_t serial = cj_engine_submit_batch(e, 0, NULL);
+  if (serial == 0) return;
+  for (uint32_t i = e->retired_count - e->retired_untagged; i < e->retired_count; ++i) {
+    e->retired[(e->retired_head + i) % e->retired_capacity].serial = serial;
+  }
+  e->retired_untagged = 0;
+}
+
+/* Free every queued entry; the device must be idle */
+static void eng_drain_retired(cj_engine_t* e) {
+  while (e->retired_count > 0) {
+    cj_res_retired_t r = e->retired[e->retired_head];
+    e->retired_head = (e->retired_head + 1u) % e->retired_capacity;
+    --e->retired_count;
+    res_free_entry(e, &r);
+  }
+  e->retired_head = 0;
+  e->retired_untagged = 0;
+}
+
+CJ_API uint32_t cj_engine_collect_garbage(cj_engine_t* e, uint32_t budget_us) {
   if (!e) return 0;
-  size_t cap = 0; cj_res_entry_t* table = table_for(e, kind, &cap);
-  if (!table || cap == 0) return 0;
-  for (uint32_t i = 1; i < cap; ++i) { /* start at 1 so 0 stays null */
-    if (!table[i].in_use) {
-      table[i].in_use = 1;
-      table[i].refcount = 1;
-      uint32_t newgen = table[i].generation + 1u;
-      if (newgen == 0u) newgen = 1u;
-      table[i].generation = newgen;
-      table[i].slot = i; /* trivial mapping in stub */
-      if (out_slot) *out_slot = table[i].slot;
-      return make_handle(i, table[i].generation);
+  uint64_t start = budget_us ? cj_pacer_now_us() : 0;
+  uint32_t freed = 0;
+  res_drain_released(e);
+  // Serials grow from head to tail, so the first unfinished entry ends the pass
+  while (e->retired_count > e->retired_untagged) {
+    cj_res_retired_t r = e->retired[e->retired_head];
+    if (!cj_engine_batch_done(e, r.serial)) break;
+    e->retired_head = (e->retired_head + 1u) % e->retired_capacity;
+    --e->retired_count;
+    res_free_entry(e, &r);
+    ++freed;
+    if (budget_us && cj_pacer_now_us() - start >= budget_us) break;
+  }
+  res_tag_retired(e);
+  return freed;
+}
+
+/* Pipeline cache retire callback: the released or replaced pipeline may still be in frames in flight */
+static void eng_retire_pipeline(void* user, VkPipeline pipeline) {
+  cj_engine_t* e = (cj_engine_t*)user;
+  if (!res_retire(e, CJ_RES_TEX, 0, pipeline)) {
+    fprintf(stderr, "eng_retire_pipeline: could not grow the deletion queue, waiting for the device\n");
+    vkDeviceWaitIdle(e->device);
+    vkDestroyPipeline(e->device, pipeline, NULL);
+  }
+}
+
+/* Set up shader reload before anything creates a shared pipeline */
+static void eng_start_shader_reload(cj_engine_t* e) {
+  if (!(e->flags & CJ_ENGINE_ENABLE_SHADER_RELOAD) || !e->pipelines || e->shader_reload) return;
+  cj_pipeline_cache_enable_reload(e->pipelines);
+  e->shader_reload = cj_shader_reload_create(e->pipelines, NULL);
+}
+
+CJ_API bool cj_engine_poll_shader_reload(cj_engine_t* e) {
+  return e ? cj_shader_reload_poll(e->shader_reload) : false;
+}
+
+static cj_sampler_key_t sampler_key(const cj_sampler_desc_t* desc) {
+  cj_sampler_key_t key;
+  memset(&key, 0, sizeof(key));
+  key.min_filter = (uint8_t)desc->min_filter;
+  key.mag_filter = (uint8_t)desc->mag_filter;
+  key.address_u = (uint8_t)desc->address_u;
+  key.address_v = (uint8_t)desc->address_v;
+  key.address_w = (uint8_t)desc->address_w;
+  /* Adding 0 folds -0.0 into 0.0; anisotropy at or below 0 is disabled either way */
+  key.mip_lod_bias = desc->mip_lod_bias + 0.0f;
+  key.max_anisotropy = desc->max_anisotropy > 0.0f ? desc->max_anisotropy : 0.0f;
+  return key;
+}
+
+static uint32_t sampler_key_hash(const cj_sampler_key_t* key) {
+  const unsigned char* p = (const unsigned char*)key;
+  uint32_t h = 2166136261u;  /* FNV-1a */
+  for (size_t i = 0; i < sizeof(*key); ++i) h = (h ^ p[i]) * 16777619u;
+  return h;
+}
+
+static inline const cj_sampler_key_t* sampler_cache_key(cj_engine_t* e, uint32_t index) {
+  return &res_cold(&e->tables[CJ_RES_SMP], index)->vulkan.sampler.key;
+}
+
+/* Sampler index cached for a key, 0 if none */
+static uint32_t sampler_cache_find(cj_engine_t* e, const cj_sampler_key_t* key) {
+  if (e->sampler_cache_capacity == 0) return 0;
+  uint32_t mask = e->sampler_cache_capacity - 1u;
+  for (uint32_t i = sampler_key_hash(key) & mask;; i = (i + 1u) & mask) {
+    uint32_t index = e->sampler_cache[i];
+    if (index == 0 || memcmp(sampler_cache_key(e, index), key, sizeof(*key)) == 0) return index;
+  }
+}
+
+static void sampler_cache_place(cj_engine_t* e, uint32_t index) {
+  uint32_t mask = e->sampler_cache_capacity - 1u;
+  uint32_t i = sampler_key_hash(sampler_cache_key(e, index)) & mask;
+  while (e->sampler_cache[i] != 0) i = (i + 1u) & mask;
+  e->sampler_cache[i] = index;
+}
+
+/* Add a sampler, keeping the table at most half full */
+static bool sampler_cache_insert(cj_engine_t* e, uint32_t index) {
+  if ((e->sampler_cache_count + 1u) * 2u > e->sampler_cache_capacity) {
+    uint32_t old_capacity = e->sampler_cache_capacity;
+    uint32_t* old = e->sampler_cache;
+    uint32_t capacity = old_capacity ? old_capacity * 2u : 16u;
+    uint32_t* grown = (uint32_t*)eng_host_alloc(e, sizeof(uint32_t) * capacity);
+    if (!grown) return false;
+    memset(grown, 0, sizeof(uint32_t) * capacity);
+    e->sampler_cache = grown;
+    e->sampler_cache_capacity = capacity;
+    for (uint32_t i = 0; i < old_capacity; ++i) {
+      if (old[i]) sampler_cache_place(e, old[i]);
     }
+    eng_host_free(e, old);
   }
-  return 0;
+  sampler_cache_place(e, index);
+  ++e->sampler_cache_count;
+  return true;
+}
+
+/* Drop a sampler from the cache, shifting later probes back so lookups need no tombstones */
+static void sampler_cache_remove(cj_engine_t* e, uint32_t index) {
+  if (e->sampler_cache_capacity == 0) return;
+  uint32_t mask = e->sampler_cache_capacity - 1u;
+  uint32_t i = sampler_key_hash(sampler_cache_key(e, index)) & mask;
+  while (e->sampler_cache[i] != index) {
+    if (e->sampler_cache[i] == 0) return;
+    i = (i + 1u) & mask;
+  }
+  for (uint32_t j = i;;) {
+    e->sampler_cache[i] = 0;
+    for (;;) {
+      j = (j + 1u) & mask;
+      if (e->sampler_cache[j] == 0) {
+        --e->sampler_cache_count;
+        return;
+      }
+      uint32_t home = sampler_key_hash(sampler_cache_key(e, e->sampler_cache[j])) & mask;
+      // The entry at j may stay unless its home lies cyclically outside (i, j]
+      bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+      if (!stays) break;
+    }
+    e->sampler_cache[i] = e->sampler_cache[j];
+    i = j;
+  }
+}
+
+/* Hand an entry whose last reference was just dropped to the engine thread; any thread */
+static void res_queue_released(cj_res_table_t* t, uint32_t index) {
+  /* The handle named an allocated page, and nothing else touches pending_next until the drain */
+  cj_res_cold_t* cold = &t->cold[index >> CJ_RES_PAGE_SHIFT][index & (CJ_RES_PAGE_SIZE - 1u)];
+  uint32_t head = atomic_load_explicit(&t->pending_head, memory_order_relaxed);
+  do {
+    cold->pending_next = head;
+  } while (!atomic_compare_exchange_weak_explicit(&t->pending_head, &head, index,
+                                                  memory_order_release, memory_order_relaxed));
+}
+
+/* Queue a released entry's objects for deletion once submitted work is done with them */
+static void res_finish_release(cj_engine_t* e, cj_res_kind_t kind, uint32_t index) {
+  if (kind == CJ_RES_SMP) sampler_cache_remove(e, index);
+  // Copies not submitted yet are pointless now; submitted work may still read the objects
+  res_discard_uploads(e, kind, index);
+  if (e->device == VK_NULL_HANDLE) {
+    res_free_retired(e, kind, index);
+  } else if (!res_retire(e, kind, index, VK_NULL_HANDLE)) {
+    fprintf(stderr, "cj_engine_res_release: could not grow the deletion queue, waiting for the device\n");
+    vkDeviceWaitIdle(e->device);
+    res_free_retired(e, kind, index);
+  }
+}
+
+/* Take every entry released since the last call; engine thread only */
+static void res_drain_released(cj_engine_t* e) {
+  for (uint32_t k = 0; k < 3u; ++k) {
+    cj_res_table_t* t = &e->tables[k];
+    // Taking the whole list at once leaves pushes as the only concurrent operation, so no ABA
+    uint32_t index = atomic_exchange_explicit(&t->pending_head, 0u, memory_order_acquire);
+    while (index != 0) {
+      uint32_t next = res_cold(t, index)->pending_next;
+      res_finish_release(e, (cj_res_kind_t)k, index);
+      index = next;
+    }
+  }
+}
+
+CJ_API uint64_t cj_engine_res_alloc(cj_engine_t* e, cj_res_kind_t kind, uint32_t* out_index) {
+  cj_res_table_t* t = e ? table_for(e, kind) : NULL;
+  if (!t) return 0;
+  /* Without a device, entries released elsewhere become free right here */
+  if (t->free_head[0] == 0 && t->free_head[1] == 0) res_drain_released(e);
+  if (t->free_head[0] == 0 && t->free_head[1] == 0 && !res_grow(e, t)) {
+    fprintf(stderr, "cj_engine_res_alloc: resource table %d is full\n", (int)kind);
+    return 0;
+  }
+  uint32_t* head = &t->free_head[t->free_head[0] == 0];
+  uint32_t idx = *head;
+  cj_res_cold_t* cold = res_cold(t, idx);
+  *head = cold->next_free;
+  memset(cold, 0, sizeof(*cold));
+  ++t->live;
+
+  cj_res_hot_t* hot = res_hot(t, idx);
+  uint32_t gen = res_state_gen(atomic_load_explicit(&hot->state, memory_order_relaxed));
+  atomic_store_explicit(&hot->state, res_state(gen, 1u), memory_order_release);
+  if (out_index) *out_index = idx;
+  return make_handle(idx, gen);
+}
+
+/* Entry a handle names, live or not; NULL past the allocated pages */
+static inline cj_res_hot_t* res_handle_hot(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle,
+                                           uint32_t* out_index, uint32_t* out_gen) {
+  cj_res_table_t* t = (e && handle) ? table_for(e, kind) : NULL;
+  if (!t) return NULL;
+  split_handle(handle, out_index, out_gen);
+  return res_hot(t, *out_index);
 }
 
 CJ_API void cj_engine_res_retain(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle) {
-  if (!e || handle == 0) return;
-  size_t cap = 0; cj_res_entry_t* table = table_for(e, kind, &cap);
-  uint32_t idx, gen; split_handle(handle, &idx, &gen);
-  if (idx >= cap) return;
-  cj_res_entry_t* ent = &table[idx];
-  if (!ent->in_use || ent->generation != gen) return;
-  if (ent->refcount < 0xfffffff0u) ++ent->refcount;
+  uint32_t idx = 0, gen = 0;
+  cj_res_hot_t* hot = res_handle_hot(e, kind, handle, &idx, &gen);
+  if (!hot) return;
+  // Never revive an entry another thread just freed, nor count on one reused since
+  uint64_t state = atomic_load_explicit(&hot->state, memory_order_relaxed);
+  while (res_state_gen(state) == gen && res_state_count(state) != 0 && res_state_count(state) < 0xfffffff0u &&
+         !atomic_compare_exchange_weak_explicit(&hot->state, &state, state + 1u,
+                                                memory_order_acq_rel, memory_order_relaxed)) {
+  }
 }
 
-CJ_API void cj_engine_res_release(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle) {
-  if (!e || handle == 0) return;
-  size_t cap = 0; cj_res_entry_t* table = table_for(e, kind, &cap);
-  uint32_t idx, gen; split_handle(handle, &idx, &gen);
-  if (idx >= cap) return;
-  cj_res_entry_t* ent = &table[idx];
-  if (!ent->in_use || ent->generation != gen) return;
-  if (ent->refcount > 0) --ent->refcount;
-  if (ent->refcount == 0) {
-    ent->in_use = 0;
-    ent->slot = 0;
+CJ_API bool cj_engine_res_release(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle) {
+  uint32_t idx = 0, gen = 0;
+  cj_res_hot_t* hot = res_handle_hot(e, kind, handle, &idx, &gen);
+  if (!hot) return false;
+  uint64_t state = atomic_load_explicit(&hot->state, memory_order_relaxed);
+  uint64_t next;
+  do {
+    if (res_state_gen(state) != gen || res_state_count(state) == 0) return false;
+    /* Last reference: stale handles fail validation from here on */
+    uint32_t newgen = gen + 1u;
+    if (newgen == 0u) newgen = 1u;
+    next = res_state_count(state) == 1u ? res_state(newgen, 0u) : state - 1u;
+  } while (!atomic_compare_exchange_weak_explicit(&hot->state, &state, next,
+                                                  memory_order_acq_rel, memory_order_relaxed));
+  if (res_state_count(next) != 0) return false;
+  res_queue_released(table_for(e, kind), idx);
+  return true;
+}
+
+CJ_API uint64_t cj_engine_acquire_sampler(cj_engine_t* e, const cj_sampler_desc_t* desc, VkSampler* out_sampler) {
+  if (out_sampler) *out_sampler = VK_NULL_HANDLE;
+  if (!e || !desc || e->device == VK_NULL_HANDLE) return 0;
+
+  cj_sampler_key_t key = sampler_key(desc);
+  uint32_t idx = sampler_cache_find(e, &key);
+  if (idx != 0) {
+    // Cached entries stay until this thread drains them, but another may drop the last reference
+    cj_res_hot_t* hot = res_hot(&e->tables[CJ_RES_SMP], idx);
+    uint64_t state = atomic_load_explicit(&hot->state, memory_order_relaxed);
+    while (res_state_count(state) != 0 &&
+           !atomic_compare_exchange_weak_explicit(&hot->state, &state, state + 1u,
+                                                  memory_order_acq_rel, memory_order_relaxed)) {
+    }
+    if (res_state_count(state) != 0) {
+      if (out_sampler) *out_sampler = res_cold(&e->tables[CJ_RES_SMP], idx)->vulkan.sampler.sampler;
+      return make_handle(idx, res_state_gen(state));
+    }
+    /* Released meanwhile: take it out of the cache and make a new one */
+    res_drain_released(e);
   }
+
+  uint64_t h = cj_engine_res_alloc(e, CJ_RES_SMP, &idx);
+  if (h == 0) return 0;
+  if (!cj_engine_create_sampler(e, idx, desc) || !sampler_cache_insert(e, idx)) {
+    cj_engine_res_release(e, CJ_RES_SMP, h);
+    return 0;
+  }
+  if (out_sampler) *out_sampler = res_cold(&e->tables[CJ_RES_SMP], idx)->vulkan.sampler.sampler;
+  return h;
+}
+
+CJ_API uint32_t cj_engine_res_index(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle) {
+  uint32_t idx = 0;
+  return res_lookup(e, kind, handle, &idx) ? idx : 0u;
 }
 
 CJ_API uint32_t cj_engine_res_slot(cj_engine_t* e, cj_res_kind_t kind, uint64_t handle) {
-  if (!e || handle == 0) return 0;
-  size_t cap = 0; cj_res_entry_t* table = table_for(e, kind, &cap);
-  uint32_t idx, gen; split_handle(handle, &idx, &gen);
-  if (idx >= cap) return 0;
-  cj_res_entry_t* ent = &table[idx];
-  if (!ent->in_use || ent->generation != gen) return 0;
-  return ent->slot;
+  uint32_t idx = cj_engine_res_index(e, kind, handle);
+  if (kind == CJ_RES_TEX && idx >= CJ_ENGINE_TEXTURE_TABLE_SIZE) return 0;
+  return idx;
 }
 
 /* Handle API thin wrappers */
@@ -663,22 +1907,123 @@ CJ_API uint32_t cj_handle_slot(cj_engine_t* e, cj_handle_kind_t kind, cj_handle_
 /* Public resource API already implemented in resources.c */
 
 /* Vulkan resource creation helpers */
-CJ_API int cj_engine_create_texture(cj_engine_t* e, uint32_t slot, const cj_texture_desc_t* desc) {
-  if (!e || !desc || slot >= CJ_ENGINE_MAX_TEXTURES) return 0;
-  cj_res_entry_t* entry = &e->textures[slot];
-  if (!entry->in_use) return 0;
+/* Create a texture's image and view, with memory bound; nothing is left behind on failure */
+static bool eng_texture_storage(cj_engine_t* e, const VkImageCreateInfo* info, VkImageViewType view_type,
+                                VkImageAspectFlags aspect, VkImage* out_image, VkImageView* out_view,
+                                cj_gpu_alloc_t* out_alloc) {
+  VkDevice dev = e->device;
+  *out_view = VK_NULL_HANDLE;
+  if (vkCreateImage(dev, info, NULL, out_image) != VK_SUCCESS) {
+    *out_image = VK_NULL_HANDLE;
+    return false;
+  }
+  if (!cj_gpu_alloc_image(e->gpu, *out_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, CJ_GPU_ALLOC_OPTIMAL, out_alloc)) {
+    vkDestroyImage(dev, *out_image, NULL);
+    *out_image = VK_NULL_HANDLE;
+    return false;
+  }
+
+  VkImageViewCreateInfo viewInfo = {0};
+  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+  viewInfo.image = *out_image;
+  viewInfo.viewType = view_type;
+  viewInfo.format = info->format;
+  viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+  viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+  viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+  viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+  viewInfo.subresourceRange.aspectMask = aspect;
+  viewInfo.subresourceRange.baseMipLevel = 0;
+  viewInfo.subresourceRange.levelCount = info->mipLevels;
+  viewInfo.subresourceRange.baseArrayLayer = 0;
+  viewInfo.subresourceRange.layerCount = info->arrayLayers;
+  if (vkCreateImageView(dev, &viewInfo, NULL, out_view) != VK_SUCCESS) {
+    *out_view = VK_NULL_HANDLE;
+    cj_gpu_free(e->gpu, out_alloc);
+    vkDestroyImage(dev, *out_image, NULL);
+    *out_image = VK_NULL_HANDLE;
+    return false;
+  }
+  return true;
+}
+
+/* Point a texture's element of the texture table at its view. The slot is only sampled once
+ * the caller draws with it, by which time its uploads have been submitted. */
+static void eng_write_texture_table(cj_engine_t* e, uint32_t index, const cj_res_cold_t* entry) {
+  if (e->texture_table == VK_NULL_HANDLE || index >= CJ_ENGINE_TEXTURE_TABLE_SIZE) return;
+  VkDescriptorImageInfo imageInfo = {0};
+  imageInfo.sampler = entry->vulkan.texture.sampler;
+  imageInfo.imageView = entry->vulkan.texture.imageView;
+  imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  VkWriteDescriptorSet write = {0};
+  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write.dstSet = e->texture_table;
+  write.dstBinding = 0;
+  write.dstArrayElement = index;
+  write.descriptorCount = 1;
+  write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+  write.pImageInfo = &imageInfo;
+  vkUpdateDescriptorSets(e->device, 1, &write, 0, NULL);
+}
+
+static bool eng_stream_load(cj_engine_t* e, cj_res_cold_t* entry, VkImage image, uint32_t base, uint64_t* out_ticket);
+static bool eng_stream_add(cj_engine_t* e, uint32_t index);
+static VkDeviceSize eng_stream_evict(cj_engine_t* e, VkDeviceSize bytes);
+
+CJ_API int cj_engine_create_texture(cj_engine_t* e, uint32_t index, const cj_texture_desc_t* desc) {
+  cj_res_cold_t* entry = (e && desc) ? res_live(e, CJ_RES_TEX, index) : NULL;
+  if (!entry) return 0;
 
   VkDevice dev = e->device;
   if (dev == VK_NULL_HANDLE) return 0;
 
-  // Convert CJelly format to Vulkan format
-  VkFormat vk_format = VK_FORMAT_R8G8B8A8_UNORM; // Default
-  switch (desc->format) {
-    case CJ_FORMAT_RGBA8_UNORM: vk_format = VK_FORMAT_R8G8B8A8_UNORM; break;
-    case CJ_FORMAT_BGRA8_UNORM: vk_format = VK_FORMAT_B8G8R8A8_UNORM; break;
-    case CJ_FORMAT_RGBA32_FLOAT: vk_format = VK_FORMAT_R32G32B32A32_SFLOAT; break;
-    default: vk_format = VK_FORMAT_R8G8B8A8_UNORM; break;
+  const eng_format_t* format = eng_format(desc->format);
+  if (!format) {
+    fprintf(stderr, "cj_engine_create_texture: unknown format %d\n", (int)desc->format);
+    return 0;
+  }
+  if (!cj_engine_format_supported(e, desc->format)) {
+    fprintf(stderr, "cj_engine_create_texture: format %d is not supported by the device\n", (int)desc->format);
+    return 0;
+  }
+  VkFormat vk_format = format->vk_format;
+  bool depth = (desc->format == CJ_FORMAT_D24S8 || desc->format == CJ_FORMAT_D32F);
+  uint32_t layers = desc->layers ? desc->layers : 1;
+  if (desc->cube && (layers % 6u != 0 || desc->width != desc->height)) {
+    fprintf(stderr, "cj_engine_create_texture: a cube needs square faces and a multiple of 6 layers, not %u\n", layers);
+    return 0;
+  }
+  /* Down to 1x1, for generated and streamed chains */
+  uint32_t full = 1;
+  for (uint32_t size = desc->width > desc->height ? desc->width : desc->height; size > 1; size >>= 1) full++;
+  uint32_t mips = desc->mips ? desc->mips : 1;
+  if (desc->generate_mips) {
+    if (!cj_engine_format_can_generate_mips(e, desc->format)) {
+      fprintf(stderr, "cj_engine_create_texture: the device cannot generate mips for format %d\n", (int)desc->format);
+      return 0;
+    }
+    mips = (desc->mips && desc->mips < full) ? desc->mips : full;
+  }
+
+  /* A streamed texture starts with its smallest levels; base is the level that is mip 0 */
+  uint32_t base = 0;
+  if (desc->stream) {
+    if (!desc->stream->load || !(desc->usage & CJ_IMAGE_SAMPLED) || layers != 1 || desc->cube || desc->generate_mips) {
+      fprintf(stderr, "cj_engine_create_texture: streamed textures need a load callback and are sampled, "
+                      "single-layer and not generated\n");
+      return 0;
+    }
+    mips = (desc->mips && desc->mips < full) ? desc->mips : full;
+    uint32_t resident = desc->stream->resident_mips;
+    if (resident == 0) {
+      while (base + 1u < mips && ((desc->width >> base) > CJ_ENGINE_STREAM_RESIDENT_SIZE ||
+                                  (desc->height >> base) > CJ_ENGINE_STREAM_RESIDENT_SIZE)) base++;
+    } else {
+      base = mips - (resident < mips ? resident : mips);
+    }
   }
+  uint32_t width = (desc->width >> base) ? (desc->width >> base) : 1u;
+  uint32_t height = (desc->height >> base) ? (desc->height >> base) : 1u;
 
   // Convert usage flags
   VkImageUsageFlags usage = 0;
@@ -686,16 +2031,21 @@ CJ_API int cj_engine_create_texture(cj_engine_t* e, uint32_t slot, const cj_text
   if (desc->usage & CJ_IMAGE_STORAGE) usage |= VK_IMAGE_USAGE_STORAGE_BIT;
   if (desc->usage & CJ_IMAGE_COLOR_RT) usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
   if (desc->usage & CJ_IMAGE_DEPTH_RT) usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  /* Color textures can receive cj_upload_texture data */
+  if (!(desc->usage & CJ_IMAGE_DEPTH_RT)) usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+  /* Generated levels are blitted from the level above */
+  if (desc->generate_mips) usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
   // Create image
   VkImageCreateInfo imageInfo = {0};
   imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+  imageInfo.flags = desc->cube ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
   imageInfo.imageType = VK_IMAGE_TYPE_2D;
-  imageInfo.extent.width = desc->width;
-  imageInfo.extent.height = desc->height;
+  imageInfo.extent.width = width;
+  imageInfo.extent.height = height;
   imageInfo.extent.depth = 1;
-  imageInfo.mipLevels = desc->mips ? desc->mips : 1;
-  imageInfo.arrayLayers = desc->layers ? desc->layers : 1;
+  imageInfo.mipLevels = mips - base;
+  imageInfo.arrayLayers = layers;
   imageInfo.format = vk_format;
   imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
   imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -703,81 +2053,490 @@ CJ_API int cj_engine_create_texture(cj_engine_t* e, uint32_t slot, const cj_text
   imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
   imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-  if (vkCreateImage(dev, &imageInfo, NULL, &entry->vulkan.texture.image) != VK_SUCCESS) {
+  VkImageViewType viewType;
+  if (desc->cube) viewType = (layers > 6) ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+  else viewType = (layers > 1) ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+  if (!eng_texture_storage(e, &imageInfo, viewType, depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT,
+                           &entry->vulkan.texture.image, &entry->vulkan.texture.imageView,
+                           &entry->vulkan.texture.alloc)) {
+    /* Make room for a retry by giving up the detail of idle streamed textures */
+    VkDeviceSize bytes = (VkDeviceSize)width * height * layers * format->block_bytes /
+                         ((VkDeviceSize)format->block_width * format->block_height);
+    if (eng_stream_evict(e, bytes + bytes / 3u) > 0) {
+      fprintf(stderr, "cj_engine_create_texture: out of device memory; evicting streamed mip levels\n");
+    }
     return 0;
   }
 
-  // Allocate memory
-  VkMemoryRequirements memRequirements;
-  vkGetImageMemoryRequirements(dev, entry->vulkan.texture.image, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = eng_find_memory_type(e, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-  if (vkAllocateMemory(dev, &allocInfo, NULL, &entry->vulkan.texture.memory) != VK_SUCCESS) {
+  // Sample through the shared linear, repeating sampler
+  cj_sampler_desc_t sampler_desc = {0};
+  sampler_desc.min_filter = CJ_FILTER_LINEAR;
+  sampler_desc.mag_filter = CJ_FILTER_LINEAR;
+  sampler_desc.address_u = CJ_ADDRESS_REPEAT;
+  sampler_desc.address_v = CJ_ADDRESS_REPEAT;
+  sampler_desc.address_w = CJ_ADDRESS_REPEAT;
+  entry->vulkan.texture.sampler_handle = cj_engine_acquire_sampler(e, &sampler_desc, &entry->vulkan.texture.sampler);
+  if (entry->vulkan.texture.sampler_handle == 0) {
+    vkDestroyImageView(dev, entry->vulkan.texture.imageView, NULL);
+    cj_gpu_free(e->gpu, &entry->vulkan.texture.alloc);
     vkDestroyImage(dev, entry->vulkan.texture.image, NULL);
+    entry->vulkan.texture.imageView = VK_NULL_HANDLE;
+    entry->vulkan.texture.image = VK_NULL_HANDLE;
     return 0;
   }
 
-  vkBindImageMemory(dev, entry->vulkan.texture.image, entry->vulkan.texture.memory, 0);
+  entry->vulkan.texture.extent.width = width;
+  entry->vulkan.texture.extent.height = height;
+  entry->vulkan.texture.mips = imageInfo.mipLevels;
+  entry->vulkan.texture.layers = layers;
+  entry->vulkan.texture.texel_size = format->block_bytes;
+  entry->vulkan.texture.block_width = format->block_width;
+  entry->vulkan.texture.block_height = format->block_height;
+  entry->vulkan.texture.generate_mips = desc->generate_mips && mips > 1;
+  entry->vulkan.texture.mip_filter = VK_FILTER_NEAREST;
+  if (entry->vulkan.texture.generate_mips) {
+    VkFormatProperties props = {0};
+    vkGetPhysicalDeviceFormatProperties(e->physical_device, vk_format, &props);
+    if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) {
+      entry->vulkan.texture.mip_filter = VK_FILTER_LINEAR;
+    }
+  }
+  entry->vulkan.texture.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+  entry->vulkan.texture.ready_layout = (desc->usage & CJ_IMAGE_SAMPLED) ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+                                                                       : VK_IMAGE_LAYOUT_GENERAL;
+
+  if (desc->stream) {
+    /* Destroying the entry on failure frees the stream state and drops the queued copies */
+    cj_tex_stream_t* s = (cj_tex_stream_t*)eng_host_alloc(e, sizeof(*s));
+    if (!s) return 0;
+    s->source = *desc->stream;
+    s->extent.width = desc->width;
+    s->extent.height = desc->height;
+    s->levels = mips;
+    s->base = s->floor = base;
+    s->wanted = UINT32_MAX;
+    s->image_info = imageInfo;
+    entry->vulkan.texture.stream = s;
+    uint64_t ticket = 0;
+    if (!eng_stream_add(e, index) || !eng_stream_load(e, entry, entry->vulkan.texture.image, base, &ticket)) return 0;
+  }
 
-  // Create image view
-  VkImageViewCreateInfo viewInfo = {0};
-  viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-  viewInfo.image = entry->vulkan.texture.image;
-  viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-  viewInfo.format = vk_format;
-  viewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-  viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  viewInfo.subresourceRange.baseMipLevel = 0;
-  viewInfo.subresourceRange.levelCount = desc->mips ? desc->mips : 1;
-  viewInfo.subresourceRange.baseArrayLayer = 0;
-  viewInfo.subresourceRange.layerCount = desc->layers ? desc->layers : 1;
+  /* Sampled 2D textures are published in the texture table */
+  if ((desc->usage & CJ_IMAGE_SAMPLED) && viewType == VK_IMAGE_VIEW_TYPE_2D) eng_write_texture_table(e, index, entry);
+  return 1;
+}
 
-  if (vkCreateImageView(dev, &viewInfo, NULL, &entry->vulkan.texture.imageView) != VK_SUCCESS) {
-    vkFreeMemory(dev, entry->vulkan.texture.memory, NULL);
-    vkDestroyImage(dev, entry->vulkan.texture.image, NULL);
-    return 0;
+/* Describe a copy of a region of one texture subresource; fails when it does not fit or,
+ * for block-compressed formats, does not start and end on block boundaries (or the edge) */
+static bool eng_texture_region(const cj_res_cold_t* entry, uint32_t mip, uint32_t layer, uint32_t x, uint32_t y,
+                               uint32_t width, uint32_t height, cj_upload_image_t* out) {
+  if (mip >= entry->vulkan.texture.mips || layer >= entry->vulkan.texture.layers) {
+    fprintf(stderr, "cj_engine_upload_texture: mip %u layer %u does not exist\n", mip, layer);
+    return false;
+  }
+  uint32_t mip_w = entry->vulkan.texture.extent.width >> mip;
+  uint32_t mip_h = entry->vulkan.texture.extent.height >> mip;
+  if (mip_w == 0) mip_w = 1;
+  if (mip_h == 0) mip_h = 1;
+  uint32_t w = width ? width : mip_w;
+  uint32_t h = height ? height : mip_h;
+  if (x > mip_w || y > mip_h || w > mip_w - x || h > mip_h - y) {
+    fprintf(stderr, "cj_engine_upload_texture: region %ux%u at (%u,%u) exceeds %ux%u mip %u\n",
+            w, h, x, y, mip_w, mip_h, mip);
+    return false;
+  }
+  uint32_t bw = entry->vulkan.texture.block_width, bh = entry->vulkan.texture.block_height;
+  if (x % bw || y % bh || ((x + w) % bw && x + w != mip_w) || ((y + h) % bh && y + h != mip_h)) {
+    fprintf(stderr, "cj_engine_upload_texture: region %ux%u at (%u,%u) is not aligned to %ux%u blocks\n",
+            w, h, x, y, bw, bh);
+    return false;
   }
 
-  // Create sampler
-  VkSamplerCreateInfo samplerInfo = {0};
-  samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-  samplerInfo.magFilter = VK_FILTER_LINEAR;
-  samplerInfo.minFilter = VK_FILTER_LINEAR;
-  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  samplerInfo.anisotropyEnable = VK_FALSE;
-  samplerInfo.maxAnisotropy = 1;
-  samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-  samplerInfo.unnormalizedCoordinates = VK_FALSE;
-  samplerInfo.compareEnable = VK_FALSE;
-  samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  samplerInfo.mipLodBias = 0.0f;
-  samplerInfo.minLod = 0.0f;
-  samplerInfo.maxLod = 0.0f;
+  memset(out, 0, sizeof(*out));
+  out->image = entry->vulkan.texture.image;
+  out->old_layout = entry->vulkan.texture.layout;
+  out->new_layout = entry->vulkan.texture.ready_layout;
+  out->offset.x = (int32_t)x;
+  out->offset.y = (int32_t)y;
+  out->extent.width = w;
+  out->extent.height = h;
+  out->extent.depth = 1;
+  out->mip_level = mip;
+  out->array_layer = layer;
+  out->texel_size = entry->vulkan.texture.texel_size;
+  out->block_width = bw;
+  out->block_height = bh;
+  return true;
+}
 
-  if (vkCreateSampler(dev, &samplerInfo, NULL, &entry->vulkan.texture.sampler) != VK_SUCCESS) {
-    vkDestroyImageView(dev, entry->vulkan.texture.imageView, NULL);
-    vkFreeMemory(dev, entry->vulkan.texture.memory, NULL);
-    vkDestroyImage(dev, entry->vulkan.texture.image, NULL);
+/* After a copy into mip 0 of a layer, queue the regeneration of the layer's other levels */
+static bool eng_texture_generate_mips(cj_engine_t* e, const cj_res_cold_t* entry, const cj_upload_image_t* dst) {
+  if (!entry->vulkan.texture.generate_mips || dst->mip_level != 0) return true;
+  cj_upload_mips_t mips = {0};
+  mips.image = dst->image;
+  mips.layout = dst->new_layout;
+  mips.extent = entry->vulkan.texture.extent;
+  mips.levels = entry->vulkan.texture.mips;
+  mips.array_layer = dst->array_layer;
+  mips.filter = entry->vulkan.texture.mip_filter;
+  if (!cj_upload_queue_generate_mips(e->uploads, &mips, NULL)) {
+    fprintf(stderr, "cj_engine_upload_texture: out of memory queuing mips of layer %u\n", dst->array_layer);
+    return false;
+  }
+  return true;
+}
+
+CJ_API cj_upload_ticket_t cj_engine_upload_texture(cj_engine_t* e, uint32_t index, const cj_texture_upload_t* upload) {
+  cj_res_cold_t* entry = (e && upload && upload->data) ? res_live(e, CJ_RES_TEX, index) : NULL;
+  if (!entry || entry->vulkan.texture.image == VK_NULL_HANDLE) return 0;
+  if (entry->vulkan.texture.stream) {
+    fprintf(stderr, "cj_engine_upload_texture: streamed textures load their levels through their stream\n");
     return 0;
   }
 
-  return 1;
+  cj_upload_image_t dst;
+  if (!eng_texture_region(entry, upload->mip, upload->layer, upload->x, upload->y,
+                          upload->width, upload->height, &dst)) return 0;
+
+  uint64_t ticket = 0;
+  uint8_t* staged = (uint8_t*)cj_upload_queue_stage_image(e->uploads, &dst, &ticket);
+  if (!staged) return 0;
+
+  /* Rows of blocks; 1x1 blocks for uncompressed formats */
+  uint32_t rows = (dst.extent.height + dst.block_height - 1) / dst.block_height;
+  size_t row = (size_t)((dst.extent.width + dst.block_width - 1) / dst.block_width) * dst.texel_size;
+  size_t pitch = upload->row_pitch ? upload->row_pitch : row;
+  if (pitch == row) {
+    memcpy(staged, upload->data, row * rows);
+  } else {
+    const uint8_t* src = (const uint8_t*)upload->data;
+    for (uint32_t y = 0; y < rows; y++) memcpy(staged + row * y, src + pitch * y, row);
+  }
+
+  /* Only the first upload may discard; later ones keep what is already there */
+  entry->vulkan.texture.layout = dst.new_layout;
+  if (!eng_texture_generate_mips(e, entry, &dst)) return 0;
+  return ticket;
+}
+
+CJ_API void* cj_engine_stage_texture_level(cj_engine_t* e, uint32_t index, uint32_t mip, uint32_t layer,
+                                           size_t* out_size, cj_upload_ticket_t* out_ticket) {
+  cj_res_cold_t* entry = e ? res_live(e, CJ_RES_TEX, index) : NULL;
+  if (!entry || entry->vulkan.texture.image == VK_NULL_HANDLE) return NULL;
+
+  cj_upload_image_t dst;
+  if (!eng_texture_region(entry, mip, layer, 0, 0, 0, 0, &dst)) return NULL;
+  /* The caller writes the whole subresource, so its old contents can always go */
+  dst.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+  uint64_t ticket = 0;
+  void* staged = cj_upload_queue_stage_image(e->uploads, &dst, &ticket);
+  if (!staged) return NULL;
+  if (out_size) {
+    *out_size = (size_t)((dst.extent.width + dst.block_width - 1) / dst.block_width) *
+                ((dst.extent.height + dst.block_height - 1) / dst.block_height) * dst.texel_size;
+  }
+  if (out_ticket) *out_ticket = ticket;
+  entry->vulkan.texture.layout = dst.new_layout;
+  if (!eng_texture_generate_mips(e, entry, &dst)) return NULL;
+  return staged;
+}
+
+/* Texture streaming. Each streamed texture keeps a resident image with the levels from base
+ * down; more detail means a new image with more levels, filled from the load callback and
+ * swapped in once its uploads finished, and eviction is the same with fewer levels. */
+
+/* Bytes a streaming update may load, so a burst of requests spreads over several frames */
+#define CJ_ENGINE_STREAM_UPDATE_BYTES ((VkDeviceSize)32 << 20)
+/* Updates a finished replacement waits for the frames in flight; then it waits for the GPU */
+#define CJ_ENGINE_STREAM_SWAP_WAITS 8u
+
+/* Bytes of the levels from base down of a streamed texture */
+static VkDeviceSize eng_stream_bytes(const cj_res_cold_t* entry, uint32_t base) {
+  const cj_tex_stream_t* s = entry->vulkan.texture.stream;
+  uint32_t bw = entry->vulkan.texture.block_width, bh = entry->vulkan.texture.block_height;
+  VkDeviceSize bytes = 0;
+  for (uint32_t level = base; level < s->levels; level++) {
+    uint32_t w = (s->extent.width >> level) ? (s->extent.width >> level) : 1u;
+    uint32_t h = (s->extent.height >> level) ? (s->extent.height >> level) : 1u;
+    bytes += (VkDeviceSize)((w + bw - 1) / bw) * ((h + bh - 1) / bh) * entry->vulkan.texture.texel_size;
+  }
+  return bytes;
+}
+
+/* Queue copies of the levels from base down into image, which holds them from mip 0 */
+static bool eng_stream_load(cj_engine_t* e, cj_res_cold_t* entry, VkImage image, uint32_t base, uint64_t* out_ticket) {
+  cj_tex_stream_t* s = entry->vulkan.texture.stream;
+  for (uint32_t level = base; level < s->levels; level++) {
+    cj_upload_image_t dst = {0};
+    dst.image = image;
+    dst.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    dst.new_layout = entry->vulkan.texture.ready_layout;
+    dst.extent.width = (s->extent.width >> level) ? (s->extent.width >> level) : 1u;
+    dst.extent.height = (s->extent.height >> level) ? (s->extent.height >> level) : 1u;
+    dst.extent.depth = 1;
+    dst.mip_level = level - base;
+    dst.texel_size = entry->vulkan.texture.texel_size;
+    dst.block_width = entry->vulkan.texture.block_width;
+    dst.block_height = entry->vulkan.texture.block_height;
+    void* staged = cj_upload_queue_stage_image(e->uploads, &dst, out_ticket);
+    if (!staged) return false;
+    size_t size = (size_t)((dst.extent.width + dst.block_width - 1) / dst.block_width) *
+                  ((dst.extent.height + dst.block_height - 1) / dst.block_height) * dst.texel_size;
+    if (!s->source.load(s->source.user, level, 0, staged, size)) {
+      fprintf(stderr, "cj_engine_update_streaming: loading mip %u of texture failed\n", level);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool eng_stream_add(cj_engine_t* e, uint32_t index) {
+  if (e->streamed_count == e->streamed_capacity) {
+    uint32_t cap = e->streamed_capacity ? e->streamed_capacity * 2u : 64u;
+    uint32_t* grown = (uint32_t*)realloc(e->streamed, sizeof(*grown) * cap);
+    if (!grown) return false;
+    e->streamed = grown;
+    e->streamed_capacity = cap;
+  }
+  e->streamed[e->streamed_count++] = index;
+  return true;
+}
+
+/* Destroy a texture's stream state; its replacement was never sampled */
+static void eng_stream_remove(cj_engine_t* e, uint32_t index, cj_res_cold_t* entry) {
+  cj_tex_stream_t* s = entry->vulkan.texture.stream;
+  if (s->next_image != VK_NULL_HANDLE) cj_upload_queue_discard_image(e->uploads, s->next_image);
+  eng_destroy_storage(e, s->next_image, s->next_view, &s->next_alloc);
+  for (uint32_t i = 0; i < e->streamed_count; i++) {
+    if (e->streamed[i] == index) {
+      e->streamed[i] = e->streamed[--e->streamed_count];
+      break;
+    }
+  }
+  eng_host_free(e, s);
+  entry->vulkan.texture.stream = NULL;
+}
+
+/* Start filling a replacement holding the levels from base down */
+static bool eng_stream_begin(cj_engine_t* e, cj_res_cold_t* entry, uint32_t base) {
+  cj_tex_stream_t* s = entry->vulkan.texture.stream;
+  VkImageCreateInfo info = s->image_info;
+  info.extent.width = (s->extent.width >> base) ? (s->extent.width >> base) : 1u;
+  info.extent.height = (s->extent.height >> base) ? (s->extent.height >> base) : 1u;
+  info.mipLevels = s->levels - base;
+  if (!eng_texture_storage(e, &info, VK_IMAGE_VIEW_TYPE_2D, VK_IMAGE_ASPECT_COLOR_BIT,
+                           &s->next_image, &s->next_view, &s->next_alloc)) {
+    return false;
+  }
+  s->next_base = base;
+  s->next_ticket = 0;
+  s->next_waits = 0;
+  if (!eng_stream_load(e, entry, s->next_image, base, &s->next_ticket)) {
+    cj_upload_queue_discard_image(e->uploads, s->next_image);
+    eng_destroy_storage(e, s->next_image, s->next_view, &s->next_alloc);
+    s->next_image = VK_NULL_HANDLE;
+    s->next_view = VK_NULL_HANDLE;
+    return false;
+  }
+  return true;
 }
 
-CJ_API int cj_engine_create_buffer(cj_engine_t* e, uint32_t slot, const cj_buffer_desc_t* desc) {
-  if (!e || !desc || slot >= CJ_ENGINE_MAX_BUFFERS) return 0;
-  cj_res_entry_t* entry = &e->buffers[slot];
-  if (!entry->in_use) return 0;
+/* Bytes that shrinks in flight and the deletion queue will give back */
+static VkDeviceSize eng_stream_pending_free(cj_engine_t* e) {
+  VkDeviceSize bytes = e->stream_retired_bytes;
+  for (uint32_t i = 0; i < e->streamed_count; i++) {
+    const cj_res_cold_t* entry = res_cold(&e->tables[CJ_RES_TEX], e->streamed[i]);
+    const cj_tex_stream_t* s = entry->vulkan.texture.stream;
+    if (s->next_image != VK_NULL_HANDLE && s->next_base > s->base) {
+      bytes += eng_stream_bytes(entry, s->base) - eng_stream_bytes(entry, s->next_base);
+    }
+  }
+  return bytes;
+}
+
+/* Return the least recently requested textures to their resident floor until about bytes
+ * will be freed; textures requested since the last update keep their detail.
+ * Returns the bytes the shrinks give back once they are swapped in and retired. */
+static VkDeviceSize eng_stream_evict(cj_engine_t* e, VkDeviceSize bytes) {
+  VkDeviceSize freed = 0;
+  while (e && freed < bytes) {
+    cj_res_cold_t* victim = NULL;
+    for (uint32_t i = 0; i < e->streamed_count; i++) {
+      cj_res_cold_t* entry = res_cold(&e->tables[CJ_RES_TEX], e->streamed[i]);
+      const cj_tex_stream_t* s = entry->vulkan.texture.stream;
+      if (s->next_image != VK_NULL_HANDLE || s->base >= s->floor || s->last_request >= e->stream_frame) continue;
+      if (!victim || s->last_request < victim->vulkan.texture.stream->last_request) victim = entry;
+    }
+    if (!victim) break;
+    const cj_tex_stream_t* s = victim->vulkan.texture.stream;
+    VkDeviceSize gain = eng_stream_bytes(victim, s->base) - eng_stream_bytes(victim, s->floor);
+    if (!eng_stream_begin(e, victim, s->floor)) break;
+    freed += gain;
+  }
+  return freed;
+}
+
+/* Swap in a finished replacement once no frame in flight reads the texture table, or after
+ * waiting for them when it has been ready for a while. Sets *idle after such a wait. */
+static void eng_stream_swap(cj_engine_t* e, uint32_t index, cj_res_cold_t* entry, bool* idle) {
+  cj_tex_stream_t* s = entry->vulkan.texture.stream;
+  if (!cj_upload_queue_done(e->uploads, s->next_ticket)) return;
+  if (!*idle) {
+    if (++s->next_waits < CJ_ENGINE_STREAM_SWAP_WAITS) return;
+    cj_engine_wait_batch(e, e->batch_serial);
+    *idle = true;
+  }
+
+  res_retire_storage(e, entry->vulkan.texture.image, entry->vulkan.texture.imageView, &entry->vulkan.texture.alloc);
+  entry->vulkan.texture.image = s->next_image;
+  entry->vulkan.texture.imageView = s->next_view;
+  entry->vulkan.texture.alloc = s->next_alloc;
+  entry->vulkan.texture.extent.width = (s->extent.width >> s->next_base) ? (s->extent.width >> s->next_base) : 1u;
+  entry->vulkan.texture.extent.height = (s->extent.height >> s->next_base) ? (s->extent.height >> s->next_base) : 1u;
+  entry->vulkan.texture.mips = s->levels - s->next_base;
+  entry->vulkan.texture.layout = entry->vulkan.texture.ready_layout;
+  s->base = s->next_base;
+  s->next_image = VK_NULL_HANDLE;
+  s->next_view = VK_NULL_HANDLE;
+  memset(&s->next_alloc, 0, sizeof(s->next_alloc));
+  eng_write_texture_table(e, index, entry);
+}
+
+CJ_API void cj_engine_request_texture_extent(cj_engine_t* e, uint32_t index, uint32_t width, uint32_t height) {
+  cj_res_cold_t* entry = e ? res_live(e, CJ_RES_TEX, index) : NULL;
+  cj_tex_stream_t* s = entry ? entry->vulkan.texture.stream : NULL;
+  if (!s) return;
+  /* The smallest level still covering the drawn size */
+  uint32_t level = 0;
+  while (level < s->floor && (s->extent.width >> (level + 1u)) >= (width ? width : 1u) &&
+         (s->extent.height >> (level + 1u)) >= (height ? height : 1u)) {
+    level++;
+  }
+  if (level < s->wanted) s->wanted = level;
+  s->last_request = e->stream_frame;
+}
+
+CJ_API uint32_t cj_engine_texture_resident_mip(cj_engine_t* e, uint32_t index) {
+  cj_res_cold_t* entry = e ? res_live(e, CJ_RES_TEX, index) : NULL;
+  return (entry && entry->vulkan.texture.stream) ? entry->vulkan.texture.stream->base : 0u;
+}
+
+CJ_API void cj_engine_update_streaming(cj_engine_t* e) {
+  if (!e || !e->gpu || e->streamed_count == 0) return;
+  cj_memory_heap_t heaps[VK_MAX_MEMORY_HEAPS];
+  uint32_t heap_count = cj_engine_get_memory_heaps(e, heaps, VK_MAX_MEMORY_HEAPS);
+  const VkPhysicalDeviceMemoryProperties* props = cj_gpu_allocator_memory_properties(e->gpu);
+  bool idle = cj_engine_batch_done(e, e->batch_serial);
+  VkDeviceSize loaded = 0;
+
+  for (uint32_t i = 0; i < e->streamed_count; i++) {
+    uint32_t index = e->streamed[i];
+    cj_res_cold_t* entry = res_cold(&e->tables[CJ_RES_TEX], index);
+    cj_tex_stream_t* s = entry->vulkan.texture.stream;
+    uint32_t wanted = s->wanted;
+    s->wanted = UINT32_MAX;
+    if (s->next_image != VK_NULL_HANDLE) {
+      eng_stream_swap(e, index, entry, &idle);
+      continue;
+    }
+    if (wanted >= s->base || (loaded > 0 && loaded >= CJ_ENGINE_STREAM_UPDATE_BYTES)) continue;
+
+    /* Make room by evicting, and settle for less detail when even that is not enough */
+    uint32_t heap = props->memoryTypes[entry->vulkan.texture.alloc.memory_type].heapIndex;
+    VkDeviceSize budget = heap < heap_count ? heaps[heap].budget : (VkDeviceSize)-1;
+    VkDeviceSize reserved = 0;
+    cj_gpu_allocator_heap_usage(e->gpu, heap, &reserved, NULL);
+    VkDeviceSize need = eng_stream_bytes(entry, wanted);
+    if (reserved + need > budget) {
+      VkDeviceSize pending = eng_stream_pending_free(e);
+      if (reserved + need > budget + pending) pending += eng_stream_evict(e, reserved + need - budget - pending);
+      while (wanted < s->base && reserved + eng_stream_bytes(entry, wanted) > budget + pending) wanted++;
+      need = eng_stream_bytes(entry, wanted);
+      /* What fits once the pending frees land is loaded then */
+      if (wanted >= s->base || reserved + need > budget) continue;
+    }
+    if (eng_stream_begin(e, entry, wanted)) loaded += need;
+  }
+  e->stream_frame++;
+}
+
+CJ_API uint32_t cj_engine_get_memory_heaps(const cj_engine_t* e, cj_memory_heap_t* out, uint32_t capacity) {
+  const VkPhysicalDeviceMemoryProperties* props = e ? cj_gpu_allocator_memory_properties(e->gpu) : NULL;
+  if (!props) return 0;
+  VkPhysicalDeviceMemoryBudgetPropertiesEXT driver = {0};
+  driver.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+  bool has_driver = e->get_memory_properties2 != NULL && out && capacity > 0;
+  if (has_driver) {
+    VkPhysicalDeviceMemoryProperties2 props2 = {0};
+    props2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    props2.pNext = &driver;
+    e->get_memory_properties2(e->physical_device, &props2);
+  }
+
+  for (uint32_t h = 0; out && h < props->memoryHeapCount && h < capacity; h++) {
+    cj_memory_heap_t* heap = &out[h];
+    memset(heap, 0, sizeof(*heap));
+    VkDeviceSize reserved = 0, used = 0;
+    cj_gpu_allocator_heap_usage(e->gpu, h, &reserved, &used);
+    heap->size = props->memoryHeaps[h].size;
+    heap->allocated = reserved;
+    heap->used = used;
+    heap->device_local = (props->memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    heap->driver_budget = has_driver;
+    heap->usage = has_driver ? driver.heapUsage[h] : reserved;
+    heap->budget = heap->size;
+    if (has_driver) {
+      /* The driver's budget is for the whole process; what others use is out of reach */
+      uint64_t others = driver.heapUsage[h] > reserved ? driver.heapUsage[h] - reserved : 0u;
+      heap->budget = driver.heapBudget[h] > others ? driver.heapBudget[h] - others : 0u;
+    }
+    if (heap->device_local && e->memory_budget && e->memory_budget < heap->budget) heap->budget = e->memory_budget;
+  }
+  return props->memoryHeapCount;
+}
+
+CJ_API bool cj_engine_format_supported(cj_engine_t* e, cj_format_t format) {
+  const eng_format_t* f = eng_format(format);
+  if (!e || !f || e->physical_device == VK_NULL_HANDLE) return false;
+  if (f->compression && !(e->compression & f->compression)) return false;
+  VkFormatProperties props = {0};
+  vkGetPhysicalDeviceFormatProperties(e->physical_device, f->vk_format, &props);
+  VkFormatFeatureFlags need = (format == CJ_FORMAT_D24S8 || format == CJ_FORMAT_D32F)
+                                  ? VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+                                  : VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+  return (props.optimalTilingFeatures & need) == need;
+}
+
+CJ_API bool cj_engine_format_can_generate_mips(cj_engine_t* e, cj_format_t format) {
+  const eng_format_t* f = eng_format(format);
+  if (!f || f->compression || format == CJ_FORMAT_D24S8 || format == CJ_FORMAT_D32F) return false;
+  if (!cj_engine_format_supported(e, format)) return false;
+  VkFormatProperties props = {0};
+  vkGetPhysicalDeviceFormatProperties(e->physical_device, f->vk_format, &props);
+  VkFormatFeatureFlags need = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+  return (props.optimalTilingFeatures & need) == need;
+}
+
+CJ_API cj_format_t cj_engine_format_from_vk(uint32_t vk_format) {
+  for (uint32_t i = 0; i < sizeof(eng_formats) / sizeof(eng_formats[0]); i++) {
+    if (eng_formats[i].block_bytes && (uint32_t)eng_formats[i].vk_format == vk_format) return (cj_format_t)i;
+  }
+  return CJ_FORMAT_UNDEFINED;
+}
+
+CJ_API bool cj_engine_format_block(cj_format_t format, uint32_t* out_width, uint32_t* out_height, uint32_t* out_bytes) {
+  const eng_format_t* f = eng_format(format);
+  if (!f) return false;
+  if (out_width) *out_width = f->block_width;
+  if (out_height) *out_height = f->block_height;
+  if (out_bytes) *out_bytes = f->block_bytes;
+  return true;
+}
+
+CJ_API int cj_engine_create_buffer(cj_engine_t* e, uint32_t index, const cj_buffer_desc_t* desc) {
+  cj_res_cold_t* entry = (e && desc) ? res_live(e, CJ_RES_BUF, index) : NULL;
+  if (!entry) return 0;
 
   VkDevice dev = e->device;
   if (dev == VK_NULL_HANDLE) return 0;
@@ -803,33 +2562,43 @@ CJ_API int cj_engine_create_buffer(cj_engine_t* e, uint32_t slot, const cj_buffe
   }
 
   // Allocate memory
-  VkMemoryRequirements memRequirements;
-  vkGetBufferMemoryRequirements(dev, entry->vulkan.buffer.buffer, &memRequirements);
-
-  VkMemoryAllocateInfo allocInfo = {0};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-
   VkMemoryPropertyFlags memProps = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
   if (desc->host_visible) {
     memProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
   }
-  allocInfo.memoryTypeIndex = eng_find_memory_type(e, memRequirements.memoryTypeBits, memProps);
-
-  if (vkAllocateMemory(dev, &allocInfo, NULL, &entry->vulkan.buffer.memory) != VK_SUCCESS) {
+  if (!cj_gpu_alloc_buffer(e->gpu, entry->vulkan.buffer.buffer, memProps, 0, &entry->vulkan.buffer.alloc)) {
     vkDestroyBuffer(dev, entry->vulkan.buffer.buffer, NULL);
     return 0;
   }
-
-  vkBindBufferMemory(dev, entry->vulkan.buffer.buffer, entry->vulkan.buffer.memory, 0);
+  entry->vulkan.buffer.size = desc->size;
 
   return 1;
 }
 
-CJ_API int cj_engine_create_sampler(cj_engine_t* e, uint32_t slot, const cj_sampler_desc_t* desc) {
-  if (!e || !desc || slot >= CJ_ENGINE_MAX_SAMPLERS) return 0;
-  cj_res_entry_t* entry = &e->samplers[slot];
-  if (!entry->in_use) return 0;
+CJ_API VkBuffer cj_engine_buffer(cj_engine_t* e, uint32_t index) {
+  cj_res_cold_t* entry = e ? res_live(e, CJ_RES_BUF, index) : NULL;
+  return entry ? entry->vulkan.buffer.buffer : VK_NULL_HANDLE;
+}
+
+CJ_API cj_upload_ticket_t cj_engine_upload_buffer(cj_engine_t* e, uint32_t index, uint64_t offset, const void* data, uint64_t size) {
+  cj_res_cold_t* entry = (e && data && size) ? res_live(e, CJ_RES_BUF, index) : NULL;
+  if (!entry || entry->vulkan.buffer.buffer == VK_NULL_HANDLE) return 0;
+  if (offset > entry->vulkan.buffer.size || size > entry->vulkan.buffer.size - offset) {
+    fprintf(stderr, "cj_engine_upload_buffer: %llu bytes at %llu exceed the %llu byte buffer\n",
+            (unsigned long long)size, (unsigned long long)offset, (unsigned long long)entry->vulkan.buffer.size);
+    return 0;
+  }
+
+  uint64_t ticket = 0;
+  void* staged = cj_upload_queue_stage_buffer(e->uploads, entry->vulkan.buffer.buffer, offset, size, &ticket);
+  if (!staged) return 0;
+  memcpy(staged, data, (size_t)size);
+  return ticket;
+}
+
+CJ_API int cj_engine_create_sampler(cj_engine_t* e, uint32_t index, const cj_sampler_desc_t* desc) {
+  cj_res_cold_t* entry = (e && desc) ? res_live(e, CJ_RES_SMP, index) : NULL;
+  if (!entry) return 0;
 
   VkDevice dev = e->device;
   if (dev == VK_NULL_HANDLE) return 0;
@@ -880,63 +2649,62 @@ CJ_API int cj_engine_create_sampler(cj_engine_t* e, uint32_t slot, const cj_samp
   samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
   samplerInfo.mipLodBias = desc->mip_lod_bias;
   samplerInfo.minLod = 0.0f;
-  samplerInfo.maxLod = 0.0f;
+  /* Every level the texture has; a max of 0 would pin sampling to mip 0 and ignore the bias */
+  samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 
   if (vkCreateSampler(dev, &samplerInfo, NULL, &entry->vulkan.sampler.sampler) != VK_SUCCESS) {
     return 0;
   }
+  entry->vulkan.sampler.key = sampler_key(desc);
 
   return 1;
 }
 
-CJ_API void cj_engine_destroy_texture(cj_engine_t* e, uint32_t slot) {
-  if (!e || slot >= CJ_ENGINE_MAX_TEXTURES) return;
-  cj_res_entry_t* entry = &e->textures[slot];
-  if (!entry->in_use) return;
+CJ_API void cj_engine_destroy_texture(cj_engine_t* e, uint32_t index) {
+  cj_res_cold_t* entry = e ? res_cold(&e->tables[CJ_RES_TEX], index) : NULL;
+  if (!entry) return;
 
   VkDevice dev = e->device;
   if (dev == VK_NULL_HANDLE) return;
 
-  if (entry->vulkan.texture.sampler != VK_NULL_HANDLE) {
-    vkDestroySampler(dev, entry->vulkan.texture.sampler, NULL);
-    entry->vulkan.texture.sampler = VK_NULL_HANDLE;
+  /* The table element keeps pointing at the destroyed view until the slot is reused;
+   * the binding is partially bound, so that is valid as long as nothing samples it. */
+  if (entry->vulkan.texture.sampler_handle != 0) {
+    cj_engine_res_release(e, CJ_RES_SMP, entry->vulkan.texture.sampler_handle);
+    entry->vulkan.texture.sampler_handle = 0;
   }
+  entry->vulkan.texture.sampler = VK_NULL_HANDLE;
+  if (entry->vulkan.texture.stream) eng_stream_remove(e, index, entry);
   if (entry->vulkan.texture.imageView != VK_NULL_HANDLE) {
     vkDestroyImageView(dev, entry->vulkan.texture.imageView, NULL);
     entry->vulkan.texture.imageView = VK_NULL_HANDLE;
   }
   if (entry->vulkan.texture.image != VK_NULL_HANDLE) {
+    cj_upload_queue_discard_image(e->uploads, entry->vulkan.texture.image);
     vkDestroyImage(dev, entry->vulkan.texture.image, NULL);
     entry->vulkan.texture.image = VK_NULL_HANDLE;
   }
-  if (entry->vulkan.texture.memory != VK_NULL_HANDLE) {
-    vkFreeMemory(dev, entry->vulkan.texture.memory, NULL);
-    entry->vulkan.texture.memory = VK_NULL_HANDLE;
-  }
+  cj_gpu_free(e->gpu, &entry->vulkan.texture.alloc);
 }
 
-CJ_API void cj_engine_destroy_buffer(cj_engine_t* e, uint32_t slot) {
-  if (!e || slot >= CJ_ENGINE_MAX_BUFFERS) return;
-  cj_res_entry_t* entry = &e->buffers[slot];
-  if (!entry->in_use) return;
+CJ_API void cj_engine_destroy_buffer(cj_engine_t* e, uint32_t index) {
+  cj_res_cold_t* entry = e ? res_cold(&e->tables[CJ_RES_BUF], index) : NULL;
+  if (!entry) return;
 
   VkDevice dev = e->device;
   if (dev == VK_NULL_HANDLE) return;
 
   if (entry->vulkan.buffer.buffer != VK_NULL_HANDLE) {
+    cj_upload_queue_discard_buffer(e->uploads, entry->vulkan.buffer.buffer);
     vkDestroyBuffer(dev, entry->vulkan.buffer.buffer, NULL);
     entry->vulkan.buffer.buffer = VK_NULL_HANDLE;
   }
-  if (entry->vulkan.buffer.memory != VK_NULL_HANDLE) {
-    vkFreeMemory(dev, entry->vulkan.buffer.memory, NULL);
-    entry->vulkan.buffer.memory = VK_NULL_HANDLE;
-  }
+  cj_gpu_free(e->gpu, &entry->vulkan.buffer.alloc);
 }
 
-CJ_API void cj_engine_destroy_sampler(cj_engine_t* e, uint32_t slot) {
-  if (!e || slot >= CJ_ENGINE_MAX_SAMPLERS) return;
-  cj_res_entry_t* entry = &e->samplers[slot];
-  if (!entry->in_use) return;
+CJ_API void cj_engine_destroy_sampler(cj_engine_t* e, uint32_t index) {
+  cj_res_cold_t* entry = e ? res_cold(&e->tables[CJ_RES_SMP], index) : NULL;
+  if (!entry) return;
 
   VkDevice dev = e->device;
   if (dev == VK_NULL_HANDLE) return;
@@ -2,7 +2,7 @@
 
 #ifndef _WIN32
 #ifndef _POSIX_C_SOURCE
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200809L
 #endif
 #endif
 
@@ -10,133 +10,335 @@
 #include <cjelly/cj_window.h>
 #include <cjelly/application.h>
 #include <cjelly/window_internal.h>
+#include <cjelly/engine_internal.h>
+#include <cjelly/arena_internal.h>
+#include <cjelly/frame_pacer_internal.h>
+#include <cjelly/cj_profiler.h>
 #include <cjelly/macros.h>
 
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <limits.h>
 
 #ifdef _WIN32
 #include <windows.h>
 #else
 #include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <X11/Xlib.h>
+extern Display* display; /* provided by main on Linux */
 #endif
 
 /* High-resolution timer helpers - returns microseconds for better precision */
 static uint64_t cj_get_time_us(void) {
-#ifdef _WIN32
-  LARGE_INTEGER frequency, counter;
-  QueryPerformanceFrequency(&frequency);
-  QueryPerformanceCounter(&counter);
-  return (uint64_t)((counter.QuadPart * 1000000ULL) / frequency.QuadPart);
-#else
-  struct timespec ts;
-  clock_gettime(CLOCK_MONOTONIC, &ts);
-  return (uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000ULL;
-#endif
+  return cj_pacer_now_us();
 }
 
-/* Convenience wrapper for milliseconds (for compatibility) */
-static uint64_t cj_get_time_ms(void) {
-  return cj_get_time_us() / 1000ULL;
-}
+/* Time each iteration may spend destroying released resources */
+#define CJ_RUN_GARBAGE_BUDGET_US 500u
 
 /* Global stop flag for now (process-wide). */
 static volatile int g_cj_run_stop_requested = 0;
 
-static void cj_sleep_ms(uint32_t ms) {
-  if (ms == 0) return;
+/* Wakeup for cj_wait_events(): set by cj_wake(), cleared by the waiter.
+ * Only the first cj_wake() after a wait signals the OS object, the rest coalesce. */
+static atomic_bool g_cj_wake_pending;
+
 #ifdef _WIN32
-  Sleep((DWORD)ms);
+/* Auto-reset event waited on alongside the thread's message queue */
+static HANDLE cj_wake_event(void) {
+  static HANDLE volatile event = NULL;
+  if (!event) {
+    HANDLE created = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (created && InterlockedCompareExchangePointer((PVOID volatile*)&event, created, NULL) != NULL) {
+      CloseHandle(created);  /* Another thread got there first */
+    }
+  }
+  return event;
+}
 #else
-  struct timespec req;
-  req.tv_sec = (time_t)(ms / 1000u);
-  req.tv_nsec = (long)((ms % 1000u) * 1000000u);
-  nanosleep(&req, NULL);
+/* Non-blocking pipe polled alongside the X11 connection */
+static int g_cj_wake_pipe[2] = { -1, -1 };
+static pthread_once_t g_cj_wake_once = PTHREAD_ONCE_INIT;
+
+static void cj_wake_init(void) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    fprintf(stderr, "cj_wake: failed to create wakeup pipe\n");
+    return;
+  }
+  for (int i = 0; i < 2; i++) {
+    fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+  }
+  g_cj_wake_pipe[0] = fds[0];
+  g_cj_wake_pipe[1] = fds[1];
+}
+#endif
+
+CJ_API void cj_wake(void) {
+  if (atomic_exchange(&g_cj_wake_pending, true)) return;
+#ifdef _WIN32
+  HANDLE event = cj_wake_event();
+  if (event) SetEvent(event);
+#else
+  pthread_once(&g_cj_wake_once, cj_wake_init);
+  if (g_cj_wake_pipe[1] >= 0) {
+    char byte = 1;
+    ssize_t written = write(g_cj_wake_pipe[1], &byte, 1);
+    (void)written;  /* A full pipe already wakes the reader */
+  }
 #endif
 }
 
+CJ_API bool cj_wait_events(uint32_t timeout_ms) {
+#ifdef _WIN32
+  HANDLE event = cj_wake_event();
+  DWORD timeout = (timeout_ms == CJ_WAIT_FOREVER) ? INFINITE : (DWORD)timeout_ms;
+  /* MWMO_INPUTAVAILABLE also returns for messages already seen by an earlier peek */
+  DWORD result = event ?
+      MsgWaitForMultipleObjectsEx(1, &event, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE) :
+      MsgWaitForMultipleObjectsEx(0, NULL, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+  atomic_store(&g_cj_wake_pending, false);
+  return result != WAIT_TIMEOUT && result != WAIT_FAILED;
+#else
+  pthread_once(&g_cj_wake_once, cj_wake_init);
+  /* Events Xlib or the Vulkan WSI already read off the socket never make it readable again */
+  if (display && XEventsQueued(display, QueuedAfterFlush) > 0) return true;
+
+  struct pollfd fds[2];
+  nfds_t count = 0;
+  if (display) {
+    fds[count].fd = ConnectionNumber(display);
+    fds[count].events = POLLIN;
+    fds[count].revents = 0;
+    count++;
+  }
+  if (g_cj_wake_pipe[0] >= 0) {
+    fds[count].fd = g_cj_wake_pipe[0];
+    fds[count].events = POLLIN;
+    fds[count].revents = 0;
+    count++;
+  }
+  int timeout = (timeout_ms == CJ_WAIT_FOREVER || timeout_ms > (uint32_t)INT_MAX) ? -1 : (int)timeout_ms;
+  int ready = poll(fds, count, timeout);
+  if (ready < 0 && errno != EINTR) {
+    fprintf(stderr, "cj_wait_events: poll failed (%d)\n", errno);
+  }
+
+  /* Clear before draining, so a cj_wake() racing with this wait signals again */
+  atomic_store(&g_cj_wake_pending, false);
+  if (g_cj_wake_pipe[0] >= 0) {
+    char buffer[64];
+    while (read(g_cj_wake_pipe[0], buffer, sizeof(buffer)) > 0) {}
+  }
+  return ready > 0;
+#endif
+}
+
+/* Loop frame time for target_fps, in whole refresh cycles of the first window whose display
+ * reports its refresh duration; a target just off the refresh rate would drift against
+ * vblank and skip or double a frame every so often. */
+static uint64_t cj_run__paced_interval_us(uint64_t target_frame_us) {
+  CJellyApplication* app = cjelly_application_get_current();
+  if (!app || target_frame_us == 0) return target_frame_us;
+  for (uint32_t i = 0; i < cjelly_application_window_slots(app); i++) {
+    cj_window_t* win = (cj_window_t*)cjelly_application_window_at(app, i, NULL);
+    const cj_frame_timing_t* timing = win ? cj_window__frame_timing(win) : NULL;
+    if (timing && timing->refresh_ns > 0) return cj_frame_timing_snap_interval_us(timing, target_frame_us);
+  }
+  return target_frame_us;
+}
+
+/* Earliest time any window needs the loop to run again, given the loop's target frame time */
+static uint64_t cj_run__next_wake_time_us(bool run_when_minimized, uint64_t now_us, uint64_t loop_interval_us) {
+  CJellyApplication* app = cjelly_application_get_current();
+  if (!app) return now_us;
+
+  uint64_t wake_us = UINT64_MAX;
+  for (uint32_t i = 0; i < cjelly_application_window_slots(app) && wake_us > now_us; i++) {
+    cj_window_t* win = (cj_window_t*)cjelly_application_window_at(app, i, NULL);
+    if (!win || (!run_when_minimized && cj_window__is_minimized(win))) continue;
+    uint64_t due_us = cj_window__next_wake_time_us(win, now_us, loop_interval_us);
+    if (due_us < wake_us) wake_us = due_us;
+  }
+  return wake_us;
+}
+
 CJ_API void cj_request_stop(cj_engine_t* engine) {
   (void)engine;
   g_cj_run_stop_requested = 1;
+  /* A loop blocked in cj_wait_events() would not see the flag until the next event */
+  cj_wake();
 }
 
-/* Profiling structure for detailed timing */
+/* Windows whose frames are recorded and submitted together once the pass is done */
 typedef struct {
-  uint64_t event_poll_us;
-  uint64_t window_list_us;
-  uint64_t minimized_check_us;
-  uint64_t begin_frame_us;
-  uint64_t callback_us;
-  uint64_t execute_us;
-  uint64_t present_us;
-  uint64_t vsync_check_us;
-  uint64_t sleep_us;
-  uint64_t other_us;  /* Unaccounted time (should be VSync wait) */
-  uint32_t window_count;
-} cj_frame_profile_t;
+  cj_window_t** items;    /* NULL when windows render immediately */
+  cj_window_t** done;     /* Copy of items, which the submission may reorder */
+  uint32_t* slots;        /* Registry slot and generation of each item */
+  uint32_t* generations;
+  uint32_t count;
+  uint32_t capacity;
+} cj_render_batch_t;
+
+/* Kept across passes and grown with the window registry, so steady frames do not allocate */
+static cj_render_batch_t g_cj_run_batch;
+
+/* Make room for one item per window slot; false (render immediately) when out of memory */
+static bool cj_run__reserve_batch(cj_render_batch_t* batch, uint32_t slots) {
+  if (slots <= batch->capacity) return true;
+  uint32_t capacity = batch->capacity ? batch->capacity : 8;
+  while (capacity < slots) capacity *= 2;
+  cj_window_t** items = (cj_window_t**)realloc(batch->items, sizeof(cj_window_t*) * capacity);
+  if (items) batch->items = items;
+  cj_window_t** done = (cj_window_t**)realloc(batch->done, sizeof(cj_window_t*) * capacity);
+  if (done) batch->done = done;
+  uint32_t* slot_ids = (uint32_t*)realloc(batch->slots, sizeof(uint32_t) * capacity);
+  if (slot_ids) batch->slots = slot_ids;
+  uint32_t* generations = (uint32_t*)realloc(batch->generations, sizeof(uint32_t) * capacity);
+  if (generations) batch->generations = generations;
+  if (!items || !done || !slot_ids || !generations) return false;
+  cj_heap_note_alloc();
+  batch->capacity = capacity;
+  return true;
+}
 
-/* Internal version with flags. */
-static bool cj_run_once_with_flags(cj_engine_t* engine, bool run_when_minimized, cj_frame_profile_t* profile) {
-  (void)engine;
-  uint64_t t0, t1;
+static void cj_run__release_batch(cj_render_batch_t* batch) {
+  free(batch->items);
+  free(batch->done);
+  free(batch->slots);
+  free(batch->generations);
+  memset(batch, 0, sizeof(*batch));
+}
+
+/* Render a window now, or queue it when the engine records frames on worker threads */
+static void cj_run__render_window(cj_window_t* win, uint32_t slot, uint32_t generation, cj_render_batch_t* batch) {
+  if (batch) {
+    batch->items[batch->count] = win;
+    batch->slots[batch->count] = slot;
+    batch->generations[batch->count] = generation;
+    batch->count++;
+    return;
+  }
+
+  CJ_PROFILE_ZONE_BEGIN(execute_zone, "execute window");
+  cj_window_execute(win);
+  CJ_PROFILE_ZONE_END(execute_zone, "execute window");
+
+  CJ_PROFILE_ZONE_BEGIN(present_zone, "present window");
+  cj_window_present(win);
+  CJ_PROFILE_ZONE_END(present_zone, "present window");
+
+  /* Update last render time for FPS limiting */
+  cj_window__update_last_render_time(win, cj_get_time_us());
+
+  /* Clear dirty flag after successful frame render (if policy requires it) */
+  if (cj_window__should_clear_dirty_after_render(win)) {
+    cj_window_clear_dirty(win);
+  }
+}
+
+/* Record, submit and present every queued window that survived the callbacks */
+static void cj_run__flush_batch(CJellyApplication* app, cj_render_batch_t* batch) {
+  if (batch->count == 0) return;
+
+  /* A callback may have destroyed a window queued earlier in the pass */
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < batch->count; i++) {
+    if (cjelly_application_window_alive(app, batch->slots[i], batch->generations[i])) {
+      batch->items[kept++] = batch->items[i];
+    }
+  }
+
+  /* Rendered windows need their bookkeeping even if the batch reorders them */
+  memcpy(batch->done, batch->items, sizeof(cj_window_t*) * kept);
+
+  CJ_PROFILE_ZONE_BEGIN(batch_zone, "execute batch");
+  cj_window__execute_batch(batch->items, kept);
+  CJ_PROFILE_ZONE_END(batch_zone, "execute batch");
+
+  uint64_t now = cj_get_time_us();
+  for (uint32_t i = 0; i < kept; i++) {
+    cj_window__update_last_render_time(batch->done[i], now);
+    if (cj_window__should_clear_dirty_after_render(batch->done[i])) {
+      cj_window_clear_dirty(batch->done[i]);
+    }
+  }
+  batch->count = 0;
+}
 
+/* Internal version with flags. */
+static bool cj_run_once_with_flags(cj_engine_t* engine, bool run_when_minimized) {
   CJellyApplication* app = cjelly_application_get_current();
   if (!app) return false;
   if (g_cj_run_stop_requested) return false;
   if (cjelly_application_should_shutdown(app)) return false;
 
   /* Process events first (can close windows). */
-  t0 = cj_get_time_us();
+  CJ_PROFILE_ZONE_BEGIN(poll_zone, "poll events");
   cj_poll_events();
-  if (profile) profile->event_poll_us = cj_get_time_us() - t0;
+  CJ_PROFILE_ZONE_END(poll_zone, "poll events");
 
   if (g_cj_run_stop_requested) return false;
   if (cjelly_application_should_shutdown(app)) return false;
 
-  t0 = cj_get_time_us();
-  uint32_t count = cjelly_application_window_count(app);
-  if (count == 0) return false;
-
-  /* Use stack allocation for small window counts to avoid malloc overhead. */
-  void* windows_stack[8];
-  void** windows = (count <= 8) ? windows_stack : (void**)malloc(sizeof(void*) * count);
-  if (!windows) return false;
-  uint32_t actual = cjelly_application_get_windows(app, windows, count);
-  if (profile) {
-    profile->window_list_us = cj_get_time_us() - t0;
-    profile->window_count = actual;
+  if (cjelly_application_window_count(app) == 0) return false;
+
+  /* Windows are visited in place: a callback that destroys one empties its slot, and
+   * windows it creates take slots this pass visits later or not at all. */
+  uint32_t slots = cjelly_application_window_slots(app);
+
+  /* Rebuilt shaders are adopted when the graphs are prepared below; redraw to show them */
+  if (cj_engine_poll_shader_reload(engine ? engine : cj_engine_get_current())) {
+    for (uint32_t i = 0; i < slots; i++) {
+      cj_window_t* win = (cj_window_t*)cjelly_application_window_at(app, i, NULL);
+      if (win) cj_window_mark_dirty(win);
+    }
   }
 
   /* Check if all windows are minimized (if run_when_minimized is false).
    * We still process events, but skip rendering if all are minimized.
    */
-  t0 = cj_get_time_us();
-  if (!run_when_minimized && actual > 0) {
+  if (!run_when_minimized) {
     bool all_minimized = true;
-    for (uint32_t i = 0; i < actual; i++) {
-      cj_window_t* win = (cj_window_t*)windows[i];
+    for (uint32_t i = 0; i < slots; i++) {
+      cj_window_t* win = (cj_window_t*)cjelly_application_window_at(app, i, NULL);
       if (win && !cj_window__is_minimized(win)) {
         all_minimized = false;
         break;
       }
     }
     /* If all windows are minimized and we shouldn't run when minimized, stop. */
-    if (all_minimized) {
-      if (profile) profile->minimized_check_us = cj_get_time_us() - t0;
-      if (windows != windows_stack) free(windows);
-      return false;
-    }
+    if (all_minimized) return false;
+  }
+
+  /* A new frame: what callbacks and the engine took from the frame arena last pass is dropped */
+  cj_engine_start_frame_memory(engine ? engine : cj_engine_get_current());
+
+  /* Frames are recorded after every callback ran (in parallel with worker threads),
+   * then submitted together and presented together */
+  cj_render_batch_t* batch = NULL;
+  if (cj_run__reserve_batch(&g_cj_run_batch, slots)) {
+    batch = &g_cj_run_batch;
   }
-  if (profile) profile->minimized_check_us = cj_get_time_us() - t0;
 
   /* Render each window. */
-  uint64_t total_begin_frame = 0, total_callback = 0, total_execute = 0, total_present = 0;
-  for (uint32_t i = 0; i < actual; i++) {
-    cj_window_t* win = (cj_window_t*)windows[i];
+  for (uint32_t i = 0; i < slots; i++) {
+    uint32_t generation = 0;
+    cj_window_t* win = (cj_window_t*)cjelly_application_window_at(app, i, &generation);
     if (!win) continue;
 
+    /* Redraws posted from other threads become dirty marks on this one */
+    cj_window__take_posted_redraw(win);
+
     /* Skip minimized windows if run_when_minimized is false. */
     if (!run_when_minimized && cj_window__is_minimized(win)) {
       continue;
@@ -181,52 +383,31 @@ static bool cj_run_once_with_flags(cj_engine_t* engine, bool run_when_minimized,
     /* If window has no callback but needs render, render it */
     if (!should_call_callback && needs_render) {
       /* No callback to call, just render directly */
-      t0 = cj_get_time_us();
+      CJ_PROFILE_ZONE_BEGIN(begin_zone, "begin frame");
       cj_frame_info_t frame = {0};
-      if (cj_window_begin_frame(win, &frame) == CJ_SUCCESS) {
-        t1 = cj_get_time_us();
-        total_begin_frame += (t1 - t0);
-
-        t0 = cj_get_time_us();
-        cj_window_execute(win);
-        t1 = cj_get_time_us();
-        total_execute += (t1 - t0);
-
-        t0 = cj_get_time_us();
-        cj_window_present(win);
-        t1 = cj_get_time_us();
-        total_present += (t1 - t0);
-
-        /* Update last render time for FPS limiting */
-        cj_window__update_last_render_time(win, cj_get_time_us());
-
-        /* Clear dirty flag after successful render */
-        if (cj_window__should_clear_dirty_after_render(win)) {
-          cj_window_clear_dirty(win);
-        }
+      cj_result_t begun = cj_window_begin_frame(win, &frame);
+      CJ_PROFILE_ZONE_END(begin_zone, "begin frame");
+      if (begun == CJ_SUCCESS) {
+        cj_run__render_window(win, i, generation, batch);
       }
       continue;
     }
 
-    t0 = cj_get_time_us();
     cj_frame_info_t frame = (cj_frame_info_t){0};
     cj_result_t begin_result = CJ_SUCCESS;
     if (needs_render) {
+      CJ_PROFILE_ZONE_BEGIN(begin_zone, "begin frame");
       begin_result = cj_window_begin_frame(win, &frame);
+      CJ_PROFILE_ZONE_END(begin_zone, "begin frame");
       if (begin_result != CJ_SUCCESS) {
         /* If begin_frame fails, still call callback but skip rendering */
         needs_render = false;  /* Don't render if begin_frame failed */
       }
     }
-    t1 = cj_get_time_us();
-    if (needs_render) {
-      total_begin_frame += (t1 - t0);
-    }
 
-    t0 = cj_get_time_us();
+    CJ_PROFILE_ZONE_BEGIN(callback_zone, "frame callback");
     cj_frame_result_t result = cj_window__dispatch_frame_callback(win, &frame);
-    t1 = cj_get_time_us();
-    total_callback += (t1 - t0);
+    CJ_PROFILE_ZONE_END(callback_zone, "frame callback");
 
     /* Check again if we need to render - callback may have marked window dirty */
     bool needs_render_after_callback = cj_window__needs_redraw(win);
@@ -238,11 +419,10 @@ static bool cj_run_once_with_flags(cj_engine_t* engine, bool run_when_minimized,
 
     /* If callback marked window dirty and we haven't begun frame yet, do it now */
     if (needs_render_after_callback && !needs_render) {
-      t0 = cj_get_time_us();
+      CJ_PROFILE_ZONE_BEGIN(begin_zone, "begin frame");
       begin_result = cj_window_begin_frame(win, &frame);
-      t1 = cj_get_time_us();
+      CJ_PROFILE_ZONE_END(begin_zone, "begin frame");
       if (begin_result == CJ_SUCCESS) {
-        total_begin_frame += (t1 - t0);
         needs_render = true;
       } else {
         needs_render = false;
@@ -255,23 +435,7 @@ static bool cj_run_once_with_flags(cj_engine_t* engine, bool run_when_minimized,
     switch (result) {
       case CJ_FRAME_CONTINUE:
         if (needs_render) {
-          t0 = cj_get_time_us();
-          cj_window_execute(win);
-          t1 = cj_get_time_us();
-          total_execute += (t1 - t0);
-
-          t0 = cj_get_time_us();
-          cj_window_present(win);
-          t1 = cj_get_time_us();
-          total_present += (t1 - t0);
-
-          /* Update last render time for FPS limiting */
-          cj_window__update_last_render_time(win, cj_get_time_us());
-
-          /* Clear dirty flag after successful frame render (if policy requires it) */
-          if (cj_window__should_clear_dirty_after_render(win)) {
-            cj_window_clear_dirty(win);
-          }
+          cj_run__render_window(win, i, generation, batch);
         } else {
           /* Callback was called but window wasn't dirty - clear dirty flag if callback didn't mark it */
           if (cj_window__should_clear_dirty_after_render(win) && !cj_window__needs_redraw(win)) {
@@ -294,23 +458,7 @@ static bool cj_run_once_with_flags(cj_engine_t* engine, bool run_when_minimized,
       default:
         /* Unknown: default to continue */
         if (needs_render) {
-          t0 = cj_get_time_us();
-          cj_window_execute(win);
-          t1 = cj_get_time_us();
-          total_execute += (t1 - t0);
-
-          t0 = cj_get_time_us();
-          cj_window_present(win);
-          t1 = cj_get_time_us();
-          total_present += (t1 - t0);
-
-          /* Update last render time for FPS limiting */
-          cj_window__update_last_render_time(win, cj_get_time_us());
-
-          /* Clear dirty flag after successful frame render (if policy requires it) */
-          if (cj_window__should_clear_dirty_after_render(win)) {
-            cj_window_clear_dirty(win);
-          }
+          cj_run__render_window(win, i, generation, batch);
         }
         break;
     }
@@ -318,17 +466,20 @@ static bool cj_run_once_with_flags(cj_engine_t* engine, bool run_when_minimized,
     if (g_cj_run_stop_requested) break;
   }
 
-  if (profile) {
-    profile->begin_frame_us = total_begin_frame;
-    profile->callback_us = total_callback;
-    profile->execute_us = total_execute;
-    profile->present_us = total_present;
-    profile->vsync_check_us = 0;  /* Set in main loop */
-    profile->sleep_us = 0;  /* Set in main loop */
-    profile->other_us = 0;  /* Will be calculated in main loop */
-  }
+  if (batch) cj_run__flush_batch(app, batch);
+  /* Decoded assets get their textures and meshes; their copies start below too */
+  cj_asset_update(cj_engine_get_current());
+  /* Streamed textures load the levels this pass asked for; their copies start below */
+  cj_engine_update_streaming(cj_engine_get_current());
+  /* Uploads queued by callbacks that did not render still start this pass */
+  cj_upload_queue_flush(cj_engine_uploads(cj_engine_get_current()));
+  cj_engine_end_frame_memory(engine ? engine : cj_engine_get_current());
 
-  if (windows != windows_stack) free(windows);
+  /* Zones recorded on worker threads this pass reach the aggregates */
+  cj_profiler_collect();
+
+  /* Resources released this pass are freed once the frames just submitted retire */
+  cj_engine_collect_garbage(cj_engine_get_current(), CJ_RUN_GARBAGE_BUDGET_US);
 
   /* Continue if windows still exist and we haven't been asked to stop. */
   return (cjelly_application_window_count(app) > 0) &&
@@ -339,13 +490,50 @@ static bool cj_run_once_with_flags(cj_engine_t* engine, bool run_when_minimized,
 /* Run a single iteration. Returns false when loop should stop. */
 CJ_API bool cj_run_once(cj_engine_t* engine) {
   (void)engine;
-  return cj_run_once_with_flags(engine, false, NULL);
+  return cj_run_once_with_flags(engine, false);
 }
 
 CJ_API void cj_run(cj_engine_t* engine) {
   cj_run_with_config(engine, NULL);
 }
 
+/* Print the FPS line, CPU zone averages per frame, and every window's latest frame timings */
+static void cj_run__print_profile(uint32_t frames, double elapsed_s, double min_us, double max_us, double total_us) {
+  double fps = (frames > 0 && elapsed_s > 0.0) ? frames / elapsed_s : 0.0;
+  double avg_us = (frames > 0) ? total_us / frames : 0.0;
+  printf("FPS: %.2f | Frame time: avg=%.3fms min=%.3fms max=%.3fms | Frames: %u\n",
+         fps, avg_us / 1000.0, min_us / 1000.0, max_us / 1000.0, frames);
+  if (frames == 0) return;
+
+  cj_profiler_zone_stat_t zones[32];
+  uint32_t zone_count = cj_profiler_zone_stats(zones, 32, true);
+  if (zone_count > 32) zone_count = 32;
+  if (zone_count > 0) printf("  CPU zones (avg per frame | max | calls per frame):\n");
+  for (uint32_t i = 0; i < zone_count; i++) {
+    if (zones[i].count == 0) continue;
+    printf("    %-22s %8.3fms | %8.3fms | %.1f\n", zones[i].name,
+           (double)zones[i].total_ns / frames / 1e6, (double)zones[i].max_ns / 1e6,
+           (double)zones[i].count / frames);
+  }
+
+  CJellyApplication* app = cjelly_application_get_current();
+  uint32_t slots = app ? cjelly_application_window_slots(app) : 0;
+  for (uint32_t i = 0; i < slots; i++) {
+    cj_window_t* win = (cj_window_t*)cjelly_application_window_at(app, i, NULL);
+    cj_profiler_frame_stats_t stats;
+    if (!win || cj_profiler_window_stats(win, &stats) != CJ_SUCCESS || stats.frame_index == 0) continue;
+    printf("  Window %u: frame %llu CPU %.3fms", i, (unsigned long long)stats.frame_index, stats.cpu_ms);
+    if (stats.gpu_frame_index == 0) {
+      printf(" | GPU n/a\n");
+      continue;
+    }
+    printf(" | frame %llu GPU %.3fms\n", (unsigned long long)stats.gpu_frame_index, stats.gpu_ms);
+    for (uint32_t z = 0; z < stats.gpu_zone_count; z++) {
+      printf("    %-22s %8.3fms\n", stats.gpu_zones[z].name, stats.gpu_zones[z].ms);
+    }
+  }
+}
+
 CJ_API void cj_run_with_config(cj_engine_t* engine, const cj_run_config_t* config) {
   (void)engine;
 
@@ -355,175 +543,124 @@ CJ_API void cj_run_with_config(cj_engine_t* engine, const cj_run_config_t* confi
   uint32_t target_fps = 0;
   bool run_when_minimized = false;
   bool enable_fps_profiling = false;
+  bool wait_for_events = false;
 
   if (config) {
     target_fps = config->target_fps;
-    /* Note: config->vsync is reserved for future use when we support different present modes */
+    /* Present mode is chosen per window (cj_window_desc_t.present_mode) */
     (void)config->vsync;  /* Suppress unused warning */
     run_when_minimized = config->run_when_minimized;
     enable_fps_profiling = config->enable_fps_profiling;
+    wait_for_events = config->wait_for_events;
   }
 
-  /* Calculate target frame time in milliseconds. */
-  uint32_t target_frame_ms = 0;
+  /* Calculate target frame time in microseconds (whole milliseconds would turn 144 FPS into 166). */
+  uint64_t base_frame_us = 0;
   if (target_fps > 0) {
-    target_frame_ms = 1000u / target_fps;
+    base_frame_us = 1000000ULL / target_fps;
   }
 
   /* Track frame timing for accurate pacing (using microsecond precision). */
+  uint64_t next_frame_us = 0;  /* Absolute deadline of the next iteration when sleeping */
 
-  /* FPS profiling state (if enabled). */
+  /* Statistics come from the profiler, which records while they are printed */
+  bool profiler_was_enabled = cj_profiler_is_enabled();
+  if (enable_fps_profiling) {
+    if (!cj_profiler_available()) {
+      fprintf(stderr, "cj_run_with_config: built with CJ_ENABLE_PROFILER=0, printing FPS only\n");
+    }
+    cj_profiler_set_enabled(true);
+    /* Zones from before the loop would skew the first report */
+    cj_profiler_zone_stats(NULL, 0, true);
+  }
+
+  /* FPS statistics since the last report */
   uint64_t fps_start_time_us = cj_get_time_us();
-  uint64_t fps_last_print_time = cj_get_time_ms();
   uint32_t fps_frame_count = 0;
   double fps_min_frame_time_us = 1e9;
   double fps_max_frame_time_us = 0;
   double fps_total_frame_time_us = 0;
 
-  /* Detailed profiling accumulators */
-  double total_event_poll_us = 0;
-  double total_window_list_us = 0;
-  double total_minimized_check_us = 0;
-  double total_begin_frame_us = 0;
-  double total_callback_us = 0;
-  double total_execute_us = 0;
-  double total_present_us = 0;
-  double total_vsync_check_us = 0;
-  double total_sleep_us = 0;
-  double total_other_us = 0;
-
-  /* VSync is always active (FIFO mode), but we still respect target_fps for lower limits. */
+  /* FIFO windows are paced by vblank; target_fps still applies for lower limits. */
 
   /* Main loop: run until cj_run_once says stop. */
-  cj_frame_profile_t profile = {0};
   uint64_t frame_start_us = cj_get_time_us();
-  uint64_t vsync_check_start_us = 0;
-  uint64_t sleep_start_us = 0;
 
-  while (cj_run_once_with_flags(engine, run_when_minimized, enable_fps_profiling ? &profile : NULL)) {
+  while (cj_run_once_with_flags(engine, run_when_minimized)) {
     uint64_t loop_end_us = cj_get_time_us();
-    double frame_duration_us = (double)(loop_end_us - frame_start_us);
 
     /* Frame timing: respect target FPS if set.
-     * Note: VSync (FIFO mode) limits to 60 FPS max, but we can still limit to lower FPS.
+     * Note: FIFO windows are capped at the display refresh rate, but we can still limit to lower FPS.
      */
-    uint64_t vsync_check_us = 0;
-    uint64_t sleep_us = 0;
-    if (target_frame_ms > 0) {
-      /* VSync is always active (FIFO mode), but we still respect target_fps.
-       * The config->vsync flag is for future use when we support different present modes.
-       */
-      if (enable_fps_profiling) {
-        vsync_check_start_us = cj_get_time_us();
-        vsync_check_us = cj_get_time_us() - vsync_check_start_us;
+    uint64_t target_frame_us = cj_run__paced_interval_us(base_frame_us);
+    CJ_PROFILE_ZONE_BEGIN(wait_zone, "wait");
+    if (wait_for_events) {
+      /* Block until the earliest window deadline, waking early for OS events and cj_wake().
+       * target_fps still caps the loop rate and sets the CJ_REDRAW_ON_EVENTS callback rate. */
+      uint64_t wake_us = cj_run__next_wake_time_us(run_when_minimized, loop_end_us, target_frame_us);
+      if (target_frame_us > 0 && wake_us < frame_start_us + target_frame_us) {
+        wake_us = frame_start_us + target_frame_us;
+      }
+      if (wake_us > loop_end_us) {
+        uint32_t timeout_ms = CJ_WAIT_FOREVER;
+        if (wake_us != UINT64_MAX) {
+          /* End the OS wait a spin margin early; the pacer lands on the deadline itself */
+          uint64_t wait_us = wake_us - loop_end_us;
+          uint64_t margin_us = cj_pacer_spin_margin_us();
+          uint64_t wait_ms = (wait_us > margin_us) ? (wait_us - margin_us) / 1000ULL : 0;
+          timeout_ms = (wait_ms < (uint64_t)CJ_WAIT_FOREVER) ? (uint32_t)wait_ms : CJ_WAIT_FOREVER - 1u;
+        }
+        if (!cj_wait_events(timeout_ms) && wake_us != UINT64_MAX) {
+          cj_pacer_sleep_until_us(wake_us);
+        }
       }
+    } else if (target_frame_us > 0) {
+      /* FIFO windows are paced by vblank, but we still respect target_fps.
+       * MAILBOX/IMMEDIATE windows rely on target_fps alone for pacing.
+       */
 
       /* Sleep to respect target FPS if we finished early.
-       * Use microsecond precision for accurate timing.
+       * Deadlines are absolute, so a late wake-up shortens the next wait instead of
+       * shifting every later frame; the pacer sleeps coarsely and spins the last stretch.
        * Even with VSync active, we can limit to lower FPS (e.g., 30 FPS).
-       * VSync will prevent going above 60 FPS, but we can still sleep to hit lower targets.
+       * VSync will prevent going above the refresh rate, but we can still sleep to hit lower targets.
        */
-      uint64_t target_frame_us = (uint64_t)target_frame_ms * 1000ULL;
-      if (frame_duration_us < (double)target_frame_us) {
-        uint64_t sleep_us_needed = target_frame_us - (uint64_t)frame_duration_us;
-        uint32_t sleep_ms = (uint32_t)(sleep_us_needed / 1000ULL);
-        /* Sleep at least 1ms if we need any sleep (nanosleep has minimum granularity) */
-        if (sleep_ms > 0 || (sleep_us_needed % 1000ULL) > 0) {
-          if (sleep_ms == 0) sleep_ms = 1;  /* Minimum 1ms sleep */
-          if (enable_fps_profiling) sleep_start_us = cj_get_time_us();
-          cj_sleep_ms(sleep_ms);
-          if (enable_fps_profiling) sleep_us = cj_get_time_us() - sleep_start_us;
-        }
+      next_frame_us = (next_frame_us == 0) ? frame_start_us + target_frame_us : next_frame_us + target_frame_us;
+      if (next_frame_us + target_frame_us < loop_end_us) {
+        /* More than a frame behind (a stall): start a new cadence instead of catching up in a burst */
+        next_frame_us = loop_end_us;
+      }
+      if (next_frame_us > loop_end_us) {
+        cj_pacer_sleep_until_us(next_frame_us);
       }
     }
+    CJ_PROFILE_ZONE_END(wait_zone, "wait");
 
     /* Update frame start for next iteration (after all work is done) */
-    frame_start_us = cj_get_time_us();
+    uint64_t now_us = cj_get_time_us();
+    double frame_duration_us = (double)(now_us - frame_start_us);
+    frame_start_us = now_us;
 
-    /* FPS profiling (if enabled). */
+    /* FPS profiling (if enabled): per-stage costs come from the profiler's zones. */
     if (enable_fps_profiling) {
-      /* Calculate unaccounted time (likely VSync wait in execute) */
-      double accounted_us = (double)profile.event_poll_us +
-                           (double)profile.window_list_us +
-                           (double)profile.minimized_check_us +
-                           (double)profile.begin_frame_us +
-                           (double)profile.callback_us +
-                           (double)profile.execute_us +
-                           (double)profile.present_us +
-                           vsync_check_us +
-                           sleep_us;
-      profile.other_us = (uint64_t)(frame_duration_us - accounted_us);
-      if (profile.other_us > frame_duration_us) profile.other_us = 0;  /* Sanity check */
-
       fps_frame_count++;
-      if (frame_duration_us < fps_min_frame_time_us) {
-        fps_min_frame_time_us = frame_duration_us;
-      }
-      if (frame_duration_us > fps_max_frame_time_us) {
-        fps_max_frame_time_us = frame_duration_us;
-      }
+      if (frame_duration_us < fps_min_frame_time_us) fps_min_frame_time_us = frame_duration_us;
+      if (frame_duration_us > fps_max_frame_time_us) fps_max_frame_time_us = frame_duration_us;
       fps_total_frame_time_us += frame_duration_us;
 
-      /* Accumulate detailed profiling data */
-      total_event_poll_us += (double)profile.event_poll_us;
-      total_window_list_us += (double)profile.window_list_us;
-      total_minimized_check_us += (double)profile.minimized_check_us;
-      total_begin_frame_us += (double)profile.begin_frame_us;
-      total_callback_us += (double)profile.callback_us;
-      total_execute_us += (double)profile.execute_us;
-      total_present_us += (double)profile.present_us;
-      total_vsync_check_us += (double)vsync_check_us;
-      total_sleep_us += (double)sleep_us;
-      total_other_us += (double)profile.other_us;
-
       /* Print statistics every second. */
-      uint64_t current_time = cj_get_time_ms();
-      if (current_time - fps_last_print_time >= 1000) {
-        double elapsed_seconds = ((double)(cj_get_time_us() - fps_start_time_us)) / 1000000.0;
-        double fps = (fps_frame_count > 0) ? (fps_frame_count / elapsed_seconds) : 0.0;
-        double avg_frame_time_us = (fps_frame_count > 0) ?
-          (fps_total_frame_time_us / fps_frame_count) : 0.0;
-
-        printf("FPS: %.2f | Frame time: avg=%.3fms min=%.3fms max=%.3fms | Frames: %u\n",
-               fps, avg_frame_time_us / 1000.0,
-               fps_min_frame_time_us / 1000.0, fps_max_frame_time_us / 1000.0,
-               fps_frame_count);
-
-        /* Print detailed breakdown */
-        if (fps_frame_count > 0) {
-          printf("  Breakdown (avg per frame):\n");
-          printf("    Event poll:     %.3fms\n", (total_event_poll_us / fps_frame_count) / 1000.0);
-          printf("    Window list:    %.3fms\n", (total_window_list_us / fps_frame_count) / 1000.0);
-          printf("    Minimized chk: %.3fms\n", (total_minimized_check_us / fps_frame_count) / 1000.0);
-          printf("    Begin frame:   %.3fms\n", (total_begin_frame_us / fps_frame_count) / 1000.0);
-          printf("    Callback:      %.3fms\n", (total_callback_us / fps_frame_count) / 1000.0);
-          printf("    Execute:       %.3fms\n", (total_execute_us / fps_frame_count) / 1000.0);
-          printf("    Present:       %.3fms\n", (total_present_us / fps_frame_count) / 1000.0);
-          printf("    VSync check:   %.3fms\n", (total_vsync_check_us / fps_frame_count) / 1000.0);
-          printf("    Sleep:         %.3fms\n", (total_sleep_us / fps_frame_count) / 1000.0);
-          printf("    Other/VSync:   %.3fms (likely VSync wait in execute)\n", (total_other_us / fps_frame_count) / 1000.0);
-          printf("    Windows:       %u\n", profile.window_count);
-        }
-
-        /* Reset profiling counters. */
-        fps_last_print_time = current_time;
+      if (now_us - fps_start_time_us >= 1000000ULL) {
+        cj_run__print_profile(fps_frame_count, (double)(now_us - fps_start_time_us) / 1000000.0,
+                              fps_min_frame_time_us, fps_max_frame_time_us, fps_total_frame_time_us);
         fps_frame_count = 0;
-        fps_start_time_us = cj_get_time_us();
+        fps_start_time_us = now_us;
         fps_min_frame_time_us = 1e9;
         fps_max_frame_time_us = 0;
         fps_total_frame_time_us = 0;
-        total_event_poll_us = 0;
-        total_window_list_us = 0;
-        total_minimized_check_us = 0;
-        total_begin_frame_us = 0;
-        total_callback_us = 0;
-        total_execute_us = 0;
-        total_present_us = 0;
-        total_vsync_check_us = 0;
-        total_sleep_us = 0;
-        total_other_us = 0;
       }
     }
   }
-}
 
+  if (enable_fps_profiling) cj_profiler_set_enabled(profiler_was_enabled);
+  cj_run__release_batch(&g_cj_run_batch);
+}
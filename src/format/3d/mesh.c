@@ -0,0 +1,596 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cjelly/format/3d/mesh.h>
+
+
+// Reference documents:
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+
+
+// Size of the simulated post-transform vertex cache, and the scoring
+// constants from Forsyth's paper.
+#define CACHE_SIZE 32
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+// Valence scores are tabulated up to this many remaining triangles.
+#define VALENCE_TABLE_SIZE 64
+
+// Marks an empty hash table slot or a vertex that has not been numbered.
+#define NONE UINT32_MAX
+
+
+/**
+ * @brief One corner of an OBJ face: indices into the three OBJ arrays.
+ */
+typedef struct {
+  int vertex;
+  int texcoord;
+  int normal;
+} Corner;
+
+
+/**
+ * @brief Open-addressing hash set that numbers distinct corners.
+ */
+typedef struct {
+  uint32_t * slots;   // Vertex number per slot, or NONE.
+  uint32_t mask;      // Slot count minus one; the slot count is a power of two.
+  Corner * corners;   // The corner of each vertex number.
+  uint32_t count;     // Number of distinct corners.
+} CornerSet;
+
+
+/**
+ * @brief Working memory for the vertex cache optimizer.
+ */
+typedef struct {
+  uint32_t * valence;         // Triangles not yet emitted, per vertex.
+  uint32_t * adjacencyStart;  // Start of each vertex's list in adjacency.
+  int32_t * cachePosition;    // Position in the simulated cache, or -1.
+  float * score;              // Score per vertex.
+  uint32_t * adjacency;       // Triangles that use each vertex.
+  float * triangleScore;      // Score per triangle of the range.
+  bool * emitted;             // Whether each triangle has been emitted.
+  uint32_t * input;           // Copy of the range's indices.
+  float cacheScores[CACHE_SIZE];
+  float valenceScores[VALENCE_TABLE_SIZE];
+} CacheScratch;
+
+
+static Corner faceCorner(const CJellyFormat3dObjFace * face, int i) {
+  Corner corner;
+  if (i < 4) {
+    corner.vertex = face->vertex[i];
+    corner.texcoord = face->texcoord[i];
+    corner.normal = face->normal[i];
+  }
+  else {
+    const CJellyFormat3dObjFaceOverflow * overflow = &face->overflow[i - 4];
+    corner.vertex = overflow->vertex;
+    corner.texcoord = overflow->texcoord;
+    corner.normal = overflow->normal;
+  }
+  return corner;
+}
+
+
+static uint32_t hashCorner(Corner corner) {
+  uint32_t h = (uint32_t)corner.vertex * 0x9E3779B1u;
+  h ^= (uint32_t)(corner.texcoord + 1) * 0x85EBCA77u + (h << 6) + (h >> 2);
+  h ^= (uint32_t)(corner.normal + 1) * 0xC2B2AE3Du + (h << 6) + (h >> 2);
+  h ^= h >> 16;
+  h *= 0x7FEB352Du;
+  h ^= h >> 15;
+  return h;
+}
+
+
+// Returns the vertex number of a corner, numbering it if it is new.
+static uint32_t insertCorner(CornerSet * set, Corner corner) {
+  uint32_t i = hashCorner(corner) & set->mask;
+  while (true) {
+    uint32_t vertex = set->slots[i];
+    if (vertex == NONE) {
+      set->slots[i] = set->count;
+      set->corners[set->count] = corner;
+      return set->count++;
+    }
+    const Corner * other = &set->corners[vertex];
+    if (other->vertex == corner.vertex && other->texcoord == corner.texcoord && other->normal == corner.normal) {
+      return vertex;
+    }
+    i = (i + 1) & set->mask;
+  }
+}
+
+
+static int faceBucket(const CJellyFormat3dObjFace * face) {
+  return face->material_index < 0 ? 0 : face->material_index + 1;
+}
+
+
+static float vertexScore(const CacheScratch * s, int32_t cachePosition, uint32_t remaining) {
+  if (remaining == 0) {
+    // Vertices without triangles left never attract a triangle.
+    return -1.0f;
+  }
+  float score = cachePosition >= 0 ? s->cacheScores[cachePosition] : 0.0f;
+  score += remaining < VALENCE_TABLE_SIZE
+    ? s->valenceScores[remaining]
+    : VALENCE_BOOST_SCALE * powf((float)remaining, -VALENCE_BOOST_POWER);
+  return score;
+}
+
+
+static float triangleScore(const CacheScratch * s, const uint32_t * triangle) {
+  return s->score[triangle[0]] + s->score[triangle[1]] + s->score[triangle[2]];
+}
+
+
+// Reorders the triangles of one range for the post-transform vertex cache.
+// Greedily emits the triangle whose vertices score highest, where vertices
+// score for being recently used and for having few triangles left.
+static void optimizeVertexCache(CacheScratch * s, uint32_t * indices, uint32_t triangleCount) {
+  if (triangleCount == 0) return;
+  uint32_t indexCount = triangleCount * 3;
+  memcpy(s->input, indices, indexCount * sizeof(uint32_t));
+  const uint32_t * in = s->input;
+
+  // Build the triangle list of every vertex the range uses.  adjacencyStart
+  // first holds the end of each list and is walked back while filling it.
+  for (uint32_t i = 0; i < indexCount; ++i) {
+    s->valence[in[i]] = 0;
+    s->cachePosition[in[i]] = -1;
+  }
+  for (uint32_t i = 0; i < indexCount; ++i) {
+    s->valence[in[i]]++;
+  }
+  uint32_t offset = 0;
+  for (uint32_t i = 0; i < indexCount; ++i) {
+    uint32_t v = in[i];
+    if (s->cachePosition[v] == -1) {
+      s->cachePosition[v] = -2;
+      offset += s->valence[v];
+      s->adjacencyStart[v] = offset;
+    }
+  }
+  for (uint32_t i = indexCount; i-- > 0;) {
+    s->adjacency[--s->adjacencyStart[in[i]]] = i / 3;
+  }
+
+  for (uint32_t i = 0; i < indexCount; ++i) {
+    uint32_t v = in[i];
+    s->cachePosition[v] = -1;
+    s->score[v] = vertexScore(s, -1, s->valence[v]);
+  }
+  uint32_t best = 0;
+  for (uint32_t t = 0; t < triangleCount; ++t) {
+    s->emitted[t] = false;
+    s->triangleScore[t] = triangleScore(s, &in[t * 3]);
+    if (s->triangleScore[t] > s->triangleScore[best]) {
+      best = t;
+    }
+  }
+
+  uint32_t cache[CACHE_SIZE + 3];
+  uint32_t cacheCount = 0;
+  uint32_t written = 0;
+  uint32_t scan = 0;
+  while (true) {
+    const uint32_t * triangle = &in[best * 3];
+    s->emitted[best] = true;
+    indices[written++] = triangle[0];
+    indices[written++] = triangle[1];
+    indices[written++] = triangle[2];
+
+    // Drop the triangle from the lists of its vertices.
+    for (int k = 0; k < 3; ++k) {
+      uint32_t v = triangle[k];
+      uint32_t * list = &s->adjacency[s->adjacencyStart[v]];
+      uint32_t count = s->valence[v];
+      for (uint32_t j = 0; j < count; ++j) {
+        if (list[j] == best) {
+          list[j] = list[count - 1];
+          break;
+        }
+      }
+      s->valence[v]--;
+    }
+
+    // The triangle's vertices move to the front of the cache.
+    uint32_t next[CACHE_SIZE + 3];
+    uint32_t nextCount = 0;
+    for (int k = 0; k < 3; ++k) {
+      if ((k < 1 || triangle[k] != triangle[0]) && (k < 2 || triangle[k] != triangle[1])) {
+        next[nextCount++] = triangle[k];
+      }
+    }
+    for (uint32_t j = 0; j < cacheCount; ++j) {
+      uint32_t v = cache[j];
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+        next[nextCount++] = v;
+      }
+    }
+
+    // Rescore the vertices that moved, including the ones that fell out, and
+    // the triangles around them; the best of those triangles goes next.
+    for (uint32_t j = 0; j < nextCount; ++j) {
+      uint32_t v = next[j];
+      s->cachePosition[v] = j < CACHE_SIZE ? (int32_t)j : -1;
+      s->score[v] = vertexScore(s, s->cachePosition[v], s->valence[v]);
+    }
+    float bestScore = -1.0f;
+    best = NONE;
+    for (uint32_t j = 0; j < nextCount; ++j) {
+      uint32_t v = next[j];
+      const uint32_t * list = &s->adjacency[s->adjacencyStart[v]];
+      for (uint32_t a = 0; a < s->valence[v]; ++a) {
+        uint32_t t = list[a];
+        s->triangleScore[t] = triangleScore(s, &in[t * 3]);
+        if (s->triangleScore[t] > bestScore) {
+          bestScore = s->triangleScore[t];
+          best = t;
+        }
+      }
+    }
+    cacheCount = nextCount < CACHE_SIZE ? nextCount : CACHE_SIZE;
+    memcpy(cache, next, cacheCount * sizeof(uint32_t));
+
+    // When no cached vertex has triangles left, continue with the next
+    // triangle in the original order.
+    if (best == NONE) {
+      while (scan < triangleCount && s->emitted[scan]) {
+        ++scan;
+      }
+      if (scan == triangleCount) break;
+      best = scan;
+    }
+  }
+}
+
+
+// Fills each vertex that has no normal with the area-weighted average of the
+// normals of the triangles that share its position.
+static bool generateNormals(CJellyFormat3dMesh * mesh, const CJellyFormat3dObjModel * model,
+    const CornerSet * set, const uint32_t * indices) {
+  float (* sum)[3] = calloc(model->vertex_count ? model->vertex_count : 1, sizeof(*sum));
+  if (!sum) return false;
+
+  for (uint32_t i = 0; i < mesh->index_count; i += 3) {
+    const float * p0 = mesh->vertices[indices[i]].position;
+    const float * p1 = mesh->vertices[indices[i + 1]].position;
+    const float * p2 = mesh->vertices[indices[i + 2]].position;
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    // The cross product is twice the triangle's area long.
+    float n[3] = {
+      e1[1] * e2[2] - e1[2] * e2[1],
+      e1[2] * e2[0] - e1[0] * e2[2],
+      e1[0] * e2[1] - e1[1] * e2[0],
+    };
+    for (int k = 0; k < 3; ++k) {
+      float * total = sum[set->corners[indices[i + k]].vertex];
+      total[0] += n[0];
+      total[1] += n[1];
+      total[2] += n[2];
+    }
+  }
+
+  for (uint32_t v = 0; v < mesh->vertex_count; ++v) {
+    if (set->corners[v].normal >= 0) continue;
+    const float * total = sum[set->corners[v].vertex];
+    float length = sqrtf(total[0] * total[0] + total[1] * total[1] + total[2] * total[2]);
+    float * normal = mesh->vertices[v].normal;
+    if (length > 0.0f) {
+      normal[0] = total[0] / length;
+      normal[1] = total[1] / length;
+      normal[2] = total[2] / length;
+    }
+    else {
+      // Only degenerate triangles use this position; any direction will do.
+      normal[0] = 0.0f;
+      normal[1] = 0.0f;
+      normal[2] = 1.0f;
+    }
+  }
+  free(sum);
+  return true;
+}
+
+
+// Runs the vertex cache optimizer on every range, then renumbers the vertices
+// in the order the index buffer first uses them.
+static bool optimizeMesh(CJellyFormat3dMesh * mesh, uint32_t * indices) {
+  bool ok = false;
+  uint32_t maxTriangles = 0;
+  for (uint32_t r = 0; r < mesh->range_count; ++r) {
+    uint32_t triangles = mesh->ranges[r].index_count / 3;
+    if (triangles > maxTriangles) maxTriangles = triangles;
+  }
+  size_t vertexCount = mesh->vertex_count ? mesh->vertex_count : 1;
+  size_t indexCount = maxTriangles ? (size_t)maxTriangles * 3 : 1;
+
+  CacheScratch s;
+  s.valence = malloc(vertexCount * sizeof(uint32_t));
+  s.adjacencyStart = malloc(vertexCount * sizeof(uint32_t));
+  s.cachePosition = malloc(vertexCount * sizeof(int32_t));
+  s.score = malloc(vertexCount * sizeof(float));
+  s.adjacency = malloc(indexCount * sizeof(uint32_t));
+  s.triangleScore = malloc(indexCount / 3 * sizeof(float) + sizeof(float));
+  s.emitted = malloc(indexCount / 3 + 1);
+  s.input = malloc(indexCount * sizeof(uint32_t));
+  uint32_t * remap = malloc(vertexCount * sizeof(uint32_t));
+  CJellyFormat3dMeshVertex * vertices = malloc(vertexCount * sizeof(CJellyFormat3dMeshVertex));
+  if (!s.valence || !s.adjacencyStart || !s.cachePosition || !s.score || !s.adjacency
+      || !s.triangleScore || !s.emitted || !s.input || !remap || !vertices) {
+    goto CLEANUP;
+  }
+
+  for (int i = 0; i < CACHE_SIZE; ++i) {
+    s.cacheScores[i] = i < 3
+      ? LAST_TRIANGLE_SCORE
+      : powf(1.0f - (float)(i - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+  }
+  s.valenceScores[0] = 0.0f;
+  for (int i = 1; i < VALENCE_TABLE_SIZE; ++i) {
+    s.valenceScores[i] = VALENCE_BOOST_SCALE * powf((float)i, -VALENCE_BOOST_POWER);
+  }
+
+  for (uint32_t r = 0; r < mesh->range_count; ++r) {
+    optimizeVertexCache(&s, indices + mesh->ranges[r].first_index, mesh->ranges[r].index_count / 3);
+  }
+
+  for (uint32_t v = 0; v < mesh->vertex_count; ++v) {
+    remap[v] = NONE;
+  }
+  uint32_t next = 0;
+  for (uint32_t i = 0; i < mesh->index_count; ++i) {
+    uint32_t v = indices[i];
+    if (remap[v] == NONE) {
+      remap[v] = next;
+      vertices[next++] = mesh->vertices[v];
+    }
+    indices[i] = remap[v];
+  }
+  free(mesh->vertices);
+  mesh->vertices = vertices;
+  vertices = NULL;
+  ok = true;
+
+CLEANUP:
+  free(s.valence);
+  free(s.adjacencyStart);
+  free(s.cachePosition);
+  free(s.score);
+  free(s.adjacency);
+  free(s.triangleScore);
+  free(s.emitted);
+  free(s.input);
+  free(remap);
+  free(vertices);
+  return ok;
+}
+
+
+CJellyFormat3dMeshError cjelly_format_3d_mesh_from_obj(const CJellyFormat3dObjModel * model,
+    unsigned flags, CJellyFormat3dMesh * * outMesh) {
+  CJellyFormat3dMeshError err = CJELLY_FORMAT_3D_MESH_SUCCESS;
+
+  // Check for invalid input.
+  if (!model || !outMesh) {
+    return CJELLY_FORMAT_3D_MESH_ERR_INVALID_MODEL;
+  }
+
+  // Validate the faces and size everything before allocating.
+  uint64_t triangleCount = 0;
+  uint64_t cornerCount = 0;
+  int maxMaterial = -1;
+  int maxCorners = 0;
+  for (int f = 0; f < model->face_count; ++f) {
+    const CJellyFormat3dObjFace * face = &model->faces[f];
+    if (face->count < 3) continue;
+    if (face->count > 4 && !face->overflow) {
+      return CJELLY_FORMAT_3D_MESH_ERR_INVALID_MODEL;
+    }
+    for (int i = 0; i < face->count; ++i) {
+      Corner corner = faceCorner(face, i);
+      if (corner.vertex < 0 || corner.vertex >= model->vertex_count
+          || corner.texcoord < -1 || corner.texcoord >= model->texcoord_count
+          || corner.normal < -1 || corner.normal >= model->normal_count) {
+        return CJELLY_FORMAT_3D_MESH_ERR_INVALID_MODEL;
+      }
+    }
+    triangleCount += (uint64_t)face->count - 2;
+    cornerCount += (uint64_t)face->count;
+    if (face->material_index > maxMaterial) maxMaterial = face->material_index;
+    if (face->count > maxCorners) maxCorners = face->count;
+  }
+  if (triangleCount * 3 > UINT32_MAX || cornerCount > (UINT32_MAX >> 2)) {
+    return CJELLY_FORMAT_3D_MESH_ERR_TOO_LARGE;
+  }
+
+  // Faces are bucketed by material; bucket 0 holds faces without one.
+  uint32_t bucketCount = (uint32_t)maxMaterial + 2;
+  uint32_t indexCount = (uint32_t)triangleCount * 3;
+  uint32_t slotCount = 1;
+  while (slotCount < cornerCount * 2) {
+    slotCount <<= 1;
+  }
+
+  CornerSet set = {0};
+  uint32_t * bucketStart = calloc(bucketCount + 1, sizeof(uint32_t));
+  uint32_t * bucketFill = calloc(bucketCount, sizeof(uint32_t));
+  uint32_t * faceVertices = malloc((maxCorners ? maxCorners : 1) * sizeof(uint32_t));
+  uint32_t * indices = malloc((indexCount ? indexCount : 1) * sizeof(uint32_t));
+  set.slots = malloc(slotCount * sizeof(uint32_t));
+  set.corners = malloc((cornerCount ? cornerCount : 1) * sizeof(Corner));
+  set.mask = slotCount - 1;
+  CJellyFormat3dMesh * mesh = calloc(1, sizeof(CJellyFormat3dMesh));
+  if (!bucketStart || !bucketFill || !faceVertices || !indices || !set.slots || !set.corners || !mesh) {
+    goto ERROR_CLEANUP;
+  }
+  memset(set.slots, 0xFF, slotCount * sizeof(uint32_t));
+
+  // Lay the buckets out one after another, in material order.
+  for (int f = 0; f < model->face_count; ++f) {
+    const CJellyFormat3dObjFace * face = &model->faces[f];
+    if (face->count >= 3) {
+      bucketStart[faceBucket(face) + 1] += (uint32_t)face->count - 2;
+    }
+  }
+  for (uint32_t b = 0; b < bucketCount; ++b) {
+    bucketStart[b + 1] += bucketStart[b];
+  }
+
+  // Number the distinct corners and triangulate each face as a fan.  Faces
+  // keep their file order within a bucket.
+  for (int f = 0; f < model->face_count; ++f) {
+    const CJellyFormat3dObjFace * face = &model->faces[f];
+    if (face->count < 3) continue;
+    for (int i = 0; i < face->count; ++i) {
+      faceVertices[i] = insertCorner(&set, faceCorner(face, i));
+    }
+    int bucket = faceBucket(face);
+    uint32_t * out = &indices[(bucketStart[bucket] + bucketFill[bucket]) * 3];
+    for (int i = 1; i + 1 < face->count; ++i) {
+      *out++ = faceVertices[0];
+      *out++ = faceVertices[i];
+      *out++ = faceVertices[i + 1];
+    }
+    bucketFill[bucket] += (uint32_t)face->count - 2;
+  }
+
+  for (uint32_t b = 0; b < bucketCount; ++b) {
+    if (bucketStart[b + 1] > bucketStart[b]) mesh->range_count++;
+  }
+  mesh->ranges = malloc((mesh->range_count ? mesh->range_count : 1) * sizeof(CJellyFormat3dMeshRange));
+  mesh->vertices = malloc((set.count ? set.count : 1) * sizeof(CJellyFormat3dMeshVertex));
+  if (!mesh->ranges || !mesh->vertices) { goto ERROR_CLEANUP; }
+  mesh->vertex_count = set.count;
+  mesh->index_count = indexCount;
+
+  uint32_t range = 0;
+  for (uint32_t b = 0; b < bucketCount; ++b) {
+    if (bucketStart[b + 1] == bucketStart[b]) continue;
+    mesh->ranges[range].first_index = bucketStart[b] * 3;
+    mesh->ranges[range].index_count = (bucketStart[b + 1] - bucketStart[b]) * 3;
+    mesh->ranges[range].material_index = (int)b - 1;
+    ++range;
+  }
+
+  // Fill in the interleaved vertices.  OBJ puts v = 0 at the bottom of the
+  // image, while the image loaders put the first row at the top.
+  bool missingNormals = false;
+  for (uint32_t v = 0; v < set.count; ++v) {
+    const Corner * corner = &set.corners[v];
+    CJellyFormat3dMeshVertex * vertex = &mesh->vertices[v];
+    const CJellyFormat3dObjVertex * position = &model->vertices[corner->vertex];
+    vertex->position[0] = position->x;
+    vertex->position[1] = position->y;
+    vertex->position[2] = position->z;
+    if (corner->normal >= 0) {
+      const CJellyFormat3dObjNormal * normal = &model->normals[corner->normal];
+      vertex->normal[0] = normal->x;
+      vertex->normal[1] = normal->y;
+      vertex->normal[2] = normal->z;
+    }
+    else {
+      missingNormals = true;
+    }
+    if (corner->texcoord >= 0) {
+      vertex->texcoord[0] = model->texcoords[corner->texcoord].u;
+      vertex->texcoord[1] = 1.0f - model->texcoords[corner->texcoord].v;
+    }
+    else {
+      vertex->texcoord[0] = 0.0f;
+      vertex->texcoord[1] = 0.0f;
+    }
+  }
+  if (missingNormals && !generateNormals(mesh, model, &set, indices)) {
+    goto ERROR_CLEANUP;
+  }
+
+  if ((flags & CJELLY_FORMAT_3D_MESH_OPTIMIZE) && !optimizeMesh(mesh, indices)) {
+    goto ERROR_CLEANUP;
+  }
+
+  for (uint32_t v = 0; v < mesh->vertex_count; ++v) {
+    for (int k = 0; k < 3; ++k) {
+      float p = mesh->vertices[v].position[k];
+      if (v == 0 || p < mesh->bounds_min[k]) mesh->bounds_min[k] = p;
+      if (v == 0 || p > mesh->bounds_max[k]) mesh->bounds_max[k] = p;
+    }
+  }
+
+  // Narrow the indices when every vertex number fits in 16 bits.
+  if (mesh->vertex_count <= 0x10000u && !(flags & CJELLY_FORMAT_3D_MESH_32BIT_INDICES)) {
+    uint16_t * narrow = malloc((indexCount ? indexCount : 1) * sizeof(uint16_t));
+    if (!narrow) { goto ERROR_CLEANUP; }
+    for (uint32_t i = 0; i < indexCount; ++i) {
+      narrow[i] = (uint16_t)indices[i];
+    }
+    free(indices);
+    mesh->indices = narrow;
+    mesh->index_size = sizeof(uint16_t);
+  }
+  else {
+    mesh->indices = indices;
+    mesh->index_size = sizeof(uint32_t);
+  }
+  indices = NULL;
+
+  free(bucketStart);
+  free(bucketFill);
+  free(faceVertices);
+  free(set.slots);
+  free(set.corners);
+  *outMesh = mesh;
+  return CJELLY_FORMAT_3D_MESH_SUCCESS;
+
+  // Error handling.
+ERROR_CLEANUP:
+  // Every failure past validation is an allocation failure.
+  if (err == CJELLY_FORMAT_3D_MESH_SUCCESS) {
+    err = CJELLY_FORMAT_3D_MESH_ERR_OUT_OF_MEMORY;
+  }
+  free(bucketStart);
+  free(bucketFill);
+  free(faceVertices);
+  free(indices);
+  free(set.slots);
+  free(set.corners);
+  cjelly_format_3d_mesh_free(mesh);
+  return err;
+}
+
+
+void cjelly_format_3d_mesh_free(CJellyFormat3dMesh * mesh) {
+  if (!mesh) return;
+  free(mesh->vertices);
+  free(mesh->indices);
+  free(mesh->ranges);
+  free(mesh);
+}
+
+
+const char * cjelly_format_3d_mesh_strerror(CJellyFormat3dMeshError err) {
+  switch (err) {
+    case CJELLY_FORMAT_3D_MESH_SUCCESS:
+      return "No error";
+    case CJELLY_FORMAT_3D_MESH_ERR_OUT_OF_MEMORY:
+      return "Out of memory";
+    case CJELLY_FORMAT_3D_MESH_ERR_INVALID_MODEL:
+      return "Face refers to a missing vertex, texture coordinate or normal";
+    case CJELLY_FORMAT_3D_MESH_ERR_TOO_LARGE:
+      return "Mesh needs more than 2^32 indices";
+    default:
+      return "Unknown error";
+  }
+}
@@ -0,0 +1,561 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <cjelly/format/3d/mesh_cache.h>
+
+
+// The cache stores the in-memory layout, so only little-endian hosts can use
+// it in place.
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define CACHE_SUPPORTED 1
+#else
+#define CACHE_SUPPORTED 0
+#endif
+
+// Every section starts at a multiple of this many bytes from the file start.
+#define SECTION_ALIGN 16
+
+// Marks a key whose source file did not exist when the cache was written.
+#define MISSING_SIZE UINT64_MAX
+
+// Appended to the OBJ path to make the default cache path.
+#define CACHE_EXTENSION ".cjmesh"
+
+
+static const char cacheMagic[8] = {'C', 'J', 'M', 'E', 'S', 'H', '\0', '\0'};
+
+
+/**
+ * @brief What a cached mesh was built from.
+ */
+typedef struct {
+  int64_t mtime;  // Modification time in nanoseconds since the epoch.
+  uint64_t size;  // File size in bytes, or MISSING_SIZE.
+  uint64_t hash;  // Hash of the file contents.
+} SourceKey;
+
+
+/**
+ * @brief The start of a cache file.  All fields are little-endian.
+ */
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t flags;            // Builder flags the mesh was made with.
+  uint32_t vertex_count;
+  uint32_t index_count;
+  uint32_t index_size;
+  uint32_t range_count;
+  uint32_t material_count;
+  uint32_t vertex_size;      // Guards against layout changes without a version bump.
+  float bounds_min[3];
+  float bounds_max[3];
+  uint64_t vertex_offset;
+  uint64_t index_offset;
+  uint64_t range_offset;
+  uint64_t material_offset;
+  uint64_t file_size;
+  SourceKey obj;
+  SourceKey mtl;
+  char mtllib[256];          // The model's material library, relative to the OBJ file.
+} FileHeader;
+
+
+_Static_assert(sizeof(CJellyFormat3dMeshVertex) == 32, "The cached vertex layout changed");
+_Static_assert(sizeof(CJellyFormat3dMeshRange) == 12, "The cached range layout changed");
+_Static_assert(sizeof(CJellyFormat3dMtlMaterial) == 176, "The cached material layout changed");
+_Static_assert(sizeof(FileHeader) == 408, "The cache header layout changed");
+
+
+static uint64_t alignSection(uint64_t offset) {
+  return (offset + SECTION_ALIGN - 1) / SECTION_ALIGN * SECTION_ALIGN;
+}
+
+
+// A fast 64-bit hash that mixes eight bytes per step.  It only has to tell
+// versions of the same file apart, not resist an adversary.
+static uint64_t hashBytes(const unsigned char * data, size_t size) {
+  uint64_t h = 0x9E3779B97F4A7C15ull ^ (uint64_t)size;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t k;
+    memcpy(&k, data + i, 8);
+    k *= 0xFF51AFD7ED558CCDull;
+    k ^= k >> 32;
+    h = (h ^ k) * 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 29;
+  }
+  uint64_t tail = 0;
+  memcpy(&tail, data + i, size - i);
+  h = (h ^ tail) * 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+
+// Reads the time and size of a file; the hash is left for hashSource().
+static bool statSource(const char * path, SourceKey * key) {
+  memset(key, 0, sizeof(SourceKey));
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    key->size = MISSING_SIZE;
+    return false;
+  }
+#ifdef _WIN32
+  key->mtime = (int64_t)st.st_mtime * 1000000000;
+#else
+  key->mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+  key->size = (uint64_t)st.st_size;
+  return true;
+}
+
+
+static bool hashSource(const char * path, SourceKey * key) {
+  CJellyFormatFileMapping mapping;
+  switch (cjelly_format_file_map(path, &mapping)) {
+    case CJELLY_FORMAT_FILE_SUCCESS:
+      key->hash = hashBytes(mapping.data, mapping.size);
+      cjelly_format_file_unmap(&mapping);
+      return true;
+    case CJELLY_FORMAT_FILE_ERR_EMPTY:
+      key->hash = hashBytes(NULL, 0);
+      return true;
+    default:
+      return false;
+  }
+}
+
+
+// Checks a source file against its key in the cache.  The contents are only
+// hashed when the time differs.  `current` receives the file's key as it is now.
+static bool sourceMatches(const char * path, const SourceKey * stored, SourceKey * current) {
+  if (!statSource(path, current)) {
+    return stored->size == MISSING_SIZE;
+  }
+  if (current->size != stored->size) {
+    return false;
+  }
+  if (current->mtime == stored->mtime) {
+    current->hash = stored->hash;
+    return true;
+  }
+  return hashSource(path, current) && current->hash == stored->hash;
+}
+
+
+// Resolves the model's material library relative to the directory of the OBJ file.
+static char * materialLibraryPath(const char * obj_path, const char * mtllib) {
+  size_t directory = 0;
+  bool absolute = mtllib[0] == '/' || mtllib[0] == '\\' || (mtllib[0] && mtllib[1] == ':');
+  if (!absolute) {
+    for (size_t i = 0; obj_path[i]; ++i) {
+      if (obj_path[i] == '/' || obj_path[i] == '\\') directory = i + 1;
+    }
+  }
+  size_t length = strlen(mtllib);
+  char * path = malloc(directory + length + 1);
+  if (!path) return NULL;
+  memcpy(path, obj_path, directory);
+  memcpy(path + directory, mtllib, length + 1);
+  return path;
+}
+
+
+static bool sectionFits(uint64_t offset, uint64_t count, uint64_t element, uint64_t size) {
+  return offset % SECTION_ALIGN == 0 && offset <= size && count * element <= size - offset;
+}
+
+
+// Checks everything a consumer relies on, so a corrupt file cannot make the
+// GPU read out of bounds.
+static bool validateCache(const unsigned char * data, size_t size) {
+  if (size < sizeof(FileHeader)) return false;
+  const FileHeader * h = (const FileHeader *)data;
+  if (memcmp(h->magic, cacheMagic, sizeof(cacheMagic)) != 0
+      || h->version != CJELLY_FORMAT_3D_MESH_CACHE_VERSION
+      || h->vertex_size != sizeof(CJellyFormat3dMeshVertex)
+      || (h->index_size != 2 && h->index_size != 4)
+      || h->file_size != size
+      || !memchr(h->mtllib, '\0', sizeof(h->mtllib))) {
+    return false;
+  }
+  if (!sectionFits(h->vertex_offset, h->vertex_count, sizeof(CJellyFormat3dMeshVertex), size)
+      || !sectionFits(h->index_offset, h->index_count, h->index_size, size)
+      || !sectionFits(h->range_offset, h->range_count, sizeof(CJellyFormat3dMeshRange), size)
+      || !sectionFits(h->material_offset, h->material_count, sizeof(CJellyFormat3dMtlMaterial), size)) {
+    return false;
+  }
+
+  const CJellyFormat3dMeshRange * ranges = (const CJellyFormat3dMeshRange *)(data + h->range_offset);
+  for (uint32_t r = 0; r < h->range_count; ++r) {
+    if (ranges[r].first_index > h->index_count
+        || ranges[r].index_count > h->index_count - ranges[r].first_index
+        || ranges[r].index_count % 3 != 0
+        || ranges[r].material_index < -1
+        || ranges[r].material_index >= (int)h->material_count) {
+      return false;
+    }
+  }
+
+  const CJellyFormat3dMtlMaterial * materials = (const CJellyFormat3dMtlMaterial *)(data + h->material_offset);
+  for (uint32_t m = 0; m < h->material_count; ++m) {
+    if (!memchr(materials[m].name, '\0', sizeof(materials[m].name))) return false;
+  }
+
+  const unsigned char * indices = data + h->index_offset;
+  for (uint32_t i = 0; i < h->index_count; ++i) {
+    uint32_t index;
+    if (h->index_size == 2) {
+      uint16_t narrow;
+      memcpy(&narrow, indices + (size_t)i * 2, 2);
+      index = narrow;
+    }
+    else {
+      memcpy(&index, indices + (size_t)i * 4, 4);
+    }
+    if (index >= h->vertex_count) return false;
+  }
+  return true;
+}
+
+
+static bool writeAll(FILE * fp, const void * data, size_t size) {
+  return size == 0 || fwrite(data, 1, size, fp) == size;
+}
+
+
+static bool writePadding(FILE * fp, uint64_t * position, uint64_t offset) {
+  static const unsigned char zeros[SECTION_ALIGN] = {0};
+  size_t length = (size_t)(offset - *position);
+  *position = offset;
+  return writeAll(fp, zeros, length);
+}
+
+
+// Writes the cache to a temporary file and moves it into place, so readers
+// never see a partial file.
+static CJellyFormat3dMeshCacheError writeCache(const char * cache_path, const CJellyFormat3dMeshAsset * asset,
+    unsigned flags, const SourceKey * obj, const SourceKey * mtl, const char * mtllib) {
+  const CJellyFormat3dMesh * mesh = &asset->mesh;
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+  header.version = CJELLY_FORMAT_3D_MESH_CACHE_VERSION;
+  header.flags = flags;
+  header.vertex_count = mesh->vertex_count;
+  header.index_count = mesh->index_count;
+  header.index_size = mesh->index_size;
+  header.range_count = mesh->range_count;
+  header.material_count = asset->material_count;
+  header.vertex_size = sizeof(CJellyFormat3dMeshVertex);
+  memcpy(header.bounds_min, mesh->bounds_min, sizeof(header.bounds_min));
+  memcpy(header.bounds_max, mesh->bounds_max, sizeof(header.bounds_max));
+  header.vertex_offset = alignSection(sizeof(FileHeader));
+  header.index_offset = alignSection(header.vertex_offset + (uint64_t)mesh->vertex_count * sizeof(CJellyFormat3dMeshVertex));
+  header.range_offset = alignSection(header.index_offset + (uint64_t)mesh->index_count * mesh->index_size);
+  header.material_offset = alignSection(header.range_offset + (uint64_t)mesh->range_count * sizeof(CJellyFormat3dMeshRange));
+  header.file_size = header.material_offset + (uint64_t)asset->material_count * sizeof(CJellyFormat3dMtlMaterial);
+  header.obj = *obj;
+  header.mtl = *mtl;
+  snprintf(header.mtllib, sizeof(header.mtllib), "%s", mtllib);
+
+  size_t length = strlen(cache_path);
+  char * temp_path = malloc(length + 5);
+  if (!temp_path) {
+    return CJELLY_FORMAT_3D_MESH_CACHE_ERR_OUT_OF_MEMORY;
+  }
+  memcpy(temp_path, cache_path, length);
+  memcpy(temp_path + length, ".tmp", 5);
+
+  FILE * fp = fopen(temp_path, "wb");
+  if (!fp) {
+    free(temp_path);
+    return CJELLY_FORMAT_3D_MESH_CACHE_ERR_IO;
+  }
+  uint64_t position = sizeof(FileHeader);
+  bool ok = writeAll(fp, &header, sizeof(header))
+    && writePadding(fp, &position, header.vertex_offset)
+    && writeAll(fp, mesh->vertices, (size_t)mesh->vertex_count * sizeof(CJellyFormat3dMeshVertex))
+    && (position += (uint64_t)mesh->vertex_count * sizeof(CJellyFormat3dMeshVertex), writePadding(fp, &position, header.index_offset))
+    && writeAll(fp, mesh->indices, (size_t)mesh->index_count * mesh->index_size)
+    && (position += (uint64_t)mesh->index_count * mesh->index_size, writePadding(fp, &position, header.range_offset))
+    && writeAll(fp, mesh->ranges, (size_t)mesh->range_count * sizeof(CJellyFormat3dMeshRange))
+    && (position += (uint64_t)mesh->range_count * sizeof(CJellyFormat3dMeshRange), writePadding(fp, &position, header.material_offset))
+    && writeAll(fp, asset->materials, (size_t)asset->material_count * sizeof(CJellyFormat3dMtlMaterial));
+  ok = fclose(fp) == 0 && ok;
+
+#ifdef _WIN32
+  ok = ok && MoveFileExA(temp_path, cache_path, MOVEFILE_REPLACE_EXISTING);
+#else
+  ok = ok && rename(temp_path, cache_path) == 0;
+#endif
+  if (!ok) {
+    remove(temp_path);
+  }
+  free(temp_path);
+  return ok ? CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS : CJELLY_FORMAT_3D_MESH_CACHE_ERR_IO;
+}
+
+
+// Stores new source times in a cache whose sources were touched but not
+// changed, so the next load skips hashing them.  Failure only costs a hash.
+static void refreshKeys(const char * cache_path, const SourceKey * obj, const SourceKey * mtl) {
+  FILE * fp = fopen(cache_path, "r+b");
+  if (!fp) return;
+  if (fseek(fp, (long)offsetof(FileHeader, obj), SEEK_SET) == 0) {
+    if (writeAll(fp, obj, sizeof(SourceKey))) {
+      writeAll(fp, mtl, sizeof(SourceKey));
+    }
+  }
+  fclose(fp);
+}
+
+
+// Parses the OBJ file and its material library and builds the mesh.
+static CJellyFormat3dMeshCacheError buildAsset(const char * obj_path, unsigned flags,
+    CJellyFormat3dMeshAsset * * outAsset, char * mtllib, size_t mtllib_size) {
+  CJellyFormat3dObjModel * model = NULL;
+  CJellyFormat3dObjError objErr = cjelly_format_3d_obj_load(obj_path, &model);
+  if (objErr != CJELLY_FORMAT_3D_OBJ_SUCCESS) {
+    fprintf(stderr, "Cannot load %s: %s\n", obj_path, cjelly_format_3d_obj_strerror(objErr));
+    return objErr == CJELLY_FORMAT_3D_OBJ_ERR_FILE_NOT_FOUND
+      ? CJELLY_FORMAT_3D_MESH_CACHE_ERR_FILE_NOT_FOUND
+      : CJELLY_FORMAT_3D_MESH_CACHE_ERR_SOURCE;
+  }
+
+  CJellyFormat3dMeshCacheError err = CJELLY_FORMAT_3D_MESH_CACHE_ERR_OUT_OF_MEMORY;
+  CJellyFormat3dMesh * mesh = NULL;
+  CJellyFormat3dMeshAsset * asset = calloc(1, sizeof(CJellyFormat3dMeshAsset));
+  uint32_t material_count = (uint32_t)model->material_mapping_count;
+  CJellyFormat3dMtlMaterial * materials = calloc(material_count ? material_count : 1, sizeof(CJellyFormat3dMtlMaterial));
+  if (!asset || !materials) { goto ERROR_CLEANUP; }
+
+  CJellyFormat3dMeshError meshErr = cjelly_format_3d_mesh_from_obj(model, flags, &mesh);
+  if (meshErr != CJELLY_FORMAT_3D_MESH_SUCCESS) {
+    fprintf(stderr, "Cannot build %s: %s\n", obj_path, cjelly_format_3d_mesh_strerror(meshErr));
+    if (meshErr != CJELLY_FORMAT_3D_MESH_ERR_OUT_OF_MEMORY) {
+      err = CJELLY_FORMAT_3D_MESH_CACHE_ERR_SOURCE;
+    }
+    goto ERROR_CLEANUP;
+  }
+
+  // Start every material as the white default, then take what the library defines.
+  for (uint32_t m = 0; m < material_count; ++m) {
+    const CJellyFormat3dObjMaterialMapping * mapping = &model->material_mappings[m];
+    CJellyFormat3dMtlMaterial * material = &materials[mapping->index];
+    strcpy(material->name, mapping->name);
+    material->Kd[0] = material->Kd[1] = material->Kd[2] = 1.0f;
+    material->d = 1.0f;
+    material->illum = 1;
+  }
+  snprintf(mtllib, mtllib_size, "%s", model->mtllib);
+  if (mtllib[0]) {
+    char * mtl_path = materialLibraryPath(obj_path, mtllib);
+    if (!mtl_path) { goto ERROR_CLEANUP; }
+    CJellyFormat3dMtl library;
+    if (cjelly_format_3d_mtl_load(mtl_path, &library) == CJELLY_FORMAT_3D_MTL_SUCCESS) {
+      for (uint32_t m = 0; m < material_count; ++m) {
+        for (int l = 0; l < library.material_count; ++l) {
+          if (strcmp(materials[m].name, library.materials[l].name) == 0) {
+            materials[m] = library.materials[l];
+            break;
+          }
+        }
+      }
+      cjelly_format_3d_mtl_free(&library);
+    }
+    free(mtl_path);
+  }
+
+  asset->mesh = *mesh;
+  asset->built_mesh = mesh;
+  asset->materials = materials;
+  asset->built_materials = materials;
+  asset->material_count = material_count;
+  cjelly_format_3d_obj_free(model);
+  *outAsset = asset;
+  return CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS;
+
+  // Error handling.
+ERROR_CLEANUP:
+  cjelly_format_3d_mesh_free(mesh);
+  free(materials);
+  free(asset);
+  cjelly_format_3d_obj_free(model);
+  return err;
+}
+
+
+CJellyFormat3dMeshCacheError cjelly_format_3d_mesh_cache_open(const char * cache_path,
+    CJellyFormat3dMeshAsset * * outAsset) {
+  if (!cache_path || !outAsset) {
+    return CJELLY_FORMAT_3D_MESH_CACHE_ERR_INVALID_FORMAT;
+  }
+  if (!CACHE_SUPPORTED) {
+    return CJELLY_FORMAT_3D_MESH_CACHE_ERR_UNSUPPORTED;
+  }
+
+  CJellyFormat3dMeshAsset * asset = calloc(1, sizeof(CJellyFormat3dMeshAsset));
+  if (!asset) {
+    return CJELLY_FORMAT_3D_MESH_CACHE_ERR_OUT_OF_MEMORY;
+  }
+  switch (cjelly_format_file_map(cache_path, &asset->mapping)) {
+    case CJELLY_FORMAT_FILE_SUCCESS:
+      break;
+    case CJELLY_FORMAT_FILE_ERR_NOT_FOUND:
+      free(asset);
+      return CJELLY_FORMAT_3D_MESH_CACHE_ERR_FILE_NOT_FOUND;
+    case CJELLY_FORMAT_FILE_ERR_EMPTY:
+      free(asset);
+      return CJELLY_FORMAT_3D_MESH_CACHE_ERR_INVALID_FORMAT;
+    default:
+      free(asset);
+      return CJELLY_FORMAT_3D_MESH_CACHE_ERR_IO;
+  }
+
+  const unsigned char * data = asset->mapping.data;
+  if (!validateCache(data, asset->mapping.size)) {
+    cjelly_format_3d_mesh_asset_free(asset);
+    return CJELLY_FORMAT_3D_MESH_CACHE_ERR_INVALID_FORMAT;
+  }
+
+  // Point the mesh into the mapping.  The mapping is page aligned and every
+  // section is 16-byte aligned within it.
+  const FileHeader * h = (const FileHeader *)data;
+  CJellyFormat3dMesh * mesh = &asset->mesh;
+  mesh->vertices = (CJellyFormat3dMeshVertex *)(data + h->vertex_offset);
+  mesh->vertex_count = h->vertex_count;
+  mesh->indices = (void *)(data + h->index_offset);
+  mesh->index_count = h->index_count;
+  mesh->index_size = h->index_size;
+  mesh->ranges = (CJellyFormat3dMeshRange *)(data + h->range_offset);
+  mesh->range_count = h->range_count;
+  memcpy(mesh->bounds_min, h->bounds_min, sizeof(mesh->bounds_min));
+  memcpy(mesh->bounds_max, h->bounds_max, sizeof(mesh->bounds_max));
+  asset->materials = (const CJellyFormat3dMtlMaterial *)(data + h->material_offset);
+  asset->material_count = h->material_count;
+  asset->from_cache = true;
+  *outAsset = asset;
+  return CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS;
+}
+
+
+CJellyFormat3dMeshCacheError cjelly_format_3d_mesh_cache_load(const char * obj_path,
+    const char * cache_path, unsigned flags, CJellyFormat3dMeshAsset * * outAsset) {
+  if (!obj_path || !outAsset) {
+    return CJELLY_FORMAT_3D_MESH_CACHE_ERR_INVALID_FORMAT;
+  }
+
+  char * default_path = NULL;
+  if (!cache_path) {
+    size_t length = strlen(obj_path);
+    default_path = malloc(length + sizeof(CACHE_EXTENSION));
+    if (!default_path) {
+      return CJELLY_FORMAT_3D_MESH_CACHE_ERR_OUT_OF_MEMORY;
+    }
+    memcpy(default_path, obj_path, length);
+    memcpy(default_path + length, CACHE_EXTENSION, sizeof(CACHE_EXTENSION));
+    cache_path = default_path;
+  }
+
+  // Use the cache if it was built with the same flags from the same sources.
+  CJellyFormat3dMeshAsset * asset = NULL;
+  if (cjelly_format_3d_mesh_cache_open(cache_path, &asset) == CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS) {
+    const FileHeader * h = (const FileHeader *)asset->mapping.data;
+    SourceKey obj, mtl = h->mtl;
+    bool fresh = h->flags == flags && sourceMatches(obj_path, &h->obj, &obj);
+    if (fresh && h->mtllib[0]) {
+      char * mtl_path = materialLibraryPath(obj_path, h->mtllib);
+      fresh = mtl_path && sourceMatches(mtl_path, &h->mtl, &mtl);
+      free(mtl_path);
+    }
+    if (fresh) {
+      if (obj.mtime != h->obj.mtime || mtl.mtime != h->mtl.mtime) {
+        refreshKeys(cache_path, &obj, &mtl);
+      }
+      free(default_path);
+      *outAsset = asset;
+      return CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS;
+    }
+    cjelly_format_3d_mesh_asset_free(asset);
+    asset = NULL;
+  }
+
+  // Key the sources before parsing them, so a file that changes while it is
+  // parsed leaves a cache that is rebuilt next time rather than one that
+  // claims the new contents.
+  SourceKey obj, mtl;
+  if (!statSource(obj_path, &obj) || !hashSource(obj_path, &obj)) {
+    fprintf(stderr, "Cannot open file %s\n", obj_path);
+    free(default_path);
+    return CJELLY_FORMAT_3D_MESH_CACHE_ERR_FILE_NOT_FOUND;
+  }
+  char mtllib[sizeof(((FileHeader *)0)->mtllib)];
+  CJellyFormat3dMeshCacheError err = buildAsset(obj_path, flags, &asset, mtllib, sizeof(mtllib));
+  if (err != CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS) {
+    free(default_path);
+    return err;
+  }
+  memset(&mtl, 0, sizeof(mtl));
+  if (mtllib[0]) {
+    char * mtl_path = materialLibraryPath(obj_path, mtllib);
+    if (mtl_path && statSource(mtl_path, &mtl) && !hashSource(mtl_path, &mtl)) {
+      mtl.size = MISSING_SIZE;
+    }
+    free(mtl_path);
+  }
+
+  if (CACHE_SUPPORTED) {
+    writeCache(cache_path, asset, flags, &obj, &mtl, mtllib);
+  }
+  free(default_path);
+  *outAsset = asset;
+  return CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS;
+}
+
+
+void cjelly_format_3d_mesh_asset_free(CJellyFormat3dMeshAsset * asset) {
+  if (!asset) return;
+  cjelly_format_3d_mesh_free(asset->built_mesh);
+  free(asset->built_materials);
+  cjelly_format_file_unmap(&asset->mapping);
+  free(asset);
+}
+
+
+const char * cjelly_format_3d_mesh_cache_strerror(CJellyFormat3dMeshCacheError err) {
+  switch (err) {
+    case CJELLY_FORMAT_3D_MESH_CACHE_SUCCESS:
+      return "No error";
+    case CJELLY_FORMAT_3D_MESH_CACHE_ERR_FILE_NOT_FOUND:
+      return "File not found";
+    case CJELLY_FORMAT_3D_MESH_CACHE_ERR_OUT_OF_MEMORY:
+      return "Out of memory";
+    case CJELLY_FORMAT_3D_MESH_CACHE_ERR_INVALID_FORMAT:
+      return "Invalid or corrupt mesh cache file";
+    case CJELLY_FORMAT_3D_MESH_CACHE_ERR_SOURCE:
+      return "Cannot build a mesh from the OBJ file";
+    case CJELLY_FORMAT_3D_MESH_CACHE_ERR_IO:
+      return "I/O error when reading/writing the mesh cache";
+    case CJELLY_FORMAT_3D_MESH_CACHE_ERR_UNSUPPORTED:
+      return "Mesh cache is not supported on big-endian hosts";
+    default:
+      return "Unknown error";
+  }
+}
@@ -1,9 +1,13 @@
-#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <cjelly/format/file.h>
 #include <cjelly/format/3d/obj.h>
+#include <cjelly/worker_pool_internal.h>
 
 
 // Reference documents:
@@ -12,272 +16,704 @@
 // https://paulbourke.net/dataformats/obj/obj_spec.pdf
 
 
-#define LINE_SIZE 256
+// Files smaller than this are parsed on the calling thread; starting worker
+// threads costs more than it saves.
+#define PARALLEL_THRESHOLD ((size_t)4 << 20)
+
+// Smallest slice of a file handed to one work item.
+#define MIN_CHUNK_SIZE ((size_t)1 << 20)
+
+// Upper bound on the number of slices a file is split into.
+#define MAX_CHUNKS 64
+
+
+/**
+ * @brief The kinds of line the loader understands.
+ */
+typedef enum {
+  LINE_OTHER,
+  LINE_VERTEX,
+  LINE_TEXCOORD,
+  LINE_NORMAL,
+  LINE_FACE,
+  LINE_GROUP,
+  LINE_USEMTL,
+  LINE_MTLLIB,
+} LineType;
+
+
+/**
+ * @brief Number of elements of each kind, or the index of the first one.
+ */
+typedef struct {
+  int vertices;
+  int texcoords;
+  int normals;
+  int faces;
+  int groups;
+} ElementCounts;
+
+
+/**
+ * @brief A "usemtl" directive seen while parsing a chunk.
+ */
+typedef struct {
+  char name[CJELLY_FORMAT_3D_OBJ_MAX_NAME_LENGTH];
+  int index;   // Model-wide material index, assigned when the chunk is merged.
+} MaterialUse;
+
+
+/**
+ * @brief A newline-aligned slice of the file and the results of parsing it.
+ *
+ * Every chunk is counted first, so the model arrays can be allocated once
+ * and each chunk knows where its elements go.  The chunks are then parsed
+ * independently.  State that crosses chunk boundaries (the active material
+ * and the active group) is resolved afterwards, in file order.
+ */
+typedef struct {
+  const char * begin;
+  const char * end;
+  ElementCounts count;   // Elements found in this chunk.
+  ElementCounts base;    // Index of the chunk's first element in the model arrays.
+
+  // The "usemtl" directives in this chunk, in order.  Faces store an index
+  // into this list until the chunk is merged, or -1 for faces that use the
+  // material active at the end of the previous chunk.
+  MaterialUse * materials;
+  int material_count;
+  int material_capacity;
+
+  // The last "mtllib" name in this chunk, pointing into the mapping.
+  const char * mtllib;
+  size_t mtllib_length;
+
+  CJellyFormat3dObjError err;
+} Chunk;
+
+
+/**
+ * @brief Shared state for the work items of one load.
+ */
+typedef struct {
+  Chunk * chunks;
+  CJellyFormat3dObjModel * model;
+} ParseJob;
+
+
+static bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
 
 
-CJellyFormat3dObjError cjelly_format_3d_obj_load(const char * filename, CJellyFormat3dObjModel * * outModel) {
-  CJellyFormat3dObjError err = CJELLY_FORMAT_3D_OBJ_SUCCESS;
+static bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
 
-  // Check for invalid input.
-  if (!filename || !outModel) {
-    return CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
-  }
 
-  // Open the file for reading.
-  FILE* fp = fopen(filename, "r");
-  if (!fp) {
-    fprintf(stderr, "Cannot open file %s\n", filename);
-    return CJELLY_FORMAT_3D_OBJ_ERR_FILE_NOT_FOUND;
+static void skipSpace(const char * * cursor, const char * end) {
+  const char * p = *cursor;
+  while (p < end && isSpace(*p)) {
+    ++p;
   }
+  *cursor = p;
+}
 
-  // Allocate memory for the model structure.
-  CJellyFormat3dObjModel * model = (CJellyFormat3dObjModel *)malloc(sizeof(CJellyFormat3dObjModel));
-  if (!model) { goto ERROR_CLEANUP; }
 
-  // Initialize all counts and capacities, and preallocate memory.
-  model->vertex_count = 0;
-  model->vertex_capacity = 128;
-  model->vertices = (CJellyFormat3dObjVertex *)malloc(model->vertex_capacity * sizeof(CJellyFormat3dObjVertex));
-  if (!model->vertices) { goto ERROR_CLEANUP; }
+static const char * lineEnd(const char * line, const char * end) {
+  const char * eol = memchr(line, '\n', (size_t)(end - line));
+  return eol ? eol : end;
+}
 
-  model->texcoord_count = 0;
-  model->texcoord_capacity = 128;
-  model->texcoords = (CJellyFormat3dObjTexCoord *)malloc(model->texcoord_capacity * sizeof(CJellyFormat3dObjTexCoord));
-  if (!model->texcoords) { goto ERROR_CLEANUP; }
 
-  model->normal_count = 0;
-  model->normal_capacity = 128;
-  model->normals = (CJellyFormat3dObjNormal *)malloc(model->normal_capacity * sizeof(CJellyFormat3dObjNormal));
-  if (!model->normals) { goto ERROR_CLEANUP; }
+// Reads the keyword at the start of a line and leaves the cursor after it.
+static LineType classifyLine(const char * * cursor, const char * eol) {
+  skipSpace(cursor, eol);
+  const char * keyword = *cursor;
+  const char * p = keyword;
+  while (p < eol && !isSpace(*p)) {
+    ++p;
+  }
+  *cursor = p;
+
+  size_t length = (size_t)(p - keyword);
+  switch (length) {
+    case 1:
+      switch (keyword[0]) {
+        case 'v': return LINE_VERTEX;
+        case 'f': return LINE_FACE;
+        case 'g':
+        case 'o': return LINE_GROUP;
+        default: return LINE_OTHER;
+      }
+    case 2:
+      if (keyword[0] != 'v') return LINE_OTHER;
+      if (keyword[1] == 't') return LINE_TEXCOORD;
+      if (keyword[1] == 'n') return LINE_NORMAL;
+      return LINE_OTHER;
+    case 6:
+      if (memcmp(keyword, "usemtl", 6) == 0) return LINE_USEMTL;
+      if (memcmp(keyword, "mtllib", 6) == 0) return LINE_MTLLIB;
+      return LINE_OTHER;
+    default:
+      return LINE_OTHER;
+  }
+}
 
-  model->face_count = 0;
-  model->face_capacity = 128;
-  model->faces = (CJellyFormat3dObjFace *)malloc(model->face_capacity * sizeof(CJellyFormat3dObjFace));
-  if (!model->faces) { goto ERROR_CLEANUP; }
 
-  model->group_count = 0;
-  model->group_capacity = 16;
-  model->groups = (CJellyFormat3dObjGroup *)malloc(model->group_capacity * sizeof(CJellyFormat3dObjGroup));
-  if (!model->groups) { goto ERROR_CLEANUP; }
+// Exact powers of ten; every one of them is representable in a double.
+static const double powersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
 
-  model->material_mapping_count = 0;
-  model->material_mapping_capacity = 4;
-  model->material_mappings = (CJellyFormat3dObjMaterialMapping *)malloc(model->material_mapping_capacity * sizeof(CJellyFormat3dObjMaterialMapping));
-  if (!model->material_mappings) { goto ERROR_CLEANUP; }
 
-  // Initialize the material library name.
-  model->mtllib[0] = '\0';
-
-  int current_group = -1;            // Index of the current active group
-  int current_material_index = -1;   // Current material index (updated by "usemtl" directive)
-
-  // Begin parsing the file line by line.
-  char line[LINE_SIZE];
-  while (fgets(line, LINE_SIZE, fp)) {
-    // Remove newline characters.
-    line[strcspn(line, "\r\n")] = 0;
-
-    if (strncmp(line, "v ", 2) == 0) {
-      // Read a vertex line.
-      CJellyFormat3dObjVertex v;
-      if (sscanf(line + 2, "%f %f %f", &v.x, &v.y, &v.z) == 3) {
-        if (model->vertex_count >= model->vertex_capacity) {
-          model->vertex_capacity *= 2;
-          CJellyFormat3dObjVertex* temp = realloc(model->vertices, model->vertex_capacity * sizeof(CJellyFormat3dObjVertex));
-          if (!temp) { goto ERROR_CLEANUP; }
-          model->vertices = temp;
-        }
-        model->vertices[model->vertex_count++] = v;
-      }
-      else {
-        err = CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
-        goto ERROR_CLEANUP;
+// Parses a decimal floating point number, with optional sign, fraction and
+// exponent, after skipping leading whitespace.  Up to 19 significant digits
+// are accumulated exactly in an integer and scaled once, which is accurate
+// to the last bit of a float for anything an OBJ exporter writes.
+static bool parseFloat(const char * * cursor, const char * end, float * out) {
+  skipSpace(cursor, end);
+  const char * p = *cursor;
+
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  int significant = 0;
+  int exponent = 0;
+  bool anyDigits = false;
+  for (; p < end && isDigit(*p); ++p) {
+    anyDigits = true;
+    if (significant < 19) {
+      mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+      if (mantissa) ++significant;
+    }
+    else {
+      ++exponent;
+    }
+  }
+  if (p < end && *p == '.') {
+    ++p;
+    for (; p < end && isDigit(*p); ++p) {
+      anyDigits = true;
+      if (significant < 19) {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        if (mantissa) ++significant;
+        --exponent;
       }
     }
-    else if (strncmp(line, "vt ", 3) == 0) {
-      // Read a texture coordinate line.
-      CJellyFormat3dObjTexCoord vt;
-      if (sscanf(line + 3, "%f %f", &vt.u, &vt.v) == 2) {
-        if (model->texcoord_count >= model->texcoord_capacity) {
-          model->texcoord_capacity *= 2;
-          CJellyFormat3dObjTexCoord* temp = realloc(model->texcoords, model->texcoord_capacity * sizeof(CJellyFormat3dObjTexCoord));
-          if (!temp) { goto ERROR_CLEANUP; }
-          model->texcoords = temp;
+  }
+  if (!anyDigits) {
+    return false;
+  }
+
+  // The exponent is only consumed if it has digits, as strtof would.
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char * e = p + 1;
+    bool negativeExponent = false;
+    if (e < end && (*e == '-' || *e == '+')) {
+      negativeExponent = *e == '-';
+      ++e;
+    }
+    if (e < end && isDigit(*e)) {
+      int value = 0;
+      for (; e < end && isDigit(*e); ++e) {
+        if (value < 10000) {
+          value = value * 10 + (*e - '0');
         }
-        model->texcoords[model->texcoord_count++] = vt;
-      }
-      else {
-        err = CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
-        goto ERROR_CLEANUP;
       }
+      exponent += negativeExponent ? -value : value;
+      p = e;
     }
-    else if (strncmp(line, "vn ", 3) == 0) {
-      // Read a normal line.
-      CJellyFormat3dObjNormal vn;
-      if (sscanf(line + 3, "%f %f %f", &vn.x, &vn.y, &vn.z) == 3) {
-        if (model->normal_count >= model->normal_capacity) {
-          model->normal_capacity *= 2;
-          CJellyFormat3dObjNormal* temp = realloc(model->normals, model->normal_capacity * sizeof(CJellyFormat3dObjNormal));
-          if (!temp) { goto ERROR_CLEANUP; }
-          model->normals = temp;
-        }
-        model->normals[model->normal_count++] = vn;
+  }
+
+  double value = (double)mantissa;
+  if (value != 0) {
+    for (; exponent > 22 && value < 1e300; exponent -= 22) {
+      value *= 1e22;
+    }
+    for (; exponent < -22 && value > 1e-300; exponent += 22) {
+      value /= 1e22;
+    }
+    if (exponent > 22) {
+      exponent = 22;
+    }
+    if (exponent < -22) {
+      exponent = -22;
+    }
+    value = exponent < 0 ? value / powersOfTen[-exponent] : value * powersOfTen[exponent];
+  }
+
+  *out = (float)(negative ? -value : value);
+  *cursor = p;
+  return true;
+}
+
+
+// Parses a decimal integer with an optional sign.
+static bool parseInt(const char * * cursor, const char * end, int * out) {
+  const char * p = *cursor;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  if (p >= end || !isDigit(*p)) {
+    return false;
+  }
+  long long value = 0;
+  for (; p < end && isDigit(*p); ++p) {
+    value = value * 10 + (*p - '0');
+    if (value > INT_MAX) {
+      return false;
+    }
+  }
+  *out = (int)(negative ? -value : value);
+  *cursor = p;
+  return true;
+}
+
+
+// Reads the next whitespace-delimited word, truncated to fit the buffer.
+static bool parseName(const char * * cursor, const char * end, char * name, size_t capacity) {
+  skipSpace(cursor, end);
+  const char * start = *cursor;
+  const char * p = start;
+  while (p < end && !isSpace(*p)) {
+    ++p;
+  }
+  if (p == start) {
+    return false;
+  }
+  size_t length = (size_t)(p - start);
+  if (length > capacity - 1) {
+    length = capacity - 1;
+  }
+  memcpy(name, start, length);
+  name[length] = '\0';
+  *cursor = p;
+  return true;
+}
+
+
+// Converts a 1-based or negative (relative) OBJ index to a 0-based index.
+// `available` is the number of elements of that kind read before the face.
+static bool resolveIndex(int index, int available, int * out) {
+  if (index > 0) {
+    *out = index - 1;
+    return true;
+  }
+  if (index < 0 && -index <= available) {
+    *out = available + index;
+    return true;
+  }
+  return false;
+}
+
+
+// Parses the corners of a face into a zeroed slot of the model's face array.
+static CJellyFormat3dObjError parseFace(const char * * cursor, const char * eol,
+    CJellyFormat3dObjFace * face, const ElementCounts * available) {
+  int extra_capacity = 0;
+  face->count = 0;
+  face->overflow = NULL;
+
+  while (true) {
+    skipSpace(cursor, eol);
+    if (*cursor >= eol) break;
+
+    // Accepted forms: v, v/vt, v/vt/vn and v//vn.
+    int v, vt = 0, vn = 0;
+    if (!parseInt(cursor, eol, &v)) {
+      return CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
+    }
+    if (*cursor < eol && **cursor == '/') {
+      ++*cursor;
+      if (*cursor < eol && **cursor != '/' && !parseInt(cursor, eol, &vt)) {
+        return CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
       }
-      else {
-        err = CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
-        goto ERROR_CLEANUP;
+      if (*cursor < eol && **cursor == '/') {
+        ++*cursor;
+        if (!parseInt(cursor, eol, &vn)) {
+          return CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
+        }
       }
     }
-    else if (strncmp(line, "f ", 2) == 0) {
-      // Read a face line.
-      CJellyFormat3dObjFace face;
-      face.count = 0;
-      face.material_index = current_material_index;
-      face.overflow = NULL; // Initialize overflow to NULL.
-      int extra_count = 0;  // Number of vertices stored in overflow.
-      int extra_capacity = 0; // Capacity for overflow array.
-
-      // Tokenize the line after "f ".
-      char * token = strtok(line + 2, " ");
-      while (token != NULL) {
-        int vIndex = 0, vtIndex = 0, vnIndex = 0;
-        if (strchr(token, '/')) {
-          /* Replace '/' with space for easier parsing */
-          char temp[64];
-          strncpy(temp, token, 63);
-          temp[63] = '\0';
-          for (int i = 0; i < (int)strlen(temp); i++) {
-            if (temp[i] == '/')
-              temp[i] = ' ';
-          }
-          // Parse the indices (some may be missing).
-          int parsed = sscanf(temp, "%d %d %d", &vIndex, &vtIndex, &vnIndex);
-          if (parsed < 3)
-            vtIndex = 0; // If texture coordinate is missing, set to 0 (or use -1).
-        }
-        else {
-          vIndex = atoi(token);
-        }
+    if (*cursor < eol && !isSpace(**cursor)) {
+      return CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
+    }
 
-        // For the first four vertices, store in fixed arrays.
-        if (face.count < 4) {
-          face.vertex[face.count] = vIndex - 1;
-          face.texcoord[face.count] = vtIndex ? (vtIndex - 1) : -1;
-          face.normal[face.count] = vnIndex ? (vnIndex - 1) : -1;
-          face.count++;
-        }
-        else {
-          // For extra vertices, allocate or grow the overflow array.
-          if (face.overflow == NULL) {
-            extra_capacity = 4;
-            face.overflow = (CJellyFormat3dObjFaceOverflow *)malloc(extra_capacity * sizeof(CJellyFormat3dObjFaceOverflow));
-            if (!face.overflow) { goto ERROR_CLEANUP; }
-            extra_count = 0;
-          }
-          if (extra_count >= extra_capacity) {
-            extra_capacity *= 2;
-            CJellyFormat3dObjFaceOverflow * tmp = realloc(face.overflow, extra_capacity * sizeof(CJellyFormat3dObjFaceOverflow));
-            if (!tmp) { goto ERROR_CLEANUP; }
-            face.overflow = tmp;
-          }
-          face.overflow[extra_count].vertex = vIndex - 1;
-          face.overflow[extra_count].texcoord = vtIndex ? (vtIndex - 1) : -1;
-          face.overflow[extra_count].normal = vnIndex ? (vnIndex - 1) : -1;
-          extra_count++;
-          face.count++; // Increase total vertex count.
+    // Missing texture coordinates and normals are stored as -1.
+    int vertex, texcoord = -1, normal = -1;
+    if (!resolveIndex(v, available->vertices, &vertex)
+        || (vt && !resolveIndex(vt, available->texcoords, &texcoord))
+        || (vn && !resolveIndex(vn, available->normals, &normal))) {
+      return CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
+    }
+
+    // The first four corners are stored inline; the rest go to the overflow.
+    if (face->count < 4) {
+      face->vertex[face->count] = vertex;
+      face->texcoord[face->count] = texcoord;
+      face->normal[face->count] = normal;
+    }
+    else {
+      int extra = face->count - 4;
+      if (extra >= extra_capacity) {
+        extra_capacity = extra_capacity ? extra_capacity * 2 : 4;
+        CJellyFormat3dObjFaceOverflow * temp = realloc(face->overflow, extra_capacity * sizeof(CJellyFormat3dObjFaceOverflow));
+        if (!temp) {
+          return CJELLY_FORMAT_3D_OBJ_ERR_OUT_OF_MEMORY;
         }
-        token = strtok(NULL, " ");
+        face->overflow = temp;
       }
-      // Append the face to the model's face array.
-      if (model->face_count >= model->face_capacity) {
-        model->face_capacity *= 2;
-        CJellyFormat3dObjFace * temp = realloc(model->faces, model->face_capacity * sizeof(CJellyFormat3dObjFace));
-        if (!temp) {
-          // Free the overflow array if it was allocated.
-          // The code pattern is different for this case because the operation
-          // to add the face to the faces array failed.  Therefore, it will
-          // not be automatically freed when the model itself is freed.
-          if (face.overflow) free(face.overflow);
-          goto ERROR_CLEANUP;
+      face->overflow[extra].vertex = vertex;
+      face->overflow[extra].texcoord = texcoord;
+      face->overflow[extra].normal = normal;
+    }
+    face->count++;
+  }
+  return CJELLY_FORMAT_3D_OBJ_SUCCESS;
+}
+
+
+// First pass: count the elements in a chunk so the arrays can be sized.
+static void countChunk(void * user, uint32_t index) {
+  Chunk * chunk = &((ParseJob *)user)->chunks[index];
+  ElementCounts count = {0};
+  size_t total = 0;
+
+  for (const char * line = chunk->begin; line < chunk->end;) {
+    const char * eol = lineEnd(line, chunk->end);
+    switch (classifyLine(&line, eol)) {
+      case LINE_VERTEX: count.vertices++; ++total; break;
+      case LINE_TEXCOORD: count.texcoords++; ++total; break;
+      case LINE_NORMAL: count.normals++; ++total; break;
+      case LINE_FACE: count.faces++; ++total; break;
+      case LINE_GROUP:
+        // A "g" without a name keeps the current group.
+        skipSpace(&line, eol);
+        if (line < eol) {
+          count.groups++;
+          ++total;
         }
-        model->faces = temp;
+        break;
+      default: break;
+    }
+    // Guard the int counts of the model against absurdly large files.
+    if (total > INT_MAX) {
+      chunk->err = CJELLY_FORMAT_3D_OBJ_ERR_OUT_OF_MEMORY;
+      return;
+    }
+    line = eol + 1;
+  }
+  chunk->count = count;
+}
+
+
+// Second pass: parse a chunk straight into its slice of the model arrays.
+static void parseChunk(void * user, uint32_t index) {
+  ParseJob * job = (ParseJob *)user;
+  Chunk * chunk = &job->chunks[index];
+  CJellyFormat3dObjModel * model = job->model;
+  ElementCounts local = {0};
+  int current_material = -1;
+
+  for (const char * line = chunk->begin; line < chunk->end;) {
+    const char * eol = lineEnd(line, chunk->end);
+    const char * p = line;
+    bool ok = true;
+
+    switch (classifyLine(&p, eol)) {
+      case LINE_VERTEX: {
+        CJellyFormat3dObjVertex * v = &model->vertices[chunk->base.vertices + local.vertices++];
+        ok = parseFloat(&p, eol, &v->x) && parseFloat(&p, eol, &v->y) && parseFloat(&p, eol, &v->z);
+        break;
       }
-      model->faces[model->face_count++] = face;
-      if (current_group >= 0) {
-        model->groups[current_group].face_count++;
+      case LINE_TEXCOORD: {
+        CJellyFormat3dObjTexCoord * vt = &model->texcoords[chunk->base.texcoords + local.texcoords++];
+        ok = parseFloat(&p, eol, &vt->u) && parseFloat(&p, eol, &vt->v);
+        break;
       }
-    }
-    else if (strncmp(line, "g ", 2) == 0 || strncmp(line, "o ", 2) == 0) {
-      // Read a group or object name line.
-      char name[CJELLY_FORMAT_3D_OBJ_MAX_NAME_LENGTH];
-      // 128 is hard-coded because "%127s" is used in the sscanf call.
-      // The assert is used to ensure that the buffer cannot be smaller
-      // than this hard-coded value.
-      assert(sizeof(name) >= 128);
-      if (sscanf(line + 2, "%127s", name) == 1) {
-        if (model->group_count >= model->group_capacity) {
-          model->group_capacity *= 2;
-          CJellyFormat3dObjGroup* temp = realloc(model->groups, model->group_capacity * sizeof(CJellyFormat3dObjGroup));
-          if (!temp) { goto ERROR_CLEANUP; }
-          model->groups = temp;
+      case LINE_NORMAL: {
+        CJellyFormat3dObjNormal * vn = &model->normals[chunk->base.normals + local.normals++];
+        ok = parseFloat(&p, eol, &vn->x) && parseFloat(&p, eol, &vn->y) && parseFloat(&p, eol, &vn->z);
+        break;
+      }
+      case LINE_FACE: {
+        // Relative indices count back from everything read so far, including
+        // the elements of earlier chunks.
+        ElementCounts available = {
+          .vertices = chunk->base.vertices + local.vertices,
+          .texcoords = chunk->base.texcoords + local.texcoords,
+          .normals = chunk->base.normals + local.normals,
+        };
+        CJellyFormat3dObjFace * face = &model->faces[chunk->base.faces + local.faces++];
+        face->material_index = current_material;
+        CJellyFormat3dObjError err = parseFace(&p, eol, face, &available);
+        if (err != CJELLY_FORMAT_3D_OBJ_SUCCESS) {
+          chunk->err = err;
+          return;
         }
-        strcpy(model->groups[model->group_count].name, name);
-        model->groups[model->group_count].start_face = model->face_count;
-        model->groups[model->group_count].face_count = 0;
-        current_group = model->group_count;
-        model->group_count++;
+        break;
       }
-      else {
-        err = CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
-        goto ERROR_CLEANUP;
+      case LINE_GROUP: {
+        // Face counts are filled in once all chunks are parsed.
+        skipSpace(&p, eol);
+        if (p == eol) break;
+        CJellyFormat3dObjGroup * group = &model->groups[chunk->base.groups + local.groups++];
+        parseName(&p, eol, group->name, sizeof(group->name));
+        group->start_face = chunk->base.faces + local.faces;
+        group->face_count = 0;
+        break;
       }
-    }
-    else if (strncmp(line, "usemtl", 6) == 0) {
-      // Read a material usage directive.
-      char mtl_name[CJELLY_FORMAT_3D_OBJ_MAX_NAME_LENGTH];
-      // 128 is hard-coded because "%127s" is used in the sscanf call.
-      // The assert is used to ensure that the buffer cannot be smaller
-      // than this hard-coded value.
-      assert(sizeof(mtl_name) >= 128);
-      if (sscanf(line + 6, "%127s", mtl_name) == 1) {
-        int found = 0;
-        int mapped_index = -1;
-        // Search for an existing mapping.
-        for (int i = 0; i < model->material_mapping_count; i++) {
-          if (strcmp(model->material_mappings[i].name, mtl_name) == 0) {
-            found = 1;
-            mapped_index = model->material_mappings[i].index;
-            break;
+      case LINE_USEMTL: {
+        if (chunk->material_count >= chunk->material_capacity) {
+          int capacity = chunk->material_capacity ? chunk->material_capacity * 2 : 4;
+          void * temp = realloc(chunk->materials, capacity * sizeof(*chunk->materials));
+          if (!temp) {
+            chunk->err = CJELLY_FORMAT_3D_OBJ_ERR_OUT_OF_MEMORY;
+            return;
           }
+          chunk->materials = temp;
+          chunk->material_capacity = capacity;
         }
-        if (!found) {
-          // Add a new mapping.
-          if (model->material_mapping_count >= model->material_mapping_capacity) {
-            model->material_mapping_capacity *= 2;
-            CJellyFormat3dObjMaterialMapping* temp = realloc(model->material_mappings, model->material_mapping_capacity * sizeof(CJellyFormat3dObjMaterialMapping));
-            if (!temp) { goto ERROR_CLEANUP; }
-            model->material_mappings = temp;
-          }
-          strcpy(model->material_mappings[model->material_mapping_count].name, mtl_name);
-          model->material_mappings[model->material_mapping_count].index = model->material_mapping_count;
-          mapped_index = model->material_mapping_count;
-          model->material_mapping_count++;
+        MaterialUse * use = &chunk->materials[chunk->material_count];
+        ok = parseName(&p, eol, use->name, sizeof(use->name));
+        current_material = chunk->material_count++;
+        break;
+      }
+      case LINE_MTLLIB: {
+        // A later "mtllib" replaces an earlier one; one without a name is ignored.
+        skipSpace(&p, eol);
+        const char * name = p;
+        while (p < eol && !isSpace(*p)) {
+          ++p;
+        }
+        if (p > name) {
+          chunk->mtllib = name;
+          chunk->mtllib_length = (size_t)(p - name);
         }
-        current_material_index = mapped_index;
+        break;
+      }
+      default:
+        break;
+    }
+
+    if (!ok) {
+      chunk->err = CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
+      return;
+    }
+    line = eol + 1;
+  }
+}
+
+
+// Returns the model-wide index of a material name, adding it if it is new,
+// or -1 if out of memory.
+static int mapMaterial(CJellyFormat3dObjModel * model, const char * name) {
+  for (int i = 0; i < model->material_mapping_count; i++) {
+    if (strcmp(model->material_mappings[i].name, name) == 0) {
+      return model->material_mappings[i].index;
+    }
+  }
+  if (model->material_mapping_count >= model->material_mapping_capacity) {
+    int capacity = model->material_mapping_capacity * 2;
+    CJellyFormat3dObjMaterialMapping * temp = realloc(model->material_mappings, capacity * sizeof(CJellyFormat3dObjMaterialMapping));
+    if (!temp) {
+      return -1;
+    }
+    model->material_mappings = temp;
+    model->material_mapping_capacity = capacity;
+  }
+  CJellyFormat3dObjMaterialMapping * mapping = &model->material_mappings[model->material_mapping_count];
+  strcpy(mapping->name, name);
+  mapping->index = model->material_mapping_count;
+  return model->material_mapping_count++;
+}
+
+
+// Resolves the state that crosses chunk boundaries, in file order.
+static CJellyFormat3dObjError mergeChunks(CJellyFormat3dObjModel * model, Chunk * chunks, int chunkCount) {
+  int current_material = -1;
+  for (int c = 0; c < chunkCount; ++c) {
+    Chunk * chunk = &chunks[c];
+
+    // Turn the chunk's material list into model-wide indices.
+    MaterialUse * uses = chunk->materials;
+    for (int i = 0; i < chunk->material_count; ++i) {
+      uses[i].index = mapMaterial(model, uses[i].name);
+      if (uses[i].index < 0) {
+        return CJELLY_FORMAT_3D_OBJ_ERR_OUT_OF_MEMORY;
       }
-      else {
-        err = CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
-        goto ERROR_CLEANUP;
+    }
+    CJellyFormat3dObjFace * faces = &model->faces[chunk->base.faces];
+    for (int i = 0; i < chunk->count.faces; ++i) {
+      faces[i].material_index = faces[i].material_index < 0 ? current_material : uses[faces[i].material_index].index;
+    }
+    if (chunk->material_count) {
+      current_material = uses[chunk->material_count - 1].index;
+    }
+
+    if (chunk->mtllib) {
+      size_t length = chunk->mtllib_length < sizeof(model->mtllib) - 1 ? chunk->mtllib_length : sizeof(model->mtllib) - 1;
+      memcpy(model->mtllib, chunk->mtllib, length);
+      model->mtllib[length] = '\0';
+    }
+  }
+
+  // A group holds every face up to the next group.
+  for (int g = 0; g < model->group_count; ++g) {
+    int next = g + 1 < model->group_count ? model->groups[g + 1].start_face : model->face_count;
+    model->groups[g].face_count = next - model->groups[g].start_face;
+  }
+  return CJELLY_FORMAT_3D_OBJ_SUCCESS;
+}
+
+
+// Splits the file into slices that start at the beginning of a line.
+static int splitChunks(const char * data, size_t size, uint32_t threads, Chunk * chunks) {
+  int chunkCount = 1;
+  if (size >= PARALLEL_THRESHOLD && threads > 0) {
+    size_t wanted = ((size_t)threads + 1) * 2;
+    size_t limit = size / MIN_CHUNK_SIZE;
+    chunkCount = (int)(wanted < limit ? wanted : limit);
+    if (chunkCount > MAX_CHUNKS) chunkCount = MAX_CHUNKS;
+    if (chunkCount < 1) chunkCount = 1;
+  }
+
+  const char * end = data + size;
+  const char * begin = data;
+  for (int i = 0; i < chunkCount; ++i) {
+    const char * split = end;
+    if (i + 1 < chunkCount) {
+      split = data + size / (size_t)chunkCount * (size_t)(i + 1);
+      if (split < begin) {
+        split = begin;
       }
+      split = lineEnd(split, end);
+      if (split < end) ++split;
+    }
+    memset(&chunks[i], 0, sizeof(Chunk));
+    chunks[i].begin = begin;
+    chunks[i].end = split;
+    begin = split;
+  }
+  return chunkCount;
+}
+
+
+CJellyFormat3dObjError cjelly_format_3d_obj_load(const char * filename, CJellyFormat3dObjModel * * outModel) {
+  CJellyFormat3dObjError err = CJELLY_FORMAT_3D_OBJ_SUCCESS;
+
+  // Check for invalid input.
+  if (!filename || !outModel) {
+    return CJELLY_FORMAT_3D_OBJ_ERR_INVALID_FORMAT;
+  }
+
+  // Map the file.  An empty file is a valid, empty model.
+  CJellyFormatFileMapping mapping;
+  switch (cjelly_format_file_map(filename, &mapping)) {
+    case CJELLY_FORMAT_FILE_SUCCESS:
+    case CJELLY_FORMAT_FILE_ERR_EMPTY:
+      break;
+    case CJELLY_FORMAT_FILE_ERR_NOT_FOUND:
+      fprintf(stderr, "Cannot open file %s\n", filename);
+      return CJELLY_FORMAT_3D_OBJ_ERR_FILE_NOT_FOUND;
+    case CJELLY_FORMAT_FILE_ERR_TOO_LARGE:
+      return CJELLY_FORMAT_3D_OBJ_ERR_OUT_OF_MEMORY;
+    default:
+      return CJELLY_FORMAT_3D_OBJ_ERR_IO;
+  }
+
+  // Large files are split across worker threads; small ones are parsed here.
+  uint32_t threads = mapping.size >= PARALLEL_THRESHOLD ? cj_worker_pool_default_threads() : 0;
+  Chunk chunks[MAX_CHUNKS];
+  int chunkCount = splitChunks((const char *)mapping.data, mapping.size, threads, chunks);
+  cj_worker_pool_t * pool = chunkCount > 1 ? cj_worker_pool_create(threads) : NULL;
+  CJellyFormat3dObjModel * model = NULL;
+
+  // Count every chunk, then give each one its range of the model arrays.
+  ParseJob job = {.chunks = chunks};
+  cj_worker_pool_parallel_for(pool, (uint32_t)chunkCount, countChunk, &job);
+  long long total[5] = {0};
+  for (int i = 0; i < chunkCount; ++i) {
+    if (chunks[i].err != CJELLY_FORMAT_3D_OBJ_SUCCESS) {
+      err = chunks[i].err;
+      goto ERROR_CLEANUP;
+    }
+    chunks[i].base = (ElementCounts){
+      .vertices = (int)total[0],
+      .texcoords = (int)total[1],
+      .normals = (int)total[2],
+      .faces = (int)total[3],
+      .groups = (int)total[4],
+    };
+    total[0] += chunks[i].count.vertices;
+    total[1] += chunks[i].count.texcoords;
+    total[2] += chunks[i].count.normals;
+    total[3] += chunks[i].count.faces;
+    total[4] += chunks[i].count.groups;
+    for (int k = 0; k < 5; ++k) {
+      if (total[k] > INT_MAX) { goto ERROR_CLEANUP; }
     }
-    else if (strncmp(line, "mtllib", 6) == 0) {
-      // Read the material library name.
-      sscanf(line + 6, "%255s", model->mtllib);
+  }
+
+  // Allocate the model with exactly the capacity it needs.  Faces are zeroed
+  // so that freeing a partially parsed model only frees real overflow arrays.
+  model = (CJellyFormat3dObjModel *)calloc(1, sizeof(CJellyFormat3dObjModel));
+  if (!model) { goto ERROR_CLEANUP; }
+
+  model->vertex_capacity = total[0] ? (int)total[0] : 1;
+  model->vertices = (CJellyFormat3dObjVertex *)malloc(model->vertex_capacity * sizeof(CJellyFormat3dObjVertex));
+  if (!model->vertices) { goto ERROR_CLEANUP; }
+  model->vertex_count = (int)total[0];
+
+  model->texcoord_capacity = total[1] ? (int)total[1] : 1;
+  model->texcoords = (CJellyFormat3dObjTexCoord *)malloc(model->texcoord_capacity * sizeof(CJellyFormat3dObjTexCoord));
+  if (!model->texcoords) { goto ERROR_CLEANUP; }
+  model->texcoord_count = (int)total[1];
+
+  model->normal_capacity = total[2] ? (int)total[2] : 1;
+  model->normals = (CJellyFormat3dObjNormal *)malloc(model->normal_capacity * sizeof(CJellyFormat3dObjNormal));
+  if (!model->normals) { goto ERROR_CLEANUP; }
+  model->normal_count = (int)total[2];
+
+  model->face_capacity = total[3] ? (int)total[3] : 1;
+  model->faces = (CJellyFormat3dObjFace *)calloc(model->face_capacity, sizeof(CJellyFormat3dObjFace));
+  if (!model->faces) { goto ERROR_CLEANUP; }
+  model->face_count = (int)total[3];
+
+  model->group_capacity = total[4] ? (int)total[4] : 1;
+  model->groups = (CJellyFormat3dObjGroup *)malloc(model->group_capacity * sizeof(CJellyFormat3dObjGroup));
+  if (!model->groups) { goto ERROR_CLEANUP; }
+  model->group_count = (int)total[4];
+
+  model->material_mapping_capacity = 4;
+  model->material_mappings = (CJellyFormat3dObjMaterialMapping *)malloc(model->material_mapping_capacity * sizeof(CJellyFormat3dObjMaterialMapping));
+  if (!model->material_mappings) { goto ERROR_CLEANUP; }
+
+  // Parse the chunks into their ranges, then stitch them together.
+  job.model = model;
+  cj_worker_pool_parallel_for(pool, (uint32_t)chunkCount, parseChunk, &job);
+  for (int i = 0; i < chunkCount; ++i) {
+    if (chunks[i].err != CJELLY_FORMAT_3D_OBJ_SUCCESS) {
+      err = chunks[i].err;
+      goto ERROR_CLEANUP;
     }
   }
+  err = mergeChunks(model, chunks, chunkCount);
+  if (err != CJELLY_FORMAT_3D_OBJ_SUCCESS) { goto ERROR_CLEANUP; }
 
-  // Close the file and return the model.
-  fclose(fp);
+  for (int i = 0; i < chunkCount; ++i) {
+    free(chunks[i].materials);
+  }
+  cj_worker_pool_destroy(pool);
+  cjelly_format_file_unmap(&mapping);
   *outModel = model;
   return CJELLY_FORMAT_3D_OBJ_SUCCESS;
 
@@ -289,8 +725,12 @@ ERROR_CLEANUP:
   if (err == CJELLY_FORMAT_3D_OBJ_SUCCESS) {
     err = CJELLY_FORMAT_3D_OBJ_ERR_OUT_OF_MEMORY;
   }
+  for (int i = 0; i < chunkCount; ++i) {
+    free(chunks[i].materials);
+  }
   cjelly_format_3d_obj_free(model);
-  fclose(fp);
+  cj_worker_pool_destroy(pool);
+  cjelly_format_file_unmap(&mapping);
   return err;
 }
 
@@ -0,0 +1,124 @@
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <cjelly/format/file.h>
+
+CJellyFormatFileError cjelly_format_file_map(const char * filename, CJellyFormatFileMapping * out_mapping) {
+  if (!out_mapping) {
+    return CJELLY_FORMAT_FILE_ERR_IO;
+  }
+  memset(out_mapping, 0, sizeof(CJellyFormatFileMapping));
+  if (!filename) {
+    return CJELLY_FORMAT_FILE_ERR_NOT_FOUND;
+  }
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    return CJELLY_FORMAT_FILE_ERR_NOT_FOUND;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize)) {
+    CloseHandle(file);
+    return CJELLY_FORMAT_FILE_ERR_IO;
+  }
+  if (fileSize.QuadPart == 0) {
+    CloseHandle(file);
+    return CJELLY_FORMAT_FILE_ERR_EMPTY;
+  }
+  if ((unsigned long long)fileSize.QuadPart > (size_t)-1) {
+    CloseHandle(file);
+    return CJELLY_FORMAT_FILE_ERR_TOO_LARGE;
+  }
+
+  // The mapping object keeps the file open.
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping) {
+    return CJELLY_FORMAT_FILE_ERR_IO;
+  }
+  const void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(mapping);
+    return CJELLY_FORMAT_FILE_ERR_IO;
+  }
+  out_mapping->data = (const unsigned char *)view;
+  out_mapping->size = (size_t)fileSize.QuadPart;
+  out_mapping->handle = mapping;
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return CJELLY_FORMAT_FILE_ERR_NOT_FOUND;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return CJELLY_FORMAT_FILE_ERR_IO;
+  }
+  if (st.st_size <= 0) {
+    close(fd);
+    return CJELLY_FORMAT_FILE_ERR_EMPTY;
+  }
+  if ((unsigned long long)st.st_size > (size_t)-1) {
+    close(fd);
+    return CJELLY_FORMAT_FILE_ERR_TOO_LARGE;
+  }
+
+  // The mapping stays valid after the descriptor is closed.
+  void * view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) {
+    return CJELLY_FORMAT_FILE_ERR_IO;
+  }
+
+  // Loaders read the whole file front to back, so start the readahead now.
+  posix_madvise(view, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+  out_mapping->data = (const unsigned char *)view;
+  out_mapping->size = (size_t)st.st_size;
+#endif
+  return CJELLY_FORMAT_FILE_SUCCESS;
+}
+
+
+void cjelly_format_file_unmap(CJellyFormatFileMapping * mapping) {
+  if (!mapping || !mapping->data) return;
+#ifdef _WIN32
+  UnmapViewOfFile(mapping->data);
+  CloseHandle((HANDLE)mapping->handle);
+#else
+  munmap((void *)mapping->data, mapping->size);
+#endif
+  memset(mapping, 0, sizeof(CJellyFormatFileMapping));
+}
+
+
+CJellyFormatFileError cjelly_format_file_stat(const char * filename, int64_t * out_mtime, uint64_t * out_size) {
+  if (out_mtime) *out_mtime = 0;
+  if (out_size) *out_size = 0;
+  struct stat st;
+  if (!filename || stat(filename, &st) != 0) {
+    return CJELLY_FORMAT_FILE_ERR_NOT_FOUND;
+  }
+#ifdef _WIN32
+  if (out_mtime) *out_mtime = (int64_t)st.st_mtime * 1000000000;
+#else
+  if (out_mtime) *out_mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+  if (out_size) *out_size = (uint64_t)st.st_size;
+  return CJELLY_FORMAT_FILE_SUCCESS;
+}
@@ -5,6 +5,9 @@
 #include <cjelly/format/image.h>
 #include <cjelly/format/image/bmp.h>
 
+// Matches the leading bytes of a file against the known image signatures.
+static CJellyFormatImageType matchSignature(const unsigned char * bytes, size_t length);
+
 CJellyFormatImageError cjelly_format_image_load(const char * filename, CJellyFormatImage * * out_image) {
   *out_image = NULL;
 
@@ -40,30 +43,45 @@ ERROR_IMAGE_CLEANUP:
 }
 
 
-void cjelly_format_image_free(CJellyFormatImage * image) {
-  if (!image) return;
-  switch (image->type) {
+CJellyFormatImageError cjelly_format_image_load_rgba(const char * filename,
+    const CJellyFormatImageTarget * target, int * out_width, int * out_height) {
+  // Map the file once; the type is detected from the mapped bytes and the
+  // loader decodes them in place.
+  CJellyFormatImageMapping mapping;
+  CJellyFormatImageError err = cjelly_format_image_map(filename, &mapping);
+  if (err != CJELLY_FORMAT_IMAGE_SUCCESS) return err;
+
+  switch (matchSignature(mapping.data, mapping.size)) {
     case CJELLY_FORMAT_IMAGE_BMP:
-      cjelly_format_image_bmp_free((CJellyFormatImageBMP *)image);
+      err = cjelly_format_image_bmp_load_rgba_memory(mapping.data, mapping.size, target, out_width, out_height);
       break;
     default:
+      err = CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
       break;
   }
-  if (image->raw) {
-    if (image->raw->data) {
-      free(image->raw->data);
-      image->raw->data = NULL;
-      image->raw->data_size = 0;
-    }
-    free(image->raw);
-    image->raw = NULL;
-  }
-  if (image->name) {
-    free(image->name);
-    image->name = NULL;
+  cjelly_format_image_unmap(&mapping);
+  return err;
+}
+
+
+CJellyFormatImageError cjelly_format_image_map(const char * filename, CJellyFormatImageMapping * out_mapping) {
+  switch (cjelly_format_file_map(filename, out_mapping)) {
+    case CJELLY_FORMAT_FILE_SUCCESS:
+      return CJELLY_FORMAT_IMAGE_SUCCESS;
+    case CJELLY_FORMAT_FILE_ERR_NOT_FOUND:
+      return CJELLY_FORMAT_IMAGE_ERR_FILE_NOT_FOUND;
+    case CJELLY_FORMAT_FILE_ERR_EMPTY:
+      return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+    case CJELLY_FORMAT_FILE_ERR_TOO_LARGE:
+      return CJELLY_FORMAT_IMAGE_ERR_OUT_OF_MEMORY;
+    default:
+      return CJELLY_FORMAT_IMAGE_ERR_IO;
   }
-  image->type = CJELLY_FORMAT_IMAGE_UNKNOWN;
-  free(image);
+}
+
+
+void cjelly_format_image_unmap(CJellyFormatImageMapping * mapping) {
+  cjelly_format_file_unmap(mapping);
 }
 
 
@@ -82,12 +100,14 @@ typedef struct {
 
 // Define known image signatures.
 static const unsigned char signature_bmp[] = {'B', 'M'};
+static const unsigned char signature_ktx2[] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
 // static const unsigned char signature_png[] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
 // static const unsigned char signature_jpg[] = {0xFF, 0xD8, 0xFF};
 
 
 static ImageSignature signatures[] = {
   { CJELLY_FORMAT_IMAGE_BMP, signature_bmp, sizeof(signature_bmp) },
+  { CJELLY_FORMAT_IMAGE_KTX2, signature_ktx2, sizeof(signature_ktx2) },
   // { CJELLY_FORMAT_IMAGE_PNG, signature_png, sizeof(signature_png) },
   // { CJELLY_FORMAT_IMAGE_JPG, signature_jpg, sizeof(signature_jpg) },
 };
@@ -124,19 +144,23 @@ CJellyFormatImageError cjelly_format_image_detect_type(const char * path, CJelly
   // Read the required number of bytes.
   size_t bytes_read = fread(buffer, sizeof(unsigned char), max_sig_length, fp);
   fclose(fp);
-  if (bytes_read) {
-    // Iterate over each known signature and check for a match.
-    for (size_t i = 0; i < num_signatures; i++) {
-      if ((bytes_read >= signatures[i].length) && !memcmp(buffer, signatures[i].signature, signatures[i].length)) {
-        *out_type = signatures[i].type;
-        free(buffer);
-        return CJELLY_FORMAT_IMAGE_SUCCESS;
-      }
+  *out_type = matchSignature(buffer, bytes_read);
+  free(buffer);
+  return *out_type != CJELLY_FORMAT_IMAGE_UNKNOWN
+    ? CJELLY_FORMAT_IMAGE_SUCCESS
+    : CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+}
+
+
+static CJellyFormatImageType matchSignature(const unsigned char * bytes, size_t length) {
+  // Iterate over each known signature and check for a match.
+  size_t num_signatures = sizeof(signatures) / sizeof(signatures[0]);
+  for (size_t i = 0; i < num_signatures; i++) {
+    if ((length >= signatures[i].length) && !memcmp(bytes, signatures[i].signature, signatures[i].length)) {
+      return signatures[i].type;
     }
   }
-
-  free(buffer);
-  return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  return CJELLY_FORMAT_IMAGE_UNKNOWN;
 }
 
 
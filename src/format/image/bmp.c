@@ -1,8 +1,10 @@
+#include <limits.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <cjelly/format/image/bmp.h>
+#include <cjelly/format/image/convert.h>
 
 // BMP file header structures.
 // The structures are packed so that they exactly match the file layout.
@@ -38,111 +40,86 @@ typedef struct {
 #pragma pack(pop)
 
 // Helper: calculate the row size (in bytes) for a given width and bits-per-pixel.
-static int calcRowSize(int width, int bitsPerPixel) {
-  return (((width * bitsPerPixel) + 31) / 32) * 4;
+static size_t calcRowSize(unsigned int width, unsigned int bitsPerPixel) {
+  return ((((size_t)width * bitsPerPixel) + 31) / 32) * 4;
 }
 
-// Helper: read a palette of numColors entries.
-static RGBQuad* readPalette(FILE * fp, unsigned int numColors) {
-  RGBQuad * palette = (RGBQuad *)malloc(numColors * sizeof(RGBQuad));
-  if (!palette) {
-    return NULL;
-  }
-  if (fread(palette, sizeof(RGBQuad), numColors, fp) != numColors) {
-    free(palette);
-    return NULL;
+// A palette color, already in the RGBA8 output layout.
+typedef struct {
+  unsigned char rgba[4];
+} PaletteEntry;
+
+// Helper: expand the palette of a bitmap into a 256-entry lookup table.
+// Entries past the stored colors are opaque black, so that out-of-range
+// indices in corrupt files stay within the table.
+static void expandPalette(const CJellyFormatImageBMPInfo * info, PaletteEntry * palette) {
+  for (unsigned int i = 0; i < 256; ++i) {
+    const unsigned char * quad = info->palette + ((size_t)i * sizeof(RGBQuad));
+    bool stored = i < info->palette_size;
+    palette[i].rgba[0] = stored ? quad[2] : 0;
+    palette[i].rgba[1] = stored ? quad[1] : 0;
+    palette[i].rgba[2] = stored ? quad[0] : 0;
+    palette[i].rgba[3] = 255;
   }
-  return palette;
 }
 
-// Helper: process uncompressed rows. This function seeks through each row,
-// flips the image vertically, and calls a conversion callback for each row.
-static CJellyFormatImageError processUncompressedRows(FILE * fp, int bitsPerPixel,
-    int width, int height, unsigned char *dest, int destPixelSize, bool topDown,
-    void (*convertRow)(const unsigned char *src, int width, unsigned char * dest)) {
-  int rowSize = calcRowSize(width, bitsPerPixel);
-  unsigned char *rowBuffer = (unsigned char *)malloc((size_t)rowSize);
-  if (!rowBuffer) {
-    return CJELLY_FORMAT_IMAGE_ERR_OUT_OF_MEMORY;
+// Helper: write one palette color into an RGBA8 row, clipping at the row end.
+static inline void putPaletteColor(unsigned char * row, unsigned int x, unsigned int width,
+    const PaletteEntry * palette, unsigned char index) {
+  if (x < width) {
+    memcpy(row + ((size_t)x * 4), palette[index].rgba, 4);
   }
-  for (int y = 0; y < height; ++y) {
-    if (fread(rowBuffer, 1, (size_t)rowSize, fp) != (size_t)rowSize) {
-      free(rowBuffer);
-      return CJELLY_FORMAT_IMAGE_ERR_IO;
-    }
-    int destRow = topDown ? y : ((height - 1) - y);
-    unsigned char * destRowPtr = dest + (destRow * width * destPixelSize);
-    convertRow(rowBuffer, width, destRowPtr);
-  }
-  free(rowBuffer);
-  return CJELLY_FORMAT_IMAGE_SUCCESS;
 }
 
-// Conversion callback for 24-bit rows: convert from BGR to RGB.
-static void convert24BitRow(const unsigned char * src, int width, unsigned char *dest) {
-  for (int x = 0; x < width; ++x) {
-    int pixelIndex = x * 3;
-    unsigned char blue  = src[pixelIndex + 0];
-    unsigned char green = src[pixelIndex + 1];
-    unsigned char red   = src[pixelIndex + 2];
-    dest[(x * 3) + 0] = red;
-    dest[(x * 3) + 1] = green;
-    dest[(x * 3) + 2] = blue;
-  }
+// Helper: read the next byte of RLE data, or EOF at the end of the span.
+static inline int readByte(const unsigned char * * cursor, const unsigned char * end) {
+  return *cursor < end ? *(*cursor)++ : EOF;
 }
 
-// Conversion callback for 16-bit rows (assumed 5-6-5 format).
-static void convert16BitRow(const unsigned char * src, int width, unsigned char * dest) {
-  for (int x = 0; x < width; ++x) {
-    int pixelIndex = x * 2;
-    unsigned short pixel = (unsigned short)(src[pixelIndex] | (src[pixelIndex + 1] << 8));
-    unsigned char r = (unsigned char)(((pixel >> 11) & 0x1F) * 255 / 31);
-    unsigned char g = (unsigned char)(((pixel >> 5)  & 0x3F) * 255 / 63);
-    unsigned char b = (unsigned char)((pixel & 0x1F) * 255 / 31);
-    dest[(x * 3) + 0] = r;
-    dest[(x * 3) + 1] = g;
-    dest[(x * 3) + 2] = b;
+// Helper: pick the pixel conversion for a true-color bitmap.  BI_RGB 16-bit
+// bitmaps are X1R5G5B5; BI_BITFIELDS bitmaps name their channels with masks,
+// of which the 5-6-5, 5-5-5 and 8-8-8 layouts are supported.
+static bool selectTrueColorLayout(const BMPInfoHeader * info, const unsigned int masks[3],
+    CJellyFormatImagePixel * out_layout) {
+  if (info->biCompression == 0) {
+    *out_layout = info->biBitCount == 32
+      ? CJELLY_FORMAT_IMAGE_PIXEL_BGRA32
+      : info->biBitCount == 24
+        ? CJELLY_FORMAT_IMAGE_PIXEL_BGR24
+        : CJELLY_FORMAT_IMAGE_PIXEL_RGB555;
+    return true;
   }
-}
-
-// Conversion callback for 32-bit rows (assumed BGRA to RGBA).
-static void convert32BitRow(const unsigned char * src, int width, unsigned char * dest) {
-  for (int x = 0; x < width; ++x) {
-    int pixelIndex = x * 4;
-    unsigned char blue  = src[pixelIndex + 0];
-    unsigned char green = src[pixelIndex + 1];
-    unsigned char red   = src[pixelIndex + 2];
-    unsigned char alpha = src[pixelIndex + 3];
-    dest[(x * 4) + 0] = red;
-    dest[(x * 4) + 1] = green;
-    dest[(x * 4) + 2] = blue;
-    dest[(x * 4) + 3] = alpha;
+  if (info->biBitCount == 16 && masks[0] == 0xF800 && masks[1] == 0x07E0 && masks[2] == 0x001F) {
+    *out_layout = CJELLY_FORMAT_IMAGE_PIXEL_RGB565;
+    return true;
+  }
+  if (info->biBitCount == 16 && masks[0] == 0x7C00 && masks[1] == 0x03E0 && masks[2] == 0x001F) {
+    *out_layout = CJELLY_FORMAT_IMAGE_PIXEL_RGB555;
+    return true;
+  }
+  if (info->biBitCount == 32 && masks[0] == 0x00FF0000 && masks[1] == 0x0000FF00 && masks[2] == 0x000000FF) {
+    *out_layout = CJELLY_FORMAT_IMAGE_PIXEL_BGRA32;
+    return true;
   }
+  return false;
 }
 
-CJellyFormatImageError cjelly_format_image_bmp_load(const char * filename, CJellyFormatImage * * out_image) {
-  CJellyFormatImageError err = CJELLY_FORMAT_IMAGE_SUCCESS;
-  unsigned char * rowBuffer = NULL;
-  RGBQuad * palette = NULL;
-  *out_image = NULL;
-
+CJellyFormatImageError cjelly_format_image_bmp_parse(const void * data, size_t size, CJellyFormatImageBMPInfo * out_info) {
   // Validate input parameters.
-  if (!filename || !out_image) {
+  if (!data || !out_info) {
     return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
   }
+  memset(out_info, 0, sizeof(CJellyFormatImageBMPInfo));
+  const unsigned char * bytes = (const unsigned char *)data;
 
-  // Open the BMP file for reading.
-  FILE * fp = fopen(filename, "rb");
-  if (!fp) {
-    return CJELLY_FORMAT_IMAGE_ERR_FILE_NOT_FOUND;
-  }
-
-  // Read the BMP file header.
+  // Copy out the headers; the span has no alignment guarantees.
   BMPFileHeader fileHeader;
-  if (fread(&fileHeader, sizeof(BMPFileHeader), 1, fp) != 1) {
-    err = CJELLY_FORMAT_IMAGE_ERR_IO;
-    goto ERROR_FILE_CLOSE;
+  BMPInfoHeader infoHeader;
+  if (size < sizeof(BMPFileHeader) + sizeof(BMPInfoHeader)) {
+    return CJELLY_FORMAT_IMAGE_ERR_IO;
   }
+  memcpy(&fileHeader, bytes, sizeof(BMPFileHeader));
+  memcpy(&infoHeader, bytes + sizeof(BMPFileHeader), sizeof(BMPInfoHeader));
 
   // Convert the BMP file header fields to host byte order.
   fileHeader.bfType    = GCJ_LE16_TO_HOST(fileHeader.bfType);
@@ -151,15 +128,7 @@ CJellyFormatImageError cjelly_format_image_bmp_load(const char * filename, CJell
 
   // Check the BMP file signature.
   if (fileHeader.bfType != 0x4D42) {
-    err = CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
-    goto ERROR_FILE_CLOSE;
-  }
-
-  // Read the BMP info header.
-  BMPInfoHeader infoHeader;
-  if (fread(&infoHeader, sizeof(BMPInfoHeader), 1, fp) != 1) {
-    err = CJELLY_FORMAT_IMAGE_ERR_IO;
-    goto ERROR_FILE_CLOSE;
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
   }
 
   // Convert the BMP info header fields to host byte order.
@@ -172,339 +141,384 @@ CJellyFormatImageError cjelly_format_image_bmp_load(const char * filename, CJell
   infoHeader.biSizeImage    = GCJ_LE32_TO_HOST(infoHeader.biSizeImage);
   infoHeader.biClrUsed      = GCJ_LE32_TO_HOST(infoHeader.biClrUsed);
   infoHeader.biClrImportant = GCJ_LE32_TO_HOST(infoHeader.biClrImportant);
+  if (infoHeader.biSize < sizeof(BMPInfoHeader) || infoHeader.biSize > size - sizeof(BMPFileHeader)) {
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  }
+
+  // BI_BITFIELDS channel masks follow the 40 bytes of the original info
+  // header, either as an extension of it or as a separate table.
+  unsigned int masks[3] = {0, 0, 0};
+  if (infoHeader.biCompression == 3) {
+    size_t masksOffset = sizeof(BMPFileHeader) + sizeof(BMPInfoHeader);
+    if (size < masksOffset + sizeof(masks)) {
+      return CJELLY_FORMAT_IMAGE_ERR_IO;
+    }
+    memcpy(masks, bytes + masksOffset, sizeof(masks));
+    for (int i = 0; i < 3; ++i) {
+      masks[i] = GCJ_LE32_TO_HOST(masks[i]);
+    }
+  }
 
   // Determine if the bitmap is top-down.
   bool topDown = false;
-  if (infoHeader.biHeight < 0) {
+  if (infoHeader.biHeight < 0 && infoHeader.biHeight != INT_MIN) {
     topDown = true;
     infoHeader.biHeight = -infoHeader.biHeight;
   }
+  if (infoHeader.biWidth <= 0 || infoHeader.biHeight <= 0) {
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  }
+  unsigned int bits = infoHeader.biBitCount;
+
+  // Work out how the pixels are stored.
+  bool trueColor = (infoHeader.biCompression == 0 || infoHeader.biCompression == 3)
+    && (bits == 16 || bits == 24 || bits == 32);
+  bool paletted = infoHeader.biCompression == 0 && (bits == 1 || bits == 4 || bits == 8);
+  bool rle = (bits == 8 && infoHeader.biCompression == 1)
+    || ((bits == 1 || bits == 4) && infoHeader.biCompression == 2);
+  if (trueColor) {
+    if (!selectTrueColorLayout(&infoHeader, masks, &out_info->layout)) {
+      return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+    }
+  }
+  else if (paletted || rle) {
+    // The palette is stored immediately after the info header.
+    unsigned int expectedColors = (bits == 1 ? 2 : (bits == 4 ? 16 : 256));
+    unsigned int numColors = infoHeader.biClrUsed != 0 ? infoHeader.biClrUsed : expectedColors;
+    size_t paletteOffset = sizeof(BMPFileHeader) + infoHeader.biSize;
+    if (numColors > 256) {
+      return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+    }
+    if (size - paletteOffset < (size_t)numColors * sizeof(RGBQuad)) {
+      return CJELLY_FORMAT_IMAGE_ERR_IO;
+    }
+    out_info->palette = bytes + paletteOffset;
+    out_info->palette_size = numColors;
+  }
+  else {
+    // If we're here, then we don't know how to interpret the BMP.
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  }
 
-  // Allocate the BMP image structure.
-  CJellyFormatImageBMP * bmpImage = (CJellyFormatImageBMP *)malloc(sizeof(CJellyFormatImageBMP));
-  if (!bmpImage) {
-    goto ERROR_FILE_CLOSE;
+  // Locate the pixel data and make sure every uncompressed row is present.
+  if (fileHeader.bfOffBits >= size) {
+    return CJELLY_FORMAT_IMAGE_ERR_IO;
   }
-  memset(bmpImage, 0, sizeof(CJellyFormatImageBMP));
+  out_info->width = infoHeader.biWidth;
+  out_info->height = infoHeader.biHeight;
+  out_info->top_down = topDown;
+  out_info->bits_per_pixel = bits;
+  out_info->compression = infoHeader.biCompression;
+  out_info->pixels = bytes + fileHeader.bfOffBits;
+  out_info->pixels_size = size - fileHeader.bfOffBits;
+  if (!rle) {
+    out_info->row_size = calcRowSize((unsigned int)infoHeader.biWidth, bits);
+    if (out_info->pixels_size / out_info->row_size < (size_t)infoHeader.biHeight) {
+      return CJELLY_FORMAT_IMAGE_ERR_IO;
+    }
+  }
+  return CJELLY_FORMAT_IMAGE_SUCCESS;
+}
 
-  // Allocate the raw image data structure.
-  bmpImage->base.raw = (CJellyFormatImageRaw *)malloc(sizeof(CJellyFormatImageRaw));
-  if (!bmpImage->base.raw) {
-    goto ERROR_FREE_BMP_IMAGE;
+const unsigned char * cjelly_format_image_bmp_bgra_pixels(const CJellyFormatImageBMPInfo * info) {
+  // 32-bit rows are always a multiple of 4 bytes, so they carry no padding.
+  if (!info || !info->pixels || !info->top_down || info->bits_per_pixel != 32) {
+    return NULL;
   }
-  memset(bmpImage->base.raw, 0, sizeof(CJellyFormatImageRaw));
+  return info->layout == CJELLY_FORMAT_IMAGE_PIXEL_BGRA32 ? info->pixels : NULL;
+}
 
-  // Populate the BMP image structure.
-  bmpImage->base.type = CJELLY_FORMAT_IMAGE_BMP;
-  unsigned int width = infoHeader.biWidth;
-  unsigned int height = infoHeader.biHeight;
-  bmpImage->base.raw->width  = width;
-  bmpImage->base.raw->height = height;
-
-  // All modes will produce either a 24-bit (RGB) or 32-bit (RGBA) image.
-  bmpImage->base.raw->channels = infoHeader.biBitCount == 32 ? 4 : 3;
-  bmpImage->base.raw->bitdepth = infoHeader.biBitCount == 32 ? 32 : 24;
-  int rowSize = calcRowSize(width, infoHeader.biBitCount);
-  size_t dataSize = width * height * bmpImage->base.raw->channels;
-
-  // Allocate and zero out memory for the raw image data.
-  bmpImage->base.raw->data = (unsigned char *)malloc(dataSize);
-  if (!bmpImage->base.raw->data) {
-    goto ERROR_FREE_BASE_RAW;
-  }
-  bmpImage->base.raw->data_size = dataSize;
-  memset(bmpImage->base.raw->data, 0, dataSize);
-
-   // Actually read the image data.
-  if (infoHeader.biCompression == 0) {
-    // Uncompressed BMPs.
-
-    if ((infoHeader.biBitCount == 16 || infoHeader.biBitCount == 24 || infoHeader.biBitCount == 32)) {
-      // These are true-color uncompressed BMPs (16-bit, 24-bit, or 32-bit).
-
-      // Seek to the start of the pixel data.
-      if (fseek(fp, fileHeader.bfOffBits, SEEK_SET) != 0) {
-        err = CJELLY_FORMAT_IMAGE_ERR_IO;
-        goto ERROR_FREE_BASE_RAW_DATA;
-      }
+CJellyFormatImageError cjelly_format_image_bmp_decode(const CJellyFormatImageBMPInfo * info,
+    unsigned char * dest, size_t dest_stride) {
+  if (!info || !info->pixels || !dest) {
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  }
+  unsigned int width = (unsigned int)info->width;
+  unsigned int height = (unsigned int)info->height;
+  unsigned int bits = info->bits_per_pixel;
+  bool topDown = info->top_down;
+
+  // True-color rows (16-bit, 24-bit, or 32-bit) are converted in one pass,
+  // which also flips bottom-up bitmaps into the top-down destination.
+  if (!info->palette) {
+    cjelly_format_image_convert(info->layout, info->pixels, info->row_size,
+        dest, dest_stride, width, height, !topDown);
+    return CJELLY_FORMAT_IMAGE_SUCCESS;
+  }
 
-      // Process the uncompressed rows.
-      err = infoHeader.biBitCount == 24
-        ? processUncompressedRows(fp, 24, width, height, bmpImage->base.raw->data, 3, topDown, convert24BitRow)
-        : infoHeader.biBitCount == 16
-          ? processUncompressedRows(fp, 16, width, height, bmpImage->base.raw->data, 3, topDown, convert16BitRow)
-          : processUncompressedRows(fp, 32, width, height, bmpImage->base.raw->data, 4, topDown, convert32BitRow);
-      if (err != CJELLY_FORMAT_IMAGE_SUCCESS) {
-        goto ERROR_FREE_BASE_RAW_DATA;
-      }
-    }
-    else if (infoHeader.biBitCount == 8 || infoHeader.biBitCount == 1 || infoHeader.biBitCount == 4) {
-      // Palette-based uncompressed (8-bit or 1/4-bit).
-      int bits = infoHeader.biBitCount;
-      unsigned int expectedColors = (bits == 1 ? 2 : (bits == 4 ? 16 : 0));
-      unsigned int num_colors = (infoHeader.biClrUsed != 0 ? infoHeader.biClrUsed : (bits == 8 ? 256 : expectedColors));
-
-      // The palette is stored immediately after the info header.
-      palette = readPalette(fp, num_colors);
-      if (!palette) {
-        err = CJELLY_FORMAT_IMAGE_ERR_IO;
-        goto ERROR_FREE_BASE_RAW_DATA;
-      }
+  PaletteEntry palette[256];
+  expandPalette(info, palette);
 
-      // Seek to the start of the pixel data.
-      if (fseek(fp, fileHeader.bfOffBits, SEEK_SET) != 0) {
-        err = CJELLY_FORMAT_IMAGE_ERR_IO;
-        goto ERROR_FREE_PALETTE;
-      }
+  if (info->compression == 0) {
+    // Palette-based uncompressed (8-bit or 1/4-bit).
+    for (unsigned int y = 0; y < height; ++y) {
+      const unsigned char * src = info->pixels + (y * info->row_size);
 
-      // Allocate a buffer for reading rows.
-      rowBuffer = (unsigned char *)malloc((size_t)rowSize);
-      if (!rowBuffer) {
-        goto ERROR_FREE_PALETTE;
-      }
+      // Flip the image vertically (in the output).
+      unsigned int destRow = topDown ? y : ((height - 1) - y);
+      unsigned char * row = dest + (destRow * dest_stride);
 
-      // Process the uncompressed, palette-based rows.
-      for (unsigned int y = 0; y < height; ++y) {
-        // Read the row.
-        if (fread(rowBuffer, 1, (size_t)rowSize, fp) != (size_t)rowSize) {
-          err = CJELLY_FORMAT_IMAGE_ERR_IO;
-          goto ERROR_FREE_ROWBUFFER;
+      // Decode the row.
+      for (unsigned int x = 0; x < width; ++x) {
+        unsigned char index;
+        if (bits == 8) {
+          // 8-bit mode.
+          index = src[x];
         }
-
-        // Flip the image vertically (in the output).
-        int destRow = topDown ? y : ((height - 1) - y);
-        unsigned char * dest = bmpImage->base.raw->data + (destRow * width * 3);
-
-        // Decode the row.
-        for (unsigned int x = 0; x < width; ++x) {
-          unsigned char index;
-          if (bits == 8) {
-            // 8-bit mode.
-            index = rowBuffer[x];
-          }
-          else {
-            // 1-bit and 4-bit modes.
-            int bitIndex = x * bits;
-            int byteIndex = bitIndex / 8;
-            int shift = (8 - bits) - (bitIndex % 8);
-            index = (rowBuffer[byteIndex] >> shift) & ((1 << bits) - 1);
-          }
-          if (index >= num_colors) {
-            err = CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
-            goto ERROR_FREE_ROWBUFFER;
-          }
-          dest[(x * 3) + 0] = palette[index].rgbRed;
-          dest[(x * 3) + 1] = palette[index].rgbGreen;
-          dest[(x * 3) + 2] = palette[index].rgbBlue;
+        else {
+          // 1-bit and 4-bit modes.
+          unsigned int bitIndex = x * bits;
+          unsigned int byteIndex = bitIndex / 8;
+          unsigned int shift = (8 - bits) - (bitIndex % 8);
+          index = (unsigned char)((src[byteIndex] >> shift) & ((1u << bits) - 1));
+        }
+        if (index >= info->palette_size) {
+          return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
         }
+        putPaletteColor(row, x, width, palette, index);
       }
-      free(rowBuffer);
-      free(palette);
-    }
-    else {
-      err = CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
-      goto ERROR_FREE_BASE_RAW_DATA;
     }
+    return CJELLY_FORMAT_IMAGE_SUCCESS;
   }
+
   // --- RLE Compressed Modes ---
-  else if ((infoHeader.biBitCount == 8 && infoHeader.biCompression == 1)
-    || ((infoHeader.biBitCount == 1 || infoHeader.biBitCount == 4) && infoHeader.biCompression == 2)) {
+  // RLE-compressed BMP (RLE8 for 8-bit, RLE4 for 1-/4-bit).
+  unsigned int mode = bits;
+  const unsigned char * cursor = info->pixels;
+  const unsigned char * end = info->pixels + info->pixels_size;
+
+  // Pixels skipped by deltas or an early end-of-bitmap are opaque black.
+  static const unsigned char opaqueBlack[4] = { 0, 0, 0, 255 };
+  for (unsigned int y = 0; y < height; ++y) {
+    for (unsigned int x = 0; x < width; ++x) {
+      memcpy(dest + (y * dest_stride) + ((size_t)x * 4), opaqueBlack, 4);
+    }
+  }
 
-    // RLE-compressed BMP (RLE8 for 8-bit, RLE4 for 1-/4-bit).
-    int mode = infoHeader.biBitCount;
+  unsigned int x = 0, y = 0;
+  while (y < height) {
+    // Process a row.
 
-    // The palette is stored immediately after the info header.
-    // Read the palette.
-    unsigned int num_colors = infoHeader.biClrUsed
-      ? infoHeader.biClrUsed
-      : mode == 8
-        ? 256
-        : mode == 1
-          ? 2
-          : 16;
-    palette = readPalette(fp, num_colors);
-    if (!palette) {
-      err = CJELLY_FORMAT_IMAGE_ERR_IO;
-      goto ERROR_FREE_BASE_RAW_DATA;
+    // Read the RLE pair.
+    int count = readByte(&cursor, end);
+    if (count == EOF) {
+      return CJELLY_FORMAT_IMAGE_ERR_IO;
+    }
+    int value = readByte(&cursor, end);
+    if (value == EOF) {
+      return CJELLY_FORMAT_IMAGE_ERR_IO;
     }
 
-    unsigned int x = 0, y = 0;
-    while (y < height) {
-      // Process a row.
-
-      // Read the RLE pair.
-      int count = fgetc(fp);
-      if (count == EOF) {
-        err = CJELLY_FORMAT_IMAGE_ERR_IO;
-        goto ERROR_FREE_PALETTE;
-      }
-      int value = fgetc(fp);
-      if (value == EOF) {
-        err = CJELLY_FORMAT_IMAGE_ERR_IO;
-        goto ERROR_FREE_PALETTE;
-      }
+    // Rows are flipped vertically.
+    unsigned int destRow = topDown ? y : ((height - 1) - y);
+    unsigned char * row = dest + (destRow * dest_stride);
 
-      // Rows are flipped vertically.
-      int destRow = topDown ? y : ((height - 1) - y);
-      int destOffset = destRow * width * 3;
+    // Process the RLE pair.
+    if (count) {
+      // `count` is greater than zero, so this is Encoded mode.
 
       // Process the RLE pair.
-      if (count) {
-        // `count` is greater than zero, so this is Encoded mode.
-
-        // Process the RLE pair.
-        if (mode == 8) {
-          // RLE8: output 'count' copies of the single color.
-          for (int i = 0; i < count; ++i) {
-            if (x < width) {
-              unsigned char * dest = bmpImage->base.raw->data + destOffset + (x * 3);
-              dest[0] = palette[(unsigned char)value].rgbRed;
-              dest[1] = palette[(unsigned char)value].rgbGreen;
-              dest[2] = palette[(unsigned char)value].rgbBlue;
-            }
-            x++;
-          }
-        }
-        else {
-          // RLE4: each encoded byte holds two nibbles.
-
-          // `nibbles` will hold the two nibbles from the byte
-          // in the order [high, low].  We can then use `i & 1`
-          // to select the appropriate nibble.
-          unsigned char nibbles[2] = { (unsigned char)((value >> 4) & 0x0F), (unsigned char)(value & 0x0F) };
-          for (int i = 0; i < count; ++i) {
-            unsigned char nibble = nibbles[i & 1];
-            if (x < width)  {
-              unsigned char * dest = bmpImage->base.raw->data + destOffset + (x * 3);
-              dest[0] = palette[nibble].rgbRed;
-              dest[1] = palette[nibble].rgbGreen;
-              dest[2] = palette[nibble].rgbBlue;
-            }
-            x++;
-          }
+      if (mode == 8) {
+        // RLE8: output 'count' copies of the single color.
+        for (int i = 0; i < count; ++i) {
+          putPaletteColor(row, x, width, palette, (unsigned char)value);
+          x++;
         }
       }
       else {
-        // `count` is 0, so this is Escape mode.
-        if (value == 0) {
-          // End-of-line.
-          x = 0;
-          y++;
+        // RLE4: each encoded byte holds two nibbles.
+
+        // `nibbles` will hold the two nibbles from the byte
+        // in the order [high, low].  We can then use `i & 1`
+        // to select the appropriate nibble.
+        unsigned char nibbles[2] = { (unsigned char)((value >> 4) & 0x0F), (unsigned char)(value & 0x0F) };
+        for (int i = 0; i < count; ++i) {
+          putPaletteColor(row, x, width, palette, nibbles[i & 1]);
+          x++;
         }
-        else if (value == 1) {
-          // End-of-bitmap.
-          break;
+      }
+    }
+    else {
+      // `count` is 0, so this is Escape mode.
+      if (value == 0) {
+        // End-of-line.
+        x = 0;
+        y++;
+      }
+      else if (value == 1) {
+        // End-of-bitmap.
+        break;
+      }
+      else if (value == 2) {
+        // Delta.
+        int dx = readByte(&cursor, end);
+        int dy = readByte(&cursor, end);
+        if (dx == EOF || dy == EOF) {
+          return CJELLY_FORMAT_IMAGE_ERR_IO;
         }
-        else if (value == 2) {
-          // Delta.
-          int dx = fgetc(fp);
-          int dy = fgetc(fp);
-          if (dx == EOF || dy == EOF) {
-            err = CJELLY_FORMAT_IMAGE_ERR_IO;
-            goto ERROR_FREE_PALETTE;
+        x += (unsigned char)dx;
+        y += (unsigned char)dy;
+      }
+      else {
+        // Absolute mode.
+        int n = value;
+        if (mode == 8) {
+          // RLE8 absolute mode.
+          // In RLE8 absolute mode, that many 8‑bit color indices are read
+          // directly. If the count is odd, a padding byte is added.
+          for (int i = 0; i < n; ++i) {
+            int pixel = readByte(&cursor, end);
+            if (pixel == EOF) {
+              return CJELLY_FORMAT_IMAGE_ERR_IO;
+            }
+            putPaletteColor(row, x, width, palette, (unsigned char)pixel);
+            x++;
+          }
+          if (n & 1) {
+            // Padding byte.
+            readByte(&cursor, end);
           }
-          x += (unsigned char)dx;
-          y += (unsigned char)dy;
         }
         else {
-          // Absolute mode.
-          int n = value;
-          if (mode == 8) {
-            // RLE8 absolute mode.
-            // In RLE8 absolute mode, that many 8‑bit color indices are read
-            // directly. If the count is odd, a padding byte is added.
-            for (int i = 0; i < n; ++i) {
-              int pixel = fgetc(fp);
-              if (pixel == EOF) {
-                err = CJELLY_FORMAT_IMAGE_ERR_IO;
-                goto ERROR_FREE_PALETTE;
-              }
-              if (x < width) {
-                unsigned char * dest = bmpImage->base.raw->data + destOffset + (x * 3);
-                dest[0] = palette[(unsigned char)pixel].rgbRed;
-                dest[1] = palette[(unsigned char)pixel].rgbGreen;
-                dest[2] = palette[(unsigned char)pixel].rgbBlue;
+          // RLE4 absolute mode.
+          // In RLE4 absolute mode, the literal data is stored as packed
+          // nibbles (two per byte); if the count is odd, an extra nibble
+          // (or pad byte) is included to maintain word alignment.
+          for (int i = 0; i < n; ++i) {
+            if ((i & 1) == 0) {
+              // Read a new byte.
+              int byteVal = readByte(&cursor, end);
+              if (byteVal == EOF) {
+                return CJELLY_FORMAT_IMAGE_ERR_IO;
               }
+
+              // Process the high nibble.
+              putPaletteColor(row, x, width, palette, (unsigned char)((byteVal >> 4) & 0x0F));
               x++;
-            }
-            if (n & 1) {
-              // Padding byte.
-              fgetc(fp);
-            }
-          }
-          else {
-            // RLE4 absolute mode.
-            // In RLE4 absolute mode, the literal data is stored as packed
-            // nibbles (two per byte); if the count is odd, an extra nibble
-            // (or pad byte) is included to maintain word alignment.
-            for (int i = 0; i < n; ++i) {
-              if ((i & 1) == 0) {
-                // Read a new byte.
-                int byteVal = fgetc(fp);
-                if (byteVal == EOF) {
-                  err = CJELLY_FORMAT_IMAGE_ERR_IO;
-                  goto ERROR_FREE_PALETTE;
-                }
-
-                // Process the high nibble.
-                unsigned char nibble = (unsigned char)((byteVal >> 4) & 0x0F);
-                if (x < width) {
-                  unsigned char *dest = bmpImage->base.raw->data + destOffset + (x * 3);
-                  dest[0] = palette[nibble].rgbRed;
-                  dest[1] = palette[nibble].rgbGreen;
-                  dest[2] = palette[nibble].rgbBlue;
-                }
-                x++;
 
-                if (i + 1 < n) {
-                  // There are more nibbles to process.
-                  // Process the low nibble.
-                  unsigned char nibble2 = (unsigned char)(byteVal & 0x0F);
-                  if (x < width) {
-                    unsigned char *dest = bmpImage->base.raw->data + destOffset + (x * 3);
-                    dest[0] = palette[nibble2].rgbRed;
-                    dest[1] = palette[nibble2].rgbGreen;
-                    dest[2] = palette[nibble2].rgbBlue;
-                  }
-                  x++;
-                }
+              if (i + 1 < n) {
+                // There are more nibbles to process.
+                // Process the low nibble.
+                putPaletteColor(row, x, width, palette, (unsigned char)(byteVal & 0x0F));
+                x++;
               }
             }
-            if (n & 1) {
-              // Padding byte.
-              fgetc(fp);
-            }
+          }
+          if (n & 1) {
+            // Padding byte.
+            readByte(&cursor, end);
           }
         }
       }
     }
-    free(palette);
+  }
+  return CJELLY_FORMAT_IMAGE_SUCCESS;
+}
+
+CJellyFormatImageError cjelly_format_image_bmp_load_rgba_memory(const void * data, size_t size,
+    const CJellyFormatImageTarget * target, int * out_width, int * out_height) {
+  if (!target || !target->acquire) {
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
   }
 
-  // If we're here, then we don't know how to interpret the BMP.
-  else {
-    err = CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
-    goto ERROR_FREE_BASE_RAW;
+  // Parse the headers before asking for memory.
+  CJellyFormatImageBMPInfo info;
+  CJellyFormatImageError err = cjelly_format_image_bmp_parse(data, size, &info);
+  if (err != CJELLY_FORMAT_IMAGE_SUCCESS) {
+    return err;
   }
 
-  fclose(fp);
-  *out_image = (CJellyFormatImage *)bmpImage;
+  // Get the destination for the decoded pixels and decode into it.
+  size_t destStride = 0;
+  unsigned char * dest = target->acquire(target->user, info.width, info.height, &destStride);
+  if (!dest) {
+    return CJELLY_FORMAT_IMAGE_ERR_OUT_OF_MEMORY;
+  }
+  err = cjelly_format_image_bmp_decode(&info, dest, destStride);
+  if (err != CJELLY_FORMAT_IMAGE_SUCCESS) {
+    return err;
+  }
+
+  if (out_width) {
+    *out_width = info.width;
+  }
+  if (out_height) {
+    *out_height = info.height;
+  }
   return CJELLY_FORMAT_IMAGE_SUCCESS;
+}
+
+CJellyFormatImageError cjelly_format_image_bmp_load_rgba(const char * filename,
+    const CJellyFormatImageTarget * target, int * out_width, int * out_height) {
+  // Map the file so that the decoder reads it in place.
+  CJellyFormatImageMapping mapping;
+  CJellyFormatImageError err = cjelly_format_image_map(filename, &mapping);
+  if (err != CJELLY_FORMAT_IMAGE_SUCCESS) {
+    return err;
+  }
+  err = cjelly_format_image_bmp_load_rgba_memory(mapping.data, mapping.size, target, out_width, out_height);
+  cjelly_format_image_unmap(&mapping);
+  return err;
+}
+
+// Target for cjelly_format_image_bmp_load(): decodes into a new buffer owned
+// by the image.
+static unsigned char * acquireRawImage(void * user, int width, int height, size_t * stride) {
+  CJellyFormatImageRaw * raw = (CJellyFormatImageRaw *)user;
+  size_t dataSize = (size_t)width * (size_t)height * 4;
+  raw->data = (unsigned char *)malloc(dataSize);
+  if (!raw->data) {
+    return NULL;
+  }
+  raw->width = width;
+  raw->height = height;
+  raw->channels = 4;
+  raw->bitdepth = 32;
+  raw->data_size = dataSize;
+  *stride = (size_t)width * 4;
+  return raw->data;
+}
+
+CJellyFormatImageError cjelly_format_image_bmp_load(const char * filename, CJellyFormatImage * * out_image) {
+  CJellyFormatImageError err = CJELLY_FORMAT_IMAGE_SUCCESS;
+
+  // Validate input parameters.
+  if (!filename || !out_image) {
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  }
+  *out_image = NULL;
 
-ERROR_FREE_ROWBUFFER:
-  free(rowBuffer);
-ERROR_FREE_PALETTE:
-  if (palette) {
-    free(palette);
+  // Allocate the BMP image structure.
+  CJellyFormatImageBMP * bmpImage = (CJellyFormatImageBMP *)malloc(sizeof(CJellyFormatImageBMP));
+  if (!bmpImage) {
+    goto ERROR_RETURN;
   }
+  memset(bmpImage, 0, sizeof(CJellyFormatImageBMP));
+  bmpImage->base.type = CJELLY_FORMAT_IMAGE_BMP;
+
+  // Allocate the raw image data structure.
+  bmpImage->base.raw = (CJellyFormatImageRaw *)malloc(sizeof(CJellyFormatImageRaw));
+  if (!bmpImage->base.raw) {
+    goto ERROR_FREE_BMP_IMAGE;
+  }
+  memset(bmpImage->base.raw, 0, sizeof(CJellyFormatImageRaw));
+
+  // Decode into a buffer sized from the header.
+  CJellyFormatImageTarget target = { acquireRawImage, bmpImage->base.raw };
+  err = cjelly_format_image_bmp_load_rgba(filename, &target, NULL, NULL);
+  if (err != CJELLY_FORMAT_IMAGE_SUCCESS) {
+    goto ERROR_FREE_BASE_RAW_DATA;
+  }
+
+  *out_image = (CJellyFormatImage *)bmpImage;
+  return CJELLY_FORMAT_IMAGE_SUCCESS;
+
 ERROR_FREE_BASE_RAW_DATA:
   free(bmpImage->base.raw->data);
-ERROR_FREE_BASE_RAW:
   free(bmpImage->base.raw);
 ERROR_FREE_BMP_IMAGE:
   free(bmpImage);
-ERROR_FILE_CLOSE:
-  fclose(fp);
+ERROR_RETURN:
   if (err == CJELLY_FORMAT_IMAGE_SUCCESS) {
     err = CJELLY_FORMAT_IMAGE_ERR_OUT_OF_MEMORY;
   }
@@ -0,0 +1,542 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cjelly/format/image/convert.h>
+
+// The x86 kernels are compiled with per-function target attributes, so the
+// library still runs on CPUs without the newer extensions.  That requires
+// GCC or Clang; other compilers get the portable kernels on x86.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CONVERT_X86 1
+#include <immintrin.h>
+#define CONVERT_TARGET(X) __attribute__((target(X)))
+#endif
+
+// Multi-byte NEON loads assume a little-endian lane order.
+#if defined(__ARM_NEON) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef void (*ConvertRowFn)(const unsigned char * src, unsigned char * dst, size_t width);
+
+// A backend provides one row kernel per source layout.
+typedef struct ConvertBackend {
+  const char * name;
+  ConvertRowFn rows[CJELLY_FORMAT_IMAGE_PIXEL_COUNT];
+} ConvertBackend;
+
+// 5- and 6-bit channels are widened by replicating their top bits, which maps
+// 0 to 0 and the maximum to 255 and matches the SIMD kernels exactly.
+#define EXPAND5(V) ((unsigned char)(((V) << 3) | ((V) >> 2)))
+#define EXPAND6(V) ((unsigned char)(((V) << 2) | ((V) >> 4)))
+
+
+// --- Portable kernels ---
+
+static void copyRowScalar(const unsigned char * src, unsigned char * dst, size_t width) {
+  memcpy(dst, src, width * 4);
+}
+
+static void swizzleBGRARowScalar(const unsigned char * src, unsigned char * dst, size_t width) {
+  for (size_t x = 0; x < width; ++x) {
+    dst[(x * 4) + 0] = src[(x * 4) + 2];
+    dst[(x * 4) + 1] = src[(x * 4) + 1];
+    dst[(x * 4) + 2] = src[(x * 4) + 0];
+    dst[(x * 4) + 3] = src[(x * 4) + 3];
+  }
+}
+
+static void expandRGBRowScalar(const unsigned char * src, unsigned char * dst, size_t width) {
+  for (size_t x = 0; x < width; ++x) {
+    dst[(x * 4) + 0] = src[(x * 3) + 0];
+    dst[(x * 4) + 1] = src[(x * 3) + 1];
+    dst[(x * 4) + 2] = src[(x * 3) + 2];
+    dst[(x * 4) + 3] = 255;
+  }
+}
+
+static void expandBGRRowScalar(const unsigned char * src, unsigned char * dst, size_t width) {
+  for (size_t x = 0; x < width; ++x) {
+    dst[(x * 4) + 0] = src[(x * 3) + 2];
+    dst[(x * 4) + 1] = src[(x * 3) + 1];
+    dst[(x * 4) + 2] = src[(x * 3) + 0];
+    dst[(x * 4) + 3] = 255;
+  }
+}
+
+static void expand565RowScalar(const unsigned char * src, unsigned char * dst, size_t width) {
+  for (size_t x = 0; x < width; ++x) {
+    unsigned int pixel = (unsigned int)src[x * 2] | ((unsigned int)src[(x * 2) + 1] << 8);
+    unsigned int r = (pixel >> 11) & 0x1F;
+    unsigned int g = (pixel >> 5) & 0x3F;
+    unsigned int b = pixel & 0x1F;
+    dst[(x * 4) + 0] = EXPAND5(r);
+    dst[(x * 4) + 1] = EXPAND6(g);
+    dst[(x * 4) + 2] = EXPAND5(b);
+    dst[(x * 4) + 3] = 255;
+  }
+}
+
+static void expand555RowScalar(const unsigned char * src, unsigned char * dst, size_t width) {
+  for (size_t x = 0; x < width; ++x) {
+    unsigned int pixel = (unsigned int)src[x * 2] | ((unsigned int)src[(x * 2) + 1] << 8);
+    unsigned int r = (pixel >> 10) & 0x1F;
+    unsigned int g = (pixel >> 5) & 0x1F;
+    unsigned int b = pixel & 0x1F;
+    dst[(x * 4) + 0] = EXPAND5(r);
+    dst[(x * 4) + 1] = EXPAND5(g);
+    dst[(x * 4) + 2] = EXPAND5(b);
+    dst[(x * 4) + 3] = 255;
+  }
+}
+
+static const ConvertBackend scalarBackend = {
+  "scalar",
+  {
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGBA32] = copyRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGRA32] = swizzleBGRARowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB24]  = expandRGBRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGR24]  = expandBGRRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB565] = expand565RowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB555] = expand555RowScalar,
+  },
+};
+
+
+// --- x86 kernels ---
+
+#ifdef CONVERT_X86
+
+// Interleaves 16-bit R|G<<8 and B|A<<8 lanes into RGBA pixels and stores 8 of them.
+CONVERT_TARGET("sse2")
+static inline void storeRGBA16SSE2(unsigned char * dst, __m128i r, __m128i g, __m128i b) {
+  __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+  __m128i ba = _mm_or_si128(b, _mm_set1_epi16((short)0xFF00));
+  _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(rg, ba));
+  _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(rg, ba));
+}
+
+CONVERT_TARGET("sse2")
+static void swizzleBGRARowSSE2(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m128i rbMask = _mm_set1_epi32(0x00FF00FF);
+  size_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + (x * 4)));
+    __m128i rb = _mm_and_si128(v, rbMask);
+    __m128i ga = _mm_andnot_si128(rbMask, v);
+    rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+    _mm_storeu_si128((__m128i *)(dst + (x * 4)), _mm_or_si128(rb, ga));
+  }
+  swizzleBGRARowScalar(src + (x * 4), dst + (x * 4), width - x);
+}
+
+CONVERT_TARGET("sse2")
+static void expand565RowSSE2(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m128i mask5 = _mm_set1_epi16(0x1F);
+  const __m128i mask6 = _mm_set1_epi16(0x3F);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i p = _mm_loadu_si128((const __m128i *)(src + (x * 2)));
+    __m128i r = _mm_srli_epi16(p, 11);
+    __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), mask6);
+    __m128i b = _mm_and_si128(p, mask5);
+    r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+    g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+    b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+    storeRGBA16SSE2(dst + (x * 4), r, g, b);
+  }
+  expand565RowScalar(src + (x * 2), dst + (x * 4), width - x);
+}
+
+CONVERT_TARGET("sse2")
+static void expand555RowSSE2(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m128i mask5 = _mm_set1_epi16(0x1F);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i p = _mm_loadu_si128((const __m128i *)(src + (x * 2)));
+    __m128i r = _mm_and_si128(_mm_srli_epi16(p, 10), mask5);
+    __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), mask5);
+    __m128i b = _mm_and_si128(p, mask5);
+    r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+    g = _mm_or_si128(_mm_slli_epi16(g, 3), _mm_srli_epi16(g, 2));
+    b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+    storeRGBA16SSE2(dst + (x * 4), r, g, b);
+  }
+  expand555RowScalar(src + (x * 2), dst + (x * 4), width - x);
+}
+
+// 24-bit expansion needs a byte shuffle, which SSE2 lacks.
+static const ConvertBackend sse2Backend = {
+  "sse2",
+  {
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGBA32] = copyRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGRA32] = swizzleBGRARowSSE2,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB24]  = expandRGBRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGR24]  = expandBGRRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB565] = expand565RowSSE2,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB555] = expand555RowSSE2,
+  },
+};
+
+// Splits 48 bytes of packed 24-bit pixels into four vectors that each start
+// with 4 whole pixels (12 bytes), without reading past the 48 bytes.
+CONVERT_TARGET("ssse3")
+static inline void load24SSSE3(const unsigned char * src, __m128i out[4]) {
+  __m128i a = _mm_loadu_si128((const __m128i *)src);
+  __m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+  __m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+  out[0] = a;
+  out[1] = _mm_alignr_epi8(b, a, 12);
+  out[2] = _mm_alignr_epi8(c, b, 8);
+  out[3] = _mm_srli_si128(c, 4);
+}
+
+CONVERT_TARGET("ssse3")
+static inline void expand24RowSSSE3(const unsigned char * src, unsigned char * dst, size_t width,
+    __m128i shuffle, ConvertRowFn tail) {
+  const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i v[4];
+    load24SSSE3(src + (x * 3), v);
+    for (int i = 0; i < 4; ++i) {
+      __m128i rgba = _mm_or_si128(_mm_shuffle_epi8(v[i], shuffle), alpha);
+      _mm_storeu_si128((__m128i *)(dst + (x * 4) + (i * 16)), rgba);
+    }
+  }
+  tail(src + (x * 3), dst + (x * 4), width - x);
+}
+
+CONVERT_TARGET("ssse3")
+static void expandRGBRowSSSE3(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  expand24RowSSSE3(src, dst, width, shuffle, expandRGBRowScalar);
+}
+
+CONVERT_TARGET("ssse3")
+static void expandBGRRowSSSE3(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+  expand24RowSSSE3(src, dst, width, shuffle, expandBGRRowScalar);
+}
+
+CONVERT_TARGET("ssse3")
+static void swizzleBGRARowSSSE3(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  size_t x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(src + (x * 4)));
+    _mm_storeu_si128((__m128i *)(dst + (x * 4)), _mm_shuffle_epi8(v, shuffle));
+  }
+  swizzleBGRARowScalar(src + (x * 4), dst + (x * 4), width - x);
+}
+
+static const ConvertBackend ssse3Backend = {
+  "ssse3",
+  {
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGBA32] = copyRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGRA32] = swizzleBGRARowSSSE3,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB24]  = expandRGBRowSSSE3,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGR24]  = expandBGRRowSSSE3,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB565] = expand565RowSSE2,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB555] = expand555RowSSE2,
+  },
+};
+
+// AVX2 shuffles and unpacks work within 128-bit lanes, so pixel groups are
+// paired up per lane and the 16-bit results are put back in order afterwards.
+CONVERT_TARGET("avx2")
+static inline void expand24RowAVX2(const unsigned char * src, unsigned char * dst, size_t width,
+    __m256i shuffle, ConvertRowFn tail) {
+  const __m256i alpha = _mm256_set1_epi32((int)0xFF000000u);
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i v[4];
+    load24SSSE3(src + (x * 3), v);
+    __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(v[0]), v[1], 1);
+    __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(v[2]), v[3], 1);
+    lo = _mm256_or_si256(_mm256_shuffle_epi8(lo, shuffle), alpha);
+    hi = _mm256_or_si256(_mm256_shuffle_epi8(hi, shuffle), alpha);
+    _mm256_storeu_si256((__m256i *)(dst + (x * 4)), lo);
+    _mm256_storeu_si256((__m256i *)(dst + (x * 4) + 32), hi);
+  }
+  tail(src + (x * 3), dst + (x * 4), width - x);
+}
+
+CONVERT_TARGET("avx2")
+static void expandRGBRowAVX2(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m256i shuffle = _mm256_setr_epi8(
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+      0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  expand24RowAVX2(src, dst, width, shuffle, expandRGBRowScalar);
+}
+
+CONVERT_TARGET("avx2")
+static void expandBGRRowAVX2(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m256i shuffle = _mm256_setr_epi8(
+      2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+      2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+  expand24RowAVX2(src, dst, width, shuffle, expandBGRRowScalar);
+}
+
+CONVERT_TARGET("avx2")
+static void swizzleBGRARowAVX2(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m256i shuffle = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(src + (x * 4)));
+    _mm256_storeu_si256((__m256i *)(dst + (x * 4)), _mm256_shuffle_epi8(v, shuffle));
+  }
+  swizzleBGRARowScalar(src + (x * 4), dst + (x * 4), width - x);
+}
+
+CONVERT_TARGET("avx2")
+static inline void storeRGBA16AVX2(unsigned char * dst, __m256i r, __m256i g, __m256i b) {
+  __m256i rg = _mm256_or_si256(r, _mm256_slli_epi16(g, 8));
+  __m256i ba = _mm256_or_si256(b, _mm256_set1_epi16((short)0xFF00));
+  __m256i lo = _mm256_unpacklo_epi16(rg, ba);  // Pixels 0-3 and 8-11.
+  __m256i hi = _mm256_unpackhi_epi16(rg, ba);  // Pixels 4-7 and 12-15.
+  _mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(lo, hi, 0x20));
+  _mm256_storeu_si256((__m256i *)(dst + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+CONVERT_TARGET("avx2")
+static void expand565RowAVX2(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m256i mask5 = _mm256_set1_epi16(0x1F);
+  const __m256i mask6 = _mm256_set1_epi16(0x3F);
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i p = _mm256_loadu_si256((const __m256i *)(src + (x * 2)));
+    __m256i r = _mm256_srli_epi16(p, 11);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 5), mask6);
+    __m256i b = _mm256_and_si256(p, mask5);
+    r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+    g = _mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4));
+    b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+    storeRGBA16AVX2(dst + (x * 4), r, g, b);
+  }
+  expand565RowSSE2(src + (x * 2), dst + (x * 4), width - x);
+}
+
+CONVERT_TARGET("avx2")
+static void expand555RowAVX2(const unsigned char * src, unsigned char * dst, size_t width) {
+  const __m256i mask5 = _mm256_set1_epi16(0x1F);
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i p = _mm256_loadu_si256((const __m256i *)(src + (x * 2)));
+    __m256i r = _mm256_and_si256(_mm256_srli_epi16(p, 10), mask5);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi16(p, 5), mask5);
+    __m256i b = _mm256_and_si256(p, mask5);
+    r = _mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2));
+    g = _mm256_or_si256(_mm256_slli_epi16(g, 3), _mm256_srli_epi16(g, 2));
+    b = _mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2));
+    storeRGBA16AVX2(dst + (x * 4), r, g, b);
+  }
+  expand555RowSSE2(src + (x * 2), dst + (x * 4), width - x);
+}
+
+static const ConvertBackend avx2Backend = {
+  "avx2",
+  {
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGBA32] = copyRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGRA32] = swizzleBGRARowAVX2,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB24]  = expandRGBRowAVX2,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGR24]  = expandBGRRowAVX2,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB565] = expand565RowAVX2,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB555] = expand555RowAVX2,
+  },
+};
+
+#endif // CONVERT_X86
+
+
+// --- NEON kernels ---
+
+#ifdef CONVERT_NEON
+
+static void swizzleBGRARowNEON(const unsigned char * src, unsigned char * dst, size_t width) {
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x4_t bgra = vld4q_u8(src + (x * 4));
+    uint8x16x4_t rgba = {{ bgra.val[2], bgra.val[1], bgra.val[0], bgra.val[3] }};
+    vst4q_u8(dst + (x * 4), rgba);
+  }
+  swizzleBGRARowScalar(src + (x * 4), dst + (x * 4), width - x);
+}
+
+static void expandRGBRowNEON(const unsigned char * src, unsigned char * dst, size_t width) {
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x3_t rgb = vld3q_u8(src + (x * 3));
+    uint8x16x4_t rgba = {{ rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255) }};
+    vst4q_u8(dst + (x * 4), rgba);
+  }
+  expandRGBRowScalar(src + (x * 3), dst + (x * 4), width - x);
+}
+
+static void expandBGRRowNEON(const unsigned char * src, unsigned char * dst, size_t width) {
+  size_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x16x3_t bgr = vld3q_u8(src + (x * 3));
+    uint8x16x4_t rgba = {{ bgr.val[2], bgr.val[1], bgr.val[0], vdupq_n_u8(255) }};
+    vst4q_u8(dst + (x * 4), rgba);
+  }
+  expandBGRRowScalar(src + (x * 3), dst + (x * 4), width - x);
+}
+
+static inline uint8x8_t expand5NEON(uint16x8_t v) {
+  return vmovn_u16(vorrq_u16(vshlq_n_u16(v, 3), vshrq_n_u16(v, 2)));
+}
+
+static void expand565RowNEON(const unsigned char * src, unsigned char * dst, size_t width) {
+  const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+  const uint16x8_t mask6 = vdupq_n_u16(0x3F);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint16x8_t p = vreinterpretq_u16_u8(vld1q_u8(src + (x * 2)));
+    uint16x8_t g = vandq_u16(vshrq_n_u16(p, 5), mask6);
+    uint8x8x4_t rgba = {{
+      expand5NEON(vshrq_n_u16(p, 11)),
+      vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4))),
+      expand5NEON(vandq_u16(p, mask5)),
+      vdup_n_u8(255),
+    }};
+    vst4_u8(dst + (x * 4), rgba);
+  }
+  expand565RowScalar(src + (x * 2), dst + (x * 4), width - x);
+}
+
+static void expand555RowNEON(const unsigned char * src, unsigned char * dst, size_t width) {
+  const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+  size_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    uint16x8_t p = vreinterpretq_u16_u8(vld1q_u8(src + (x * 2)));
+    uint8x8x4_t rgba = {{
+      expand5NEON(vandq_u16(vshrq_n_u16(p, 10), mask5)),
+      expand5NEON(vandq_u16(vshrq_n_u16(p, 5), mask5)),
+      expand5NEON(vandq_u16(p, mask5)),
+      vdup_n_u8(255),
+    }};
+    vst4_u8(dst + (x * 4), rgba);
+  }
+  expand555RowScalar(src + (x * 2), dst + (x * 4), width - x);
+}
+
+static const ConvertBackend neonBackend = {
+  "neon",
+  {
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGBA32] = copyRowScalar,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGRA32] = swizzleBGRARowNEON,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB24]  = expandRGBRowNEON,
+    [CJELLY_FORMAT_IMAGE_PIXEL_BGR24]  = expandBGRRowNEON,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB565] = expand565RowNEON,
+    [CJELLY_FORMAT_IMAGE_PIXEL_RGB555] = expand555RowNEON,
+  },
+};
+
+#endif // CONVERT_NEON
+
+
+// --- Dispatch ---
+
+// Fills `out` with the backends this CPU can run, best first.
+static size_t supportedBackends(const ConvertBackend * * out) {
+  size_t count = 0;
+#ifdef CONVERT_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    out[count++] = &avx2Backend;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    out[count++] = &ssse3Backend;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    out[count++] = &sse2Backend;
+  }
+#endif
+#ifdef CONVERT_NEON
+  out[count++] = &neonBackend;
+#endif
+  out[count++] = &scalarBackend;
+  return count;
+}
+
+static const ConvertBackend * selectBackend(void) {
+  const ConvertBackend * backends[5];
+  size_t count = supportedBackends(backends);
+  const char * forced = getenv("CJELLY_PIXEL_CONVERT");
+  if (forced) {
+    for (size_t i = 0; i < count; ++i) {
+      if (strcmp(forced, backends[i]->name) == 0) {
+        return backends[i];
+      }
+    }
+  }
+  return backends[0];
+}
+
+// Loaders may run on several threads; they all resolve to the same backend,
+// so a race on first use only repeats the selection.
+static _Atomic(const ConvertBackend *) activeBackend;
+
+static const ConvertBackend * getBackend(void) {
+  const ConvertBackend * backend = atomic_load_explicit(&activeBackend, memory_order_acquire);
+  if (!backend) {
+    backend = selectBackend();
+    atomic_store_explicit(&activeBackend, backend, memory_order_release);
+  }
+  return backend;
+}
+
+size_t cjelly_format_image_pixel_size(CJellyFormatImagePixel layout) {
+  switch (layout) {
+    case CJELLY_FORMAT_IMAGE_PIXEL_RGBA32:
+    case CJELLY_FORMAT_IMAGE_PIXEL_BGRA32:
+      return 4;
+    case CJELLY_FORMAT_IMAGE_PIXEL_RGB24:
+    case CJELLY_FORMAT_IMAGE_PIXEL_BGR24:
+      return 3;
+    case CJELLY_FORMAT_IMAGE_PIXEL_RGB565:
+    case CJELLY_FORMAT_IMAGE_PIXEL_RGB555:
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+void cjelly_format_image_convert_row(CJellyFormatImagePixel layout,
+    const unsigned char * src, unsigned char * dst, size_t width) {
+  if ((unsigned)layout >= CJELLY_FORMAT_IMAGE_PIXEL_COUNT) {
+    return;
+  }
+  getBackend()->rows[layout](src, dst, width);
+}
+
+void cjelly_format_image_convert(CJellyFormatImagePixel layout,
+    const unsigned char * src, size_t src_stride,
+    unsigned char * dst, size_t dst_stride,
+    size_t width, size_t height, bool flip) {
+  if ((unsigned)layout >= CJELLY_FORMAT_IMAGE_PIXEL_COUNT || !height) {
+    return;
+  }
+
+  // Contiguous copies need no per-row work.
+  if (layout == CJELLY_FORMAT_IMAGE_PIXEL_RGBA32 && !flip
+      && src_stride == width * 4 && dst_stride == width * 4) {
+    memcpy(dst, src, width * 4 * height);
+    return;
+  }
+
+  ConvertRowFn row = getBackend()->rows[layout];
+  for (size_t y = 0; y < height; ++y) {
+    size_t destRow = flip ? (height - 1) - y : y;
+    row(src + (y * src_stride), dst + (destRow * dst_stride), width);
+  }
+}
+
+const char * cjelly_format_image_convert_backend(void) {
+  return getBackend()->name;
+}
@@ -0,0 +1,135 @@
+#include <stdint.h>
+#include <string.h>
+#include <cjelly/format/image/ktx2.h>
+
+// The file identifier: «KTX 20», then line ending and EOF bytes that catch
+// transfers which translate text.
+static const unsigned char ktx2Identifier[12] = {
+  0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+// Offsets of the header fields, which are little-endian.
+enum {
+  KTX2_VK_FORMAT = 12,
+  KTX2_TYPE_SIZE = 16,
+  KTX2_PIXEL_WIDTH = 20,
+  KTX2_PIXEL_HEIGHT = 24,
+  KTX2_PIXEL_DEPTH = 28,
+  KTX2_LAYER_COUNT = 32,
+  KTX2_FACE_COUNT = 36,
+  KTX2_LEVEL_COUNT = 40,
+  KTX2_SUPERCOMPRESSION = 44,
+  KTX2_DFD_OFFSET = 48,
+  KTX2_DFD_LENGTH = 52,
+  KTX2_LEVEL_INDEX = 80,   // After the key/value and supercompression global data ranges
+  KTX2_LEVEL_ENTRY = 24,   // byteOffset, byteLength and uncompressedByteLength
+};
+
+// Khronos data format descriptor values read from the basic descriptor block.
+enum {
+  KTX2_DFD_COLOR_MODEL = 12,     // From the start of the descriptor, past its total size and block header
+  KTX2_DFD_TRANSFER = 14,
+  KTX2_DFD_MODEL_ETC1S = 163,
+  KTX2_DFD_MODEL_UASTC = 166,
+  KTX2_DFD_TRANSFER_SRGB = 2,
+};
+
+// Helper: read little-endian integers.
+static inline uint32_t readU32(const unsigned char * p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t readU64(const unsigned char * p) {
+  return (uint64_t)readU32(p) | ((uint64_t)readU32(p + 4) << 32);
+}
+
+
+CJellyFormatImageError cjelly_format_image_ktx2_parse(const void * data, size_t size, CJellyFormatImageKTX2Info * out_info) {
+  if (!data || !out_info) return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  memset(out_info, 0, sizeof(*out_info));
+  const unsigned char * bytes = (const unsigned char *)data;
+
+  if (size < sizeof(ktx2Identifier) || memcmp(bytes, ktx2Identifier, sizeof(ktx2Identifier)) != 0) {
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  }
+  if (size < KTX2_LEVEL_INDEX) return CJELLY_FORMAT_IMAGE_ERR_IO;
+
+  CJellyFormatImageKTX2Info info;
+  memset(&info, 0, sizeof(info));
+  info.vk_format = readU32(bytes + KTX2_VK_FORMAT);
+  info.type_size = readU32(bytes + KTX2_TYPE_SIZE);
+  info.width = readU32(bytes + KTX2_PIXEL_WIDTH);
+  info.height = readU32(bytes + KTX2_PIXEL_HEIGHT);
+  info.depth = readU32(bytes + KTX2_PIXEL_DEPTH);
+  info.layers = readU32(bytes + KTX2_LAYER_COUNT);
+  info.faces = readU32(bytes + KTX2_FACE_COUNT);
+  info.levels = readU32(bytes + KTX2_LEVEL_COUNT);
+  info.supercompression = readU32(bytes + KTX2_SUPERCOMPRESSION);
+
+  // Zero counts stand for 1 (or, for levels, a chain to generate).
+  if (info.height == 0) info.height = 1;
+  if (info.depth == 0) info.depth = 1;
+  if (info.layers == 0) info.layers = 1;
+  if (info.levels == 0) {
+    info.generate_mips = true;
+    info.levels = 1;
+  }
+  if (info.width == 0 || info.levels > CJELLY_FORMAT_IMAGE_KTX2_MAX_LEVELS ||
+      (info.faces != 1 && info.faces != 6) || (info.faces == 6 && info.width != info.height) ||
+      info.supercompression > CJELLY_FORMAT_IMAGE_KTX2_SUPERCOMPRESSION_ZLIB) {
+    return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+  }
+
+  // The color model tells Basis Universal data apart; it has no VkFormat.
+  uint32_t dfdOffset = readU32(bytes + KTX2_DFD_OFFSET);
+  uint32_t dfdLength = readU32(bytes + KTX2_DFD_LENGTH);
+  if (dfdLength > 0) {
+    if (dfdOffset > size || dfdLength > size - dfdOffset) return CJELLY_FORMAT_IMAGE_ERR_IO;
+    if (dfdLength > KTX2_DFD_TRANSFER) {
+      unsigned char model = bytes[dfdOffset + KTX2_DFD_COLOR_MODEL];
+      info.basis = model == KTX2_DFD_MODEL_ETC1S || model == KTX2_DFD_MODEL_UASTC;
+      info.uastc = model == KTX2_DFD_MODEL_UASTC;
+      info.srgb = bytes[dfdOffset + KTX2_DFD_TRANSFER] == KTX2_DFD_TRANSFER_SRGB;
+    }
+  }
+  if (info.vk_format == 0 && !info.basis) return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+
+  // The level index, checked against the span.
+  if ((size - KTX2_LEVEL_INDEX) / KTX2_LEVEL_ENTRY < info.levels) return CJELLY_FORMAT_IMAGE_ERR_IO;
+  uint64_t images = (uint64_t)info.layers * info.faces * info.depth;
+  for (unsigned int i = 0; i < info.levels; ++i) {
+    const unsigned char * entry = bytes + KTX2_LEVEL_INDEX + (size_t)i * KTX2_LEVEL_ENTRY;
+    uint64_t offset = readU64(entry);
+    uint64_t length = readU64(entry + 8);
+    uint64_t uncompressed = readU64(entry + 16);
+    if (offset > size || length > size - offset || length == 0) return CJELLY_FORMAT_IMAGE_ERR_IO;
+    // Without supercompression every image of a level has the same size.
+    if (info.supercompression == CJELLY_FORMAT_IMAGE_KTX2_SUPERCOMPRESSION_NONE &&
+        (length % images != 0 || (uncompressed != 0 && uncompressed != length))) {
+      return CJELLY_FORMAT_IMAGE_ERR_INVALID_FORMAT;
+    }
+    info.level[i].data = bytes + offset;
+    info.level[i].size = (size_t)length;
+    info.level[i].uncompressed_size = (size_t)(uncompressed ? uncompressed : length);
+    if ((uint64_t)info.level[i].uncompressed_size != (uncompressed ? uncompressed : length)) {
+      return CJELLY_FORMAT_IMAGE_ERR_OUT_OF_MEMORY;
+    }
+  }
+
+  *out_info = info;
+  return CJELLY_FORMAT_IMAGE_SUCCESS;
+}
+
+
+const unsigned char * cjelly_format_image_ktx2_image(const CJellyFormatImageKTX2Info * info,
+    unsigned int level, unsigned int layer, unsigned int face, size_t * out_size) {
+  if (out_size) *out_size = 0;
+  if (!info || level >= info->levels || layer >= info->layers || face >= info->faces ||
+      info->supercompression != CJELLY_FORMAT_IMAGE_KTX2_SUPERCOMPRESSION_NONE) {
+    return NULL;
+  }
+  // Checked to divide evenly by cjelly_format_image_ktx2_parse().
+  size_t imageSize = info->level[level].size / ((size_t)info->layers * info->faces);
+  if (out_size) *out_size = imageSize;
+  return info->level[level].data + ((size_t)layer * info->faces + face) * imageSize;
+}
@@ -0,0 +1,176 @@
+/* CJelly frame pacing: precise waits and smoothed frame deltas */
+
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <cjelly/frame_pacer_internal.h>
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+#include <errno.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+/* Bounds of the spin margin; it starts in between and adapts to measured oversleep */
+#define CJ_PACER_MIN_MARGIN_US 100u
+#define CJ_PACER_MAX_MARGIN_US 4000u
+#define CJ_PACER_INITIAL_MARGIN_US 1000u
+
+/* Weight of a new sample in the exponential averages */
+#define CJ_PACER_SMOOTHING 0.2
+
+/* Average lateness of OS sleeps past their requested wake time */
+static double g_oversleep_us = (double)CJ_PACER_INITIAL_MARGIN_US / 2.0;
+
+uint64_t cj_pacer_now_us(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  /* Split to avoid overflowing counter * 1000000 */
+  uint64_t ticks = (uint64_t)counter.QuadPart, freq = (uint64_t)frequency.QuadPart;
+  return (ticks / freq) * 1000000ULL + ((ticks % freq) * 1000000ULL) / freq;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+#endif
+}
+
+uint64_t cj_pacer_spin_margin_us(void) {
+  /* Half again the average lateness leaves room for jitter */
+  double margin = g_oversleep_us * 1.5 + (double)CJ_PACER_MIN_MARGIN_US;
+  if (margin > (double)CJ_PACER_MAX_MARGIN_US) margin = (double)CJ_PACER_MAX_MARGIN_US;
+  return (uint64_t)margin;
+}
+
+#ifdef _WIN32
+/* High-resolution timers (Windows 10 1803+) wake within a fraction of a millisecond;
+ * older systems fall back to a regular waitable timer at the scheduler tick. */
+static HANDLE cj_pacer_timer(void) {
+  static HANDLE timer = NULL;
+  static bool tried = false;
+  if (!tried) {
+    tried = true;
+    timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer) timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    if (!timer) fprintf(stderr, "cj_pacer: no waitable timer, falling back to Sleep\n");
+  }
+  return timer;
+}
+#endif
+
+/* Sleep through the OS until about wake_us; may return early or late */
+static void cj_pacer_os_sleep_until(uint64_t wake_us) {
+#ifdef _WIN32
+  uint64_t now = cj_pacer_now_us();
+  if (wake_us <= now) return;
+  HANDLE timer = cj_pacer_timer();
+  if (timer) {
+    /* Negative due time is relative, in 100 ns units */
+    LARGE_INTEGER due;
+    due.QuadPart = -(LONGLONG)((wake_us - now) * 10ULL);
+    if (SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE)) {
+      WaitForSingleObject(timer, INFINITE);
+      return;
+    }
+  }
+  Sleep((DWORD)((wake_us - now) / 1000ULL));
+#else
+  struct timespec ts;
+  ts.tv_sec = (time_t)(wake_us / 1000000ULL);
+  ts.tv_nsec = (long)((wake_us % 1000000ULL) * 1000ULL);
+  /* Absolute deadline: signals restart the wait without drifting */
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+#endif
+}
+
+void cj_pacer_sleep_until_us(uint64_t deadline_us) {
+  uint64_t now = cj_pacer_now_us();
+  if (deadline_us <= now) return;
+
+  /* Coarse part: the OS wait, ending a margin before the deadline */
+  uint64_t margin = cj_pacer_spin_margin_us();
+  if (deadline_us - now > margin) {
+    uint64_t wake_us = deadline_us - margin;
+    cj_pacer_os_sleep_until(wake_us);
+    now = cj_pacer_now_us();
+    double late = (now > wake_us) ? (double)(now - wake_us) : 0.0;
+    g_oversleep_us += (late - g_oversleep_us) * CJ_PACER_SMOOTHING;
+  }
+
+  /* Fine part: spin on the clock, yielding so other threads keep the core */
+  while (cj_pacer_now_us() < deadline_us) {
+#ifdef _WIN32
+    YieldProcessor();
+#else
+    sched_yield();
+#endif
+  }
+}
+
+double cj_frame_timing_begin(cj_frame_timing_t* timing, uint64_t now_us) {
+  if (!timing) return 0.0;
+  uint64_t last = timing->last_begin_us;
+  timing->last_begin_us = now_us;
+  if (last == 0 || now_us <= last) return 0.0;
+
+  /* The display's cadence is exact where the CPU's is jittery */
+  double raw_s = (double)(now_us - last) / 1e6;
+  if (timing->present_delta_ns > 0) {
+    double present_s = (double)timing->present_delta_ns / 1e9;
+    timing->present_delta_ns = 0;
+    /* Only while the window presents steadily, not after it idled */
+    if (present_s > raw_s * 0.5 && present_s < raw_s * 2.0) raw_s = present_s;
+  }
+
+  /* Vsync-locked frames last whole refresh cycles */
+  if (timing->refresh_ns > 0) {
+    double refresh_s = (double)timing->refresh_ns / 1e9;
+    double cycles = (double)(uint64_t)(raw_s / refresh_s + 0.5);
+    if (cycles >= 1.0 && raw_s > (cycles - 0.1) * refresh_s && raw_s < (cycles + 0.1) * refresh_s) {
+      raw_s = cycles * refresh_s;
+    }
+  }
+
+  double avg = timing->smoothed_delta_s;
+  if (avg <= 0.0 || raw_s > avg * 2.0 || raw_s < avg * 0.5) {
+    timing->smoothed_delta_s = raw_s;
+  } else {
+    timing->smoothed_delta_s = avg + (raw_s - avg) * CJ_PACER_SMOOTHING;
+  }
+  return timing->smoothed_delta_s;
+}
+
+void cj_frame_timing_presented(cj_frame_timing_t* timing, uint32_t present_id, uint64_t actual_present_ns) {
+  if (!timing || actual_present_ns == 0) return;
+  if (timing->last_present_ns != 0 && actual_present_ns > timing->last_present_ns &&
+      present_id > timing->last_present_id) {
+    /* Per frame, in case reports for some presents were never delivered */
+    timing->present_delta_ns = (actual_present_ns - timing->last_present_ns) / (present_id - timing->last_present_id);
+  }
+  timing->last_present_ns = actual_present_ns;
+  timing->last_present_id = present_id;
+}
+
+uint64_t cj_frame_timing_snap_interval_us(const cj_frame_timing_t* timing, uint64_t interval_us) {
+  if (!timing || timing->refresh_ns == 0 || interval_us == 0) return interval_us;
+  uint64_t interval_ns = interval_us * 1000ULL;
+  uint64_t cycles = (interval_ns + timing->refresh_ns / 2) / timing->refresh_ns;
+  if (cycles == 0) return interval_us;
+  uint64_t snapped_ns = cycles * timing->refresh_ns;
+  uint64_t diff = (snapped_ns > interval_ns) ? snapped_ns - interval_ns : interval_ns - snapped_ns;
+  if (diff * 10ULL > interval_ns) return interval_us;
+  return snapped_ns / 1000ULL;
+}
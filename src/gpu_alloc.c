@@ -0,0 +1,396 @@
+/* CJelly GPU memory allocator: block heaps with buddy and linear sub-allocation */
+
+#include <cjelly/gpu_alloc_internal.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Smallest buddy range; smaller requests round up to it */
+#define CJ_GPU_BUDDY_MIN_SHIFT 10u
+#define CJ_GPU_BUDDY_MIN ((VkDeviceSize)1 << CJ_GPU_BUDDY_MIN_SHIFT)
+
+/* Block sizes for large heaps; small heaps (integrated, BAR) use an eighth of their size */
+#define CJ_GPU_BLOCK_SIZE ((VkDeviceSize)64 << 20)
+#define CJ_GPU_LINEAR_BLOCK_SIZE ((VkDeviceSize)4 << 20)
+#define CJ_GPU_MIN_BLOCK_SIZE ((VkDeviceSize)4 << 20)
+
+/* Images this large get memory of their own instead of fragmenting a block */
+#define CJ_GPU_DEDICATED_IMAGE_MIN ((VkDeviceSize)16 << 20)
+
+/* Block lists per memory type; images never share a block with buffers
+ * so bufferImageGranularity never has to be honored inside a block */
+enum { CJ_GPU_POOL_BUFFER = 0, CJ_GPU_POOL_IMAGE = 1, CJ_GPU_POOL_LINEAR = 2, CJ_GPU_POOL_COUNT = 3 };
+
+struct cj_gpu_block_t {
+  cj_gpu_block_t* next;
+  VkDeviceMemory memory;
+  VkDeviceSize size;
+  void* mapped;           /* Whole-block mapping for host-visible types */
+  uint32_t pool;
+  uint32_t live;          /* Allocations currently carved out of the block */
+  VkDeviceSize head;      /* Linear: next free offset */
+  uint32_t max_order;     /* Buddy: log2(size / CJ_GPU_BUDDY_MIN) */
+  uint8_t* tree;          /* Buddy: per node, largest free order in the subtree + 1, 0 if full */
+};
+
+struct cj_gpu_allocator_t {
+  VkDevice device;
+  cj_allocator_t host;
+  VkPhysicalDeviceMemoryProperties props;
+  cj_gpu_block_t* pools[VK_MAX_MEMORY_TYPES][CJ_GPU_POOL_COUNT];
+  cj_memory_stats_t stats;
+  VkDeviceSize heap_reserved[VK_MAX_MEMORY_HEAPS];  /* Device memory obtained per heap */
+  VkDeviceSize heap_used[VK_MAX_MEMORY_HEAPS];      /* Bytes of live allocations per heap */
+};
+
+static void* gpu_host_alloc(const cj_allocator_t* host, size_t size) {
+  void* p = host->alloc ? host->alloc(host->user, size, 16) : malloc(size);
+  if (p) memset(p, 0, size);
+  return p;
+}
+
+static void gpu_host_free(const cj_allocator_t* host, void* p) {
+  if (!p) return;
+  if (host->free) host->free(host->user, p);
+  else free(p);
+}
+
+static uint32_t gpu_log2_ceil(VkDeviceSize v) {
+  uint32_t r = 0;
+  while (((VkDeviceSize)1 << r) < v) r++;
+  return r;
+}
+
+static uint32_t gpu_find_memory_type(const cj_gpu_allocator_t* a, uint32_t bits, VkMemoryPropertyFlags props) {
+  for (uint32_t i = 0; i < a->props.memoryTypeCount; i++) {
+    if ((bits & (1u << i)) && (a->props.memoryTypes[i].propertyFlags & props) == props) return i;
+  }
+  return UINT32_MAX;
+}
+
+static VkDeviceSize gpu_block_size(const cj_gpu_allocator_t* a, uint32_t type, uint32_t pool) {
+  VkDeviceSize heap = a->props.memoryHeaps[a->props.memoryTypes[type].heapIndex].size;
+  VkDeviceSize size = (pool == CJ_GPU_POOL_LINEAR) ? CJ_GPU_LINEAR_BLOCK_SIZE : CJ_GPU_BLOCK_SIZE;
+  while (size > CJ_GPU_MIN_BLOCK_SIZE && size > heap / 8) size >>= 1;
+  return size;
+}
+
+/* One vkAllocateMemory, mapped for its lifetime when host visible */
+static bool gpu_device_alloc(cj_gpu_allocator_t* a, uint32_t type, VkDeviceSize size,
+                             VkDeviceMemory* out_memory, void** out_mapped) {
+  VkMemoryAllocateInfo info = {0};
+  info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  info.allocationSize = size;
+  info.memoryTypeIndex = type;
+  if (vkAllocateMemory(a->device, &info, NULL, out_memory) != VK_SUCCESS) return false;
+
+  *out_mapped = NULL;
+  if (a->props.memoryTypes[type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    if (vkMapMemory(a->device, *out_memory, 0, VK_WHOLE_SIZE, 0, out_mapped) != VK_SUCCESS) {
+      vkFreeMemory(a->device, *out_memory, NULL);
+      *out_memory = VK_NULL_HANDLE;
+      return false;
+    }
+  }
+  a->stats.device_allocations++;
+  a->stats.bytes_reserved += size;
+  a->heap_reserved[a->props.memoryTypes[type].heapIndex] += size;
+  return true;
+}
+
+static void gpu_device_free(cj_gpu_allocator_t* a, uint32_t type, VkDeviceMemory memory, VkDeviceSize size) {
+  vkFreeMemory(a->device, memory, NULL);
+  a->stats.device_allocations--;
+  a->stats.bytes_reserved -= size;
+  a->heap_reserved[a->props.memoryTypes[type].heapIndex] -= size;
+}
+
+static cj_gpu_block_t* gpu_block_create(cj_gpu_allocator_t* a, uint32_t type, uint32_t pool) {
+  cj_gpu_block_t* block = (cj_gpu_block_t*)gpu_host_alloc(&a->host, sizeof(*block));
+  if (!block) return NULL;
+  block->size = gpu_block_size(a, type, pool);
+  block->pool = pool;
+
+  if (pool != CJ_GPU_POOL_LINEAR) {
+    block->max_order = gpu_log2_ceil(block->size) - CJ_GPU_BUDDY_MIN_SHIFT;
+    size_t nodes = (size_t)2 << block->max_order;
+    block->tree = (uint8_t*)gpu_host_alloc(&a->host, nodes);
+    if (!block->tree) {
+      gpu_host_free(&a->host, block);
+      return NULL;
+    }
+    /* Everything free: each node offers its own order */
+    for (uint32_t depth = 0; depth <= block->max_order; depth++) {
+      memset(block->tree + ((size_t)1 << depth), (int)(block->max_order - depth + 1), (size_t)1 << depth);
+    }
+  }
+
+  if (!gpu_device_alloc(a, type, block->size, &block->memory, &block->mapped)) {
+    gpu_host_free(&a->host, block->tree);
+    gpu_host_free(&a->host, block);
+    return NULL;
+  }
+  block->next = a->pools[type][pool];
+  a->pools[type][pool] = block;
+  a->stats.block_count++;
+  return block;
+}
+
+static void gpu_block_destroy(cj_gpu_allocator_t* a, uint32_t type, cj_gpu_block_t* block) {
+  cj_gpu_block_t** link = &a->pools[type][block->pool];
+  while (*link && *link != block) link = &(*link)->next;
+  if (*link) *link = block->next;
+  gpu_device_free(a, type, block->memory, block->size);
+  a->stats.block_count--;
+  gpu_host_free(&a->host, block->tree);
+  gpu_host_free(&a->host, block);
+}
+
+static void gpu_buddy_update_parents(cj_gpu_block_t* block, size_t node, uint32_t order) {
+  while (node > 1) {
+    node >>= 1;
+    order++;
+    uint8_t l = block->tree[node * 2], r = block->tree[node * 2 + 1];
+    /* Two free halves merge back into a free parent */
+    block->tree[node] = (l == order && r == order) ? (uint8_t)(order + 1) : (l > r ? l : r);
+  }
+}
+
+static bool gpu_buddy_alloc(cj_gpu_block_t* block, uint32_t order, VkDeviceSize* out_offset) {
+  if (order > block->max_order || block->tree[1] < order + 1) return false;
+  size_t node = 1;
+  for (uint32_t cur = block->max_order; cur > order; cur--) {
+    node = (block->tree[node * 2] >= order + 1) ? node * 2 : node * 2 + 1;
+  }
+  block->tree[node] = 0;
+  gpu_buddy_update_parents(block, node, order);
+
+  size_t first = (size_t)1 << (block->max_order - order);
+  *out_offset = (VkDeviceSize)(node - first) << (order + CJ_GPU_BUDDY_MIN_SHIFT);
+  return true;
+}
+
+static void gpu_buddy_free(cj_gpu_block_t* block, VkDeviceSize offset, uint32_t order) {
+  size_t first = (size_t)1 << (block->max_order - order);
+  size_t node = first + (size_t)(offset >> (order + CJ_GPU_BUDDY_MIN_SHIFT));
+  block->tree[node] = (uint8_t)(order + 1);
+  gpu_buddy_update_parents(block, node, order);
+}
+
+static bool gpu_linear_alloc(cj_gpu_block_t* block, const VkMemoryRequirements* reqs, VkDeviceSize* out_offset) {
+  VkDeviceSize align = reqs->alignment ? reqs->alignment : 1;
+  VkDeviceSize offset = (block->head + align - 1) / align * align;
+  if (offset + reqs->size > block->size) return false;
+  block->head = offset + reqs->size;
+  *out_offset = offset;
+  return true;
+}
+
+cj_gpu_allocator_t* cj_gpu_allocator_create(VkPhysicalDevice physical, VkDevice device, const cj_allocator_t* host) {
+  cj_allocator_t h = {0};
+  if (host) h = *host;
+  cj_gpu_allocator_t* a = (cj_gpu_allocator_t*)gpu_host_alloc(&h, sizeof(*a));
+  if (!a) return NULL;
+  a->device = device;
+  a->host = h;
+  vkGetPhysicalDeviceMemoryProperties(physical, &a->props);
+  return a;
+}
+
+void cj_gpu_allocator_destroy(cj_gpu_allocator_t* a) {
+  if (!a) return;
+  if (a->stats.allocation_count > 0) {
+    fprintf(stderr, "Warning: %u GPU allocations (%llu bytes) still alive at allocator shutdown\n",
+            a->stats.allocation_count, (unsigned long long)a->stats.bytes_used);
+  }
+  for (uint32_t t = 0; t < VK_MAX_MEMORY_TYPES; t++) {
+    for (uint32_t p = 0; p < CJ_GPU_POOL_COUNT; p++) {
+      while (a->pools[t][p]) gpu_block_destroy(a, t, a->pools[t][p]);
+    }
+  }
+  cj_allocator_t host = a->host;
+  gpu_host_free(&host, a);
+}
+
+bool cj_gpu_alloc(cj_gpu_allocator_t* a, const VkMemoryRequirements* reqs,
+                  VkMemoryPropertyFlags props, uint32_t flags, cj_gpu_alloc_t* out) {
+  if (!out) return false;
+  memset(out, 0, sizeof(*out));
+  if (!a || !reqs || reqs->size == 0) return false;
+
+  uint32_t type = gpu_find_memory_type(a, reqs->memoryTypeBits, props);
+  if (type == UINT32_MAX) {
+    fprintf(stderr, "cj_gpu_alloc: no memory type with properties 0x%x\n", (unsigned)props);
+    return false;
+  }
+
+  uint32_t pool = (flags & CJ_GPU_ALLOC_OPTIMAL) ? CJ_GPU_POOL_IMAGE
+      : (flags & CJ_GPU_ALLOC_LINEAR) ? CJ_GPU_POOL_LINEAR : CJ_GPU_POOL_BUFFER;
+  VkDeviceSize block_size = gpu_block_size(a, type, pool);
+  VkDeviceSize span = reqs->size > reqs->alignment ? reqs->size : reqs->alignment;
+  bool dedicated = (flags & CJ_GPU_ALLOC_DEDICATED) || span > block_size / 2 ||
+      (pool == CJ_GPU_POOL_IMAGE && reqs->size >= CJ_GPU_DEDICATED_IMAGE_MIN);
+
+  out->size = reqs->size;
+  out->memory_type = type;
+
+  if (dedicated) {
+    void* mapped = NULL;
+    if (!gpu_device_alloc(a, type, reqs->size, &out->memory, &mapped)) {
+      fprintf(stderr, "cj_gpu_alloc: vkAllocateMemory failed for %llu bytes\n", (unsigned long long)reqs->size);
+      memset(out, 0, sizeof(*out));
+      return false;
+    }
+    out->mapped = mapped;
+    a->stats.dedicated_count++;
+  } else {
+    uint32_t order = 0;
+    if (pool != CJ_GPU_POOL_LINEAR) {
+      order = gpu_log2_ceil(span);
+      order = order > CJ_GPU_BUDDY_MIN_SHIFT ? order - CJ_GPU_BUDDY_MIN_SHIFT : 0;
+    }
+
+    VkDeviceSize offset = 0;
+    cj_gpu_block_t* block = a->pools[type][pool];
+    for (; block; block = block->next) {
+      bool ok = (pool == CJ_GPU_POOL_LINEAR) ? gpu_linear_alloc(block, reqs, &offset)
+                                             : gpu_buddy_alloc(block, order, &offset);
+      if (ok) break;
+    }
+    if (!block) {
+      block = gpu_block_create(a, type, pool);
+      bool ok = block && ((pool == CJ_GPU_POOL_LINEAR) ? gpu_linear_alloc(block, reqs, &offset)
+                                                       : gpu_buddy_alloc(block, order, &offset));
+      if (!ok) {
+        fprintf(stderr, "cj_gpu_alloc: failed to allocate %llu bytes from a new block\n", (unsigned long long)reqs->size);
+        memset(out, 0, sizeof(*out));
+        return false;
+      }
+    }
+
+    block->live++;
+    out->memory = block->memory;
+    out->offset = offset;
+    out->block = block;
+    out->order = order;
+    out->mapped = block->mapped ? (void*)((char*)block->mapped + offset) : NULL;
+  }
+
+  a->stats.allocation_count++;
+  a->stats.bytes_used += reqs->size;
+  a->heap_used[a->props.memoryTypes[type].heapIndex] += reqs->size;
+  return true;
+}
+
+void cj_gpu_free(cj_gpu_allocator_t* a, cj_gpu_alloc_t* alloc) {
+  if (!a || !alloc || alloc->memory == VK_NULL_HANDLE) return;
+  cj_gpu_block_t* block = alloc->block;
+
+  if (!block) {
+    gpu_device_free(a, alloc->memory_type, alloc->memory, alloc->size);
+    a->stats.dedicated_count--;
+  } else {
+    if (block->pool != CJ_GPU_POOL_LINEAR) gpu_buddy_free(block, alloc->offset, alloc->order);
+    if (--block->live == 0) {
+      block->head = 0;
+      /* Keep one empty block per pool around so alloc/free churn does not hit the driver */
+      for (cj_gpu_block_t* other = a->pools[alloc->memory_type][block->pool]; other; other = other->next) {
+        if (other != block && other->live == 0) {
+          gpu_block_destroy(a, alloc->memory_type, block);
+          break;
+        }
+      }
+    }
+  }
+
+  a->stats.allocation_count--;
+  a->stats.bytes_used -= alloc->size;
+  a->heap_used[a->props.memoryTypes[alloc->memory_type].heapIndex] -= alloc->size;
+  memset(alloc, 0, sizeof(*alloc));
+}
+
+bool cj_gpu_alloc_buffer(cj_gpu_allocator_t* a, VkBuffer buffer,
+                         VkMemoryPropertyFlags props, uint32_t flags, cj_gpu_alloc_t* out) {
+  if (!a || buffer == VK_NULL_HANDLE) return false;
+  VkMemoryRequirements reqs;
+  vkGetBufferMemoryRequirements(a->device, buffer, &reqs);
+  if (!cj_gpu_alloc(a, &reqs, props, flags & ~CJ_GPU_ALLOC_OPTIMAL, out)) return false;
+  if (vkBindBufferMemory(a->device, buffer, out->memory, out->offset) != VK_SUCCESS) {
+    cj_gpu_free(a, out);
+    return false;
+  }
+  return true;
+}
+
+bool cj_gpu_alloc_image(cj_gpu_allocator_t* a, VkImage image,
+                        VkMemoryPropertyFlags props, uint32_t flags, cj_gpu_alloc_t* out) {
+  if (!a || image == VK_NULL_HANDLE) return false;
+  VkMemoryRequirements reqs;
+  vkGetImageMemoryRequirements(a->device, image, &reqs);
+  /* Images are never bump-allocated; linear blocks only hold buffers */
+  if (!cj_gpu_alloc(a, &reqs, props, flags & ~CJ_GPU_ALLOC_LINEAR, out)) return false;
+  if (vkBindImageMemory(a->device, image, out->memory, out->offset) != VK_SUCCESS) {
+    cj_gpu_free(a, out);
+    return false;
+  }
+  return true;
+}
+
+bool cj_gpu_create_buffer(cj_gpu_allocator_t* a, VkDeviceSize size, VkBufferUsageFlags usage,
+                          VkMemoryPropertyFlags props, uint32_t flags,
+                          VkBuffer* out_buffer, cj_gpu_alloc_t* out_alloc) {
+  if (!a || !out_buffer || !out_alloc) return false;
+  *out_buffer = VK_NULL_HANDLE;
+  memset(out_alloc, 0, sizeof(*out_alloc));
+
+  VkBufferCreateInfo info = {0};
+  info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  info.size = size;
+  info.usage = usage;
+  info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+  if (vkCreateBuffer(a->device, &info, NULL, out_buffer) != VK_SUCCESS) {
+    *out_buffer = VK_NULL_HANDLE;
+    return false;
+  }
+  if (!cj_gpu_alloc_buffer(a, *out_buffer, props, flags, out_alloc)) {
+    vkDestroyBuffer(a->device, *out_buffer, NULL);
+    *out_buffer = VK_NULL_HANDLE;
+    return false;
+  }
+  return true;
+}
+
+void cj_gpu_destroy_buffer(cj_gpu_allocator_t* a, VkBuffer* buffer, cj_gpu_alloc_t* alloc) {
+  if (!a) return;
+  if (buffer && *buffer != VK_NULL_HANDLE) {
+    vkDestroyBuffer(a->device, *buffer, NULL);
+    *buffer = VK_NULL_HANDLE;
+  }
+  cj_gpu_free(a, alloc);
+}
+
+void cj_gpu_allocator_stats(const cj_gpu_allocator_t* a, cj_memory_stats_t* out) {
+  if (!out) return;
+  if (!a) {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  *out = a->stats;
+}
+
+const VkPhysicalDeviceMemoryProperties* cj_gpu_allocator_memory_properties(const cj_gpu_allocator_t* a) {
+  return a ? &a->props : NULL;
+}
+
+uint32_t cj_gpu_allocator_heap(const cj_gpu_allocator_t* a, uint32_t type_bits, VkMemoryPropertyFlags props) {
+  uint32_t type = a ? gpu_find_memory_type(a, type_bits, props) : UINT32_MAX;
+  return type == UINT32_MAX ? UINT32_MAX : a->props.memoryTypes[type].heapIndex;
+}
+
+void cj_gpu_allocator_heap_usage(const cj_gpu_allocator_t* a, uint32_t heap,
+                                 VkDeviceSize* out_reserved, VkDeviceSize* out_used) {
+  bool valid = a && heap < a->props.memoryHeapCount;
+  if (out_reserved) *out_reserved = valid ? a->heap_reserved[heap] : 0;
+  if (out_used) *out_used = valid ? a->heap_used[heap] : 0;
+}
@@ -0,0 +1,327 @@
+/* CJelly input queue: per-window SPSC event ring with coalescing and an optional input thread */
+
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <cjelly/input_queue_internal.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define CJ_INPUT_QUEUE_MASK (CJ_INPUT_QUEUE_SIZE - 1u)
+
+/* Queue whose input thread this is; NULL on every other thread */
+static _Thread_local const struct cj_input_queue_t* t_thread_queue;
+
+struct cj_input_queue_t {
+  cj_input_event_t events[CJ_INPUT_QUEUE_SIZE];
+  atomic_uint head;              /* Events published by the producer */
+  atomic_uint tail;              /* Events consumed */
+  atomic_uint dropped;           /* Events lost to a full ring */
+  cj_input_deliver_fn_t deliver;
+  void* target;
+
+  /* Merged motion samples of the event being delivered; consumer only */
+  atomic_bool history_enabled;
+  cj_mouse_event_t history[CJ_INPUT_QUEUE_SIZE];
+  uint32_t history_count;
+  uint32_t delivered_count;      /* history_count while a motion event is delivered, else 0 */
+
+  /* Input thread; thread_running is only touched by the thread that owns the queue */
+  bool thread_running;
+#ifdef _WIN32
+  HANDLE thread;
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE wake_cv;
+#else
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake_cv;
+#endif
+  bool notified;                 /* Guarded by lock */
+  bool stop;                     /* Guarded by lock */
+
+  /* A callback destroyed the queue's window; the consumer frees the queue once it returns */
+  bool draining;
+  bool destroy_pending;
+};
+
+static void input_lock(cj_input_queue_t* q) {
+#ifdef _WIN32
+  EnterCriticalSection(&q->lock);
+#else
+  pthread_mutex_lock(&q->lock);
+#endif
+}
+
+static void input_unlock(cj_input_queue_t* q) {
+#ifdef _WIN32
+  LeaveCriticalSection(&q->lock);
+#else
+  pthread_mutex_unlock(&q->lock);
+#endif
+}
+
+static void input_wake(cj_input_queue_t* q) {
+#ifdef _WIN32
+  WakeConditionVariable(&q->wake_cv);
+#else
+  pthread_cond_signal(&q->wake_cv);
+#endif
+}
+
+static bool input_is_motion(const cj_input_event_t* ev) {
+  return ev->kind == CJ_INPUT_MOUSE && ev->u.mouse.type == CJ_MOUSE_MOVE;
+}
+
+/* Only the latest of a run of motion samples (with the same modifiers), sizes or positions matters */
+static bool input_coalesces(const cj_input_event_t* pending, const cj_input_event_t* ev) {
+  if (pending->kind != ev->kind) return false;
+  switch (ev->kind) {
+    case CJ_INPUT_MOUSE:
+      return input_is_motion(pending) && input_is_motion(ev) && pending->u.mouse.modifiers == ev->u.mouse.modifiers;
+    case CJ_INPUT_RESIZE:
+    case CJ_INPUT_MOVE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static bool input_coalescable(const cj_input_event_t* ev) {
+  return input_is_motion(ev) || ev->kind == CJ_INPUT_RESIZE || ev->kind == CJ_INPUT_MOVE;
+}
+
+/* Returns false once a callback destroyed the queue */
+static bool input_deliver(cj_input_queue_t* q, const cj_input_event_t* ev) {
+  q->delivered_count = input_is_motion(ev) ? q->history_count : 0u;
+  q->deliver(q->target, ev);
+  q->delivered_count = 0;
+  q->history_count = 0;
+  return !q->destroy_pending;
+}
+
+/* Deliver every published event, merging runs of coalescable ones. Slots are
+ * released only afterwards, so the producer never overwrites an event being read.
+ * Returns false when a callback destroyed the queue; the caller then frees it. */
+static bool input_drain(cj_input_queue_t* q) {
+  unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+  bool history = atomic_load_explicit(&q->history_enabled, memory_order_relaxed);
+  cj_input_event_t pending;
+  bool has_pending = false;
+  q->history_count = 0;
+  q->draining = true;
+
+  for (; tail != head; tail++) {
+    const cj_input_event_t* ev = &q->events[tail & CJ_INPUT_QUEUE_MASK];
+    if (has_pending && input_coalesces(&pending, ev)) {
+      if (ev->kind == CJ_INPUT_MOUSE) {
+        int32_t dx = pending.u.mouse.dx, dy = pending.u.mouse.dy;
+        pending = *ev;
+        pending.u.mouse.dx += dx;
+        pending.u.mouse.dy += dy;
+      } else {
+        pending = *ev;
+      }
+    } else {
+      if (has_pending && !input_deliver(q, &pending)) return false;
+      has_pending = input_coalescable(ev);
+      if (has_pending) pending = *ev;
+      else if (!input_deliver(q, ev)) return false;
+    }
+    if (history && input_is_motion(ev) && q->history_count < CJ_INPUT_QUEUE_SIZE) {
+      q->history[q->history_count++] = ev->u.mouse;
+    }
+  }
+  if (has_pending && !input_deliver(q, &pending)) return false;
+  q->draining = false;
+  atomic_store_explicit(&q->tail, tail, memory_order_release);
+  return true;
+}
+
+cj_input_queue_t* cj_input_queue_create(cj_input_deliver_fn_t deliver, void* target) {
+  if (!deliver) return NULL;
+  cj_input_queue_t* q = (cj_input_queue_t*)calloc(1, sizeof(*q));
+  if (!q) return NULL;
+  q->deliver = deliver;
+  q->target = target;
+  atomic_init(&q->head, 0u);
+  atomic_init(&q->tail, 0u);
+  atomic_init(&q->dropped, 0u);
+  atomic_init(&q->history_enabled, false);
+#ifdef _WIN32
+  InitializeCriticalSection(&q->lock);
+  InitializeConditionVariable(&q->wake_cv);
+#else
+  pthread_mutex_init(&q->lock, NULL);
+  pthread_cond_init(&q->wake_cv, NULL);
+#endif
+  return q;
+}
+
+static void input_free(cj_input_queue_t* q) {
+#ifdef _WIN32
+  DeleteCriticalSection(&q->lock);
+#else
+  pthread_mutex_destroy(&q->lock);
+  pthread_cond_destroy(&q->wake_cv);
+#endif
+  free(q);
+}
+
+void cj_input_queue_destroy(cj_input_queue_t* q) {
+  if (!q) return;
+  /* Called from a callback: the delivering thread frees the queue when it returns */
+  if (t_thread_queue == q || (!q->thread_running && q->draining)) {
+    q->destroy_pending = true;
+    return;
+  }
+  if (q->thread_running) {
+    /* Drop what is queued rather than deliver it to a window going away */
+    atomic_store_explicit(&q->tail, atomic_load_explicit(&q->head, memory_order_acquire), memory_order_release);
+    cj_input_queue_set_thread(q, false);
+  }
+  input_free(q);
+}
+
+bool cj_input_queue_push(cj_input_queue_t* q, const cj_input_event_t* ev) {
+  if (!q || !ev) return false;
+  unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  unsigned limit = input_is_motion(ev) ? CJ_INPUT_QUEUE_SIZE / 4u * 3u : CJ_INPUT_QUEUE_SIZE;
+  if (head - tail >= limit) {
+    if (atomic_fetch_add_explicit(&q->dropped, 1u, memory_order_relaxed) == 0 && !input_is_motion(ev)) {
+      fprintf(stderr, "cj_input_queue_push: input queue full, dropping events\n");
+    }
+    return false;
+  }
+  q->events[head & CJ_INPUT_QUEUE_MASK] = *ev;
+  atomic_store_explicit(&q->head, head + 1u, memory_order_release);
+  return true;
+}
+
+void cj_input_queue_notify(cj_input_queue_t* q) {
+  if (!q || !q->thread_running) return;
+  input_lock(q);
+  q->notified = true;
+  input_wake(q);
+  input_unlock(q);
+}
+
+void cj_input_queue_dispatch(cj_input_queue_t* q) {
+  if (!q || q->thread_running) return;
+  if (!input_drain(q)) input_free(q);
+}
+
+void cj_input_queue_set_history(cj_input_queue_t* q, bool enabled) {
+  if (q) atomic_store_explicit(&q->history_enabled, enabled, memory_order_relaxed);
+}
+
+uint32_t cj_input_queue_history(const cj_input_queue_t* q, const cj_mouse_event_t** out_samples) {
+  uint32_t count = q ? q->delivered_count : 0u;
+  if (out_samples) *out_samples = count ? q->history : NULL;
+  return count;
+}
+
+bool cj_input_queue_threaded(const cj_input_queue_t* q) {
+  return q && q->thread_running;
+}
+
+bool cj_input_queue_on_thread(const cj_input_queue_t* q) {
+  return q && t_thread_queue == q;
+}
+
+uint32_t cj_input_queue_dropped(const cj_input_queue_t* q) {
+  return q ? atomic_load_explicit(&((cj_input_queue_t*)q)->dropped, memory_order_relaxed) : 0u;
+}
+
+/* Sleep until the producer finishes a batch, deliver it, repeat until stopped */
+static void input_thread_loop(cj_input_queue_t* q) {
+  t_thread_queue = q;
+  for (;;) {
+    input_lock(q);
+    while (!q->notified && !q->stop) {
+#ifdef _WIN32
+      SleepConditionVariableCS(&q->wake_cv, &q->lock, INFINITE);
+#else
+      pthread_cond_wait(&q->wake_cv, &q->lock);
+#endif
+    }
+    bool stop = q->stop;
+    q->notified = false;
+    input_unlock(q);
+
+    if (!input_drain(q)) {
+      /* Nobody joins a thread whose window went away under it */
+#ifdef _WIN32
+      CloseHandle(q->thread);
+#else
+      pthread_detach(q->thread);
+#endif
+      input_free(q);
+      return;
+    }
+    if (stop) return;
+  }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI input_thread_main(LPVOID arg) {
+  input_thread_loop((cj_input_queue_t*)arg);
+  return 0;
+}
+#else
+static void* input_thread_main(void* arg) {
+  input_thread_loop((cj_input_queue_t*)arg);
+  return NULL;
+}
+#endif
+
+bool cj_input_queue_set_thread(cj_input_queue_t* q, bool enabled) {
+  if (!q) return false;
+  if (enabled == q->thread_running) return true;
+
+  if (!enabled) {
+    input_lock(q);
+    q->stop = true;
+    input_wake(q);
+    input_unlock(q);
+#ifdef _WIN32
+    WaitForSingleObject(q->thread, INFINITE);
+    CloseHandle(q->thread);
+#else
+    pthread_join(q->thread, NULL);
+#endif
+    q->thread_running = false;
+    return true;
+  }
+
+  input_lock(q);
+  q->stop = false;
+  q->notified = true;  /* Deliver what is already queued */
+  input_unlock(q);
+#ifdef _WIN32
+  q->thread = CreateThread(NULL, 0, input_thread_main, q, 0, NULL);
+  bool started = q->thread != NULL;
+#else
+  bool started = (pthread_create(&q->thread, NULL, input_thread_main, q) == 0);
+#endif
+  if (!started) {
+    fprintf(stderr, "cj_input_queue_set_thread: could not start the input thread\n");
+    return false;
+  }
+  q->thread_running = true;
+  return true;
+}
@@ -98,7 +98,7 @@ static cj_frame_result_t window3_on_frame(GCJ_MAYBE_UNUSED(cj_window_t* window),
   uint64_t now = getCurrentTimeInMilliseconds();
   if (now - ctx->last_tick_ms >= 50) {
     cj_str_t param_time = {"time_ms", 7};
-    cj_str_t param_blur_intensity = {"blur_intensity", 12};
+    cj_str_t param_blur_intensity = {"blur_intensity", 14};
     cj_rgraph_set_i32(ctx->graph3, param_time, (int32_t)(now % 10000));
 
     float blur_intensity = 0.5f + 0.5f * sin(now * 0.001f);
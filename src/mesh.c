@@ -0,0 +1,61 @@
+/* CJelly GPU meshes: vertex and index buffers filled through the upload queue */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <cjelly/cj_mesh.h>
+#include <cjelly/format/3d/mesh.h>
+
+CJ_API cj_result_t cj_mesh_upload(cj_engine_t* e, const CJellyFormat3dMesh* mesh, cj_mesh_t* out) {
+  if (!out) return CJ_E_INVALID_ARGUMENT;
+  memset(out, 0, sizeof(*out));
+  if (!e || !mesh || mesh->vertex_count == 0 || mesh->index_count == 0 ||
+      (mesh->index_size != 2 && mesh->index_size != 4)) {
+    return CJ_E_INVALID_ARGUMENT;
+  }
+
+  uint64_t vertex_bytes = (uint64_t)mesh->vertex_count * sizeof(CJellyFormat3dMeshVertex);
+  uint64_t index_bytes = (uint64_t)mesh->index_count * mesh->index_size;
+
+  cj_buffer_desc_t desc = {0};
+  desc.size = vertex_bytes;
+  desc.usage = CJ_BUFFER_VERTEX | CJ_BUFFER_TRANSFER_DST;
+  out->vertex_buffer = cj_buffer_create(e, &desc);
+  desc.size = index_bytes;
+  desc.usage = CJ_BUFFER_INDEX | CJ_BUFFER_TRANSFER_DST;
+  out->index_buffer = cj_buffer_create(e, &desc);
+  out->ranges = (cj_mesh_range_t*)malloc(sizeof(cj_mesh_range_t) * (mesh->range_count ? mesh->range_count : 1u));
+  if (out->vertex_buffer.idx == 0 || out->index_buffer.idx == 0 || !out->ranges) {
+    cj_mesh_release(e, out);
+    return CJ_E_OUT_OF_MEMORY;
+  }
+
+  /* Both copies land in the same batch unless the first one fills the staging ring */
+  cj_upload_ticket_t vertex_ticket = cj_upload_buffer(e, out->vertex_buffer, 0, mesh->vertices, vertex_bytes);
+  cj_upload_ticket_t index_ticket = cj_upload_buffer(e, out->index_buffer, 0, mesh->indices, index_bytes);
+  if (vertex_ticket == 0 || index_ticket == 0) {
+    cj_mesh_release(e, out);
+    return CJ_E_OUT_OF_MEMORY;
+  }
+
+  for (uint32_t i = 0; i < mesh->range_count; i++) {
+    out->ranges[i].first_index = mesh->ranges[i].first_index;
+    out->ranges[i].index_count = mesh->ranges[i].index_count;
+    out->ranges[i].material_index = mesh->ranges[i].material_index;
+  }
+  out->range_count = mesh->range_count;
+  out->vertex_count = mesh->vertex_count;
+  out->vertex_stride = (uint32_t)sizeof(CJellyFormat3dMeshVertex);
+  out->index_count = mesh->index_count;
+  out->index_size = mesh->index_size;
+  out->ticket = vertex_ticket > index_ticket ? vertex_ticket : index_ticket;
+  return CJ_SUCCESS;
+}
+
+CJ_API void cj_mesh_release(cj_engine_t* e, cj_mesh_t* mesh) {
+  if (!mesh) return;
+  if (mesh->vertex_buffer.idx != 0) cj_buffer_release(e, mesh->vertex_buffer);
+  if (mesh->index_buffer.idx != 0) cj_buffer_release(e, mesh->index_buffer);
+  free(mesh->ranges);
+  memset(mesh, 0, sizeof(*mesh));
+}
@@ -0,0 +1,375 @@
+/* CJelly offscreen render targets: a ring of images rendered through the engine
+ * render pass, each copied into a mapped host buffer the frame it is drawn */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <cjelly/cj_offscreen.h>
+#include <cjelly/cj_profiler.h>
+#include <cjelly/cj_rgraph.h>
+#include <cjelly/engine_internal.h>
+#include <cjelly/rgraph_internal.h>
+
+/* Time each render may spend destroying released resources */
+#define CJ_OFFSCREEN_GARBAGE_BUDGET_US 500u
+
+typedef struct cj_offscreen_slot_t {
+  VkImage image;
+  cj_gpu_alloc_t image_alloc;
+  VkImageView view;
+  VkFramebuffer framebuffer;
+  VkBuffer readback;            /* VK_NULL_HANDLE without readback */
+  cj_gpu_alloc_t readback_alloc;
+  VkCommandBuffer cmd;
+  VkFence fence;
+  uint64_t frame_index;         /* frame last submitted from this slot, 0 = none */
+} cj_offscreen_slot_t;
+
+struct cj_offscreen_target_t {
+  cj_engine_t* engine;
+  cj_rgraph_t* graph;
+  VkDevice device;
+  VkCommandPool pool;
+  VkExtent2D extent;
+  VkFormat format;              /* engine color format the images were created with */
+  uint32_t texel_size;
+  bool readback;
+  uint32_t slot_count;
+  uint64_t frame_index;
+  cj_offscreen_slot_t slots[CJ_OFFSCREEN_MAX_BUFFERS];
+};
+
+static cj_format_t offscreen_public_format(VkFormat format) {
+  switch (format) {
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB: return CJ_FORMAT_BGRA8_UNORM;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB: return CJ_FORMAT_RGBA8_UNORM;
+    case VK_FORMAT_R16G16B16A16_SFLOAT: return CJ_FORMAT_RGBA16_FLOAT;
+    default: return CJ_FORMAT_UNDEFINED;
+  }
+}
+
+static uint32_t offscreen_texel_size(VkFormat format) {
+  return format == VK_FORMAT_R16G16B16A16_SFLOAT ? 8u : 4u;
+}
+
+/* Wait for every submitted frame; their slots then read as empty */
+static void offscreen_wait_all(cj_offscreen_target_t* t) {
+  for (uint32_t i = 0; i < t->slot_count; ++i) {
+    cj_offscreen_slot_t* s = &t->slots[i];
+    if (s->frame_index && s->fence) vkWaitForFences(t->device, 1, &s->fence, VK_TRUE, UINT64_MAX);
+    s->frame_index = 0;
+  }
+}
+
+static void offscreen_release_images(cj_offscreen_target_t* t) {
+  cj_gpu_allocator_t* gpu = cj_engine_gpu_allocator(t->engine);
+  offscreen_wait_all(t);
+  for (uint32_t i = 0; i < t->slot_count; ++i) {
+    cj_offscreen_slot_t* s = &t->slots[i];
+    if (s->framebuffer) vkDestroyFramebuffer(t->device, s->framebuffer, NULL);
+    if (s->view) vkDestroyImageView(t->device, s->view, NULL);
+    if (s->image) vkDestroyImage(t->device, s->image, NULL);
+    cj_gpu_free(gpu, &s->image_alloc);
+    cj_gpu_destroy_buffer(gpu, &s->readback, &s->readback_alloc);
+    s->framebuffer = VK_NULL_HANDLE;
+    s->view = VK_NULL_HANDLE;
+    s->image = VK_NULL_HANDLE;
+  }
+}
+
+/* Color images compatible with the engine render pass, plus their host buffers */
+static bool offscreen_create_images(cj_offscreen_target_t* t) {
+  cj_gpu_allocator_t* gpu = cj_engine_gpu_allocator(t->engine);
+  t->format = cj_engine_color_format(t->engine);
+  t->texel_size = offscreen_texel_size(t->format);
+  VkDeviceSize bytes = (VkDeviceSize)t->extent.width * t->extent.height * t->texel_size;
+
+  for (uint32_t i = 0; i < t->slot_count; ++i) {
+    cj_offscreen_slot_t* s = &t->slots[i];
+    VkImageCreateInfo ici = {0};
+    ici.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    ici.imageType = VK_IMAGE_TYPE_2D;
+    ici.format = t->format;
+    ici.extent = (VkExtent3D){ t->extent.width, t->extent.height, 1 };
+    ici.mipLevels = 1;
+    ici.arrayLayers = 1;
+    ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ici.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    ici.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(t->device, &ici, NULL, &s->image) != VK_SUCCESS ||
+        !cj_gpu_alloc_image(gpu, s->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, CJ_GPU_ALLOC_OPTIMAL, &s->image_alloc)) {
+      fprintf(stderr, "cj_offscreen: failed to create a %ux%u image\n", t->extent.width, t->extent.height);
+      return false;
+    }
+
+    VkImageViewCreateInfo vci = {0};
+    vci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    vci.image = s->image;
+    vci.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vci.format = t->format;
+    vci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    vci.subresourceRange.levelCount = 1;
+    vci.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(t->device, &vci, NULL, &s->view) != VK_SUCCESS) return false;
+
+    VkFramebufferCreateInfo fci = {0};
+    fci.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fci.renderPass = cj_engine_render_pass(t->engine);
+    fci.attachmentCount = 1;
+    fci.pAttachments = &s->view;
+    fci.width = t->extent.width;
+    fci.height = t->extent.height;
+    fci.layers = 1;
+    if (vkCreateFramebuffer(t->device, &fci, NULL, &s->framebuffer) != VK_SUCCESS) return false;
+
+    if (!t->readback) continue;
+    /* Cached memory reads back far faster; coherent, so no invalidation is needed */
+    VkMemoryPropertyFlags host = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (!cj_gpu_create_buffer(gpu, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, host | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                              0, &s->readback, &s->readback_alloc) &&
+        !cj_gpu_create_buffer(gpu, bytes, VK_BUFFER_USAGE_TRANSFER_DST_BIT, host, 0, &s->readback, &s->readback_alloc)) {
+      fprintf(stderr, "cj_offscreen: failed to create a readback buffer\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+CJ_API cj_offscreen_target_t* cj_offscreen_create(cj_engine_t* engine, const cj_offscreen_desc_t* desc) {
+  if (!engine || !desc || desc->width == 0 || desc->height == 0 || desc->buffer_count > CJ_OFFSCREEN_MAX_BUFFERS) {
+    return NULL;
+  }
+  VkDevice dev = cj_engine_device(engine);
+  if (dev == VK_NULL_HANDLE || cj_engine_render_pass(engine) == VK_NULL_HANDLE) {
+    fprintf(stderr, "cj_offscreen_create: engine is not initialized\n");
+    return NULL;
+  }
+
+  cj_offscreen_target_t* t = (cj_offscreen_target_t*)calloc(1, sizeof(*t));
+  if (!t) return NULL;
+  t->engine = engine;
+  t->device = dev;
+  t->extent = (VkExtent2D){ desc->width, desc->height };
+  t->readback = !desc->no_readback;
+  t->slot_count = desc->buffer_count ? desc->buffer_count : 2u;
+
+  VkCommandPoolCreateInfo pci = {0};
+  pci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  pci.queueFamilyIndex = cj_engine_graphics_family(engine);
+  bool ok = vkCreateCommandPool(dev, &pci, NULL, &t->pool) == VK_SUCCESS;
+  for (uint32_t i = 0; i < t->slot_count && ok; ++i) {
+    VkCommandBufferAllocateInfo cai = {0};
+    cai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cai.commandPool = t->pool;
+    cai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cai.commandBufferCount = 1;
+    VkFenceCreateInfo fci = {0};
+    fci.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    ok = vkAllocateCommandBuffers(dev, &cai, &t->slots[i].cmd) == VK_SUCCESS &&
+         vkCreateFence(dev, &fci, NULL, &t->slots[i].fence) == VK_SUCCESS;
+  }
+  if (!ok || !offscreen_create_images(t)) {
+    cj_offscreen_destroy(t);
+    return NULL;
+  }
+  return t;
+}
+
+CJ_API void cj_offscreen_destroy(cj_offscreen_target_t* t) {
+  if (!t) return;
+  offscreen_release_images(t);
+  for (uint32_t i = 0; i < t->slot_count; ++i) {
+    if (t->slots[i].fence) vkDestroyFence(t->device, t->slots[i].fence, NULL);
+  }
+  /* Frees the command buffers with it */
+  if (t->pool) vkDestroyCommandPool(t->device, t->pool, NULL);
+  free(t);
+}
+
+CJ_API void cj_offscreen_set_render_graph(cj_offscreen_target_t* t, cj_rgraph_t* graph) {
+  if (t) t->graph = graph;
+}
+
+CJ_API cj_result_t cj_offscreen_resize(cj_offscreen_target_t* t, uint32_t width, uint32_t height) {
+  if (!t || width == 0 || height == 0) return CJ_E_INVALID_ARGUMENT;
+  if (width == t->extent.width && height == t->extent.height) return CJ_SUCCESS;
+  offscreen_release_images(t);
+  t->extent = (VkExtent2D){ width, height };
+  return offscreen_create_images(t) ? CJ_SUCCESS : CJ_E_OUT_OF_MEMORY;
+}
+
+/* Same recording as a window frame, followed by the copy into the slot's host buffer */
+static cj_result_t offscreen_record(cj_offscreen_target_t* t, cj_offscreen_slot_t* s) {
+  VkCommandBuffer cmd = s->cmd;
+  VkCommandBufferBeginInfo beginInfo = {0};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (vkResetCommandBuffer(cmd, 0) != VK_SUCCESS || vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+    return CJ_E_UNKNOWN;
+  }
+
+  /* Nodes rendering into transients run before the backbuffer pass */
+  cj_result_t result = cj_rgraph_execute_offscreen(t->graph, cmd, t->extent);
+
+  VkRenderPassBeginInfo rp = {0};
+  rp.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  rp.renderPass = cj_engine_render_pass(t->engine);
+  rp.framebuffer = s->framebuffer;
+  rp.renderArea.extent = t->extent;
+  VkClearValue clearColor = {{{0.1f, 0.1f, 0.1f, 1.0f}}};
+  rp.clearValueCount = 1;
+  rp.pClearValues = &clearColor;
+  vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+
+  VkViewport viewport = {0};
+  viewport.width = (float)t->extent.width;
+  viewport.height = (float)t->extent.height;
+  viewport.maxDepth = 1.0f;
+  vkCmdSetViewport(cmd, 0, 1, &viewport);
+  vkCmdSetScissor(cmd, 0, 1, &rp.renderArea);
+  if (result == CJ_SUCCESS) result = cj_rgraph_execute(t->graph, cmd, t->extent);
+  vkCmdEndRenderPass(cmd);
+
+  if (s->readback) {
+    /* The engine pass leaves the image ready to present; copy from it instead */
+    VkImageMemoryBarrier toCopy = {0};
+    toCopy.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toCopy.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    toCopy.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toCopy.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    toCopy.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toCopy.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toCopy.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toCopy.image = s->image;
+    toCopy.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    toCopy.subresourceRange.levelCount = 1;
+    toCopy.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, NULL, 0, NULL, 1, &toCopy);
+
+    VkBufferImageCopy region = {0};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = (VkExtent3D){ t->extent.width, t->extent.height, 1 };
+    vkCmdCopyImageToBuffer(cmd, s->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, s->readback, 1, &region);
+
+    /* Make the copy visible to the host once the fence signals */
+    VkBufferMemoryBarrier toHost = {0};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = s->readback;
+    toHost.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 0, NULL, 1, &toHost, 0, NULL);
+  }
+
+  if (vkEndCommandBuffer(cmd) != VK_SUCCESS) return CJ_E_UNKNOWN;
+  return result;
+}
+
+CJ_API cj_result_t cj_offscreen_render(cj_offscreen_target_t* t) {
+  if (!t) return CJ_E_INVALID_ARGUMENT;
+  if (!t->graph) return CJ_E_NOT_READY;
+
+  /* A window may have rebuilt the engine render pass for its surface format */
+  if (cj_engine_color_format(t->engine) != t->format) {
+    offscreen_release_images(t);
+    if (!offscreen_create_images(t)) return CJ_E_OUT_OF_MEMORY;
+  }
+
+  CJ_PROFILE_ZONE_BEGIN(renderZone, "offscreen render");
+  uint32_t slot = (uint32_t)(t->frame_index % t->slot_count);
+  cj_offscreen_slot_t* s = &t->slots[slot];
+  /* Only blocks when the GPU is a whole ring of frames behind */
+  if (s->frame_index) vkWaitForFences(t->device, 1, &s->fence, VK_TRUE, UINT64_MAX);
+  s->frame_index = 0;
+
+  /* Between frames: the graph picks up rebuilt shaders in prepare */
+  cj_engine_poll_shader_reload(t->engine);
+  cj_result_t result = cj_rgraph_prepare(t->graph, t->extent);
+  cj_rgraph__set_frame(t->graph, t, slot);
+  if (result == CJ_SUCCESS) result = offscreen_record(t, s);
+  if (result == CJ_SUCCESS) {
+    /* Textures sampled by the graph must be resident before it runs */
+    cj_upload_queue_flush(cj_engine_uploads(t->engine));
+    VkSubmitInfo si = {0};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &s->cmd;
+    /* Ordered with the graph's async compute work like a window frame */
+    cj_rgraph_async_sync_t sync;
+    cj_rgraph__async_sync(t->graph, &sync);
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    VkTimelineSemaphoreSubmitInfo timeline = {0};
+    if (sync.semaphore != VK_NULL_HANDLE) {
+      timeline.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+      if (sync.wait_value) {
+        si.waitSemaphoreCount = 1;
+        si.pWaitSemaphores = &sync.semaphore;
+        si.pWaitDstStageMask = &waitStage;
+        timeline.waitSemaphoreValueCount = 1;
+        timeline.pWaitSemaphoreValues = &sync.wait_value;
+      }
+      if (sync.signal_value) {
+        si.signalSemaphoreCount = 1;
+        si.pSignalSemaphores = &sync.semaphore;
+        timeline.signalSemaphoreValueCount = 1;
+        timeline.pSignalSemaphoreValues = &sync.signal_value;
+      }
+      si.pNext = &timeline;
+    }
+    vkResetFences(t->device, 1, &s->fence);
+    bool submitted = vkQueueSubmit(cj_engine_graphics_queue(t->engine), 1, &si, s->fence) == VK_SUCCESS;
+    cj_rgraph__submit_async(t->graph, submitted);
+    if (submitted) {
+      s->frame_index = ++t->frame_index;
+    } else {
+      fprintf(stderr, "cj_offscreen_render: vkQueueSubmit failed\n");
+      result = CJ_E_DEVICE_LOST;
+    }
+  }
+  /* Headless applications have no event loop to free released resources */
+  cj_engine_collect_garbage(t->engine, CJ_OFFSCREEN_GARBAGE_BUDGET_US);
+  CJ_PROFILE_ZONE_END(renderZone, "offscreen render");
+  return result;
+}
+
+CJ_API cj_result_t cj_offscreen_read(cj_offscreen_target_t* t, bool wait, cj_offscreen_frame_t* out) {
+  if (!t || !out) return CJ_E_INVALID_ARGUMENT;
+  memset(out, 0, sizeof(*out));
+  if (!t->readback) return CJ_E_NOT_READY;
+
+  /* Newest first: a finished frame hides every older one */
+  cj_offscreen_slot_t* found = NULL;
+  for (uint64_t back = 0; back < t->slot_count && back < t->frame_index; ++back) {
+    cj_offscreen_slot_t* s = &t->slots[(t->frame_index - 1u - back) % t->slot_count];
+    if (s->frame_index != t->frame_index - back) continue;
+    if (wait && vkWaitForFences(t->device, 1, &s->fence, VK_TRUE, UINT64_MAX) != VK_SUCCESS) break;
+    if (vkGetFenceStatus(t->device, s->fence) == VK_SUCCESS) {
+      found = s;
+      break;
+    }
+  }
+  if (!found || !found->readback_alloc.mapped) return CJ_E_NOT_READY;
+
+  out->frame_index = found->frame_index;
+  out->width = t->extent.width;
+  out->height = t->extent.height;
+  out->row_pitch = t->extent.width * t->texel_size;
+  out->format = offscreen_public_format(t->format);
+  out->pixels = found->readback_alloc.mapped;
+  return CJ_SUCCESS;
+}
+
+CJ_API uint64_t cj_offscreen_frame_index(const cj_offscreen_target_t* t) {
+  return t ? t->frame_index : 0u;
+}
@@ -0,0 +1,1190 @@
+/* CJelly pipeline cache: persistent VkPipelineCache and shared pipelines */
+
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <cjelly/pipeline_cache_internal.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define CJ_PIPELINE_FILE_VERSION 1u
+
+/* Files claiming more driver data than this are ignored */
+#define CJ_PIPELINE_FILE_MAX_DATA ((uint64_t)256 << 20)
+
+/* Vertex, two tessellation, geometry and fragment */
+#define CJ_PIPELINE_MAX_STAGES 5u
+
+/* Largest state arrays a recipe can hold; pipelines with more are not reloadable */
+#define CJ_RECIPE_MAX_VERTEX_INPUTS 16u
+#define CJ_RECIPE_MAX_VIEWPORTS 4u
+#define CJ_RECIPE_MAX_BLEND_ATTACHMENTS 8u
+#define CJ_RECIPE_MAX_DYNAMIC_STATES 32u
+#define CJ_RECIPE_NAME_SIZE 64u
+
+static const char cj_pipeline_file_magic[4] = {'C', 'J', 'P', 'C'};
+
+/* Start of the cache file; data_size bytes of vkGetPipelineCacheData output follow */
+typedef struct cj_pipeline_file_header_t {
+  char magic[4];
+  uint32_t version;
+  uint32_t vendor_id;
+  uint32_t device_id;
+  uint32_t driver_version;
+  uint8_t uuid[VK_UUID_SIZE];
+  uint32_t reserved;
+  uint64_t data_size;
+  uint64_t data_hash;
+} cj_pipeline_file_header_t;
+
+/* One stage of a recipe; code is an owned copy */
+typedef struct cj_recipe_stage_t {
+  VkShaderStageFlagBits stage;
+  char name[CJ_RECIPE_NAME_SIZE];   /* Empty for fixed code */
+  char entry[CJ_RECIPE_NAME_SIZE];
+  void* code;
+  size_t size;
+} cj_recipe_stage_t;
+
+/*
+ * Everything a pipeline was built from, deep-copied. The create infos point into
+ * the recipe itself (see recipe_link), so a recipe is never copied bytewise.
+ */
+typedef struct cj_pipeline_recipe_t {
+  bool compute;
+  VkComputePipelineCreateInfo compute_info;
+  VkGraphicsPipelineCreateInfo graphics;
+  bool has_vi, has_ia, has_ts, has_vp, has_rs, has_ms, has_ds, has_cb, has_dyn, has_sample_mask;
+  VkPipelineVertexInputStateCreateInfo vi;
+  VkVertexInputBindingDescription bindings[CJ_RECIPE_MAX_VERTEX_INPUTS];
+  VkVertexInputAttributeDescription attributes[CJ_RECIPE_MAX_VERTEX_INPUTS];
+  VkPipelineInputAssemblyStateCreateInfo ia;
+  VkPipelineTessellationStateCreateInfo ts;
+  VkPipelineViewportStateCreateInfo vp;
+  bool has_viewports, has_scissors;
+  VkViewport viewports[CJ_RECIPE_MAX_VIEWPORTS];
+  VkRect2D scissors[CJ_RECIPE_MAX_VIEWPORTS];
+  VkPipelineRasterizationStateCreateInfo rs;
+  VkPipelineMultisampleStateCreateInfo ms;
+  VkSampleMask sample_mask[2];
+  VkPipelineDepthStencilStateCreateInfo ds;
+  VkPipelineColorBlendStateCreateInfo cb;
+  VkPipelineColorBlendAttachmentState blend[CJ_RECIPE_MAX_BLEND_ATTACHMENTS];
+  VkPipelineDynamicStateCreateInfo dyn;
+  VkDynamicState dynamic[CJ_RECIPE_MAX_DYNAMIC_STATES];
+  uint32_t stage_count;
+  cj_recipe_stage_t stages[CJ_PIPELINE_MAX_STAGES];
+} cj_pipeline_recipe_t;
+
+/* Every input a shared object was built from, serialized. Lookups compare the bytes;
+ * the hash only skips entries that cannot match. */
+typedef struct cj_pipeline_key_t {
+  uint64_t hash;
+  unsigned char* bytes;
+  size_t size;
+  size_t capacity;
+  bool failed;                   /* Ran out of memory while serializing */
+} cj_pipeline_key_t;
+
+typedef struct cj_pipeline_entry_t {
+  cj_pipeline_key_t key;
+  uint32_t refs;
+  VkPipeline pipeline;
+  cj_pipeline_recipe_t* recipe;  /* NULL when the state does not fit (and for compute pipelines without reload) */
+  VkPipeline replaced_by;        /* Newer build holders should move to, VK_NULL_HANDLE if none */
+} cj_pipeline_entry_t;
+
+/* Code hot reload installed for a shader name */
+typedef struct cj_shader_override_t {
+  char name[CJ_RECIPE_NAME_SIZE];
+  void* code;
+  size_t size;
+} cj_shader_override_t;
+
+struct cj_pipeline_rebuild_t {
+  cj_pipeline_rebuild_t* next;
+  VkDevice device;
+  VkPipelineCache handle;
+  VkPipeline target;             /* Pipeline being rebuilt */
+  cj_pipeline_key_t key;         /* Key of the rebuilt pipeline */
+  cj_pipeline_recipe_t* recipe;  /* Recipe with the new code */
+  VkPipeline pipeline;           /* Result of cj_pipeline_rebuild_run */
+  VkResult result;
+};
+
+typedef struct cj_layout_entry_t {
+  cj_pipeline_key_t key;
+  uint32_t refs;
+  VkPipelineLayout layout;
+} cj_layout_entry_t;
+
+struct cj_pipeline_cache_t {
+  VkDevice device;
+  VkPipelineCache handle;
+  char* path;                        /* NULL when there is no cache directory */
+  cj_pipeline_file_header_t header;  /* Device fields of the file header */
+  uint64_t saved_size;               /* Driver data the file holds */
+  uint64_t saved_hash;
+
+  cj_pipeline_entry_t* pipelines;
+  uint32_t pipeline_count;
+  uint32_t pipeline_capacity;
+  cj_layout_entry_t* layouts;
+  uint32_t layout_count;
+  uint32_t layout_capacity;
+
+  /* Receives pipelines frames in flight may still use; NULL = destroyed at once */
+  cj_pipeline_retire_fn_t retire;
+  void* retire_user;
+
+  /* Hot reload: compute recipes are kept while enabled (graphics ones always, for variants) */
+  bool reload;
+  uint64_t generation;
+  cj_shader_override_t* overrides;
+  uint32_t override_count;
+};
+
+static void recipe_free(cj_pipeline_recipe_t* r) {
+  if (!r) return;
+  for (uint32_t i = 0; i < r->stage_count; i++) free(r->stages[i].code);
+  free(r);
+}
+
+/* FNV-1a; key hashes and file checksums only need to tell inputs apart */
+static uint64_t pcache_hash(uint64_t h, const void* data, size_t size) {
+  const unsigned char* p = (const unsigned char*)data;
+  for (size_t i = 0; i < size; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+#define PCACHE_SEED 0xcbf29ce484222325ull
+#define PCACHE_MIX(k, v) pcache_key_append((k), &(v), sizeof(v))
+
+static void pcache_key_init(cj_pipeline_key_t* k) {
+  memset(k, 0, sizeof(*k));
+  k->hash = PCACHE_SEED;
+}
+
+static void pcache_key_append(cj_pipeline_key_t* k, const void* data, size_t size) {
+  if (k->failed) return;
+  if (k->size + size > k->capacity) {
+    size_t capacity = k->capacity ? k->capacity : 256u;
+    while (capacity < k->size + size) capacity *= 2u;
+    unsigned char* grown = (unsigned char*)realloc(k->bytes, capacity);
+    if (!grown) {
+      k->failed = true;
+      return;
+    }
+    k->bytes = grown;
+    k->capacity = capacity;
+  }
+  memcpy(k->bytes + k->size, data, size);
+  k->size += size;
+  k->hash = pcache_hash(k->hash, data, size);
+}
+
+static void pcache_key_free(cj_pipeline_key_t* k) {
+  free(k->bytes);
+  memset(k, 0, sizeof(*k));
+}
+
+static bool pcache_key_equal(const cj_pipeline_key_t* a, const cj_pipeline_key_t* b) {
+  return a->hash == b->hash && a->size == b->size && memcmp(a->bytes, b->bytes, a->size) == 0;
+}
+
+/* Create every missing directory of path */
+static void pcache_make_dirs(char* path) {
+  for (char* p = path + 1; ; p++) {
+    if (*p != '/' && *p != '\\' && *p != '\0') continue;
+    char c = *p;
+    *p = '\0';
+#ifdef _WIN32
+    CreateDirectoryA(path, NULL);
+#else
+    mkdir(path, 0755);
+#endif
+    *p = c;
+    if (c == '\0') break;
+  }
+}
+
+static char* pcache_file_path(const uint8_t uuid[VK_UUID_SIZE]) {
+  char dir[1024];
+  const char* env = getenv("CJELLY_CACHE_DIR");
+  if (env && *env) {
+    snprintf(dir, sizeof(dir), "%s", env);
+#ifdef _WIN32
+  } else if ((env = getenv("LOCALAPPDATA")) && *env) {
+    snprintf(dir, sizeof(dir), "%s\\cjelly", env);
+#else
+  } else if ((env = getenv("XDG_CACHE_HOME")) && *env) {
+    snprintf(dir, sizeof(dir), "%s/cjelly", env);
+  } else if ((env = getenv("HOME")) && *env) {
+    snprintf(dir, sizeof(dir), "%s/.cache/cjelly", env);
+#endif
+  } else {
+    return NULL;
+  }
+  pcache_make_dirs(dir);
+
+  size_t size = strlen(dir) + sizeof("/pipelines-.bin") + VK_UUID_SIZE * 2;
+  char* path = (char*)malloc(size);
+  if (!path) return NULL;
+  int n = snprintf(path, size, "%s/pipelines-", dir);
+  for (uint32_t i = 0; i < VK_UUID_SIZE; i++) n += snprintf(path + n, size - (size_t)n, "%02x", uuid[i]);
+  snprintf(path + n, size - (size_t)n, ".bin");
+  return path;
+}
+
+/* Read the driver data of a file written for the same device and driver */
+static void* pcache_read_file(cj_pipeline_cache_t* c, size_t* out_size) {
+  *out_size = 0;
+  if (!c->path) return NULL;
+  FILE* f = fopen(c->path, "rb");
+  if (!f) return NULL;
+
+  void* data = NULL;
+  cj_pipeline_file_header_t h;
+  if (fread(&h, sizeof(h), 1, f) == 1
+      && memcmp(h.magic, c->header.magic, sizeof(h.magic)) == 0
+      && h.version == c->header.version
+      && h.vendor_id == c->header.vendor_id
+      && h.device_id == c->header.device_id
+      && h.driver_version == c->header.driver_version
+      && memcmp(h.uuid, c->header.uuid, VK_UUID_SIZE) == 0
+      && h.data_size > 0 && h.data_size <= CJ_PIPELINE_FILE_MAX_DATA) {
+    data = malloc((size_t)h.data_size);
+    if (data && (fread(data, 1, (size_t)h.data_size, f) != (size_t)h.data_size
+                 || pcache_hash(PCACHE_SEED, data, (size_t)h.data_size) != h.data_hash)) {
+      free(data);
+      data = NULL;
+    }
+    if (data) {
+      *out_size = (size_t)h.data_size;
+      c->saved_size = h.data_size;
+      c->saved_hash = h.data_hash;
+    }
+  }
+  fclose(f);
+  return data;
+}
+
+cj_pipeline_cache_t* cj_pipeline_cache_create(VkPhysicalDevice physical, VkDevice device) {
+  cj_pipeline_cache_t* c = (cj_pipeline_cache_t*)calloc(1, sizeof(*c));
+  if (!c) return NULL;
+  c->device = device;
+
+  VkPhysicalDeviceProperties props;
+  vkGetPhysicalDeviceProperties(physical, &props);
+  memcpy(c->header.magic, cj_pipeline_file_magic, sizeof(c->header.magic));
+  c->header.version = CJ_PIPELINE_FILE_VERSION;
+  c->header.vendor_id = props.vendorID;
+  c->header.device_id = props.deviceID;
+  c->header.driver_version = props.driverVersion;
+  memcpy(c->header.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+  c->path = pcache_file_path(props.pipelineCacheUUID);
+
+  size_t size = 0;
+  void* data = pcache_read_file(c, &size);
+  VkPipelineCacheCreateInfo ci = {0};
+  ci.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  ci.initialDataSize = size;
+  ci.pInitialData = data;
+  VkResult res = vkCreatePipelineCache(device, &ci, NULL, &c->handle);
+  if (res != VK_SUCCESS && data) {
+    /* The driver refused the data; start from scratch */
+    ci.initialDataSize = 0;
+    ci.pInitialData = NULL;
+    c->saved_size = 0;
+    c->saved_hash = 0;
+    res = vkCreatePipelineCache(device, &ci, NULL, &c->handle);
+  }
+  free(data);
+  if (res != VK_SUCCESS) {
+    fprintf(stderr, "cj_pipeline_cache_create: vkCreatePipelineCache failed (%d)\n", res);
+    free(c->path);
+    free(c);
+    return NULL;
+  }
+  return c;
+}
+
+bool cj_pipeline_cache_save(cj_pipeline_cache_t* c) {
+  if (!c || !c->handle || !c->path) return false;
+
+  size_t size = 0;
+  if (vkGetPipelineCacheData(c->device, c->handle, &size, NULL) != VK_SUCCESS) return false;
+  if (size == 0) return true;
+  void* data = malloc(size);
+  if (!data) return false;
+  VkResult res = vkGetPipelineCacheData(c->device, c->handle, &size, data);
+  if (res != VK_SUCCESS) {
+    free(data);
+    return false;
+  }
+
+  cj_pipeline_file_header_t h = c->header;
+  h.data_size = size;
+  h.data_hash = pcache_hash(PCACHE_SEED, data, size);
+  if (h.data_size == c->saved_size && h.data_hash == c->saved_hash) {
+    free(data);
+    return true;
+  }
+
+  /* Write next to the file and move it into place so readers never see a partial file */
+  size_t len = strlen(c->path);
+  char* tmp = (char*)malloc(len + 5);
+  bool ok = tmp != NULL;
+  if (ok) {
+    memcpy(tmp, c->path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    FILE* f = fopen(tmp, "wb");
+    ok = f != NULL;
+    if (f) {
+      ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(data, 1, size, f) == size;
+      ok = fclose(f) == 0 && ok;
+    }
+#ifdef _WIN32
+    ok = ok && MoveFileExA(tmp, c->path, MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = ok && rename(tmp, c->path) == 0;
+#endif
+    if (!ok) remove(tmp);
+  }
+  if (ok) {
+    c->saved_size = h.data_size;
+    c->saved_hash = h.data_hash;
+  } else {
+    fprintf(stderr, "cj_pipeline_cache_save: cannot write %s\n", c->path);
+  }
+  free(tmp);
+  free(data);
+  return ok;
+}
+
+void cj_pipeline_cache_destroy(cj_pipeline_cache_t* c) {
+  if (!c) return;
+  /* Rebuilds nobody adopted yet hold no references */
+  uint32_t held = 0;
+  for (uint32_t i = 0; i < c->pipeline_count; i++) held += c->pipelines[i].refs != 0;
+  if (held || c->layout_count) {
+    fprintf(stderr, "cj_pipeline_cache_destroy: %u shared pipelines and %u layouts still referenced\n",
+            held, c->layout_count);
+  }
+  for (uint32_t i = 0; i < c->pipeline_count; i++) {
+    vkDestroyPipeline(c->device, c->pipelines[i].pipeline, NULL);
+    recipe_free(c->pipelines[i].recipe);
+    pcache_key_free(&c->pipelines[i].key);
+  }
+  for (uint32_t i = 0; i < c->override_count; i++) free(c->overrides[i].code);
+  free(c->overrides);
+  for (uint32_t i = 0; i < c->layout_count; i++) {
+    vkDestroyPipelineLayout(c->device, c->layouts[i].layout, NULL);
+    pcache_key_free(&c->layouts[i].key);
+  }
+  cj_pipeline_cache_save(c);
+  vkDestroyPipelineCache(c->device, c->handle, NULL);
+  free(c->pipelines);
+  free(c->layouts);
+  free(c->path);
+  free(c);
+}
+
+VkPipelineCache cj_pipeline_cache_handle(const cj_pipeline_cache_t* c) {
+  return c ? c->handle : VK_NULL_HANDLE;
+}
+
+static void pcache_layout_key(const VkPipelineLayoutCreateInfo* info, cj_pipeline_key_t* k) {
+  pcache_key_init(k);
+  PCACHE_MIX(k, info->flags);
+  PCACHE_MIX(k, info->setLayoutCount);
+  for (uint32_t i = 0; i < info->setLayoutCount; i++) PCACHE_MIX(k, info->pSetLayouts[i]);
+  PCACHE_MIX(k, info->pushConstantRangeCount);
+  for (uint32_t i = 0; i < info->pushConstantRangeCount; i++) {
+    PCACHE_MIX(k, info->pPushConstantRanges[i].stageFlags);
+    PCACHE_MIX(k, info->pPushConstantRanges[i].offset);
+    PCACHE_MIX(k, info->pPushConstantRanges[i].size);
+  }
+}
+
+VkPipelineLayout cj_pipeline_cache_layout(cj_pipeline_cache_t* c, const VkPipelineLayoutCreateInfo* info) {
+  if (!c || !info || info->pNext) return VK_NULL_HANDLE;
+  cj_pipeline_key_t key;
+  pcache_layout_key(info, &key);
+  if (key.failed) {
+    pcache_key_free(&key);
+    return VK_NULL_HANDLE;
+  }
+  for (uint32_t i = 0; i < c->layout_count; i++) {
+    if (pcache_key_equal(&c->layouts[i].key, &key)) {
+      pcache_key_free(&key);
+      c->layouts[i].refs++;
+      return c->layouts[i].layout;
+    }
+  }
+
+  if (c->layout_count == c->layout_capacity) {
+    uint32_t cap = c->layout_capacity ? c->layout_capacity * 2 : 8;
+    cj_layout_entry_t* grown = (cj_layout_entry_t*)realloc(c->layouts, cap * sizeof(*grown));
+    if (!grown) {
+      pcache_key_free(&key);
+      return VK_NULL_HANDLE;
+    }
+    c->layouts = grown;
+    c->layout_capacity = cap;
+  }
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+  if (vkCreatePipelineLayout(c->device, info, NULL, &layout) != VK_SUCCESS) {
+    pcache_key_free(&key);
+    return VK_NULL_HANDLE;
+  }
+  c->layouts[c->layout_count++] = (cj_layout_entry_t){ key, 1, layout };
+  return layout;
+}
+
+void cj_pipeline_cache_release_layout(cj_pipeline_cache_t* c, VkPipelineLayout layout) {
+  if (!c || layout == VK_NULL_HANDLE) return;
+  for (uint32_t i = 0; i < c->layout_count; i++) {
+    if (c->layouts[i].layout != layout) continue;
+    if (--c->layouts[i].refs == 0) {
+      vkDestroyPipelineLayout(c->device, layout, NULL);
+      pcache_key_free(&c->layouts[i].key);
+      c->layouts[i] = c->layouts[--c->layout_count];
+    }
+    return;
+  }
+}
+
+static bool pcache_has_dynamic(const VkPipelineDynamicStateCreateInfo* ds, VkDynamicState state) {
+  if (!ds) return false;
+  for (uint32_t i = 0; i < ds->dynamicStateCount; i++) {
+    if (ds->pDynamicStates[i] == state) return true;
+  }
+  return false;
+}
+
+/* Serialize every field the pipeline depends on into k. Returns false, with k freed, for
+ * states the key cannot describe and when memory runs out (k->failed). */
+static bool pcache_graphics_key(const VkGraphicsPipelineCreateInfo* info, const cj_pipeline_shader_t* shaders,
+                                uint32_t shader_count, cj_pipeline_key_t* k) {
+  const VkPipelineVertexInputStateCreateInfo* vi = info->pVertexInputState;
+  const VkPipelineInputAssemblyStateCreateInfo* ia = info->pInputAssemblyState;
+  const VkPipelineTessellationStateCreateInfo* ts = info->pTessellationState;
+  const VkPipelineViewportStateCreateInfo* vp = info->pViewportState;
+  const VkPipelineRasterizationStateCreateInfo* rs = info->pRasterizationState;
+  const VkPipelineMultisampleStateCreateInfo* ms = info->pMultisampleState;
+  const VkPipelineDepthStencilStateCreateInfo* dss = info->pDepthStencilState;
+  const VkPipelineColorBlendStateCreateInfo* cb = info->pColorBlendState;
+  const VkPipelineDynamicStateCreateInfo* dyn = info->pDynamicState;
+  if (info->pNext || (vi && vi->pNext) || (ia && ia->pNext) || (ts && ts->pNext) || (vp && vp->pNext) ||
+      (rs && rs->pNext) || (ms && ms->pNext) || (dss && dss->pNext) || (cb && cb->pNext) || (dyn && dyn->pNext)) {
+    pcache_key_init(k);
+    return false;
+  }
+
+  pcache_key_init(k);
+  PCACHE_MIX(k, info->flags);
+  PCACHE_MIX(k, info->layout);
+  PCACHE_MIX(k, info->renderPass);
+  PCACHE_MIX(k, info->subpass);
+
+  PCACHE_MIX(k, shader_count);
+  for (uint32_t i = 0; i < shader_count; i++) {
+    const char* entry = shaders[i].entry ? shaders[i].entry : "main";
+    PCACHE_MIX(k, shaders[i].stage);
+    PCACHE_MIX(k, shaders[i].size);
+    pcache_key_append(k, shaders[i].code, shaders[i].size);
+    pcache_key_append(k, entry, strlen(entry) + 1);
+  }
+
+  if (vi) {
+    PCACHE_MIX(k, vi->vertexBindingDescriptionCount);
+    for (uint32_t i = 0; i < vi->vertexBindingDescriptionCount; i++) {
+      PCACHE_MIX(k, vi->pVertexBindingDescriptions[i].binding);
+      PCACHE_MIX(k, vi->pVertexBindingDescriptions[i].stride);
+      PCACHE_MIX(k, vi->pVertexBindingDescriptions[i].inputRate);
+    }
+    PCACHE_MIX(k, vi->vertexAttributeDescriptionCount);
+    for (uint32_t i = 0; i < vi->vertexAttributeDescriptionCount; i++) {
+      PCACHE_MIX(k, vi->pVertexAttributeDescriptions[i].location);
+      PCACHE_MIX(k, vi->pVertexAttributeDescriptions[i].binding);
+      PCACHE_MIX(k, vi->pVertexAttributeDescriptions[i].format);
+      PCACHE_MIX(k, vi->pVertexAttributeDescriptions[i].offset);
+    }
+  }
+  if (ia) {
+    PCACHE_MIX(k, ia->topology);
+    PCACHE_MIX(k, ia->primitiveRestartEnable);
+  }
+  if (ts) PCACHE_MIX(k, ts->patchControlPoints);
+  if (vp) {
+    PCACHE_MIX(k, vp->viewportCount);
+    PCACHE_MIX(k, vp->scissorCount);
+    if (vp->pViewports && !pcache_has_dynamic(dyn, VK_DYNAMIC_STATE_VIEWPORT)) {
+      for (uint32_t i = 0; i < vp->viewportCount; i++) {
+        PCACHE_MIX(k, vp->pViewports[i].x);
+        PCACHE_MIX(k, vp->pViewports[i].y);
+        PCACHE_MIX(k, vp->pViewports[i].width);
+        PCACHE_MIX(k, vp->pViewports[i].height);
+        PCACHE_MIX(k, vp->pViewports[i].minDepth);
+        PCACHE_MIX(k, vp->pViewports[i].maxDepth);
+      }
+    }
+    if (vp->pScissors && !pcache_has_dynamic(dyn, VK_DYNAMIC_STATE_SCISSOR)) {
+      for (uint32_t i = 0; i < vp->scissorCount; i++) {
+        PCACHE_MIX(k, vp->pScissors[i].offset.x);
+        PCACHE_MIX(k, vp->pScissors[i].offset.y);
+        PCACHE_MIX(k, vp->pScissors[i].extent.width);
+        PCACHE_MIX(k, vp->pScissors[i].extent.height);
+      }
+    }
+  }
+  if (rs) {
+    PCACHE_MIX(k, rs->depthClampEnable);
+    PCACHE_MIX(k, rs->rasterizerDiscardEnable);
+    PCACHE_MIX(k, rs->polygonMode);
+    PCACHE_MIX(k, rs->cullMode);
+    PCACHE_MIX(k, rs->frontFace);
+    PCACHE_MIX(k, rs->depthBiasEnable);
+    PCACHE_MIX(k, rs->depthBiasConstantFactor);
+    PCACHE_MIX(k, rs->depthBiasClamp);
+    PCACHE_MIX(k, rs->depthBiasSlopeFactor);
+    PCACHE_MIX(k, rs->lineWidth);
+  }
+  if (ms) {
+    PCACHE_MIX(k, ms->rasterizationSamples);
+    PCACHE_MIX(k, ms->sampleShadingEnable);
+    PCACHE_MIX(k, ms->minSampleShading);
+    PCACHE_MIX(k, ms->alphaToCoverageEnable);
+    PCACHE_MIX(k, ms->alphaToOneEnable);
+    if (ms->pSampleMask) {
+      uint32_t words = ((uint32_t)ms->rasterizationSamples + 31u) / 32u;
+      pcache_key_append(k, ms->pSampleMask, words * sizeof(VkSampleMask));
+    }
+  }
+  if (dss) {
+    PCACHE_MIX(k, dss->depthTestEnable);
+    PCACHE_MIX(k, dss->depthWriteEnable);
+    PCACHE_MIX(k, dss->depthCompareOp);
+    PCACHE_MIX(k, dss->depthBoundsTestEnable);
+    PCACHE_MIX(k, dss->stencilTestEnable);
+    PCACHE_MIX(k, dss->front);
+    PCACHE_MIX(k, dss->back);
+    PCACHE_MIX(k, dss->minDepthBounds);
+    PCACHE_MIX(k, dss->maxDepthBounds);
+  }
+  if (cb) {
+    PCACHE_MIX(k, cb->logicOpEnable);
+    PCACHE_MIX(k, cb->logicOp);
+    PCACHE_MIX(k, cb->attachmentCount);
+    for (uint32_t i = 0; i < cb->attachmentCount; i++) PCACHE_MIX(k, cb->pAttachments[i]);
+    PCACHE_MIX(k, cb->blendConstants);
+  }
+  if (dyn) {
+    PCACHE_MIX(k, dyn->dynamicStateCount);
+    for (uint32_t i = 0; i < dyn->dynamicStateCount; i++) PCACHE_MIX(k, dyn->pDynamicStates[i]);
+  }
+  if (k->failed) {
+    pcache_key_free(k);
+    k->failed = true;
+    return false;
+  }
+  return true;
+}
+
+/* Like pcache_graphics_key; only fails when memory runs out */
+static bool pcache_compute_key(const VkComputePipelineCreateInfo* info, const cj_pipeline_shader_t* shader,
+                               cj_pipeline_key_t* k) {
+  /* The bind point keeps compute keys apart from graphics keys over the same code */
+  const char* entry = shader->entry ? shader->entry : "main";
+  const VkPipelineBindPoint bind_point = VK_PIPELINE_BIND_POINT_COMPUTE;
+  pcache_key_init(k);
+  PCACHE_MIX(k, bind_point);
+  PCACHE_MIX(k, info->flags);
+  PCACHE_MIX(k, info->layout);
+  PCACHE_MIX(k, shader->size);
+  pcache_key_append(k, shader->code, shader->size);
+  pcache_key_append(k, entry, strlen(entry) + 1);
+  if (k->failed) {
+    pcache_key_free(k);
+    k->failed = true;
+    return false;
+  }
+  return true;
+}
+
+static VkResult pcache_build_graphics(VkDevice device, VkPipelineCache handle, const VkGraphicsPipelineCreateInfo* info,
+                                      const cj_pipeline_shader_t* shaders, uint32_t shader_count, VkPipeline* out) {
+  VkPipelineShaderStageCreateInfo stages[CJ_PIPELINE_MAX_STAGES];
+  memset(stages, 0, sizeof(stages));
+  VkResult res = VK_SUCCESS;
+  uint32_t created = 0;
+  for (; created < shader_count; created++) {
+    VkShaderModuleCreateInfo mi = {0};
+    mi.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    mi.codeSize = shaders[created].size;
+    mi.pCode = (const uint32_t*)shaders[created].code;
+    stages[created].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[created].stage = shaders[created].stage;
+    stages[created].pName = shaders[created].entry ? shaders[created].entry : "main";
+    res = vkCreateShaderModule(device, &mi, NULL, &stages[created].module);
+    if (res != VK_SUCCESS) break;
+  }
+  if (res == VK_SUCCESS) {
+    VkGraphicsPipelineCreateInfo ci = *info;
+    ci.stageCount = shader_count;
+    ci.pStages = stages;
+    res = vkCreateGraphicsPipelines(device, handle, 1, &ci, NULL, out);
+  }
+  for (uint32_t i = 0; i < created; i++) vkDestroyShaderModule(device, stages[i].module, NULL);
+  return res;
+}
+
+static VkResult pcache_build_compute(VkDevice device, VkPipelineCache handle, const VkComputePipelineCreateInfo* info,
+                                     const cj_pipeline_shader_t* shader, VkPipeline* out) {
+  VkShaderModuleCreateInfo mi = {0};
+  mi.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  mi.codeSize = shader->size;
+  mi.pCode = (const uint32_t*)shader->code;
+  VkComputePipelineCreateInfo ci = *info;
+  ci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  ci.stage.pNext = NULL;
+  ci.stage.flags = 0;
+  ci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  ci.stage.pName = shader->entry ? shader->entry : "main";
+  ci.stage.pSpecializationInfo = NULL;
+  VkResult res = vkCreateShaderModule(device, &mi, NULL, &ci.stage.module);
+  if (res == VK_SUCCESS) {
+    res = vkCreateComputePipelines(device, handle, 1, &ci, NULL, out);
+    vkDestroyShaderModule(device, ci.stage.module, NULL);
+  }
+  return res;
+}
+
+/* Point a recipe's create infos at its own copies of the state */
+static void recipe_link(cj_pipeline_recipe_t* r) {
+  if (r->compute) return;
+  r->vi.pVertexBindingDescriptions = r->bindings;
+  r->vi.pVertexAttributeDescriptions = r->attributes;
+  r->vp.pViewports = r->has_viewports ? r->viewports : NULL;
+  r->vp.pScissors = r->has_scissors ? r->scissors : NULL;
+  r->ms.pSampleMask = r->has_sample_mask ? r->sample_mask : NULL;
+  r->cb.pAttachments = r->blend;
+  r->dyn.pDynamicStates = r->dynamic;
+
+  VkGraphicsPipelineCreateInfo* g = &r->graphics;
+  g->stageCount = 0;
+  g->pStages = NULL;
+  g->pVertexInputState = r->has_vi ? &r->vi : NULL;
+  g->pInputAssemblyState = r->has_ia ? &r->ia : NULL;
+  g->pTessellationState = r->has_ts ? &r->ts : NULL;
+  g->pViewportState = r->has_vp ? &r->vp : NULL;
+  g->pRasterizationState = r->has_rs ? &r->rs : NULL;
+  g->pMultisampleState = r->has_ms ? &r->ms : NULL;
+  g->pDepthStencilState = r->has_ds ? &r->ds : NULL;
+  g->pColorBlendState = r->has_cb ? &r->cb : NULL;
+  g->pDynamicState = r->has_dyn ? &r->dyn : NULL;
+}
+
+/* Copy the stages; false when a name does not fit or memory runs out */
+static bool recipe_set_stages(cj_pipeline_recipe_t* r, const cj_pipeline_shader_t* shaders, uint32_t shader_count) {
+  for (uint32_t i = 0; i < shader_count; i++) {
+    cj_recipe_stage_t* st = &r->stages[i];
+    const char* entry = shaders[i].entry ? shaders[i].entry : "main";
+    const char* name = shaders[i].name ? shaders[i].name : "";
+    if (strlen(entry) >= CJ_RECIPE_NAME_SIZE || strlen(name) >= CJ_RECIPE_NAME_SIZE) return false;
+    st->stage = shaders[i].stage;
+    memcpy(st->entry, entry, strlen(entry) + 1);
+    memcpy(st->name, name, strlen(name) + 1);
+    st->code = malloc(shaders[i].size);
+    if (!st->code) return false;
+    memcpy(st->code, shaders[i].code, shaders[i].size);
+    st->size = shaders[i].size;
+    r->stage_count = i + 1;
+  }
+  return true;
+}
+
+/* Stages of a recipe as shader descriptions */
+static void recipe_shaders(const cj_pipeline_recipe_t* r, cj_pipeline_shader_t* out) {
+  for (uint32_t i = 0; i < r->stage_count; i++) {
+    const cj_recipe_stage_t* st = &r->stages[i];
+    out[i] = (cj_pipeline_shader_t){ st->stage, st->code, st->size, st->entry, st->name[0] ? st->name : NULL };
+  }
+}
+
+/* Deep copy of a graphics pipeline's state, or NULL when it does not fit a recipe */
+static cj_pipeline_recipe_t* recipe_create_graphics(const VkGraphicsPipelineCreateInfo* info,
+                                                    const cj_pipeline_shader_t* shaders, uint32_t shader_count) {
+  const VkPipelineVertexInputStateCreateInfo* vi = info->pVertexInputState;
+  const VkPipelineViewportStateCreateInfo* vp = info->pViewportState;
+  const VkPipelineMultisampleStateCreateInfo* ms = info->pMultisampleState;
+  const VkPipelineColorBlendStateCreateInfo* cb = info->pColorBlendState;
+  const VkPipelineDynamicStateCreateInfo* dyn = info->pDynamicState;
+  if ((vi && (vi->vertexBindingDescriptionCount > CJ_RECIPE_MAX_VERTEX_INPUTS ||
+              vi->vertexAttributeDescriptionCount > CJ_RECIPE_MAX_VERTEX_INPUTS)) ||
+      (vp && (vp->viewportCount > CJ_RECIPE_MAX_VIEWPORTS || vp->scissorCount > CJ_RECIPE_MAX_VIEWPORTS)) ||
+      (cb && cb->attachmentCount > CJ_RECIPE_MAX_BLEND_ATTACHMENTS) ||
+      (dyn && dyn->dynamicStateCount > CJ_RECIPE_MAX_DYNAMIC_STATES)) {
+    return NULL;
+  }
+
+  cj_pipeline_recipe_t* r = (cj_pipeline_recipe_t*)calloc(1, sizeof(*r));
+  if (!r) return NULL;
+  r->graphics = *info;
+  if ((r->has_vi = vi != NULL)) {
+    r->vi = *vi;
+    if (vi->vertexBindingDescriptionCount) {
+      memcpy(r->bindings, vi->pVertexBindingDescriptions, vi->vertexBindingDescriptionCount * sizeof(*r->bindings));
+    }
+    if (vi->vertexAttributeDescriptionCount) {
+      memcpy(r->attributes, vi->pVertexAttributeDescriptions, vi->vertexAttributeDescriptionCount * sizeof(*r->attributes));
+    }
+  }
+  if ((r->has_ia = info->pInputAssemblyState != NULL)) r->ia = *info->pInputAssemblyState;
+  if ((r->has_ts = info->pTessellationState != NULL)) r->ts = *info->pTessellationState;
+  if ((r->has_vp = vp != NULL)) {
+    r->vp = *vp;
+    if ((r->has_viewports = vp->pViewports != NULL)) memcpy(r->viewports, vp->pViewports, vp->viewportCount * sizeof(VkViewport));
+    if ((r->has_scissors = vp->pScissors != NULL)) memcpy(r->scissors, vp->pScissors, vp->scissorCount * sizeof(VkRect2D));
+  }
+  if ((r->has_rs = info->pRasterizationState != NULL)) r->rs = *info->pRasterizationState;
+  if ((r->has_ms = ms != NULL)) {
+    r->ms = *ms;
+    if ((r->has_sample_mask = ms->pSampleMask != NULL)) {
+      uint32_t words = ((uint32_t)ms->rasterizationSamples + 31u) / 32u;
+      memcpy(r->sample_mask, ms->pSampleMask, (words < 2u ? words : 2u) * sizeof(VkSampleMask));
+    }
+  }
+  if ((r->has_ds = info->pDepthStencilState != NULL)) r->ds = *info->pDepthStencilState;
+  if ((r->has_cb = cb != NULL)) {
+    r->cb = *cb;
+    if (cb->attachmentCount) memcpy(r->blend, cb->pAttachments, cb->attachmentCount * sizeof(*r->blend));
+  }
+  if ((r->has_dyn = dyn != NULL)) {
+    r->dyn = *dyn;
+    if (dyn->dynamicStateCount) memcpy(r->dynamic, dyn->pDynamicStates, dyn->dynamicStateCount * sizeof(*r->dynamic));
+  }
+  if (!recipe_set_stages(r, shaders, shader_count)) {
+    recipe_free(r);
+    return NULL;
+  }
+  recipe_link(r);
+  return r;
+}
+
+static cj_pipeline_recipe_t* recipe_create_compute(const VkComputePipelineCreateInfo* info, const cj_pipeline_shader_t* shader) {
+  cj_pipeline_recipe_t* r = (cj_pipeline_recipe_t*)calloc(1, sizeof(*r));
+  if (!r) return NULL;
+  r->compute = true;
+  r->compute_info = *info;
+  if (!recipe_set_stages(r, shader, 1)) {
+    recipe_free(r);
+    return NULL;
+  }
+  return r;
+}
+
+static cj_pipeline_recipe_t* recipe_clone(const cj_pipeline_recipe_t* src) {
+  cj_pipeline_recipe_t* r = (cj_pipeline_recipe_t*)malloc(sizeof(*r));
+  if (!r) return NULL;
+  memcpy(r, src, sizeof(*r));
+  for (uint32_t i = 0; i < r->stage_count; i++) {
+    r->stages[i].code = malloc(src->stages[i].size);
+    if (!r->stages[i].code) {
+      r->stage_count = i;
+      recipe_free(r);
+      return NULL;
+    }
+    memcpy(r->stages[i].code, src->stages[i].code, src->stages[i].size);
+  }
+  recipe_link(r);
+  return r;
+}
+
+static bool recipe_uses(const cj_pipeline_recipe_t* r, const char* name) {
+  for (uint32_t i = 0; i < r->stage_count; i++) {
+    if (strcmp(r->stages[i].name, name) == 0) return true;
+  }
+  return false;
+}
+
+static const cj_shader_override_t* pcache_override(const cj_pipeline_cache_t* c, const char* name) {
+  if (!name) return NULL;
+  for (uint32_t i = 0; i < c->override_count; i++) {
+    if (strcmp(c->overrides[i].name, name) == 0) return &c->overrides[i];
+  }
+  return NULL;
+}
+
+/* Copy shaders into out, taking reloaded code for named stages */
+static void pcache_resolve_shaders(const cj_pipeline_cache_t* c, const cj_pipeline_shader_t* shaders,
+                                   uint32_t shader_count, cj_pipeline_shader_t* out) {
+  for (uint32_t i = 0; i < shader_count; i++) {
+    out[i] = shaders[i];
+    const cj_shader_override_t* o = pcache_override(c, shaders[i].name);
+    if (o) {
+      out[i].code = o->code;
+      out[i].size = o->size;
+    }
+  }
+}
+
+static int32_t pcache_find_pipeline(const cj_pipeline_cache_t* c, VkPipeline pipeline) {
+  for (uint32_t i = 0; i < c->pipeline_count; i++) {
+    if (c->pipelines[i].pipeline == pipeline) return (int32_t)i;
+  }
+  return -1;
+}
+
+/* Index of the newest build with this key, or -1 */
+static int32_t pcache_find_key(const cj_pipeline_cache_t* c, const cj_pipeline_key_t* key) {
+  for (uint32_t i = 0; i < c->pipeline_count; i++) {
+    if (c->pipelines[i].replaced_by == VK_NULL_HANDLE && pcache_key_equal(&c->pipelines[i].key, key)) return (int32_t)i;
+  }
+  return -1;
+}
+
+/* Takes over key and recipe on success */
+static bool pcache_add_pipeline(cj_pipeline_cache_t* c, cj_pipeline_key_t* key, VkPipeline pipeline, uint32_t refs,
+                                cj_pipeline_recipe_t* recipe) {
+  if (c->pipeline_count == c->pipeline_capacity) {
+    uint32_t cap = c->pipeline_capacity ? c->pipeline_capacity * 2 : 8;
+    cj_pipeline_entry_t* grown = (cj_pipeline_entry_t*)realloc(c->pipelines, cap * sizeof(*grown));
+    if (!grown) return false;
+    c->pipelines = grown;
+    c->pipeline_capacity = cap;
+  }
+  c->pipelines[c->pipeline_count++] = (cj_pipeline_entry_t){ *key, refs, pipeline, recipe, VK_NULL_HANDLE };
+  memset(key, 0, sizeof(*key));
+  return true;
+}
+
+static void pcache_remove_entry(cj_pipeline_cache_t* c, uint32_t index) {
+  /* Keep chains through the removed entry intact */
+  const cj_pipeline_entry_t* gone = &c->pipelines[index];
+  for (uint32_t i = 0; i < c->pipeline_count; i++) {
+    if (c->pipelines[i].replaced_by == gone->pipeline) c->pipelines[i].replaced_by = gone->replaced_by;
+  }
+  recipe_free(gone->recipe);
+  pcache_key_free(&c->pipelines[index].key);
+  c->pipelines[index] = c->pipelines[--c->pipeline_count];
+}
+
+/* Retire replaced entries nobody holds any more */
+static void pcache_sweep(cj_pipeline_cache_t* c) {
+  for (uint32_t i = 0; i < c->pipeline_count;) {
+    cj_pipeline_entry_t* e = &c->pipelines[i];
+    if (e->refs == 0 && e->replaced_by != VK_NULL_HANDLE) {
+      if (c->retire) c->retire(c->retire_user, e->pipeline);
+      else vkDestroyPipeline(c->device, e->pipeline, NULL);
+      pcache_remove_entry(c, i);
+    } else {
+      i++;
+    }
+  }
+}
+
+VkPipeline cj_pipeline_cache_graphics(cj_pipeline_cache_t* c, const VkGraphicsPipelineCreateInfo* info,
+                                      const cj_pipeline_shader_t* shaders, uint32_t shader_count) {
+  if (!c || !info || !shaders || shader_count == 0 || shader_count > CJ_PIPELINE_MAX_STAGES) return VK_NULL_HANDLE;
+  cj_pipeline_shader_t resolved[CJ_PIPELINE_MAX_STAGES];
+  pcache_resolve_shaders(c, shaders, shader_count, resolved);
+  cj_pipeline_key_t key;
+  if (!pcache_graphics_key(info, resolved, shader_count, &key)) {
+    fprintf(stderr, key.failed ? "cj_pipeline_cache_graphics: out of memory for the pipeline key\n"
+                               : "cj_pipeline_cache_graphics: pNext chains cannot be shared\n");
+    return VK_NULL_HANDLE;
+  }
+  int32_t found = pcache_find_key(c, &key);
+  if (found >= 0) {
+    pcache_key_free(&key);
+    c->pipelines[found].refs++;
+    return c->pipelines[found].pipeline;
+  }
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult res = pcache_build_graphics(c->device, c->handle, info, resolved, shader_count, &pipeline);
+  if (res != VK_SUCCESS) {
+    fprintf(stderr, "cj_pipeline_cache_graphics: pipeline creation failed (%d)\n", res);
+    pcache_key_free(&key);
+    return VK_NULL_HANDLE;
+  }
+  cj_pipeline_recipe_t* recipe = recipe_create_graphics(info, resolved, shader_count);
+  if (!pcache_add_pipeline(c, &key, pipeline, 1, recipe)) {
+    recipe_free(recipe);
+    pcache_key_free(&key);
+    vkDestroyPipeline(c->device, pipeline, NULL);
+    return VK_NULL_HANDLE;
+  }
+  return pipeline;
+}
+
+VkPipeline cj_pipeline_cache_compute(cj_pipeline_cache_t* c, const VkComputePipelineCreateInfo* info,
+                                     const cj_pipeline_shader_t* shader) {
+  if (!c || !info || !shader || shader->stage != VK_SHADER_STAGE_COMPUTE_BIT) return VK_NULL_HANDLE;
+  if (info->pNext) {
+    fprintf(stderr, "cj_pipeline_cache_compute: pNext chains cannot be shared\n");
+    return VK_NULL_HANDLE;
+  }
+  cj_pipeline_shader_t resolved;
+  pcache_resolve_shaders(c, shader, 1, &resolved);
+  cj_pipeline_key_t key;
+  if (!pcache_compute_key(info, &resolved, &key)) {
+    fprintf(stderr, "cj_pipeline_cache_compute: out of memory for the pipeline key\n");
+    return VK_NULL_HANDLE;
+  }
+  int32_t found = pcache_find_key(c, &key);
+  if (found >= 0) {
+    pcache_key_free(&key);
+    c->pipelines[found].refs++;
+    return c->pipelines[found].pipeline;
+  }
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult res = pcache_build_compute(c->device, c->handle, info, &resolved, &pipeline);
+  if (res != VK_SUCCESS) {
+    fprintf(stderr, "cj_pipeline_cache_compute: pipeline creation failed (%d)\n", res);
+    pcache_key_free(&key);
+    return VK_NULL_HANDLE;
+  }
+  cj_pipeline_recipe_t* recipe = c->reload ? recipe_create_compute(info, &resolved) : NULL;
+  if (!pcache_add_pipeline(c, &key, pipeline, 1, recipe)) {
+    recipe_free(recipe);
+    pcache_key_free(&key);
+    vkDestroyPipeline(c->device, pipeline, NULL);
+    return VK_NULL_HANDLE;
+  }
+  return pipeline;
+}
+
+VkPipeline cj_pipeline_cache_variant(cj_pipeline_cache_t* c, VkPipeline pipeline, VkRenderPass render_pass) {
+  if (!c || pipeline == VK_NULL_HANDLE || render_pass == VK_NULL_HANDLE) return VK_NULL_HANDLE;
+  int32_t from = pcache_find_pipeline(c, pipeline);
+  while (from >= 0 && c->pipelines[from].replaced_by != VK_NULL_HANDLE) {
+    from = pcache_find_pipeline(c, c->pipelines[from].replaced_by);
+  }
+  const cj_pipeline_recipe_t* base = from >= 0 ? c->pipelines[from].recipe : NULL;
+  if (!base || base->compute) return VK_NULL_HANDLE;
+
+  cj_pipeline_recipe_t* r = recipe_clone(base);
+  if (!r) return VK_NULL_HANDLE;
+  r->graphics.renderPass = render_pass;
+  cj_pipeline_shader_t shaders[CJ_PIPELINE_MAX_STAGES];
+  recipe_shaders(r, shaders);
+  cj_pipeline_key_t key;
+  if (!pcache_graphics_key(&r->graphics, shaders, r->stage_count, &key)) {
+    recipe_free(r);
+    return VK_NULL_HANDLE;
+  }
+  int32_t found = pcache_find_key(c, &key);
+  if (found >= 0) {
+    recipe_free(r);
+    pcache_key_free(&key);
+    c->pipelines[found].refs++;
+    return c->pipelines[found].pipeline;
+  }
+
+  VkPipeline variant = VK_NULL_HANDLE;
+  VkResult res = pcache_build_graphics(c->device, c->handle, &r->graphics, shaders, r->stage_count, &variant);
+  if (res != VK_SUCCESS) {
+    fprintf(stderr, "cj_pipeline_cache_variant: pipeline creation failed (%d)\n", res);
+    recipe_free(r);
+    pcache_key_free(&key);
+    return VK_NULL_HANDLE;
+  }
+  if (!pcache_add_pipeline(c, &key, variant, 1, r)) {
+    recipe_free(r);
+    pcache_key_free(&key);
+    vkDestroyPipeline(c->device, variant, NULL);
+    return VK_NULL_HANDLE;
+  }
+  return variant;
+}
+
+void cj_pipeline_cache_release(cj_pipeline_cache_t* c, VkPipeline pipeline) {
+  if (!c || pipeline == VK_NULL_HANDLE) return;
+  int32_t i = pcache_find_pipeline(c, pipeline);
+  if (i < 0 || --c->pipelines[i].refs != 0) return;
+  if (c->retire) c->retire(c->retire_user, pipeline);
+  else vkDestroyPipeline(c->device, pipeline, NULL);
+  pcache_remove_entry(c, (uint32_t)i);
+  pcache_sweep(c);
+}
+
+void cj_pipeline_cache_set_retire(cj_pipeline_cache_t* c, cj_pipeline_retire_fn_t retire, void* user) {
+  if (!c) return;
+  c->retire = retire;
+  c->retire_user = user;
+}
+
+void cj_pipeline_cache_enable_reload(cj_pipeline_cache_t* c) {
+  if (c) c->reload = true;
+}
+
+cj_pipeline_rebuild_t* cj_pipeline_cache_set_shader(cj_pipeline_cache_t* c, const char* name,
+                                                    const void* code, size_t size) {
+  if (!c || !name || !name[0] || !code || size == 0 || strlen(name) >= CJ_RECIPE_NAME_SIZE) return NULL;
+
+  void* copy = malloc(size);
+  if (!copy) return NULL;
+  memcpy(copy, code, size);
+  cj_shader_override_t* o = (cj_shader_override_t*)pcache_override(c, name);
+  if (!o) {
+    cj_shader_override_t* grown = (cj_shader_override_t*)realloc(c->overrides, (c->override_count + 1) * sizeof(*grown));
+    if (!grown) {
+      free(copy);
+      return NULL;
+    }
+    c->overrides = grown;
+    o = &c->overrides[c->override_count++];
+    memset(o, 0, sizeof(*o));
+    memcpy(o->name, name, strlen(name) + 1);
+  }
+  free(o->code);
+  o->code = copy;
+  o->size = size;
+  if (!c->reload) return NULL;
+
+  // Rebuild the newest build of every pipeline using the shader
+  cj_pipeline_rebuild_t* head = NULL;
+  cj_pipeline_rebuild_t** tail = &head;
+  for (uint32_t i = 0; i < c->pipeline_count; i++) {
+    const cj_pipeline_entry_t* e = &c->pipelines[i];
+    if (!e->recipe || e->replaced_by != VK_NULL_HANDLE || !recipe_uses(e->recipe, name)) continue;
+    cj_pipeline_rebuild_t* job = (cj_pipeline_rebuild_t*)calloc(1, sizeof(*job));
+    cj_pipeline_recipe_t* r = job ? recipe_clone(e->recipe) : NULL;
+    if (!r) {
+      free(job);
+      continue;
+    }
+    // Every reloaded stage, so rebuilds still in flight for other shaders are not undone
+    for (uint32_t s = 0; s < r->stage_count; s++) {
+      const cj_shader_override_t* so = pcache_override(c, r->stages[s].name);
+      void* stage_code = so ? malloc(so->size) : NULL;
+      if (!stage_code) continue;  /* Keeps the old code */
+      memcpy(stage_code, so->code, so->size);
+      free(r->stages[s].code);
+      r->stages[s].code = stage_code;
+      r->stages[s].size = so->size;
+    }
+    cj_pipeline_shader_t shaders[CJ_PIPELINE_MAX_STAGES];
+    recipe_shaders(r, shaders);
+    bool keyed = r->compute ? pcache_compute_key(&r->compute_info, &shaders[0], &job->key)
+                            : pcache_graphics_key(&r->graphics, shaders, r->stage_count, &job->key);
+    if (!keyed) {
+      recipe_free(r);
+      free(job);
+      continue;
+    }
+    job->device = c->device;
+    job->handle = c->handle;
+    job->target = e->pipeline;
+    job->recipe = r;
+    job->result = VK_NOT_READY;
+    *tail = job;
+    tail = &job->next;
+  }
+  return head;
+}
+
+cj_pipeline_rebuild_t* cj_pipeline_rebuild_next(const cj_pipeline_rebuild_t* job) {
+  return job ? job->next : NULL;
+}
+
+void cj_pipeline_rebuild_run(cj_pipeline_rebuild_t* job) {
+  if (!job) return;
+  cj_pipeline_shader_t shaders[CJ_PIPELINE_MAX_STAGES];
+  recipe_shaders(job->recipe, shaders);
+  if (job->recipe->compute) {
+    job->result = pcache_build_compute(job->device, job->handle, &job->recipe->compute_info, &shaders[0], &job->pipeline);
+  } else {
+    job->result = pcache_build_graphics(job->device, job->handle, &job->recipe->graphics, shaders,
+                                        job->recipe->stage_count, &job->pipeline);
+  }
+}
+
+void cj_pipeline_rebuild_discard(cj_pipeline_rebuild_t* job) {
+  if (!job) return;
+  if (job->pipeline != VK_NULL_HANDLE) vkDestroyPipeline(job->device, job->pipeline, NULL);
+  recipe_free(job->recipe);
+  pcache_key_free(&job->key);
+  free(job);
+}
+
+bool cj_pipeline_cache_finish_rebuild(cj_pipeline_cache_t* c, cj_pipeline_rebuild_t* job) {
+  if (!c || !job) return false;
+  int32_t end = pcache_find_pipeline(c, job->target);
+  if (job->result != VK_SUCCESS || end < 0) {
+    // Failed, or every holder released the old pipeline meanwhile
+    if (job->result != VK_SUCCESS) fprintf(stderr, "cj_pipeline_cache: rebuilding a pipeline failed (%d)\n", job->result);
+    cj_pipeline_rebuild_discard(job);
+    return false;
+  }
+  // A later job for the same pipeline extends the chain built by an earlier one
+  while (c->pipelines[end].replaced_by != VK_NULL_HANDLE) {
+    int32_t next = pcache_find_pipeline(c, c->pipelines[end].replaced_by);
+    if (next < 0) break;
+    end = next;
+  }
+
+  bool installed = false;
+  int32_t same = -1;
+  for (uint32_t i = 0; i < c->pipeline_count; i++) {
+    if (pcache_key_equal(&c->pipelines[i].key, &job->key)) { same = (int32_t)i; break; }
+  }
+  if (same == end) {
+    /* The code did not change after all */
+  } else if (same >= 0) {
+    // Back to code an existing build already has (an undo): move holders there
+    c->pipelines[same].replaced_by = VK_NULL_HANDLE;
+    c->pipelines[end].replaced_by = c->pipelines[same].pipeline;
+    installed = true;
+  } else if (pcache_add_pipeline(c, &job->key, job->pipeline, 0, job->recipe)) {
+    c->pipelines[end].replaced_by = job->pipeline;
+    job->pipeline = VK_NULL_HANDLE;
+    job->recipe = NULL;
+    installed = true;
+  }
+  cj_pipeline_rebuild_discard(job);
+  if (installed) {
+    c->generation++;
+    pcache_sweep(c);
+  }
+  return installed;
+}
+
+uint64_t cj_pipeline_cache_generation(const cj_pipeline_cache_t* c) {
+  return c ? c->generation : 0;
+}
+
+VkPipeline cj_pipeline_cache_current(cj_pipeline_cache_t* c, VkPipeline pipeline) {
+  if (!c || pipeline == VK_NULL_HANDLE) return pipeline;
+  int32_t from = pcache_find_pipeline(c, pipeline);
+  if (from < 0 || c->pipelines[from].replaced_by == VK_NULL_HANDLE) return pipeline;
+  int32_t end = from;
+  while (c->pipelines[end].replaced_by != VK_NULL_HANDLE) {
+    int32_t next = pcache_find_pipeline(c, c->pipelines[end].replaced_by);
+    if (next < 0) break;
+    end = next;
+  }
+  VkPipeline newest = c->pipelines[end].pipeline;
+  c->pipelines[end].refs++;
+  c->pipelines[from].refs--;
+  pcache_sweep(c);
+  return newest;
+}
@@ -0,0 +1,450 @@
+/* CJelly profiler: per-thread zone rings, aggregates, trace capture and GPU timestamps */
+
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <cjelly/cj_profiler.h>
+#include <cjelly/profiler_internal.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#if CJ_ENABLE_PROFILER
+
+/* Zones a thread can record between two collections; more are dropped (power of two) */
+#define CJ_PROFILER_RING_SIZE 4096u
+
+/* Distinct zone names aggregated; later names are only captured */
+#define CJ_PROFILER_MAX_ZONE_NAMES 64u
+
+/* Bounds the memory a forgotten capture can take (about 32 MiB) */
+#define CJ_PROFILER_MAX_CAPTURE_EVENTS (1u << 20)
+
+typedef struct cj_profiler_event_t {
+  const char* name;
+  uint64_t start_ns;
+  uint64_t end_ns;
+} cj_profiler_event_t;
+
+/* Single-producer single-consumer ring: the owning thread pushes, the collector pops */
+typedef struct cj_profiler_ring_t {
+  cj_profiler_event_t events[CJ_PROFILER_RING_SIZE];
+  atomic_uint head;                   /* Events published by the owner */
+  atomic_uint tail;                   /* Events consumed by the collector */
+  atomic_uint dropped;                /* Zones lost to a full ring since the last collection */
+  atomic_bool in_use;                 /* Owned by a live thread; free rings are reused */
+  uint32_t thread_id;                 /* Trace thread id, stable for the ring */
+  struct cj_profiler_ring_t* next;    /* Registry link; rings are never unlinked */
+} cj_profiler_ring_t;
+
+typedef struct cj_profiler_capture_event_t {
+  cj_profiler_event_t event;
+  uint32_t thread_id;
+} cj_profiler_capture_event_t;
+
+static atomic_bool g_enabled;
+static _Atomic(cj_profiler_ring_t*) g_rings;
+static atomic_uint g_ring_count;
+static _Thread_local cj_profiler_ring_t* t_ring;
+
+/* Collector state, main thread only */
+static cj_profiler_zone_stat_t g_stats[CJ_PROFILER_MAX_ZONE_NAMES];
+static uint32_t g_stat_count;
+static bool g_capturing;
+static uint64_t g_capture_start_ns;
+static cj_profiler_capture_event_t* g_capture;
+static size_t g_capture_count;
+static size_t g_capture_capacity;
+static uint64_t g_capture_dropped;
+
+static uint64_t cj_profiler__now_ns(void) {
+#ifdef _WIN32
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  /* Split to avoid overflowing counter * 1e9 */
+  uint64_t ticks = (uint64_t)counter.QuadPart, freq = (uint64_t)frequency.QuadPart;
+  return (ticks / freq) * 1000000000ULL + ((ticks % freq) * 1000000000ULL) / freq;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* Thread exit hands the ring back for reuse; its remaining events are still collected */
+#ifdef _WIN32
+static DWORD g_ring_fls = FLS_OUT_OF_INDEXES;
+static INIT_ONCE g_ring_once = INIT_ONCE_STATIC_INIT;
+
+static void WINAPI cj_profiler__release_ring(void* ring) {
+  if (ring) atomic_store_explicit(&((cj_profiler_ring_t*)ring)->in_use, false, memory_order_release);
+}
+
+static BOOL CALLBACK cj_profiler__init_key(PINIT_ONCE once, void* param, void** context) {
+  (void)once; (void)param; (void)context;
+  g_ring_fls = FlsAlloc(cj_profiler__release_ring);
+  return TRUE;
+}
+
+static void cj_profiler__watch_thread(cj_profiler_ring_t* ring) {
+  InitOnceExecuteOnce(&g_ring_once, cj_profiler__init_key, NULL, NULL);
+  if (g_ring_fls != FLS_OUT_OF_INDEXES) FlsSetValue(g_ring_fls, ring);
+}
+#else
+static pthread_key_t g_ring_key;
+static pthread_once_t g_ring_once = PTHREAD_ONCE_INIT;
+static bool g_ring_key_valid;
+
+static void cj_profiler__release_ring(void* ring) {
+  if (ring) atomic_store_explicit(&((cj_profiler_ring_t*)ring)->in_use, false, memory_order_release);
+}
+
+static void cj_profiler__init_key(void) {
+  g_ring_key_valid = pthread_key_create(&g_ring_key, cj_profiler__release_ring) == 0;
+}
+
+static void cj_profiler__watch_thread(cj_profiler_ring_t* ring) {
+  pthread_once(&g_ring_once, cj_profiler__init_key);
+  if (g_ring_key_valid) pthread_setspecific(g_ring_key, ring);
+}
+#endif
+
+/* The calling thread's ring, claimed or created on its first zone */
+static cj_profiler_ring_t* cj_profiler__thread_ring(void) {
+  if (t_ring) return t_ring;
+
+  cj_profiler_ring_t* ring = NULL;
+  for (cj_profiler_ring_t* r = atomic_load_explicit(&g_rings, memory_order_acquire); r; r = r->next) {
+    bool expected = false;
+    if (atomic_compare_exchange_strong_explicit(&r->in_use, &expected, true, memory_order_acquire, memory_order_relaxed)) {
+      ring = r;
+      break;
+    }
+  }
+
+  if (!ring) {
+    ring = (cj_profiler_ring_t*)calloc(1, sizeof(*ring));
+    if (!ring) return NULL;
+    atomic_init(&ring->head, 0u);
+    atomic_init(&ring->tail, 0u);
+    atomic_init(&ring->dropped, 0u);
+    atomic_init(&ring->in_use, true);
+    ring->thread_id = atomic_fetch_add(&g_ring_count, 1u) + 1u;
+    cj_profiler_ring_t* head = atomic_load_explicit(&g_rings, memory_order_relaxed);
+    do {
+      ring->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&g_rings, &head, ring, memory_order_release, memory_order_relaxed));
+  }
+
+  cj_profiler__watch_thread(ring);
+  t_ring = ring;
+  return ring;
+}
+
+CJ_API bool cj_profiler_available(void) {
+  return true;
+}
+
+CJ_API void cj_profiler_set_enabled(bool enabled) {
+  atomic_store_explicit(&g_enabled, enabled, memory_order_relaxed);
+}
+
+CJ_API bool cj_profiler_is_enabled(void) {
+  return atomic_load_explicit(&g_enabled, memory_order_relaxed);
+}
+
+CJ_API uint64_t cj_profiler_zone_begin(const char* name) {
+  (void)name;
+  if (!atomic_load_explicit(&g_enabled, memory_order_relaxed)) return 0;
+  uint64_t now = cj_profiler__now_ns();
+  return now ? now : 1;
+}
+
+CJ_API void cj_profiler_zone_end(const char* name, uint64_t start) {
+  if (start == 0 || !name) return;
+  uint64_t end = cj_profiler__now_ns();
+  cj_profiler_ring_t* ring = cj_profiler__thread_ring();
+  if (!ring) return;
+
+  unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+  if (head - tail >= CJ_PROFILER_RING_SIZE) {
+    atomic_fetch_add_explicit(&ring->dropped, 1u, memory_order_relaxed);
+    return;
+  }
+  cj_profiler_event_t* ev = &ring->events[head & (CJ_PROFILER_RING_SIZE - 1u)];
+  ev->name = name;
+  ev->start_ns = start;
+  ev->end_ns = end;
+  atomic_store_explicit(&ring->head, head + 1u, memory_order_release);
+}
+
+/* Aggregate entry for a name: pointer match first, names from other translation units by value */
+static cj_profiler_zone_stat_t* cj_profiler__stat(const char* name) {
+  for (uint32_t i = 0; i < g_stat_count; i++) {
+    if (g_stats[i].name == name) return &g_stats[i];
+  }
+  for (uint32_t i = 0; i < g_stat_count; i++) {
+    if (strcmp(g_stats[i].name, name) == 0) return &g_stats[i];
+  }
+  if (g_stat_count >= CJ_PROFILER_MAX_ZONE_NAMES) return NULL;
+  cj_profiler_zone_stat_t* stat = &g_stats[g_stat_count++];
+  memset(stat, 0, sizeof(*stat));
+  stat->name = name;
+  return stat;
+}
+
+static void cj_profiler__capture(const cj_profiler_event_t* ev, uint32_t thread_id) {
+  if (ev->start_ns < g_capture_start_ns) return;
+  if (g_capture_count == g_capture_capacity) {
+    size_t capacity = g_capture_capacity ? g_capture_capacity * 2 : 4096;
+    if (capacity > CJ_PROFILER_MAX_CAPTURE_EVENTS) capacity = CJ_PROFILER_MAX_CAPTURE_EVENTS;
+    if (capacity == g_capture_capacity) {
+      g_capture_dropped++;
+      return;
+    }
+    cj_profiler_capture_event_t* grown =
+        (cj_profiler_capture_event_t*)realloc(g_capture, capacity * sizeof(*grown));
+    if (!grown) {
+      g_capture_dropped++;
+      return;
+    }
+    g_capture = grown;
+    g_capture_capacity = capacity;
+  }
+  g_capture[g_capture_count].event = *ev;
+  g_capture[g_capture_count].thread_id = thread_id;
+  g_capture_count++;
+}
+
+CJ_API void cj_profiler_collect(void) {
+  for (cj_profiler_ring_t* ring = atomic_load_explicit(&g_rings, memory_order_acquire); ring; ring = ring->next) {
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    for (; tail != head; tail++) {
+      const cj_profiler_event_t* ev = &ring->events[tail & (CJ_PROFILER_RING_SIZE - 1u)];
+      uint64_t duration = ev->end_ns > ev->start_ns ? ev->end_ns - ev->start_ns : 0;
+      cj_profiler_zone_stat_t* stat = cj_profiler__stat(ev->name);
+      if (stat) {
+        stat->count++;
+        stat->total_ns += duration;
+        if (duration > stat->max_ns) stat->max_ns = duration;
+      }
+      if (g_capturing) cj_profiler__capture(ev, ring->thread_id);
+    }
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+    unsigned dropped = atomic_exchange_explicit(&ring->dropped, 0u, memory_order_relaxed);
+    if (g_capturing) g_capture_dropped += dropped;
+  }
+}
+
+CJ_API uint32_t cj_profiler_zone_stats(cj_profiler_zone_stat_t* out_stats, uint32_t max_stats, bool reset) {
+  cj_profiler_collect();
+  uint32_t count = g_stat_count;
+  if (out_stats) {
+    for (uint32_t i = 0; i < count && i < max_stats; i++) out_stats[i] = g_stats[i];
+  }
+  if (reset) {
+    /* Names stay in place so the order is stable from one report to the next */
+    for (uint32_t i = 0; i < count; i++) {
+      g_stats[i].count = 0;
+      g_stats[i].total_ns = 0;
+      g_stats[i].max_ns = 0;
+    }
+  }
+  return count;
+}
+
+CJ_API void cj_profiler_begin_capture(void) {
+  /* Zones from before the capture are dropped by their start time */
+  cj_profiler_collect();
+  g_capture_count = 0;
+  g_capture_dropped = 0;
+  g_capture_start_ns = cj_profiler__now_ns();
+  g_capturing = true;
+}
+
+/* Write s as a JSON string body */
+static void cj_profiler__write_json_string(FILE* f, const char* s) {
+  for (; *s; s++) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\') {
+      fputc('\\', f);
+      fputc((int)c, f);
+    } else if (c < 0x20) {
+      fprintf(f, "\\u%04x", c);
+    } else {
+      fputc((int)c, f);
+    }
+  }
+}
+
+CJ_API cj_result_t cj_profiler_end_capture(const char* path) {
+  if (!g_capturing || !path) return CJ_E_INVALID_ARGUMENT;
+  cj_profiler_collect();
+  g_capturing = false;
+
+  FILE* f = fopen(path, "w");
+  if (!f) {
+    fprintf(stderr, "cj_profiler_end_capture: cannot open %s\n", path);
+    return CJ_E_UNKNOWN;
+  }
+
+  /* Complete ("X") events in microseconds since the capture began */
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+  uint32_t threads = atomic_load(&g_ring_count);
+  for (uint32_t t = 1; t <= threads; t++) {
+    fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"cjelly thread %u\"}},\n",
+            t, t);
+  }
+  for (size_t i = 0; i < g_capture_count; i++) {
+    const cj_profiler_capture_event_t* ce = &g_capture[i];
+    uint64_t duration = ce->event.end_ns > ce->event.start_ns ? ce->event.end_ns - ce->event.start_ns : 0;
+    fputs("{\"name\":\"", f);
+    cj_profiler__write_json_string(f, ce->event.name);
+    fprintf(f, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n", ce->thread_id,
+            (double)(ce->event.start_ns - g_capture_start_ns) / 1000.0, (double)duration / 1000.0);
+  }
+  /* Trailing metadata keeps every event line ending in a comma */
+  fprintf(f, "{\"name\":\"dropped_zones\",\"ph\":\"M\",\"pid\":1,\"args\":{\"count\":%llu}}\n]}\n",
+          (unsigned long long)g_capture_dropped);
+
+  bool ok = !ferror(f);
+  if (fclose(f) != 0) ok = false;
+  if (g_capture_dropped) {
+    fprintf(stderr, "cj_profiler_end_capture: %llu zones were dropped\n", (unsigned long long)g_capture_dropped);
+  }
+  free(g_capture);
+  g_capture = NULL;
+  g_capture_count = g_capture_capacity = 0;
+  return ok ? CJ_SUCCESS : CJ_E_UNKNOWN;
+}
+
+bool cj_gpu_timer_init(cj_gpu_timer_t* timer, VkDevice device, VkPhysicalDevice physical, uint32_t queue_family) {
+  if (!timer || !device || !physical) return false;
+  memset(timer, 0, sizeof(*timer));
+
+  uint32_t family_count = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physical, &family_count, NULL);
+  if (queue_family >= family_count || family_count > 64) return false;
+  VkQueueFamilyProperties families[64];
+  vkGetPhysicalDeviceQueueFamilyProperties(physical, &family_count, families);
+  uint32_t bits = families[queue_family].timestampValidBits;
+  if (bits == 0) return false;
+
+  VkPhysicalDeviceProperties props;
+  vkGetPhysicalDeviceProperties(physical, &props);
+
+  VkQueryPoolCreateInfo qi = {0};
+  qi.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  qi.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  qi.queryCount = CJ_GPU_TIMER_QUERY_COUNT;
+  if (vkCreateQueryPool(device, &qi, NULL, &timer->pool) != VK_SUCCESS) {
+    fprintf(stderr, "cj_gpu_timer_init: failed to create timestamp query pool\n");
+    timer->pool = VK_NULL_HANDLE;
+    return false;
+  }
+  timer->device = device;
+  timer->period_ns = (double)props.limits.timestampPeriod;
+  timer->valid_mask = bits >= 64 ? UINT64_MAX : ((1ULL << bits) - 1ULL);
+  return true;
+}
+
+void cj_gpu_timer_destroy(cj_gpu_timer_t* timer) {
+  if (!timer) return;
+  if (timer->pool != VK_NULL_HANDLE) vkDestroyQueryPool(timer->device, timer->pool, NULL);
+  memset(timer, 0, sizeof(*timer));
+}
+
+void cj_gpu_timer_begin_frame(cj_gpu_timer_t* timer, VkCommandBuffer cmd, uint64_t frame_index) {
+  if (!timer || timer->pool == VK_NULL_HANDLE) return;
+  vkCmdResetQueryPool(cmd, timer->pool, 0, CJ_GPU_TIMER_QUERY_COUNT);
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timer->pool, 0);
+  timer->frame_index = frame_index;
+  timer->zone_count = 0;
+  timer->pending = true;
+}
+
+void cj_gpu_timer_end_frame(cj_gpu_timer_t* timer, VkCommandBuffer cmd) {
+  if (!timer || !timer->pending) return;
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timer->pool, 1);
+}
+
+void cj_gpu_timer_discard(cj_gpu_timer_t* timer) {
+  if (timer) timer->pending = false;
+}
+
+uint32_t cj_gpu_timer_begin(cj_gpu_timer_t* timer, VkCommandBuffer cmd, const char* name) {
+  if (!timer || !timer->pending || timer->zone_count >= CJ_PROFILER_MAX_GPU_ZONES) return CJ_GPU_TIMER_NO_ZONE;
+  uint32_t zone = timer->zone_count++;
+  snprintf(timer->names[zone], CJ_PROFILER_NAME_SIZE, "%s", name ? name : "");
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timer->pool, 2u + 2u * zone);
+  return zone;
+}
+
+void cj_gpu_timer_end(cj_gpu_timer_t* timer, VkCommandBuffer cmd, uint32_t zone) {
+  if (!timer || zone == CJ_GPU_TIMER_NO_ZONE || zone >= timer->zone_count) return;
+  vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timer->pool, 3u + 2u * zone);
+}
+
+bool cj_gpu_timer_read(cj_gpu_timer_t* timer, cj_profiler_frame_stats_t* out_stats) {
+  if (!timer || !timer->pending || !out_stats) return false;
+  timer->pending = false;
+
+  /* The slot fence signaled, so without WAIT this only fails for queries never submitted */
+  uint64_t ticks[CJ_GPU_TIMER_QUERY_COUNT];
+  uint32_t count = 2u + 2u * timer->zone_count;
+  if (vkGetQueryPoolResults(timer->device, timer->pool, 0, count, sizeof(ticks), ticks, sizeof(uint64_t),
+                            VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+    return false;
+  }
+
+  /* Masked differences survive the counter wrapping */
+  double ms_per_tick = timer->period_ns / 1e6;
+  out_stats->gpu_frame_index = timer->frame_index;
+  out_stats->gpu_ms = (double)((ticks[1] - ticks[0]) & timer->valid_mask) * ms_per_tick;
+  out_stats->gpu_zone_count = timer->zone_count;
+  for (uint32_t i = 0; i < timer->zone_count; i++) {
+    memcpy(out_stats->gpu_zones[i].name, timer->names[i], CJ_PROFILER_NAME_SIZE);
+    out_stats->gpu_zones[i].ms = (double)((ticks[3 + 2 * i] - ticks[2 + 2 * i]) & timer->valid_mask) * ms_per_tick;
+  }
+  return true;
+}
+
+#else /* !CJ_ENABLE_PROFILER */
+
+CJ_API bool cj_profiler_available(void) { return false; }
+CJ_API void cj_profiler_set_enabled(bool enabled) { (void)enabled; }
+CJ_API bool cj_profiler_is_enabled(void) { return false; }
+CJ_API uint64_t cj_profiler_zone_begin(const char* name) { (void)name; return 0; }
+CJ_API void cj_profiler_zone_end(const char* name, uint64_t start) { (void)name; (void)start; }
+CJ_API void cj_profiler_collect(void) {}
+
+CJ_API uint32_t cj_profiler_zone_stats(cj_profiler_zone_stat_t* out_stats, uint32_t max_stats, bool reset) {
+  (void)out_stats; (void)max_stats; (void)reset;
+  return 0;
+}
+
+CJ_API void cj_profiler_begin_capture(void) {}
+
+CJ_API cj_result_t cj_profiler_end_capture(const char* path) {
+  (void)path;
+  return CJ_E_UNSUPPORTED;
+}
+
+#endif
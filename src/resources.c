@@ -13,15 +13,15 @@ CJ_API cj_handle_t cj_texture_create(cj_engine_t* e, const cj_texture_desc_t* d)
     return null_handle;
   }
 
-  uint32_t slot = 0;
-  uint64_t h = cj_engine_res_alloc(e, CJ_RES_TEX, &slot);
+  uint32_t index = 0;
+  uint64_t h = cj_engine_res_alloc(e, CJ_RES_TEX, &index);
   if (h == 0) {
     cj_handle_t null_handle = {0};
     return null_handle;
   }
 
   // Create the actual Vulkan texture
-  if (!cj_engine_create_texture(e, slot, d)) {
+  if (!cj_engine_create_texture(e, index, d)) {
     cj_engine_res_release(e, CJ_RES_TEX, h);
     cj_handle_t null_handle = {0};
     return null_handle;
@@ -31,15 +31,40 @@ CJ_API cj_handle_t cj_texture_create(cj_engine_t* e, const cj_texture_desc_t* d)
   return out;
 }
 CJ_API void        cj_texture_retain(cj_engine_t* e, cj_handle_t h) { uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen; cj_engine_res_retain(e, CJ_RES_TEX, v); }
+/* The last release queues the Vulkan objects for deletion */
 CJ_API void        cj_texture_release(cj_engine_t* e, cj_handle_t h) {
   uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen;
-  uint32_t slot = cj_engine_res_slot(e, CJ_RES_TEX, v);
-  if (slot > 0) {
-    cj_engine_destroy_texture(e, slot - 1); // slot is 1-based, array is 0-based
-  }
   cj_engine_res_release(e, CJ_RES_TEX, v);
 }
 CJ_API uint32_t    cj_texture_descriptor_slot(cj_engine_t* e, cj_handle_t h) { uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen; return cj_engine_res_slot(e, CJ_RES_TEX, v); }
+CJ_API void        cj_texture_request_extent(cj_engine_t* e, cj_handle_t h, uint32_t width, uint32_t height) {
+  uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen;
+  uint32_t index = cj_engine_res_index(e, CJ_RES_TEX, v);
+  if (index != 0) cj_engine_request_texture_extent(e, index, width, height);
+}
+CJ_API uint32_t    cj_texture_resident_mip(cj_engine_t* e, cj_handle_t h) {
+  uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen;
+  uint32_t index = cj_engine_res_index(e, CJ_RES_TEX, v);
+  return index != 0 ? cj_engine_texture_resident_mip(e, index) : 0u;
+}
+CJ_API bool        cj_texture_format_supported(cj_engine_t* e, cj_format_t format) { return cj_engine_format_supported(e, format); }
+CJ_API bool        cj_texture_can_generate_mips(cj_engine_t* e, cj_format_t format) { return cj_engine_format_can_generate_mips(e, format); }
+CJ_API cj_format_t cj_texture_pick_format(cj_engine_t* e, const cj_format_t* formats, uint32_t count) {
+  for (uint32_t i = 0; formats && i < count; i++) {
+    if (cj_engine_format_supported(e, formats[i])) return formats[i];
+  }
+  return CJ_FORMAT_UNDEFINED;
+}
+
+CJ_API cj_upload_ticket_t cj_upload_texture(cj_engine_t* e, cj_handle_t h, const cj_texture_upload_t* upload) {
+  uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen;
+  uint32_t index = cj_engine_res_index(e, CJ_RES_TEX, v);
+  if (index == 0 || !upload) return 0;
+  return cj_engine_upload_texture(e, index, upload);
+}
+CJ_API cj_upload_ticket_t cj_upload_flush(cj_engine_t* e) { return cj_upload_queue_flush(cj_engine_uploads(e)); }
+CJ_API bool        cj_upload_is_complete(cj_engine_t* e, cj_upload_ticket_t ticket) { return cj_upload_queue_done(cj_engine_uploads(e), ticket); }
+CJ_API void        cj_upload_wait(cj_engine_t* e, cj_upload_ticket_t ticket) { cj_upload_queue_wait(cj_engine_uploads(e), ticket); }
 
 CJ_API cj_handle_t cj_buffer_create(cj_engine_t* e, const cj_buffer_desc_t* d) {
   if (!e || !d) {
@@ -47,15 +72,15 @@ CJ_API cj_handle_t cj_buffer_create(cj_engine_t* e, const cj_buffer_desc_t* d) {
     return null_handle;
   }
 
-  uint32_t slot = 0;
-  uint64_t h = cj_engine_res_alloc(e, CJ_RES_BUF, &slot);
+  uint32_t index = 0;
+  uint64_t h = cj_engine_res_alloc(e, CJ_RES_BUF, &index);
   if (h == 0) {
     cj_handle_t null_handle = {0};
     return null_handle;
   }
 
   // Create the actual Vulkan buffer
-  if (!cj_engine_create_buffer(e, slot, d)) {
+  if (!cj_engine_create_buffer(e, index, d)) {
     cj_engine_res_release(e, CJ_RES_BUF, h);
     cj_handle_t null_handle = {0};
     return null_handle;
@@ -64,13 +89,16 @@ CJ_API cj_handle_t cj_buffer_create(cj_engine_t* e, const cj_buffer_desc_t* d) {
   cj_handle_t out = { (uint32_t)(h >> 32), (uint32_t)(h & 0xffffffffu) };
   return out;
 }
+CJ_API cj_upload_ticket_t cj_upload_buffer(cj_engine_t* e, cj_handle_t h, uint64_t offset, const void* data, uint64_t size) {
+  uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen;
+  uint32_t index = cj_engine_res_index(e, CJ_RES_BUF, v);
+  if (index == 0) return 0;
+  return cj_engine_upload_buffer(e, index, offset, data, size);
+}
 CJ_API void        cj_buffer_retain(cj_engine_t* e, cj_handle_t h) { uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen; cj_engine_res_retain(e, CJ_RES_BUF, v); }
+/* The last release queues the Vulkan objects for deletion */
 CJ_API void        cj_buffer_release(cj_engine_t* e, cj_handle_t h) {
   uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen;
-  uint32_t slot = cj_engine_res_slot(e, CJ_RES_BUF, v);
-  if (slot > 0) {
-    cj_engine_destroy_buffer(e, slot - 1); // slot is 1-based, array is 0-based
-  }
   cj_engine_res_release(e, CJ_RES_BUF, v);
 }
 CJ_API uint32_t    cj_buffer_descriptor_slot(cj_engine_t* e, cj_handle_t h) { uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen; return cj_engine_res_slot(e, CJ_RES_BUF, v); }
@@ -81,30 +109,20 @@ CJ_API cj_handle_t cj_sampler_create(cj_engine_t* e, const cj_sampler_desc_t* d)
     return null_handle;
   }
 
-  uint32_t slot = 0;
-  uint64_t h = cj_engine_res_alloc(e, CJ_RES_SMP, &slot);
+  // Identical descriptors share one sampler; this adds a reference to it
+  uint64_t h = cj_engine_acquire_sampler(e, d, NULL);
   if (h == 0) {
     cj_handle_t null_handle = {0};
     return null_handle;
   }
 
-  // Create the actual Vulkan sampler
-  if (!cj_engine_create_sampler(e, slot, d)) {
-    cj_engine_res_release(e, CJ_RES_SMP, h);
-    cj_handle_t null_handle = {0};
-    return null_handle;
-  }
-
   cj_handle_t out = { (uint32_t)(h >> 32), (uint32_t)(h & 0xffffffffu) };
   return out;
 }
 CJ_API void        cj_sampler_retain(cj_engine_t* e, cj_handle_t h) { uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen; cj_engine_res_retain(e, CJ_RES_SMP, v); }
+/* The last release queues the Vulkan objects for deletion */
 CJ_API void        cj_sampler_release(cj_engine_t* e, cj_handle_t h) {
   uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen;
-  uint32_t slot = cj_engine_res_slot(e, CJ_RES_SMP, v);
-  if (slot > 0) {
-    cj_engine_destroy_sampler(e, slot - 1); // slot is 1-based, array is 0-based
-  }
   cj_engine_res_release(e, CJ_RES_SMP, v);
 }
 CJ_API uint32_t    cj_sampler_descriptor_slot(cj_engine_t* e, cj_handle_t h) { uint64_t v = ((uint64_t)h.idx << 32) | (uint64_t)h.gen; return cj_engine_res_slot(e, CJ_RES_SMP, v); }
@@ -10,12 +10,26 @@
 #include <cjelly/cj_resources.h>
 #include <cjelly/cj_result.h>
 #include <cjelly/cj_types.h>
+#include <cjelly/cj_window.h>
+#include <cjelly/cj_mesh.h>
+#include <cjelly/format/3d/mesh.h>
 #include <cjelly/engine_internal.h>
 #include <cjelly/textured_internal.h>
 #include <cjelly/bindless_internal.h>
-#include <shaders/blur.vert.h>
+#include <cjelly/profiler_internal.h>
+#include <cjelly/rgraph_internal.h>
+#include <shaders/fullscreen.vert.h>
 #include <shaders/blur.frag.h>
+#include <shaders/blur_down.frag.h>
+#include <shaders/blur.comp.h>
 #include <shaders/textured.vert.h>
+#include <shaders/textured_table.frag.h>
+#include <shaders/sprite.vert.h>
+#include <shaders/sprite.frag.h>
+#include <shaders/mesh.vert.h>
+#include <shaders/mesh.frag.h>
+#include <shaders/mesh_cull.comp.h>
+#include <shaders/textured_simple.frag.h>
 
 /* Render graph node types */
 typedef enum {
@@ -23,64 +37,254 @@ typedef enum {
     CJ_RGRAPH_NODE_BLUR = 1,
     CJ_RGRAPH_NODE_TEXTURED = 2,
     CJ_RGRAPH_NODE_COLOR = 3,
+    CJ_RGRAPH_NODE_SPRITE = 4,
+    CJ_RGRAPH_NODE_MESH = 5,
     CJ_RGRAPH_NODE_COUNT
 } cj_rgraph_node_type_t;
 
 /* Forward declarations */
 typedef struct cj_rgraph_param_t cj_rgraph_param_t;
 
+/* Blur limits */
+#define CJ_RGRAPH_BLUR_MAX_LEVELS 2u   /* Halvings of the input before blurring (half, quarter) */
+#define CJ_RGRAPH_BLUR_MAX_TAPS 64     /* Kernel reach in blurred texels; MAX_RADIUS in blur.comp */
+#define CJ_RGRAPH_BLUR_AUTO_TAPS 12.0f /* Auto downsampling halves until the reach fits this */
+#define CJ_RGRAPH_BLUR_TILE 256u       /* Texels per compute workgroup; TILE in blur.comp */
+
+/* Execute extents a graph keeps images for at once, so windows of different sizes can share it */
+#define CJ_RGRAPH_EXTENTS 4u
+
+/* Parameter blur nodes follow while no radius is set */
+static const cj_str_t blur_intensity_name = { "blur_intensity", sizeof("blur_intensity") - 1u };
+
+/* A node-owned image of a blur chain */
+typedef struct cj_rgraph_blur_image_t {
+    VkImage image;
+    cj_gpu_alloc_t alloc;
+    VkImageView view;
+    VkFramebuffer framebuffer;        /* Transient render pass target; VK_NULL_HANDLE for storage images */
+    VkDescriptorPool set_pool;        /* Engine node pool set came from (not owned) */
+    VkDescriptorSet set;              /* Samples the image from the fragment stage */
+} cj_rgraph_blur_image_t;
+
+/* Images a blur uses at one downsample level; level 0 is the target size */
+typedef struct cj_rgraph_blur_level_t {
+    VkExtent2D extent;
+    cj_rgraph_blur_image_t down;      /* Input reduced to this level; unused at level 0 */
+    cj_rgraph_blur_image_t work[2];   /* Horizontal result; the vertical one too on the compute path */
+    VkDescriptorSet compute_sets[2];  /* Input and output of each compute pass (from the chain's compute_pool) */
+    VkImageView compute_input;        /* Input compute_sets[0] was last written with */
+
+    /* Async compute path. Slot async_frame & 1 goes to the compute queue while the
+     * other slot's result, queued the frame before, is composited */
+    cj_rgraph_blur_image_t async_stage[2]; /* Copy of the input the compute queue blurs */
+    cj_rgraph_blur_image_t async_work;     /* Horizontal result; only the compute queue uses it */
+    cj_rgraph_blur_image_t async_out[2];   /* Result handed back to the graphics queue */
+    VkDescriptorSet async_sets[2][2];      /* Per slot: stage to work, work to out (from the chain's compute_pool) */
+    uint64_t async_queued[2];              /* async_frame that queued each slot's work; 0 = none */
+} cj_rgraph_blur_level_t;
+
+/* A blur node's images at one execute extent of the graph, and the plan frames drawn at it
+ * follow. cj_rgraph_prepare builds and plans it; recording only reads it. */
+typedef struct cj_rgraph_blur_chain_t {
+    VkExtent2D extent;                /* Target extent the levels are sized for; 0 = unused */
+    VkDescriptorPool compute_pool;    /* Holds every level's compute sets; VK_NULL_HANDLE without compute */
+    VkDescriptorPool desc_pool;       /* Engine node pool desc_set came from (not owned) */
+    VkDescriptorSet desc_set;         /* Samples the node's input */
+    VkImageView source_view;          /* View desc_set was written with */
+    cj_rgraph_blur_level_t levels[CJ_RGRAPH_BLUR_MAX_LEVELS + 1u];
+
+    uint32_t level;                   /* Downsample level blurred at */
+    int32_t taps;                     /* Kernel reach in texels of that level */
+    float sigma;                      /* Standard deviation in texels of that level */
+    bool use_compute;
+    bool use_async;                   /* The compute passes go to the engine's compute queue */
+} cj_rgraph_blur_chain_t;
+
 /* Blur node specific data */
 typedef struct cj_rgraph_blur_node_t {
-    VkPipeline pipeline_horizontal;   /* Horizontal blur pipeline */
-    VkPipeline pipeline_vertical;     /* Vertical blur pipeline */
-    VkPipelineLayout pipeline_layout; /* Shared pipeline layout */
-    VkDescriptorSetLayout desc_layout; /* Descriptor set layout */
-    VkDescriptorPool desc_pool;       /* Descriptor pool */
-    VkDescriptorSet desc_set;         /* Descriptor set */
-    VkBuffer vertex_buffer;           /* Full-screen quad vertex buffer */
-    VkDeviceMemory vertex_buffer_memory;
-    cj_rgraph_param_t* intensity_param; /* Cached pointer to intensity parameter */
-    cj_rgraph_param_t* time_param;      /* Cached pointer to time parameter */
-
-    /* Intermediate render target for true multi-pass */
-    VkImage intermediate_texture;      /* Intermediate texture for Pass 1 output */
-    VkDeviceMemory intermediate_memory; /* Memory for intermediate texture */
-    VkImageView intermediate_view;    /* View for intermediate texture */
-    VkFramebuffer intermediate_framebuffer; /* Framebuffer for intermediate rendering */
-    VkRenderPass intermediate_render_pass; /* Render pass for intermediate target */
+    VkPipeline pipeline;              /* Separable pass; direction is a push constant (shared) */
+    VkPipeline pipeline_down;         /* Dual-Kawase downsample (shared) */
+    VkPipeline pipeline_compute;      /* Shared-memory compute pass; VK_NULL_HANDLE when unsupported */
+    VkPipelineLayout pipeline_layout; /* Node set plus the BlurParams push constants (shared) */
+    VkPipelineLayout compute_layout;  /* compute_set_layout plus the compute push constants (shared) */
+    VkDescriptorSetLayout compute_set_layout; /* Sampled input and storage output, compute stage */
+    VkSampler sampler;                /* Linear, clamped to edge so the kernel does not wrap */
+    uint64_t sampler_handle;          /* Reference on the engine's shared sampler */
+    cj_rgraph_blur_chain_t chains[CJ_RGRAPH_EXTENTS]; /* Index of the graph's extent set */
+    cj_rgraph_blur_desc_t desc;       /* Settings from cj_rgraph_set_blur */
+
+    bool recorded;                    /* cj_rgraph_execute_offscreen recorded the pre-pass */
+    bool async_current;               /* This frame composites the compute queue's previous result */
+
+    cj_rgraph_param_id_t intensity_param; /* "blur_intensity"; 0 until it is declared */
+    uint32_t intensity_lookup;          /* param_count when intensity_param was last looked up */
+    float time;                         /* Animation clock when no radius is set or parameterized */
 } cj_rgraph_blur_node_t;
 
 /* Textured node specific data */
 typedef struct cj_rgraph_textured_node_t {
     VkPipeline pipeline;              /* Textured rendering pipeline */
-    VkPipelineLayout pipeline_layout; /* Pipeline layout */
-    VkDescriptorSetLayout desc_layout; /* Descriptor set layout */
-    VkDescriptorPool desc_pool;       /* Descriptor pool */
+    VkPipelineLayout pipeline_layout; /* Shared pipeline layout */
+    VkDescriptorPool desc_pool;       /* Engine node pool the set came from (not owned) */
     VkDescriptorSet desc_set;         /* Descriptor set */
-    VkBuffer vertex_buffer;           /* Vertex buffer for textured quad */
-    VkDeviceMemory vertex_buffer_memory;
+    VkBuffer vertex_buffer;           /* Engine's shared quad buffer (not owned) */
+    VkDeviceSize vertex_offset;       /* Offset of the textured quad in vertex_buffer */
+    VkPipeline table_pipeline;        /* Samples the engine texture table; VK_NULL_HANDLE without one */
+    VkPipelineLayout table_layout;    /* Texture table set plus the texture slot push constant */
     VkImage texture_image;            /* Texture image */
-    VkDeviceMemory texture_memory;    /* Texture memory */
+    cj_gpu_alloc_t texture_alloc;     /* Texture memory */
     VkImageView texture_view;         /* Texture view */
-    VkSampler texture_sampler;        /* Texture sampler */
 } cj_rgraph_textured_node_t;
 
 /* Color node specific data */
 typedef struct cj_rgraph_color_node_t {
     VkPipeline pipeline;              /* Color rendering pipeline */
-    VkPipelineLayout pipeline_layout; /* Pipeline layout */
-    VkBuffer vertex_buffer;           /* Vertex buffer for color quad */
-    VkDeviceMemory vertex_buffer_memory;
+    VkPipelineLayout pipeline_layout; /* Shared pipeline layout */
+    VkBuffer vertex_buffer;           /* Engine's shared quad buffer (not owned) */
+    VkDeviceSize vertex_offset;       /* Offset of the color quad in vertex_buffer */
 } cj_rgraph_color_node_t;
 
+/* Entries of each per-frame buffer ring: every frame slot of two windows sharing the
+ * graph, plus the one being written. Beyond that, taking an entry waits for the device. */
+#define CJ_RGRAPH_RING_FRAMES (2u * CJ_WINDOW_MAX_FRAMES_IN_FLIGHT + 1u)
+
+/* Frames reading the ring entries are told apart by reader: a window frame slot or an
+ * offscreen slot. A reader's previous frame has finished by the time it records again,
+ * so only then are the entries it read free to rewrite. */
+#define CJ_RGRAPH_MAX_READERS 32u     /* Fits the uint32_t reader masks */
+
+typedef struct cj_rgraph_reader_t {
+    const void* owner;                /* Window or offscreen target; NULL = direct callers */
+    uint32_t slot;                    /* Frame slot of the owner */
+} cj_rgraph_reader_t;
+
+/* One persistently mapped instance buffer of a sprite node */
+typedef struct cj_rgraph_sprite_frame_t {
+    VkBuffer buffer;                  /* Host-visible instance buffer */
+    cj_gpu_alloc_t alloc;             /* Its memory; alloc.mapped stays mapped */
+    uint32_t capacity;                /* Sprites the buffer holds */
+    uint32_t count;                   /* Sprites written for this frame */
+    uint32_t readers;                 /* Mask of the readers whose last frame read the entry */
+} cj_rgraph_sprite_frame_t;
+
+/* Sprite node specific data */
+typedef struct cj_rgraph_sprite_node_t {
+    VkPipeline pipeline;              /* Instanced sprite pipeline (shared) */
+    VkPipelineLayout pipeline_layout; /* Texture table and uniform sets, inverse extent push constant */
+    cj_rgraph_sprite_frame_t frames[CJ_RGRAPH_RING_FRAMES];
+    uint32_t frame;                   /* Ring entry the next execute draws */
+    bool pending;                     /* frames[frame] was written since the last execute */
+    cj_rgraph_param_id_t transform_param; /* "<node>.transform" */
+    cj_rgraph_param_id_t tint_param;  /* "<node>.tint" */
+} cj_rgraph_sprite_node_t;
+
+/* Uniform block of a sprite node; SpriteUniforms in sprite.vert (std140) */
+typedef struct cj_rgraph_sprite_uniforms_t {
+    float transform[16];
+    float tint[4];
+} cj_rgraph_sprite_uniforms_t;
+
+/* Objects per culling workgroup; GROUP in mesh_cull.comp */
+#define CJ_RGRAPH_MESH_GROUP 64u
+
+/* Draw buffer layout of a mesh node (Draws in mesh_cull.comp): the visible count
+ * vkCmdDrawIndexedIndirectCount reads, padded to 16 bytes, then one command per object */
+#define CJ_RGRAPH_MESH_DRAWS_OFFSET ((VkDeviceSize)16)
+#define CJ_RGRAPH_MESH_DRAW_STRIDE ((uint32_t)sizeof(VkDrawIndexedIndirectCommand))
+
+/* One ring entry of a mesh node, taken like the sprite instance buffers */
+typedef struct cj_rgraph_mesh_frame_t {
+    VkBuffer objects;                 /* Host-visible cj_rgraph_mesh_object_t array */
+    cj_gpu_alloc_t objects_alloc;     /* Its memory; objects_alloc.mapped stays mapped */
+    VkBuffer draws;                   /* Device-local count and indirect commands culling writes */
+    cj_gpu_alloc_t draws_alloc;
+    uint32_t capacity;                /* Objects both buffers hold */
+    uint32_t count;                   /* Objects written for this frame */
+    VkDescriptorSet set;              /* objects at binding 0, draws at binding 1 (from set_pool) */
+    uint32_t readers;                 /* Mask of the readers whose last frame read the entry */
+} cj_rgraph_mesh_frame_t;
+
+/* Images a mesh node draws its objects into at one execute extent of the graph */
+typedef struct cj_rgraph_mesh_target_t {
+    VkExtent2D extent;                /* Node target extent; 0 = unused */
+    VkImage color_image;
+    cj_gpu_alloc_t color_alloc;
+    VkImageView color_view;
+    VkImage depth_image;
+    cj_gpu_alloc_t depth_alloc;
+    VkImageView depth_view;
+    VkFramebuffer framebuffer;        /* color_view and depth_view in mesh_render_pass */
+    VkDescriptorPool color_pool;      /* Engine node pool color_set came from (not owned) */
+    VkDescriptorSet color_set;        /* Samples color_view from the fragment stage */
+} cj_rgraph_mesh_target_t;
+
+/* Mesh node specific data */
+typedef struct cj_rgraph_mesh_node_t {
+    VkPipeline pipeline;              /* Draws the indirect commands in mesh_render_pass (shared) */
+    VkPipelineLayout pipeline_layout; /* Object set plus the view_proj push constant */
+    VkPipeline cull_pipeline;         /* Frustum culling compute pass (shared) */
+    VkPipelineLayout cull_layout;     /* Object set plus MeshCullParams */
+    VkPipeline composite_pipeline;    /* Blends the color image over the target (shared) */
+    VkPipelineLayout composite_layout;/* Node set, no push constants */
+    VkDescriptorSetLayout set_layout; /* Objects and draws storage buffers */
+    VkDescriptorPool set_pool;        /* Holds the ring entries' sets */
+    VkSampler sampler;                /* Linear, clamped; samples the color image */
+    uint64_t sampler_handle;          /* Reference on the engine's shared sampler */
+    cj_rgraph_mesh_frame_t frames[CJ_RGRAPH_RING_FRAMES];
+    uint32_t frame;                   /* Ring entry the next execute draws */
+    bool pending;                     /* frames[frame] was written since the last execute */
+    uint32_t max_draws;               /* maxDrawIndirectCount of the device */
+    const cj_mesh_t* mesh;            /* Mesh the objects index into (not owned); NULL = none */
+
+    /* Images the objects are drawn into, sized to the node's target; index of the graph's extent set */
+    cj_rgraph_mesh_target_t targets[CJ_RGRAPH_EXTENTS];
+
+    bool recorded;                    /* cj_rgraph_execute_offscreen recorded the pre-pass */
+    bool drawn;                       /* The pre-pass drew objects, so there is something to composite */
+    cj_rgraph_param_id_t view_proj_param; /* "<node>.view_proj" */
+} cj_rgraph_mesh_node_t;
+
+/* Push constants of the culling pass; MeshCullParams in mesh_cull.comp */
+typedef struct cj_rgraph_mesh_cull_params_t {
+    float view_proj[16];
+    uint32_t object_count;
+    uint32_t compact;                 /* Visible objects are packed and counted for the count draw */
+} cj_rgraph_mesh_cull_params_t;
+
+/* Descriptor range of the uniform sets: the largest block a node writes */
+#define CJ_RGRAPH_UNIFORM_RANGE ((VkDeviceSize)sizeof(cj_rgraph_sprite_uniforms_t))
+
+/* One persistently mapped uniform buffer of the graph. Nodes take their blocks from it
+ * in order while a frame is recorded and bind them through one dynamic offset each. */
+typedef struct cj_rgraph_uniform_frame_t {
+    VkBuffer buffer;                  /* Host-visible uniform buffer */
+    cj_gpu_alloc_t alloc;             /* Its memory; alloc.mapped stays mapped */
+    VkDeviceSize capacity;
+    VkDeviceSize used;                /* Bytes handed out to the frame being recorded */
+    VkDescriptorPool pool;            /* Holds set alone, so both are retired with the buffer */
+    VkDescriptorSet set;              /* Dynamic uniform set over buffer */
+    uint32_t readers;                 /* Mask of the readers whose last frame read the entry */
+} cj_rgraph_uniform_frame_t;
+
+/* Graph limits */
+#define CJ_RGRAPH_MAX_NODE_READS 8    /* Resources a single node may sample */
+#define CJ_RGRAPH_MAX_RESOURCES 16    /* Backbuffer plus transients (fits a uint32_t mask) */
+#define CJ_RGRAPH_BACKBUFFER_INDEX 0u /* Resource index of the imported swapchain image */
+
 /* Internal render graph structure */
 typedef struct cj_rgraph_node_t {
     char name[64];                    /* Node name for debugging */
     uint32_t type;                    /* Node type (pass-through, post-process, etc.) */
-    cj_handle_t input_textures[8];    /* Input texture handles */
-    cj_handle_t output_textures[8];   /* Output texture handles */
-    uint32_t input_count;
-    uint32_t output_count;
+    uint32_t reads[CJ_RGRAPH_MAX_NODE_READS]; /* Resource indices sampled by this node */
+    uint32_t read_count;
+    uint32_t write;                   /* Resource index rendered into (backbuffer by default) */
+    bool live;                        /* Survived culling in the last compile */
+    bool alias_wait;                  /* Write target reuses memory of an earlier transient */
+    uint32_t barrier_mask;            /* Transients needing a write->read barrier before this node */
+    /* Per extent set: samples reads[0] when it is a transient (from input_pools, not owned) */
+    VkDescriptorSet input_sets[CJ_RGRAPH_EXTENTS];
+    VkDescriptorPool input_pools[CJ_RGRAPH_EXTENTS];
     struct cj_rgraph_node_t* next;    /* Linked list of nodes */
 
     /* Node-specific data */
@@ -88,6 +292,8 @@ typedef struct cj_rgraph_node_t {
         cj_rgraph_blur_node_t blur;      /* Blur node data */
         cj_rgraph_textured_node_t textured; /* Textured node data */
         cj_rgraph_color_node_t color;    /* Color node data */
+        cj_rgraph_sprite_node_t sprite;  /* Sprite node data */
+        cj_rgraph_mesh_node_t mesh;      /* Mesh node data */
     } data;
 } cj_rgraph_node_t;
 
@@ -99,24 +305,147 @@ typedef struct cj_rgraph_binding_t {
 
 typedef struct cj_rgraph_param_t {
     char name[64];                    /* Parameter name */
-    int32_t value;                    /* Integer parameter value */
+    cj_rgraph_param_type_t type;      /* Fixed when the parameter is declared */
+    union {
+        int32_t i32;
+        float f32;
+        float vec4[4];
+        float mat4[16];
+    } value;
 } cj_rgraph_param_t;
 
+/* A named image nodes can read or write */
+typedef struct cj_rgraph_resource_t {
+    char name[64];                    /* Resource name */
+    bool transient;                   /* Graph-owned; false for the imported backbuffer */
+    float scale;                      /* Size relative to the execute extent */
+    bool used;                        /* Accessed by a live node in the last compile */
+    uint32_t first_use;               /* Schedule position of the first access */
+    uint32_t last_use;                /* Schedule position of the last access */
+    uint32_t alias_slot;              /* Memory slot shared with non-overlapping transients */
+} cj_rgraph_resource_t;
+
+/* A transient's image at one execute extent */
+typedef struct cj_rgraph_transient_t {
+    VkExtent2D extent;                /* Physical size of the image */
+    VkImage image;
+    VkImageView view;
+    VkFramebuffer framebuffer;
+    uint32_t memory;                  /* Entry of the extent set's memory the image is bound to */
+} cj_rgraph_transient_t;
+
+/* Transients whose lifetimes do not overlap, which may share memory */
+typedef struct cj_rgraph_alias_slot_t {
+    uint32_t busy_until;              /* Last schedule position of the current occupant */
+} cj_rgraph_alias_slot_t;
+
+/* Device memory of transients. An alias slot's images share one allocation unless their
+ * memory types have nothing in common, which gives the slot another allocation. */
+typedef struct cj_rgraph_memory_t {
+    VkDeviceMemory memory;
+    VkDeviceSize size;                /* Largest requirement among the images bound to it */
+    uint32_t memory_type_bits;        /* Intersection of their requirements */
+    uint32_t alias_slot;
+} cj_rgraph_memory_t;
+
+/* Transient images for one execute extent. Windows sharing a graph each draw at their
+ * own size, so cj_rgraph_prepare keeps a set per extent and evicts the least recently
+ * prepared one when a new extent needs a set. */
+typedef struct cj_rgraph_extent_set_t {
+    VkExtent2D extent;                /* Execute extent the transients are scaled from */
+    uint64_t prepared;                /* prepare_count when last prepared */
+    bool valid;                       /* Built for the current compile */
+    cj_rgraph_transient_t images[CJ_RGRAPH_MAX_RESOURCES]; /* Indexed like resources; 0 is unused */
+    cj_rgraph_memory_t memory[CJ_RGRAPH_MAX_RESOURCES];
+    uint32_t memory_count;
+} cj_rgraph_extent_set_t;
+
+/* Node pipeline rebuilt for a backbuffer pass of another format than the engine pass */
+typedef struct cj_rgraph_variant_t {
+    VkPipeline base;                  /* Node pipeline, built for the engine pass */
+    VkRenderPass pass;
+    VkPipeline pipeline;              /* Holds a pipeline cache reference; VK_NULL_HANDLE if it cannot be built */
+} cj_rgraph_variant_t;
+
 struct cj_rgraph_t {
     cj_engine_t* engine;              /* Reference to engine (not owned) */
     cj_rgraph_node_t* nodes;          /* Linked list of render nodes */
     cj_rgraph_binding_t* bindings;    /* Array of texture bindings */
-    cj_rgraph_param_t* params;        /* Array of integer parameters */
+    cj_rgraph_param_t* params;        /* Typed parameters; a parameter's ID is its index + 1 */
     uint32_t binding_count;
     uint32_t param_count;
     uint32_t max_bindings;
-    uint32_t max_params;
+    uint32_t param_capacity;
     bool needs_recompile;             /* Flag indicating graph needs recompilation */
+
+    /* Declared resources; index 0 is always the backbuffer */
+    cj_rgraph_resource_t resources[CJ_RGRAPH_MAX_RESOURCES];
+    uint32_t resource_count;
+
+    /* Compile output: live nodes, transient writers first, then backbuffer writers */
+    cj_rgraph_node_t** schedule;
+    uint32_t schedule_count;
+    uint32_t offscreen_count;         /* Leading schedule entries that render into transients */
+    uint32_t final_barrier_mask;      /* Barriers flushed before the backbuffer pass */
+    cj_rgraph_alias_slot_t alias_slots[CJ_RGRAPH_MAX_RESOURCES];
+    uint32_t alias_slot_count;
+
+    /* Physical transient images per execute extent */
+    VkRenderPass transient_render_pass;
+    VkRenderPass mesh_render_pass;    /* Color and depth pass of mesh nodes; created with the first one */
+    VkFormat mesh_depth_format;
+    cj_rgraph_extent_set_t extents[CJ_RGRAPH_EXTENTS];
+    uint32_t active;                  /* Extent set of the frame being prepared or recorded */
+    uint64_t prepare_count;           /* cj_rgraph_prepare calls */
+    bool offscreen_recorded;          /* cj_rgraph_execute_offscreen ran for the current frame */
+    VkRect2D clip;                    /* Backbuffer region being redrawn while clip_active */
+    bool clip_active;
+    cj_gpu_timer_t* gpu_timer;        /* Receives a timestamp zone per node while set (not owned) */
+    VkRenderPass backbuffer_pass;     /* Pass of the window being prepared or recorded (not owned) */
+    bool recording_backbuffer;        /* Inside cj_rgraph_execute_region, so nodes bind variants */
+    cj_rgraph_variant_t* variants;    /* Built in cj_rgraph_prepare, only read while recording */
+    uint32_t variant_count;
+    uint32_t variant_capacity;
+
+    /* Bumped whenever recorded backbuffer commands would differ */
+    uint64_t content_version;
+    uint64_t pipeline_generation;     /* Pipeline cache generation the node pipelines were updated to */
+    float color_mul_snapshot[4];      /* Engine colorMul the color nodes were last recorded with */
+
+    /* Frames reading the per-frame buffer rings */
+    cj_rgraph_reader_t readers[CJ_RGRAPH_MAX_READERS];
+    uint32_t reader_count;
+    uint32_t reader;                  /* Reader of the frame being recorded */
+    bool reader_set;                  /* cj_rgraph__set_frame named the reader of the next frame */
+    uint32_t direct_slot;             /* Slot of direct callers, cycled per frame */
+
+    /* Uniform buffers taken per frame from the entries no reader still reads */
+    cj_rgraph_uniform_frame_t uniform_frames[CJ_RGRAPH_RING_FRAMES];
+    uint32_t uniform_frame;           /* Ring entry of the frame being recorded */
+    bool uniform_open;                /* uniform_frames[uniform_frame] belongs to the frame being recorded */
+    VkDeviceSize uniform_alignment;   /* minUniformBufferOffsetAlignment; 0 until queried */
+
+    /* Async compute: blur passes recorded for the compute queue and submitted after the
+     * frame that feeds them. One timeline orders both queues: frame submissions signal
+     * a value the compute submission waits for, and the next frame waits for its value */
+    VkSemaphore async_timeline;       /* VK_NULL_HANDLE until an async blur first runs */
+    uint64_t async_value;             /* Last value handed out */
+    uint64_t async_compute_value;     /* Value the last compute submission signals */
+    uint64_t async_waited;            /* Highest compute value a frame submission waited for */
+    uint64_t async_signal;            /* Value the frame being recorded signals; 0 = unassigned */
+    VkCommandPool async_pool;         /* On the compute family */
+    VkCommandBuffer async_cmds[2];    /* Recorded in turn, one per frame with async work */
+    uint64_t async_cmd_values[2];     /* Compute value of each buffer's last submission */
+    uint64_t async_frame;             /* Frames begun by cj_rgraph_execute_offscreen */
+    uint64_t async_submitted_frame;   /* Frame whose compute work was submitted last */
+    bool async_recording;             /* async_cmds[async_frame & 1] is open */
+    bool async_failed;                /* The async objects could not be created; blur stays on graphics */
 };
 
 /* Forward declarations */
 static cj_rgraph_binding_t* find_binding(cj_rgraph_t* graph, const char* name);
-static cj_rgraph_param_t* find_param(cj_rgraph_t* graph, const char* name);
+static cj_rgraph_param_id_t find_param(cj_rgraph_t* graph, cj_str_t name);
+static cj_rgraph_param_id_t declare_param(cj_rgraph_t* graph, cj_str_t name, cj_rgraph_param_type_t type);
 static void add_default_node(cj_rgraph_t* graph);
 static int create_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node);
 static void destroy_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node);
@@ -127,8 +456,39 @@ static int execute_textured_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkC
 static int create_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node);
 static void destroy_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node);
 static int execute_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent);
-static int create_intermediate_render_target(cj_rgraph_t* graph, cj_rgraph_blur_node_t* blur, VkExtent2D extent);
-static void destroy_intermediate_render_target(cj_rgraph_t* graph, cj_rgraph_blur_node_t* blur);
+static int create_sprite_node(cj_rgraph_t* graph, cj_rgraph_node_t* node);
+static void destroy_sprite_node(cj_rgraph_t* graph, cj_rgraph_node_t* node);
+static int execute_sprite_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent);
+static bool graphics_queue_computes(cj_rgraph_t* graph);
+static int create_mesh_node(cj_rgraph_t* graph, cj_rgraph_node_t* node);
+static void destroy_mesh_node(cj_rgraph_t* graph, cj_rgraph_node_t* node);
+static bool grow_mesh_frame(cj_rgraph_t* graph, cj_rgraph_mesh_node_t* mesh, cj_rgraph_mesh_frame_t* frame, uint32_t count);
+static int prepare_mesh_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkExtent2D extent);
+static cj_result_t record_mesh_prepass(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent);
+static int execute_mesh_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent);
+static cj_rgraph_node_t* find_node(cj_rgraph_t* graph, const char* name);
+static int find_resource(cj_rgraph_t* graph, cj_str_t name);
+static cj_result_t compile_graph(cj_rgraph_t* graph);
+static cj_result_t build_physical(cj_rgraph_t* graph, uint32_t set, VkExtent2D extent);
+static void release_physical(cj_rgraph_t* graph, uint32_t set);
+static void release_extents(cj_rgraph_t* graph);
+static uint32_t find_extent_set(const cj_rgraph_t* graph, VkExtent2D extent);
+static cj_result_t execute_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent);
+static int ensure_transient_render_pass(cj_rgraph_t* graph);
+static void plan_blur(cj_rgraph_t* graph, cj_rgraph_node_t* node, cj_rgraph_blur_chain_t* chain);
+static int prepare_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkExtent2D extent);
+static void release_blur_chain(cj_rgraph_t* graph, cj_rgraph_blur_chain_t* chain);
+static cj_result_t record_blur_prepass(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent);
+static void release_blur_async(cj_rgraph_t* graph, cj_rgraph_blur_level_t* level);
+static void set_node_scissor(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent);
+static void drain_readers(cj_rgraph_t* graph);
+static uint32_t begin_reader_frame(cj_rgraph_t* graph);
+static void begin_uniform_frame(cj_rgraph_t* graph);
+static void prepare_uniforms(cj_rgraph_t* graph);
+static void* alloc_uniforms(cj_rgraph_t* graph, VkDeviceSize size, VkDescriptorSet* out_set, uint32_t* out_offset);
+static void release_uniforms(cj_rgraph_t* graph);
+static void begin_async_frame(cj_rgraph_t* graph);
+static void release_async(cj_rgraph_t* graph);
 
 /* Create a new render graph */
 CJ_API cj_rgraph_t* cj_rgraph_create(cj_engine_t* engine, const cj_rgraph_desc_t* desc) {
@@ -147,21 +507,22 @@ CJ_API cj_rgraph_t* cj_rgraph_create(cj_engine_t* engine, const cj_rgraph_desc_t
     memset(graph, 0, sizeof(cj_rgraph_t));
     graph->engine = engine;
     graph->max_bindings = 16;
-    graph->max_params = 16;
     graph->needs_recompile = true;
 
-    /* Allocate binding and parameter arrays */
+    /* Allocate the binding array; parameters grow as they are declared */
     graph->bindings = (cj_rgraph_binding_t*)malloc(sizeof(cj_rgraph_binding_t) * graph->max_bindings);
-    graph->params = (cj_rgraph_param_t*)malloc(sizeof(cj_rgraph_param_t) * graph->max_params);
 
-    if (!graph->bindings || !graph->params) {
-        fprintf(stderr, "cj_rgraph_create: failed to allocate binding/param arrays\n");
-        if (graph->bindings) free(graph->bindings);
-        if (graph->params) free(graph->params);
+    if (!graph->bindings) {
+        fprintf(stderr, "cj_rgraph_create: failed to allocate binding array\n");
         free(graph);
         return NULL;
     }
 
+    /* The swapchain image is imported under a fixed name */
+    strncpy(graph->resources[0].name, CJ_RGRAPH_BACKBUFFER, sizeof(graph->resources[0].name) - 1);
+    graph->resources[0].scale = 1.0f;
+    graph->resource_count = 1;
+
     /* No default nodes - nodes will be added explicitly */
 
     // Render graph created successfully
@@ -172,6 +533,22 @@ CJ_API cj_rgraph_t* cj_rgraph_create(cj_engine_t* engine, const cj_rgraph_desc_t
 CJ_API void cj_rgraph_destroy(cj_rgraph_t* graph) {
     if (!graph) return;
 
+    /* Frames in flight may still use the graph's passes, pipelines and images */
+    vkDeviceWaitIdle(cj_engine_device(graph->engine));
+
+    /* Release transient images before the nodes whose descriptor sets reference them */
+    release_extents(graph);
+    if (graph->transient_render_pass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(cj_engine_device(graph->engine), graph->transient_render_pass, NULL);
+    }
+    free(graph->schedule);
+    for (uint32_t i = 0; i < graph->variant_count; i++) {
+        cj_pipeline_cache_release(cj_engine_pipelines(graph->engine), graph->variants[i].pipeline);
+    }
+    free(graph->variants);
+    release_uniforms(graph);
+    release_async(graph);
+
     /* Free all nodes */
     cj_rgraph_node_t* node = graph->nodes;
     while (node) {
@@ -184,11 +561,18 @@ CJ_API void cj_rgraph_destroy(cj_rgraph_t* graph) {
             destroy_textured_node(graph, node);
         } else if (node->type == CJ_RGRAPH_NODE_COLOR) {
             destroy_color_node(graph, node);
+        } else if (node->type == CJ_RGRAPH_NODE_SPRITE) {
+            destroy_sprite_node(graph, node);
+        } else if (node->type == CJ_RGRAPH_NODE_MESH) {
+            destroy_mesh_node(graph, node);
         }
 
         free(node);
         node = next;
     }
+    if (graph->mesh_render_pass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(cj_engine_device(graph->engine), graph->mesh_render_pass, NULL);
+    }
 
     /* Free arrays */
     if (graph->bindings) free(graph->bindings);
@@ -198,13 +582,77 @@ CJ_API void cj_rgraph_destroy(cj_rgraph_t* graph) {
     // Render graph destroyed
 }
 
-/* Recompile the graph (stub implementation) */
+/* Recompile the graph: schedule, cull, plan aliasing and barriers */
 CJ_API cj_result_t cj_rgraph_recompile(cj_rgraph_t* graph) {
     if (!graph) return CJ_E_INVALID_ARGUMENT;
 
-    /* For now, just mark as compiled */
+    cj_result_t result = compile_graph(graph);
+    graph->content_version++;
+    if (result != CJ_SUCCESS) return result;
     graph->needs_recompile = false;
-    // Render graph recompiled
+    return CJ_SUCCESS;
+}
+
+/* Declare a graph-owned transient color target */
+CJ_API cj_result_t cj_rgraph_declare_transient(cj_rgraph_t* graph, cj_str_t name, float scale) {
+    if (!graph || !name.ptr || name.len == 0 || name.len >= sizeof(graph->resources[0].name)) {
+        return CJ_E_INVALID_ARGUMENT;
+    }
+    if (!(scale > 0.0f) || scale > 1.0f) return CJ_E_INVALID_ARGUMENT;
+
+    int index = find_resource(graph, name);
+    if (index == (int)CJ_RGRAPH_BACKBUFFER_INDEX) return CJ_E_INVALID_ARGUMENT;
+    if (index < 0) {
+        if (graph->resource_count >= CJ_RGRAPH_MAX_RESOURCES) {
+            fprintf(stderr, "cj_rgraph_declare_transient: too many resources\n");
+            return CJ_E_OUT_OF_MEMORY;
+        }
+        index = (int)graph->resource_count++;
+        cj_rgraph_resource_t* res = &graph->resources[index];
+        memset(res, 0, sizeof(*res));
+        memcpy(res->name, name.ptr, name.len);
+        res->name[name.len] = '\0';
+        res->transient = true;
+    }
+    graph->resources[index].scale = scale;
+    graph->needs_recompile = true;
+    return CJ_SUCCESS;
+}
+
+/* Declare that a node samples a resource */
+CJ_API cj_result_t cj_rgraph_node_read(cj_rgraph_t* graph, const char* node_name, cj_str_t resource) {
+    if (!graph || !node_name || !resource.ptr || resource.len == 0) return CJ_E_INVALID_ARGUMENT;
+
+    cj_rgraph_node_t* node = find_node(graph, node_name);
+    if (!node) return CJ_E_NOT_FOUND;
+    int index = find_resource(graph, resource);
+    if (index < 0) return CJ_E_NOT_FOUND;
+    /* The backbuffer is only available inside the window pass; it cannot be sampled */
+    if (index == (int)CJ_RGRAPH_BACKBUFFER_INDEX) return CJ_E_INVALID_ARGUMENT;
+
+    for (uint32_t i = 0; i < node->read_count; i++) {
+        if (node->reads[i] == (uint32_t)index) return CJ_SUCCESS;
+    }
+    if (node->read_count >= CJ_RGRAPH_MAX_NODE_READS) {
+        fprintf(stderr, "cj_rgraph_node_read: too many reads for node %s\n", node->name);
+        return CJ_E_OUT_OF_MEMORY;
+    }
+    node->reads[node->read_count++] = (uint32_t)index;
+    graph->needs_recompile = true;
+    return CJ_SUCCESS;
+}
+
+/* Declare the resource a node renders into */
+CJ_API cj_result_t cj_rgraph_node_write(cj_rgraph_t* graph, const char* node_name, cj_str_t resource) {
+    if (!graph || !node_name || !resource.ptr || resource.len == 0) return CJ_E_INVALID_ARGUMENT;
+
+    cj_rgraph_node_t* node = find_node(graph, node_name);
+    if (!node) return CJ_E_NOT_FOUND;
+    int index = find_resource(graph, resource);
+    if (index < 0) return CJ_E_NOT_FOUND;
+
+    node->write = (uint32_t)index;
+    graph->needs_recompile = true;
     return CJ_SUCCESS;
 }
 
@@ -229,33 +677,81 @@ CJ_API cj_result_t cj_rgraph_bind_texture(cj_rgraph_t* graph, cj_str_t name, cj_
 
     binding->texture = texture;
     binding->slot = cj_texture_descriptor_slot(graph->engine, texture);
+    graph->content_version++;
 
     // Bound texture to slot
     return CJ_SUCCESS;
 }
 
-/* Set an integer parameter */
-CJ_API cj_result_t cj_rgraph_set_i32(cj_rgraph_t* graph, cj_str_t name, int32_t value) {
-    if (!graph || !name.ptr || name.len == 0) {
-        return CJ_E_INVALID_ARGUMENT;
+/* Store a parameter value if the ID names a parameter of that type */
+static cj_result_t set_param(cj_rgraph_t* graph, cj_rgraph_param_id_t id, cj_rgraph_param_type_t type,
+                             const void* value, size_t size) {
+    if (!graph || !value || id == 0 || id > graph->param_count) return CJ_E_INVALID_ARGUMENT;
+    cj_rgraph_param_t* param = &graph->params[id - 1u];
+    if (param->type != type) return CJ_E_INVALID_ARGUMENT;
+
+    if (memcmp(&param->value, value, size) != 0) {
+        memcpy(&param->value, value, size);
+        graph->content_version++;
     }
+    return CJ_SUCCESS;
+}
 
-    /* Find existing parameter or create new one */
-    cj_rgraph_param_t* param = find_param(graph, name.ptr);
-    if (!param) {
-        if (graph->param_count >= graph->max_params) {
-            fprintf(stderr, "cj_rgraph_set_i32: too many parameters\n");
-            return CJ_E_OUT_OF_MEMORY;
-        }
+/* Resolve a parameter name to its ID, declaring it if needed */
+CJ_API cj_rgraph_param_id_t cj_rgraph_param_id(cj_rgraph_t* graph, cj_str_t name, cj_rgraph_param_type_t type) {
+    if (!graph || !name.ptr || name.len == 0 || name.len >= sizeof(graph->params[0].name)) return 0;
+    if (type > CJ_RGRAPH_PARAM_MAT4) return 0;
+
+    cj_rgraph_param_id_t id = find_param(graph, name);
+    if (id == 0) return declare_param(graph, name, type);
+    return graph->params[id - 1u].type == type ? id : 0;
+}
+
+CJ_API cj_result_t cj_rgraph_set_param_i32(cj_rgraph_t* graph, cj_rgraph_param_id_t id, int32_t value) {
+    return set_param(graph, id, CJ_RGRAPH_PARAM_I32, &value, sizeof(value));
+}
+
+CJ_API cj_result_t cj_rgraph_set_param_f32(cj_rgraph_t* graph, cj_rgraph_param_id_t id, float value) {
+    return set_param(graph, id, CJ_RGRAPH_PARAM_F32, &value, sizeof(value));
+}
+
+CJ_API cj_result_t cj_rgraph_set_param_vec4(cj_rgraph_t* graph, cj_rgraph_param_id_t id, const float value[4]) {
+    return set_param(graph, id, CJ_RGRAPH_PARAM_VEC4, value, sizeof(float) * 4);
+}
+
+CJ_API cj_result_t cj_rgraph_set_param_mat4(cj_rgraph_t* graph, cj_rgraph_param_id_t id, const float value[16]) {
+    return set_param(graph, id, CJ_RGRAPH_PARAM_MAT4, value, sizeof(float) * 16);
+}
+
+/* Set a parameter by name: resolve, then store */
+static cj_result_t set_named_param(cj_rgraph_t* graph, cj_str_t name, cj_rgraph_param_type_t type,
+                                   const void* value, size_t size) {
+    if (!graph || !name.ptr || name.len == 0 || !value) return CJ_E_INVALID_ARGUMENT;
+    if (name.len >= sizeof(graph->params[0].name)) return CJ_E_INVALID_ARGUMENT;
 
-        param = &graph->params[graph->param_count++];
-        strncpy(param->name, name.ptr, sizeof(param->name) - 1);
-        param->name[sizeof(param->name) - 1] = '\0';
+    cj_rgraph_param_id_t id = find_param(graph, name);
+    if (id == 0) {
+        id = declare_param(graph, name, type);
+        if (id == 0) return CJ_E_OUT_OF_MEMORY;
     }
+    return set_param(graph, id, type, value, size);
+}
 
-    param->value = value;
-    // Parameter set
-    return CJ_SUCCESS;
+/* Set an integer parameter */
+CJ_API cj_result_t cj_rgraph_set_i32(cj_rgraph_t* graph, cj_str_t name, int32_t value) {
+    return set_named_param(graph, name, CJ_RGRAPH_PARAM_I32, &value, sizeof(value));
+}
+
+CJ_API cj_result_t cj_rgraph_set_f32(cj_rgraph_t* graph, cj_str_t name, float value) {
+    return set_named_param(graph, name, CJ_RGRAPH_PARAM_F32, &value, sizeof(value));
+}
+
+CJ_API cj_result_t cj_rgraph_set_vec4(cj_rgraph_t* graph, cj_str_t name, const float value[4]) {
+    return set_named_param(graph, name, CJ_RGRAPH_PARAM_VEC4, value, sizeof(float) * 4);
+}
+
+CJ_API cj_result_t cj_rgraph_set_mat4(cj_rgraph_t* graph, cj_str_t name, const float value[16]) {
+    return set_named_param(graph, name, CJ_RGRAPH_PARAM_MAT4, value, sizeof(float) * 16);
 }
 
 /* Add a textured node to the render graph */
@@ -274,6 +770,7 @@ CJ_API cj_result_t cj_rgraph_add_textured_node(cj_rgraph_t* graph, const char* n
     node->type = CJ_RGRAPH_NODE_TEXTURED;
     node->next = graph->nodes;
     graph->nodes = node;
+    graph->needs_recompile = true;
 
     // Create textured-specific resources
     if (!create_textured_node(graph, node)) {
@@ -300,6 +797,7 @@ CJ_API cj_result_t cj_rgraph_add_color_node(cj_rgraph_t* graph, const char* name
     node->type = CJ_RGRAPH_NODE_COLOR;
     node->next = graph->nodes;
     graph->nodes = node;
+    graph->needs_recompile = true;
 
     // Create color-specific resources
     if (!create_color_node(graph, node)) {
@@ -310,918 +808,2909 @@ CJ_API cj_result_t cj_rgraph_add_color_node(cj_rgraph_t* graph, const char* name
     return CJ_SUCCESS;
 }
 
-/* Execute the render graph */
-CJ_API cj_result_t cj_rgraph_execute(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent) {
-    if (!graph || !cmd) return CJ_E_INVALID_ARGUMENT;
+/* Add a sprite batch node to the render graph */
+CJ_API cj_result_t cj_rgraph_add_sprite_node(cj_rgraph_t* graph, const char* name) {
+    if (!graph || !name) return CJ_E_INVALID_ARGUMENT;
+    if (cj_engine_texture_table(graph->engine) == VK_NULL_HANDLE) {
+        fprintf(stderr, "cj_rgraph_add_sprite_node: the engine has no texture table\n");
+        return CJ_E_UNSUPPORTED;
+    }
 
-    // Execute all nodes in the graph
-    cj_rgraph_node_t* node = graph->nodes;
-    while (node) {
-        switch (node->type) {
-            case CJ_RGRAPH_NODE_PASSTHROUGH:
-                // Pass-through nodes indicate we should use legacy rendering
-                // Return a special code to indicate fallback needed
-                return CJ_E_UNKNOWN;
+    cj_rgraph_node_t* node = (cj_rgraph_node_t*)malloc(sizeof(cj_rgraph_node_t));
+    if (!node) {
+        fprintf(stderr, "cj_rgraph_add_sprite_node: failed to allocate node\n");
+        return CJ_E_OUT_OF_MEMORY;
+    }
 
-            case CJ_RGRAPH_NODE_BLUR:
-                if (!execute_blur_node(graph, node, cmd, extent)) {
-                    return CJ_E_UNKNOWN;
-                }
-                break;
+    memset(node, 0, sizeof(cj_rgraph_node_t));
+    strncpy(node->name, name, sizeof(node->name) - 1);
+    node->name[sizeof(node->name) - 1] = '\0';
+    node->type = CJ_RGRAPH_NODE_SPRITE;
 
-            case CJ_RGRAPH_NODE_TEXTURED:
-                if (!execute_textured_node(graph, node, cmd, extent)) {
-                    return CJ_E_UNKNOWN;
-                }
-                break;
+    // Create sprite-specific resources before the node joins the graph
+    if (!create_sprite_node(graph, node)) {
+        free(node);
+        return CJ_E_UNKNOWN;
+    }
 
-            case CJ_RGRAPH_NODE_COLOR:
-                if (!execute_color_node(graph, node, cmd, extent)) {
-                    return CJ_E_UNKNOWN;
-                }
-                break;
+    // Batch parameters, resolved once; the node draws untransformed and untinted without them
+    static const float opaque_white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    char param_name[80];
+    int len = snprintf(param_name, sizeof(param_name), "%s.transform", node->name);
+    node->data.sprite.transform_param = cj_rgraph_param_id(graph, (cj_str_t){ param_name, (size_t)len }, CJ_RGRAPH_PARAM_MAT4);
+    len = snprintf(param_name, sizeof(param_name), "%s.tint", node->name);
+    cj_str_t tint_name = { param_name, (size_t)len };
+    bool tint_declared = find_param(graph, tint_name) != 0;
+    node->data.sprite.tint_param = cj_rgraph_param_id(graph, tint_name, CJ_RGRAPH_PARAM_VEC4);
+    if (node->data.sprite.tint_param && !tint_declared) {
+        cj_rgraph_set_param_vec4(graph, node->data.sprite.tint_param, opaque_white);
+    }
+    if (!node->data.sprite.transform_param || !node->data.sprite.tint_param) {
+        fprintf(stderr, "cj_rgraph_add_sprite_node: parameters of %s are unavailable; it draws with the defaults\n", node->name);
+    }
 
-            default:
-                fprintf(stderr, "cj_rgraph_execute: unknown node type %u\n", node->type);
-                return CJ_E_UNKNOWN;
+    node->next = graph->nodes;
+    graph->nodes = node;
+    graph->needs_recompile = true;
+    return CJ_SUCCESS;
+}
+
+/* Copy the sprites for the next execute into the sprite node's instance ring */
+CJ_API cj_result_t cj_rgraph_set_sprites(cj_rgraph_t* graph, const char* node_name,
+                                         const cj_rgraph_sprite_t* sprites, uint32_t count) {
+    if (!graph || !node_name || (count > 0 && !sprites)) return CJ_E_INVALID_ARGUMENT;
+
+    cj_rgraph_node_t* node = find_node(graph, node_name);
+    if (!node || node->type != CJ_RGRAPH_NODE_SPRITE) return CJ_E_NOT_FOUND;
+    cj_rgraph_sprite_node_t* sprite = &node->data.sprite;
+
+    // The first update after an execute moves to an entry no frame in flight reads
+    if (!sprite->pending) {
+        uint32_t entry = 0;
+        while (entry < CJ_RGRAPH_RING_FRAMES && sprite->frames[entry].readers) entry++;
+        if (entry == CJ_RGRAPH_RING_FRAMES) {
+            drain_readers(graph);
+            entry = (sprite->frame + 1u) % CJ_RGRAPH_RING_FRAMES;
         }
+        sprite->frame = entry;
+        sprite->pending = true;
+    }
+    cj_rgraph_sprite_frame_t* frame = &sprite->frames[sprite->frame];
 
-        node = node->next;
+    if (count > frame->capacity) {
+        uint32_t capacity = frame->capacity ? frame->capacity : 256u;
+        while (capacity < count) {
+            if (capacity > UINT32_MAX / 2u) { capacity = count; break; }
+            capacity *= 2u;
+        }
+        cj_gpu_allocator_t* gpu = cj_engine_gpu_allocator(graph->engine);
+        cj_gpu_destroy_buffer(gpu, &frame->buffer, &frame->alloc);
+        frame->capacity = 0;
+        frame->count = 0;
+        if (!cj_gpu_create_buffer(gpu, (VkDeviceSize)capacity * sizeof(cj_rgraph_sprite_t), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                  CJ_GPU_ALLOC_LINEAR, &frame->buffer, &frame->alloc)) {
+            fprintf(stderr, "cj_rgraph_set_sprites: failed to create an instance buffer for %u sprites\n", count);
+            return CJ_E_OUT_OF_MEMORY;
+        }
+        frame->capacity = capacity;
     }
+
+    if (count > 0) memcpy(frame->alloc.mapped, sprites, (size_t)count * sizeof(cj_rgraph_sprite_t));
+    frame->count = count;
+    graph->content_version++;
     return CJ_SUCCESS;
 }
 
-/* Create blur node resources */
-static int create_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_BLUR) return 0;
-
-    cj_rgraph_blur_node_t* blur = &node->data.blur;
-    VkDevice device = cj_engine_device(graph->engine);
-    VkRenderPass render_pass = cj_engine_render_pass(graph->engine);
+/* Add a GPU-driven mesh node to the render graph */
+CJ_API cj_result_t cj_rgraph_add_mesh_node(cj_rgraph_t* graph, const char* name) {
+    if (!graph || !name) return CJ_E_INVALID_ARGUMENT;
+    if (!cj_engine_indirect_draws(graph->engine) || !graphics_queue_computes(graph)) {
+        fprintf(stderr, "cj_rgraph_add_mesh_node: the device cannot draw indirect commands computed on the graphics queue\n");
+        return CJ_E_UNSUPPORTED;
+    }
 
-    // Create descriptor set layout
-    VkDescriptorSetLayoutBinding layout_binding = {0};
-    layout_binding.binding = 0;
-    layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    layout_binding.descriptorCount = 1;
-    layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    cj_rgraph_node_t* node = (cj_rgraph_node_t*)malloc(sizeof(cj_rgraph_node_t));
+    if (!node) {
+        fprintf(stderr, "cj_rgraph_add_mesh_node: failed to allocate node\n");
+        return CJ_E_OUT_OF_MEMORY;
+    }
 
-    VkDescriptorSetLayoutCreateInfo layout_info = {0};
-    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layout_info.bindingCount = 1;
-    layout_info.pBindings = &layout_binding;
+    memset(node, 0, sizeof(cj_rgraph_node_t));
+    strncpy(node->name, name, sizeof(node->name) - 1);
+    node->name[sizeof(node->name) - 1] = '\0';
+    node->type = CJ_RGRAPH_NODE_MESH;
 
-    if (vkCreateDescriptorSetLayout(device, &layout_info, NULL, &blur->desc_layout) != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to create descriptor set layout\n");
-        return 0;
+    // Create mesh-specific resources before the node joins the graph
+    if (!create_mesh_node(graph, node)) {
+        free(node);
+        return CJ_E_UNKNOWN;
     }
 
-    // Create descriptor pool
-    VkDescriptorPoolSize pool_size = {0};
-    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    pool_size.descriptorCount = 1;
+    // Resolved once; the node draws in object space without it
+    char param_name[80];
+    int len = snprintf(param_name, sizeof(param_name), "%s.view_proj", node->name);
+    node->data.mesh.view_proj_param = cj_rgraph_param_id(graph, (cj_str_t){ param_name, (size_t)len }, CJ_RGRAPH_PARAM_MAT4);
+    if (!node->data.mesh.view_proj_param) {
+        fprintf(stderr, "cj_rgraph_add_mesh_node: parameter %s is unavailable; it draws with the identity\n", param_name);
+    }
 
-    VkDescriptorPoolCreateInfo pool_info = {0};
-    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    pool_info.poolSizeCount = 1;
-    pool_info.pPoolSizes = &pool_size;
-    pool_info.maxSets = 1;
+    node->next = graph->nodes;
+    graph->nodes = node;
+    graph->needs_recompile = true;
+    return CJ_SUCCESS;
+}
 
-    if (vkCreateDescriptorPool(device, &pool_info, NULL, &blur->desc_pool) != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to create descriptor pool\n");
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+/* Point a mesh node at the mesh its objects index into */
+CJ_API cj_result_t cj_rgraph_set_mesh(cj_rgraph_t* graph, const char* node_name, const cj_mesh_t* mesh) {
+    if (!graph || !node_name) return CJ_E_INVALID_ARGUMENT;
+    // The pipeline reads CJellyFormat3dMeshVertex positions and normals
+    if (mesh && (mesh->vertex_stride != sizeof(CJellyFormat3dMeshVertex) ||
+                 (mesh->index_size != 2 && mesh->index_size != 4))) {
+        return CJ_E_INVALID_ARGUMENT;
     }
 
-    // Allocate descriptor set
-    VkDescriptorSetAllocateInfo alloc_info = {0};
-    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    alloc_info.descriptorPool = blur->desc_pool;
-    alloc_info.descriptorSetCount = 1;
-    alloc_info.pSetLayouts = &blur->desc_layout;
+    cj_rgraph_node_t* node = find_node(graph, node_name);
+    if (!node || node->type != CJ_RGRAPH_NODE_MESH) return CJ_E_NOT_FOUND;
+    node->data.mesh.mesh = mesh;
+    graph->content_version++;
+    return CJ_SUCCESS;
+}
 
-    if (vkAllocateDescriptorSets(device, &alloc_info, &blur->desc_set) != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to allocate descriptor set\n");
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+/* Copy the objects for the next execute into the mesh node's object ring */
+CJ_API cj_result_t cj_rgraph_set_mesh_objects(cj_rgraph_t* graph, const char* node_name,
+                                              const cj_rgraph_mesh_object_t* objects, uint32_t count) {
+    if (!graph || !node_name || (count > 0 && !objects)) return CJ_E_INVALID_ARGUMENT;
+
+    cj_rgraph_node_t* node = find_node(graph, node_name);
+    if (!node || node->type != CJ_RGRAPH_NODE_MESH) return CJ_E_NOT_FOUND;
+    cj_rgraph_mesh_node_t* mesh = &node->data.mesh;
+    if (count > mesh->max_draws) {
+        fprintf(stderr, "cj_rgraph_set_mesh_objects: %u objects exceed the %u indirect draws of the device\n",
+                count, mesh->max_draws);
+        return CJ_E_INVALID_ARGUMENT;
     }
 
-    // Use the fish texture's descriptor set layout for compatibility
-    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
-    if (!tx || tx->descriptorSetLayout == VK_NULL_HANDLE) {
-        fprintf(stderr, "create_blur_node: fish texture not available\n");
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+    // The first update after an execute moves to an entry no frame in flight reads
+    if (!mesh->pending) {
+        uint32_t entry = 0;
+        while (entry < CJ_RGRAPH_RING_FRAMES && mesh->frames[entry].readers) entry++;
+        if (entry == CJ_RGRAPH_RING_FRAMES) {
+            drain_readers(graph);
+            entry = (mesh->frame + 1u) % CJ_RGRAPH_RING_FRAMES;
+        }
+        mesh->frame = entry;
+        mesh->pending = true;
     }
+    cj_rgraph_mesh_frame_t* frame = &mesh->frames[mesh->frame];
 
-    // Create pipeline layout with push constants using fish texture's descriptor set layout
-    VkPushConstantRange push_range = {0};
-    push_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    push_range.offset = 0;
-    push_range.size = sizeof(float) * 6; // vec2 texelSize + vec2 direction + float intensity + float time
+    if (count > frame->capacity && !grow_mesh_frame(graph, mesh, frame, count)) {
+        fprintf(stderr, "cj_rgraph_set_mesh_objects: failed to create buffers for %u objects\n", count);
+        return CJ_E_OUT_OF_MEMORY;
+    }
 
-    VkPipelineLayoutCreateInfo pli = {0};
-    pli.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pli.setLayoutCount = 1;
-    pli.pSetLayouts = &tx->descriptorSetLayout; // Use fish texture's layout
-    pli.pushConstantRangeCount = 1;
-    pli.pPushConstantRanges = &push_range;
+    if (count > 0) memcpy(frame->objects_alloc.mapped, objects, (size_t)count * sizeof(cj_rgraph_mesh_object_t));
+    frame->count = count;
+    graph->content_version++;
+    return CJ_SUCCESS;
+}
 
-    if (vkCreatePipelineLayout(device, &pli, NULL, &blur->pipeline_layout) != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to create pipeline layout\n");
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
-    }
+/* Record one node into the currently open render pass */
+static cj_result_t execute_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    switch (node->type) {
+        case CJ_RGRAPH_NODE_PASSTHROUGH:
+            // Pass-through nodes indicate we should use legacy rendering
+            // Return a special code to indicate fallback needed
+            return CJ_E_UNKNOWN;
 
-    // Create full-screen quad vertex buffer
-    typedef struct { float pos[2]; float tex[2]; } BlurVertex;
-    BlurVertex vertices[] = {
-        {{-1.0f, -1.0f}, {0.0f, 0.0f}},
-        {{ 1.0f, -1.0f}, {1.0f, 0.0f}},
-        {{ 1.0f,  1.0f}, {1.0f, 1.0f}},
-        {{-1.0f,  1.0f}, {0.0f, 1.0f}},
-    };
+        case CJ_RGRAPH_NODE_BLUR:
+            return execute_blur_node(graph, node, cmd, extent) ? CJ_SUCCESS : CJ_E_UNKNOWN;
 
-    VkBufferCreateInfo buffer_info = {0};
-    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_info.size = sizeof(vertices);
-    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateBuffer(device, &buffer_info, NULL, &blur->vertex_buffer) != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to create vertex buffer\n");
-        vkDestroyPipelineLayout(device, blur->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+        case CJ_RGRAPH_NODE_TEXTURED:
+            return execute_textured_node(graph, node, cmd, extent) ? CJ_SUCCESS : CJ_E_UNKNOWN;
+
+        case CJ_RGRAPH_NODE_COLOR:
+            return execute_color_node(graph, node, cmd, extent) ? CJ_SUCCESS : CJ_E_UNKNOWN;
+
+        case CJ_RGRAPH_NODE_SPRITE:
+            return execute_sprite_node(graph, node, cmd, extent) ? CJ_SUCCESS : CJ_E_UNKNOWN;
+
+        case CJ_RGRAPH_NODE_MESH:
+            return execute_mesh_node(graph, node, cmd, extent) ? CJ_SUCCESS : CJ_E_UNKNOWN;
+
+        default:
+            fprintf(stderr, "cj_rgraph_execute: unknown node type %u\n", node->type);
+            return CJ_E_UNKNOWN;
+    }
+}
+
+/* Make transient writes in mask visible to fragment shader reads */
+static void emit_read_barriers(cj_rgraph_t* graph, VkCommandBuffer cmd, uint32_t mask) {
+    VkImageMemoryBarrier barriers[CJ_RGRAPH_MAX_RESOURCES];
+    uint32_t count = 0;
+    const cj_rgraph_transient_t* images = graph->extents[graph->active].images;
+    for (uint32_t r = 0; r < graph->resource_count; r++) {
+        if (!(mask & (1u << r)) || images[r].image == VK_NULL_HANDLE) continue;
+        VkImageMemoryBarrier* b = &barriers[count++];
+        memset(b, 0, sizeof(*b));
+        b->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        b->srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        b->dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        /* The transient render pass already transitioned the layout */
+        b->oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        b->newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        b->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b->image = images[r].image;
+        b->subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        b->subresourceRange.levelCount = 1;
+        b->subresourceRange.layerCount = 1;
     }
+    if (count == 0) return;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, NULL, 0, NULL, count, barriers);
+}
 
-    // Allocate vertex buffer memory
-    VkMemoryRequirements mem_requirements;
-    vkGetBufferMemoryRequirements(device, blur->vertex_buffer, &mem_requirements);
+/* Move a node pipeline to its newest build; its variants are then found under the new handle */
+static void adopt_pipeline(cj_rgraph_t* graph, cj_pipeline_cache_t* pipelines, VkPipeline* pipeline) {
+    VkPipeline old = *pipeline;
+    *pipeline = cj_pipeline_cache_current(pipelines, old);
+    if (*pipeline == old) return;
+    for (uint32_t i = 0; i < graph->variant_count; i++) {
+        if (graph->variants[i].base == old) graph->variants[i].base = *pipeline;
+    }
+}
 
-    // Find proper memory type (device local + host visible for vertex buffer)
-    VkPhysicalDeviceMemoryProperties mem_properties;
-    vkGetPhysicalDeviceMemoryProperties(cj_engine_physical_device(graph->engine), &mem_properties);
+/* Move node pipelines to the replacements shader reload installed since the last frame */
+static void adopt_reloaded_pipelines(cj_rgraph_t* graph) {
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    uint64_t generation = cj_pipeline_cache_generation(pipelines);
+    if (generation == graph->pipeline_generation) return;
+    graph->pipeline_generation = generation;
 
-    uint32_t memory_type_index = UINT32_MAX;
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if ((mem_requirements.memoryTypeBits & (1 << i)) &&
-            (mem_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
-            (mem_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
-            memory_type_index = i;
-            break;
+    for (cj_rgraph_node_t* node = graph->nodes; node; node = node->next) {
+        switch (node->type) {
+            case CJ_RGRAPH_NODE_BLUR: {
+                cj_rgraph_blur_node_t* blur = &node->data.blur;
+                adopt_pipeline(graph, pipelines, &blur->pipeline);
+                blur->pipeline_down = cj_pipeline_cache_current(pipelines, blur->pipeline_down);
+                blur->pipeline_compute = cj_pipeline_cache_current(pipelines, blur->pipeline_compute);
+                break;
+            }
+            case CJ_RGRAPH_NODE_TEXTURED: {
+                cj_rgraph_textured_node_t* textured = &node->data.textured;
+                adopt_pipeline(graph, pipelines, &textured->table_pipeline);
+                break;
+            }
+            case CJ_RGRAPH_NODE_SPRITE: {
+                cj_rgraph_sprite_node_t* sprite = &node->data.sprite;
+                adopt_pipeline(graph, pipelines, &sprite->pipeline);
+                break;
+            }
+            case CJ_RGRAPH_NODE_MESH: {
+                cj_rgraph_mesh_node_t* mesh = &node->data.mesh;
+                adopt_pipeline(graph, pipelines, &mesh->composite_pipeline);
+                mesh->pipeline = cj_pipeline_cache_current(pipelines, mesh->pipeline);
+                mesh->cull_pipeline = cj_pipeline_cache_current(pipelines, mesh->cull_pipeline);
+                break;
+            }
+            default:
+                break;
         }
     }
-
-    if (memory_type_index == UINT32_MAX) {
-        fprintf(stderr, "create_blur_node: failed to find suitable memory type\n");
-        vkDestroyBuffer(device, blur->vertex_buffer, NULL);
-        vkDestroyPipelineLayout(device, blur->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+    // Variants use the same shaders, so they were rebuilt as well
+    for (uint32_t i = 0; i < graph->variant_count; i++) {
+        graph->variants[i].pipeline = cj_pipeline_cache_current(pipelines, graph->variants[i].pipeline);
     }
+    // Cached backbuffer commands still bind the old pipelines
+    graph->content_version++;
+}
 
-    VkMemoryAllocateInfo alloc_info_mem = {0};
-    alloc_info_mem.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info_mem.allocationSize = mem_requirements.size;
-    alloc_info_mem.memoryTypeIndex = memory_type_index;
+/* Backbuffer nodes need variants of their pipelines for the current pass */
+static bool uses_variants(const cj_rgraph_t* graph) {
+    return graph->backbuffer_pass != VK_NULL_HANDLE && graph->backbuffer_pass != cj_engine_render_pass(graph->engine);
+}
 
-    if (vkAllocateMemory(device, &alloc_info_mem, NULL, &blur->vertex_buffer_memory) != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to allocate vertex buffer memory\n");
-        vkDestroyBuffer(device, blur->vertex_buffer, NULL);
-        vkDestroyPipelineLayout(device, blur->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+/* Pipeline a node binds for base: base itself, or its variant while recording a backbuffer
+ * of another format. VK_NULL_HANDLE when the variant could not be built. */
+static VkPipeline node_pipeline(const cj_rgraph_t* graph, VkPipeline base) {
+    if (!graph->recording_backbuffer || !uses_variants(graph) || base == VK_NULL_HANDLE) return base;
+    for (uint32_t i = 0; i < graph->variant_count; i++) {
+        const cj_rgraph_variant_t* v = &graph->variants[i];
+        if (v->base == base && v->pass == graph->backbuffer_pass) return v->pipeline;
     }
+    return VK_NULL_HANDLE;
+}
 
-    vkBindBufferMemory(device, blur->vertex_buffer, blur->vertex_buffer_memory, 0);
-
-    // Copy vertex data
-    void* data;
-    vkMapMemory(device, blur->vertex_buffer_memory, 0, sizeof(vertices), 0, &data);
-    memcpy(data, vertices, sizeof(vertices));
-    vkUnmapMemory(device, blur->vertex_buffer_memory);
-
-    // Create shader modules
-    VkShaderModuleCreateInfo vert_info = {0};
-    vert_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    vert_info.codeSize = blur_vert_spv_len;
-    vert_info.pCode = (const uint32_t*)blur_vert_spv;
-
-    VkShaderModule vert_shader = VK_NULL_HANDLE;
-    printf("create_blur_node: Creating vertex shader module (size: %u)\n", blur_vert_spv_len);
-    if (vkCreateShaderModule(device, &vert_info, NULL, &vert_shader) != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to create vertex shader module\n");
-        vkDestroyBuffer(device, blur->vertex_buffer, NULL);
-        vkFreeMemory(device, blur->vertex_buffer_memory, NULL);
-        vkDestroyPipelineLayout(device, blur->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+/* Build the variant of base for the backbuffer pass once. A node name reports failures. */
+static void ensure_variant(cj_rgraph_t* graph, VkPipeline base, const char* node_name) {
+    if (base == VK_NULL_HANDLE) return;
+    for (uint32_t i = 0; i < graph->variant_count; i++) {
+        if (graph->variants[i].base == base && graph->variants[i].pass == graph->backbuffer_pass) return;
     }
-    printf("create_blur_node: Vertex shader module created successfully\n");
-
-    VkShaderModuleCreateInfo frag_info = {0};
-    frag_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    frag_info.codeSize = blur_frag_spv_len;
-    frag_info.pCode = (const uint32_t*)blur_frag_spv;
-
-    VkShaderModule frag_shader = VK_NULL_HANDLE;
-    printf("create_blur_node: Creating fragment shader module (size: %u)\n", blur_frag_spv_len);
-    if (vkCreateShaderModule(device, &frag_info, NULL, &frag_shader) != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to create fragment shader module\n");
-        vkDestroyShaderModule(device, vert_shader, NULL);
-        vkDestroyBuffer(device, blur->vertex_buffer, NULL);
-        vkFreeMemory(device, blur->vertex_buffer_memory, NULL);
-        vkDestroyPipelineLayout(device, blur->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+    if (graph->variant_count == graph->variant_capacity) {
+        uint32_t capacity = graph->variant_capacity ? graph->variant_capacity * 2 : 8;
+        cj_rgraph_variant_t* grown = (cj_rgraph_variant_t*)realloc(graph->variants, capacity * sizeof(*grown));
+        if (!grown) return;
+        graph->variants = grown;
+        graph->variant_capacity = capacity;
+    }
+    // Failures are remembered too, so they are not retried every frame
+    VkPipeline pipeline = cj_pipeline_cache_variant(cj_engine_pipelines(graph->engine), base, graph->backbuffer_pass);
+    if (pipeline == VK_NULL_HANDLE && node_name) {
+        fprintf(stderr, "cj_rgraph_prepare: node %s cannot draw into this window's surface format and is skipped\n", node_name);
     }
-    printf("create_blur_node: Fragment shader module created successfully\n");
+    cj_rgraph_variant_t* v = &graph->variants[graph->variant_count++];
+    v->base = base;
+    v->pass = graph->backbuffer_pass;
+    v->pipeline = pipeline;
+}
 
-    // Create graphics pipeline (simplified - same for both horizontal and vertical for now)
-    VkPipelineShaderStageCreateInfo stages[2] = {0};
-    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-    stages[0].module = vert_shader;
-    stages[0].pName = "main";
-    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    stages[1].module = frag_shader;
-    stages[1].pName = "main";
+/* Variants for the pipelines the backbuffer nodes bind */
+static void prepare_variants(cj_rgraph_t* graph) {
+    if (!uses_variants(graph)) return;
+    for (uint32_t i = graph->offscreen_count; i < graph->schedule_count; i++) {
+        cj_rgraph_node_t* node = graph->schedule[i];
+        switch (node->type) {
+            case CJ_RGRAPH_NODE_BLUR:
+                ensure_variant(graph, node->data.blur.pipeline, node->name);
+                break;
+            case CJ_RGRAPH_NODE_TEXTURED: {
+                // The legacy pipeline only draws without a table pipeline to fall back from
+                cj_rgraph_textured_node_t* textured = &node->data.textured;
+                ensure_variant(graph, textured->table_pipeline, node->name);
+                ensure_variant(graph, textured->pipeline, textured->table_pipeline ? NULL : node->name);
+                break;
+            }
+            case CJ_RGRAPH_NODE_COLOR:
+                ensure_variant(graph, node->data.color.pipeline, node->name);
+                break;
+            case CJ_RGRAPH_NODE_SPRITE:
+                ensure_variant(graph, node->data.sprite.pipeline, node->name);
+                break;
+            case CJ_RGRAPH_NODE_MESH:
+                // Only the composite draws in the window pass; the objects go to the node's own pass
+                ensure_variant(graph, node->data.mesh.composite_pipeline, node->name);
+                break;
+            default:
+                break;
+        }
+    }
+}
 
-    VkVertexInputBindingDescription binding = {0};
-    binding.binding = 0;
-    binding.stride = sizeof(BlurVertex);
-    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+/*
+ * Compile, build the extent's transient images and plan the next frame drawn at it.
+ * Everything recording needs that allocates, writes descriptor sets or depends on the
+ * frame's parameters happens here, on the engine thread, so recording only reads it.
+ */
+CJ_API cj_result_t cj_rgraph_prepare(cj_rgraph_t* graph, VkExtent2D extent) {
+    if (!graph) return CJ_E_INVALID_ARGUMENT;
 
-    VkVertexInputAttributeDescription attrs[2] = {0};
-    attrs[0].binding = 0; attrs[0].location = 0; attrs[0].format = VK_FORMAT_R32G32_SFLOAT; attrs[0].offset = offsetof(BlurVertex, pos);
-    attrs[1].binding = 0; attrs[1].location = 1; attrs[1].format = VK_FORMAT_R32G32_SFLOAT; attrs[1].offset = offsetof(BlurVertex, tex);
+    adopt_reloaded_pipelines(graph);
 
-    VkPipelineVertexInputStateCreateInfo vi = {0};
-    vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vi.vertexBindingDescriptionCount = 1; vi.pVertexBindingDescriptions = &binding;
-    vi.vertexAttributeDescriptionCount = 2; vi.pVertexAttributeDescriptions = attrs;
+    if (graph->needs_recompile) {
+        cj_result_t result = cj_rgraph_recompile(graph);
+        if (result != CJ_SUCCESS) return result;
+    }
 
-    VkPipelineInputAssemblyStateCreateInfo ia = {0};
-    ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_FAN;
+    // A new extent takes an unused set, else the one prepared longest ago
+    uint32_t set = find_extent_set(graph, extent);
+    if (set == CJ_RGRAPH_EXTENTS) {
+        set = 0;
+        for (uint32_t i = 1; i < CJ_RGRAPH_EXTENTS; i++) {
+            if (graph->extents[i].prepared < graph->extents[set].prepared) set = i;
+        }
+        cj_result_t result = build_physical(graph, set, extent);
+        if (result != CJ_SUCCESS) return result;
+    }
+    graph->extents[set].prepared = ++graph->prepare_count;
+    graph->active = set;
 
-    VkViewport vp = {0}; vp.x=0; vp.y=0; vp.width=1.0f; vp.height=1.0f; vp.minDepth=0; vp.maxDepth=1;
-    VkRect2D sc = {0}; sc.extent.width = 1; sc.extent.height = 1;
-    VkPipelineViewportStateCreateInfo vps = {0};
-    vps.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    vps.viewportCount = 1; vps.pViewports = &vp; vps.scissorCount = 1; vps.pScissors = &sc;
+    // Blur chains planned for the next frame, and mesh targets
+    for (uint32_t i = 0; i < graph->schedule_count; i++) {
+        cj_rgraph_node_t* node = graph->schedule[i];
+        VkExtent2D target = i < graph->offscreen_count ? graph->extents[set].images[node->write].extent : extent;
+        if (node->type == CJ_RGRAPH_NODE_BLUR) {
+            if (!prepare_blur_node(graph, node, target)) return CJ_E_UNKNOWN;
+        } else if (node->type == CJ_RGRAPH_NODE_MESH && node->data.mesh.mesh) {
+            if (!prepare_mesh_node(graph, node, target)) return CJ_E_UNKNOWN;
+        }
+    }
+    prepare_variants(graph);
+    prepare_uniforms(graph);
+    return CJ_SUCCESS;
+}
 
-    VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    VkPipelineDynamicStateCreateInfo dynamic_state = {0};
-    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamic_state.dynamicStateCount = 2;
-    dynamic_state.pDynamicStates = dynamic_states;
+/* The frame draws into graph-owned images: transients, blur chains or mesh targets */
+static bool writes_offscreen_images(const cj_rgraph_t* graph) {
+    if (graph->offscreen_count > 0) return true;
+    for (uint32_t i = 0; i < graph->schedule_count; i++) {
+        uint32_t type = graph->schedule[i]->type;
+        if (type == CJ_RGRAPH_NODE_BLUR || type == CJ_RGRAPH_NODE_MESH) return true;
+    }
+    return false;
+}
 
-    VkPipelineRasterizationStateCreateInfo rs = {0};
-    rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rs.polygonMode = VK_POLYGON_MODE_FILL;
-    rs.lineWidth = 1.0f;
-    rs.cullMode = VK_CULL_MODE_NONE; // No culling for full-screen quad
+/*
+ * Graph-owned images are shared by every frame in flight, so the frames before this
+ * one must be done with them before it draws into them again. Commands submitted
+ * earlier are in the first scope of a pipeline barrier; the passes drawing into the
+ * images chain to it through their external dependency, which also orders the layout
+ * transition from UNDEFINED.
+ */
+static void begin_offscreen_writes(VkCommandBuffer cmd) {
+    VkMemoryBarrier barrier = {0};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                            VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                            VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &barrier, 0, NULL, 0, NULL);
+}
 
-    VkPipelineMultisampleStateCreateInfo ms = {0};
-    ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+/* Passes a node records before the render pass it draws in; CJ_SUCCESS for nodes without any */
+static cj_result_t record_prepass(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    switch (node->type) {
+        case CJ_RGRAPH_NODE_BLUR:
+            return record_blur_prepass(graph, node, cmd, extent);
+        case CJ_RGRAPH_NODE_MESH:
+            return record_mesh_prepass(graph, node, cmd, extent);
+        default:
+            return CJ_SUCCESS;
+    }
+}
 
-    VkPipelineColorBlendAttachmentState cba = {0};
-    cba.colorWriteMask = VK_COLOR_COMPONENT_R_BIT|VK_COLOR_COMPONENT_G_BIT|VK_COLOR_COMPONENT_B_BIT|VK_COLOR_COMPONENT_A_BIT;
-    VkPipelineColorBlendStateCreateInfo cb = {0};
-    cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    cb.attachmentCount = 1;
-    cb.pAttachments = &cba;
+/* Record the nodes that render into transients */
+CJ_API cj_result_t cj_rgraph_execute_offscreen(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent) {
+    if (!graph || !cmd) return CJ_E_INVALID_ARGUMENT;
 
-    VkGraphicsPipelineCreateInfo gp = {0};
-    gp.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    gp.stageCount = 2; gp.pStages = stages;
-    gp.pVertexInputState = &vi; gp.pInputAssemblyState = &ia; gp.pViewportState = &vps; gp.pRasterizationState = &rs; gp.pMultisampleState = &ms; gp.pColorBlendState = &cb; gp.pDynamicState = &dynamic_state;
-    gp.layout = blur->pipeline_layout; gp.renderPass = render_pass; gp.subpass = 0;
-
-    printf("create_blur_node: Creating graphics pipeline...\n");
-    VkResult pipeline_result = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &gp, NULL, &blur->pipeline_horizontal);
-    if (pipeline_result != VK_SUCCESS) {
-        fprintf(stderr, "create_blur_node: failed to create graphics pipeline (result: %d)\n", pipeline_result);
-        vkDestroyShaderModule(device, vert_shader, NULL);
-        vkDestroyShaderModule(device, frag_shader, NULL);
-        vkDestroyBuffer(device, blur->vertex_buffer, NULL);
-        vkFreeMemory(device, blur->vertex_buffer_memory, NULL);
-        vkDestroyPipelineLayout(device, blur->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
-        return 0;
+    // Recording may run on worker threads, so what cj_rgraph_prepare built is only read here
+    uint32_t set = graph->needs_recompile ? CJ_RGRAPH_EXTENTS : find_extent_set(graph, extent);
+    if (set == CJ_RGRAPH_EXTENTS) {
+        fprintf(stderr, "cj_rgraph_execute_offscreen: cj_rgraph_prepare was not called for %ux%u\n",
+                extent.width, extent.height);
+        return CJ_E_NOT_READY;
     }
-    printf("create_blur_node: Graphics pipeline created successfully\n");
+    graph->active = set;
 
-    // For now, use the same pipeline for both horizontal and vertical
-    blur->pipeline_vertical = blur->pipeline_horizontal;
+    /* A frame starts here: its offscreen and backbuffer nodes share one uniform buffer */
+    begin_uniform_frame(graph);
+    begin_async_frame(graph);
+    if (writes_offscreen_images(graph)) begin_offscreen_writes(cmd);
 
-    vkDestroyShaderModule(device, vert_shader, NULL);
-    vkDestroyShaderModule(device, frag_shader, NULL);
+    for (uint32_t i = 0; i < graph->offscreen_count; i++) {
+        cj_rgraph_node_t* node = graph->schedule[i];
+        const cj_rgraph_transient_t* target = &graph->extents[set].images[node->write];
 
-    return 1;
+        /* Earlier readers of the aliased memory must finish before it is overwritten */
+        if (node->alias_wait) {
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                 0, 0, NULL, 0, NULL, 0, NULL);
+        }
+        if (node->barrier_mask) emit_read_barriers(graph, cmd, node->barrier_mask);
+        uint32_t zone = cj_gpu_timer_begin(graph->gpu_timer, cmd, node->name);
+        cj_result_t prepass = record_prepass(graph, node, cmd, target->extent);
+        if (prepass != CJ_SUCCESS) {
+            cj_gpu_timer_end(graph->gpu_timer, cmd, zone);
+            return prepass;
+        }
+
+        VkRenderPassBeginInfo rp = {0};
+        rp.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        rp.renderPass = graph->transient_render_pass;
+        rp.framebuffer = target->framebuffer;
+        rp.renderArea.extent = target->extent;
+        VkClearValue clear = {{{0.0f, 0.0f, 0.0f, 0.0f}}};
+        rp.clearValueCount = 1;
+        rp.pClearValues = &clear;
+        vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+        cj_result_t result = execute_node(graph, node, cmd, target->extent);
+        vkCmdEndRenderPass(cmd);
+        cj_gpu_timer_end(graph->gpu_timer, cmd, zone);
+        if (result != CJ_SUCCESS) return result;
+    }
+
+    if (graph->final_barrier_mask) emit_read_barriers(graph, cmd, graph->final_barrier_mask);
+
+    // Blur and mesh nodes drawing into the backbuffer run their first passes before the window pass begins
+    for (uint32_t i = graph->offscreen_count; i < graph->schedule_count; i++) {
+        cj_rgraph_node_t* node = graph->schedule[i];
+        if (node->type != CJ_RGRAPH_NODE_BLUR && node->type != CJ_RGRAPH_NODE_MESH) continue;
+        char zone_name[CJ_PROFILER_NAME_SIZE];
+        snprintf(zone_name, sizeof(zone_name), "%.39s prepass", node->name);
+        uint32_t zone = cj_gpu_timer_begin(graph->gpu_timer, cmd, zone_name);
+        cj_result_t result = record_prepass(graph, node, cmd, extent);
+        cj_gpu_timer_end(graph->gpu_timer, cmd, zone);
+        if (result != CJ_SUCCESS) return result;
+    }
+    graph->offscreen_recorded = true;
+    return CJ_SUCCESS;
 }
 
-/* Destroy blur node resources */
-static void destroy_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_BLUR) return;
+/* Execute the backbuffer nodes of the render graph */
+CJ_API cj_result_t cj_rgraph_execute(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent) {
+    return cj_rgraph_execute_region(graph, cmd, extent, NULL);
+}
 
-    cj_rgraph_blur_node_t* blur = &node->data.blur;
-    VkDevice device = cj_engine_device(graph->engine);
+/* Execute the backbuffer nodes, clipped to a region of the backbuffer */
+CJ_API cj_result_t cj_rgraph_execute_region(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent,
+                                            const VkRect2D* region) {
+    if (!graph || !cmd) return CJ_E_INVALID_ARGUMENT;
 
-    // CRITICAL FIX: Clean up intermediate render target to prevent memory leak
-    destroy_intermediate_render_target(graph, blur);
+    if (graph->needs_recompile) {
+        cj_result_t result = cj_rgraph_recompile(graph);
+        if (result != CJ_SUCCESS) return result;
+    }
 
-    if (blur->pipeline_horizontal != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device, blur->pipeline_horizontal, NULL);
+    /* Backbuffer nodes sampling transients need this frame's offscreen work */
+    if (graph->offscreen_count > 0 && !graph->offscreen_recorded) {
+        fprintf(stderr, "cj_rgraph_execute: cj_rgraph_execute_offscreen was not recorded for this frame\n");
+        return CJ_E_NOT_READY;
     }
-    if (blur->pipeline_vertical != VK_NULL_HANDLE && blur->pipeline_vertical != blur->pipeline_horizontal) {
-        vkDestroyPipeline(device, blur->pipeline_vertical, NULL);
+    graph->offscreen_recorded = false;
+    if (!graph->uniform_open) begin_uniform_frame(graph);
+
+    // Nodes scissor to the region instead of the whole backbuffer
+    graph->clip_active = region != NULL;
+    if (region) graph->clip = *region;
+    graph->recording_backbuffer = true;
+
+    // Execute live backbuffer nodes in compiled order
+    cj_result_t result = CJ_SUCCESS;
+    for (uint32_t i = graph->offscreen_count; i < graph->schedule_count && result == CJ_SUCCESS; i++) {
+        uint32_t zone = cj_gpu_timer_begin(graph->gpu_timer, cmd, graph->schedule[i]->name);
+        result = execute_node(graph, graph->schedule[i], cmd, extent);
+        cj_gpu_timer_end(graph->gpu_timer, cmd, zone);
     }
-    if (blur->pipeline_layout != VK_NULL_HANDLE) {
-        vkDestroyPipelineLayout(device, blur->pipeline_layout, NULL);
+    graph->clip_active = false;
+    graph->recording_backbuffer = false;
+    graph->uniform_open = false;
+    return result;
+}
+
+/* Uniform bytes the schedule takes per frame, one aligned block per sprite node */
+static VkDeviceSize uniform_frame_size(cj_rgraph_t* graph) {
+    if (graph->uniform_alignment == 0) {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(cj_engine_physical_device(graph->engine), &props);
+        graph->uniform_alignment = props.limits.minUniformBufferOffsetAlignment;
+        if (graph->uniform_alignment == 0) graph->uniform_alignment = 1;
     }
-    if (blur->vertex_buffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(device, blur->vertex_buffer, NULL);
+    VkDeviceSize block = (CJ_RGRAPH_UNIFORM_RANGE + graph->uniform_alignment - 1u) & ~(graph->uniform_alignment - 1u);
+    VkDeviceSize size = 0;
+    for (uint32_t i = 0; i < graph->schedule_count; i++) {
+        if (graph->schedule[i]->type == CJ_RGRAPH_NODE_SPRITE) size += block;
     }
-    if (blur->vertex_buffer_memory != VK_NULL_HANDLE) {
-        vkFreeMemory(device, blur->vertex_buffer_memory, NULL);
+    return size;
+}
+
+/* Keep only the readers in mask on every ring entry of the graph */
+static void mask_readers(cj_rgraph_t* graph, uint32_t mask) {
+    for (uint32_t i = 0; i < CJ_RGRAPH_RING_FRAMES; i++) graph->uniform_frames[i].readers &= mask;
+    for (cj_rgraph_node_t* node = graph->nodes; node; node = node->next) {
+        for (uint32_t i = 0; i < CJ_RGRAPH_RING_FRAMES; i++) {
+            if (node->type == CJ_RGRAPH_NODE_SPRITE) node->data.sprite.frames[i].readers &= mask;
+            else if (node->type == CJ_RGRAPH_NODE_MESH) node->data.mesh.frames[i].readers &= mask;
+        }
     }
-    if (blur->desc_pool != VK_NULL_HANDLE) {
-        vkDestroyDescriptorPool(device, blur->desc_pool, NULL);
+}
+
+/* Wait until no frame reads any ring entry */
+static void drain_readers(cj_rgraph_t* graph) {
+    vkDeviceWaitIdle(cj_engine_device(graph->engine));
+    mask_readers(graph, 0);
+}
+
+/* Index of a reader, added on first use. A full table starts over once the device is
+ * idle, since no ring entry is read then. */
+static uint32_t find_reader(cj_rgraph_t* graph, const void* owner, uint32_t slot) {
+    for (uint32_t i = 0; i < graph->reader_count; i++) {
+        if (graph->readers[i].owner == owner && graph->readers[i].slot == slot) return i;
     }
-    if (blur->desc_layout != VK_NULL_HANDLE) {
-        vkDestroyDescriptorSetLayout(device, blur->desc_layout, NULL);
+    if (graph->reader_count == CJ_RGRAPH_MAX_READERS) {
+        drain_readers(graph);
+        graph->reader_count = 0;
     }
+    graph->readers[graph->reader_count].owner = owner;
+    graph->readers[graph->reader_count].slot = slot;
+    return graph->reader_count++;
 }
 
-/* Execute a blur node */
-static int execute_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_BLUR || !cmd) return 0;
+/* Name the reader of the next frame recorded */
+void cj_rgraph__set_frame(cj_rgraph_t* graph, const void* owner, uint32_t slot) {
+    if (!graph) return;
+    graph->reader = find_reader(graph, owner, slot);
+    graph->reader_set = true;
+}
 
-    cj_rgraph_blur_node_t* blur = &node->data.blur;
+/*
+ * Start the frame of the named reader, or else of direct callers, whose frames take
+ * the CJ_WINDOW_MAX_FRAMES_IN_FLIGHT slots in turn. The reader's previous frame has
+ * finished, so the entries it read stop counting it.
+ */
+static uint32_t begin_reader_frame(cj_rgraph_t* graph) {
+    if (!graph->reader_set) {
+        graph->reader = find_reader(graph, NULL, graph->direct_slot);
+        graph->direct_slot = (graph->direct_slot + 1u) % CJ_WINDOW_MAX_FRAMES_IN_FLIGHT;
+    }
+    graph->reader_set = false;
+    mask_readers(graph, ~(1u << graph->reader));
+    return graph->reader;
+}
 
+/* Give a ring entry a buffer of at least size bytes and a set of its own over it. The old
+ * buffer and set go through the deletion queue, since frames in flight may still read them. */
+static bool grow_uniform_frame(cj_rgraph_t* graph, cj_rgraph_uniform_frame_t* frame, VkDeviceSize size) {
+    VkDeviceSize capacity = frame->capacity ? frame->capacity : 1024u;
+    while (capacity < size) capacity *= 2u;
+
+    if (frame->buffer != VK_NULL_HANDLE || frame->pool != VK_NULL_HANDLE) {
+        cj_engine_garbage_t garbage = {0};
+        garbage.buffer = frame->buffer;
+        garbage.alloc = frame->alloc;
+        garbage.pool = frame->pool;
+        cj_engine_retire(graph->engine, &garbage);
+    }
+    frame->buffer = VK_NULL_HANDLE;
+    memset(&frame->alloc, 0, sizeof(frame->alloc));
+    frame->pool = VK_NULL_HANDLE;
+    frame->set = VK_NULL_HANDLE;
+    frame->capacity = 0;
+
+    cj_gpu_allocator_t* gpu = cj_engine_gpu_allocator(graph->engine);
+    if (!cj_gpu_create_buffer(gpu, capacity, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              CJ_GPU_ALLOC_LINEAR, &frame->buffer, &frame->alloc)) {
+        fprintf(stderr, "cj_rgraph: failed to create a %llu byte uniform buffer\n", (unsigned long long)capacity);
+        return false;
+    }
 
-    // Create intermediate render target if it doesn't exist
-    if (blur->intermediate_texture == VK_NULL_HANDLE) {
-        if (!create_intermediate_render_target(graph, blur, extent)) {
-            return 0;
-        }
+    VkDevice device = cj_engine_device(graph->engine);
+    VkDescriptorPoolSize pool_size = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
+    VkDescriptorPoolCreateInfo pi = {0};
+    pi.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pi.maxSets = 1;
+    pi.poolSizeCount = 1;
+    pi.pPoolSizes = &pool_size;
+    if (vkCreateDescriptorPool(device, &pi, NULL, &frame->pool) != VK_SUCCESS) {
+        frame->pool = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to create a uniform descriptor pool\n");
+        return false;
+    }
+    VkDescriptorSetLayout layout = cj_engine_uniform_set_layout(graph->engine);
+    VkDescriptorSetAllocateInfo ai = {0};
+    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    ai.descriptorPool = frame->pool;
+    ai.descriptorSetCount = 1;
+    ai.pSetLayouts = &layout;
+    if (layout == VK_NULL_HANDLE || vkAllocateDescriptorSets(device, &ai, &frame->set) != VK_SUCCESS) {
+        frame->set = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to allocate a uniform descriptor set\n");
+        return false;
     }
 
-    // Set viewport and scissor
-    VkViewport viewport = {0};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)extent.width;
-    viewport.height = (float)extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    VkDescriptorBufferInfo bi = { frame->buffer, 0, CJ_RGRAPH_UNIFORM_RANGE };
+    VkWriteDescriptorSet write = {0};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = frame->set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo = &bi;
+    vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+    frame->capacity = capacity;
+    return true;
+}
 
-    VkRect2D scissor = {0};
-    scissor.offset = (VkOffset2D){0, 0};
-    scissor.extent = extent;
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
+/* Size every ring entry for the schedule, so recording never allocates */
+static void prepare_uniforms(cj_rgraph_t* graph) {
+    VkDeviceSize size = uniform_frame_size(graph);
+    for (uint32_t i = 0; i < CJ_RGRAPH_RING_FRAMES; i++) {
+        cj_rgraph_uniform_frame_t* frame = &graph->uniform_frames[i];
+        if (size > frame->capacity && !grow_uniform_frame(graph, frame, size)) return;
+    }
+}
 
-    // Safety checks before Vulkan operations
-    if (blur->pipeline_horizontal == VK_NULL_HANDLE) {
-        return 0;
+/*
+ * Take the uniform ring entry of the frame being recorded: one no frame in flight
+ * reads, else the device is waited for. Direct callers may record without
+ * cj_rgraph_prepare, which sizes the entries, so theirs may still grow here.
+ */
+static void begin_uniform_frame(cj_rgraph_t* graph) {
+    uint32_t reader = begin_reader_frame(graph);
+    uint32_t entry = 0;
+    while (entry < CJ_RGRAPH_RING_FRAMES && graph->uniform_frames[entry].readers) entry++;
+    if (entry == CJ_RGRAPH_RING_FRAMES) {
+        drain_readers(graph);
+        entry = 0;
     }
 
-    if (blur->pipeline_layout == VK_NULL_HANDLE) {
-        return 0;
+    graph->uniform_frame = entry;
+    graph->uniform_open = true;
+    cj_rgraph_uniform_frame_t* frame = &graph->uniform_frames[entry];
+    frame->used = 0;
+    frame->readers |= 1u << reader;
+
+    VkDeviceSize size = uniform_frame_size(graph);
+    if (size > frame->capacity && graph->readers[reader].owner == NULL) grow_uniform_frame(graph, frame, size);
+}
+
+/* Take an aligned block of the frame's uniform buffer for one node draw. NULL without room */
+static void* alloc_uniforms(cj_rgraph_t* graph, VkDeviceSize size, VkDescriptorSet* out_set, uint32_t* out_offset) {
+    if (!graph->uniform_open) begin_uniform_frame(graph);
+    cj_rgraph_uniform_frame_t* frame = &graph->uniform_frames[graph->uniform_frame];
+    VkDeviceSize block = (size + graph->uniform_alignment - 1u) & ~(graph->uniform_alignment - 1u);
+    if (size > CJ_RGRAPH_UNIFORM_RANGE || frame->used + block > frame->capacity) {
+        fprintf(stderr, "cj_rgraph: no room for node uniforms this frame\n");
+        return NULL;
     }
+    *out_set = frame->set;
+    *out_offset = (uint32_t)frame->used;
+    void* block_ptr = (uint8_t*)frame->alloc.mapped + frame->used;
+    frame->used += block;
+    return block_ptr;
+}
 
-    if (blur->vertex_buffer == VK_NULL_HANDLE) {
-        return 0;
+/* Free the uniform buffers and their sets */
+static void release_uniforms(cj_rgraph_t* graph) {
+    cj_gpu_allocator_t* gpu = cj_engine_gpu_allocator(graph->engine);
+    VkDevice device = cj_engine_device(graph->engine);
+    for (uint32_t i = 0; i < CJ_RGRAPH_RING_FRAMES; i++) {
+        cj_rgraph_uniform_frame_t* frame = &graph->uniform_frames[i];
+        cj_gpu_destroy_buffer(gpu, &frame->buffer, &frame->alloc);
+        if (frame->pool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, frame->pool, NULL);
+        frame->pool = VK_NULL_HANDLE;
+        frame->set = VK_NULL_HANDLE;
     }
+}
 
-    // SIMPLIFIED MULTI-PASS RENDERING:
-    // For now, just apply animated blur directly to the fish texture
-    // TODO: Implement true multi-pass with intermediate texture
+/* Create the timeline and the compute queue's command buffers */
+static bool create_async(cj_rgraph_t* graph) {
+    VkDevice device = cj_engine_device(graph->engine);
+    VkSemaphoreTypeCreateInfo type_info = {0};
+    type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    VkSemaphoreCreateInfo sem_info = {0};
+    sem_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    sem_info.pNext = &type_info;
+    if (vkCreateSemaphore(device, &sem_info, NULL, &graph->async_timeline) != VK_SUCCESS) {
+        graph->async_timeline = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to create the async compute timeline\n");
+        return false;
+    }
 
+    VkCommandPoolCreateInfo pool_info = {0};
+    pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    pool_info.queueFamilyIndex = cj_engine_compute_family(graph->engine);
+    if (vkCreateCommandPool(device, &pool_info, NULL, &graph->async_pool) != VK_SUCCESS) {
+        graph->async_pool = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to create the async compute command pool\n");
+        return false;
+    }
+    VkCommandBufferAllocateInfo ai = {0};
+    ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    ai.commandPool = graph->async_pool;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = 2;
+    if (vkAllocateCommandBuffers(device, &ai, graph->async_cmds) != VK_SUCCESS) {
+        graph->async_cmds[0] = graph->async_cmds[1] = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to allocate async compute command buffers\n");
+        return false;
+    }
+    return true;
+}
 
-    // Apply animated blur directly to fish texture
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, blur->pipeline_horizontal);
+/* Wait for the compute queue and free the async objects */
+static void release_async(cj_rgraph_t* graph) {
+    VkDevice device = cj_engine_device(graph->engine);
+    if (graph->async_recording) {
+        vkEndCommandBuffer(graph->async_cmds[graph->async_frame & 1u]);
+        graph->async_recording = false;
+    }
+    if (graph->async_compute_value) {
+        cj_engine_wait_timeline(graph->engine, graph->async_timeline, graph->async_compute_value);
+    }
+    if (graph->async_pool != VK_NULL_HANDLE) vkDestroyCommandPool(device, graph->async_pool, NULL);
+    if (graph->async_timeline != VK_NULL_HANDLE) vkDestroySemaphore(device, graph->async_timeline, NULL);
+    graph->async_pool = VK_NULL_HANDLE;
+    graph->async_timeline = VK_NULL_HANDLE;
+    graph->async_cmds[0] = graph->async_cmds[1] = VK_NULL_HANDLE;
+    graph->async_cmd_values[0] = graph->async_cmd_values[1] = 0;
+    graph->async_compute_value = 0;
+}
 
-    // Animated blur intensity - cycle every 2 seconds (like red/green animation)
-    static float time_counter = 0.0f;
-    time_counter += 0.016f; // 60 FPS timing
-    float blur_intensity = (sinf(time_counter * 3.14159f) + 1.0f) * 0.5f * 0.3f; // Animate between 0.0 and 0.3 with 2-second period
+/* A frame starts: compute work recorded for a frame that was never submitted is dropped */
+static void begin_async_frame(cj_rgraph_t* graph) {
+    if (graph->async_recording) {
+        vkEndCommandBuffer(graph->async_cmds[graph->async_frame & 1u]);
+        graph->async_recording = false;
+    }
+    graph->async_frame++;
+    graph->async_signal = 0;
+}
 
-    float push_constants[6] = {
-        1.0f / (float)extent.width,  // texelSize.x
-        1.0f / (float)extent.height, // texelSize.y
-        1.0f, 0.0f,                  // direction (horizontal)
-        blur_intensity,              // intensity (animated)
-        time_counter                 // time (animated)
-    };
-    vkCmdPushConstants(cmd, blur->pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_constants), push_constants);
+/* Command buffer collecting this frame's compute queue work, begun on first use;
+ * VK_NULL_HANDLE when the async objects are unavailable */
+static VkCommandBuffer async_commands(cj_rgraph_t* graph) {
+    uint32_t slot = (uint32_t)(graph->async_frame & 1u);
+    if (graph->async_recording) return graph->async_cmds[slot];
+    if (graph->async_failed) return VK_NULL_HANDLE;
+    if (graph->async_pool == VK_NULL_HANDLE && !create_async(graph)) {
+        // Blur nodes stay on the graphics queue from now on
+        release_async(graph);
+        graph->async_failed = true;
+        return VK_NULL_HANDLE;
+    }
 
-    // Bind fish texture descriptor set
-    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
-    if (tx && tx->descriptorSet != VK_NULL_HANDLE) {
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, blur->pipeline_layout, 0, 1, &tx->descriptorSet, 0, NULL);
-    } else {
-        return 0;
+    // Its previous submission, two frames ago, has normally finished already
+    VkCommandBuffer cmd = graph->async_cmds[slot];
+    VkCommandBufferBeginInfo begin = {0};
+    begin.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (!cj_engine_wait_timeline(graph->engine, graph->async_timeline, graph->async_cmd_values[slot]) ||
+        vkResetCommandBuffer(cmd, 0) != VK_SUCCESS || vkBeginCommandBuffer(cmd, &begin) != VK_SUCCESS) {
+        fprintf(stderr, "cj_rgraph: failed to begin async compute commands\n");
+        return VK_NULL_HANDLE;
     }
+    graph->async_recording = true;
+    return cmd;
+}
 
-    // Draw blur effect
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmd, 0, 1, &blur->vertex_buffer, offsets);
-    vkCmdDraw(cmd, 4, 1, 0, 0);
+void cj_rgraph__async_sync(cj_rgraph_t* graph, cj_rgraph_async_sync_t* out) {
+    memset(out, 0, sizeof(*out));
+    if (!graph || graph->async_timeline == VK_NULL_HANDLE) return;
 
-    return 1; // Success - true multi-pass rendering
+    // The compute work submitted last wrote results this frame may sample, and read
+    // inputs this frame may overwrite
+    if (graph->async_compute_value > graph->async_waited) out->wait_value = graph->async_compute_value;
+    if (graph->async_recording) {
+        graph->async_signal = ++graph->async_value;
+        out->signal_value = graph->async_signal;
+    }
+    if (out->wait_value || out->signal_value) out->semaphore = graph->async_timeline;
 }
 
-/* Create textured node resources */
-static int create_textured_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_TEXTURED) return 0;
+void cj_rgraph__submit_async(cj_rgraph_t* graph, bool submitted) {
+    if (!graph || graph->async_timeline == VK_NULL_HANDLE) return;
+    if (submitted && graph->async_compute_value > graph->async_waited) {
+        graph->async_waited = graph->async_compute_value;
+    }
+    if (!graph->async_recording) return;
 
-    cj_rgraph_textured_node_t* textured = &node->data.textured;
-    VkDevice device = cj_engine_device(graph->engine);
-    // VkRenderPass render_pass = cj_engine_render_pass(graph->engine); // TODO: Use for pipeline creation
-
-    // Create descriptor set layout
-    VkDescriptorSetLayoutBinding layout_binding = {0};
-    layout_binding.binding = 0;
-    layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    layout_binding.descriptorCount = 1;
-    layout_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    VkDescriptorSetLayoutCreateInfo layout_info = {0};
-    layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layout_info.bindingCount = 1;
-    layout_info.pBindings = &layout_binding;
-
-    if (vkCreateDescriptorSetLayout(device, &layout_info, NULL, &textured->desc_layout) != VK_SUCCESS) {
-        fprintf(stderr, "create_textured_node: failed to create descriptor set layout\n");
-        return 0;
+    uint32_t slot = (uint32_t)(graph->async_frame & 1u);
+    VkCommandBuffer cmd = graph->async_cmds[slot];
+    graph->async_recording = false;
+    if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
+        fprintf(stderr, "cj_rgraph: failed to end async compute commands\n");
+        return;
+    }
+    // Without the frame that feeds it, the work is dropped and the next frame blurs on graphics
+    if (!submitted || graph->async_signal == 0) return;
+
+    uint64_t value = graph->async_value + 1u;
+    VkTimelineSemaphoreSubmitInfo timeline = {0};
+    timeline.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline.waitSemaphoreValueCount = 1;
+    timeline.pWaitSemaphoreValues = &graph->async_signal;
+    timeline.signalSemaphoreValueCount = 1;
+    timeline.pSignalSemaphoreValues = &value;
+    VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    VkSubmitInfo si = {0};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.pNext = &timeline;
+    si.waitSemaphoreCount = 1;
+    si.pWaitSemaphores = &graph->async_timeline;
+    si.pWaitDstStageMask = &wait_stage;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &cmd;
+    si.signalSemaphoreCount = 1;
+    si.pSignalSemaphores = &graph->async_timeline;
+    if (vkQueueSubmit(cj_engine_compute_queue(graph->engine), 1, &si, VK_NULL_HANDLE) != VK_SUCCESS) {
+        fprintf(stderr, "cj_rgraph: failed to submit async compute work\n");
+        return;
     }
+    graph->async_value = value;
+    graph->async_compute_value = value;
+    graph->async_cmd_values[slot] = value;
+    graph->async_submitted_frame = graph->async_frame;
+}
 
-    // Create descriptor pool
-    VkDescriptorPoolSize pool_size = {0};
-    pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    pool_size.descriptorCount = 1;
+void cj_rgraph__set_backbuffer_pass(cj_rgraph_t* graph, VkRenderPass pass) {
+    if (graph) graph->backbuffer_pass = pass;
+}
 
-    VkDescriptorPoolCreateInfo pool_info = {0};
-    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    pool_info.poolSizeCount = 1;
-    pool_info.pPoolSizes = &pool_size;
-    pool_info.maxSets = 1;
+/* Select the timer node zones are written into */
+void cj_rgraph__set_gpu_timer(cj_rgraph_t* graph, cj_gpu_timer_t* timer) {
+    if (graph) graph->gpu_timer = timer;
+}
 
-    if (vkCreateDescriptorPool(device, &pool_info, NULL, &textured->desc_pool) != VK_SUCCESS) {
-        fprintf(stderr, "create_textured_node: failed to create descriptor pool\n");
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
-        return 0;
+/* Scissor a node draw to the extent, or to the redrawn region of the backbuffer */
+static void set_node_scissor(cj_rgraph_t* graph, VkCommandBuffer cmd, VkExtent2D extent) {
+    VkRect2D scissor = {0};
+    scissor.offset = (VkOffset2D){0, 0};
+    scissor.extent = extent;
+    if (graph->clip_active) {
+        // Intersect with the extent; an empty intersection draws nothing
+        int32_t x0 = graph->clip.offset.x > 0 ? graph->clip.offset.x : 0;
+        int32_t y0 = graph->clip.offset.y > 0 ? graph->clip.offset.y : 0;
+        int64_t x1 = (int64_t)graph->clip.offset.x + graph->clip.extent.width;
+        int64_t y1 = (int64_t)graph->clip.offset.y + graph->clip.extent.height;
+        if (x1 > (int64_t)extent.width) x1 = extent.width;
+        if (y1 > (int64_t)extent.height) y1 = extent.height;
+        scissor.offset = (VkOffset2D){x0, y0};
+        scissor.extent.width = x1 > x0 ? (uint32_t)(x1 - x0) : 0;
+        scissor.extent.height = y1 > y0 ? (uint32_t)(y1 - y0) : 0;
     }
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+}
 
-    // Allocate descriptor set
-    VkDescriptorSetAllocateInfo alloc_info = {0};
-    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    alloc_info.descriptorPool = textured->desc_pool;
-    alloc_info.descriptorSetCount = 1;
-    alloc_info.pSetLayouts = &textured->desc_layout;
+/* Check whether backbuffer commands can be recorded once and replayed */
+CJ_API bool cj_rgraph_is_static(cj_rgraph_t* graph) {
+    if (!graph) return false;
+    if (graph->needs_recompile && cj_rgraph_recompile(graph) != CJ_SUCCESS) return false;
+    if (graph->schedule_count == graph->offscreen_count) return false;
 
-    if (vkAllocateDescriptorSets(device, &alloc_info, &textured->desc_set) != VK_SUCCESS) {
-        fprintf(stderr, "create_textured_node: failed to allocate descriptor set\n");
-        vkDestroyDescriptorPool(device, textured->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
-        return 0;
+    for (uint32_t i = graph->offscreen_count; i < graph->schedule_count; i++) {
+        /* Blur and mesh nodes record passes outside the window pass every frame; pass-through uses legacy drawing */
+        uint32_t type = graph->schedule[i]->type;
+        if (type != CJ_RGRAPH_NODE_TEXTURED && type != CJ_RGRAPH_NODE_COLOR) return false;
     }
+    return true;
+}
 
-    // Create pipeline layout
-    VkPipelineLayoutCreateInfo pli = {0};
-    pli.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pli.setLayoutCount = 1;
-    pli.pSetLayouts = &textured->desc_layout;
+/* Version of the backbuffer commands cj_rgraph_execute would record */
+CJ_API uint64_t cj_rgraph_content_version(cj_rgraph_t* graph) {
+    if (!graph) return 0;
 
-    if (vkCreatePipelineLayout(device, &pli, NULL, &textured->pipeline_layout) != VK_SUCCESS) {
-        fprintf(stderr, "create_textured_node: failed to create pipeline layout\n");
-        vkDestroyDescriptorPool(device, textured->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
-        return 0;
+    /* Color nodes push the engine colorMul, which changes outside the graph */
+    CJellyBindlessResources* color_resources = cj_engine_color_pipeline(graph->engine);
+    if (color_resources && memcmp(graph->color_mul_snapshot, color_resources->colorMul,
+                                  sizeof(graph->color_mul_snapshot)) != 0) {
+        memcpy(graph->color_mul_snapshot, color_resources->colorMul, sizeof(graph->color_mul_snapshot));
+        graph->content_version++;
     }
+    return graph->content_version;
+}
 
-    // Create full-screen quad vertex buffer (same size as color rectangle) - 6 vertices for two triangles
-    typedef struct { float pos[2]; float tex[2]; } TexturedVertex;
-    TexturedVertex vertices[] = {
-        // Triangle 1: bottom-left, bottom-right, top-right
-        {{-0.5f, -0.5f}, {0.0f, 0.0f}},  // bottom-left
-        {{ 0.5f, -0.5f}, {1.0f, 0.0f}},  // bottom-right
-        {{ 0.5f,  0.5f}, {1.0f, 1.0f}},  // top-right
-        // Triangle 2: top-right, top-left, bottom-left
-        {{ 0.5f,  0.5f}, {1.0f, 1.0f}},  // top-right
-        {{-0.5f,  0.5f}, {0.0f, 1.0f}},  // top-left
-        {{-0.5f, -0.5f}, {0.0f, 0.0f}},  // bottom-left
-    };
+/* Write a fragment-stage node set sampling view */
+static void write_blur_sampler_set(VkDevice device, VkDescriptorSet set, VkSampler sampler, VkImageView view) {
+    VkDescriptorImageInfo image_info = {0};
+    image_info.sampler = sampler;
+    image_info.imageView = view;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkWriteDescriptorSet write = {0};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+}
 
-    VkBufferCreateInfo buffer_info = {0};
-    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_info.size = sizeof(vertices);
-    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateBuffer(device, &buffer_info, NULL, &textured->vertex_buffer) != VK_SUCCESS) {
-        fprintf(stderr, "create_textured_node: failed to create vertex buffer\n");
-        vkDestroyPipelineLayout(device, textured->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, textured->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
-        return 0;
+/* Write a compute set reading input and storing into output */
+static void write_blur_compute_set(VkDevice device, VkDescriptorSet set, VkSampler sampler,
+                                   VkImageView input, VkImageView output) {
+    VkDescriptorImageInfo images[2] = {{0}};
+    images[0].sampler = sampler;
+    images[0].imageView = input;
+    images[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    images[1].imageView = output;
+    images[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    VkWriteDescriptorSet writes[2] = {{0}};
+    for (uint32_t i = 0; i < 2; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].pImageInfo = &images[i];
     }
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    vkUpdateDescriptorSets(device, 2, writes, 0, NULL);
+}
 
-    // Allocate vertex buffer memory
-    VkMemoryRequirements mem_requirements;
-    vkGetBufferMemoryRequirements(device, textured->vertex_buffer, &mem_requirements);
+/* Destroy a blur chain image; safe on an empty one */
+static void destroy_blur_image(cj_rgraph_t* graph, cj_rgraph_blur_image_t* img) {
+    VkDevice device = cj_engine_device(graph->engine);
+    cj_engine_free_node_set(graph->engine, img->set_pool, img->set);
+    if (img->framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(device, img->framebuffer, NULL);
+    if (img->view != VK_NULL_HANDLE) vkDestroyImageView(device, img->view, NULL);
+    if (img->image != VK_NULL_HANDLE) vkDestroyImage(device, img->image, NULL);
+    cj_gpu_free(cj_engine_gpu_allocator(graph->engine), &img->alloc);
+    memset(img, 0, sizeof(*img));
+}
 
-    VkPhysicalDevice physical_device = cj_engine_physical_device(graph->engine);
-    VkPhysicalDeviceMemoryProperties mem_properties;
-    vkGetPhysicalDeviceMemoryProperties(physical_device, &mem_properties);
+/* Create a blur chain image: a transient render pass target, or an RGBA8 storage image */
+static int create_blur_image(cj_rgraph_t* graph, cj_rgraph_blur_node_t* blur, cj_rgraph_blur_image_t* img,
+                             VkExtent2D extent, bool storage) {
+    VkDevice device = cj_engine_device(graph->engine);
+    VkFormat format = storage ? VK_FORMAT_R8G8B8A8_UNORM : cj_engine_color_format(graph->engine);
+    if (!storage && !ensure_transient_render_pass(graph)) return 0;
 
-    uint32_t memory_type_index = UINT32_MAX;
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if ((mem_requirements.memoryTypeBits & (1 << i)) &&
-            (mem_properties.memoryTypes[i].propertyFlags & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))) {
-            memory_type_index = i;
-            break;
-        }
+    VkImageCreateInfo image_info = {0};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent.width = extent.width;
+    image_info.extent.height = extent.height;
+    image_info.extent.depth = 1;
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.format = format;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = VK_IMAGE_USAGE_SAMPLED_BIT |
+                       (storage ? VK_IMAGE_USAGE_STORAGE_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(device, &image_info, NULL, &img->image) != VK_SUCCESS) {
+        img->image = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to create a %ux%u blur image\n", extent.width, extent.height);
+        return 0;
     }
-
-    if (memory_type_index == UINT32_MAX) {
-        fprintf(stderr, "create_textured_node: failed to find suitable memory type\n");
-        vkDestroyBuffer(device, textured->vertex_buffer, NULL);
-        vkDestroyPipelineLayout(device, textured->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, textured->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
+    if (!cj_gpu_alloc_image(cj_engine_gpu_allocator(graph->engine), img->image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                            CJ_GPU_ALLOC_OPTIMAL, &img->alloc)) {
+        fprintf(stderr, "cj_rgraph: failed to allocate a %ux%u blur image\n", extent.width, extent.height);
+        destroy_blur_image(graph, img);
         return 0;
     }
 
-    VkMemoryAllocateInfo alloc_info_mem = {0};
-    alloc_info_mem.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info_mem.allocationSize = mem_requirements.size;
-    alloc_info_mem.memoryTypeIndex = memory_type_index;
-
-    if (vkAllocateMemory(device, &alloc_info_mem, NULL, &textured->vertex_buffer_memory) != VK_SUCCESS) {
-        fprintf(stderr, "create_textured_node: failed to allocate vertex buffer memory\n");
-        vkDestroyBuffer(device, textured->vertex_buffer, NULL);
-        vkDestroyPipelineLayout(device, textured->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, textured->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
+    VkImageViewCreateInfo view_info = {0};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = img->image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = format;
+    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    view_info.subresourceRange.levelCount = 1;
+    view_info.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device, &view_info, NULL, &img->view) != VK_SUCCESS) {
+        img->view = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to create a blur image view\n");
+        destroy_blur_image(graph, img);
         return 0;
     }
 
-    vkBindBufferMemory(device, textured->vertex_buffer, textured->vertex_buffer_memory, 0);
-
-    // Copy vertex data
-    void* data;
-    vkMapMemory(device, textured->vertex_buffer_memory, 0, sizeof(vertices), 0, &data);
-    memcpy(data, vertices, sizeof(vertices));
-    vkUnmapMemory(device, textured->vertex_buffer_memory);
-
-    // Load fish texture
-    // TODO: Load the actual fish texture from "test/images/bmp/tang.bmp"
-    // For now, create a placeholder texture
-
-    // Create graphics pipeline
-    VkShaderModuleCreateInfo vert_info = {0};
-    vert_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    vert_info.codeSize = textured_vert_spv_len; // Use proper textured vertex shader
-    vert_info.pCode = (const uint32_t*)textured_vert_spv;
-
-    VkShaderModule vert_shader = VK_NULL_HANDLE;
-    if (vkCreateShaderModule(device, &vert_info, NULL, &vert_shader) != VK_SUCCESS) {
-        fprintf(stderr, "create_textured_node: failed to create vertex shader module\n");
-        vkDestroyBuffer(device, textured->vertex_buffer, NULL);
-        vkFreeMemory(device, textured->vertex_buffer_memory, NULL);
-        vkDestroyPipelineLayout(device, textured->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, textured->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
-        return 0;
+    if (!storage) {
+        VkFramebufferCreateInfo fb_info = {0};
+        fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        fb_info.renderPass = graph->transient_render_pass;
+        fb_info.attachmentCount = 1;
+        fb_info.pAttachments = &img->view;
+        fb_info.width = extent.width;
+        fb_info.height = extent.height;
+        fb_info.layers = 1;
+        if (vkCreateFramebuffer(device, &fb_info, NULL, &img->framebuffer) != VK_SUCCESS) {
+            img->framebuffer = VK_NULL_HANDLE;
+            fprintf(stderr, "cj_rgraph: failed to create a blur framebuffer\n");
+            destroy_blur_image(graph, img);
+            return 0;
+        }
     }
 
-    // Get textured pipeline from engine's textured resources
-    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
-    if (!tx || tx->pipeline == VK_NULL_HANDLE) {
-        fprintf(stderr, "create_textured_node: failed to get engine textured pipeline\n");
-        vkDestroyShaderModule(device, vert_shader, NULL);
-        vkDestroyBuffer(device, textured->vertex_buffer, NULL);
-        vkFreeMemory(device, textured->vertex_buffer_memory, NULL);
-        vkDestroyPipelineLayout(device, textured->pipeline_layout, NULL);
-        vkDestroyDescriptorPool(device, textured->desc_pool, NULL);
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
+    img->set = cj_engine_alloc_node_set(graph->engine, &img->set_pool);
+    if (img->set == VK_NULL_HANDLE) {
+        fprintf(stderr, "cj_rgraph: failed to allocate a blur descriptor set\n");
+        destroy_blur_image(graph, img);
         return 0;
     }
-    textured->pipeline = tx->pipeline;
-
-    vkDestroyShaderModule(device, vert_shader, NULL);
-
+    write_blur_sampler_set(device, img->set, blur->sampler, img->view);
     return 1;
 }
 
-/* Destroy textured node resources */
-static void destroy_textured_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_TEXTURED) return;
-
-    VkDevice device = cj_engine_device(graph->engine);
-    cj_rgraph_textured_node_t* textured = &node->data.textured;
+/* Hand a blur chain image to the engine deletion queue; safe on an empty one */
+static void retire_blur_image(cj_rgraph_t* graph, cj_rgraph_blur_image_t* img) {
+    if (img->image == VK_NULL_HANDLE && img->set == VK_NULL_HANDLE) return;
+    cj_engine_garbage_t garbage = {0};
+    garbage.framebuffer = img->framebuffer;
+    garbage.view = img->view;
+    garbage.image = img->image;
+    garbage.alloc = img->alloc;
+    garbage.set_pool = img->set_pool;
+    garbage.set = img->set;
+    cj_engine_retire(graph->engine, &garbage);
+    memset(img, 0, sizeof(*img));
+}
 
-    if (textured->texture_view != VK_NULL_HANDLE) {
-        vkDestroyImageView(device, textured->texture_view, NULL);
-        textured->texture_view = VK_NULL_HANDLE;
+/* Retire a chain's images and sets behind the frames that may still use them, and clear it */
+static void release_blur_chain(cj_rgraph_t* graph, cj_rgraph_blur_chain_t* chain) {
+    // The deletion queue follows graphics submissions; compute queue work is waited for here
+    bool async = false;
+    for (uint32_t l = 0; l <= CJ_RGRAPH_BLUR_MAX_LEVELS; l++) {
+        if (chain->levels[l].async_work.image != VK_NULL_HANDLE) async = true;
     }
-
-    if (textured->texture_memory != VK_NULL_HANDLE) {
-        vkFreeMemory(device, textured->texture_memory, NULL);
-        textured->texture_memory = VK_NULL_HANDLE;
+    if (async && graph->async_compute_value) {
+        cj_engine_wait_timeline(graph->engine, graph->async_timeline, graph->async_compute_value);
     }
 
-    if (textured->texture_image != VK_NULL_HANDLE) {
-        vkDestroyImage(device, textured->texture_image, NULL);
-        textured->texture_image = VK_NULL_HANDLE;
+    for (uint32_t l = 0; l <= CJ_RGRAPH_BLUR_MAX_LEVELS; l++) {
+        cj_rgraph_blur_level_t* level = &chain->levels[l];
+        retire_blur_image(graph, &level->down);
+        retire_blur_image(graph, &level->work[0]);
+        retire_blur_image(graph, &level->work[1]);
+        retire_blur_image(graph, &level->async_work);
+        for (uint32_t i = 0; i < 2; i++) {
+            retire_blur_image(graph, &level->async_stage[i]);
+            retire_blur_image(graph, &level->async_out[i]);
+        }
     }
+    if (chain->desc_set != VK_NULL_HANDLE || chain->compute_pool != VK_NULL_HANDLE) {
+        cj_engine_garbage_t sets = {0};
+        sets.set_pool = chain->desc_pool;
+        sets.set = chain->desc_set;
+        sets.pool = chain->compute_pool;
+        cj_engine_retire(graph->engine, &sets);
+    }
+    memset(chain, 0, sizeof(*chain));
+}
 
-    if (textured->vertex_buffer_memory != VK_NULL_HANDLE) {
-        vkFreeMemory(device, textured->vertex_buffer_memory, NULL);
-        textured->vertex_buffer_memory = VK_NULL_HANDLE;
+/* Destroy a level's async images; only for images no frame has used */
+static void release_blur_async(cj_rgraph_t* graph, cj_rgraph_blur_level_t* level) {
+    for (uint32_t i = 0; i < 2; i++) {
+        destroy_blur_image(graph, &level->async_stage[i]);
+        destroy_blur_image(graph, &level->async_out[i]);
+        level->async_queued[i] = 0;
     }
+    destroy_blur_image(graph, &level->async_work);
+}
+
+/* The graphics queue family runs compute work as well */
+static bool graphics_queue_computes(cj_rgraph_t* graph) {
+    VkPhysicalDevice physical = cj_engine_physical_device(graph->engine);
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical, &family_count, NULL);
+    uint32_t family = cj_engine_graphics_family(graph->engine);
+    if (family >= family_count) return false;
+    VkQueueFamilyProperties* families = (VkQueueFamilyProperties*)malloc(sizeof(*families) * family_count);
+    if (!families) return false;
+    vkGetPhysicalDeviceQueueFamilyProperties(physical, &family_count, families);
+    bool compute = (families[family].queueFlags & VK_QUEUE_COMPUTE_BIT) != 0;
+    free(families);
+    return compute;
+}
+
+/* The compute path writes RGBA8 storage images on the graphics queue */
+static bool blur_compute_supported(cj_rgraph_t* graph) {
+    VkFormatProperties format_props;
+    vkGetPhysicalDeviceFormatProperties(cj_engine_physical_device(graph->engine), VK_FORMAT_R8G8B8A8_UNORM, &format_props);
+    if (!(format_props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT)) return false;
+    return graphics_queue_computes(graph);
+}
 
-    if (textured->vertex_buffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(device, textured->vertex_buffer, NULL);
-        textured->vertex_buffer = VK_NULL_HANDLE;
+/* Create the compute pipeline and its set layout; leaves the compute path off on failure */
+static void create_blur_compute(cj_rgraph_t* graph, cj_rgraph_blur_node_t* blur) {
+    if (!blur_compute_supported(graph)) return;
+    VkDevice device = cj_engine_device(graph->engine);
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+
+    VkDescriptorSetLayoutBinding bindings[2] = {{0}};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo sli = {0};
+    sli.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    sli.bindingCount = 2;
+    sli.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &sli, NULL, &blur->compute_set_layout) != VK_SUCCESS) {
+        blur->compute_set_layout = VK_NULL_HANDLE;
+        fprintf(stderr, "create_blur_node: failed to create the compute set layout\n");
+        return;
     }
 
-    if (textured->pipeline_layout != VK_NULL_HANDLE) {
-        vkDestroyPipelineLayout(device, textured->pipeline_layout, NULL);
-        textured->pipeline_layout = VK_NULL_HANDLE;
+    VkPushConstantRange push_range = {0};
+    push_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_range.size = sizeof(int32_t) * 4; // ivec2 direction + float sigma + int radius
+    VkPipelineLayoutCreateInfo pli = {0};
+    pli.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pli.setLayoutCount = 1;
+    pli.pSetLayouts = &blur->compute_set_layout;
+    pli.pushConstantRangeCount = 1;
+    pli.pPushConstantRanges = &push_range;
+    blur->compute_layout = cj_pipeline_cache_layout(pipelines, &pli);
+    if (blur->compute_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_blur_node: failed to create the compute pipeline layout\n");
+        return;
     }
 
-    if (textured->desc_pool != VK_NULL_HANDLE) {
-        vkDestroyDescriptorPool(device, textured->desc_pool, NULL);
-        textured->desc_pool = VK_NULL_HANDLE;
+    VkComputePipelineCreateInfo cp = {0};
+    cp.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    cp.layout = blur->compute_layout;
+    cj_pipeline_shader_t shader = { VK_SHADER_STAGE_COMPUTE_BIT, blur_comp_spv, blur_comp_spv_len, "main", "blur.comp" };
+    blur->pipeline_compute = cj_pipeline_cache_compute(pipelines, &cp, &shader);
+    if (blur->pipeline_compute == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_blur_node: failed to create the compute pipeline\n");
     }
+}
 
-    if (textured->desc_layout != VK_NULL_HANDLE) {
-        vkDestroyDescriptorSetLayout(device, textured->desc_layout, NULL);
-        textured->desc_layout = VK_NULL_HANDLE;
+/* Allocate every level's compute sets from a pool of the chain's own; false leaves it on fragment passes */
+static bool create_blur_compute_sets(cj_rgraph_t* graph, cj_rgraph_blur_node_t* blur, cj_rgraph_blur_chain_t* chain) {
+    VkDevice device = cj_engine_device(graph->engine);
+    // Two passes per level, each reading one image and writing another, and the same
+    // for both slots of the async path
+    const uint32_t set_count = 6u * (CJ_RGRAPH_BLUR_MAX_LEVELS + 1u);
+    VkDescriptorPoolSize sizes[2] = {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_count },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, set_count },
+    };
+    VkDescriptorPoolCreateInfo pi = {0};
+    pi.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pi.maxSets = set_count;
+    pi.poolSizeCount = 2;
+    pi.pPoolSizes = sizes;
+    if (vkCreateDescriptorPool(device, &pi, NULL, &chain->compute_pool) != VK_SUCCESS) {
+        chain->compute_pool = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to create the compute descriptor pool\n");
+        return false;
+    }
+    VkDescriptorSetLayout layouts[6u * (CJ_RGRAPH_BLUR_MAX_LEVELS + 1u)];
+    VkDescriptorSet sets[6u * (CJ_RGRAPH_BLUR_MAX_LEVELS + 1u)];
+    for (uint32_t i = 0; i < set_count; i++) layouts[i] = blur->compute_set_layout;
+    VkDescriptorSetAllocateInfo ai = {0};
+    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    ai.descriptorPool = chain->compute_pool;
+    ai.descriptorSetCount = set_count;
+    ai.pSetLayouts = layouts;
+    if (vkAllocateDescriptorSets(device, &ai, sets) != VK_SUCCESS) {
+        fprintf(stderr, "cj_rgraph: failed to allocate compute descriptor sets\n");
+        vkDestroyDescriptorPool(device, chain->compute_pool, NULL);
+        chain->compute_pool = VK_NULL_HANDLE;
+        return false;
+    }
+    for (uint32_t l = 0; l <= CJ_RGRAPH_BLUR_MAX_LEVELS; l++) {
+        cj_rgraph_blur_level_t* level = &chain->levels[l];
+        level->compute_sets[0] = sets[6u * l];
+        level->compute_sets[1] = sets[6u * l + 1u];
+        for (uint32_t i = 0; i < 2; i++) {
+            level->async_sets[i][0] = sets[6u * l + 2u + 2u * i];
+            level->async_sets[i][1] = sets[6u * l + 3u + 2u * i];
+        }
     }
 
-    // Note: textured->pipeline is owned by the engine, not the node
+    return true;
 }
 
-/* Execute a textured node */
-static int execute_textured_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_TEXTURED || !cmd) return 0;
+/* Create blur node resources */
+static int create_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_BLUR) return 0;
 
-    cj_rgraph_textured_node_t* textured = &node->data.textured;
+    cj_rgraph_blur_node_t* blur = &node->data.blur;
+    VkRenderPass render_pass = cj_engine_render_pass(graph->engine);
+    blur->desc.radius = 0.0f;
+    blur->desc.downsample = CJ_RGRAPH_BLUR_DOWNSAMPLE_AUTO;
+    blur->desc.use_compute = false;
 
+    // The fish texture is the fallback input when the graph wires none
+    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
+    if (!tx || tx->imageView == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_blur_node: fish texture not available\n");
+        return 0;
+    }
 
-    // Set viewport and scissor
-    VkViewport viewport = {0};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)extent.width;
-    viewport.height = (float)extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    // Clamp to edge so the kernel does not wrap around the borders
+    cj_sampler_desc_t sampler_desc = {0};
+    sampler_desc.min_filter = CJ_FILTER_LINEAR;
+    sampler_desc.mag_filter = CJ_FILTER_LINEAR;
+    sampler_desc.address_u = CJ_ADDRESS_CLAMP;
+    sampler_desc.address_v = CJ_ADDRESS_CLAMP;
+    sampler_desc.address_w = CJ_ADDRESS_CLAMP;
+    blur->sampler_handle = cj_engine_acquire_sampler(graph->engine, &sampler_desc, &blur->sampler);
+    if (blur->sampler_handle == 0) {
+        fprintf(stderr, "create_blur_node: failed to create sampler\n");
+        return 0;
+    }
 
-    VkRect2D scissor = {0};
-    scissor.offset = (VkOffset2D){0, 0};
-    scissor.extent = extent;
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    // Create pipeline layout with push constants using the shared node set layout
+    VkDescriptorSetLayout set_layout = cj_engine_node_set_layout(graph->engine);
+    VkPushConstantRange push_range = {0};
+    push_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push_range.offset = 0;
+    push_range.size = sizeof(float) * 4; // vec2 direction + float sigma + float radius
 
-    // Bind the textured pipeline
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, textured->pipeline);
+    VkPipelineLayoutCreateInfo pli = {0};
+    pli.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pli.setLayoutCount = 1;
+    pli.pSetLayouts = &set_layout;
+    pli.pushConstantRangeCount = 1;
+    pli.pPushConstantRanges = &push_range;
 
-    // Bind the fish texture descriptor set from legacy textured resources
-    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
-    if (tx && tx->descriptorSet != VK_NULL_HANDLE) {
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, textured->pipeline_layout, 0, 1, &tx->descriptorSet, 0, NULL);
-    } else {
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, textured->pipeline_layout, 0, 1, &textured->desc_set, 0, NULL);
+    // Blur nodes share one pipeline layout and their pipelines
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    blur->pipeline_layout = cj_pipeline_cache_layout(pipelines, &pli);
+    if (blur->pipeline_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_blur_node: failed to create pipeline layout\n");
+        destroy_blur_node(graph, node);
+        return 0;
     }
 
-    // Bind vertex buffer
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmd, 0, 1, &textured->vertex_buffer, offsets);
+    // One pipeline serves both directions of the separable pass; the downsample
+    // pipeline only swaps the fragment shader. The full-screen triangle is generated
+    // from gl_VertexIndex, so there is no vertex input.
+    cj_pipeline_shader_t shaders[2] = {
+        { VK_SHADER_STAGE_VERTEX_BIT, fullscreen_vert_spv, fullscreen_vert_spv_len, "main", "fullscreen.vert" },
+        { VK_SHADER_STAGE_FRAGMENT_BIT, blur_frag_spv, blur_frag_spv_len, "main", "blur.frag" },
+    };
 
-    // Draw textured quad (6 vertices for two triangles)
-    vkCmdDraw(cmd, 6, 1, 0, 0);
+    VkPipelineVertexInputStateCreateInfo vi = {0};
+    vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-    return 1; // Success - textured rendering completed
-}
+    VkPipelineInputAssemblyStateCreateInfo ia = {0};
+    ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkViewport vp = {0}; vp.x=0; vp.y=0; vp.width=1.0f; vp.height=1.0f; vp.minDepth=0; vp.maxDepth=1;
+    VkRect2D sc = {0}; sc.extent.width = 1; sc.extent.height = 1;
+    VkPipelineViewportStateCreateInfo vps = {0};
+    vps.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    vps.viewportCount = 1; vps.pViewports = &vp; vps.scissorCount = 1; vps.pScissors = &sc;
+
+    VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamic_state = {0};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    VkPipelineRasterizationStateCreateInfo rs = {0};
+    rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rs.polygonMode = VK_POLYGON_MODE_FILL;
+    rs.lineWidth = 1.0f;
+    rs.cullMode = VK_CULL_MODE_NONE; // No culling for the full-screen triangle
+
+    VkPipelineMultisampleStateCreateInfo ms = {0};
+    ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState cba = {0};
+    cba.colorWriteMask = VK_COLOR_COMPONENT_R_BIT|VK_COLOR_COMPONENT_G_BIT|VK_COLOR_COMPONENT_B_BIT|VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo cb = {0};
+    cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    cb.attachmentCount = 1;
+    cb.pAttachments = &cba;
+
+    // The transient render pass the chain images use is compatible with the engine pass
+    VkGraphicsPipelineCreateInfo gp = {0};
+    gp.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    gp.pVertexInputState = &vi; gp.pInputAssemblyState = &ia; gp.pViewportState = &vps; gp.pRasterizationState = &rs; gp.pMultisampleState = &ms; gp.pColorBlendState = &cb; gp.pDynamicState = &dynamic_state;
+    gp.layout = blur->pipeline_layout; gp.renderPass = render_pass; gp.subpass = 0;
+
+    blur->pipeline = cj_pipeline_cache_graphics(pipelines, &gp, shaders, 2);
+    shaders[1].code = blur_down_frag_spv;
+    shaders[1].size = blur_down_frag_spv_len;
+    shaders[1].name = "blur_down.frag";
+    blur->pipeline_down = cj_pipeline_cache_graphics(pipelines, &gp, shaders, 2);
+    if (blur->pipeline == VK_NULL_HANDLE || blur->pipeline_down == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_blur_node: failed to create graphics pipeline\n");
+        destroy_blur_node(graph, node);
+        return 0;
+    }
+
+    // The compute path is optional; nodes fall back to fragment passes without it
+    create_blur_compute(graph, blur);
+    return 1;
+}
+
+/* Destroy blur node resources */
+static void destroy_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_BLUR) return;
+
+    cj_rgraph_blur_node_t* blur = &node->data.blur;
+    VkDevice device = cj_engine_device(graph->engine);
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+
+    for (uint32_t i = 0; i < CJ_RGRAPH_EXTENTS; i++) release_blur_chain(graph, &blur->chains[i]);
+    cj_pipeline_cache_release(pipelines, blur->pipeline_compute);
+    cj_pipeline_cache_release(pipelines, blur->pipeline_down);
+    cj_pipeline_cache_release(pipelines, blur->pipeline);
+    cj_pipeline_cache_release_layout(pipelines, blur->compute_layout);
+    cj_pipeline_cache_release_layout(pipelines, blur->pipeline_layout);
+    if (blur->compute_set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, blur->compute_set_layout, NULL);
+    if (blur->sampler_handle != 0) cj_engine_res_release(graph->engine, CJ_RES_SMP, blur->sampler_handle);
+    memset(blur, 0, sizeof(*blur));
+}
+
+/* Decide the downsample level and kernel of the next frame drawn with chain */
+static void plan_blur(cj_rgraph_t* graph, cj_rgraph_node_t* node, cj_rgraph_blur_chain_t* chain) {
+    cj_rgraph_blur_node_t* blur = &node->data.blur;
+
+    // An explicit radius wins, then the "blur_intensity" parameter, then the demo animation
+    float radius = blur->desc.radius;
+    if (!(radius > 0.0f)) {
+        // Searched again only after new parameters were declared
+        if (!blur->intensity_param && blur->intensity_lookup != graph->param_count) {
+            blur->intensity_param = find_param(graph, blur_intensity_name);
+            blur->intensity_lookup = graph->param_count;
+        }
+        const cj_rgraph_param_t* param = blur->intensity_param ? &graph->params[blur->intensity_param - 1u] : NULL;
+        if (param && param->type == CJ_RGRAPH_PARAM_I32) {
+            radius = (float)param->value.i32 * 0.001f * CJ_RGRAPH_BLUR_INTENSITY_RADIUS;
+        } else if (param && param->type == CJ_RGRAPH_PARAM_F32) {
+            radius = param->value.f32 * CJ_RGRAPH_BLUR_INTENSITY_RADIUS;
+        } else {
+            // Cycle every 2 seconds between no blur and 0.3 of the intensity radius
+            blur->time += 0.016f; // 60 FPS timing
+            radius = (sinf(blur->time * 3.14159f) + 1.0f) * 0.5f * 0.3f * CJ_RGRAPH_BLUR_INTENSITY_RADIUS;
+        }
+    }
+    if (!(radius > 0.0f)) radius = 0.0f;
+
+    // Each halving quarters the texels the kernel runs over and halves its reach
+    uint32_t level = 0;
+    if (blur->desc.downsample == CJ_RGRAPH_BLUR_DOWNSAMPLE_AUTO) {
+        while (level < CJ_RGRAPH_BLUR_MAX_LEVELS && radius / (float)(1u << level) > CJ_RGRAPH_BLUR_AUTO_TAPS) level++;
+    } else {
+        level = (uint32_t)blur->desc.downsample;
+    }
+    float reach = radius / (float)(1u << level);
+    if (reach > (float)CJ_RGRAPH_BLUR_MAX_TAPS) reach = (float)CJ_RGRAPH_BLUR_MAX_TAPS;
+
+    chain->level = level;
+    chain->taps = (int32_t)ceilf(reach);
+    chain->sigma = reach / 3.0f;
+    chain->use_compute = blur->desc.use_compute && blur->pipeline_compute != VK_NULL_HANDLE;
+    chain->use_async = chain->use_compute && blur->desc.async_compute && !graph->async_failed &&
+                      cj_engine_async_compute(graph->engine);
+}
+
+/* View the node blurs: its first declared read once built, else the fish texture */
+static VkImageView blur_source_view(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    const cj_rgraph_transient_t* images = graph->extents[graph->active].images;
+    if (node->read_count > 0 && images[node->reads[0]].view != VK_NULL_HANDLE) {
+        return images[node->reads[0]].view;
+    }
+    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
+    return tx ? tx->imageView : VK_NULL_HANDLE;
+}
+
+/* Plan the next frame of the active extent's chain and create the images it needs. Images,
+ * once a frame may use them, and the sets written with them stay as they are until the
+ * chain is released; a new target extent or input moves to a new chain. */
+static int prepare_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkExtent2D extent) {
+    cj_rgraph_blur_node_t* blur = &node->data.blur;
+    cj_rgraph_blur_chain_t* chain = &blur->chains[graph->active];
+    VkDevice device = cj_engine_device(graph->engine);
+
+    VkImageView source = blur_source_view(graph, node);
+    if (source == VK_NULL_HANDLE) return 0;
+    if (chain->extent.width != extent.width || chain->extent.height != extent.height ||
+        chain->source_view != source) {
+        release_blur_chain(graph, chain);
+        chain->extent = extent;
+        for (uint32_t l = 0; l <= CJ_RGRAPH_BLUR_MAX_LEVELS; l++) {
+            chain->levels[l].extent.width = extent.width >> l ? extent.width >> l : 1u;
+            chain->levels[l].extent.height = extent.height >> l ? extent.height >> l : 1u;
+        }
+        // Descriptor set from the engine's shared node pool; it samples the input
+        chain->desc_set = cj_engine_alloc_node_set(graph->engine, &chain->desc_pool);
+        if (chain->desc_set == VK_NULL_HANDLE) {
+            fprintf(stderr, "cj_rgraph: failed to allocate a blur descriptor set\n");
+            return 0;
+        }
+        write_blur_sampler_set(device, chain->desc_set, blur->sampler, source);
+        chain->source_view = source;
+    }
+
+    plan_blur(graph, node, chain);
+    if (chain->use_compute && chain->compute_pool == VK_NULL_HANDLE && !create_blur_compute_sets(graph, blur, chain)) {
+        chain->use_compute = false;
+        chain->use_async = false;
+    }
+
+    for (uint32_t l = 1; l <= chain->level; l++) {
+        cj_rgraph_blur_level_t* level = &chain->levels[l];
+        if (level->down.image == VK_NULL_HANDLE &&
+            !create_blur_image(graph, blur, &level->down, level->extent, false)) return 0;
+    }
+
+    cj_rgraph_blur_level_t* top = &chain->levels[chain->level];
+    if (chain->use_compute && top->work[0].image != VK_NULL_HANDLE && top->work[1].image == VK_NULL_HANDLE) {
+        // Fragment passes drew into work[0]; the compute path needs storage images
+        retire_blur_image(graph, &top->work[0]);
+    }
+    if (top->work[0].image == VK_NULL_HANDLE) {
+        if (!create_blur_image(graph, blur, &top->work[0], top->extent, chain->use_compute) ||
+            (chain->use_compute && !create_blur_image(graph, blur, &top->work[1], top->extent, true))) {
+            destroy_blur_image(graph, &top->work[0]);
+            destroy_blur_image(graph, &top->work[1]);
+            return 0;
+        }
+        top->compute_input = VK_NULL_HANDLE;
+    }
+    if (chain->use_compute) {
+        // Written only together with images no frame has used yet
+        VkImageView input = chain->level == 0 ? source : top->down.view;
+        if (top->compute_input != input) {
+            write_blur_compute_set(device, top->compute_sets[0], blur->sampler, input, top->work[0].view);
+            write_blur_compute_set(device, top->compute_sets[1], blur->sampler, top->work[0].view, top->work[1].view);
+            top->compute_input = input;
+        }
+    }
+    if (chain->use_async && top->async_work.image == VK_NULL_HANDLE) {
+        bool created = create_blur_image(graph, blur, &top->async_work, top->extent, true);
+        for (uint32_t i = 0; created && i < 2; i++) {
+            created = create_blur_image(graph, blur, &top->async_stage[i], top->extent, false) &&
+                      create_blur_image(graph, blur, &top->async_out[i], top->extent, true);
+        }
+        if (!created) {
+            // No frame used them yet; this level blurs on the graphics queue
+            release_blur_async(graph, top);
+            chain->use_async = false;
+        } else {
+            for (uint32_t i = 0; i < 2; i++) {
+                write_blur_compute_set(device, top->async_sets[i][0], blur->sampler,
+                                       top->async_stage[i].view, top->async_work.view);
+                write_blur_compute_set(device, top->async_sets[i][1], blur->sampler,
+                                       top->async_work.view, top->async_out[i].view);
+            }
+        }
+    }
+    return 1;
+}
+
+/* Record a full-screen triangle into a blur chain image */
+static void draw_blur_pass(cj_rgraph_t* graph, VkCommandBuffer cmd, const cj_rgraph_blur_image_t* img,
+                           VkExtent2D extent, VkPipeline pipeline, VkPipelineLayout layout,
+                           VkDescriptorSet input, const float push[4]) {
+    VkRenderPassBeginInfo rp = {0};
+    rp.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    rp.renderPass = graph->transient_render_pass;
+    rp.framebuffer = img->framebuffer;
+    rp.renderArea.extent = extent;
+    VkClearValue clear = {{{0.0f, 0.0f, 0.0f, 0.0f}}};
+    rp.clearValueCount = 1;
+    rp.pClearValues = &clear;
+    vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport = {0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f};
+    VkRect2D scissor = {{0, 0}, extent};
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &input, 0, NULL);
+    if (push) vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(float) * 4, push);
+    vkCmdDraw(cmd, 3, 1, 0, 0);
+    vkCmdEndRenderPass(cmd);
+
+    // The next pass samples what this one wrote
+    VkMemoryBarrier barrier = {0};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+/* Barrier on a blur image, also moving it between queue families unless both are VK_QUEUE_FAMILY_IGNORED */
+static void blur_transfer_barrier(VkCommandBuffer cmd, VkImage image, VkImageLayout old_layout, VkImageLayout new_layout,
+                                  uint32_t src_family, uint32_t dst_family,
+                                  VkAccessFlags src_access, VkAccessFlags dst_access,
+                                  VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage) {
+    VkImageMemoryBarrier b = {0};
+    b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    b.srcAccessMask = src_access;
+    b.dstAccessMask = dst_access;
+    b.oldLayout = old_layout;
+    b.newLayout = new_layout;
+    b.srcQueueFamilyIndex = src_family;
+    b.dstQueueFamilyIndex = dst_family;
+    b.image = image;
+    b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    b.subresourceRange.levelCount = 1;
+    b.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmd, src_stage, dst_stage, 0, 0, NULL, 0, NULL, 1, &b);
+}
+
+/* Move a compute work image between storage writes and sampling */
+static void blur_image_barrier(VkCommandBuffer cmd, VkImage image, VkImageLayout old_layout, VkImageLayout new_layout,
+                               VkAccessFlags src_access, VkAccessFlags dst_access,
+                               VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage) {
+    blur_transfer_barrier(cmd, image, old_layout, new_layout, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED,
+                          src_access, dst_access, src_stage, dst_stage);
+}
+
+/* Horizontal pass from sets[0] into work, then vertical from sets[1]; both images are in GENERAL */
+static void dispatch_blur_compute(const cj_rgraph_blur_node_t* blur, const cj_rgraph_blur_chain_t* chain,
+                                  VkCommandBuffer cmd, VkExtent2D extent, const VkDescriptorSet sets[2], VkImage work) {
+    // One workgroup per TILE texels of a row or column
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, blur->pipeline_compute);
+    struct { int32_t direction[2]; float sigma; int32_t radius; } push = { {1, 0}, chain->sigma, chain->taps };
+    vkCmdPushConstants(cmd, blur->compute_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, blur->compute_layout, 0, 1, &sets[0], 0, NULL);
+    vkCmdDispatch(cmd, (extent.width + CJ_RGRAPH_BLUR_TILE - 1u) / CJ_RGRAPH_BLUR_TILE, extent.height, 1);
+    blur_image_barrier(cmd, work, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                       VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    push.direction[0] = 0;
+    push.direction[1] = 1;
+    vkCmdPushConstants(cmd, blur->compute_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, blur->compute_layout, 0, 1, &sets[1], 0, NULL);
+    vkCmdDispatch(cmd, (extent.height + CJ_RGRAPH_BLUR_TILE - 1u) / CJ_RGRAPH_BLUR_TILE, extent.width, 1);
+}
+
+/* Hand the blur level's input to the compute queue for the next frame, and take over the
+ * result it queued the frame before when that reached the queue. False without async compute. */
+static bool record_blur_async(cj_rgraph_t* graph, cj_rgraph_blur_node_t* blur, cj_rgraph_blur_chain_t* chain,
+                              VkCommandBuffer cmd, VkDescriptorSet input) {
+    VkCommandBuffer compute = async_commands(graph);
+    if (compute == VK_NULL_HANDLE) return false;
+    cj_rgraph_blur_level_t* top = &chain->levels[chain->level];
+    uint32_t slot = (uint32_t)(graph->async_frame & 1u);
+    uint32_t prev = slot ^ 1u;
+    uint32_t graphics_family = cj_engine_graphics_family(graph->engine);
+    uint32_t compute_family = cj_engine_compute_family(graph->engine);
+    VkImageLayout read_only = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    // The submission of this frame waits for that work at the fragment stage
+    blur->async_current = top->async_queued[prev] != 0 && top->async_queued[prev] + 1u == graph->async_frame &&
+                          graph->async_submitted_frame == top->async_queued[prev];
+    if (blur->async_current) {
+        blur_transfer_barrier(cmd, top->async_out[prev].image, VK_IMAGE_LAYOUT_GENERAL, read_only,
+                              compute_family, graphics_family, 0, VK_ACCESS_SHADER_READ_BIT,
+                              VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+
+    // Frames after this one overwrite the input, so the compute queue blurs a copy
+    float copy[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    draw_blur_pass(graph, cmd, &top->async_stage[slot], top->extent, blur->pipeline, blur->pipeline_layout, input, copy);
+    blur_transfer_barrier(cmd, top->async_stage[slot].image, read_only, read_only, graphics_family, compute_family,
+                          VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, 0,
+                          VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+
+    // Compute queue: acquire the copy, blur it, release the result to graphics
+    blur_transfer_barrier(compute, top->async_stage[slot].image, read_only, read_only, graphics_family, compute_family,
+                          0, VK_ACCESS_SHADER_READ_BIT,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    blur_image_barrier(compute, top->async_work.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                       0, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    blur_image_barrier(compute, top->async_out[slot].image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                       0, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    dispatch_blur_compute(blur, chain, compute, top->extent, top->async_sets[slot], top->async_work.image);
+    blur_transfer_barrier(compute, top->async_out[slot].image, VK_IMAGE_LAYOUT_GENERAL, read_only,
+                          compute_family, graphics_family, VK_ACCESS_SHADER_WRITE_BIT, 0,
+                          VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+    top->async_queued[slot] = graph->async_frame;
+    return true;
+}
+
+/* Record the passes before a blur node's last one: downsampling and the horizontal pass
+ * (both passes on the compute path). Must be outside any render pass. */
+static cj_result_t record_blur_prepass(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    cj_rgraph_blur_node_t* blur = &node->data.blur;
+    cj_rgraph_blur_chain_t* chain = &blur->chains[graph->active];
+    if (chain->desc_set == VK_NULL_HANDLE || chain->extent.width != extent.width ||
+        chain->extent.height != extent.height || chain->levels[chain->level].work[0].image == VK_NULL_HANDLE) {
+        fprintf(stderr, "cj_rgraph_execute: blur node %s was not prepared for %ux%u\n",
+                node->name, extent.width, extent.height);
+        return CJ_E_NOT_READY;
+    }
+
+    // The previous frame's reads of the chain must finish before it is overwritten, and
+    // the input's attachment writes must be visible to compute as well as fragment reads
+    VkPipelineStageFlags shader_stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    VkMemoryBarrier barrier = {0};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | shader_stages,
+                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | shader_stages,
+                         0, 1, &barrier, 0, NULL, 0, NULL);
+
+    // Dual-Kawase chain down to the blur level
+    VkDescriptorSet input = chain->desc_set;
+    for (uint32_t l = 1; l <= chain->level; l++) {
+        cj_rgraph_blur_level_t* level = &chain->levels[l];
+        draw_blur_pass(graph, cmd, &level->down, level->extent, blur->pipeline_down, blur->pipeline_layout, input, NULL);
+        input = level->down.set;
+    }
+
+    // Async results come a frame late; until one is there the graphics queue blurs as well
+    cj_rgraph_blur_level_t* top = &chain->levels[chain->level];
+    blur->async_current = false;
+    if (chain->use_async && record_blur_async(graph, blur, chain, cmd, input) && blur->async_current) {
+        blur->recorded = true;
+        return CJ_SUCCESS;
+    }
+    if (!chain->use_compute) {
+        float push[4] = { 1.0f, 0.0f, chain->sigma, (float)chain->taps };
+        draw_blur_pass(graph, cmd, &top->work[0], top->extent, blur->pipeline, blur->pipeline_layout, input, push);
+        blur->recorded = true;
+        return CJ_SUCCESS;
+    }
+
+    // Horizontal then vertical pass
+    for (uint32_t i = 0; i < 2; i++) {
+        blur_image_barrier(cmd, top->work[i].image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                           0, VK_ACCESS_SHADER_WRITE_BIT, shader_stages, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    }
+    dispatch_blur_compute(blur, chain, cmd, top->extent, top->compute_sets, top->work[0].image);
+    blur_image_barrier(cmd, top->work[1].image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                       VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    blur->recorded = true;
+    return CJ_SUCCESS;
+}
+
+/* Execute a blur node: the vertical pass (a copy after compute) into the open render pass */
+static int execute_blur_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_BLUR || !cmd) return 0;
+
+    cj_rgraph_blur_node_t* blur = &node->data.blur;
+    if (!blur->recorded) {
+        fprintf(stderr, "cj_rgraph_execute: blur node %s has no pre-pass for this frame\n", node->name);
+        return 0;
+    }
+    blur->recorded = false;
+
+    // Set viewport and scissor
+    VkViewport viewport = {0};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+    set_node_scissor(graph, cmd, extent);
+
+    // Sample the blur level's result; bilinear filtering upsamples it to the target
+    const cj_rgraph_blur_chain_t* chain = &blur->chains[graph->active];
+    const cj_rgraph_blur_level_t* top = &chain->levels[chain->level];
+    VkDescriptorSet input = chain->use_compute ? top->work[1].set : top->work[0].set;
+    if (blur->async_current) input = top->async_out[(graph->async_frame & 1u) ^ 1u].set;
+    float push_constants[4] = {
+        0.0f, 1.0f,                                // direction (vertical)
+        chain->use_compute ? 0.0f : chain->sigma,  // sigma 0 copies the compute result
+        (float)chain->taps                         // kernel reach in level texels
+    };
+    VkPipeline pipeline = node_pipeline(graph, blur->pipeline);
+    if (pipeline == VK_NULL_HANDLE) return 1;  // No variant for this surface format
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdPushConstants(cmd, blur->pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_constants), push_constants);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, blur->pipeline_layout, 0, 1, &input, 0, NULL);
+
+    // Draw blur effect: one triangle covering the viewport
+    vkCmdDraw(cmd, 3, 1, 0, 0);
+
+    return 1; // Success - blur pass recorded
+}
+
+/* Create the pipeline that samples the engine texture table by slot */
+static int create_textured_table_pipeline(cj_rgraph_t* graph, cj_rgraph_textured_node_t* textured) {
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    VkDescriptorSetLayout set_layout = cj_engine_texture_table_layout(graph->engine);
+
+    VkPushConstantRange push_range = {0};
+    push_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push_range.offset = 0;
+    push_range.size = sizeof(uint32_t); // uint textureSlot
+
+    VkPipelineLayoutCreateInfo pli = {0};
+    pli.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pli.setLayoutCount = 1;
+    pli.pSetLayouts = &set_layout;
+    pli.pushConstantRangeCount = 1;
+    pli.pPushConstantRanges = &push_range;
+
+    textured->table_layout = cj_pipeline_cache_layout(pipelines, &pli);
+    if (textured->table_layout == VK_NULL_HANDLE) return 0;
+
+    cj_pipeline_shader_t shaders[2] = {
+        { VK_SHADER_STAGE_VERTEX_BIT, textured_vert_spv, textured_vert_spv_len, "main", "textured.vert" },
+        { VK_SHADER_STAGE_FRAGMENT_BIT, textured_table_frag_spv, textured_table_frag_spv_len, "main", "textured_table.frag" },
+    };
+
+    // Matches CJ_ENGINE_QUAD_TEXTURED: vec2 pos + vec2 uv
+    VkVertexInputBindingDescription binding = {0};
+    binding.binding = 0;
+    binding.stride = sizeof(float) * 4;
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription attrs[2] = {0};
+    attrs[0].binding = 0; attrs[0].location = 0; attrs[0].format = VK_FORMAT_R32G32_SFLOAT; attrs[0].offset = 0;
+    attrs[1].binding = 0; attrs[1].location = 1; attrs[1].format = VK_FORMAT_R32G32_SFLOAT; attrs[1].offset = sizeof(float) * 2;
+
+    VkPipelineVertexInputStateCreateInfo vi = {0};
+    vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vi.vertexBindingDescriptionCount = 1; vi.pVertexBindingDescriptions = &binding;
+    vi.vertexAttributeDescriptionCount = 2; vi.pVertexAttributeDescriptions = attrs;
+
+    VkPipelineInputAssemblyStateCreateInfo ia = {0};
+    ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo vps = {0};
+    vps.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    vps.viewportCount = 1; vps.scissorCount = 1;
+
+    VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamic_state = {0};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    VkPipelineRasterizationStateCreateInfo rs = {0};
+    rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rs.polygonMode = VK_POLYGON_MODE_FILL;
+    rs.lineWidth = 1.0f;
+    rs.cullMode = VK_CULL_MODE_NONE;
+
+    VkPipelineMultisampleStateCreateInfo ms = {0};
+    ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState cba = {0};
+    cba.colorWriteMask = VK_COLOR_COMPONENT_R_BIT|VK_COLOR_COMPONENT_G_BIT|VK_COLOR_COMPONENT_B_BIT|VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo cb = {0};
+    cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    cb.attachmentCount = 1;
+    cb.pAttachments = &cba;
+
+    VkGraphicsPipelineCreateInfo gp = {0};
+    gp.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    gp.pVertexInputState = &vi; gp.pInputAssemblyState = &ia; gp.pViewportState = &vps; gp.pRasterizationState = &rs; gp.pMultisampleState = &ms; gp.pColorBlendState = &cb; gp.pDynamicState = &dynamic_state;
+    gp.layout = textured->table_layout; gp.renderPass = cj_engine_render_pass(graph->engine); gp.subpass = 0;
+
+    textured->table_pipeline = cj_pipeline_cache_graphics(pipelines, &gp, shaders, 2);
+    if (textured->table_pipeline == VK_NULL_HANDLE) {
+        cj_pipeline_cache_release_layout(pipelines, textured->table_layout);
+        textured->table_layout = VK_NULL_HANDLE;
+        return 0;
+    }
+    return 1;
+}
+
+/* Create textured node resources */
+static int create_textured_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_TEXTURED) return 0;
+
+    cj_rgraph_textured_node_t* textured = &node->data.textured;
+
+    // Get textured pipeline from engine's textured resources
+    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
+    if (!tx || tx->pipeline == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_textured_node: failed to get engine textured pipeline\n");
+        return 0;
+    }
+
+    // Descriptor set from the engine's shared node pool
+    textured->desc_set = cj_engine_alloc_node_set(graph->engine, &textured->desc_pool);
+    if (textured->desc_set == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_textured_node: failed to allocate descriptor set\n");
+        return 0;
+    }
+
+    // Create pipeline layout (shared by every textured node)
+    VkDescriptorSetLayout set_layout = cj_engine_node_set_layout(graph->engine);
+    VkPipelineLayoutCreateInfo pli = {0};
+    pli.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pli.setLayoutCount = 1;
+    pli.pSetLayouts = &set_layout;
+
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    textured->pipeline_layout = cj_pipeline_cache_layout(pipelines, &pli);
+    if (textured->pipeline_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_textured_node: failed to create pipeline layout\n");
+        cj_engine_free_node_set(graph->engine, textured->desc_pool, textured->desc_set);
+        return 0;
+    }
+
+    // The engine's textured quad (same size as color rectangle) - 6 vertices for two triangles
+    textured->vertex_buffer = cj_engine_shared_quad(graph->engine, CJ_ENGINE_QUAD_TEXTURED, &textured->vertex_offset);
+    if (textured->vertex_buffer == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_textured_node: failed to get vertex buffer\n");
+        cj_pipeline_cache_release_layout(pipelines, textured->pipeline_layout);
+        cj_engine_free_node_set(graph->engine, textured->desc_pool, textured->desc_set);
+        return 0;
+    }
+
+    textured->pipeline = tx->pipeline;
+
+    // With a texture table, bound textures are drawn by slot instead of through a set per texture
+    if (cj_engine_texture_table(graph->engine) != VK_NULL_HANDLE &&
+        !create_textured_table_pipeline(graph, textured)) {
+        fprintf(stderr, "create_textured_node: failed to create texture table pipeline\n");
+    }
+
+    return 1;
+}
+
+/* Destroy textured node resources */
+static void destroy_textured_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_TEXTURED) return;
+
+    VkDevice device = cj_engine_device(graph->engine);
+    cj_rgraph_textured_node_t* textured = &node->data.textured;
+
+    if (textured->texture_view != VK_NULL_HANDLE) {
+        vkDestroyImageView(device, textured->texture_view, NULL);
+        textured->texture_view = VK_NULL_HANDLE;
+    }
+
+    if (textured->texture_image != VK_NULL_HANDLE) {
+        vkDestroyImage(device, textured->texture_image, NULL);
+        textured->texture_image = VK_NULL_HANDLE;
+    }
+    cj_gpu_free(cj_engine_gpu_allocator(graph->engine), &textured->texture_alloc);
+
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    cj_pipeline_cache_release(pipelines, textured->table_pipeline);
+    cj_pipeline_cache_release_layout(pipelines, textured->table_layout);
+    textured->table_pipeline = VK_NULL_HANDLE;
+    textured->table_layout = VK_NULL_HANDLE;
+    cj_pipeline_cache_release_layout(pipelines, textured->pipeline_layout);
+    textured->pipeline_layout = VK_NULL_HANDLE;
+
+    cj_engine_free_node_set(graph->engine, textured->desc_pool, textured->desc_set);
+    textured->desc_pool = VK_NULL_HANDLE;
+    textured->desc_set = VK_NULL_HANDLE;
+
+    // Note: textured->pipeline and textured->vertex_buffer are owned by the engine, not the node
+}
+
+/* Execute a textured node */
+static int execute_textured_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_TEXTURED || !cmd) return 0;
+
+    cj_rgraph_textured_node_t* textured = &node->data.textured;
+
+
+    // Set viewport and scissor
+    VkViewport viewport = {0};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+    set_node_scissor(graph, cmd, extent);
+
+    // A texture bound under the node's name is sampled from the engine texture table by slot:
+    // one set for every texture, so there is nothing per texture to allocate or bind
+    VkDescriptorSet table = cj_engine_texture_table(graph->engine);
+    cj_rgraph_binding_t* binding = find_binding(graph, node->name);
+    uint32_t slot = binding ? cj_texture_descriptor_slot(graph->engine, binding->texture) : 0;
+    VkPipeline table_pipeline = node_pipeline(graph, textured->table_pipeline);
+    VkDescriptorSet input_set = node->input_sets[graph->active];
+    if (input_set == VK_NULL_HANDLE && slot != 0 && table_pipeline != VK_NULL_HANDLE && table != VK_NULL_HANDLE) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, table_pipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, textured->table_layout, 0, 1, &table, 0, NULL);
+        vkCmdPushConstants(cmd, textured->table_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(slot), &slot);
+        vkCmdBindVertexBuffers(cmd, 0, 1, &textured->vertex_buffer, &textured->vertex_offset);
+        vkCmdDraw(cmd, 6, 1, 0, 0);
+        return 1;
+    }
+
+    // Bind the textured pipeline
+    VkPipeline pipeline = node_pipeline(graph, textured->pipeline);
+    if (pipeline == VK_NULL_HANDLE) return 1;  // No variant for this surface format
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+    // Bind the transient input if the graph wired one, otherwise the fish texture
+    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
+    if (input_set != VK_NULL_HANDLE) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, textured->pipeline_layout, 0, 1, &input_set, 0, NULL);
+    } else if (tx && tx->descriptorSet != VK_NULL_HANDLE) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, textured->pipeline_layout, 0, 1, &tx->descriptorSet, 0, NULL);
+    } else {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, textured->pipeline_layout, 0, 1, &textured->desc_set, 0, NULL);
+    }
+
+    // Bind the shared quad
+    vkCmdBindVertexBuffers(cmd, 0, 1, &textured->vertex_buffer, &textured->vertex_offset);
+
+    // Draw textured quad (6 vertices for two triangles)
+    vkCmdDraw(cmd, 6, 1, 0, 0);
+
+    return 1; // Success - textured rendering completed
+}
+
+/* Create color node resources */
+static int create_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_COLOR) return 0;
+
+    cj_rgraph_color_node_t* color = &node->data.color;
+
+    // Get engine's color pipeline resources
+    CJellyBindlessResources* engine_cp = cj_engine_color_pipeline(graph->engine);
+    if (!engine_cp) {
+        fprintf(stderr, "create_color_node: failed to get engine color pipeline\n");
+        return 0;
+    }
+
+    // The engine's color quad: Position (x, y) + Color (r, g, b) + TextureID (uint32),
+    // 6 vertices (two triangles) to match the engine's color pipeline
+    color->vertex_buffer = cj_engine_shared_quad(graph->engine, CJ_ENGINE_QUAD_COLOR, &color->vertex_offset);
+    if (color->vertex_buffer == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_color_node: failed to get vertex buffer\n");
+        return 0;
+    }
+
+    // Create pipeline layout with push constants support
+    VkPushConstantRange push_constant_range = {0};
+    push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push_constant_range.offset = 0;
+    push_constant_range.size = sizeof(float) * 8; // 2 vec4s = 8 floats
+
+    VkPipelineLayoutCreateInfo layout_info = {0};
+    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layout_info.setLayoutCount = 0;
+    layout_info.pSetLayouts = NULL;
+    layout_info.pushConstantRangeCount = 1;
+    layout_info.pPushConstantRanges = &push_constant_range;
+
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    color->pipeline_layout = cj_pipeline_cache_layout(pipelines, &layout_info);
+    if (color->pipeline_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_color_node: failed to create pipeline layout\n");
+        return 0;
+    }
+
+    // Get color pipeline from engine's color pipeline resources
+    if (engine_cp->pipeline == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_color_node: engine color pipeline is NULL\n");
+        cj_pipeline_cache_release_layout(pipelines, color->pipeline_layout);
+        return 0;
+    }
+    color->pipeline = engine_cp->pipeline;
+
+    printf("Color node created successfully\n");
+    return 1;
+}
+
+/* Destroy color node resources */
+static void destroy_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_COLOR) return;
+
+    cj_rgraph_color_node_t* color = &node->data.color;
+
+    cj_pipeline_cache_release_layout(cj_engine_pipelines(graph->engine), color->pipeline_layout);
+    color->pipeline_layout = VK_NULL_HANDLE;
+
+    // Note: color->pipeline and color->vertex_buffer are owned by the engine, not the node
+}
+
+/* Execute a color node */
+static int execute_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_COLOR || !cmd) return 0;
+
+    cj_rgraph_color_node_t* color = &node->data.color;
+
+
+    // Set viewport and scissor
+    VkViewport viewport = {0};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+    set_node_scissor(graph, cmd, extent);
+
+    // Bind the color pipeline
+    if (color->pipeline == VK_NULL_HANDLE) {
+        return 0;
+    }
+    VkPipeline pipeline = node_pipeline(graph, color->pipeline);
+    if (pipeline == VK_NULL_HANDLE) return 1;  // No variant for this surface format
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+
+    // Bind the shared quad
+    if (color->vertex_buffer == VK_NULL_HANDLE) {
+        return 0;
+    }
+    vkCmdBindVertexBuffers(cmd, 0, 1, &color->vertex_buffer, &color->vertex_offset);
+
+    // Get colorMul from the engine's color pipeline resources (updated by cj_bindless_set_color)
+    float red_intensity = 1.0f;
+    float green_intensity = 0.0f;
+
+    CJellyBindlessResources* color_resources = cj_engine_color_pipeline(graph->engine);
+    if (color_resources) {
+        red_intensity = color_resources->colorMul[0];
+        green_intensity = color_resources->colorMul[1];
+    }
+
+    // Push constants for color
+    struct {
+        float uv[4];        // vec4 uv
+        float colorMul[4];  // vec4 colorMul
+    } push_constants;
+
+    push_constants.uv[0] = 0.0f; push_constants.uv[1] = 0.0f; push_constants.uv[2] = 1.0f; push_constants.uv[3] = 1.0f;
+    push_constants.colorMul[0] = red_intensity; push_constants.colorMul[1] = green_intensity; push_constants.colorMul[2] = 0.0f; push_constants.colorMul[3] = 1.0f;
+
+    // Push constants to shader
+    vkCmdPushConstants(cmd, color->pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_constants), &push_constants);
+
+    // Draw color quad (our vertex buffer has 6 vertices - two triangles)
+    vkCmdDraw(cmd, 6, 1, 0, 0);
+    return 1; // Success - color rendering completed
+}
+
+/* Create sprite node resources */
+static int create_sprite_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_SPRITE) return 0;
+
+    cj_rgraph_sprite_node_t* sprite = &node->data.sprite;
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    // Set 0 is the texture table, set 1 the graph's per-frame uniforms
+    VkDescriptorSetLayout set_layouts[2] = {
+        cj_engine_texture_table_layout(graph->engine),
+        cj_engine_uniform_set_layout(graph->engine),
+    };
+    if (set_layouts[1] == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_sprite_node: failed to create the uniform set layout\n");
+        return 0;
+    }
+
+    VkPushConstantRange push_range = {0};
+    push_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    push_range.offset = 0;
+    push_range.size = sizeof(float) * 2; // vec2 invExtent
+
+    VkPipelineLayoutCreateInfo pli = {0};
+    pli.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pli.setLayoutCount = 2;
+    pli.pSetLayouts = set_layouts;
+    pli.pushConstantRangeCount = 1;
+    pli.pPushConstantRanges = &push_range;
+
+    sprite->pipeline_layout = cj_pipeline_cache_layout(pipelines, &pli);
+    if (sprite->pipeline_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_sprite_node: failed to create pipeline layout\n");
+        return 0;
+    }
+
+    cj_pipeline_shader_t shaders[2] = {
+        { VK_SHADER_STAGE_VERTEX_BIT, sprite_vert_spv, sprite_vert_spv_len, "main", "sprite.vert" },
+        { VK_SHADER_STAGE_FRAGMENT_BIT, sprite_frag_spv, sprite_frag_spv_len, "main", "sprite.frag" },
+    };
+
+    // Per-instance data only: the vertex shader builds each quad from gl_VertexIndex
+    VkVertexInputBindingDescription binding = {0};
+    binding.binding = 0;
+    binding.stride = sizeof(cj_rgraph_sprite_t);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VkVertexInputAttributeDescription attrs[4] = {0};
+    attrs[0].binding = 0; attrs[0].location = 0; attrs[0].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[0].offset = offsetof(cj_rgraph_sprite_t, rect);
+    attrs[1].binding = 0; attrs[1].location = 1; attrs[1].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[1].offset = offsetof(cj_rgraph_sprite_t, uv_rect);
+    attrs[2].binding = 0; attrs[2].location = 2; attrs[2].format = VK_FORMAT_R32G32B32A32_SFLOAT; attrs[2].offset = offsetof(cj_rgraph_sprite_t, color);
+    attrs[3].binding = 0; attrs[3].location = 3; attrs[3].format = VK_FORMAT_R32_UINT; attrs[3].offset = offsetof(cj_rgraph_sprite_t, texture_slot);
+
+    VkPipelineVertexInputStateCreateInfo vi = {0};
+    vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vi.vertexBindingDescriptionCount = 1; vi.pVertexBindingDescriptions = &binding;
+    vi.vertexAttributeDescriptionCount = 4; vi.pVertexAttributeDescriptions = attrs;
+
+    VkPipelineInputAssemblyStateCreateInfo ia = {0};
+    ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo vps = {0};
+    vps.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    vps.viewportCount = 1; vps.scissorCount = 1;
+
+    VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamic_state = {0};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    VkPipelineRasterizationStateCreateInfo rs = {0};
+    rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rs.polygonMode = VK_POLYGON_MODE_FILL;
+    rs.lineWidth = 1.0f;
+    rs.cullMode = VK_CULL_MODE_NONE;
+
+    VkPipelineMultisampleStateCreateInfo ms = {0};
+    ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // Standard alpha blending so later sprites draw over earlier ones
+    VkPipelineColorBlendAttachmentState cba = {0};
+    cba.blendEnable = VK_TRUE;
+    cba.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    cba.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    cba.colorBlendOp = VK_BLEND_OP_ADD;
+    cba.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    cba.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    cba.alphaBlendOp = VK_BLEND_OP_ADD;
+    cba.colorWriteMask = VK_COLOR_COMPONENT_R_BIT|VK_COLOR_COMPONENT_G_BIT|VK_COLOR_COMPONENT_B_BIT|VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo cb = {0};
+    cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    cb.attachmentCount = 1;
+    cb.pAttachments = &cba;
+
+    VkGraphicsPipelineCreateInfo gp = {0};
+    gp.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    gp.pVertexInputState = &vi; gp.pInputAssemblyState = &ia; gp.pViewportState = &vps; gp.pRasterizationState = &rs; gp.pMultisampleState = &ms; gp.pColorBlendState = &cb; gp.pDynamicState = &dynamic_state;
+    gp.layout = sprite->pipeline_layout; gp.renderPass = cj_engine_render_pass(graph->engine); gp.subpass = 0;
+
+    sprite->pipeline = cj_pipeline_cache_graphics(pipelines, &gp, shaders, 2);
+    if (sprite->pipeline == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_sprite_node: failed to create graphics pipeline\n");
+        cj_pipeline_cache_release_layout(pipelines, sprite->pipeline_layout);
+        return 0;
+    }
+    return 1;
+}
+
+/* Destroy sprite node resources */
+static void destroy_sprite_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_SPRITE) return;
+
+    cj_rgraph_sprite_node_t* sprite = &node->data.sprite;
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    cj_gpu_allocator_t* gpu = cj_engine_gpu_allocator(graph->engine);
+
+    for (uint32_t i = 0; i < CJ_RGRAPH_RING_FRAMES; i++) {
+        cj_gpu_destroy_buffer(gpu, &sprite->frames[i].buffer, &sprite->frames[i].alloc);
+    }
+    cj_pipeline_cache_release(pipelines, sprite->pipeline);
+    cj_pipeline_cache_release_layout(pipelines, sprite->pipeline_layout);
+}
+
+/* Execute a sprite node */
+static int execute_sprite_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_SPRITE || !cmd) return 0;
+
+    cj_rgraph_sprite_node_t* sprite = &node->data.sprite;
+    cj_rgraph_sprite_frame_t* frame = &sprite->frames[sprite->frame];
+    sprite->pending = false;
+    if (frame->count == 0) return 1; // Nothing to draw this frame
+    frame->readers |= 1u << graph->reader;
+
+    VkDescriptorSet table = cj_engine_texture_table(graph->engine);
+    if (sprite->pipeline == VK_NULL_HANDLE || table == VK_NULL_HANDLE || extent.width == 0 || extent.height == 0) {
+        return 0;
+    }
+
+    // This frame's transform and tint, read through the parameter IDs
+    uint32_t uniform_offset = 0;
+    VkDescriptorSet uniform_set = VK_NULL_HANDLE;
+    cj_rgraph_sprite_uniforms_t* uniforms =
+        (cj_rgraph_sprite_uniforms_t*)alloc_uniforms(graph, sizeof(*uniforms), &uniform_set, &uniform_offset);
+    if (!uniforms) return 0;
+    if (sprite->transform_param) {
+        memcpy(uniforms->transform, graph->params[sprite->transform_param - 1u].value.mat4, sizeof(uniforms->transform));
+    } else {
+        memset(uniforms->transform, 0, sizeof(uniforms->transform));
+        for (uint32_t i = 0; i < 4; i++) uniforms->transform[i * 5u] = 1.0f;
+    }
+    if (sprite->tint_param) {
+        memcpy(uniforms->tint, graph->params[sprite->tint_param - 1u].value.vec4, sizeof(uniforms->tint));
+    } else {
+        for (uint32_t i = 0; i < 4; i++) uniforms->tint[i] = 1.0f;
+    }
+
+    VkViewport viewport = {0};
+    viewport.width = (float)extent.width;
+    viewport.height = (float)extent.height;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+    set_node_scissor(graph, cmd, extent);
+
+    VkPipeline pipeline = node_pipeline(graph, sprite->pipeline);
+    if (pipeline == VK_NULL_HANDLE) return 1;  // No variant for this surface format
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    VkDescriptorSet sets[2] = { table, uniform_set };
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, sprite->pipeline_layout, 0, 2, sets, 1, &uniform_offset);
+    float inv_extent[2] = { 1.0f / (float)extent.width, 1.0f / (float)extent.height };
+    vkCmdPushConstants(cmd, sprite->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(inv_extent), inv_extent);
+
+    // Every sprite in one draw: six generated vertices per instance
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(cmd, 0, 1, &frame->buffer, &offset);
+    vkCmdDraw(cmd, 6, frame->count, 0, 0);
+    return 1;
+}
+
+/* Create the color and depth pass mesh nodes draw their objects in */
+static int ensure_mesh_render_pass(cj_rgraph_t* graph) {
+    if (graph->mesh_render_pass != VK_NULL_HANDLE) return 1;
+
+    // D32 where it can be an attachment, else D16, which every device supports
+    VkFormatProperties depth_props;
+    vkGetPhysicalDeviceFormatProperties(cj_engine_physical_device(graph->engine), VK_FORMAT_D32_SFLOAT, &depth_props);
+    graph->mesh_depth_format = (depth_props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+                                   ? VK_FORMAT_D32_SFLOAT : VK_FORMAT_D16_UNORM;
+
+    VkAttachmentDescription attachments[2] = {{0}};
+    attachments[0].format = cj_engine_color_format(graph->engine);
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    attachments[1] = attachments[0];
+    attachments[1].format = graph->mesh_depth_format;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE; /* Depth only lives through the pass */
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    VkAttachmentReference color_ref = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference depth_ref = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription sub = {0};
+    sub.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    sub.colorAttachmentCount = 1;
+    sub.pColorAttachments = &color_ref;
+    sub.pDepthStencilAttachment = &depth_ref;
+    /* Chains to the barrier of begin_offscreen_writes */
+    VkSubpassDependency dep = {0};
+    dep.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dep.dstSubpass = 0;
+    dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    VkRenderPassCreateInfo rp = {0};
+    rp.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    rp.attachmentCount = 2;
+    rp.pAttachments = attachments;
+    rp.subpassCount = 1;
+    rp.pSubpasses = &sub;
+    rp.dependencyCount = 1;
+    rp.pDependencies = &dep;
+    if (vkCreateRenderPass(cj_engine_device(graph->engine), &rp, NULL, &graph->mesh_render_pass) != VK_SUCCESS) {
+        graph->mesh_render_pass = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to create the mesh render pass\n");
+        return 0;
+    }
+    return 1;
+}
+
+/* Create mesh node resources; everything but the ring buffers and images, which follow use */
+static int create_mesh_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_MESH) return 0;
+
+    cj_rgraph_mesh_node_t* mesh = &node->data.mesh;
+    VkDevice device = cj_engine_device(graph->engine);
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    if (!ensure_mesh_render_pass(graph)) return 0;
+
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(cj_engine_physical_device(graph->engine), &props);
+    mesh->max_draws = props.limits.maxDrawIndirectCount;
+
+    // The composite maps the color image one to one; clamp so edges do not wrap
+    cj_sampler_desc_t sampler_desc = {0};
+    sampler_desc.min_filter = CJ_FILTER_LINEAR;
+    sampler_desc.mag_filter = CJ_FILTER_LINEAR;
+    sampler_desc.address_u = CJ_ADDRESS_CLAMP;
+    sampler_desc.address_v = CJ_ADDRESS_CLAMP;
+    sampler_desc.address_w = CJ_ADDRESS_CLAMP;
+    mesh->sampler_handle = cj_engine_acquire_sampler(graph->engine, &sampler_desc, &mesh->sampler);
+    if (mesh->sampler_handle == 0) {
+        fprintf(stderr, "create_mesh_node: failed to create sampler\n");
+        return 0;
+    }
+
+    // One set per ring entry: the objects culling and the vertex shader read, the draws culling writes
+    VkDescriptorSetLayoutBinding bindings[2] = {{0}};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = 1;
+    bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    VkDescriptorSetLayoutCreateInfo sli = {0};
+    sli.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    sli.bindingCount = 2;
+    sli.pBindings = bindings;
+    if (vkCreateDescriptorSetLayout(device, &sli, NULL, &mesh->set_layout) != VK_SUCCESS) {
+        mesh->set_layout = VK_NULL_HANDLE;
+        fprintf(stderr, "create_mesh_node: failed to create the object set layout\n");
+        destroy_mesh_node(graph, node);
+        return 0;
+    }
+
+    VkDescriptorPoolSize pool_size = { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2u * CJ_RGRAPH_RING_FRAMES };
+    VkDescriptorPoolCreateInfo pi = {0};
+    pi.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pi.maxSets = CJ_RGRAPH_RING_FRAMES;
+    pi.poolSizeCount = 1;
+    pi.pPoolSizes = &pool_size;
+    if (vkCreateDescriptorPool(device, &pi, NULL, &mesh->set_pool) != VK_SUCCESS) {
+        mesh->set_pool = VK_NULL_HANDLE;
+        fprintf(stderr, "create_mesh_node: failed to create the object descriptor pool\n");
+        destroy_mesh_node(graph, node);
+        return 0;
+    }
+    VkDescriptorSetLayout layouts[CJ_RGRAPH_RING_FRAMES];
+    VkDescriptorSet sets[CJ_RGRAPH_RING_FRAMES];
+    for (uint32_t i = 0; i < CJ_RGRAPH_RING_FRAMES; i++) layouts[i] = mesh->set_layout;
+    VkDescriptorSetAllocateInfo ai = {0};
+    ai.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    ai.descriptorPool = mesh->set_pool;
+    ai.descriptorSetCount = CJ_RGRAPH_RING_FRAMES;
+    ai.pSetLayouts = layouts;
+    if (vkAllocateDescriptorSets(device, &ai, sets) != VK_SUCCESS) {
+        fprintf(stderr, "create_mesh_node: failed to allocate object descriptor sets\n");
+        destroy_mesh_node(graph, node);
+        return 0;
+    }
+    for (uint32_t i = 0; i < CJ_RGRAPH_RING_FRAMES; i++) mesh->frames[i].set = sets[i];
+
+    // Culling: the object set plus MeshCullParams
+    VkPushConstantRange push_range = {0};
+    push_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_range.size = sizeof(cj_rgraph_mesh_cull_params_t);
+    VkPipelineLayoutCreateInfo pli = {0};
+    pli.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pli.setLayoutCount = 1;
+    pli.pSetLayouts = &mesh->set_layout;
+    pli.pushConstantRangeCount = 1;
+    pli.pPushConstantRanges = &push_range;
+    mesh->cull_layout = cj_pipeline_cache_layout(pipelines, &pli);
+
+    VkComputePipelineCreateInfo cp = {0};
+    cp.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    cp.layout = mesh->cull_layout;
+    cj_pipeline_shader_t cull_shader = { VK_SHADER_STAGE_COMPUTE_BIT, mesh_cull_comp_spv, mesh_cull_comp_spv_len, "main", "mesh_cull.comp" };
+    if (mesh->cull_layout != VK_NULL_HANDLE) mesh->cull_pipeline = cj_pipeline_cache_compute(pipelines, &cp, &cull_shader);
+    if (mesh->cull_pipeline == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_mesh_node: failed to create the culling pipeline\n");
+        destroy_mesh_node(graph, node);
+        return 0;
+    }
+
+    // Drawing: the same set plus view_proj for the vertex stage
+    push_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    push_range.size = sizeof(float) * 16; // mat4 viewProj
+    mesh->pipeline_layout = cj_pipeline_cache_layout(pipelines, &pli);
+    if (mesh->pipeline_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_mesh_node: failed to create pipeline layout\n");
+        destroy_mesh_node(graph, node);
+        return 0;
+    }
+
+    cj_pipeline_shader_t shaders[2] = {
+        { VK_SHADER_STAGE_VERTEX_BIT, mesh_vert_spv, mesh_vert_spv_len, "main", "mesh.vert" },
+        { VK_SHADER_STAGE_FRAGMENT_BIT, mesh_frag_spv, mesh_frag_spv_len, "main", "mesh.frag" },
+    };
+
+    // Positions and normals of cj_mesh_t vertices; objects come from the set by instance
+    VkVertexInputBindingDescription binding = {0};
+    binding.binding = 0;
+    binding.stride = sizeof(CJellyFormat3dMeshVertex);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription attrs[2] = {0};
+    attrs[0].binding = 0; attrs[0].location = 0; attrs[0].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[0].offset = offsetof(CJellyFormat3dMeshVertex, position);
+    attrs[1].binding = 0; attrs[1].location = 1; attrs[1].format = VK_FORMAT_R32G32B32_SFLOAT; attrs[1].offset = offsetof(CJellyFormat3dMeshVertex, normal);
+
+    VkPipelineVertexInputStateCreateInfo vi = {0};
+    vi.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vi.vertexBindingDescriptionCount = 1; vi.pVertexBindingDescriptions = &binding;
+    vi.vertexAttributeDescriptionCount = 2; vi.pVertexAttributeDescriptions = attrs;
+
+    VkPipelineInputAssemblyStateCreateInfo ia = {0};
+    ia.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    ia.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo vps = {0};
+    vps.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    vps.viewportCount = 1; vps.scissorCount = 1;
+
+    VkDynamicState dynamic_states[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamic_state = {0};
+    dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamic_state.dynamicStateCount = 2;
+    dynamic_state.pDynamicStates = dynamic_states;
+
+    // Winding differs between models and projections; the depth test resolves overlaps
+    VkPipelineRasterizationStateCreateInfo rs = {0};
+    rs.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rs.polygonMode = VK_POLYGON_MODE_FILL;
+    rs.lineWidth = 1.0f;
+    rs.cullMode = VK_CULL_MODE_NONE;
+
+    VkPipelineMultisampleStateCreateInfo ms = {0};
+    ms.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
-/* Create color node resources */
-static int create_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_COLOR) return 0;
+    VkPipelineDepthStencilStateCreateInfo ds = {0};
+    ds.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    ds.depthTestEnable = VK_TRUE;
+    ds.depthWriteEnable = VK_TRUE;
+    ds.depthCompareOp = VK_COMPARE_OP_LESS;
 
-    VkDevice device = cj_engine_device(graph->engine);
+    VkPipelineColorBlendAttachmentState cba = {0};
+    cba.colorWriteMask = VK_COLOR_COMPONENT_R_BIT|VK_COLOR_COMPONENT_G_BIT|VK_COLOR_COMPONENT_B_BIT|VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo cb = {0};
+    cb.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    cb.attachmentCount = 1;
+    cb.pAttachments = &cba;
 
-    cj_rgraph_color_node_t* color = &node->data.color;
+    VkGraphicsPipelineCreateInfo gp = {0};
+    gp.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    gp.pVertexInputState = &vi; gp.pInputAssemblyState = &ia; gp.pViewportState = &vps; gp.pRasterizationState = &rs; gp.pMultisampleState = &ms; gp.pDepthStencilState = &ds; gp.pColorBlendState = &cb; gp.pDynamicState = &dynamic_state;
+    gp.layout = mesh->pipeline_layout; gp.renderPass = graph->mesh_render_pass; gp.subpass = 0;
 
-    // Get engine's color pipeline resources
-    CJellyBindlessResources* engine_cp = cj_engine_color_pipeline(graph->engine);
-    if (!engine_cp) {
-        fprintf(stderr, "create_color_node: failed to get engine color pipeline\n");
+    mesh->pipeline = cj_pipeline_cache_graphics(pipelines, &gp, shaders, 2);
+    if (mesh->pipeline == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_mesh_node: failed to create graphics pipeline\n");
+        destroy_mesh_node(graph, node);
         return 0;
     }
 
-    // Create our own vertex buffer with animated colors
-    // Format: Position (x, y) + Color (r, g, b) + TextureID (uint32) - matches engine's format
-    // Engine expects 6 vertices (two triangles) to form a quad
-    typedef struct { float pos[2]; float color[3]; uint32_t textureID; } ColorVertex;
-    ColorVertex vertices[] = {
-        {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, 0},  // bottom-left (red) - triangle 1
-        {{ 0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}, 0},  // bottom-right (green) - triangle 1
-        {{ 0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}, 0},  // top-right (blue) - triangle 1
-        {{ 0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}, 0},  // top-right (blue) - triangle 2
-        {{-0.5f,  0.5f}, {1.0f, 1.0f, 0.0f}, 0},  // top-left (yellow) - triangle 2
-        {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}, 0}   // bottom-left (red) - triangle 2
-    };
-
-    VkBufferCreateInfo buffer_info = {0};
-    buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    buffer_info.size = sizeof(vertices);
-    buffer_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateBuffer(device, &buffer_info, NULL, &color->vertex_buffer) != VK_SUCCESS) {
-        fprintf(stderr, "create_color_node: failed to create vertex buffer\n");
+    // Compositing: a full-screen triangle sampling the color image through a node set,
+    // blended over the target; mesh.frag wrote premultiplied colors
+    VkDescriptorSetLayout node_layout = cj_engine_node_set_layout(graph->engine);
+    pli.pSetLayouts = &node_layout;
+    pli.pushConstantRangeCount = 0;
+    pli.pPushConstantRanges = NULL;
+    mesh->composite_layout = cj_pipeline_cache_layout(pipelines, &pli);
+    if (mesh->composite_layout == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_mesh_node: failed to create the composite pipeline layout\n");
+        destroy_mesh_node(graph, node);
         return 0;
     }
 
-    // Allocate memory for vertex buffer
-    VkMemoryRequirements mem_requirements;
-    vkGetBufferMemoryRequirements(device, color->vertex_buffer, &mem_requirements);
-
-    VkPhysicalDevice physical_device = cj_engine_physical_device(graph->engine);
-    VkPhysicalDeviceMemoryProperties mem_properties;
-    vkGetPhysicalDeviceMemoryProperties(physical_device, &mem_properties);
-
-    uint32_t memory_type_index = UINT32_MAX;
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if ((mem_requirements.memoryTypeBits & (1 << i)) &&
-            (mem_properties.memoryTypes[i].propertyFlags & (VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))) {
-            memory_type_index = i;
-            break;
-        }
+    shaders[0] = (cj_pipeline_shader_t){ VK_SHADER_STAGE_VERTEX_BIT, fullscreen_vert_spv, fullscreen_vert_spv_len, "main", "fullscreen.vert" };
+    shaders[1] = (cj_pipeline_shader_t){ VK_SHADER_STAGE_FRAGMENT_BIT, textured_simple_frag_spv, textured_simple_frag_spv_len, "main", "textured_simple.frag" };
+    vi.vertexBindingDescriptionCount = 0; vi.pVertexBindingDescriptions = NULL;
+    vi.vertexAttributeDescriptionCount = 0; vi.pVertexAttributeDescriptions = NULL;
+    cba.blendEnable = VK_TRUE;
+    cba.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    cba.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    cba.colorBlendOp = VK_BLEND_OP_ADD;
+    cba.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    cba.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    cba.alphaBlendOp = VK_BLEND_OP_ADD;
+    gp.pDepthStencilState = NULL;
+    gp.layout = mesh->composite_layout; gp.renderPass = cj_engine_render_pass(graph->engine);
+
+    mesh->composite_pipeline = cj_pipeline_cache_graphics(pipelines, &gp, shaders, 2);
+    if (mesh->composite_pipeline == VK_NULL_HANDLE) {
+        fprintf(stderr, "create_mesh_node: failed to create the composite pipeline\n");
+        destroy_mesh_node(graph, node);
+        return 0;
     }
+    return 1;
+}
 
-    if (memory_type_index == UINT32_MAX) {
-        fprintf(stderr, "create_color_node: failed to find suitable memory type\n");
-        vkDestroyBuffer(device, color->vertex_buffer, NULL);
-        return 0;
+/* Recreate a ring entry's buffers for at least count objects and point its set at them */
+static bool grow_mesh_frame(cj_rgraph_t* graph, cj_rgraph_mesh_node_t* mesh, cj_rgraph_mesh_frame_t* frame, uint32_t count) {
+    uint32_t capacity = frame->capacity ? frame->capacity : 256u;
+    while (capacity < count) {
+        if (capacity > UINT32_MAX / 2u) { capacity = count; break; }
+        capacity *= 2u;
+    }
+    if (capacity > mesh->max_draws) capacity = count;
+
+    // No frame in flight reads this entry, so its buffers can go right away
+    cj_gpu_allocator_t* gpu = cj_engine_gpu_allocator(graph->engine);
+    cj_gpu_destroy_buffer(gpu, &frame->objects, &frame->objects_alloc);
+    cj_gpu_destroy_buffer(gpu, &frame->draws, &frame->draws_alloc);
+    frame->capacity = 0;
+    frame->count = 0;
+    if (!cj_gpu_create_buffer(gpu, (VkDeviceSize)capacity * sizeof(cj_rgraph_mesh_object_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              CJ_GPU_ALLOC_LINEAR, &frame->objects, &frame->objects_alloc)) {
+        return false;
+    }
+    if (!cj_gpu_create_buffer(gpu, CJ_RGRAPH_MESH_DRAWS_OFFSET + (VkDeviceSize)capacity * CJ_RGRAPH_MESH_DRAW_STRIDE,
+                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, CJ_GPU_ALLOC_LINEAR, &frame->draws, &frame->draws_alloc)) {
+        cj_gpu_destroy_buffer(gpu, &frame->objects, &frame->objects_alloc);
+        return false;
     }
 
-    VkMemoryAllocateInfo alloc_info = {0};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = memory_type_index;
+    VkDescriptorBufferInfo buffers[2] = {{0}};
+    buffers[0].buffer = frame->objects;
+    buffers[0].range = VK_WHOLE_SIZE;
+    buffers[1].buffer = frame->draws;
+    buffers[1].range = VK_WHOLE_SIZE;
+    VkWriteDescriptorSet writes[2] = {{0}};
+    for (uint32_t i = 0; i < 2; i++) {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = frame->set;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = &buffers[i];
+    }
+    vkUpdateDescriptorSets(cj_engine_device(graph->engine), 2, writes, 0, NULL);
+    frame->capacity = capacity;
+    return true;
+}
 
-    if (vkAllocateMemory(device, &alloc_info, NULL, &color->vertex_buffer_memory) != VK_SUCCESS) {
-        fprintf(stderr, "create_color_node: failed to allocate vertex buffer memory\n");
-        vkDestroyBuffer(device, color->vertex_buffer, NULL);
-        return 0;
+/* Retire a target's images behind the frames that may still use them, and clear it */
+static void release_mesh_target(cj_rgraph_t* graph, cj_rgraph_mesh_target_t* target) {
+    if (target->color_image != VK_NULL_HANDLE || target->color_set != VK_NULL_HANDLE) {
+        cj_engine_garbage_t color = {0};
+        color.framebuffer = target->framebuffer;
+        color.view = target->color_view;
+        color.image = target->color_image;
+        color.alloc = target->color_alloc;
+        color.set_pool = target->color_pool;
+        color.set = target->color_set;
+        cj_engine_retire(graph->engine, &color);
     }
+    if (target->depth_image != VK_NULL_HANDLE) {
+        cj_engine_garbage_t depth = {0};
+        depth.view = target->depth_view;
+        depth.image = target->depth_image;
+        depth.alloc = target->depth_alloc;
+        cj_engine_retire(graph->engine, &depth);
+    }
+    memset(target, 0, sizeof(*target));
+}
 
-    vkBindBufferMemory(device, color->vertex_buffer, color->vertex_buffer_memory, 0);
+/* Create a device-local image and a view of it for the mesh pass; handles stay set for cleanup on failure */
+static bool create_mesh_image(cj_rgraph_t* graph, VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect,
+                              VkExtent2D extent, VkImage* out_image, cj_gpu_alloc_t* out_alloc, VkImageView* out_view) {
+    VkDevice device = cj_engine_device(graph->engine);
 
-    // Copy vertex data to buffer
-    void* data;
-    vkMapMemory(device, color->vertex_buffer_memory, 0, sizeof(vertices), 0, &data);
-    memcpy(data, vertices, sizeof(vertices));
-    vkUnmapMemory(device, color->vertex_buffer_memory);
+    VkImageCreateInfo image_info = {0};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.extent.width = extent.width;
+    image_info.extent.height = extent.height;
+    image_info.extent.depth = 1;
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = 1;
+    image_info.format = format;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_info.usage = usage;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(device, &image_info, NULL, out_image) != VK_SUCCESS) {
+        *out_image = VK_NULL_HANDLE;
+        return false;
+    }
+    if (!cj_gpu_alloc_image(cj_engine_gpu_allocator(graph->engine), *out_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                            CJ_GPU_ALLOC_OPTIMAL, out_alloc)) {
+        return false;
+    }
 
-    // Create pipeline layout with push constants support
-    VkPushConstantRange push_constant_range = {0};
-    push_constant_range.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    push_constant_range.offset = 0;
-    push_constant_range.size = sizeof(float) * 8; // 2 vec4s = 8 floats
+    VkImageViewCreateInfo view_info = {0};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = *out_image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    view_info.format = format;
+    view_info.subresourceRange.aspectMask = aspect;
+    view_info.subresourceRange.levelCount = 1;
+    view_info.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device, &view_info, NULL, out_view) != VK_SUCCESS) {
+        *out_view = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
 
-    VkPipelineLayoutCreateInfo layout_info = {0};
-    layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    layout_info.setLayoutCount = 0;
-    layout_info.pSetLayouts = NULL;
-    layout_info.pushConstantRangeCount = 1;
-    layout_info.pPushConstantRanges = &push_constant_range;
+/* Create the active extent set's color and depth images for a target extent */
+static int prepare_mesh_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkExtent2D extent) {
+    cj_rgraph_mesh_node_t* mesh = &node->data.mesh;
+    cj_rgraph_mesh_target_t* target = &mesh->targets[graph->active];
+    if (target->color_set != VK_NULL_HANDLE &&
+        target->extent.width == extent.width && target->extent.height == extent.height) return 1;
+    release_mesh_target(graph, target);
+    if (extent.width == 0 || extent.height == 0) return 0;
 
-    if (vkCreatePipelineLayout(device, &layout_info, NULL, &color->pipeline_layout) != VK_SUCCESS) {
-        fprintf(stderr, "create_color_node: failed to create pipeline layout\n");
-        vkFreeMemory(device, color->vertex_buffer_memory, NULL);
-        vkDestroyBuffer(device, color->vertex_buffer, NULL);
+    VkDevice device = cj_engine_device(graph->engine);
+    target->extent = extent;
+    if (!create_mesh_image(graph, cj_engine_color_format(graph->engine),
+                           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+                           extent, &target->color_image, &target->color_alloc, &target->color_view) ||
+        !create_mesh_image(graph, graph->mesh_depth_format,
+                           VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT,
+                           extent, &target->depth_image, &target->depth_alloc, &target->depth_view)) {
+        fprintf(stderr, "cj_rgraph: failed to create %ux%u images for mesh node %s\n", extent.width, extent.height, node->name);
+        release_mesh_target(graph, target);
         return 0;
     }
 
-    // Get color pipeline from engine's color pipeline resources
-    if (engine_cp->pipeline == VK_NULL_HANDLE) {
-        fprintf(stderr, "create_color_node: engine color pipeline is NULL\n");
-        vkDestroyPipelineLayout(device, color->pipeline_layout, NULL);
+    VkImageView attachments[2] = { target->color_view, target->depth_view };
+    VkFramebufferCreateInfo fb_info = {0};
+    fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    fb_info.renderPass = graph->mesh_render_pass;
+    fb_info.attachmentCount = 2;
+    fb_info.pAttachments = attachments;
+    fb_info.width = extent.width;
+    fb_info.height = extent.height;
+    fb_info.layers = 1;
+    if (vkCreateFramebuffer(device, &fb_info, NULL, &target->framebuffer) != VK_SUCCESS) {
+        target->framebuffer = VK_NULL_HANDLE;
+        fprintf(stderr, "cj_rgraph: failed to create the framebuffer of mesh node %s\n", node->name);
+        release_mesh_target(graph, target);
         return 0;
     }
-    color->pipeline = engine_cp->pipeline;
 
-    printf("Color node created successfully\n");
+    target->color_set = cj_engine_alloc_node_set(graph->engine, &target->color_pool);
+    if (target->color_set == VK_NULL_HANDLE) {
+        fprintf(stderr, "cj_rgraph: failed to allocate the descriptor set of mesh node %s\n", node->name);
+        release_mesh_target(graph, target);
+        return 0;
+    }
+    write_blur_sampler_set(device, target->color_set, mesh->sampler, target->color_view);
     return 1;
 }
 
-/* Destroy color node resources */
-static void destroy_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_COLOR) return;
+/* Destroy mesh node resources */
+static void destroy_mesh_node(cj_rgraph_t* graph, cj_rgraph_node_t* node) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_MESH) return;
 
+    cj_rgraph_mesh_node_t* mesh = &node->data.mesh;
     VkDevice device = cj_engine_device(graph->engine);
-    cj_rgraph_color_node_t* color = &node->data.color;
+    cj_pipeline_cache_t* pipelines = cj_engine_pipelines(graph->engine);
+    cj_gpu_allocator_t* gpu = cj_engine_gpu_allocator(graph->engine);
 
-    if (color->pipeline_layout != VK_NULL_HANDLE) {
-        vkDestroyPipelineLayout(device, color->pipeline_layout, NULL);
-        color->pipeline_layout = VK_NULL_HANDLE;
+    for (uint32_t i = 0; i < CJ_RGRAPH_EXTENTS; i++) release_mesh_target(graph, &mesh->targets[i]);
+    for (uint32_t i = 0; i < CJ_RGRAPH_RING_FRAMES; i++) {
+        cj_gpu_destroy_buffer(gpu, &mesh->frames[i].objects, &mesh->frames[i].objects_alloc);
+        cj_gpu_destroy_buffer(gpu, &mesh->frames[i].draws, &mesh->frames[i].draws_alloc);
     }
+    cj_pipeline_cache_release(pipelines, mesh->composite_pipeline);
+    cj_pipeline_cache_release(pipelines, mesh->pipeline);
+    cj_pipeline_cache_release(pipelines, mesh->cull_pipeline);
+    cj_pipeline_cache_release_layout(pipelines, mesh->composite_layout);
+    cj_pipeline_cache_release_layout(pipelines, mesh->pipeline_layout);
+    cj_pipeline_cache_release_layout(pipelines, mesh->cull_layout);
+    if (mesh->set_pool != VK_NULL_HANDLE) vkDestroyDescriptorPool(device, mesh->set_pool, NULL);
+    if (mesh->set_layout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device, mesh->set_layout, NULL);
+    if (mesh->sampler_handle != 0) cj_engine_res_release(graph->engine, CJ_RES_SMP, mesh->sampler_handle);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+/* VkBuffer behind a buffer handle; VK_NULL_HANDLE once it was released */
+static VkBuffer mesh_buffer(cj_rgraph_t* graph, cj_handle_t handle) {
+    uint64_t h = ((uint64_t)handle.idx << 32) | (uint64_t)handle.gen;
+    return cj_engine_buffer(graph->engine, cj_engine_res_index(graph->engine, CJ_RES_BUF, h));
+}
 
-    if (color->vertex_buffer_memory != VK_NULL_HANDLE) {
-        vkFreeMemory(device, color->vertex_buffer_memory, NULL);
-        color->vertex_buffer_memory = VK_NULL_HANDLE;
+/* Cull the objects and draw the visible ones into the node's images, ahead of the pass it composites in */
+static cj_result_t record_mesh_prepass(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    cj_rgraph_mesh_node_t* mesh = &node->data.mesh;
+    cj_rgraph_mesh_frame_t* frame = &mesh->frames[mesh->frame];
+    mesh->drawn = false;
+
+    VkBuffer vertex_buffer = mesh->mesh ? mesh_buffer(graph, mesh->mesh->vertex_buffer) : VK_NULL_HANDLE;
+    VkBuffer index_buffer = mesh->mesh ? mesh_buffer(graph, mesh->mesh->index_buffer) : VK_NULL_HANDLE;
+    if (frame->count == 0 || vertex_buffer == VK_NULL_HANDLE || index_buffer == VK_NULL_HANDLE) {
+        mesh->recorded = true;  // Nothing to draw; the target is left as it is
+        return CJ_SUCCESS;
+    }
+    frame->readers |= 1u << graph->reader;
+    const cj_rgraph_mesh_target_t* target = &mesh->targets[graph->active];
+    if (target->color_set == VK_NULL_HANDLE ||
+        target->extent.width != extent.width || target->extent.height != extent.height) {
+        fprintf(stderr, "cj_rgraph_execute: mesh node %s was not prepared for %ux%u\n",
+                node->name, extent.width, extent.height);
+        return CJ_E_NOT_READY;
     }
 
-    if (color->vertex_buffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(device, color->vertex_buffer, NULL);
-        color->vertex_buffer = VK_NULL_HANDLE;
+    // Without the count draw every object keeps its command and culled ones draw no instances
+    PFN_vkCmdDrawIndexedIndirectCountKHR draw_count = cj_engine_draw_indexed_indirect_count(graph->engine);
+    cj_rgraph_mesh_cull_params_t params = {0};
+    if (mesh->view_proj_param) {
+        memcpy(params.view_proj, graph->params[mesh->view_proj_param - 1u].value.mat4, sizeof(params.view_proj));
+    } else {
+        for (uint32_t i = 0; i < 4; i++) params.view_proj[i * 5u] = 1.0f;
+    }
+    params.object_count = frame->count;
+    params.compact = draw_count != NULL;
+
+    // The previous frame's indirect reads, composite and depth writes finish before
+    // the draws and images are written again
+    VkMemoryBarrier barrier = {0};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                         VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                         VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                         0, 1, &barrier, 0, NULL, 0, NULL);
+    if (params.compact) {
+        // Visible objects are counted up from zero
+        vkCmdFillBuffer(cmd, frame->draws, 0, sizeof(uint32_t), 0);
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &barrier, 0, NULL, 0, NULL);
     }
 
-    // Note: color->pipeline is owned by the engine, not the node
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mesh->cull_pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mesh->cull_layout, 0, 1, &frame->set, 0, NULL);
+    vkCmdPushConstants(cmd, mesh->cull_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(params), &params);
+    vkCmdDispatch(cmd, (frame->count + CJ_RGRAPH_MESH_GROUP - 1u) / CJ_RGRAPH_MESH_GROUP, 1, 1);
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         0, 1, &barrier, 0, NULL, 0, NULL);
+
+    VkClearValue clears[2];
+    memset(clears, 0, sizeof(clears));
+    clears[1].depthStencil.depth = 1.0f;
+    VkRenderPassBeginInfo rp = {0};
+    rp.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    rp.renderPass = graph->mesh_render_pass;
+    rp.framebuffer = target->framebuffer;
+    rp.renderArea.extent = extent;
+    rp.clearValueCount = 2;
+    rp.pClearValues = clears;
+    vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport = {0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f};
+    VkRect2D scissor = {{0, 0}, extent};
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh->pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh->pipeline_layout, 0, 1, &frame->set, 0, NULL);
+    vkCmdPushConstants(cmd, mesh->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(params.view_proj), params.view_proj);
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(cmd, 0, 1, &vertex_buffer, &offset);
+    vkCmdBindIndexBuffer(cmd, index_buffer, 0, mesh->mesh->index_size == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+
+    // Every object in one call, however many there are
+    if (draw_count) {
+        draw_count(cmd, frame->draws, CJ_RGRAPH_MESH_DRAWS_OFFSET, frame->draws, 0, frame->count, CJ_RGRAPH_MESH_DRAW_STRIDE);
+    } else {
+        vkCmdDrawIndexedIndirect(cmd, frame->draws, CJ_RGRAPH_MESH_DRAWS_OFFSET, frame->count, CJ_RGRAPH_MESH_DRAW_STRIDE);
+    }
+    vkCmdEndRenderPass(cmd);
+
+    // The composite samples what the pass wrote
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 1, &barrier, 0, NULL, 0, NULL);
+    mesh->drawn = true;
+    mesh->recorded = true;
+    return CJ_SUCCESS;
 }
 
-/* Execute a color node */
-static int execute_color_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
-    if (!graph || !node || node->type != CJ_RGRAPH_NODE_COLOR || !cmd) return 0;
-
-    cj_rgraph_color_node_t* color = &node->data.color;
+/* Execute a mesh node: blend the objects the pre-pass drew over the open render pass */
+static int execute_mesh_node(cj_rgraph_t* graph, cj_rgraph_node_t* node, VkCommandBuffer cmd, VkExtent2D extent) {
+    if (!graph || !node || node->type != CJ_RGRAPH_NODE_MESH || !cmd) return 0;
 
+    cj_rgraph_mesh_node_t* mesh = &node->data.mesh;
+    if (!mesh->recorded) {
+        fprintf(stderr, "cj_rgraph_execute: mesh node %s has no pre-pass for this frame\n", node->name);
+        return 0;
+    }
+    mesh->recorded = false;
+    mesh->pending = false;
+    if (!mesh->drawn) return 1; // Nothing to draw this frame
 
-    // Set viewport and scissor
     VkViewport viewport = {0};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
     viewport.width = (float)extent.width;
     viewport.height = (float)extent.height;
-    viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
     vkCmdSetViewport(cmd, 0, 1, &viewport);
 
-    VkRect2D scissor = {0};
-    scissor.offset = (VkOffset2D){0, 0};
-    scissor.extent = extent;
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
-
-    // Bind the color pipeline
-    if (color->pipeline == VK_NULL_HANDLE) {
-        return 0;
-    }
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, color->pipeline);
-
-    // Bind vertex buffer
-    if (color->vertex_buffer == VK_NULL_HANDLE) {
-        return 0;
-    }
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(cmd, 0, 1, &color->vertex_buffer, offsets);
-
-    // Get colorMul from the engine's color pipeline resources (updated by cj_bindless_set_color)
-    float red_intensity = 1.0f;
-    float green_intensity = 0.0f;
-
-    CJellyBindlessResources* color_resources = cj_engine_color_pipeline(graph->engine);
-    if (color_resources) {
-        red_intensity = color_resources->colorMul[0];
-        green_intensity = color_resources->colorMul[1];
-    }
-
-    // Push constants for color
-    struct {
-        float uv[4];        // vec4 uv
-        float colorMul[4];  // vec4 colorMul
-    } push_constants;
-
-    push_constants.uv[0] = 0.0f; push_constants.uv[1] = 0.0f; push_constants.uv[2] = 1.0f; push_constants.uv[3] = 1.0f;
-    push_constants.colorMul[0] = red_intensity; push_constants.colorMul[1] = green_intensity; push_constants.colorMul[2] = 0.0f; push_constants.colorMul[3] = 1.0f;
+    set_node_scissor(graph, cmd, extent);
 
-    // Push constants to shader
-    vkCmdPushConstants(cmd, color->pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push_constants), &push_constants);
-
-    // Draw color quad (our vertex buffer has 6 vertices - two triangles)
-    vkCmdDraw(cmd, 6, 1, 0, 0);
-    return 1; // Success - color rendering completed
+    VkPipeline pipeline = node_pipeline(graph, mesh->composite_pipeline);
+    if (pipeline == VK_NULL_HANDLE) return 1;  // No variant for this surface format
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, mesh->composite_layout, 0, 1,
+                            &mesh->targets[graph->active].color_set, 0, NULL);
+    vkCmdDraw(cmd, 3, 1, 0, 0);
+    return 1;
 }
 
 /* Helper function to find a binding by name */
@@ -1234,14 +3723,40 @@ static cj_rgraph_binding_t* find_binding(cj_rgraph_t* graph, const char* name) {
     return NULL;
 }
 
-/* Helper function to find a parameter by name */
-static cj_rgraph_param_t* find_param(cj_rgraph_t* graph, const char* name) {
+/* ID of a parameter by name; 0 if it is not declared. Only name-based calls search */
+static cj_rgraph_param_id_t find_param(cj_rgraph_t* graph, cj_str_t name) {
     for (uint32_t i = 0; i < graph->param_count; i++) {
-        if (strcmp(graph->params[i].name, name) == 0) {
-            return &graph->params[i];
+        const char* param_name = graph->params[i].name;
+        if (strlen(param_name) == name.len && memcmp(param_name, name.ptr, name.len) == 0) {
+            return i + 1u;
         }
     }
-    return NULL;
+    return 0;
+}
+
+/* Append a parameter with its type's initial value; the name must fit and be new. 0 when out of memory */
+static cj_rgraph_param_id_t declare_param(cj_rgraph_t* graph, cj_str_t name, cj_rgraph_param_type_t type) {
+    if (graph->param_count == graph->param_capacity) {
+        uint32_t capacity = graph->param_capacity ? graph->param_capacity * 2u : 16u;
+        cj_rgraph_param_t* grown = (cj_rgraph_param_t*)realloc(graph->params, sizeof(cj_rgraph_param_t) * capacity);
+        if (!grown) {
+            fprintf(stderr, "declare_param: failed to grow the parameter array\n");
+            return 0;
+        }
+        graph->params = grown;
+        graph->param_capacity = capacity;
+    }
+
+    cj_rgraph_param_t* param = &graph->params[graph->param_count++];
+    memset(param, 0, sizeof(*param));
+    memcpy(param->name, name.ptr, name.len);
+    param->name[name.len] = '\0';
+    param->type = type;
+    if (type == CJ_RGRAPH_PARAM_MAT4) {
+        for (uint32_t i = 0; i < 4; i++) param->value.mat4[i * 5u] = 1.0f;
+    }
+    graph->content_version++;
+    return graph->param_count;
 }
 
 /* Add a default pass-through node for basic rendering */
@@ -1257,6 +3772,7 @@ static void add_default_node(cj_rgraph_t* graph) {
     node->type = CJ_RGRAPH_NODE_PASSTHROUGH;
     node->next = graph->nodes;
     graph->nodes = node;
+    graph->needs_recompile = true;
 
     // Added default pass-through node
 }
@@ -1275,135 +3791,531 @@ CJ_API cj_result_t cj_rgraph_add_blur_node(cj_rgraph_t* graph, const char* name)
     strncpy(node->name, name, sizeof(node->name) - 1);
     node->name[sizeof(node->name) - 1] = '\0';
     node->type = CJ_RGRAPH_NODE_BLUR;
-    node->next = graph->nodes;
-    graph->nodes = node;
 
-    // Create blur-specific resources
+    // Create blur-specific resources before the node joins the graph
     if (!create_blur_node(graph, node)) {
         free(node);
         return CJ_E_UNKNOWN;
     }
 
-    // Cache parameter pointers for performance
-    cj_rgraph_blur_node_t* blur = &node->data.blur;
-    blur->intensity_param = find_param(graph, "blur_intensity");
-    blur->time_param = find_param(graph, "time_ms");
+    // Cache the parameter ID; it is looked up again while the parameter is undeclared
+    node->data.blur.intensity_param = find_param(graph, blur_intensity_name);
+    node->data.blur.intensity_lookup = graph->param_count;
+
+    node->next = graph->nodes;
+    graph->nodes = node;
+    graph->needs_recompile = true;
+    return CJ_SUCCESS;
+}
+
+/* Change how a blur node filters */
+CJ_API cj_result_t cj_rgraph_set_blur(cj_rgraph_t* graph, const char* node_name, const cj_rgraph_blur_desc_t* desc) {
+    if (!graph || !node_name || !desc) return CJ_E_INVALID_ARGUMENT;
+    if (!(desc->radius >= 0.0f)) return CJ_E_INVALID_ARGUMENT;
+    if (desc->downsample != CJ_RGRAPH_BLUR_DOWNSAMPLE_AUTO &&
+        (desc->downsample < 0 || desc->downsample > (int32_t)CJ_RGRAPH_BLUR_MAX_LEVELS)) {
+        return CJ_E_INVALID_ARGUMENT;
+    }
 
+    cj_rgraph_node_t* node = find_node(graph, node_name);
+    if (!node || node->type != CJ_RGRAPH_NODE_BLUR) return CJ_E_NOT_FOUND;
+    cj_rgraph_blur_node_t* blur = &node->data.blur;
 
+    if (desc->use_compute && blur->pipeline_compute == VK_NULL_HANDLE) {
+        fprintf(stderr, "cj_rgraph_set_blur: compute blur unavailable, %s uses fragment passes\n", node->name);
+    }
+    // Work images differ between the paths, and other levels would only hold memory
+    if (desc->use_compute != blur->desc.use_compute || desc->downsample != blur->desc.downsample) {
+        for (uint32_t i = 0; i < CJ_RGRAPH_EXTENTS; i++) release_blur_chain(graph, &blur->chains[i]);
+    }
+    blur->desc = *desc;
+    graph->content_version++;
     return CJ_SUCCESS;
 }
 
-/* Create intermediate render target for true multi-pass rendering */
-static int create_intermediate_render_target(cj_rgraph_t* graph, cj_rgraph_blur_node_t* blur, VkExtent2D extent) {
-    if (!graph || !blur) return 0;
+/* Helper function to find a node by name */
+static cj_rgraph_node_t* find_node(cj_rgraph_t* graph, const char* name) {
+    for (cj_rgraph_node_t* node = graph->nodes; node; node = node->next) {
+        if (strcmp(node->name, name) == 0) {
+            return node;
+        }
+    }
+    return NULL;
+}
 
-    VkDevice device = cj_engine_device(graph->engine);
-    VkPhysicalDevice physical_device = cj_engine_physical_device(graph->engine);
+/* Helper function to find a resource index by name (-1 if not declared) */
+static int find_resource(cj_rgraph_t* graph, cj_str_t name) {
+    for (uint32_t i = 0; i < graph->resource_count; i++) {
+        const char* res_name = graph->resources[i].name;
+        if (strlen(res_name) == name.len && memcmp(res_name, name.ptr, name.len) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
 
-    // Create intermediate texture
-    VkImageCreateInfo image_info = {0};
-    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    image_info.imageType = VK_IMAGE_TYPE_2D;
-    image_info.extent.width = extent.width;
-    image_info.extent.height = extent.height;
-    image_info.extent.depth = 1;
-    image_info.mipLevels = 1;
-    image_info.arrayLayers = 1;
-    image_info.format = VK_FORMAT_R8G8B8A8_UNORM;
-    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
-    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
-    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+/*
+ * Compile the logical graph.
+ *
+ * 1. Cull: nodes writing the backbuffer are live; a node becomes live when a
+ *    live node reads the resource it writes.
+ * 2. Schedule: topological order over read-after-write edges (plus list order
+ *    between backbuffer writers), ties broken by list order. Transient writers
+ *    are placed first since they run before the window pass.
+ * 3. Lifetimes: first/last schedule position of each transient.
+ * 4. Aliasing: transients are packed greedily into memory slots whose current
+ *    occupant is dead before the transient is first written.
+ * 5. Barriers: one write->read barrier per transient, placed before its first
+ *    reader, or flushed before the window pass if that reader draws there.
+ */
+static cj_result_t compile_graph(cj_rgraph_t* graph) {
+    free(graph->schedule);
+    graph->schedule = NULL;
+    graph->schedule_count = 0;
+    graph->offscreen_count = 0;
+    graph->final_barrier_mask = 0;
+    graph->alias_slot_count = 0;
+    release_extents(graph);
+
+    uint32_t n = 0;
+    for (cj_rgraph_node_t* node = graph->nodes; node; node = node->next) n++;
+    if (n == 0) return CJ_SUCCESS;
+
+    cj_rgraph_node_t** nodes = (cj_rgraph_node_t**)malloc(sizeof(cj_rgraph_node_t*) * n);
+    uint32_t* indegree = (uint32_t*)calloc(n, sizeof(uint32_t));
+    uint8_t* edges = (uint8_t*)calloc((size_t)n * n, sizeof(uint8_t));
+    bool* placed = (bool*)calloc(n, sizeof(bool));
+    graph->schedule = (cj_rgraph_node_t**)malloc(sizeof(cj_rgraph_node_t*) * n);
+    if (!nodes || !indegree || !edges || !placed || !graph->schedule) {
+        fprintf(stderr, "cj_rgraph_recompile: failed to allocate compile state\n");
+        free(nodes); free(indegree); free(edges); free(placed);
+        free(graph->schedule);
+        graph->schedule = NULL;
+        return CJ_E_OUT_OF_MEMORY;
+    }
 
-    if (vkCreateImage(device, &image_info, NULL, &blur->intermediate_texture) != VK_SUCCESS) {
-        fprintf(stderr, "create_intermediate_render_target: failed to create intermediate texture\n");
-        return 0;
+    uint32_t idx = 0;
+    for (cj_rgraph_node_t* node = graph->nodes; node; node = node->next) {
+        nodes[idx++] = node;
+        node->live = (node->write == CJ_RGRAPH_BACKBUFFER_INDEX);
+        node->alias_wait = false;
+        node->barrier_mask = 0;
+    }
+
+    /* Each transient has exactly one producer; a second one would clear the first */
+    for (uint32_t i = 0; i < n; i++) {
+        if (nodes[i]->write == CJ_RGRAPH_BACKBUFFER_INDEX) continue;
+        for (uint32_t j = i + 1; j < n; j++) {
+            if (nodes[j]->write == nodes[i]->write) {
+                fprintf(stderr, "cj_rgraph_recompile: transient %s has more than one writer\n",
+                        graph->resources[nodes[i]->write].name);
+                free(nodes); free(indegree); free(edges); free(placed);
+                return CJ_E_INVALID_ARGUMENT;
+            }
+        }
     }
 
-    // Allocate memory for intermediate texture
-    VkMemoryRequirements mem_requirements;
-    vkGetImageMemoryRequirements(device, blur->intermediate_texture, &mem_requirements);
+    /* 1. Culling */
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t j = 0; j < n; j++) {
+            if (!nodes[j]->live) continue;
+            for (uint32_t r = 0; r < nodes[j]->read_count; r++) {
+                for (uint32_t i = 0; i < n; i++) {
+                    if (!nodes[i]->live && nodes[i]->write == nodes[j]->reads[r]) {
+                        nodes[i]->live = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
 
-    VkPhysicalDeviceMemoryProperties mem_properties;
-    vkGetPhysicalDeviceMemoryProperties(physical_device, &mem_properties);
+    /* 2. Dependency edges between live nodes */
+    cj_result_t result = CJ_SUCCESS;
+    for (uint32_t j = 0; j < n && result == CJ_SUCCESS; j++) {
+        if (!nodes[j]->live) continue;
+        for (uint32_t r = 0; r < nodes[j]->read_count; r++) {
+            bool has_writer = false;
+            for (uint32_t i = 0; i < n; i++) {
+                if (i == j || !nodes[i]->live || nodes[i]->write != nodes[j]->reads[r]) continue;
+                has_writer = true;
+                if (!edges[i * n + j]) { edges[i * n + j] = 1; indegree[j]++; }
+            }
+            if (!has_writer) {
+                fprintf(stderr, "cj_rgraph_recompile: node %s reads %s, which no node writes\n",
+                        nodes[j]->name, graph->resources[nodes[j]->reads[r]].name);
+                result = CJ_E_INVALID_ARGUMENT;
+                break;
+            }
+        }
+        /* Keep backbuffer draws in list order */
+        if (nodes[j]->write == CJ_RGRAPH_BACKBUFFER_INDEX) {
+            for (uint32_t i = 0; i < j; i++) {
+                if (nodes[i]->live && nodes[i]->write == CJ_RGRAPH_BACKBUFFER_INDEX && !edges[i * n + j]) {
+                    edges[i * n + j] = 1;
+                    indegree[j]++;
+                }
+            }
+        }
+    }
 
-    uint32_t memory_type_index = UINT32_MAX;
-    for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
-        if ((mem_requirements.memoryTypeBits & (1 << i)) &&
-            (mem_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
-            memory_type_index = i;
+    /* Kahn's algorithm, lowest list index first; transient writers then backbuffer writers */
+    uint32_t live_count = 0;
+    for (uint32_t i = 0; i < n; i++) if (nodes[i]->live) live_count++;
+    uint32_t order_count = 0;
+    cj_rgraph_node_t** order = graph->schedule;
+    uint32_t* topo = (uint32_t*)malloc(sizeof(uint32_t) * n);
+    if (result == CJ_SUCCESS && !topo) result = CJ_E_OUT_OF_MEMORY;
+    while (result == CJ_SUCCESS && order_count < live_count) {
+        uint32_t pick = n;
+        for (uint32_t i = 0; i < n; i++) {
+            if (nodes[i]->live && !placed[i] && indegree[i] == 0) { pick = i; break; }
+        }
+        if (pick == n) {
+            fprintf(stderr, "cj_rgraph_recompile: dependency cycle between nodes\n");
+            result = CJ_E_INVALID_ARGUMENT;
             break;
         }
+        placed[pick] = true;
+        topo[order_count++] = pick;
+        for (uint32_t j = 0; j < n; j++) {
+            if (edges[pick * n + j]) indegree[j]--;
+        }
     }
 
-    if (memory_type_index == UINT32_MAX) {
-        fprintf(stderr, "create_intermediate_render_target: failed to find suitable memory type\n");
-        vkDestroyImage(device, blur->intermediate_texture, NULL);
-        return 0;
+    if (result == CJ_SUCCESS) {
+        /* 2b. Backbuffer writers never feed other nodes, so moving them after all
+         * transient writers keeps the order topological */
+        uint32_t count = 0;
+        for (uint32_t k = 0; k < order_count; k++) {
+            if (nodes[topo[k]]->write != CJ_RGRAPH_BACKBUFFER_INDEX) order[count++] = nodes[topo[k]];
+        }
+        graph->offscreen_count = count;
+        for (uint32_t k = 0; k < order_count; k++) {
+            if (nodes[topo[k]]->write == CJ_RGRAPH_BACKBUFFER_INDEX) order[count++] = nodes[topo[k]];
+        }
+        graph->schedule_count = count;
+
+        /* 3. Lifetimes */
+        for (uint32_t r = 0; r < graph->resource_count; r++) {
+            graph->resources[r].used = false;
+            graph->resources[r].first_use = 0;
+            graph->resources[r].last_use = 0;
+            graph->resources[r].alias_slot = 0;
+        }
+        for (uint32_t p = 0; p < graph->schedule_count; p++) {
+            cj_rgraph_node_t* node = order[p];
+            cj_rgraph_resource_t* w = &graph->resources[node->write];
+            if (!w->used) { w->used = true; w->first_use = p; }
+            w->last_use = p;
+            for (uint32_t r = 0; r < node->read_count; r++) {
+                cj_rgraph_resource_t* res = &graph->resources[node->reads[r]];
+                if (res->last_use < p) res->last_use = p;
+            }
+        }
+
+        /* 4. Aliasing: transients are first used by their writer, which comes in schedule order */
+        for (uint32_t p = 0; p < graph->offscreen_count; p++) {
+            cj_rgraph_node_t* node = order[p];
+            cj_rgraph_resource_t* res = &graph->resources[node->write];
+            uint32_t slot = graph->alias_slot_count;
+            for (uint32_t k = 0; k < graph->alias_slot_count; k++) {
+                if (graph->alias_slots[k].busy_until < res->first_use) { slot = k; break; }
+            }
+            if (slot == graph->alias_slot_count) {
+                graph->alias_slot_count++;
+            } else {
+                node->alias_wait = true;
+            }
+            graph->alias_slots[slot].busy_until = res->last_use;
+            res->alias_slot = slot;
+        }
+
+        /* 5. Barriers */
+        for (uint32_t r = 1; r < graph->resource_count; r++) {
+            cj_rgraph_resource_t* res = &graph->resources[r];
+            if (!res->used || !res->transient) continue;
+            for (uint32_t p = res->first_use + 1; p < graph->schedule_count; p++) {
+                bool reads = false;
+                for (uint32_t k = 0; k < order[p]->read_count; k++) {
+                    if (order[p]->reads[k] == r) { reads = true; break; }
+                }
+                if (!reads) continue;
+                if (p < graph->offscreen_count) order[p]->barrier_mask |= (1u << r);
+                else graph->final_barrier_mask |= (1u << r);
+                break;
+            }
+        }
     }
 
-    VkMemoryAllocateInfo alloc_info = {0};
-    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    alloc_info.allocationSize = mem_requirements.size;
-    alloc_info.memoryTypeIndex = memory_type_index;
+    free(topo);
+    free(nodes); free(indegree); free(edges); free(placed);
+    if (result != CJ_SUCCESS) {
+        free(graph->schedule);
+        graph->schedule = NULL;
+        graph->schedule_count = 0;
+        graph->offscreen_count = 0;
+    }
+    return result;
+}
 
-    if (vkAllocateMemory(device, &alloc_info, NULL, &blur->intermediate_memory) != VK_SUCCESS) {
-        fprintf(stderr, "create_intermediate_render_target: failed to allocate intermediate texture memory\n");
-        vkDestroyImage(device, blur->intermediate_texture, NULL);
-        return 0;
+/* Retire an extent set's transient images, views, framebuffers, their memory and the
+ * node objects built for it. Frames in flight may still use them, so the engine destroys
+ * them once those finished. */
+static void release_physical(cj_rgraph_t* graph, uint32_t set) {
+    cj_rgraph_extent_set_t* es = &graph->extents[set];
+    for (uint32_t r = 1; r < CJ_RGRAPH_MAX_RESOURCES; r++) {
+        cj_rgraph_transient_t* img = &es->images[r];
+        if (img->image == VK_NULL_HANDLE) continue;
+        cj_engine_garbage_t garbage = {0};
+        garbage.framebuffer = img->framebuffer;
+        garbage.view = img->view;
+        garbage.image = img->image;
+        cj_engine_retire(graph->engine, &garbage);
+        memset(img, 0, sizeof(*img));
+    }
+    for (uint32_t k = 0; k < es->memory_count; k++) {
+        cj_engine_garbage_t garbage = {0};
+        garbage.memory = es->memory[k].memory;
+        if (garbage.memory != VK_NULL_HANDLE) cj_engine_retire(graph->engine, &garbage);
+    }
+    memset(es->memory, 0, sizeof(es->memory));
+    es->memory_count = 0;
+    for (cj_rgraph_node_t* node = graph->nodes; node; node = node->next) {
+        if (node->input_sets[set] != VK_NULL_HANDLE) {
+            cj_engine_garbage_t garbage = {0};
+            garbage.set_pool = node->input_pools[set];
+            garbage.set = node->input_sets[set];
+            cj_engine_retire(graph->engine, &garbage);
+        }
+        node->input_sets[set] = VK_NULL_HANDLE;
+        node->input_pools[set] = VK_NULL_HANDLE;
+        if (node->type == CJ_RGRAPH_NODE_BLUR) release_blur_chain(graph, &node->data.blur.chains[set]);
+        if (node->type == CJ_RGRAPH_NODE_MESH) release_mesh_target(graph, &node->data.mesh.targets[set]);
     }
+    if (es->valid) graph->content_version++;
+    es->valid = false;
+    es->prepared = 0;
+}
 
-    vkBindImageMemory(device, blur->intermediate_texture, blur->intermediate_memory, 0);
+/* Retire every extent set */
+static void release_extents(cj_rgraph_t* graph) {
+    for (uint32_t i = 0; i < CJ_RGRAPH_EXTENTS; i++) release_physical(graph, i);
+}
 
-    // Create image view for intermediate texture
-    VkImageViewCreateInfo view_info = {0};
-    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-    view_info.image = blur->intermediate_texture;
-    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    view_info.format = VK_FORMAT_R8G8B8A8_UNORM;
-    view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    view_info.subresourceRange.baseMipLevel = 0;
-    view_info.subresourceRange.levelCount = 1;
-    view_info.subresourceRange.baseArrayLayer = 0;
-    view_info.subresourceRange.layerCount = 1;
+/* Index of the extent set built for extent; CJ_RGRAPH_EXTENTS when there is none */
+static uint32_t find_extent_set(const cj_rgraph_t* graph, VkExtent2D extent) {
+    for (uint32_t i = 0; i < CJ_RGRAPH_EXTENTS; i++) {
+        const cj_rgraph_extent_set_t* es = &graph->extents[i];
+        if (es->valid && es->extent.width == extent.width && es->extent.height == extent.height) return i;
+    }
+    return CJ_RGRAPH_EXTENTS;
+}
 
-    if (vkCreateImageView(device, &view_info, NULL, &blur->intermediate_view) != VK_SUCCESS) {
-        fprintf(stderr, "create_intermediate_render_target: failed to create intermediate texture view\n");
-        vkFreeMemory(device, blur->intermediate_memory, NULL);
-        vkDestroyImage(device, blur->intermediate_texture, NULL);
+/* Create the render pass transients are drawn with (compatible with the engine pass) */
+static int ensure_transient_render_pass(cj_rgraph_t* graph) {
+    if (graph->transient_render_pass != VK_NULL_HANDLE) return 1;
+
+    VkAttachmentDescription color = {0};
+    color.format = cj_engine_color_format(graph->engine);
+    color.samples = VK_SAMPLE_COUNT_1_BIT;
+    color.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; /* Aliased contents are never preserved */
+    color.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkAttachmentReference color_ref = {0};
+    color_ref.attachment = 0;
+    color_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    VkSubpassDescription sub = {0};
+    sub.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    sub.colorAttachmentCount = 1;
+    sub.pColorAttachments = &color_ref;
+    /* Chains to the barrier of begin_offscreen_writes */
+    VkSubpassDependency dep = {0};
+    dep.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dep.dstSubpass = 0;
+    dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    VkRenderPassCreateInfo rp = {0};
+    rp.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    rp.attachmentCount = 1;
+    rp.pAttachments = &color;
+    rp.subpassCount = 1;
+    rp.pSubpasses = &sub;
+    rp.dependencyCount = 1;
+    rp.pDependencies = &dep;
+    if (vkCreateRenderPass(cj_engine_device(graph->engine), &rp, NULL, &graph->transient_render_pass) != VK_SUCCESS) {
+        fprintf(stderr, "cj_rgraph: failed to create transient render pass\n");
         return 0;
     }
-
-    printf("Intermediate render target created: %dx%d\n", extent.width, extent.height);
     return 1;
 }
 
-/* Destroy intermediate render target - TODO: implement cleanup when blur node is destroyed */
-static void destroy_intermediate_render_target(cj_rgraph_t* graph, cj_rgraph_blur_node_t* blur) {
-    (void)graph; (void)blur; // Suppress unused parameter warnings - function not yet implemented
-    if (!graph || !blur) return;
-
+/* Allocate an extent set's transient images, sharing memory per alias slot */
+static cj_result_t build_physical(cj_rgraph_t* graph, uint32_t set, VkExtent2D extent) {
     VkDevice device = cj_engine_device(graph->engine);
+    cj_rgraph_extent_set_t* es = &graph->extents[set];
+    release_physical(graph, set);
+    es->extent = extent;
 
-    if (blur->intermediate_view != VK_NULL_HANDLE) {
-        vkDestroyImageView(device, blur->intermediate_view, NULL);
-        blur->intermediate_view = VK_NULL_HANDLE;
+    bool any = false;
+    for (uint32_t r = 1; r < graph->resource_count; r++) {
+        if (graph->resources[r].used && graph->resources[r].transient) { any = true; break; }
+    }
+    if (!any) {
+        es->valid = true;
+        return CJ_SUCCESS;
     }
-    if (blur->intermediate_memory != VK_NULL_HANDLE) {
-        vkFreeMemory(device, blur->intermediate_memory, NULL);
-        blur->intermediate_memory = VK_NULL_HANDLE;
+    if (!ensure_transient_render_pass(graph)) return CJ_E_UNKNOWN;
+
+    VkFormat format = cj_engine_color_format(graph->engine);
+
+    /* Create images first so each slot can be sized to its largest occupant */
+    for (uint32_t r = 1; r < graph->resource_count; r++) {
+        cj_rgraph_resource_t* res = &graph->resources[r];
+        if (!res->used || !res->transient) continue;
+        cj_rgraph_transient_t* img = &es->images[r];
+        img->extent.width = (uint32_t)((float)extent.width * res->scale);
+        img->extent.height = (uint32_t)((float)extent.height * res->scale);
+        if (img->extent.width == 0) img->extent.width = 1;
+        if (img->extent.height == 0) img->extent.height = 1;
+
+        VkImageCreateInfo image_info = {0};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.extent.width = img->extent.width;
+        image_info.extent.height = img->extent.height;
+        image_info.extent.depth = 1;
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = 1;
+        image_info.format = format;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        image_info.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateImage(device, &image_info, NULL, &img->image) != VK_SUCCESS) {
+            fprintf(stderr, "cj_rgraph: failed to create transient image %s\n", res->name);
+            release_physical(graph, set);
+            return CJ_E_UNKNOWN;
+        }
+
+        /* Share the slot's memory only with images that can live in the same memory type */
+        VkMemoryRequirements req;
+        vkGetImageMemoryRequirements(device, img->image, &req);
+        uint32_t k = 0;
+        while (k < es->memory_count &&
+               (es->memory[k].alias_slot != res->alias_slot ||
+                !(es->memory[k].memory_type_bits & req.memoryTypeBits))) k++;
+        cj_rgraph_memory_t* slot = &es->memory[k];
+        if (k == es->memory_count) {
+            es->memory_count++;
+            slot->alias_slot = res->alias_slot;
+            slot->memory_type_bits = UINT32_MAX;
+        }
+        if (req.size > slot->size) slot->size = req.size;
+        slot->memory_type_bits &= req.memoryTypeBits;
+        img->memory = k;
     }
-    if (blur->intermediate_texture != VK_NULL_HANDLE) {
-        vkDestroyImage(device, blur->intermediate_texture, NULL);
-        blur->intermediate_texture = VK_NULL_HANDLE;
+
+    VkPhysicalDeviceMemoryProperties mem_properties;
+    vkGetPhysicalDeviceMemoryProperties(cj_engine_physical_device(graph->engine), &mem_properties);
+    for (uint32_t k = 0; k < es->memory_count; k++) {
+        cj_rgraph_memory_t* slot = &es->memory[k];
+        uint32_t memory_type_index = UINT32_MAX;
+        for (uint32_t i = 0; i < mem_properties.memoryTypeCount; i++) {
+            if ((slot->memory_type_bits & (1u << i)) &&
+                (mem_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+                memory_type_index = i;
+                break;
+            }
+        }
+        if (memory_type_index == UINT32_MAX) {
+            fprintf(stderr, "cj_rgraph: no device-local memory type for transient slot %u\n", k);
+            release_physical(graph, set);
+            return CJ_E_UNSUPPORTED;
+        }
+        VkMemoryAllocateInfo alloc_info = {0};
+        alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        alloc_info.allocationSize = slot->size;
+        alloc_info.memoryTypeIndex = memory_type_index;
+        if (vkAllocateMemory(device, &alloc_info, NULL, &slot->memory) != VK_SUCCESS) {
+            fprintf(stderr, "cj_rgraph: failed to allocate transient slot %u\n", k);
+            release_physical(graph, set);
+            return CJ_E_OUT_OF_MEMORY;
+        }
     }
-    if (blur->intermediate_framebuffer != VK_NULL_HANDLE) {
-        vkDestroyFramebuffer(device, blur->intermediate_framebuffer, NULL);
-        blur->intermediate_framebuffer = VK_NULL_HANDLE;
+
+    CJellyTexturedResources* tx = cj_engine_textured(graph->engine);
+    for (uint32_t r = 1; r < graph->resource_count; r++) {
+        cj_rgraph_resource_t* res = &graph->resources[r];
+        if (!res->used || !res->transient) continue;
+        cj_rgraph_transient_t* img = &es->images[r];
+        vkBindImageMemory(device, img->image, es->memory[img->memory].memory, 0);
+
+        VkImageViewCreateInfo view_info = {0};
+        view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_info.image = img->image;
+        view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_info.format = format;
+        view_info.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        view_info.subresourceRange.levelCount = 1;
+        view_info.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(device, &view_info, NULL, &img->view) != VK_SUCCESS) {
+            fprintf(stderr, "cj_rgraph: failed to create transient view %s\n", res->name);
+            release_physical(graph, set);
+            return CJ_E_UNKNOWN;
+        }
+
+        VkFramebufferCreateInfo fb_info = {0};
+        fb_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        fb_info.renderPass = graph->transient_render_pass;
+        fb_info.attachmentCount = 1;
+        fb_info.pAttachments = &img->view;
+        fb_info.width = img->extent.width;
+        fb_info.height = img->extent.height;
+        fb_info.layers = 1;
+        if (vkCreateFramebuffer(device, &fb_info, NULL, &img->framebuffer) != VK_SUCCESS) {
+            fprintf(stderr, "cj_rgraph: failed to create transient framebuffer %s\n", res->name);
+            release_physical(graph, set);
+            return CJ_E_UNKNOWN;
+        }
     }
-    if (blur->intermediate_render_pass != VK_NULL_HANDLE) {
-        vkDestroyRenderPass(device, blur->intermediate_render_pass, NULL);
-        blur->intermediate_render_pass = VK_NULL_HANDLE;
+
+    /* Give sampling nodes a set over their first transient input; blur nodes bind theirs when prepared.
+     * The sets are new, so frames in flight keep the ones they were recorded with. */
+    for (uint32_t p = 0; p < graph->schedule_count; p++) {
+        cj_rgraph_node_t* node = graph->schedule[p];
+        if (node->read_count == 0 || node->type != CJ_RGRAPH_NODE_TEXTURED) continue;
+        if (!tx || tx->sampler == VK_NULL_HANDLE) continue;
+        VkDescriptorSet input = cj_engine_alloc_node_set(graph->engine, &node->input_pools[set]);
+        if (input == VK_NULL_HANDLE) {
+            fprintf(stderr, "cj_rgraph: failed to allocate the input set of %s\n", node->name);
+            release_physical(graph, set);
+            return CJ_E_OUT_OF_MEMORY;
+        }
+
+        VkDescriptorImageInfo image_info = {0};
+        image_info.sampler = tx->sampler;
+        image_info.imageView = es->images[node->reads[0]].view;
+        image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        VkWriteDescriptorSet write = {0};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = input;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.pImageInfo = &image_info;
+        vkUpdateDescriptorSets(device, 1, &write, 0, NULL);
+        node->input_sets[set] = input;
     }
+
+    es->valid = true;
+    graph->content_version++;
+    return CJ_SUCCESS;
 }
@@ -0,0 +1,473 @@
+/* CJelly shader hot reload: background compilation and pipeline rebuilds */
+
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <cjelly/shader_reload_internal.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* How often the directory is scanned for changed files */
+#define CJ_SHADER_RELOAD_SCAN_MS 250u
+#define CJ_SHADER_RELOAD_NAME_SIZE 64u
+#define CJ_SHADER_RELOAD_PATH_SIZE 1024u
+#define CJ_SPIRV_MAGIC 0x07230203u
+
+/* Source file seen by the last scan */
+typedef struct cj_shader_file_t {
+  char name[CJ_SHADER_RELOAD_NAME_SIZE];
+  uint64_t mtime;
+  uint64_t size;
+  bool seen;  /* Present in the scan in progress */
+} cj_shader_file_t;
+
+/* SPIR-V compiled from a changed source, waiting for the main thread */
+typedef struct cj_shader_compiled_t {
+  struct cj_shader_compiled_t* next;
+  char name[CJ_SHADER_RELOAD_NAME_SIZE];
+  void* code;
+  size_t size;
+} cj_shader_compiled_t;
+
+/* Rebuild in the FIFO shared with the thread */
+typedef struct cj_shader_job_t {
+  struct cj_shader_job_t* next;
+  cj_pipeline_rebuild_t* rebuild;
+  bool ran;
+} cj_shader_job_t;
+
+struct cj_shader_reload_t {
+  cj_pipeline_cache_t* pipelines;   /* Main thread only */
+  char dir[CJ_SHADER_RELOAD_PATH_SIZE];
+  char compiler[CJ_SHADER_RELOAD_PATH_SIZE];
+  char temp_dir[CJ_SHADER_RELOAD_PATH_SIZE];
+
+  /* Thread only */
+  cj_shader_file_t* files;
+  uint32_t file_count, file_capacity;
+  bool scanned;                     /* The first scan only records modification times */
+
+#ifdef _WIN32
+  HANDLE thread;
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE cv;            /* Signaled when a job is queued or the thread stops */
+#else
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cv;
+#endif
+
+  /* Guarded by lock */
+  cj_shader_compiled_t* compiled;   /* Newest first */
+  cj_shader_job_t* jobs_head;       /* Oldest first; the main thread pops ran jobs */
+  cj_shader_job_t* jobs_tail;
+  cj_shader_job_t* next_run;        /* First job the thread has not run */
+  bool stop;
+};
+
+static void reload_lock(cj_shader_reload_t* r) {
+#ifdef _WIN32
+  EnterCriticalSection(&r->lock);
+#else
+  pthread_mutex_lock(&r->lock);
+#endif
+}
+
+static void reload_unlock(cj_shader_reload_t* r) {
+#ifdef _WIN32
+  LeaveCriticalSection(&r->lock);
+#else
+  pthread_mutex_unlock(&r->lock);
+#endif
+}
+
+static void reload_wake(cj_shader_reload_t* r) {
+#ifdef _WIN32
+  WakeConditionVariable(&r->cv);
+#else
+  pthread_cond_signal(&r->cv);
+#endif
+}
+
+/* Wait on the condition variable for at most ms; the lock must be held */
+static void reload_wait(cj_shader_reload_t* r, uint32_t ms) {
+#ifdef _WIN32
+  SleepConditionVariableCS(&r->cv, &r->lock, ms);
+#else
+  struct timespec until;
+  clock_gettime(CLOCK_REALTIME, &until);
+  until.tv_sec += ms / 1000u;
+  until.tv_nsec += (long)(ms % 1000u) * 1000000L;
+  if (until.tv_nsec >= 1000000000L) {
+    until.tv_sec++;
+    until.tv_nsec -= 1000000000L;
+  }
+  pthread_cond_timedwait(&r->cv, &r->lock, &until);
+#endif
+}
+
+static void copy_string(char* dst, size_t cap, const char* src) {
+  size_t n = strlen(src);
+  if (n >= cap) n = cap - 1;
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+/* Environment variable, or fallback when unset or empty */
+static const char* env_or(const char* name, const char* fallback) {
+  const char* value = getenv(name);
+  return (value && value[0]) ? value : fallback;
+}
+
+/* GLSL stages glslangValidator picks from the extension */
+static bool is_shader_source(const char* name) {
+  static const char* const exts[] = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese" };
+  const char* dot = strrchr(name, '.');
+  if (!dot) return false;
+  for (size_t i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+    if (strcmp(dot, exts[i]) == 0) return true;
+  }
+  return false;
+}
+
+static void* read_spirv(const char* path, size_t* out_size) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return NULL;
+  void* code = NULL;
+  long size = 0;
+  if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) > 0 && size % 4 == 0 && fseek(f, 0, SEEK_SET) == 0) {
+    code = malloc((size_t)size);
+    if (code && fread(code, 1, (size_t)size, f) != (size_t)size) {
+      free(code);
+      code = NULL;
+    }
+  }
+  fclose(f);
+  if (code && *(const uint32_t*)code != CJ_SPIRV_MAGIC) {
+    free(code);
+    code = NULL;
+  }
+  if (code) *out_size = (size_t)size;
+  return code;
+}
+
+/* Compile one source with the external compiler and queue the result */
+static void compile_shader(cj_shader_reload_t* r, const char* name) {
+  char out[2 * CJ_SHADER_RELOAD_PATH_SIZE];
+  char cmd[5 * CJ_SHADER_RELOAD_PATH_SIZE];
+#ifdef _WIN32
+  unsigned long pid = (unsigned long)GetCurrentProcessId();
+  snprintf(out, sizeof(out), "%s\\cjelly_%lu_%s.spv", r->temp_dir, pid, name);
+  /* cmd.exe drops the outer quotes of a command line starting with one */
+  snprintf(cmd, sizeof(cmd), "\"\"%s\" -V \"%s\\%s\" -o \"%s\"\"", r->compiler, r->dir, name, out);
+#else
+  unsigned long pid = (unsigned long)getpid();
+  snprintf(out, sizeof(out), "%s/cjelly_%lu_%s.spv", r->temp_dir, pid, name);
+  snprintf(cmd, sizeof(cmd), "\"%s\" -V \"%s/%s\" -o \"%s\"", r->compiler, r->dir, name, out);
+#endif
+
+  int status = system(cmd);
+  size_t size = 0;
+  void* code = (status == 0) ? read_spirv(out, &size) : NULL;
+  remove(out);
+  if (!code) {
+    fprintf(stderr, "shader reload: compiling %s failed, keeping the running version\n", name);
+    return;
+  }
+
+  cj_shader_compiled_t* c = (cj_shader_compiled_t*)calloc(1, sizeof(*c));
+  if (!c) {
+    free(code);
+    return;
+  }
+  copy_string(c->name, sizeof(c->name), name);
+  c->code = code;
+  c->size = size;
+  reload_lock(r);
+  c->next = r->compiled;
+  r->compiled = c;
+  reload_unlock(r);
+}
+
+/* Record a file seen by the scan; true when it is new or changed since the last scan */
+static bool note_file(cj_shader_reload_t* r, const char* name, uint64_t mtime, uint64_t size) {
+  if (strlen(name) >= CJ_SHADER_RELOAD_NAME_SIZE) return false;
+  for (uint32_t i = 0; i < r->file_count; i++) {
+    cj_shader_file_t* f = &r->files[i];
+    if (strcmp(f->name, name) != 0) continue;
+    f->seen = true;
+    if (f->mtime == mtime && f->size == size) return false;
+    f->mtime = mtime;
+    f->size = size;
+    return true;
+  }
+  if (r->file_count == r->file_capacity) {
+    uint32_t cap = r->file_capacity ? r->file_capacity * 2u : 32u;
+    cj_shader_file_t* grown = (cj_shader_file_t*)realloc(r->files, cap * sizeof(*grown));
+    if (!grown) return false;
+    r->files = grown;
+    r->file_capacity = cap;
+  }
+  cj_shader_file_t* f = &r->files[r->file_count++];
+  copy_string(f->name, sizeof(f->name), name);
+  f->mtime = mtime;
+  f->size = size;
+  f->seen = true;
+  return true;
+}
+
+/* Compare the directory with the last scan and compile what changed */
+static void scan_directory(cj_shader_reload_t* r) {
+  for (uint32_t i = 0; i < r->file_count; i++) r->files[i].seen = false;
+
+  /* Compiling can take a while; collect the names first */
+  char (*changed)[CJ_SHADER_RELOAD_NAME_SIZE] = NULL;
+  uint32_t changed_count = 0, changed_capacity = 0;
+#ifdef _WIN32
+  char pattern[CJ_SHADER_RELOAD_PATH_SIZE + 4];
+  snprintf(pattern, sizeof(pattern), "%s\\*", r->dir);
+  WIN32_FIND_DATAA fd;
+  HANDLE find = FindFirstFileA(pattern, &fd);
+  if (find == INVALID_HANDLE_VALUE) return;
+  do {
+    if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || !is_shader_source(fd.cFileName)) continue;
+    uint64_t mtime = ((uint64_t)fd.ftLastWriteTime.dwHighDateTime << 32) | fd.ftLastWriteTime.dwLowDateTime;
+    uint64_t size = ((uint64_t)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+    const char* name = fd.cFileName;
+#else
+  DIR* d = opendir(r->dir);
+  if (!d) return;
+  struct dirent* ent;
+  while ((ent = readdir(d)) != NULL) {
+    if (!is_shader_source(ent->d_name)) continue;
+    char path[2 * CJ_SHADER_RELOAD_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/%s", r->dir, ent->d_name);
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+    uint64_t mtime = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+    uint64_t size = (uint64_t)st.st_size;
+    const char* name = ent->d_name;
+#endif
+    if (!note_file(r, name, mtime, size) || !r->scanned) continue;
+    if (changed_count == changed_capacity) {
+      uint32_t cap = changed_capacity ? changed_capacity * 2u : 8u;
+      void* grown = realloc(changed, cap * sizeof(*changed));
+      if (!grown) continue;
+      changed = grown;
+      changed_capacity = cap;
+    }
+    copy_string(changed[changed_count++], CJ_SHADER_RELOAD_NAME_SIZE, name);
+#ifdef _WIN32
+  } while (FindNextFileA(find, &fd));
+  FindClose(find);
+#else
+  }
+  closedir(d);
+#endif
+
+  /* Forget deleted files so they count as changed when they come back */
+  for (uint32_t i = 0; i < r->file_count;) {
+    if (!r->files[i].seen) r->files[i] = r->files[--r->file_count];
+    else i++;
+  }
+  r->scanned = true;
+
+  for (uint32_t i = 0; i < changed_count; i++) {
+    reload_lock(r);
+    bool stop = r->stop;
+    reload_unlock(r);
+    if (stop) break;
+    compile_shader(r, changed[i]);
+  }
+  free(changed);
+}
+
+static void reload_thread_loop(cj_shader_reload_t* r) {
+  uint32_t since_scan_ms = CJ_SHADER_RELOAD_SCAN_MS;
+  reload_lock(r);
+  while (!r->stop) {
+    /* Rebuilds come first: a frame may be waiting to adopt them */
+    cj_shader_job_t* job = r->next_run;
+    if (job) {
+      r->next_run = job->next;
+      reload_unlock(r);
+      cj_pipeline_rebuild_run(job->rebuild);
+      reload_lock(r);
+      job->ran = true;
+      continue;
+    }
+    if (since_scan_ms >= CJ_SHADER_RELOAD_SCAN_MS) {
+      reload_unlock(r);
+      scan_directory(r);
+      reload_lock(r);
+      since_scan_ms = 0;
+      continue;
+    }
+    /* A queued job cuts the nap short; the next scan then waits a full period */
+    reload_wait(r, CJ_SHADER_RELOAD_SCAN_MS);
+    since_scan_ms += CJ_SHADER_RELOAD_SCAN_MS;
+  }
+  reload_unlock(r);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI reload_thread_main(LPVOID arg) {
+  reload_thread_loop((cj_shader_reload_t*)arg);
+  return 0;
+}
+#else
+static void* reload_thread_main(void* arg) {
+  reload_thread_loop((cj_shader_reload_t*)arg);
+  return NULL;
+}
+#endif
+
+cj_shader_reload_t* cj_shader_reload_create(cj_pipeline_cache_t* pipelines, const char* dir) {
+  if (!pipelines) return NULL;
+  cj_shader_reload_t* r = (cj_shader_reload_t*)calloc(1, sizeof(*r));
+  if (!r) return NULL;
+  r->pipelines = pipelines;
+  copy_string(r->dir, sizeof(r->dir), dir ? dir : env_or("CJELLY_SHADER_DIR", "src/shaders"));
+  copy_string(r->compiler, sizeof(r->compiler), env_or("CJELLY_GLSLANG", "glslangValidator"));
+#ifdef _WIN32
+  copy_string(r->temp_dir, sizeof(r->temp_dir), env_or("TEMP", "."));
+#else
+  copy_string(r->temp_dir, sizeof(r->temp_dir), env_or("TMPDIR", "/tmp"));
+#endif
+
+#ifdef _WIN32
+  InitializeCriticalSection(&r->lock);
+  InitializeConditionVariable(&r->cv);
+  r->thread = CreateThread(NULL, 0, reload_thread_main, r, 0, NULL);
+  bool started = (r->thread != NULL);
+#else
+  pthread_mutex_init(&r->lock, NULL);
+  pthread_cond_init(&r->cv, NULL);
+  bool started = (pthread_create(&r->thread, NULL, reload_thread_main, r) == 0);
+#endif
+  if (!started) {
+    fprintf(stderr, "cj_shader_reload_create: failed to start the watcher thread\n");
+#ifdef _WIN32
+    DeleteCriticalSection(&r->lock);
+#else
+    pthread_cond_destroy(&r->cv);
+    pthread_mutex_destroy(&r->lock);
+#endif
+    free(r);
+    return NULL;
+  }
+  return r;
+}
+
+void cj_shader_reload_destroy(cj_shader_reload_t* r) {
+  if (!r) return;
+  reload_lock(r);
+  r->stop = true;
+  reload_wake(r);
+  reload_unlock(r);
+#ifdef _WIN32
+  WaitForSingleObject(r->thread, INFINITE);
+  CloseHandle(r->thread);
+  DeleteCriticalSection(&r->lock);
+#else
+  pthread_join(r->thread, NULL);
+  pthread_cond_destroy(&r->cv);
+  pthread_mutex_destroy(&r->lock);
+#endif
+
+  while (r->jobs_head) {
+    cj_shader_job_t* job = r->jobs_head;
+    r->jobs_head = job->next;
+    cj_pipeline_rebuild_discard(job->rebuild);
+    free(job);
+  }
+  while (r->compiled) {
+    cj_shader_compiled_t* c = r->compiled;
+    r->compiled = c->next;
+    free(c->code);
+    free(c);
+  }
+  free(r->files);
+  free(r);
+}
+
+bool cj_shader_reload_poll(cj_shader_reload_t* r) {
+  if (!r) return false;
+
+  reload_lock(r);
+  cj_shader_compiled_t* compiled = r->compiled;
+  r->compiled = NULL;
+  reload_unlock(r);
+
+  /* Oldest compilation first, so a later save of the same file wins */
+  cj_shader_compiled_t* ordered = NULL;
+  while (compiled) {
+    cj_shader_compiled_t* next = compiled->next;
+    compiled->next = ordered;
+    ordered = compiled;
+    compiled = next;
+  }
+  while (ordered) {
+    cj_shader_compiled_t* c = ordered;
+    ordered = c->next;
+    cj_pipeline_rebuild_t* rebuild = cj_pipeline_cache_set_shader(r->pipelines, c->name, c->code, c->size);
+    uint32_t queued = 0;
+    while (rebuild) {
+      cj_pipeline_rebuild_t* next = cj_pipeline_rebuild_next(rebuild);
+      cj_shader_job_t* job = (cj_shader_job_t*)calloc(1, sizeof(*job));
+      if (!job) {
+        cj_pipeline_rebuild_discard(rebuild);
+        rebuild = next;
+        continue;
+      }
+      job->rebuild = rebuild;
+      reload_lock(r);
+      if (r->jobs_tail) r->jobs_tail->next = job;
+      else r->jobs_head = job;
+      r->jobs_tail = job;
+      if (!r->next_run) r->next_run = job;
+      reload_wake(r);
+      reload_unlock(r);
+      queued++;
+      rebuild = next;
+    }
+    fprintf(stderr, "shader reload: %s changed, rebuilding %u pipeline%s\n", c->name, queued, queued == 1 ? "" : "s");
+    free(c->code);
+    free(c);
+  }
+
+  /* Install finished rebuilds in queue order */
+  bool installed = false;
+  for (;;) {
+    reload_lock(r);
+    cj_shader_job_t* job = r->jobs_head;
+    if (job && job->ran) {
+      r->jobs_head = job->next;
+      if (!r->jobs_head) r->jobs_tail = NULL;
+    } else {
+      job = NULL;
+    }
+    reload_unlock(r);
+    if (!job) break;
+    installed |= cj_pipeline_cache_finish_rebuild(r->pipelines, job->rebuild);
+    free(job);
+  }
+  return installed;
+}
@@ -1,45 +1,42 @@
 #version 450
 
+// One direction of a separable Gaussian blur. Neighboring taps are merged
+// into a single bilinear fetch placed between them by weight, so a kernel
+// reaching r texels to each side costs r + 1 fetches instead of 2r + 1.
 layout(location = 0) in vec2 inTexCoord;
 layout(location = 0) out vec4 outColor;
 
 layout(binding = 0) uniform sampler2D inputTexture;
 
 layout(push_constant) uniform BlurParams {
-    vec2 texelSize;     // 1.0 / texture_size
-    vec2 direction;     // blur direction (1,0) for horizontal, (0,1) for vertical
-    float intensity;    // blur intensity (0.0 = no blur, 1.0 = max blur)
-    float time;         // time parameter for animation
+    vec2 direction;     // (1,0) for the horizontal pass, (0,1) for the vertical pass
+    float sigma;        // standard deviation in input texels; 0 copies the input
+    float radius;       // texels the kernel reaches to each side
 } blurParams;
 
 void main() {
     vec2 uv = inTexCoord;
-
-    // Sample the input texture
     vec4 color = texture(inputTexture, uv);
-
-    // Apply simple blur effect
-    float blurRadius = blurParams.intensity * 5.0; // Scale intensity to reasonable blur radius
-
-    // Simple blur by sampling nearby pixels
-    vec4 blurredColor = color;
-
-    // Sample neighboring pixels for blur effect
-    for (int i = -2; i <= 2; i++) {
-        for (int j = -2; j <= 2; j++) {
-            vec2 offset = vec2(float(i), float(j)) * blurParams.texelSize * blurRadius;
-            blurredColor += texture(inputTexture, uv + offset);
-        }
+    int radius = int(blurParams.radius);
+    if (blurParams.sigma <= 0.0 || radius <= 0) {
+        outColor = color;
+        return;
     }
 
-    // Average the samples
-    blurredColor /= 25.0; // 5x5 sampling = 25 samples
-
-    // Add some animated color variation based on time
-    float timeFactor = sin(blurParams.time * 0.5) * 0.1;
-    blurredColor.r += timeFactor;
-    blurredColor.g += timeFactor * 0.5;
-    blurredColor.b += timeFactor * 0.3;
-
-    outColor = blurredColor;
+    vec2 texelStep = blurParams.direction / vec2(textureSize(inputTexture, 0));
+    float falloff = -0.5 / (blurParams.sigma * blurParams.sigma);
+
+    // The center tap has weight exp(0) = 1; the rest are normalized at the end
+    vec4 sum = color;
+    float total = 1.0;
+    for (int i = 1; i <= radius; i += 2) {
+        float w0 = exp(falloff * float(i * i));
+        float w1 = (i + 1 <= radius) ? exp(falloff * float((i + 1) * (i + 1))) : 0.0;
+        float weight = w0 + w1;
+        float offset = (float(i) * w0 + float(i + 1) * w1) / weight;
+        sum += weight * (texture(inputTexture, uv + texelStep * offset) +
+                         texture(inputTexture, uv - texelStep * offset));
+        total += 2.0 * weight;
+    }
+    outColor = sum / total;
 }
@@ -0,0 +1,21 @@
+#version 450
+
+// Dual-Kawase downsample: renders at half the input size, averaging the
+// center with four diagonal bilinear fetches one input texel away. Each
+// level widens the blur while quartering the texels later passes touch.
+layout(location = 0) in vec2 inTexCoord;
+layout(location = 0) out vec4 outColor;
+
+layout(binding = 0) uniform sampler2D inputTexture;
+
+void main() {
+    vec2 uv = inTexCoord;
+    vec2 texel = 1.0 / vec2(textureSize(inputTexture, 0));
+
+    vec4 sum = texture(inputTexture, uv) * 4.0;
+    sum += texture(inputTexture, uv - texel);
+    sum += texture(inputTexture, uv + texel);
+    sum += texture(inputTexture, uv + vec2(texel.x, -texel.y));
+    sum += texture(inputTexture, uv - vec2(texel.x, -texel.y));
+    outColor = sum / 8.0;
+}
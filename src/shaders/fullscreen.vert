@@ -0,0 +1,11 @@
+#version 450
+
+// Full-screen triangle generated from the vertex index; draw 3 vertices
+// with no vertex buffer bound. UVs cover [0,1] over the viewport.
+layout(location = 0) out vec2 outTexCoord;
+
+void main() {
+    vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+    outTexCoord = uv;
+}
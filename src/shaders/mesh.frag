@@ -0,0 +1,17 @@
+#version 450
+
+// Diffuse lighting from a fixed direction, with an ambient term so unlit
+// sides stay visible. The result is premultiplied; the node composites its
+// image with ONE, ONE_MINUS_SRC_ALPHA.
+layout(location = 0) in vec3 fragNormal;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 lightDirection = vec3(0.4, -0.8, 0.45);
+
+void main() {
+    float diffuse = max(dot(normalize(fragNormal), normalize(lightDirection)), 0.0);
+    vec3 color = fragColor.rgb * (0.25 + 0.75 * diffuse);
+    outColor = vec4(color * fragColor.a, fragColor.a);
+}
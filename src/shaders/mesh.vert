@@ -0,0 +1,33 @@
+#version 450
+
+// Objects of a mesh node, drawn through the indirect commands mesh_cull.comp
+// wrote. Each command's firstInstance is the index of its object.
+struct Object {
+    mat4 transform;
+    vec3 boundsMin;
+    uint firstIndex;
+    vec3 boundsMax;
+    uint indexCount;
+    vec4 color;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
+
+layout(push_constant) uniform Push {
+    mat4 viewProj;   // "<node>.view_proj"
+} pc;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+
+layout(location = 0) out vec3 fragNormal;
+layout(location = 1) out vec4 fragColor;
+
+void main() {
+    Object object = objects[gl_InstanceIndex];
+    gl_Position = pc.viewProj * object.transform * vec4(inPosition, 1.0);
+    fragNormal = mat3(object.transform) * inNormal;
+    fragColor = object.color;
+}
@@ -0,0 +1,21 @@
+#version 450
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec4 fragColor;
+layout(location = 2) in flat uint fragTextureSlot;
+
+// Engine texture table; the array size matches CJ_ENGINE_TEXTURE_TABLE_SIZE.
+layout(set = 0, binding = 0) uniform sampler2D textures[1024];
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    // Slot 0 is never a texture: the sprite is a solid color
+    if (fragTextureSlot == 0u) {
+        outColor = fragColor;
+    } else {
+        outColor = texture(textures[nonuniformEXT(fragTextureSlot)], fragTexCoord) * fragColor;
+    }
+}
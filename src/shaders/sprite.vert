@@ -0,0 +1,35 @@
+#version 450
+
+// One instance per sprite (cj_rgraph_sprite_t); the six corners of its quad
+// come from gl_VertexIndex, so no per-vertex buffer is bound.
+layout(location = 0) in vec4 inRect;        // x, y, width, height in pixels
+layout(location = 1) in vec4 inUvRect;      // u0, v0, u1, v1
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in uint inTextureSlot;
+
+layout(push_constant) uniform Push {
+    vec2 invExtent;  // 1 / render target size in pixels
+} pc;
+
+// Node parameters from the render graph's per-frame uniform buffer
+layout(set = 1, binding = 0) uniform SpriteUniforms {
+    mat4 transform;  // "<node>.transform", applied to pixel positions
+    vec4 tint;       // "<node>.tint", multiplied into every sprite color
+} node;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
+layout(location = 2) out flat uint fragTextureSlot;
+
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(1.0, 1.0), vec2(0.0, 1.0), vec2(0.0, 0.0));
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    vec2 pixel = (node.transform * vec4(inRect.xy + corner * inRect.zw, 0.0, 1.0)).xy;
+    gl_Position = vec4(pixel * pc.invExtent * 2.0 - 1.0, 0.0, 1.0);
+    fragTexCoord = mix(inUvRect.xy, inUvRect.zw, corner);
+    fragColor = inColor * node.tint;
+    fragTextureSlot = inTextureSlot;
+}
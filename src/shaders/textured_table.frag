@@ -0,0 +1,16 @@
+#version 450
+
+// Samples one texture of the engine texture table. The slot comes from
+// cj_texture_descriptor_slot(); the array size matches CJ_ENGINE_TEXTURE_TABLE_SIZE.
+layout(location = 0) in vec2 fragTexCoord;
+layout(set = 0, binding = 0) uniform sampler2D textures[1024];
+
+layout(push_constant) uniform Push {
+    uint textureSlot;
+} pc;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(textures[pc.textureSlot], fragTexCoord);
+}
@@ -0,0 +1,162 @@
+/*
+ * CJelly — KTX2 texture loading
+ * Copyright (c) 2025
+ *
+ * Creates textures from KTX2 files. Levels are copied (or handed to a
+ * transcoder) straight from the mapped file into upload staging memory.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <cjelly/cj_resources.h>
+#include <cjelly/engine_internal.h>
+#include <cjelly/resource_helpers_internal.h>
+#include <cjelly/format/file.h>
+#include <cjelly/format/image/ktx2.h>
+
+/* sRGB twin of a format, so Basis data tagged sRGB decodes through the hardware curve */
+static cj_format_t ktx2_srgb_format(cj_format_t format) {
+  switch (format) {
+    case CJ_FORMAT_RGBA8_UNORM:      return CJ_FORMAT_RGBA8_SRGB;
+    case CJ_FORMAT_BC1_RGBA_UNORM:   return CJ_FORMAT_BC1_RGBA_SRGB;
+    case CJ_FORMAT_BC3_UNORM:        return CJ_FORMAT_BC3_SRGB;
+    case CJ_FORMAT_BC7_UNORM:        return CJ_FORMAT_BC7_SRGB;
+    case CJ_FORMAT_ETC2_RGB8_UNORM:  return CJ_FORMAT_ETC2_RGB8_SRGB;
+    case CJ_FORMAT_ETC2_RGBA8_UNORM: return CJ_FORMAT_ETC2_RGBA8_SRGB;
+    case CJ_FORMAT_ASTC_4x4_UNORM:   return CJ_FORMAT_ASTC_4x4_SRGB;
+    case CJ_FORMAT_ASTC_6x6_UNORM:   return CJ_FORMAT_ASTC_6x6_SRGB;
+    case CJ_FORMAT_ASTC_8x8_UNORM:   return CJ_FORMAT_ASTC_8x8_SRGB;
+    default:                         return format;
+  }
+}
+
+/* Format the texture is created with: the stored one, or the first transcoder target the device has */
+static cj_format_t ktx2_pick_format(cj_engine_t* e, const CJellyFormatImageKTX2Info* info,
+                                    const cj_ktx2_transcoder_t* transcoder) {
+  if (!info->basis) {
+    cj_format_t format = cj_engine_format_from_vk(info->vk_format);
+    return cj_engine_format_supported(e, format) ? format : CJ_FORMAT_UNDEFINED;
+  }
+  for (uint32_t i = 0; transcoder && i < transcoder->format_count; i++) {
+    cj_format_t format = info->srgb ? ktx2_srgb_format(transcoder->formats[i]) : transcoder->formats[i];
+    if (cj_engine_format_supported(e, format)) return format;
+  }
+  return CJ_FORMAT_UNDEFINED;
+}
+
+CJ_API cj_result_t cj_texture_load_ktx2_memory(cj_engine_t* e, const void* data, size_t size,
+                                               const cj_ktx2_load_desc_t* desc,
+                                               cj_handle_t* out_texture, cj_upload_ticket_t* out_ticket) {
+  if (out_texture) memset(out_texture, 0, sizeof(*out_texture));
+  if (out_ticket) *out_ticket = 0;
+  if (!e || !data || !out_texture) return CJ_E_INVALID_ARGUMENT;
+  cj_ktx2_load_desc_t defaults = {0};
+  if (!desc) desc = &defaults;
+
+  CJellyFormatImageKTX2Info info;
+  if (cjelly_format_image_ktx2_parse(data, size, &info) != CJELLY_FORMAT_IMAGE_SUCCESS) {
+    fprintf(stderr, "cj_texture_load_ktx2: not a valid KTX2 file\n");
+    return CJ_E_INVALID_ARGUMENT;
+  }
+  if (info.depth > 1) {
+    fprintf(stderr, "cj_texture_load_ktx2: 3D textures are not supported\n");
+    return CJ_E_UNSUPPORTED;
+  }
+  const cj_ktx2_transcoder_t* transcoder = NULL;
+  if (info.basis || info.supercompression != CJELLY_FORMAT_IMAGE_KTX2_SUPERCOMPRESSION_NONE) {
+    transcoder = desc->transcoder;
+    if (!transcoder || !transcoder->open || !transcoder->transcode) {
+      fprintf(stderr, "cj_texture_load_ktx2: supercompressed file (scheme %u) needs a transcoder\n",
+              info.supercompression);
+      return CJ_E_UNSUPPORTED;
+    }
+  }
+  cj_format_t format = ktx2_pick_format(e, &info, transcoder);
+  if (format == CJ_FORMAT_UNDEFINED) {
+    fprintf(stderr, "cj_texture_load_ktx2: the device supports no format for VkFormat %u\n", info.vk_format);
+    return CJ_E_UNSUPPORTED;
+  }
+
+  /* Skipped levels are never staged; the smallest level always stays */
+  uint32_t skip = desc->skip_mips < info.levels ? desc->skip_mips : info.levels - 1u;
+  cj_texture_desc_t td = {0};
+  td.width = (info.width >> skip) ? (info.width >> skip) : 1u;
+  td.height = (info.height >> skip) ? (info.height >> skip) : 1u;
+  td.layers = info.layers * info.faces;
+  td.mips = info.levels - skip;
+  td.format = format;
+  td.usage = desc->usage ? desc->usage : CJ_IMAGE_SAMPLED;
+  td.cube = info.faces == 6;
+  /* Files that ask for a generated chain hold only mip 0 */
+  if (info.generate_mips && cj_engine_format_can_generate_mips(e, format)) {
+    td.mips = 0;
+    td.generate_mips = true;
+  }
+  td.debug_name = desc->debug_name;
+  cj_handle_t texture = cj_texture_create(e, &td);
+  uint64_t raw = ((uint64_t)texture.idx << 32) | (uint64_t)texture.gen;
+  uint32_t index = cj_engine_res_index(e, CJ_RES_TEX, raw);
+  if (index == 0) return CJ_E_OUT_OF_MEMORY;
+
+  void* state = transcoder ? transcoder->open(transcoder->user, data, size) : NULL;
+  cj_result_t result = (transcoder && !state) ? CJ_E_INVALID_ARGUMENT : CJ_SUCCESS;
+  cj_upload_ticket_t ticket = 0;
+  for (uint32_t level = skip; level < info.levels && result == CJ_SUCCESS; level++) {
+    for (uint32_t layer = 0; layer < info.layers && result == CJ_SUCCESS; layer++) {
+      for (uint32_t face = 0; face < info.faces && result == CJ_SUCCESS; face++) {
+        size_t staged_size = 0;
+        void* staged = cj_engine_stage_texture_level(e, index, level - skip, layer * info.faces + face,
+                                                     &staged_size, &ticket);
+        if (!staged) {
+          result = CJ_E_OUT_OF_MEMORY;
+        } else if (transcoder) {
+          if (!transcoder->transcode(state, level, layer, face, format, staged, staged_size)) {
+            fprintf(stderr, "cj_texture_load_ktx2: transcoding level %u layer %u face %u failed\n", level, layer, face);
+            result = CJ_E_INVALID_ARGUMENT;
+          }
+        } else {
+          size_t image_size = 0;
+          const unsigned char* image = cjelly_format_image_ktx2_image(&info, level, layer, face, &image_size);
+          if (!image || image_size != staged_size) {
+            fprintf(stderr, "cj_texture_load_ktx2: level %u holds %zu bytes per image, expected %zu\n",
+                    level, image_size, staged_size);
+            result = CJ_E_INVALID_ARGUMENT;
+          } else {
+            memcpy(staged, image, image_size);
+          }
+        }
+      }
+    }
+  }
+  if (state && transcoder->close) transcoder->close(state);
+
+  if (result != CJ_SUCCESS) {
+    /* Dropping the texture also drops its queued copies */
+    cj_texture_release(e, texture);
+    return result;
+  }
+  *out_texture = texture;
+  if (out_ticket) *out_ticket = ticket;
+  return CJ_SUCCESS;
+}
+
+CJ_API cj_result_t cj_texture_load_ktx2(cj_engine_t* e, const char* path, const cj_ktx2_load_desc_t* desc,
+                                        cj_handle_t* out_texture, cj_upload_ticket_t* out_ticket) {
+  if (out_texture) memset(out_texture, 0, sizeof(*out_texture));
+  if (out_ticket) *out_ticket = 0;
+  if (!e || !path || !out_texture) return CJ_E_INVALID_ARGUMENT;
+
+  CJellyFormatFileMapping mapping;
+  switch (cjelly_format_file_map(path, &mapping)) {
+    case CJELLY_FORMAT_FILE_SUCCESS: break;
+    case CJELLY_FORMAT_FILE_ERR_NOT_FOUND:
+      fprintf(stderr, "cj_texture_load_ktx2: cannot open %s\n", path);
+      return CJ_E_NOT_FOUND;
+    case CJELLY_FORMAT_FILE_ERR_TOO_LARGE: return CJ_E_OUT_OF_MEMORY;
+    default:
+      fprintf(stderr, "cj_texture_load_ktx2: cannot map %s\n", path);
+      return CJ_E_INVALID_ARGUMENT;
+  }
+  cj_result_t result = cj_texture_load_ktx2_memory(e, mapping.data, mapping.size, desc, out_texture, out_ticket);
+  cjelly_format_file_unmap(&mapping);
+  return result;
+}
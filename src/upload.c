@@ -0,0 +1,698 @@
+/* CJelly upload queue: staging ring, batched copies and fence-backed tickets */
+
+#include <cjelly/upload_internal.h>
+#include <cjelly/arena_internal.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CJ_UPLOAD_RING_SIZE ((VkDeviceSize)16 << 20)
+
+/* Submissions that may be in flight at once; reusing a slot waits for it */
+#define CJ_UPLOAD_SLOTS 4u
+
+/* Optimal copies want 16-byte aligned buffer offsets; texel alignment is a hard rule */
+#define CJ_UPLOAD_ALIGN ((VkDeviceSize)16)
+
+/* A copy recorded at the next flush; into dst.image, or into dst_buffer when that is NULL */
+typedef struct cj_upload_op_t {
+  cj_upload_image_t dst;
+  VkBuffer dst_buffer;
+  VkDeviceSize dst_offset;
+  VkDeviceSize size;
+  VkBuffer src;             /* Ring buffer, or a one-off buffer for oversized uploads */
+  VkDeviceSize src_offset;
+} cj_upload_op_t;
+
+/* One-off staging buffer for uploads that do not fit in the ring */
+typedef struct cj_upload_staging_t {
+  VkBuffer buffer;
+  cj_gpu_alloc_t alloc;
+} cj_upload_staging_t;
+
+typedef struct cj_upload_slot_t {
+  VkCommandBuffer graphics_cmd;
+  VkCommandBuffer transfer_cmd;   /* NULL without a dedicated transfer family */
+  VkFence fence;                  /* Signaled by the graphics submission, which waits for the transfer one */
+  VkSemaphore transfer_done;
+  uint64_t serial;
+  bool submitted;
+  VkDeviceSize ring_end;          /* Ring head when the slot was submitted */
+  cj_upload_staging_t* staging;   /* One-off buffers released when the slot retires */
+  uint32_t staging_count;
+} cj_upload_slot_t;
+
+struct cj_upload_queue_t {
+  VkDevice device;
+  cj_gpu_allocator_t* gpu;
+  VkQueue graphics_queue;
+  VkQueue transfer_queue;
+  uint32_t graphics_family;
+  uint32_t transfer_family;
+  bool dedicated_transfer;
+  VkCommandPool graphics_pool;
+  VkCommandPool transfer_pool;
+
+  /* Staging ring: bytes in [tail, head) (wrapping) belong to pending or in-flight copies */
+  VkBuffer ring;
+  cj_gpu_alloc_t ring_alloc;
+  VkDeviceSize ring_size;
+  VkDeviceSize head;
+  VkDeviceSize tail;
+  bool ring_pending;              /* Pending copies read from the ring */
+
+  cj_upload_slot_t slots[CJ_UPLOAD_SLOTS];
+  uint64_t serial;                /* Newest submission */
+  uint64_t completed;             /* Every submission up to this serial has retired */
+
+  cj_upload_op_t* ops;
+  uint32_t op_count;
+  uint32_t op_capacity;
+  cj_upload_staging_t* staging;   /* One-off buffers used by pending copies */
+  uint32_t staging_count;
+  cj_upload_mips_t* mips;         /* Layers whose mip chains are generated after the copies */
+  uint32_t mips_count;
+  uint32_t mips_capacity;
+  void* barriers;                 /* Flush scratch: barriers and queue choice for op_capacity copies */
+  uint32_t barrier_capacity;
+};
+
+static VkDeviceSize upload_align_up(VkDeviceSize v, VkDeviceSize align) {
+  VkDeviceSize r = v % align;
+  return r ? v + (align - r) : v;
+}
+
+/* Stage and access masks for the typical use of an image in a layout */
+static void upload_layout_scope(VkImageLayout layout, VkPipelineStageFlags* stage, VkAccessFlags* access) {
+  switch (layout) {
+    case VK_IMAGE_LAYOUT_UNDEFINED:
+      *stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+      *access = 0;
+      break;
+    case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+      *access = VK_ACCESS_TRANSFER_WRITE_BIT;
+      break;
+    case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+      *stage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+      *access = VK_ACCESS_SHADER_READ_BIT;
+      break;
+    default:
+      *stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+      *access = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+      break;
+  }
+}
+
+static bool upload_same_subresource(const cj_upload_image_t* a, const cj_upload_image_t* b) {
+  return a->image != VK_NULL_HANDLE && a->image == b->image && a->mip_level == b->mip_level && a->array_layer == b->array_layer;
+}
+
+static void upload_release_staging(cj_upload_queue_t* q, cj_upload_staging_t* list, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) cj_gpu_destroy_buffer(q->gpu, &list[i].buffer, &list[i].alloc);
+  free(list);
+}
+
+/* Retire finished submissions in order; with wait, block for the oldest one */
+static void upload_retire(cj_upload_queue_t* q, bool wait) {
+  while (q->completed < q->serial) {
+    uint64_t serial = q->completed + 1;
+    cj_upload_slot_t* slot = &q->slots[(serial - 1) % CJ_UPLOAD_SLOTS];
+    if (slot->submitted) {
+      if (wait) {
+        vkWaitForFences(q->device, 1, &slot->fence, VK_TRUE, UINT64_MAX);
+      } else if (vkGetFenceStatus(q->device, slot->fence) != VK_SUCCESS) {
+        return;
+      }
+      vkResetFences(q->device, 1, &slot->fence);
+      slot->submitted = false;
+    }
+    upload_release_staging(q, slot->staging, slot->staging_count);
+    slot->staging = NULL;
+    slot->staging_count = 0;
+    q->tail = slot->ring_end;
+    q->completed = serial;
+    wait = false;
+  }
+}
+
+static bool upload_ring_create(cj_upload_queue_t* q) {
+  if (q->ring != VK_NULL_HANDLE) return true;
+  if (!cj_gpu_create_buffer(q->gpu, q->ring_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            CJ_GPU_ALLOC_DEDICATED, &q->ring, &q->ring_alloc)) {
+    fprintf(stderr, "cj_upload_queue: failed to create %llu byte staging ring\n", (unsigned long long)q->ring_size);
+    return false;
+  }
+  return true;
+}
+
+/* Carve size bytes out of the ring without waiting; false when it is too full */
+static bool upload_ring_reserve(cj_upload_queue_t* q, VkDeviceSize size, VkDeviceSize align, VkDeviceSize* out_offset) {
+  if (!q->ring_pending && q->completed == q->serial) q->head = q->tail = 0;
+
+  VkDeviceSize offset = upload_align_up(q->head, align);
+  if (q->head >= q->tail) {
+    if (offset + size > q->ring_size) {
+      /* Wrap; the tail end of the ring stays unused this lap */
+      if (size >= q->tail) return false;
+      offset = 0;
+    }
+  } else if (offset + size >= q->tail) {
+    return false;
+  }
+
+  q->head = offset + size;
+  q->ring_pending = true;
+  *out_offset = offset;
+  return true;
+}
+
+static bool upload_push_op(cj_upload_queue_t* q, const cj_upload_op_t* op) {
+  if (q->op_count == q->op_capacity) {
+    uint32_t capacity = q->op_capacity ? q->op_capacity * 2u : 64u;
+    cj_upload_op_t* ops = (cj_upload_op_t*)realloc(q->ops, sizeof(*ops) * capacity);
+    if (!ops) return false;
+    cj_heap_note_alloc();
+    q->ops = ops;
+    q->op_capacity = capacity;
+  }
+  q->ops[q->op_count++] = *op;
+  return true;
+}
+
+cj_upload_queue_t* cj_upload_queue_create(VkDevice device, cj_gpu_allocator_t* gpu,
+                                          VkQueue graphics_queue, uint32_t graphics_family,
+                                          VkQueue transfer_queue, uint32_t transfer_family,
+                                          VkDeviceSize ring_size) {
+  if (device == VK_NULL_HANDLE || !gpu || graphics_queue == VK_NULL_HANDLE) return NULL;
+  cj_upload_queue_t* q = (cj_upload_queue_t*)calloc(1, sizeof(*q));
+  if (!q) return NULL;
+  q->device = device;
+  q->gpu = gpu;
+  q->graphics_queue = graphics_queue;
+  q->graphics_family = graphics_family;
+  q->dedicated_transfer = transfer_queue != VK_NULL_HANDLE && transfer_family != graphics_family;
+  q->transfer_queue = q->dedicated_transfer ? transfer_queue : graphics_queue;
+  q->transfer_family = q->dedicated_transfer ? transfer_family : graphics_family;
+  q->ring_size = ring_size ? ring_size : CJ_UPLOAD_RING_SIZE;
+
+  VkCommandPoolCreateInfo pci = {0};
+  pci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  pci.queueFamilyIndex = graphics_family;
+  bool ok = vkCreateCommandPool(device, &pci, NULL, &q->graphics_pool) == VK_SUCCESS;
+  if (ok && q->dedicated_transfer) {
+    pci.queueFamilyIndex = transfer_family;
+    ok = vkCreateCommandPool(device, &pci, NULL, &q->transfer_pool) == VK_SUCCESS;
+  }
+
+  for (uint32_t i = 0; ok && i < CJ_UPLOAD_SLOTS; i++) {
+    cj_upload_slot_t* slot = &q->slots[i];
+    VkCommandBufferAllocateInfo ai = {0};
+    ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = 1;
+    ai.commandPool = q->graphics_pool;
+    ok = vkAllocateCommandBuffers(device, &ai, &slot->graphics_cmd) == VK_SUCCESS;
+    if (ok && q->dedicated_transfer) {
+      ai.commandPool = q->transfer_pool;
+      ok = vkAllocateCommandBuffers(device, &ai, &slot->transfer_cmd) == VK_SUCCESS;
+    }
+    VkFenceCreateInfo fi = {0};
+    fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (ok) ok = vkCreateFence(device, &fi, NULL, &slot->fence) == VK_SUCCESS;
+    if (ok && q->dedicated_transfer) {
+      VkSemaphoreCreateInfo si = {0};
+      si.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+      ok = vkCreateSemaphore(device, &si, NULL, &slot->transfer_done) == VK_SUCCESS;
+    }
+  }
+
+  if (!ok) {
+    fprintf(stderr, "cj_upload_queue_create: failed to create command objects\n");
+    cj_upload_queue_destroy(q);
+    return NULL;
+  }
+  return q;
+}
+
+void cj_upload_queue_destroy(cj_upload_queue_t* q) {
+  if (!q) return;
+  while (q->completed < q->serial) upload_retire(q, true);
+
+  upload_release_staging(q, q->staging, q->staging_count);
+  free(q->ops);
+  free(q->barriers);
+  free(q->mips);
+  for (uint32_t i = 0; i < CJ_UPLOAD_SLOTS; i++) {
+    cj_upload_slot_t* slot = &q->slots[i];
+    if (slot->fence) vkDestroyFence(q->device, slot->fence, NULL);
+    if (slot->transfer_done) vkDestroySemaphore(q->device, slot->transfer_done, NULL);
+  }
+  /* Destroying the pools frees their command buffers */
+  if (q->transfer_pool) vkDestroyCommandPool(q->device, q->transfer_pool, NULL);
+  if (q->graphics_pool) vkDestroyCommandPool(q->device, q->graphics_pool, NULL);
+  cj_gpu_destroy_buffer(q->gpu, &q->ring, &q->ring_alloc);
+  free(q);
+}
+
+/* Find staging memory for op, which already names its destination, and queue it */
+static void* upload_stage(cj_upload_queue_t* q, cj_upload_op_t* op, VkDeviceSize size, VkDeviceSize align,
+                          uint64_t* out_ticket) {
+  void* ptr = NULL;
+  if (size > q->ring_size / 2) {
+    cj_upload_staging_t* list = (cj_upload_staging_t*)realloc(q->staging, sizeof(*list) * (q->staging_count + 1u));
+    if (!list) return NULL;
+    cj_heap_note_alloc();
+    q->staging = list;
+    cj_upload_staging_t* s = &list[q->staging_count];
+    memset(s, 0, sizeof(*s));
+    if (!cj_gpu_create_buffer(q->gpu, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              CJ_GPU_ALLOC_DEDICATED, &s->buffer, &s->alloc)) {
+      fprintf(stderr, "cj_upload_queue: failed to create %llu byte staging buffer\n", (unsigned long long)size);
+      return NULL;
+    }
+    q->staging_count++;
+    op->src = s->buffer;
+    ptr = s->alloc.mapped;
+  } else {
+    if (!upload_ring_create(q)) return NULL;
+    /* Make room by submitting what is pending, then by waiting for the oldest submission */
+    while (!upload_ring_reserve(q, size, align, &op->src_offset)) {
+      if (q->op_count > 0) {
+        /* A flush that could not take the ops frees no ring space */
+        uint64_t serial = q->serial;
+        if (cj_upload_queue_flush(q) == serial) return NULL;
+      } else if (q->completed < q->serial) upload_retire(q, true);
+      else return NULL;
+    }
+    op->src = q->ring;
+    ptr = (char*)q->ring_alloc.mapped + op->src_offset;
+  }
+
+  if (!upload_push_op(q, op)) return NULL;
+  if (out_ticket) *out_ticket = q->serial + 1;
+  return ptr;
+}
+
+void* cj_upload_queue_stage_image(cj_upload_queue_t* q, const cj_upload_image_t* dst, uint64_t* out_ticket) {
+  if (!q || !dst || dst->image == VK_NULL_HANDLE || dst->texel_size == 0) return NULL;
+  /* Compressed formats are copied as whole blocks, partial ones at the edges included */
+  uint32_t bw = dst->block_width ? dst->block_width : 1u;
+  uint32_t bh = dst->block_height ? dst->block_height : 1u;
+  VkDeviceSize size = (VkDeviceSize)((dst->extent.width + bw - 1) / bw) * ((dst->extent.height + bh - 1) / bh) *
+                      (dst->extent.depth ? dst->extent.depth : 1u) * dst->texel_size;
+  if (size == 0) return NULL;
+
+  VkDeviceSize align = CJ_UPLOAD_ALIGN;
+  while (align % dst->texel_size) align += CJ_UPLOAD_ALIGN;
+
+  cj_upload_op_t op = {0};
+  op.dst = *dst;
+  if (op.dst.extent.depth == 0) op.dst.extent.depth = 1;
+  op.size = size;
+  return upload_stage(q, &op, size, align, out_ticket);
+}
+
+void* cj_upload_queue_stage_buffer(cj_upload_queue_t* q, VkBuffer dst, VkDeviceSize offset, VkDeviceSize size,
+                                   uint64_t* out_ticket) {
+  if (!q || dst == VK_NULL_HANDLE || size == 0) return NULL;
+  cj_upload_op_t op = {0};
+  op.dst_buffer = dst;
+  op.dst_offset = offset;
+  op.size = size;
+  return upload_stage(q, &op, size, CJ_UPLOAD_ALIGN, out_ticket);
+}
+
+bool cj_upload_queue_generate_mips(cj_upload_queue_t* q, const cj_upload_mips_t* mips, uint64_t* out_ticket) {
+  if (!q || !mips || mips->image == VK_NULL_HANDLE) return false;
+  if (out_ticket) *out_ticket = q->serial + 1;
+  if (mips->levels < 2) return true;
+  for (uint32_t i = 0; i < q->mips_count; i++) {
+    if (q->mips[i].image == mips->image && q->mips[i].array_layer == mips->array_layer) {
+      q->mips[i] = *mips;
+      return true;
+    }
+  }
+  if (q->mips_count == q->mips_capacity) {
+    uint32_t capacity = q->mips_capacity ? q->mips_capacity * 2u : 16u;
+    cj_upload_mips_t* list = (cj_upload_mips_t*)realloc(q->mips, sizeof(*list) * capacity);
+    if (!list) return false;
+    cj_heap_note_alloc();
+    q->mips = list;
+    q->mips_capacity = capacity;
+  }
+  q->mips[q->mips_count++] = *mips;
+  return true;
+}
+
+/* Record the pending mip chains on the graphics queue, after the copies. Mip 0 becomes the
+ * first blit source and the smaller levels are discarded; each level is then blitted from the
+ * one above it and becomes the next source. Every level ends up in the layout of mip 0. */
+static void upload_record_mips(cj_upload_queue_t* q, VkCommandBuffer cmd) {
+  for (uint32_t i = 0; i < q->mips_count; i++) {
+    const cj_upload_mips_t* m = &q->mips[i];
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    upload_layout_scope(m->layout, &stage, &access);
+
+    VkImageMemoryBarrier b[2];
+    memset(b, 0, sizeof(b));
+    for (uint32_t k = 0; k < 2; k++) {
+      b[k].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      b[k].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      b[k].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      b[k].image = m->image;
+      b[k].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      b[k].subresourceRange.baseArrayLayer = m->array_layer;
+      b[k].subresourceRange.layerCount = 1;
+    }
+    b[0].subresourceRange.baseMipLevel = 0;
+    b[0].subresourceRange.levelCount = 1;
+    b[0].oldLayout = m->layout;
+    b[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    b[0].srcAccessMask = access;
+    b[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    /* The source stage also orders the blits after earlier frames that sampled the levels */
+    b[1].subresourceRange.baseMipLevel = 1;
+    b[1].subresourceRange.levelCount = m->levels - 1u;
+    b[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    b[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    b[1].srcAccessMask = 0;
+    b[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, stage, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 2, b);
+
+    int32_t w = (int32_t)m->extent.width, h = (int32_t)m->extent.height;
+    for (uint32_t level = 1; level < m->levels; level++) {
+      VkImageBlit blit = {0};
+      blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      blit.srcSubresource.mipLevel = level - 1u;
+      blit.srcSubresource.baseArrayLayer = m->array_layer;
+      blit.srcSubresource.layerCount = 1;
+      blit.srcOffsets[1].x = w;
+      blit.srcOffsets[1].y = h;
+      blit.srcOffsets[1].z = 1;
+      w = w > 1 ? w / 2 : 1;
+      h = h > 1 ? h / 2 : 1;
+      blit.dstSubresource = blit.srcSubresource;
+      blit.dstSubresource.mipLevel = level;
+      blit.dstOffsets[1].x = w;
+      blit.dstOffsets[1].y = h;
+      blit.dstOffsets[1].z = 1;
+      vkCmdBlitImage(cmd, m->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m->image,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, m->filter);
+
+      b[1].subresourceRange.baseMipLevel = level;
+      b[1].subresourceRange.levelCount = 1;
+      b[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      b[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      b[1].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      b[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           0, 0, NULL, 0, NULL, 1, &b[1]);
+    }
+
+    b[0].subresourceRange.levelCount = m->levels;
+    b[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    b[0].newLayout = m->layout;
+    b[0].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    b[0].dstAccessMask = access;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, stage, 0, 0, NULL, 0, NULL, 1, &b[0]);
+  }
+}
+
+/* Record the pending copies for one queue: layout barriers, copies, then final barriers.
+ * Copies into the same subresource share one barrier pair. Buffer copies always run on the
+ * graphics queue and share one memory barrier that makes them visible to vertex input and shaders. */
+static void upload_record(cj_upload_queue_t* q, VkCommandBuffer cmd, bool on_transfer,
+                          const bool* use_transfer, VkImageMemoryBarrier* pre, VkImageMemoryBarrier* post) {
+  uint32_t pre_count = 0, post_count = 0;
+  VkPipelineStageFlags pre_src = 0, pre_dst = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  VkPipelineStageFlags post_src = VK_PIPELINE_STAGE_TRANSFER_BIT, post_dst = 0;
+
+  bool buffer_copies = false;
+
+  for (uint32_t i = 0; i < q->op_count; i++) {
+    const cj_upload_image_t* d = &q->ops[i].dst;
+    if (d->image == VK_NULL_HANDLE) {
+      buffer_copies = buffer_copies || !on_transfer;
+      continue;
+    }
+    bool first = true, last = true;
+    for (uint32_t j = 0; j < q->op_count && (first || last); j++) {
+      if (j == i || !upload_same_subresource(d, &q->ops[j].dst)) continue;
+      if (j < i) first = false;
+      else last = false;
+    }
+
+    VkImageMemoryBarrier b = {0};
+    b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = d->image;
+    b.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    b.subresourceRange.baseMipLevel = d->mip_level;
+    b.subresourceRange.levelCount = 1;
+    b.subresourceRange.baseArrayLayer = d->array_layer;
+    b.subresourceRange.layerCount = 1;
+
+    VkPipelineStageFlags stage;
+    VkAccessFlags access;
+    if (use_transfer[i] == on_transfer) {
+      if (first) {
+        b.oldLayout = d->old_layout;
+        b.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        upload_layout_scope(d->old_layout, &stage, &access);
+        b.srcAccessMask = access;
+        b.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        pre_src |= stage;
+        pre[pre_count++] = b;
+      }
+      if (last) {
+        b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        b.newLayout = d->new_layout;
+        b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        if (on_transfer && q->dedicated_transfer) {
+          /* Release to the graphics family; the acquire half carries the real destination */
+          b.srcQueueFamilyIndex = q->transfer_family;
+          b.dstQueueFamilyIndex = q->graphics_family;
+          b.dstAccessMask = 0;
+          post_dst |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        } else {
+          upload_layout_scope(d->new_layout, &stage, &access);
+          b.dstAccessMask = access;
+          post_dst |= stage;
+        }
+        post[post_count++] = b;
+      }
+    } else if (!on_transfer && last) {
+      /* Acquire what the transfer queue released; ordered after its semaphore */
+      b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      b.newLayout = d->new_layout;
+      b.srcQueueFamilyIndex = q->transfer_family;
+      b.dstQueueFamilyIndex = q->graphics_family;
+      upload_layout_scope(d->new_layout, &stage, &access);
+      b.dstAccessMask = access;
+      pre_src |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+      pre_dst |= stage;
+      pre[pre_count++] = b;
+    }
+  }
+
+  VkCommandBufferBeginInfo bi = {0};
+  bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  vkResetCommandBuffer(cmd, 0);
+  vkBeginCommandBuffer(cmd, &bi);
+  if (pre_count > 0) {
+    vkCmdPipelineBarrier(cmd, pre_src, pre_dst, 0, 0, NULL, 0, NULL, pre_count, pre);
+  }
+  for (uint32_t i = 0; i < q->op_count; i++) {
+    if (use_transfer[i] != on_transfer) continue;
+    const cj_upload_op_t* op = &q->ops[i];
+    if (op->dst.image == VK_NULL_HANDLE) {
+      VkBufferCopy copy = {0};
+      copy.srcOffset = op->src_offset;
+      copy.dstOffset = op->dst_offset;
+      copy.size = op->size;
+      vkCmdCopyBuffer(cmd, op->src, op->dst_buffer, 1, &copy);
+      continue;
+    }
+    VkBufferImageCopy region = {0};
+    region.bufferOffset = op->src_offset;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = op->dst.mip_level;
+    region.imageSubresource.baseArrayLayer = op->dst.array_layer;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = op->dst.offset;
+    region.imageExtent = op->dst.extent;
+    vkCmdCopyBufferToImage(cmd, op->src, op->dst.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+  }
+  VkMemoryBarrier buffer_barrier = {0};
+  if (buffer_copies) {
+    buffer_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    buffer_barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                   VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    post_dst |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+  }
+  if (post_count > 0 || buffer_copies) {
+    vkCmdPipelineBarrier(cmd, post_src, post_dst, 0, buffer_copies ? 1u : 0u, &buffer_barrier,
+                         0, NULL, post_count, post);
+  }
+  if (!on_transfer) upload_record_mips(q, cmd);
+  vkEndCommandBuffer(cmd);
+}
+
+/*
+ * The graphics half of a flush failed after its transfer half was submitted. The
+ * transfer copies still read the ring and signal transfer_done, so a batch that only
+ * waits for the semaphore takes the slot's fence in their place; the images they
+ * released are never acquired and hold undefined contents. If even that batch fails,
+ * the transfer queue is drained and the semaphore, left signaled, is replaced.
+ * Returns whether the fence was submitted.
+ */
+static bool upload_wait_transfer(cj_upload_queue_t* q, cj_upload_slot_t* slot) {
+  static const VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  VkSubmitInfo si = {0};
+  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  si.waitSemaphoreCount = 1;
+  si.pWaitSemaphores = &slot->transfer_done;
+  si.pWaitDstStageMask = &wait_stage;
+  if (vkQueueSubmit(q->graphics_queue, 1, &si, slot->fence) == VK_SUCCESS) return true;
+
+  vkQueueWaitIdle(q->transfer_queue);
+  vkDestroySemaphore(q->device, slot->transfer_done, NULL);
+  VkSemaphoreCreateInfo ci = {0};
+  ci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  if (vkCreateSemaphore(q->device, &ci, NULL, &slot->transfer_done) != VK_SUCCESS) {
+    /* The slot's copies stay on the graphics queue from now on */
+    slot->transfer_done = VK_NULL_HANDLE;
+  }
+  return false;
+}
+
+uint64_t cj_upload_queue_flush(cj_upload_queue_t* q) {
+  if (!q) return 0;
+  if (q->op_count == 0 && q->mips_count == 0) return q->serial;
+
+  uint64_t serial = q->serial + 1;
+  cj_upload_slot_t* slot = &q->slots[(serial - 1) % CJ_UPLOAD_SLOTS];
+  while (q->completed + CJ_UPLOAD_SLOTS < serial) upload_retire(q, true);
+
+  /* Scratch grows with the op array and is kept, so steady flushes do not allocate */
+  if (q->barrier_capacity < q->op_capacity || !q->barriers) {
+    uint32_t capacity = q->op_capacity ? q->op_capacity : 1u;
+    void* barriers = realloc(q->barriers, (sizeof(VkImageMemoryBarrier) * 2u + sizeof(bool)) * capacity);
+    if (!barriers) {
+      fprintf(stderr, "cj_upload_queue_flush: out of memory for %u copies\n", q->op_count);
+      return q->serial;
+    }
+    cj_heap_note_alloc();
+    q->barriers = barriers;
+    q->barrier_capacity = capacity;
+  }
+  VkImageMemoryBarrier* pre = (VkImageMemoryBarrier*)q->barriers;
+  VkImageMemoryBarrier* post = pre + q->barrier_capacity;
+  bool* use_transfer = (bool*)(void*)(post + q->barrier_capacity);
+
+  /* A subresource whose first copy discards its contents can be filled on the transfer queue */
+  uint32_t transfer_ops = 0;
+  for (uint32_t i = 0; i < q->op_count; i++) {
+    use_transfer[i] = false;
+    if (!q->dedicated_transfer || slot->transfer_done == VK_NULL_HANDLE || q->ops[i].dst.image == VK_NULL_HANDLE) continue;
+    uint32_t first = i;
+    for (uint32_t j = 0; j < i; j++) {
+      if (upload_same_subresource(&q->ops[i].dst, &q->ops[j].dst)) { first = j; break; }
+    }
+    use_transfer[i] = (first == i) ? (q->ops[i].dst.old_layout == VK_IMAGE_LAYOUT_UNDEFINED) : use_transfer[first];
+    if (use_transfer[i]) transfer_ops++;
+  }
+
+  bool ok = true, transferred = false;
+  if (transfer_ops > 0) {
+    upload_record(q, slot->transfer_cmd, true, use_transfer, pre, post);
+    VkSubmitInfo si = {0};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &slot->transfer_cmd;
+    si.signalSemaphoreCount = 1;
+    si.pSignalSemaphores = &slot->transfer_done;
+    ok = transferred = vkQueueSubmit(q->transfer_queue, 1, &si, VK_NULL_HANDLE) == VK_SUCCESS;
+  }
+
+  if (ok) {
+    upload_record(q, slot->graphics_cmd, false, use_transfer, pre, post);
+    static const VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkSubmitInfo si = {0};
+    si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    if (transfer_ops > 0) {
+      si.waitSemaphoreCount = 1;
+      si.pWaitSemaphores = &slot->transfer_done;
+      si.pWaitDstStageMask = &wait_stage;
+    }
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &slot->graphics_cmd;
+    ok = vkQueueSubmit(q->graphics_queue, 1, &si, slot->fence) == VK_SUCCESS;
+  }
+
+  bool submitted = ok;
+  if (!ok) {
+    fprintf(stderr, "cj_upload_queue_flush: failed to submit %u copies\n", q->op_count);
+    if (transferred) submitted = upload_wait_transfer(q, slot);
+  }
+
+  /* A failed submission retires immediately so its ring space and ticket are not stuck */
+  slot->serial = serial;
+  slot->submitted = submitted;
+  slot->ring_end = q->head;
+  slot->staging = q->staging;
+  slot->staging_count = q->staging_count;
+  q->staging = NULL;
+  q->staging_count = 0;
+  q->op_count = 0;
+  q->mips_count = 0;
+  q->ring_pending = false;
+  q->serial = serial;
+  return serial;
+}
+
+bool cj_upload_queue_done(cj_upload_queue_t* q, uint64_t ticket) {
+  if (!q || ticket == 0 || ticket <= q->completed) return true;
+  if (ticket > q->serial) return false;
+  upload_retire(q, false);
+  return ticket <= q->completed;
+}
+
+void cj_upload_queue_wait(cj_upload_queue_t* q, uint64_t ticket) {
+  if (!q || ticket == 0) return;
+  if (ticket > q->serial) cj_upload_queue_flush(q);
+  while (q->completed < ticket && q->completed < q->serial) upload_retire(q, true);
+}
+
+void cj_upload_queue_discard_image(cj_upload_queue_t* q, VkImage image) {
+  if (!q || image == VK_NULL_HANDLE) return;
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < q->op_count; i++) {
+    if (q->ops[i].dst.image != image) q->ops[kept++] = q->ops[i];
+  }
+  q->op_count = kept;
+  kept = 0;
+  for (uint32_t i = 0; i < q->mips_count; i++) {
+    if (q->mips[i].image != image) q->mips[kept++] = q->mips[i];
+  }
+  q->mips_count = kept;
+}
+
+void cj_upload_queue_discard_buffer(cj_upload_queue_t* q, VkBuffer buffer) {
+  if (!q || buffer == VK_NULL_HANDLE) return;
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < q->op_count; i++) {
+    if (q->ops[i].dst_buffer != buffer) q->ops[kept++] = q->ops[i];
+  }
+  q->op_count = kept;
+}
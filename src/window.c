@@ -19,6 +19,7 @@ extern Display* display; /* provided by main on Linux */
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <cjelly/cj_window.h>
 #include <cjelly/cj_platform.h>
 #include <cjelly/runtime.h>
@@ -28,11 +29,43 @@ extern Display* display; /* provided by main on Linux */
 #include <cjelly/textured_internal.h>
 #include <cjelly/cj_rgraph.h>
 #include <cjelly/window_internal.h>
+#include <cjelly/frame_pacer_internal.h>
+#include <cjelly/profiler_internal.h>
+#include <cjelly/rgraph_internal.h>
+#include <cjelly/cj_profiler.h>
 #include <cjelly/cj_input.h>
+#include <cjelly/input_queue_internal.h>
+#include <cjelly/arena_internal.h>
 
 /* Forward declarations */
 typedef struct CJPlatformWindow CJPlatformWindow;
 
+/* Swapchain resources kept alive after recreation until the GPU is done with them */
+typedef struct CJRetiredSwapchain {
+  VkSwapchainKHR swapChain;
+  uint32_t imageCount;
+  VkImage * images;
+  VkImageView * imageViews;
+  VkFramebuffer * framebuffers;
+  VkCommandBuffer * commandBuffers;
+  VkSemaphore * renderFinishedSemaphores; /* Present waits that may still be pending on the old images */
+  uint64_t lastUseSerial;                 /* Submission serial that last referenced these resources */
+  struct CJRetiredSwapchain * next;
+} CJRetiredSwapchain;
+
+/* Rectangles cj_window_mark_dirty_rect() keeps per frame; further ones merge into the closest */
+#define CJ_WINDOW_MAX_DIRTY_RECTS 8u
+
+/* Render graph commands recorded into a secondary buffer, replayed while the key matches */
+typedef struct CJGraphRecording {
+  VkCommandBuffer cmd;                    /* Secondary command buffer owned by the ring slot */
+  const cj_rgraph_t * graph;              /* Graph the commands were recorded from */
+  uint64_t version;                       /* cj_rgraph_content_version() at record time */
+  VkExtent2D extent;
+  VkRenderPass renderPass;
+  bool valid;
+} CJGraphRecording;
+
 /* Platform window struct - defined early so window procedure can access it */
 typedef struct CJPlatformWindow {
 #ifdef _WIN32
@@ -47,15 +80,63 @@ typedef struct CJPlatformWindow {
   VkImageView * swapChainImageViews;
   VkFramebuffer * swapChainFramebuffers;
   VkCommandBuffer * commandBuffers;
-  VkSemaphore imageAvailableSemaphore;
-  VkSemaphore renderFinishedSemaphore;
-  VkFence inFlightFence;
+
+  /* Per-frame sync ring (sized by cj_window_desc_t.frames_in_flight) */
+  uint32_t framesInFlight;                /* Number of frames the CPU may record ahead of the GPU */
+  uint32_t currentFrame;                  /* Ring index of the frame being recorded */
+  VkSemaphore * imageAvailableSemaphores; /* [framesInFlight] Signaled when the acquired image is ready */
+  VkSemaphore * renderFinishedSemaphores; /* [renderFinishedCount] Per swapchain image; signaled when rendering completes, waited on by present */
+  uint32_t renderFinishedCount;           /* Images the present semaphores were created for */
+  VkFence * inFlightFences;               /* [framesInFlight] Signaled when the frame's submission retires */
+  VkCommandPool framePool;                /* Owns the ring's command buffers, so one thread at a time can record the window */
+  VkCommandBuffer * frameCommandBuffers;  /* [framesInFlight] Re-recorded each frame by the render graph path */
+  CJGraphRecording * graphRecordings;     /* [framesInFlight] Cached secondaries for static render graphs */
+  uint32_t * imagesInFlight;              /* [swapChainImageCount] Ring slot + 1 of the frame last using each image, 0 if none */
+  uint64_t * frameSerials;                /* [framesInFlight] Submission serial last made from each slot */
+  uint64_t * frameBatchSerials;           /* [framesInFlight] Engine batch that carried the slot's submission, 0 if its own fence did */
+  uint64_t submitSerial;                  /* Serial of the most recent submission */
+  uint64_t completedSerial;               /* Highest serial known to have finished on the GPU */
+  CJRetiredSwapchain * retiredSwapchains; /* Old swapchains awaiting completedSerial >= lastUseSerial */
+  bool framePending;                      /* A frame was recorded and awaits submission */
+  uint32_t pendingImageIndex;             /* Acquired image of the pending frame */
+  VkCommandBuffer pendingCmd;             /* Primary command buffer of the pending frame */
+  cj_rgraph_t * pendingGraph;             /* Graph recorded into pendingCmd, NULL for a pre-recorded buffer */
+  /* Semaphores of the submission being built: the acquired image and the graph's async compute timeline */
+  VkSemaphore submitWaits[2];
+  VkPipelineStageFlags submitWaitStages[2];
+  uint64_t submitWaitValues[2];
+  VkSemaphore submitSignals[2];
+  uint64_t submitSignalValues[2];
+  VkTimelineSemaphoreSubmitInfo submitTimeline;
   VkExtent2D swapChainExtent;
+  cj_present_mode_t presentModePref;      /* Present mode requested at creation */
+  VkPresentModeKHR presentMode;           /* Present mode the current swapchain uses */
+  cj_surface_format_t surfaceFormatPref;  /* Color format requested at creation */
+  VkSurfaceFormatKHR surfaceFormat;       /* Format and color space the current swapchain uses */
+  VkRenderPass renderPass;                /* Engine passes for surfaceFormat.format, looked up on the main thread */
+  VkRenderPass partialRenderPass;         /* Keeps the image outside the render area; may be VK_NULL_HANDLE */
   int width;
   int height;
   int updateMode;
   uint32_t fixedFramerate;
   int needsRedraw;
+  /* Partial redraws (framebuffer pixels) */
+  VkRect2D dirtyRects[CJ_WINDOW_MAX_DIRTY_RECTS]; /* Marked since the last rendered frame */
+  uint32_t dirtyRectCount;
+  bool dirtyPartial;                      /* The pending redraw is limited to dirtyRects */
+  VkRectLayerKHR frameRects[CJ_WINDOW_MAX_DIRTY_RECTS]; /* Clipped damage of the frame being rendered */
+  uint32_t frameRectCount;                /* 0 = the whole frame changed */
+  VkRect2D * imageDamage;                 /* [swapChainImageCount] Area each image misses from later frames */
+  /* Frame pacing */
+  cj_frame_timing_t timing;               /* Smoothed frame delta, refresh and present feedback */
+  uint32_t presentId;                     /* presentID of the latest present (VK_GOOGLE_display_timing) */
+  PFN_vkGetPastPresentationTimingGOOGLE getPastPresentationTiming; /* NULL without display timing */
+  /* Profiling */
+  cj_gpu_timer_t * gpuTimers;             /* [framesInFlight] Timestamps of each slot's frame, NULL until profiled */
+  bool gpuTimersUnsupported;              /* The graphics queue writes no timestamps */
+  uint64_t frameBeginUs;                  /* cj_window_begin_frame() of the frame being built, 0 = not profiled */
+  uint64_t frameBeginIndex;               /* Frame index of frameBeginUs */
+  cj_profiler_frame_stats_t profileStats; /* Latest CPU and GPU frame timings */
   uint64_t nextFrameTime;
   bool is_minimized;  /* Cached minimized state (updated via window messages) */
   bool needs_swapchain_recreate;  /* Flag to defer swapchain recreation until next frame */
@@ -104,9 +185,24 @@ struct cj_window_t {
   uint32_t max_fps;  /* Maximum FPS for this window (0 = unlimited) */
   uint64_t last_render_time_us;  /* Last render time in microseconds (for FPS limiting) */
   cj_render_reason_t pending_render_reason;  /* Reason why window needs to render (if dirty) */
-  bool is_destroyed;  /* Flag to prevent double-destruction */
+  atomic_bool redraw_posted;  /* Set by cj_window_post_redraw() from any thread, consumed by the event loop */
+  /* Input from the platform layer, delivered once per frame (NULL = delivered as it arrives) */
+  cj_input_queue_t* input;
+  bool frame_queued;  /* Waiting in the open engine frame for cj_engine_end_frame() */
+  atomic_bool destroy_requested;  /* cj_window_destroy() from the input thread; done by the next poll */
+  atomic_bool is_destroyed;  /* Flag to prevent double-destruction; the input thread reads it */
 };
 
+/* Windows cj_window_execute() queued between cj_engine_begin_frame() and cj_engine_end_frame() */
+typedef struct {
+  cj_engine_t * engine;   /* NULL while no frame is open */
+  cj_window_t ** windows;
+  uint32_t count;
+  uint32_t capacity;      /* Kept across frames, so steady frames do not allocate */
+} cj_engine_frame_t;
+
+static cj_engine_frame_t g_engine_frame;
+
 /* Forward declarations for platform helpers - needed by window procedure */
 static void plat_cleanupWindow(CJPlatformWindow * win);
 static void plat_createSwapChainForWindow(CJPlatformWindow * win);
@@ -114,6 +210,10 @@ static void plat_recreateSwapChainForWindow(CJPlatformWindow * win);
 static bool plat_createImageViewsForWindow(CJPlatformWindow * win);
 static bool plat_createFramebuffersForWindow(CJPlatformWindow * win);
 static bool createTexturedCommandBuffersForWindowCtx(CJPlatformWindow * win, const CJellyVulkanContext* ctx);
+static bool plat_resetImageFenceTracking(CJPlatformWindow * win);
+static void plat_markFullRedraw(CJPlatformWindow * win);
+static void plat_queryDisplayTiming(CJPlatformWindow * win);
+static void window_deliverInput(void * target, const cj_input_event_t * event);
 
 /* Keycode mapping functions */
 #ifdef _WIN32
@@ -565,7 +665,7 @@ static LRESULT CALLBACK CjWndProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lP
             cj_window__set_minimized(window, false);
             new_state = CJ_WINDOW_STATE_NORMAL;
             /* Mark window dirty when restored from minimized */
-            window->plat->needsRedraw = 1;
+            plat_markFullRedraw(window->plat);
             window->pending_render_reason = CJ_RENDER_REASON_EXPOSE;
           }
 
@@ -1044,24 +1144,30 @@ typedef struct MonitorDPI {
   bool valid;             /* True if DPI was successfully calculated */
 } MonitorDPI;
 
+/* Built once, then rebuilt only when RandR reports a change; lookups never talk to the server */
 static MonitorDPI* monitor_dpis = NULL;
 static int monitor_dpi_count = 0;
+static bool monitor_dpis_built = false;  /* Also true when XRandR is missing and the table stays empty */
+static int monitor_last_hit = 0;         /* Monitor the previous lookup landed on */
+#if HAVE_XRANDR_HEADERS
+static int randr_event_base = -1;        /* -1 until RandR events are selected */
+static bool monitor_dpis_dirty = false;  /* A change was reported since the table was built */
+#endif
 
 /**
  * @brief Query all monitors and cache their DPI
  * @param display X11 display
  * @param root Root window
+ *
+ * Uses XRRGetScreenResourcesCurrent, which returns the server's current
+ * configuration without making it poll the outputs. The new table replaces the
+ * old one only once it is complete.
  */
 static void refresh_monitor_dpis(Display* display, Window root) {
   (void)display;  /* May be unused if XRandR not available */
   (void)root;     /* May be unused if XRandR not available */
 
-  /* Free old cache */
-  if (monitor_dpis) {
-    free(monitor_dpis);
-    monitor_dpis = NULL;
-    monitor_dpi_count = 0;
-  }
+  monitor_dpis_built = true;
 
 #if HAVE_XRANDR_HEADERS
   /* Check if XRandR is available */
@@ -1069,25 +1175,24 @@ static void refresh_monitor_dpis(Display* display, Window root) {
   if (!XRRQueryExtension(display, &event_base, &error_base)) {
     return;  /* XRandR not available */
   }
-#else
-  return;  /* XRandR headers not available */
-#endif
 
-#if HAVE_XRANDR_HEADERS
+  /* Hear about monitors being added, removed, moved or resized from now on */
+  if (randr_event_base < 0) {
+    XRRSelectInput(display, root, RRScreenChangeNotifyMask | RRCrtcChangeNotifyMask);
+    randr_event_base = event_base;
+  }
+
   /* Get screen resources */
-  XRRScreenResources* res = XRRGetScreenResources(display, root);
+  XRRScreenResources* res = XRRGetScreenResourcesCurrent(display, root);
   if (!res) return;
-#else
-  return;
-#endif
 
-#if HAVE_XRANDR_HEADERS
   /* Allocate cache */
-  monitor_dpis = calloc(res->noutput, sizeof(MonitorDPI));
-  if (!monitor_dpis) {
+  MonitorDPI* monitors = calloc(res->noutput > 0 ? (size_t)res->noutput : 1u, sizeof(MonitorDPI));
+  if (!monitors) {
     XRRFreeScreenResources(res);
     return;
   }
+  int count = 0;
 
   /* Query each output */
   for (int i = 0; i < res->noutput; i++) {
@@ -1101,7 +1206,7 @@ static void refresh_monitor_dpis(Display* display, Window root) {
     if (output->crtc != None) {
       XRRCrtcInfo* crtc = XRRGetCrtcInfo(display, res, output->crtc);
       if (crtc) {
-        MonitorDPI* m = &monitor_dpis[monitor_dpi_count];
+        MonitorDPI* m = &monitors[count];
         m->x = crtc->x;
         m->y = crtc->y;
         m->width = crtc->width;
@@ -1122,7 +1227,7 @@ static void refresh_monitor_dpis(Display* display, Window root) {
           m->valid = false;
         }
 
-        monitor_dpi_count++;
+        count++;
         XRRFreeCrtcInfo(crtc);
       }
     }
@@ -1131,9 +1236,53 @@ static void refresh_monitor_dpis(Display* display, Window root) {
   }
 
   XRRFreeScreenResources(res);
+
+  /* Swap in the new table */
+  free(monitor_dpis);
+  monitor_dpis = monitors;
+  monitor_dpi_count = count;
+  monitor_last_hit = 0;
+#endif
+}
+
+bool cj_window__handle_randr_event_linux(Display* display, const XEvent* event) {
+  (void)display;
+  (void)event;
+#if HAVE_XRANDR_HEADERS
+  if (randr_event_base < 0 || !event) return false;
+  if (event->type == randr_event_base + RRScreenChangeNotify) {
+    /* Keeps Xlib's idea of the screen size current */
+    XRRUpdateConfiguration((XEvent*)event);
+  } else if (event->type != randr_event_base + RRNotify ||
+             ((const XRRNotifyEvent*)event)->subtype != RRNotify_CrtcChange) {
+    return false;
+  }
+  /* One reconfiguration sends an event per screen and CRTC; the table is rebuilt once after the batch */
+  monitor_dpis_dirty = true;
+  return true;
+#else
+  return false;
 #endif
 }
 
+bool cj_window__refresh_monitors_linux(Display* display) {
+  (void)display;
+#if HAVE_XRANDR_HEADERS
+  if (!monitor_dpis_dirty) return false;
+  monitor_dpis_dirty = false;
+  refresh_monitor_dpis(display, DefaultRootWindow(display));
+  return true;
+#else
+  return false;
+#endif
+}
+
+/* True if (x, y) lies on monitor m */
+static bool monitor_contains(const MonitorDPI* m, int32_t x, int32_t y) {
+  return x >= m->x && x < m->x + (int32_t)m->width &&
+         y >= m->y && y < m->y + (int32_t)m->height;
+}
+
 /**
  * @brief Get DPI scale for a window based on its position
  * @param display X11 display
@@ -1141,10 +1290,14 @@ static void refresh_monitor_dpis(Display* display, Window root) {
  * @param win_x Window X position
  * @param win_y Window Y position
  * @return DPI scale factor (1.0 = 96 DPI)
+ *
+ * Only the first call queries the server. A moving window stays on the monitor
+ * it was last found on almost every time, so that one is tested first; the
+ * handful of others are only scanned when it leaves.
  */
 float cj_window__get_dpi_scale_linux(Display* display, Window root, int32_t win_x, int32_t win_y) {
-  /* Refresh monitor cache if needed */
-  if (!monitor_dpis) {
+  /* Build the monitor cache on first use */
+  if (!monitor_dpis_built) {
     refresh_monitor_dpis(display, root);
   }
 
@@ -1152,12 +1305,16 @@ float cj_window__get_dpi_scale_linux(Display* display, Window root, int32_t win_
   int32_t win_center_x = win_x;  /* Window position is top-left, use center for better matching */
   int32_t win_center_y = win_y;
 
+  if (monitor_last_hit < monitor_dpi_count &&
+      monitor_contains(&monitor_dpis[monitor_last_hit], win_center_x, win_center_y)) {
+    return monitor_dpis[monitor_last_hit].dpi_scale;
+  }
+
   /* Find matching monitor */
   for (int i = 0; i < monitor_dpi_count; i++) {
-    MonitorDPI* m = &monitor_dpis[i];
-    if (win_center_x >= m->x && win_center_x < m->x + (int32_t)m->width &&
-        win_center_y >= m->y && win_center_y < m->y + (int32_t)m->height) {
-      return m->dpi_scale;
+    if (monitor_contains(&monitor_dpis[i], win_center_x, win_center_y)) {
+      monitor_last_hit = i;
+      return monitor_dpis[i].dpi_scale;
     }
   }
 
@@ -1307,6 +1464,88 @@ static void plat_createSurfaceForWindow(CJPlatformWindow * win) {
 #endif
 }
 
+/* Surface present modes are tried in this order for each preference; FIFO is
+ * always supported, so every list ends with it. */
+static VkPresentModeKHR plat_choosePresentMode(CJPlatformWindow * win) {
+  static const VkPresentModeKHR order_vsync[] = { VK_PRESENT_MODE_FIFO_KHR };
+  static const VkPresentModeKHR order_relaxed[] = { VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR };
+  static const VkPresentModeKHR order_mailbox[] = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR };
+  static const VkPresentModeKHR order_immediate[] = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+
+  const VkPresentModeKHR * order = order_vsync;
+  uint32_t order_count = 1;
+  switch (win->presentModePref) {
+    case CJ_PRESENT_VSYNC_RELAXED: order = order_relaxed; order_count = 2; break;
+    case CJ_PRESENT_MAILBOX: order = order_mailbox; order_count = 3; break;
+    case CJ_PRESENT_IMMEDIATE: order = order_immediate; order_count = 3; break;
+    case CJ_PRESENT_VSYNC:
+    default: break;
+  }
+
+  VkPhysicalDevice phys = cj_engine_physical_device(cj_engine_get_current());
+  VkPresentModeKHR supported[16];
+  uint32_t supported_count = (uint32_t)(sizeof(supported) / sizeof(supported[0]));
+  VkResult res = vkGetPhysicalDeviceSurfacePresentModesKHR(phys, win->surface, &supported_count, supported);
+  if (res != VK_SUCCESS && res != VK_INCOMPLETE) return VK_PRESENT_MODE_FIFO_KHR;
+
+  for (uint32_t i = 0; i < order_count; i++) {
+    for (uint32_t j = 0; j < supported_count; j++) {
+      if (supported[j] == order[i]) return order[i];
+    }
+  }
+  return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+/* 10-bit request first (if any), then 8-bit sRGB, then whatever the surface lists first */
+static VkSurfaceFormatKHR plat_chooseSurfaceFormat(CJPlatformWindow * win) {
+  static const VkFormat order_10bit[] = { VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_FORMAT_A2R10G10B10_UNORM_PACK32 };
+  static const VkFormat order_default[] = { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB };
+  VkSurfaceFormatKHR fallback = { VK_FORMAT_B8G8R8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
+
+  VkPhysicalDevice phys = cj_engine_physical_device(cj_engine_get_current());
+  VkSurfaceFormatKHR supported[64];
+  uint32_t supported_count = (uint32_t)(sizeof(supported) / sizeof(supported[0]));
+  VkResult res = vkGetPhysicalDeviceSurfaceFormatsKHR(phys, win->surface, &supported_count, supported);
+  if ((res != VK_SUCCESS && res != VK_INCOMPLETE) || supported_count == 0) return fallback;
+  /* A single UNDEFINED entry means any format is fine */
+  if (supported_count == 1 && supported[0].format == VK_FORMAT_UNDEFINED) {
+    if (win->surfaceFormatPref == CJ_SURFACE_FORMAT_10BIT) fallback.format = order_10bit[0];
+    return fallback;
+  }
+
+  if (win->surfaceFormatPref == CJ_SURFACE_FORMAT_10BIT) {
+    for (uint32_t i = 0; i < 2; i++) {
+      for (uint32_t j = 0; j < supported_count; j++) {
+        if (supported[j].format == order_10bit[i] && supported[j].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) return supported[j];
+      }
+    }
+  }
+  for (uint32_t i = 0; i < 2; i++) {
+    for (uint32_t j = 0; j < supported_count; j++) {
+      if (supported[j].format == order_default[i] && supported[j].colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) return supported[j];
+    }
+  }
+  return supported[0];
+}
+
+/* Pick the swapchain format and cache the engine passes for it (main thread) */
+static void plat_selectSurfaceFormat(CJPlatformWindow * win) {
+  cj_engine_t* e = cj_engine_get_current();
+  win->surfaceFormat = plat_chooseSurfaceFormat(win);
+  cj_engine_ensure_render_pass(e, win->surfaceFormat.format);
+  win->renderPass = cj_engine_window_render_pass(e, win->surfaceFormat.format, false);
+  win->partialRenderPass = cj_engine_window_render_pass(e, win->surfaceFormat.format, true);
+}
+
+/* Mailbox needs a spare image to replace, so it targets triple buffering;
+ * FIFO modes target double buffering. Always kept within surface limits. */
+static uint32_t plat_chooseImageCount(const VkSurfaceCapabilitiesKHR * caps, VkPresentModeKHR mode) {
+  uint32_t count = (mode == VK_PRESENT_MODE_MAILBOX_KHR) ? 3u : 2u;
+  if (count < caps->minImageCount) count = caps->minImageCount;
+  if (caps->maxImageCount > 0 && count > caps->maxImageCount) count = caps->maxImageCount;
+  return count;
+}
+
 static void plat_createSwapChainForWindow(CJPlatformWindow * win) {
   if (!win) return;
   VkSurfaceCapabilitiesKHR caps; vkGetPhysicalDeviceSurfaceCapabilitiesKHR(cj_engine_physical_device(cj_engine_get_current()), win->surface, &caps);
@@ -1323,59 +1562,143 @@ static void plat_createSwapChainForWindow(CJPlatformWindow * win) {
 
   win->swapChainExtent.width = physical_width;
   win->swapChainExtent.height = physical_height;
-  VkSwapchainCreateInfoKHR ci = {0}; ci.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR; ci.surface = win->surface; ci.minImageCount = caps.minImageCount; ci.imageFormat = VK_FORMAT_B8G8R8A8_SRGB; ci.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR; ci.imageExtent = win->swapChainExtent; ci.imageArrayLayers = 1; ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; ci.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR; ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR; ci.presentMode = VK_PRESENT_MODE_FIFO_KHR; ci.clipped = VK_TRUE;
+  win->presentMode = plat_choosePresentMode(win);
+  plat_selectSurfaceFormat(win);
+  VkSwapchainCreateInfoKHR ci = {0}; ci.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR; ci.surface = win->surface; ci.minImageCount = plat_chooseImageCount(&caps, win->presentMode); ci.imageFormat = win->surfaceFormat.format; ci.imageColorSpace = win->surfaceFormat.colorSpace; ci.imageExtent = win->swapChainExtent; ci.imageArrayLayers = 1; ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; ci.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR; ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR; ci.presentMode = win->presentMode; ci.clipped = VK_TRUE;
   /* Ensure we do not reference an invalid oldSwapchain */
   ci.oldSwapchain = VK_NULL_HANDLE;
   vkCreateSwapchainKHR(cj_engine_device(cj_engine_get_current()), &ci, NULL, &win->swapChain);
-  cj_engine_ensure_render_pass(cj_engine_get_current(), ci.imageFormat);
+  plat_queryDisplayTiming(win);
 }
 
-/* Recreate swapchain for window resize. Destroys old swapchain resources and creates new ones. */
-static void plat_recreateSwapChainForWindow(CJPlatformWindow * win) {
-  if (!win || !win->swapChain) return;
+/* Destroy the Vulkan objects and arrays held by a retired entry (not the entry itself) */
+static void plat_releaseRetiredSwapchain(VkDevice dev, CJRetiredSwapchain * r) {
+  if (!r) return;
+  VkCommandPool pool = cj_engine_command_pool(cj_engine_get_current());
+  if (dev && pool && r->commandBuffers && r->imageCount) vkFreeCommandBuffers(dev, pool, r->imageCount, r->commandBuffers);
+  if (dev && r->framebuffers) { for (uint32_t i = 0; i < r->imageCount; i++) if (r->framebuffers[i]) vkDestroyFramebuffer(dev, r->framebuffers[i], NULL); }
+  if (dev && r->imageViews) { for (uint32_t i = 0; i < r->imageCount; i++) if (r->imageViews[i]) vkDestroyImageView(dev, r->imageViews[i], NULL); }
+  if (dev && r->renderFinishedSemaphores) { for (uint32_t i = 0; i < r->imageCount; i++) if (r->renderFinishedSemaphores[i]) vkDestroySemaphore(dev, r->renderFinishedSemaphores[i], NULL); }
+  if (dev && r->swapChain) vkDestroySwapchainKHR(dev, r->swapChain, NULL);
+  free(r->commandBuffers);
+  free(r->framebuffers);
+  free(r->imageViews);
+  free(r->images);
+  free(r->renderFinishedSemaphores);
+}
 
-  VkDevice dev = cj_engine_device(cj_engine_get_current());
-  if (!dev) return;
+/* Whether the last submission made from a ring slot has finished, without blocking */
+static bool plat_frameSlotDone(CJPlatformWindow * win, uint32_t slot) {
+  cj_engine_t * e = cj_engine_get_current();
+  if (win->frameBatchSerials && win->frameBatchSerials[slot]) return cj_engine_batch_done(e, win->frameBatchSerials[slot]);
+  return vkGetFenceStatus(cj_engine_device(e), win->inFlightFences[slot]) == VK_SUCCESS;
+}
 
-  /* Wait for device to finish all operations before recreating swapchain */
-  vkDeviceWaitIdle(dev);
+/* Block until the last submission made from a ring slot has finished */
+static void plat_waitFrameSlot(CJPlatformWindow * win, uint32_t slot) {
+  cj_engine_t * e = cj_engine_get_current();
+  if (win->frameBatchSerials && win->frameBatchSerials[slot]) {
+    cj_engine_wait_batch(e, win->frameBatchSerials[slot]);
+  } else {
+    vkWaitForFences(cj_engine_device(e), 1, &win->inFlightFences[slot], VK_TRUE, UINT64_MAX);
+  }
+  if (win->frameSerials[slot] > win->completedSerial) win->completedSerial = win->frameSerials[slot];
+}
 
-  /* Save old swapchain for recreation */
-  VkSwapchainKHR oldSwapchain = win->swapChain;
+/*
+ * Advance completedSerial from the ring fences and destroy every retired
+ * swapchain whose last submission has finished. With force set (device already
+ * idle), everything on the list is destroyed.
+ */
+static void plat_collectRetiredSwapchains(CJPlatformWindow * win, bool force) {
+  if (!win || !win->retiredSwapchains) return;
+  VkDevice dev = cj_engine_device(cj_engine_get_current());
 
-  /* Destroy old swapchain-dependent resources */
-  VkCommandPool pool = cj_engine_command_pool(cj_engine_get_current());
-  if (win->commandBuffers && win->swapChainImageCount > 0) {
-    vkFreeCommandBuffers(dev, pool, win->swapChainImageCount, win->commandBuffers);
-    free(win->commandBuffers);
-    win->commandBuffers = NULL;
-  }
-  if (win->swapChainFramebuffers) {
-    for (uint32_t i = 0; i < win->swapChainImageCount; i++) {
-      if (win->swapChainFramebuffers[i]) {
-        vkDestroyFramebuffer(dev, win->swapChainFramebuffers[i], NULL);
+  if (!force && dev && win->inFlightFences && win->frameSerials) {
+    for (uint32_t i = 0; i < win->framesInFlight; i++) {
+      if (win->frameSerials[i] > win->completedSerial && plat_frameSlotDone(win, i)) {
+        win->completedSerial = win->frameSerials[i];
       }
     }
-    free(win->swapChainFramebuffers);
-    win->swapChainFramebuffers = NULL;
   }
-  if (win->swapChainImageViews) {
-    for (uint32_t i = 0; i < win->swapChainImageCount; i++) {
-      if (win->swapChainImageViews[i]) {
-        vkDestroyImageView(dev, win->swapChainImageViews[i], NULL);
-      }
+
+  CJRetiredSwapchain ** link = &win->retiredSwapchains;
+  while (*link) {
+    CJRetiredSwapchain * r = *link;
+    if (force || r->lastUseSerial <= win->completedSerial) {
+      *link = r->next;
+      plat_releaseRetiredSwapchain(dev, r);
+      free(r);
+    } else {
+      link = &r->next;
     }
-    free(win->swapChainImageViews);
-    win->swapChainImageViews = NULL;
   }
-  if (win->swapChainImages) {
-    free(win->swapChainImages);
-    win->swapChainImages = NULL;
+}
+
+/* Move the current swapchain-dependent resources onto the retire list */
+static void plat_retireSwapchainResources(CJPlatformWindow * win, VkSwapchainKHR swapChain) {
+  CJRetiredSwapchain tmp = {0};
+  CJRetiredSwapchain * r = (CJRetiredSwapchain*)calloc(1, sizeof(CJRetiredSwapchain));
+  bool deferred = (r != NULL);
+  if (!r) r = &tmp;
+
+  r->swapChain = swapChain;
+  r->imageCount = win->swapChainImageCount;
+  r->images = win->swapChainImages;
+  r->imageViews = win->swapChainImageViews;
+  r->framebuffers = win->swapChainFramebuffers;
+  r->commandBuffers = win->commandBuffers;
+  /* The presentation engine may still wait on these after the swapchain is replaced */
+  r->renderFinishedSemaphores = win->renderFinishedSemaphores;
+  r->lastUseSerial = win->submitSerial;
+
+  if (deferred) {
+    r->next = win->retiredSwapchains;
+    win->retiredSwapchains = r;
+  } else {
+    /* Out of memory: stall instead so nothing in use is destroyed */
+    VkDevice dev = cj_engine_device(cj_engine_get_current());
+    if (dev) vkDeviceWaitIdle(dev);
+    plat_releaseRetiredSwapchain(dev, r);
   }
 
+  win->swapChainImages = NULL;
+  win->swapChainImageViews = NULL;
+  win->swapChainFramebuffers = NULL;
+  win->commandBuffers = NULL;
+  win->renderFinishedSemaphores = NULL;
+  win->renderFinishedCount = 0;
+  win->swapChainImageCount = 0;
+}
+
+/*
+ * Recreate the swapchain after a resize or an out-of-date result.
+ *
+ * The old swapchain is passed as oldSwapchain and, together with its image
+ * views, framebuffers and pre-recorded command buffers, is retired rather than
+ * destroyed; plat_collectRetiredSwapchains frees it once the frames that used
+ * it have signaled their fences. Other windows sharing the device are never
+ * stalled. Resize events only set needs_swapchain_recreate, so any number of
+ * them between two frames result in a single rebuild.
+ *
+ * On return needs_swapchain_recreate is false on success and remains true if
+ * the swapchain could not be built yet (e.g. zero-sized while minimized).
+ */
+static void plat_recreateSwapChainForWindow(CJPlatformWindow * win) {
+  if (!win) return;
+
+  VkDevice dev = cj_engine_device(cj_engine_get_current());
+  if (!dev) return;
+
+  win->needs_swapchain_recreate = true;
+
+  /* A zero-sized surface cannot back a swapchain; try again on a later frame */
+  if (win->width <= 0 || win->height <= 0) return;
+
   /* Query new surface capabilities */
   VkSurfaceCapabilitiesKHR caps;
   vkGetPhysicalDeviceSurfaceCapabilitiesKHR(cj_engine_physical_device(cj_engine_get_current()), win->surface, &caps);
+  if (caps.maxImageExtent.width == 0 || caps.maxImageExtent.height == 0) return;
 
   /* Calculate physical size from logical size for swapchain */
   uint32_t physical_width = (uint32_t)logical_to_physical((int32_t)win->width, win->dpi_scale);
@@ -1391,34 +1714,47 @@ static void plat_recreateSwapChainForWindow(CJPlatformWindow * win) {
   win->swapChainExtent.height = physical_height;
 
   /* Create new swapchain with old swapchain reference */
+  VkSwapchainKHR oldSwapchain = win->swapChain;
+  win->presentMode = plat_choosePresentMode(win);
+  plat_selectSurfaceFormat(win);
   VkSwapchainCreateInfoKHR ci = {0};
   ci.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
   ci.surface = win->surface;
-  ci.minImageCount = caps.minImageCount;
-  ci.imageFormat = VK_FORMAT_B8G8R8A8_SRGB;
-  ci.imageColorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+  ci.minImageCount = plat_chooseImageCount(&caps, win->presentMode);
+  ci.imageFormat = win->surfaceFormat.format;
+  ci.imageColorSpace = win->surfaceFormat.colorSpace;
   ci.imageExtent = win->swapChainExtent;
   ci.imageArrayLayers = 1;
   ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
   ci.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
   ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-  ci.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+  ci.presentMode = win->presentMode;
   ci.clipped = VK_TRUE;
-  ci.oldSwapchain = oldSwapchain;  /* Reference old swapchain for proper recreation */
+  ci.oldSwapchain = oldSwapchain;  /* Lets the presentation engine hand over in-flight images */
+
+  VkSwapchainKHR newSwapchain = VK_NULL_HANDLE;
+  VkResult res = vkCreateSwapchainKHR(dev, &ci, NULL, &newSwapchain);
 
-  if (vkCreateSwapchainKHR(dev, &ci, NULL, &win->swapChain) != VK_SUCCESS) {
+  /* The old swapchain is retired by the call above even if creation failed */
+  if (oldSwapchain != VK_NULL_HANDLE || win->swapChainImageCount > 0) {
+    plat_retireSwapchainResources(win, oldSwapchain);
+  }
+  win->swapChain = newSwapchain;
+  if (res != VK_SUCCESS) {
     fprintf(stderr, "Error: Failed to recreate swapchain\n");
+    win->swapChain = VK_NULL_HANDLE;
     return;
   }
-
-  /* Destroy old swapchain after creating new one */
-  vkDestroySwapchainKHR(dev, oldSwapchain, NULL);
+  plat_queryDisplayTiming(win);
 
   /* Recreate image views, framebuffers, and command buffers */
   if (!plat_createImageViewsForWindow(win)) {
     fprintf(stderr, "Error: Failed to recreate image views after resize\n");
     return;
   }
+  if (!plat_resetImageFenceTracking(win)) {
+    return;
+  }
   if (!plat_createFramebuffersForWindow(win)) {
     fprintf(stderr, "Error: Failed to recreate framebuffers after resize\n");
     return;
@@ -1439,6 +1775,8 @@ static void plat_recreateSwapChainForWindow(CJPlatformWindow * win) {
     fprintf(stderr, "Error: Failed to recreate command buffers after resize\n");
     return;
   }
+
+  win->needs_swapchain_recreate = false;
 }
 
 static bool plat_createImageViewsForWindow(CJPlatformWindow * win) {
@@ -1458,7 +1796,7 @@ static bool plat_createImageViewsForWindow(CJPlatformWindow * win) {
     return false;
   }
   for (uint32_t i=0;i<win->swapChainImageCount;i++) {
-    VkImageViewCreateInfo vi = {0}; vi.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO; vi.image = win->swapChainImages[i]; vi.viewType = VK_IMAGE_VIEW_TYPE_2D; vi.format = VK_FORMAT_B8G8R8A8_SRGB; vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; vi.subresourceRange.levelCount = 1; vi.subresourceRange.layerCount = 1;
+    VkImageViewCreateInfo vi = {0}; vi.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO; vi.image = win->swapChainImages[i]; vi.viewType = VK_IMAGE_VIEW_TYPE_2D; vi.format = win->surfaceFormat.format; vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; vi.subresourceRange.levelCount = 1; vi.subresourceRange.layerCount = 1;
     if (vkCreateImageView(cj_engine_device(cj_engine_get_current()), &vi, NULL, &win->swapChainImageViews[i]) != VK_SUCCESS) {
       fprintf(stderr, "Error: Failed to create image view %u\n", i);
       // Clean up already created image views
@@ -1488,7 +1826,7 @@ static bool plat_createFramebuffersForWindow(CJPlatformWindow * win) {
   VkDevice dev = cj_engine_device(cj_engine_get_current());
   for (uint32_t i=0;i<win->swapChainImageCount;i++) {
     VkImageView attachments[] = { win->swapChainImageViews[i] };
-    VkFramebufferCreateInfo fi = {0}; fi.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO; fi.renderPass = cj_engine_render_pass(cj_engine_get_current()); fi.attachmentCount = 1; fi.pAttachments = attachments; fi.width = win->swapChainExtent.width; fi.height = win->swapChainExtent.height; fi.layers = 1;
+    VkFramebufferCreateInfo fi = {0}; fi.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO; fi.renderPass = win->renderPass; fi.attachmentCount = 1; fi.pAttachments = attachments; fi.width = win->swapChainExtent.width; fi.height = win->swapChainExtent.height; fi.layers = 1;
     if (vkCreateFramebuffer(dev, &fi, NULL, &win->swapChainFramebuffers[i]) != VK_SUCCESS) {
       fprintf(stderr, "Error: Failed to create framebuffer %u\n", i);
       // Clean up already created framebuffers
@@ -1505,28 +1843,572 @@ static bool plat_createFramebuffersForWindow(CJPlatformWindow * win) {
   return true;
 }
 
-static void plat_createSyncObjectsForWindow(CJPlatformWindow * win) {
-  if (!win) return;
+/* Resolve the requested frames_in_flight to the ring size actually used */
+static uint32_t plat_resolveFramesInFlight(uint32_t requested) {
+  if (requested == 0) return CJ_WINDOW_DEFAULT_FRAMES_IN_FLIGHT;
+  if (requested > CJ_WINDOW_MAX_FRAMES_IN_FLIGHT) return CJ_WINDOW_MAX_FRAMES_IN_FLIGHT;
+  return requested;
+}
+
+/* Destroy the per-image present semaphores; only once no present can still wait on them */
+static void plat_destroyPresentSemaphores(CJPlatformWindow * win) {
+  VkDevice dev = cj_engine_device(cj_engine_get_current());
+  for (uint32_t i = 0; i < win->renderFinishedCount; i++) {
+    if (dev && win->renderFinishedSemaphores[i]) vkDestroySemaphore(dev, win->renderFinishedSemaphores[i], NULL);
+  }
+  free(win->renderFinishedSemaphores);
+  win->renderFinishedSemaphores = NULL;
+  win->renderFinishedCount = 0;
+}
+
+/*
+ * (Re)allocate per-image slot, damage and present-semaphore tracking after the
+ * swapchain image count is known. A present semaphore is only reused once its
+ * image is acquired again, so it is never signaled while a present still waits
+ * on it; plat_retireSwapchainResources hands the old set to the retired entry.
+ */
+static bool plat_resetImageFenceTracking(CJPlatformWindow * win) {
+  if (!win) return false;
+  plat_destroyPresentSemaphores(win);
+  free(win->imagesInFlight);
+  win->imagesInFlight = NULL;
+  free(win->imageDamage);
+  win->imageDamage = NULL;
+  if (win->swapChainImageCount == 0) return true;
+  win->imagesInFlight = (uint32_t*)calloc(win->swapChainImageCount, sizeof(uint32_t));
+  if (!win->imagesInFlight) {
+    fprintf(stderr, "Error: Failed to allocate imagesInFlight\n");
+    return false;
+  }
+  /* New images hold nothing yet, so each one is drawn in full first */
+  win->imageDamage = (VkRect2D*)malloc(win->swapChainImageCount * sizeof(VkRect2D));
+  if (!win->imageDamage) {
+    fprintf(stderr, "Error: Failed to allocate imageDamage\n");
+    return false;
+  }
+  for (uint32_t i = 0; i < win->swapChainImageCount; i++) {
+    win->imageDamage[i] = (VkRect2D){{0, 0}, win->swapChainExtent};
+  }
+  win->renderFinishedSemaphores = (VkSemaphore*)calloc(win->swapChainImageCount, sizeof(VkSemaphore));
+  if (!win->renderFinishedSemaphores) {
+    fprintf(stderr, "Error: Failed to allocate present semaphores\n");
+    return false;
+  }
+  win->renderFinishedCount = win->swapChainImageCount;
+  VkDevice dev = cj_engine_device(cj_engine_get_current());
   VkSemaphoreCreateInfo si = {0}; si.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-  vkCreateSemaphore(cj_engine_device(cj_engine_get_current()), &si, NULL, &win->imageAvailableSemaphore);
-  vkCreateSemaphore(cj_engine_device(cj_engine_get_current()), &si, NULL, &win->renderFinishedSemaphore);
-  VkFenceCreateInfo fi = {0}; fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO; fi.flags = VK_FENCE_CREATE_SIGNALED_BIT; vkCreateFence(cj_engine_device(cj_engine_get_current()), &fi, NULL, &win->inFlightFence);
+  for (uint32_t i = 0; i < win->swapChainImageCount; i++) {
+    if (vkCreateSemaphore(dev, &si, NULL, &win->renderFinishedSemaphores[i]) != VK_SUCCESS) {
+      fprintf(stderr, "Error: Failed to create present semaphore for image %u\n", i);
+      plat_destroyPresentSemaphores(win);
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Smallest rectangle covering a and b; an empty rectangle covers nothing */
+static VkRect2D plat_rectUnion(VkRect2D a, VkRect2D b) {
+  if (a.extent.width == 0 || a.extent.height == 0) return b;
+  if (b.extent.width == 0 || b.extent.height == 0) return a;
+  int64_t x0 = a.offset.x < b.offset.x ? a.offset.x : b.offset.x;
+  int64_t y0 = a.offset.y < b.offset.y ? a.offset.y : b.offset.y;
+  int64_t ax1 = (int64_t)a.offset.x + a.extent.width, bx1 = (int64_t)b.offset.x + b.extent.width;
+  int64_t ay1 = (int64_t)a.offset.y + a.extent.height, by1 = (int64_t)b.offset.y + b.extent.height;
+  VkRect2D r;
+  r.offset = (VkOffset2D){(int32_t)x0, (int32_t)y0};
+  r.extent.width = (uint32_t)((ax1 > bx1 ? ax1 : bx1) - x0);
+  r.extent.height = (uint32_t)((ay1 > by1 ? ay1 : by1) - y0);
+  return r;
+}
+
+static uint64_t plat_rectArea(VkRect2D r) {
+  return (uint64_t)r.extent.width * r.extent.height;
+}
+
+/* Clip a rectangle to the extent; false when nothing is left */
+static bool plat_clipRect(VkRect2D * r, VkExtent2D extent) {
+  int64_t x0 = r->offset.x > 0 ? r->offset.x : 0;
+  int64_t y0 = r->offset.y > 0 ? r->offset.y : 0;
+  int64_t x1 = (int64_t)r->offset.x + r->extent.width;
+  int64_t y1 = (int64_t)r->offset.y + r->extent.height;
+  if (x1 > (int64_t)extent.width) x1 = extent.width;
+  if (y1 > (int64_t)extent.height) y1 = extent.height;
+  if (x1 <= x0 || y1 <= y0) return false;
+  r->offset = (VkOffset2D){(int32_t)x0, (int32_t)y0};
+  r->extent = (VkExtent2D){(uint32_t)(x1 - x0), (uint32_t)(y1 - y0)};
+  return true;
+}
+
+/* Redraw all of the window next frame, dropping any marked rectangles */
+static void plat_markFullRedraw(CJPlatformWindow * win) {
+  win->needsRedraw = 1;
+  win->dirtyPartial = false;
+  win->dirtyRectCount = 0;
+}
+
+/*
+ * Snapshot the damage of the frame about to be rendered, clipped to the swapchain.
+ * Leaves frameRectCount at 0 (whole frame) unless the pending redraw was limited
+ * to marked rectangles. Main thread only; recording reads the snapshot.
+ */
+static void plat_takeFrameDamage(cj_window_t * win) {
+  CJPlatformWindow * plat = win->plat;
+  plat->frameRectCount = 0;
+  /* Continuously redrawn windows change everywhere */
+  if (!plat->needsRedraw || !plat->dirtyPartial || win->redraw_policy == CJ_REDRAW_ALWAYS) return;
+  for (uint32_t i = 0; i < plat->dirtyRectCount; i++) {
+    VkRect2D r = plat->dirtyRects[i];
+    if (!plat_clipRect(&r, plat->swapChainExtent)) continue;
+    VkRectLayerKHR * out = &plat->frameRects[plat->frameRectCount++];
+    out->offset = r.offset;
+    out->extent = r.extent;
+    out->layer = 0;
+  }
+}
+
+/*
+ * Area of the acquired image to redraw: this frame's damage plus what the image
+ * missed while other images were presented. Every other image now misses this
+ * frame's damage too. False when the whole image is redrawn.
+ */
+static bool plat_takeImageDamage(CJPlatformWindow * win, uint32_t imageIndex, VkRect2D * out_area) {
+  VkRect2D full = {{0, 0}, win->swapChainExtent};
+  VkRect2D frame = {{0, 0}, {0, 0}};
+  if (win->frameRectCount == 0) frame = full;
+  for (uint32_t i = 0; i < win->frameRectCount; i++) {
+    VkRect2D r = {win->frameRects[i].offset, win->frameRects[i].extent};
+    frame = plat_rectUnion(frame, r);
+  }
+  *out_area = full;
+  if (!win->imageDamage || imageIndex >= win->swapChainImageCount) return false;
+
+  for (uint32_t i = 0; i < win->swapChainImageCount; i++) {
+    if (i != imageIndex) win->imageDamage[i] = plat_rectUnion(win->imageDamage[i], frame);
+  }
+  VkRect2D area = plat_rectUnion(win->imageDamage[imageIndex], frame);
+  win->imageDamage[imageIndex] = (VkRect2D){{0, 0}, {0, 0}};
+  if (plat_rectArea(area) >= plat_rectArea(full)) return false;
+  *out_area = area;
+  return true;
+}
+
+/*
+ * Read the refresh duration of a new swapchain and reset present feedback, whose
+ * reports belong to the swapchain they were presented to.
+ */
+static void plat_queryDisplayTiming(CJPlatformWindow * win) {
+  win->getPastPresentationTiming = NULL;
+  win->timing.refresh_ns = 0;
+  win->timing.last_present_ns = 0;
+  win->timing.present_delta_ns = 0;
+  cj_engine_t * engine = cj_engine_get_current();
+  if (win->swapChain == VK_NULL_HANDLE || !cj_engine_display_timing(engine)) return;
+
+  VkDevice dev = cj_engine_device(engine);
+  PFN_vkGetRefreshCycleDurationGOOGLE getRefresh =
+      (PFN_vkGetRefreshCycleDurationGOOGLE)vkGetDeviceProcAddr(dev, "vkGetRefreshCycleDurationGOOGLE");
+  win->getPastPresentationTiming =
+      (PFN_vkGetPastPresentationTimingGOOGLE)vkGetDeviceProcAddr(dev, "vkGetPastPresentationTimingGOOGLE");
+  VkRefreshCycleDurationGOOGLE refresh = {0};
+  if (getRefresh && getRefresh(dev, win->swapChain, &refresh) == VK_SUCCESS) {
+    win->timing.refresh_ns = refresh.refreshDuration;
+  }
+}
+
+/* Feed the presentation times reported since the last frame into the frame timing */
+static void plat_collectPresentTimings(CJPlatformWindow * win) {
+  if (!win->getPastPresentationTiming || win->swapChain == VK_NULL_HANDLE) return;
+  VkDevice dev = cj_engine_device(cj_engine_get_current());
+  VkPastPresentationTimingGOOGLE past[8];
+  uint32_t count = 8;
+  /* VK_INCOMPLETE leaves older reports for the next frame */
+  VkResult res = win->getPastPresentationTiming(dev, win->swapChain, &count, past);
+  if (res != VK_SUCCESS && res != VK_INCOMPLETE) return;
+  for (uint32_t i = 0; i < count; i++) {
+    cj_frame_timing_presented(&win->timing, past[i].presentID, past[i].actualPresentTime);
+  }
 }
 
-static void plat_drawFrameForWindow(CJPlatformWindow * win) {
+/* Tag a present with an id so its display time is reported back; false without display timing */
+static bool plat_fillPresentTime(CJPlatformWindow * win, VkPresentTimeGOOGLE * out_time) {
+  if (!win->getPastPresentationTiming) return false;
+  out_time->presentID = ++win->presentId;
+  out_time->desiredPresentTime = 0;  /* As soon as possible; pacing happens on the CPU */
+  return true;
+}
+
+/* Point a present region at the frame's damage; false when the whole image changed */
+static bool plat_fillPresentRegion(CJPlatformWindow * win, VkPresentRegionKHR * out_region) {
+  out_region->rectangleCount = 0;
+  out_region->pRectangles = NULL;
+  if (win->frameRectCount == 0 || !cj_engine_incremental_present(cj_engine_get_current())) return false;
+  out_region->rectangleCount = win->frameRectCount;
+  out_region->pRectangles = win->frameRects;
+  return true;
+}
+
+static void plat_destroySyncObjectsForWindow(CJPlatformWindow * win) {
   if (!win) return;
   VkDevice dev = cj_engine_device(cj_engine_get_current());
-#ifdef _WIN32
-  /* Skip draw if window has been destroyed */
-  if (!win->handle || !IsWindow(win->handle)) return;
-#endif
-  vkWaitForFences(dev, 1, &win->inFlightFence, VK_TRUE, UINT64_MAX);
-  vkResetFences(dev, 1, &win->inFlightFence);
-  uint32_t imageIndex; vkAcquireNextImageKHR(dev, win->swapChain, UINT64_MAX, win->imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
-  VkSemaphore waitS[] = { win->imageAvailableSemaphore }; VkPipelineStageFlags stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-  VkSubmitInfo si = {0}; si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO; si.waitSemaphoreCount = 1; si.pWaitSemaphores = waitS; si.pWaitDstStageMask = stages; si.commandBufferCount = 1; si.pCommandBuffers = &win->commandBuffers[imageIndex]; VkSemaphore sigS[] = { win->renderFinishedSemaphore }; si.signalSemaphoreCount = 1; si.pSignalSemaphores = sigS;
-  vkQueueSubmit(cj_engine_graphics_queue(cj_engine_get_current()), 1, &si, win->inFlightFence);
-  VkPresentInfoKHR pi = {0}; pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR; pi.waitSemaphoreCount = 1; pi.pWaitSemaphores = sigS; pi.swapchainCount = 1; pi.pSwapchains = &win->swapChain; pi.pImageIndices = &imageIndex; vkQueuePresentKHR(cj_engine_present_queue(cj_engine_get_current()), &pi);
+  for (uint32_t i = 0; i < win->framesInFlight; i++) {
+    if (dev && win->imageAvailableSemaphores && win->imageAvailableSemaphores[i]) vkDestroySemaphore(dev, win->imageAvailableSemaphores[i], NULL);
+    if (dev && win->inFlightFences && win->inFlightFences[i]) vkDestroyFence(dev, win->inFlightFences[i], NULL);
+  }
+  if (dev && win->gpuTimers) {
+    for (uint32_t i = 0; i < win->framesInFlight; i++) cj_gpu_timer_destroy(&win->gpuTimers[i]);
+  }
+  free(win->gpuTimers); win->gpuTimers = NULL;
+  /* Frees the ring's primaries and the cached secondaries with it */
+  if (dev && win->framePool) { vkDestroyCommandPool(dev, win->framePool, NULL); win->framePool = VK_NULL_HANDLE; }
+  plat_destroyPresentSemaphores(win);
+  free(win->imageAvailableSemaphores); win->imageAvailableSemaphores = NULL;
+  free(win->inFlightFences); win->inFlightFences = NULL;
+  free(win->frameCommandBuffers); win->frameCommandBuffers = NULL;
+  free(win->graphRecordings); win->graphRecordings = NULL;
+  free(win->imagesInFlight); win->imagesInFlight = NULL;
+  free(win->imageDamage); win->imageDamage = NULL;
+  free(win->frameSerials); win->frameSerials = NULL;
+  free(win->frameBatchSerials); win->frameBatchSerials = NULL;
+  win->framePending = false;
+  win->framesInFlight = 0;
+  win->currentFrame = 0;
+}
+
+/* Create the per-frame ring. win->framesInFlight must be set by the caller. */
+static bool plat_createSyncObjectsForWindow(CJPlatformWindow * win) {
+  if (!win || win->framesInFlight == 0) return false;
+  VkDevice dev = cj_engine_device(cj_engine_get_current());
+  uint32_t n = win->framesInFlight;
+  win->currentFrame = 0;
+  win->imageAvailableSemaphores = (VkSemaphore*)calloc(n, sizeof(VkSemaphore));
+  win->inFlightFences = (VkFence*)calloc(n, sizeof(VkFence));
+  win->frameCommandBuffers = (VkCommandBuffer*)calloc(n, sizeof(VkCommandBuffer));
+  win->frameSerials = (uint64_t*)calloc(n, sizeof(uint64_t));
+  win->frameBatchSerials = (uint64_t*)calloc(n, sizeof(uint64_t));
+  win->graphRecordings = (CJGraphRecording*)calloc(n, sizeof(CJGraphRecording));
+  if (!win->imageAvailableSemaphores || !win->inFlightFences || !win->frameCommandBuffers || !win->frameSerials || !win->frameBatchSerials || !win->graphRecordings) {
+    fprintf(stderr, "Error: Failed to allocate per-frame sync objects\n");
+    plat_destroySyncObjectsForWindow(win);
+    return false;
+  }
+
+  VkSemaphoreCreateInfo si = {0}; si.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  VkFenceCreateInfo fi = {0}; fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO; fi.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+  for (uint32_t i = 0; i < n; i++) {
+    if (vkCreateSemaphore(dev, &si, NULL, &win->imageAvailableSemaphores[i]) != VK_SUCCESS ||
+        vkCreateFence(dev, &fi, NULL, &win->inFlightFences[i]) != VK_SUCCESS) {
+      fprintf(stderr, "Error: Failed to create sync objects for frame %u\n", i);
+      plat_destroySyncObjectsForWindow(win);
+      return false;
+    }
+  }
+
+  /* Command pools are externally synchronized; a pool per window lets windows record in parallel */
+  VkCommandPoolCreateInfo pci = {0};
+  pci.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  pci.queueFamilyIndex = cj_engine_graphics_family(cj_engine_get_current());
+  if (vkCreateCommandPool(dev, &pci, NULL, &win->framePool) != VK_SUCCESS) {
+    fprintf(stderr, "Error: Failed to create per-window command pool\n");
+    win->framePool = VK_NULL_HANDLE;
+    plat_destroySyncObjectsForWindow(win);
+    return false;
+  }
+
+  VkCommandBufferAllocateInfo ai = {0};
+  ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  ai.commandPool = win->framePool;
+  ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  ai.commandBufferCount = n;
+  if (vkAllocateCommandBuffers(dev, &ai, win->frameCommandBuffers) != VK_SUCCESS) {
+    fprintf(stderr, "Error: Failed to allocate per-frame command buffers\n");
+    plat_destroySyncObjectsForWindow(win);
+    return false;
+  }
+
+  /* One secondary per slot: the slot fence guarantees it is idle when re-recorded */
+  ai.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+  ai.commandBufferCount = 1;
+  for (uint32_t i = 0; i < n; i++) {
+    if (vkAllocateCommandBuffers(dev, &ai, &win->graphRecordings[i].cmd) != VK_SUCCESS) {
+      fprintf(stderr, "Error: Failed to allocate secondary command buffer for frame %u\n", i);
+      win->graphRecordings[i].cmd = VK_NULL_HANDLE;
+      plat_destroySyncObjectsForWindow(win);
+      return false;
+    }
+  }
+
+  return plat_resetImageFenceTracking(win);
+}
+
+/* Create a timestamp timer per ring slot once the profiler records; main thread only */
+static void plat_ensureGpuTimers(CJPlatformWindow * win) {
+  if (win->gpuTimers || win->gpuTimersUnsupported || win->framesInFlight == 0 || !cj_profiler_is_enabled()) return;
+  cj_engine_t * e = cj_engine_get_current();
+  cj_gpu_timer_t * timers = (cj_gpu_timer_t*)calloc(win->framesInFlight, sizeof(cj_gpu_timer_t));
+  if (!timers) return;
+  for (uint32_t i = 0; i < win->framesInFlight; i++) {
+    if (!cj_gpu_timer_init(&timers[i], cj_engine_device(e), cj_engine_physical_device(e), cj_engine_graphics_family(e))) {
+      for (uint32_t j = 0; j < i; j++) cj_gpu_timer_destroy(&timers[j]);
+      free(timers);
+      win->gpuTimersUnsupported = true;
+      return;
+    }
+  }
+  win->gpuTimers = timers;
+}
+
+/* Timer for the frame recorded into the current ring slot; NULL while not profiling */
+static cj_gpu_timer_t * plat_frameGpuTimer(CJPlatformWindow * win) {
+  if (!win->gpuTimers || !cj_profiler_is_enabled()) return NULL;
+  return &win->gpuTimers[win->currentFrame];
+}
+
+/* CPU time of the frame just submitted, measured from cj_window_begin_frame() */
+static void plat_noteFrameSubmitted(CJPlatformWindow * win) {
+  if (win->frameBeginUs == 0) return;
+  win->profileStats.frame_index = win->frameBeginIndex;
+  win->profileStats.cpu_ms = (double)(cj_pacer_now_us() - win->frameBeginUs) / 1000.0;
+  win->frameBeginUs = 0;
+}
+
+/*
+ * Wait for the current ring slot to retire and acquire the next swapchain image.
+ * Only the frame submitted framesInFlight frames ago is waited on, so recording
+ * of this frame overlaps GPU execution of the previous ones. Touches nothing but
+ * this window's objects, so it may run on a worker thread.
+ */
+static bool plat_acquireFrameForWindow(CJPlatformWindow * win, uint32_t * out_image_index) {
+  if (!win || !win->inFlightFences || !out_image_index) return false;
+  if (win->swapChain == VK_NULL_HANDLE || win->needs_swapchain_recreate) return false;
+  VkDevice dev = cj_engine_device(cj_engine_get_current());
+  uint32_t frame = win->currentFrame;
+
+  plat_waitFrameSlot(win, frame);
+
+  uint32_t imageIndex = 0;
+  VkResult res = vkAcquireNextImageKHR(dev, win->swapChain, UINT64_MAX, win->imageAvailableSemaphores[frame], VK_NULL_HANDLE, &imageIndex);
+  if (res == VK_ERROR_OUT_OF_DATE_KHR) {
+    win->needs_swapchain_recreate = true;
+    return false;
+  }
+  if (res != VK_SUCCESS && res != VK_SUBOPTIMAL_KHR) {
+    fprintf(stderr, "Error: vkAcquireNextImageKHR failed (%d)\n", (int)res);
+    return false;
+  }
+
+  /* The image may still be in use by an older frame when images outnumber the ring */
+  if (win->imagesInFlight) {
+    uint32_t user = win->imagesInFlight[imageIndex];
+    if (user != 0 && user - 1 != frame) plat_waitFrameSlot(win, user - 1);
+    win->imagesInFlight[imageIndex] = frame + 1;
+  }
+
+  *out_image_index = imageIndex;
+  return true;
+}
+
+/* Fill the submit info of a frame recorded into the current ring slot; the
+ * semaphore arrays live in the window until the next frame */
+static void plat_fillFrameSubmitInfo(CJPlatformWindow * win, VkSubmitInfo * si, const VkCommandBuffer * cmd) {
+  uint32_t frame = win->currentFrame;
+  memset(si, 0, sizeof(*si));
+  si->sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  win->submitWaits[0] = win->imageAvailableSemaphores[frame];
+  win->submitWaitStages[0] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  win->submitWaitValues[0] = 0;
+  win->submitSignals[0] = win->renderFinishedSemaphores[win->pendingImageIndex];
+  win->submitSignalValues[0] = 0;
+  si->waitSemaphoreCount = 1;
+  si->pWaitSemaphores = win->submitWaits;
+  si->pWaitDstStageMask = win->submitWaitStages;
+  si->commandBufferCount = 1;
+  si->pCommandBuffers = cmd;
+  si->signalSemaphoreCount = 1;
+  si->pSignalSemaphores = win->submitSignals;
+
+  /* Blur results from the compute queue, and the input it blurs next */
+  cj_rgraph_async_sync_t sync;
+  cj_rgraph__async_sync(win->pendingGraph, &sync);
+  if (sync.semaphore == VK_NULL_HANDLE) return;
+  if (sync.wait_value) {
+    win->submitWaits[1] = sync.semaphore;
+    win->submitWaitStages[1] = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    win->submitWaitValues[1] = sync.wait_value;
+    si->waitSemaphoreCount = 2;
+  }
+  if (sync.signal_value) {
+    win->submitSignals[1] = sync.semaphore;
+    win->submitSignalValues[1] = sync.signal_value;
+    si->signalSemaphoreCount = 2;
+  }
+  /* Values of the binary semaphores are ignored */
+  memset(&win->submitTimeline, 0, sizeof(win->submitTimeline));
+  win->submitTimeline.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+  win->submitTimeline.waitSemaphoreValueCount = si->waitSemaphoreCount;
+  win->submitTimeline.pWaitSemaphoreValues = win->submitWaitValues;
+  win->submitTimeline.signalSemaphoreValueCount = si->signalSemaphoreCount;
+  win->submitTimeline.pSignalSemaphoreValues = win->submitSignalValues;
+  si->pNext = &win->submitTimeline;
+}
+
+/*
+ * Give up on the frame in the current ring slot after its submission failed.
+ * The acquire left the slot's image-available semaphore signaled and its image
+ * held by the application: a submission that only waits on the semaphore
+ * consumes the signal, and the swapchain is rebuilt so the image goes back with
+ * the old one. Direct frames reuse the slot fence, reset for the failed submit;
+ * batched frames are tracked by their batch serial. If that fails too, the
+ * device is idled and the slot's semaphore and fence are replaced.
+ */
+static void plat_abandonFrameForWindow(CJPlatformWindow * win, bool batched) {
+  cj_engine_t * e = cj_engine_get_current();
+  VkDevice dev = cj_engine_device(e);
+  uint32_t frame = win->currentFrame;
+  win->needs_swapchain_recreate = true;
+  win->framePending = false;
+
+  VkPipelineStageFlags stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  VkSubmitInfo si = {0};
+  si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  si.waitSemaphoreCount = 1;
+  si.pWaitSemaphores = &win->imageAvailableSemaphores[frame];
+  si.pWaitDstStageMask = &stage;
+  uint64_t batch = 0;
+  bool consumed = batched ? (batch = cj_engine_submit_batch(e, 1, &si)) != 0
+                          : vkQueueSubmit(cj_engine_graphics_queue(e), 1, &si, win->inFlightFences[frame]) == VK_SUCCESS;
+  if (consumed) {
+    win->frameSerials[frame] = ++win->submitSerial;
+    win->frameBatchSerials[frame] = batch;
+  } else {
+    /* Nothing waits on the semaphore or signals the fence; keep the old ones only if no new ones can be made */
+    vkDeviceWaitIdle(dev);
+    VkSemaphoreCreateInfo sci = {0}; sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VkFenceCreateInfo fci = {0}; fci.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO; fci.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    if (vkCreateSemaphore(dev, &sci, NULL, &semaphore) == VK_SUCCESS) {
+      vkDestroySemaphore(dev, win->imageAvailableSemaphores[frame], NULL);
+      win->imageAvailableSemaphores[frame] = semaphore;
+    } else {
+      fprintf(stderr, "Error: Failed to replace the image-available semaphore of frame %u\n", frame);
+    }
+    if (!batched) {
+      if (vkCreateFence(dev, &fci, NULL, &fence) == VK_SUCCESS) {
+        vkDestroyFence(dev, win->inFlightFences[frame], NULL);
+        win->inFlightFences[frame] = fence;
+      } else {
+        fprintf(stderr, "Error: Failed to replace the fence of frame %u\n", frame);
+      }
+    }
+    win->frameBatchSerials[frame] = 0;
+  }
+  win->currentFrame = (frame + 1) % win->framesInFlight;
+}
+
+/* React to the result of presenting one swapchain; only a lost device is reported to the caller */
+static cj_result_t plat_notePresentResult(CJPlatformWindow * win, VkResult res) {
+  if (res == VK_SUCCESS) return CJ_SUCCESS;
+  if (res == VK_ERROR_DEVICE_LOST) {
+    fprintf(stderr, "Error: vkQueuePresentKHR lost the device\n");
+    return CJ_E_DEVICE_LOST;
+  }
+  if (res != VK_ERROR_OUT_OF_DATE_KHR && res != VK_SUBOPTIMAL_KHR) {
+    fprintf(stderr, "Error: vkQueuePresentKHR failed (%d)\n", (int)res);
+  }
+  win->needs_swapchain_recreate = true;
+  return CJ_SUCCESS;
+}
+
+/* Submit a command buffer for the acquired image, present it, and advance the ring */
+static cj_result_t plat_submitFrameForWindow(CJPlatformWindow * win, VkCommandBuffer cmd, uint32_t imageIndex) {
+  if (!win) return CJ_E_INVALID_ARGUMENT;
+  uint32_t frame = win->currentFrame;
+  VkSemaphore sigS[] = { win->renderFinishedSemaphores[imageIndex] };
+  VkSubmitInfo si; plat_fillFrameSubmitInfo(win, &si, &cmd);
+  plat_collectRetiredSwapchains(win, false);
+  /* Texture copies queued this frame must reach the queue before the draws that sample them */
+  cj_upload_queue_flush(cj_engine_uploads(cj_engine_get_current()));
+  /* Reset only now that work is certain to be submitted with this fence */
+  vkResetFences(cj_engine_device(cj_engine_get_current()), 1, &win->inFlightFences[frame]);
+  bool submitted = vkQueueSubmit(cj_engine_graphics_queue(cj_engine_get_current()), 1, &si, win->inFlightFences[frame]) == VK_SUCCESS;
+  cj_rgraph__submit_async(win->pendingGraph, submitted);
+  win->pendingGraph = NULL;
+  if (!submitted) {
+    fprintf(stderr, "Error: vkQueueSubmit failed for the frame\n");
+    plat_abandonFrameForWindow(win, false);
+    return CJ_E_UNKNOWN;
+  }
+  plat_noteFrameSubmitted(win);
+  win->frameSerials[frame] = ++win->submitSerial;
+  win->frameBatchSerials[frame] = 0;
+  VkPresentInfoKHR pi = {0}; pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR; pi.waitSemaphoreCount = 1; pi.pWaitSemaphores = sigS; pi.swapchainCount = 1; pi.pSwapchains = &win->swapChain; pi.pImageIndices = &imageIndex;
+  /* Let the compositor copy only what changed */
+  VkPresentRegionKHR region;
+  VkPresentRegionsKHR regions = {0};
+  if (plat_fillPresentRegion(win, &region)) {
+    regions.sType = VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR;
+    regions.swapchainCount = 1;
+    regions.pRegions = &region;
+    pi.pNext = &regions;
+  }
+  /* Ask for the time the frame reaches the display */
+  VkPresentTimeGOOGLE time;
+  VkPresentTimesInfoGOOGLE times = {0};
+  if (plat_fillPresentTime(win, &time)) {
+    times.sType = VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE;
+    times.pNext = pi.pNext;
+    times.swapchainCount = 1;
+    times.pTimes = &time;
+    pi.pNext = &times;
+  }
+  VkResult res = vkQueuePresentKHR(cj_engine_present_queue(cj_engine_get_current()), &pi);
+  win->currentFrame = (frame + 1) % win->framesInFlight;
+  return plat_notePresentResult(win, res);
+}
+
+/*
+ * Replay the current slot's cached secondary, re-recording it from the graph only
+ * when the content version, extent or render pass changed. The caller must be inside
+ * a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+ */
+static cj_result_t plat_executeCachedGraphForWindow(CJPlatformWindow * win, cj_rgraph_t * graph, VkCommandBuffer cmd, VkExtent2D extent) {
+  CJGraphRecording * rec = &win->graphRecordings[win->currentFrame];
+  VkRenderPass renderPass = win->renderPass;
+  uint64_t version = cj_rgraph_content_version(graph);
+
+  if (!rec->valid || rec->graph != graph || rec->version != version || rec->renderPass != renderPass ||
+      rec->extent.width != extent.width || rec->extent.height != extent.height) {
+    rec->valid = false;
+
+    /* Framebuffer is left unspecified so the recording serves every swapchain image */
+    VkCommandBufferInheritanceInfo inheritance = {0};
+    inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritance.renderPass = renderPass;
+    inheritance.subpass = 0;
+    VkCommandBufferBeginInfo beginInfo = {0};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance;
+    if (vkBeginCommandBuffer(rec->cmd, &beginInfo) != VK_SUCCESS) {
+      return CJ_E_UNKNOWN;
+    }
+    cj_result_t result = cj_rgraph_execute(graph, rec->cmd, extent);
+    if (vkEndCommandBuffer(rec->cmd) != VK_SUCCESS) {
+      return CJ_E_UNKNOWN;
+    }
+    if (result != CJ_SUCCESS) return result;
+
+    rec->graph = graph;
+    rec->version = version;
+    rec->extent = extent;
+    rec->renderPass = renderPass;
+    rec->valid = true;
+  }
+
+  vkCmdExecuteCommands(cmd, 1, &rec->cmd);
+  return CJ_SUCCESS;
 }
 
 static void plat_cleanupWindow(CJPlatformWindow * win) {
@@ -1537,9 +2419,8 @@ static void plat_cleanupWindow(CJPlatformWindow * win) {
   if (dev) vkDeviceWaitIdle(dev);
 
   // Destroy Vulkan resources
-  if (dev && win->renderFinishedSemaphore) vkDestroySemaphore(dev, win->renderFinishedSemaphore, NULL);
-  if (dev && win->imageAvailableSemaphore) vkDestroySemaphore(dev, win->imageAvailableSemaphore, NULL);
-  if (dev && win->inFlightFence) vkDestroyFence(dev, win->inFlightFence, NULL);
+  plat_collectRetiredSwapchains(win, true);
+  plat_destroySyncObjectsForWindow(win);
   if (dev && pool && win->commandBuffers && win->swapChainImageCount) vkFreeCommandBuffers(dev, pool, win->swapChainImageCount, win->commandBuffers);
   if (win->commandBuffers) { free(win->commandBuffers); win->commandBuffers = NULL; }
   if (dev && win->swapChainFramebuffers) { for (uint32_t i=0;i<win->swapChainImageCount;i++) if (win->swapChainFramebuffers[i]) vkDestroyFramebuffer(dev, win->swapChainFramebuffers[i], NULL); }
@@ -1584,8 +2465,7 @@ static void plat_recreateSwapChainForWindow(CJPlatformWindow * win);
 static bool plat_createImageViewsForWindow(CJPlatformWindow * win);
 static bool plat_createFramebuffersForWindow(CJPlatformWindow * win);
 static bool createTexturedCommandBuffersForWindowCtx(CJPlatformWindow * win, const CJellyVulkanContext* ctx);
-static void plat_createSyncObjectsForWindow(CJPlatformWindow * win);
-static void plat_drawFrameForWindow(CJPlatformWindow * win);
+static bool plat_createSyncObjectsForWindow(CJPlatformWindow * win);
 static void plat_cleanupWindow(CJPlatformWindow * win);
 
 /* Command buffer recorders using engine/ctx */
@@ -1602,6 +2482,8 @@ CJ_API cj_window_t* cj_window_create(cj_engine_t* engine, const cj_window_desc_t
   if (!win) return NULL;
   win->plat = (CJPlatformWindow*)calloc(1, sizeof(CJPlatformWindow));
   if (!win->plat) { free(win); return NULL; }
+  win->input = cj_input_queue_create(window_deliverInput, win);
+  if (!win->input) { free(win->plat); free(win); return NULL; }
 
   /* Create OS window and per-window Vulkan resources */
   const char* title = desc->title.ptr ? desc->title.ptr : "CJelly Window";
@@ -1623,6 +2505,8 @@ CJ_API cj_window_t* cj_window_create(cj_engine_t* engine, const cj_window_desc_t
   }
   plat_createPlatformWindow(win->plat, title, (int)desc->width, (int)desc->height, x, y, initial_state);
   plat_createSurfaceForWindow(win->plat);
+  win->plat->presentModePref = desc->present_mode;
+  win->plat->surfaceFormatPref = desc->surface_format;
   plat_createSwapChainForWindow(win->plat);
   if (!plat_createImageViewsForWindow(win->plat)) {
     fprintf(stderr, "Error: Failed to create image views for window\n");
@@ -1653,7 +2537,12 @@ CJ_API cj_window_t* cj_window_create(cj_engine_t* engine, const cj_window_desc_t
     cj_window_destroy(win);
     return NULL;
   }
-  plat_createSyncObjectsForWindow(win->plat);
+  win->plat->framesInFlight = plat_resolveFramesInFlight(desc->frames_in_flight);
+  if (!plat_createSyncObjectsForWindow(win->plat)) {
+    fprintf(stderr, "Error: Failed to create per-frame sync objects for window\n");
+    cj_window_destroy(win);
+    return NULL;
+  }
 
   win->frame_index = 0u;
   win->close_callback = NULL;
@@ -1673,9 +2562,11 @@ CJ_API cj_window_t* cj_window_create(cj_engine_t* engine, const cj_window_desc_t
   win->max_fps = 0;  /* Default: unlimited (use global FPS limit) */
   win->last_render_time_us = 0;  /* Initialize to 0 (will be set on first render) */
   win->pending_render_reason = CJ_RENDER_REASON_FORCED;  /* Initial render is forced */
-  win->is_destroyed = false;
+  atomic_init(&win->redraw_posted, false);
+  atomic_init(&win->destroy_requested, false);
+  atomic_init(&win->is_destroyed, false);
   win->plat->needs_swapchain_recreate = false;
-  win->plat->needsRedraw = 1;  /* Window starts dirty (needs initial render) */
+  plat_markFullRedraw(win->plat);  /* Window starts dirty (needs initial render) */
   win->pending_render_reason = CJ_RENDER_REASON_FORCED;  /* Initial render is forced */
 
   // Automatically register window with current application (if one exists)
@@ -1712,9 +2603,32 @@ CJ_API void cj_window_destroy(cj_window_t* win) {
     return;
   }
 
+  // A callback on the input thread cannot tear down the window it is delivering to;
+  // the polling thread does it in the next cj_poll_events()
+  if (cj_input_queue_on_thread(win->input)) {
+    atomic_store(&win->destroy_requested, true);
+    cj_wake();
+    return;
+  }
+
   // Mark as destroyed immediately to prevent re-entry
   win->is_destroyed = true;
 
+  // Leave the open engine frame
+  if (win->frame_queued) {
+    for (uint32_t i = 0; i < g_engine_frame.count; i++) {
+      if (g_engine_frame.windows[i] != win) continue;
+      memmove(&g_engine_frame.windows[i], &g_engine_frame.windows[i + 1], (g_engine_frame.count - i - 1) * sizeof(cj_window_t *));
+      g_engine_frame.count--;
+      break;
+    }
+    win->frame_queued = false;
+  }
+
+  // Stop delivering input first; an input thread may still be in a callback
+  cj_input_queue_destroy(win->input);
+  win->input = NULL;
+
   // Unregister from application (need handle for lookup)
   void* handle = win->plat ? (void*)win->plat->handle : NULL;
   cjelly_application_unregister_window(NULL, win, handle);
@@ -1763,11 +2677,19 @@ CJ_API cj_result_t cj_window_resize(cj_window_t* win, uint32_t width, uint32_t h
 
 CJ_API cj_result_t cj_window_begin_frame(cj_window_t* win, cj_frame_info_t* out_frame_info) {
   if (!win || win->is_destroyed) return CJ_E_INVALID_ARGUMENT;
+  /* Timing advances even when the caller does not want the frame info */
+  double delta_seconds = 0.0;
+  uint64_t now = cj_pacer_now_us();
+  if (win->plat) {
+    plat_collectPresentTimings(win->plat);
+    delta_seconds = cj_frame_timing_begin(&win->plat->timing, now);
+  }
   if (out_frame_info) {
     out_frame_info->frame_index = ++win->frame_index;
-    out_frame_info->delta_seconds = 0.0; /* stub */
+    out_frame_info->delta_seconds = delta_seconds;
     /* Set render reason from pending reason, or default to TIMER if not dirty */
     out_frame_info->render_reason = cj_window__get_pending_render_reason(win);
+    out_frame_info->arena = cj_engine_frame_arena(cj_engine_get_current());
     /* Clear pending reason after reading it (will be set again if needed) */
     if (win->plat && win->plat->needsRedraw == 0) {
       win->pending_render_reason = CJ_RENDER_REASON_TIMER;
@@ -1775,135 +2697,410 @@ CJ_API cj_result_t cj_window_begin_frame(cj_window_t* win, cj_frame_info_t* out_
   } else {
     win->frame_index++;
   }
+  /* CPU frame time runs until the frame is submitted */
+  if (win->plat) {
+    win->plat->frameBeginUs = cj_profiler_is_enabled() ? now : 0;
+    win->plat->frameBeginIndex = win->frame_index;
+  }
   return CJ_SUCCESS;
 }
 
-CJ_API cj_result_t cj_window_execute(cj_window_t* win) {
-  if (!win || win->is_destroyed || !win->plat) return CJ_E_INVALID_ARGUMENT;
+/*
+ * Record the render graph into the current ring slot's primary for an acquired
+ * image. A non-NULL area redraws only that part of the image and keeps the rest.
+ * Returns the failure of any step; the caller falls back to the image's
+ * pre-recorded buffer. Runs on worker threads when the engine is threaded.
+ */
+static cj_result_t plat_recordGraphForWindow(cj_window_t * win, VkCommandBuffer cmd, uint32_t imageIndex, const VkRect2D * area) {
+  VkExtent2D extent = {win->plat->swapChainExtent.width, win->plat->swapChainExtent.height};
+
+  /* CRITICAL FIX: Properly prepare command buffer for render graph execution */
+  VkCommandBufferBeginInfo beginInfo = {0};
+  beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+  beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+  if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
+    printf("WINDOWS FIX: Failed to begin command buffer for render graph\n");
+    return CJ_E_UNKNOWN;
+  }
+
+  /* Partial redraws need the engine's pass that keeps the image contents */
+  VkRenderPass partialPass = win->plat->partialRenderPass;
+  if (partialPass == VK_NULL_HANDLE) area = NULL;
+
+  /* Static graphs on event-driven windows replay their last full recording */
+  bool cached = !area && (win->redraw_policy != CJ_REDRAW_ALWAYS) && win->plat->graphRecordings &&
+      cj_rgraph_is_static(win->render_graph);
+
+  /* Timestamps around every node while the profiler records */
+  cj_gpu_timer_t * timer = plat_frameGpuTimer(win->plat);
+  cj_gpu_timer_begin_frame(timer, cmd, win->frame_index);
+  cj_rgraph__set_gpu_timer(win->render_graph, timer);
+  cj_rgraph__set_backbuffer_pass(win->render_graph, win->plat->renderPass);
+  cj_rgraph__set_frame(win->render_graph, win->plat, win->plat->currentFrame);
+
+  /* Nodes rendering into transients run before the backbuffer pass */
+  cj_result_t result = cj_rgraph_execute_offscreen(win->render_graph, cmd, extent);
+
+  /* A replayed secondary is timed as a whole; timestamps inside it would outlive this frame's queries */
+  uint32_t passZone = CJ_GPU_TIMER_NO_ZONE;
+  if (cached) {
+    cj_rgraph__set_gpu_timer(win->render_graph, NULL);
+    passZone = cj_gpu_timer_begin(timer, cmd, "cached backbuffer pass");
+  }
+
+  /* Begin render pass for render graph */
+  VkRenderPassBeginInfo renderPassInfo = {0};
+  renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  renderPassInfo.renderPass = area ? partialPass : win->plat->renderPass;
+  renderPassInfo.framebuffer = win->plat->swapChainFramebuffers[imageIndex]; // Use the correct framebuffer for this frame
+  renderPassInfo.renderArea.offset = (VkOffset2D){0, 0};
+  renderPassInfo.renderArea.extent = win->plat->swapChainExtent;
+  /* The clear is limited to the render area, so only the damage is redrawn */
+  if (area) renderPassInfo.renderArea = *area;
+  VkClearValue clearColor = {{{0.1f, 0.1f, 0.1f, 1.0f}}};
+  renderPassInfo.clearValueCount = 1;
+  renderPassInfo.pClearValues = &clearColor;
+  vkCmdBeginRenderPass(cmd, &renderPassInfo,
+      cached ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+
+  if (cached) {
+    /* Secondaries set their own viewport and scissor per node */
+    if (result == CJ_SUCCESS) {
+      result = plat_executeCachedGraphForWindow(win->plat, win->render_graph, cmd, extent);
+    }
+  } else {
+    /* Set viewport and scissor */
+    VkViewport viewport = {0};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)win->plat->swapChainExtent.width;
+    viewport.height = (float)win->plat->swapChainExtent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+    VkRect2D scissor = renderPassInfo.renderArea;
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+
+    /* Execute render graph */
+    if (result == CJ_SUCCESS) {
+      result = cj_rgraph_execute_region(win->render_graph, cmd, extent, area);
+    }
+  }
+
+  /* End render pass and command buffer */
+  vkCmdEndRenderPass(cmd);
+  cj_gpu_timer_end(timer, cmd, passZone);
+  cj_gpu_timer_end_frame(timer, cmd);
+  cj_rgraph__set_gpu_timer(win->render_graph, NULL);
+  if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
+    printf("WINDOWS FIX: Failed to end command buffer for render graph\n");
+    return CJ_E_UNKNOWN;
+  }
+
+  if (result != CJ_SUCCESS) {
+    printf("WINDOWS FIX: Render graph execution failed (result=%d), falling back to legacy\n", result);
+  }
+  return result;
+}
+
+/*
+ * Main-thread half of a frame: rebuild the swapchain if needed and compile the
+ * render graph, so that recording never allocates or waits on the device.
+ * Returns false when the window has nothing to draw this frame.
+ */
+static bool cj_window__prepare_frame(cj_window_t * win) {
+  win->plat->framePending = false;
 
 #ifdef _WIN32
   /* Critical: Check if window handle is still valid before using Vulkan resources */
   if (!win->plat->handle || !IsWindow(win->plat->handle)) {
-    return CJ_E_INVALID_ARGUMENT;
+    return false;
   }
 #endif
 
-  /* Check if swapchain needs recreation (deferred from resize event) */
+  /* Check if swapchain needs recreation (deferred from resize events, so any
+   * number of resizes since the last frame cost a single rebuild) */
   if (win->plat->needs_swapchain_recreate) {
     plat_recreateSwapChainForWindow(win->plat);
-    win->plat->needs_swapchain_recreate = false;
     /* Mark dirty after swapchain recreation (content needs refresh) */
-    win->plat->needsRedraw = 1;
+    plat_markFullRedraw(win->plat);
     win->pending_render_reason = CJ_RENDER_REASON_SWAPCHAIN_RECREATE;
+    /* Still pending (e.g. zero-sized surface): skip this frame */
+    if (win->plat->needs_swapchain_recreate) return false;
   }
 
-  /* Use render graph if available, otherwise fall back to legacy drawing */
+  if (!win->plat->commandBuffers || win->plat->swapChainImageCount == 0) return false;
+  plat_takeFrameDamage(win);
+  plat_ensureGpuTimers(win->plat);
+
   if (win->render_graph) {
-    /* Execute render graph nodes */
     VkExtent2D extent = {win->plat->swapChainExtent.width, win->plat->swapChainExtent.height};
+    /* Pipeline variants for the window's format are built here, on the main thread */
+    cj_rgraph__set_backbuffer_pass(win->render_graph, win->plat->renderPass);
+    cj_rgraph_prepare(win->render_graph, extent);
+  } else {
+    /* Legacy path: direct drawing */
+    printf("DEBUG: Using legacy rendering path\n");
+  }
+  return true;
+}
 
-    /* Get the current command buffer from the window's command buffers */
-    if (win->plat->commandBuffers && win->plat->swapChainImageCount > 0) {
-      /* Acquire the next swapchain image first to get the correct command buffer index */
-      VkDevice dev = cj_engine_device(cj_engine_get_current());
-      vkWaitForFences(dev, 1, &win->plat->inFlightFence, VK_TRUE, UINT64_MAX);
-      vkResetFences(dev, 1, &win->plat->inFlightFence);
-      uint32_t imageIndex;
-      vkAcquireNextImageKHR(dev, win->plat->swapChain, UINT64_MAX, win->plat->imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
-      VkCommandBuffer cmd = win->plat->commandBuffers[imageIndex]; // Use the correct command buffer for this frame
-
-      /* CRITICAL FIX: Properly prepare command buffer for render graph execution */
-      VkCommandBufferBeginInfo beginInfo = {0};
-      beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-      beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-      if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS) {
-        printf("WINDOWS FIX: Failed to begin command buffer for render graph\n");
-        /* Fall back to legacy drawing if command buffer begin fails */
-        plat_drawFrameForWindow(win->plat);
-        return CJ_SUCCESS;
-      }
+/*
+ * Worker-safe half of a frame: acquire an image and record its command buffer.
+ * Leaves the frame pending for submission; touches only this window and its graph.
+ */
+static void cj_window__record_frame(cj_window_t * win) {
+  uint32_t imageIndex;
+  CJ_PROFILE_ZONE_BEGIN(acquireZone, "acquire image");
+  bool acquired = plat_acquireFrameForWindow(win->plat, &imageIndex);
+  CJ_PROFILE_ZONE_END(acquireZone, "acquire image");
+  if (!acquired) return;
+
+  /* The slot's previous frame has finished, so its timestamps are ready */
+  cj_gpu_timer_t * slotTimer = win->plat->gpuTimers ? &win->plat->gpuTimers[win->plat->currentFrame] : NULL;
+  cj_gpu_timer_read(slotTimer, &win->plat->profileStats);
+
+  /* Without a graph, or if it fails, the pre-recorded buffer for the acquired image is used */
+  VkCommandBuffer cmd = win->plat->commandBuffers[imageIndex];
+  VkRect2D area;
+  bool partial = plat_takeImageDamage(win->plat, imageIndex, &area);
+  cj_rgraph_t * graph = NULL;
+
+  /* Record into the current ring slot so the previous frames can still be in flight */
+  if (win->render_graph && win->plat->frameCommandBuffers) {
+    VkCommandBuffer frameCmd = win->plat->frameCommandBuffers[win->plat->currentFrame];
+    CJ_PROFILE_ZONE_BEGIN(recordZone, "record graph");
+    if (plat_recordGraphForWindow(win, frameCmd, imageIndex, partial ? &area : NULL) == CJ_SUCCESS) {
+      cmd = frameCmd;
+      graph = win->render_graph;
+    } else {
+      /* Its queries are never submitted */
+      cj_gpu_timer_discard(slotTimer);
+    }
+    CJ_PROFILE_ZONE_END(recordZone, "record graph");
+  }
+  /* A full redraw, or the pre-recorded fallback, changed the whole image; present it as such */
+  if (!partial || !graph) win->plat->frameRectCount = 0;
+
+  win->plat->pendingCmd = cmd;
+  win->plat->pendingGraph = graph;
+  win->plat->pendingImageIndex = imageIndex;
+  win->plat->framePending = true;
+}
+
+CJ_API cj_result_t cj_window_execute(cj_window_t* win) {
+  if (!win || win->is_destroyed || !win->plat) return CJ_E_INVALID_ARGUMENT;
+
+#ifdef _WIN32
+  /* Critical: Check if window handle is still valid before using Vulkan resources */
+  if (!win->plat->handle || !IsWindow(win->plat->handle)) {
+    return CJ_E_INVALID_ARGUMENT;
+  }
+#endif
 
-      /* Begin render pass for render graph */
-      VkRenderPassBeginInfo renderPassInfo = {0};
-      renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-      renderPassInfo.renderPass = cj_engine_render_pass(cj_engine_get_current());
-      renderPassInfo.framebuffer = win->plat->swapChainFramebuffers[imageIndex]; // Use the correct framebuffer for this frame
-      renderPassInfo.renderArea.offset = (VkOffset2D){0, 0};
-      renderPassInfo.renderArea.extent = win->plat->swapChainExtent;
-      VkClearValue clearColor = {{{0.1f, 0.1f, 0.1f, 1.0f}}};
-      renderPassInfo.clearValueCount = 1;
-      renderPassInfo.pClearValues = &clearColor;
-      vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-      /* Set viewport and scissor */
-      VkViewport viewport = {0};
-      viewport.x = 0.0f;
-      viewport.y = 0.0f;
-      viewport.width = (float)win->plat->swapChainExtent.width;
-      viewport.height = (float)win->plat->swapChainExtent.height;
-      viewport.minDepth = 0.0f;
-      viewport.maxDepth = 1.0f;
-      vkCmdSetViewport(cmd, 0, 1, &viewport);
-
-      VkRect2D scissor = {0};
-      scissor.offset = (VkOffset2D){0, 0};
-      scissor.extent = win->plat->swapChainExtent;
-      vkCmdSetScissor(cmd, 0, 1, &scissor);
-
-      /* Execute render graph */
-      cj_result_t result = cj_rgraph_execute(win->render_graph, cmd, extent);
-
-      /* End render pass and command buffer */
-      vkCmdEndRenderPass(cmd);
-      if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
-        printf("WINDOWS FIX: Failed to end command buffer for render graph\n");
-        /* Fall back to legacy drawing if command buffer end fails */
-        plat_drawFrameForWindow(win->plat);
-        return CJ_SUCCESS;
+  /* Inside an engine frame the window is drawn with the others at its end */
+  if (g_engine_frame.engine) {
+    if (win->frame_queued) return CJ_SUCCESS;
+    if (g_engine_frame.count == g_engine_frame.capacity) {
+      uint32_t capacity = g_engine_frame.capacity ? g_engine_frame.capacity * 2 : 8;
+      cj_window_t ** grown = (cj_window_t **)realloc(g_engine_frame.windows, capacity * sizeof(cj_window_t *));
+      if (grown) {
+        cj_heap_note_alloc();
+        g_engine_frame.windows = grown;
+        g_engine_frame.capacity = capacity;
       }
+    }
+    /* Out of memory: draw it on its own */
+    if (g_engine_frame.count < g_engine_frame.capacity) {
+      g_engine_frame.windows[g_engine_frame.count++] = win;
+      win->frame_queued = true;
+      return CJ_SUCCESS;
+    }
+  }
 
-      if (result != CJ_SUCCESS) {
-        printf("WINDOWS FIX: Render graph execution failed (result=%d), falling back to legacy\n", result);
-        /* Fall back to legacy drawing if render graph execution fails */
-        plat_drawFrameForWindow(win->plat);
-      } else {
-        /* Submit and present the command buffer (same as legacy path) */
-        VkSemaphore waitS[] = { win->plat->imageAvailableSemaphore };
-        VkPipelineStageFlags stages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        VkSubmitInfo si = {0};
-        si.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        si.waitSemaphoreCount = 1;
-        si.pWaitSemaphores = waitS;
-        si.pWaitDstStageMask = stages;
-        si.commandBufferCount = 1;
-        si.pCommandBuffers = &win->plat->commandBuffers[imageIndex];
-        VkSemaphore sigS[] = { win->plat->renderFinishedSemaphore };
-        si.signalSemaphoreCount = 1;
-        si.pSignalSemaphores = sigS;
-        vkQueueSubmit(cj_engine_graphics_queue(cj_engine_get_current()), 1, &si, win->plat->inFlightFence);
-        VkPresentInfoKHR pi = {0};
-        pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-        pi.waitSemaphoreCount = 1;
-        pi.pWaitSemaphores = sigS;
-        pi.swapchainCount = 1;
-        pi.pSwapchains = &win->plat->swapChain;
-        pi.pImageIndices = &imageIndex;
-        vkQueuePresentKHR(cj_engine_present_queue(cj_engine_get_current()), &pi);
+  if (!cj_window__prepare_frame(win)) return CJ_SUCCESS;
+  cj_window__record_frame(win);
+  if (win->plat->framePending) {
+    win->plat->framePending = false;
+    return plat_submitFrameForWindow(win->plat, win->plat->pendingCmd, win->plat->pendingImageIndex);
+  }
+  return CJ_SUCCESS;
+}
+
+/* A recording job: windows sharing a render graph are recorded one after another */
+typedef struct {
+  cj_window_t ** windows;
+  uint32_t count;
+} cj_window_record_job_t;
+
+static void cj_window__record_job(void * user, uint32_t index) {
+  cj_window_record_job_t * job = &((cj_window_record_job_t *)user)[index];
+  /* Recording is frame work, whichever thread runs it */
+  bool counted = cj_heap_count_thread(true);
+  for (uint32_t i = 0; i < job->count; i++) {
+    cj_window__record_frame(job->windows[i]);
+  }
+  cj_heap_count_thread(counted);
+}
+
+cj_result_t cj_window__execute_batch(cj_window_t ** windows, uint32_t count) {
+  if (!windows || count == 0) return CJ_SUCCESS;
+  cj_engine_t * engine = cj_engine_get_current();
+  if (!engine) return CJ_E_INVALID_ARGUMENT;
+
+  /* Scratch: the windows reordered by job, the jobs, then submit/present arrays */
+  size_t bytes = count * (sizeof(cj_window_t *) + sizeof(cj_window_record_job_t) + sizeof(VkSubmitInfo) +
+      sizeof(VkPresentRegionKHR) + sizeof(VkPresentTimeGOOGLE) + sizeof(VkSemaphore) + sizeof(VkSwapchainKHR) +
+      sizeof(uint32_t) + sizeof(VkResult));
+  cj_window_t ** ordered = (cj_window_t **)cj_arena_alloc(cj_engine_frame_arena(engine), bytes, 0);
+  bool heapScratch = !ordered;
+  if (heapScratch) {
+    /* Outside engine frames there is no frame arena */
+    ordered = (cj_window_t **)malloc(bytes);
+    if (!ordered) return CJ_E_OUT_OF_MEMORY;
+    cj_heap_note_alloc();
+  }
+  cj_window_record_job_t * jobs = (cj_window_record_job_t *)(void *)(ordered + count);
+  VkSubmitInfo * submits = (VkSubmitInfo *)(void *)(jobs + count);
+  VkPresentRegionKHR * regions = (VkPresentRegionKHR *)(void *)(submits + count);
+  VkPresentTimeGOOGLE * presentTimes = (VkPresentTimeGOOGLE *)(void *)(regions + count);
+  VkSemaphore * waits = (VkSemaphore *)(void *)(presentTimes + count);
+  VkSwapchainKHR * swapchains = (VkSwapchainKHR *)(void *)(waits + count);
+  uint32_t * indices = (uint32_t *)(void *)(swapchains + count);
+  VkResult * results = (VkResult *)(void *)(indices + count);
+
+  /* Swapchain rebuilds and graph compilation stay on the main thread */
+  uint32_t ready = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    cj_window_t * win = windows[i];
+    if (!win || win->is_destroyed || !win->plat) continue;
+    if (!cj_window__prepare_frame(win)) continue;
+    windows[ready++] = win;
+  }
+
+  /* Graphs keep per-frame state, so every window drawing a graph joins its job */
+  uint32_t jobCount = 0, placed = 0;
+  for (uint32_t i = 0; i < ready; i++) {
+    cj_window_t * win = windows[i];
+    if (!win) continue;
+    jobs[jobCount].windows = &ordered[placed];
+    jobs[jobCount].count = 0;
+    for (uint32_t j = i; j < ready; j++) {
+      cj_window_t * other = windows[j];
+      if (!other || (j != i && (!win->render_graph || other->render_graph != win->render_graph))) continue;
+      ordered[placed++] = other;
+      jobs[jobCount].count++;
+      windows[j] = NULL;
+    }
+    jobCount++;
+  }
+
+  cj_worker_pool_parallel_for(cj_engine_workers(engine), jobCount, cj_window__record_job, jobs);
+
+  /* One submission and one present for every window that recorded a frame */
+  uint32_t pending = 0;
+  bool anyRegion = false, allTimes = true;
+  for (uint32_t i = 0; i < placed; i++) {
+    CJPlatformWindow * plat = ordered[i]->plat;
+    if (!plat->framePending) continue;
+    plat_collectRetiredSwapchains(plat, false);
+    plat_fillFrameSubmitInfo(plat, &submits[pending], &plat->pendingCmd);
+    waits[pending] = plat->renderFinishedSemaphores[plat->pendingImageIndex];
+    swapchains[pending] = plat->swapChain;
+    indices[pending] = plat->pendingImageIndex;
+    results[pending] = VK_SUCCESS;
+    if (plat_fillPresentRegion(plat, &regions[pending])) anyRegion = true;
+    if (!plat_fillPresentTime(plat, &presentTimes[pending])) allTimes = false;
+    ordered[pending++] = ordered[i];
+  }
+
+  cj_result_t status = CJ_SUCCESS;
+  if (pending > 0) {
+    cj_upload_queue_flush(cj_engine_uploads(engine));
+    uint64_t batch = cj_engine_submit_batch(engine, pending, submits);
+    if (batch == 0) {
+      fprintf(stderr, "cj_window__execute_batch: failed to submit %u frames\n", pending);
+      status = CJ_E_UNKNOWN;
+    }
+    /* Compute work the graphs recorded follows the frames that feed it */
+    for (uint32_t i = 0; i < pending; i++) {
+      CJPlatformWindow * plat = ordered[i]->plat;
+      cj_rgraph__submit_async(plat->pendingGraph, status == CJ_SUCCESS);
+      plat->pendingGraph = NULL;
+    }
+
+    VkPresentInfoKHR pi = {0};
+    pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    pi.waitSemaphoreCount = pending;
+    pi.pWaitSemaphores = waits;
+    pi.swapchainCount = pending;
+    pi.pSwapchains = swapchains;
+    pi.pImageIndices = indices;
+    pi.pResults = results;
+    /* Windows redrawn in full keep rectangleCount 0 */
+    VkPresentRegionsKHR presentRegions = {0};
+    if (anyRegion) {
+      presentRegions.sType = VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR;
+      presentRegions.swapchainCount = pending;
+      presentRegions.pRegions = regions;
+      pi.pNext = &presentRegions;
+    }
+    /* Every swapchain needs an entry, so only when all of them report timing */
+    VkPresentTimesInfoGOOGLE times = {0};
+    if (allTimes) {
+      times.sType = VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE;
+      times.pNext = pi.pNext;
+      times.swapchainCount = pending;
+      times.pTimes = presentTimes;
+      pi.pNext = &times;
+    }
+    if (status == CJ_SUCCESS && vkQueuePresentKHR(cj_engine_present_queue(engine), &pi) == VK_ERROR_DEVICE_LOST) {
+      fprintf(stderr, "cj_window__execute_batch: device lost presenting %u frames\n", pending);
+      status = CJ_E_DEVICE_LOST;
+    }
+
+    for (uint32_t i = 0; i < pending; i++) {
+      CJPlatformWindow * plat = ordered[i]->plat;
+      uint32_t frame = plat->currentFrame;
+      if (batch == 0) {
+        plat_abandonFrameForWindow(plat, true);
+        continue;
       }
-    } else {
-      /* Fall back to legacy drawing if no command buffers available */
-      plat_drawFrameForWindow(win->plat);
+      plat->framePending = false;
+      plat_noteFrameSubmitted(plat);
+      plat->frameSerials[frame] = ++plat->submitSerial;
+      plat->frameBatchSerials[frame] = batch;
+      if (plat_notePresentResult(plat, results[i]) != CJ_SUCCESS) status = CJ_E_DEVICE_LOST;
+      plat->currentFrame = (frame + 1) % plat->framesInFlight;
     }
-  } else {
-    /* Legacy path: direct drawing */
-    printf("DEBUG: Using legacy rendering path\n");
-    plat_drawFrameForWindow(win->plat);
   }
 
+  if (heapScratch) free(ordered);
+  return status;
+}
+
+CJ_API cj_result_t cj_engine_begin_frame(cj_engine_t* engine) {
+  if (!engine) return CJ_E_INVALID_ARGUMENT;
+  if (g_engine_frame.engine) return CJ_E_BUSY;
+  cj_engine_start_frame_memory(engine);
+  g_engine_frame.engine = engine;
+  g_engine_frame.count = 0;
   return CJ_SUCCESS;
 }
 
+CJ_API cj_result_t cj_engine_end_frame(cj_engine_t* engine) {
+  if (!engine || g_engine_frame.engine != engine) return CJ_E_INVALID_ARGUMENT;
+  g_engine_frame.engine = NULL;
+  uint32_t count = g_engine_frame.count;
+  g_engine_frame.count = 0;
+  for (uint32_t i = 0; i < count; i++) g_engine_frame.windows[i]->frame_queued = false;
+  cj_result_t status = cj_window__execute_batch(g_engine_frame.windows, count);
+  cj_engine_end_frame_memory(engine);
+  return status;
+}
+
 CJ_API cj_result_t cj_window_present(cj_window_t* win) {
   (void)win; /* drawFrameForWindow presents already */
   return CJ_SUCCESS;
@@ -1915,13 +3112,47 @@ CJ_API void cj_window_mark_dirty(cj_window_t* window) {
 
 CJ_API void cj_window_mark_dirty_with_reason(cj_window_t* window, cj_render_reason_t reason) {
   if (!window || !window->plat || window->is_destroyed) return;
-  window->plat->needsRedraw = 1;
+  plat_markFullRedraw(window->plat);
   window->pending_render_reason = reason;
 }
 
+CJ_API void cj_window_post_redraw(cj_window_t* window) {
+  if (!window) return;
+  /* Only the flag is touched here; the event loop marks the window dirty on its own thread */
+  atomic_store(&window->redraw_posted, true);
+  cj_wake();
+}
+
+CJ_API void cj_window_mark_dirty_rect(cj_window_t* window, int32_t x, int32_t y, uint32_t width, uint32_t height) {
+  if (!window || !window->plat || window->is_destroyed) return;
+  if (width == 0 || height == 0) return;
+  CJPlatformWindow * plat = window->plat;
+  window->pending_render_reason = CJ_RENDER_REASON_FORCED;
+  /* A pending full redraw already covers the rectangle */
+  if (plat->needsRedraw && !plat->dirtyPartial) return;
+
+  VkRect2D rect = {{x, y}, {width, height}};
+  if (plat->dirtyRectCount < CJ_WINDOW_MAX_DIRTY_RECTS) {
+    plat->dirtyRects[plat->dirtyRectCount++] = rect;
+  } else {
+    /* Out of slots: grow the rectangle whose bounds grow least */
+    uint32_t best = 0;
+    uint64_t bestGrowth = UINT64_MAX;
+    for (uint32_t i = 0; i < plat->dirtyRectCount; i++) {
+      uint64_t growth = plat_rectArea(plat_rectUnion(plat->dirtyRects[i], rect)) - plat_rectArea(plat->dirtyRects[i]);
+      if (growth < bestGrowth) { bestGrowth = growth; best = i; }
+    }
+    plat->dirtyRects[best] = plat_rectUnion(plat->dirtyRects[best], rect);
+  }
+  plat->dirtyPartial = true;
+  plat->needsRedraw = 1;
+}
+
 CJ_API void cj_window_clear_dirty(cj_window_t* window) {
   if (!window || !window->plat || window->is_destroyed) return;
   window->plat->needsRedraw = 0;
+  window->plat->dirtyPartial = false;
+  window->plat->dirtyRectCount = 0;
   /* Reset render reason to TIMER for next render */
   window->pending_render_reason = CJ_RENDER_REASON_TIMER;
 }
@@ -1950,6 +3181,17 @@ CJ_API void cj_window_get_size(const cj_window_t* win, uint32_t* out_w, uint32_t
   if (out_h) *out_h = (uint32_t)win->plat->height;
 }
 
+CJ_API cj_surface_format_t cj_window_get_surface_format(const cj_window_t* win) {
+  if (!win || !win->plat) return CJ_SURFACE_FORMAT_DEFAULT;
+  switch (win->plat->surfaceFormat.format) {
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+    case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+      return CJ_SURFACE_FORMAT_10BIT;
+    default:
+      return CJ_SURFACE_FORMAT_DEFAULT;
+  }
+}
+
 CJ_API void cj_window_get_position(const cj_window_t* window, int32_t* out_x, int32_t* out_y) {
   if (!window || !window->plat) {
     if (out_x) *out_x = 0;
@@ -2176,6 +3418,25 @@ CJ_API uint64_t cj_window_frame_index(const cj_window_t* win) {
   return win ? win->frame_index : 0u;
 }
 
+CJ_API cj_result_t cj_profiler_window_stats(cj_window_t* window, cj_profiler_frame_stats_t* out_stats) {
+  if (!window || window->is_destroyed || !window->plat || !out_stats) return CJ_E_INVALID_ARGUMENT;
+  *out_stats = window->plat->profileStats;
+  return CJ_SUCCESS;
+}
+
+/* The input thread reads the input callbacks; it is stopped while one changes, so it
+ * never sees a callback with the other's user data. False when there was none to stop. */
+static bool window_pauseInput(cj_window_t* window) {
+  if (!cj_input_queue_threaded(window->input) || cj_input_queue_on_thread(window->input)) return false;
+  return cj_input_queue_set_thread(window->input, false);
+}
+
+static void window_resumeInput(cj_window_t* window, bool paused) {
+  if (paused && !cj_input_queue_set_thread(window->input, true)) {
+    fprintf(stderr, "cj_window: input thread did not restart; input is delivered by cj_poll_events()\n");
+  }
+}
+
 CJ_API void cj_window_on_close(cj_window_t* window,
                                  cj_window_close_callback_t callback,
                                  void* user_data) {
@@ -2196,32 +3457,40 @@ CJ_API void cj_window_on_resize(cj_window_t* window,
                                 cj_window_resize_callback_t callback,
                                 void* user_data) {
   if (!window) return;
+  bool paused = window_pauseInput(window);
   window->resize_callback = callback;
   window->resize_callback_user_data = user_data;
+  window_resumeInput(window, paused);
 }
 
 CJ_API void cj_window_on_move(cj_window_t* window,
                               cj_window_move_callback_t callback,
                               void* user_data) {
   if (!window) return;
+  bool paused = window_pauseInput(window);
   window->move_callback = callback;
   window->move_callback_user_data = user_data;
+  window_resumeInput(window, paused);
 }
 
 CJ_API void cj_window_on_state_change(cj_window_t* window,
                                       cj_window_state_callback_t callback,
                                       void* user_data) {
   if (!window) return;
+  bool paused = window_pauseInput(window);
   window->state_callback = callback;
   window->state_callback_user_data = user_data;
+  window_resumeInput(window, paused);
 }
 
 CJ_API void cj_window_on_key(cj_window_t* window,
                              cj_key_callback_t callback,
                              void* user_data) {
   if (!window) return;
+  bool paused = window_pauseInput(window);
   window->key_callback = callback;
   window->key_callback_user_data = user_data;
+  window_resumeInput(window, paused);
 }
 
 /* Internal helper for the framework event loop. */
@@ -2245,10 +3514,8 @@ bool cj_window__is_minimized(cj_window_t* window) {
  */
 bool cj_window__uses_vsync(cj_window_t* window) {
   if (!window || !window->plat || window->is_destroyed) return false;
-  // For now, we always use FIFO (VSync) mode. In the future, we could
-  // store the present mode when creating the swapchain and check it here.
-  (void)window;  // Suppress unused warning
-  return true;  // FIFO is VSync
+  return window->plat->presentMode == VK_PRESENT_MODE_FIFO_KHR ||
+         window->plat->presentMode == VK_PRESENT_MODE_FIFO_RELAXED_KHR;
 }
 
 /* Internal helper to check if a window needs redraw. */
@@ -2281,14 +3548,25 @@ void cj_window__set_minimized(cj_window_t* window, bool minimized) {
 /* Internal helper to update window size and mark swapchain for recreation. */
 void cj_window__update_size_and_mark_recreate(cj_window_t* window, uint32_t new_width, uint32_t new_height) {
   if (!window || !window->plat || window->is_destroyed) return;
+  /* Only the latest size matters: the swapchain is rebuilt once on the next
+   * frame no matter how many resize events arrive before it */
   window->plat->width = (int)new_width;
   window->plat->height = (int)new_height;
   window->plat->needs_swapchain_recreate = true;
   /* Mark window dirty for redraw after resize */
-  window->plat->needsRedraw = 1;
+  plat_markFullRedraw(window->plat);
   window->pending_render_reason = CJ_RENDER_REASON_RESIZE;
 }
 
+/* Queue an event for the next dispatch; without a queue it is delivered right away */
+static void window_queueInput(cj_window_t* window, const cj_input_event_t* event) {
+  if (!window->input) {
+    window_deliverInput(window, event);
+    return;
+  }
+  cj_input_queue_push(window->input, event);
+}
+
 /* Internal helper to dispatch resize callback. */
 void cj_window__dispatch_resize_callback(cj_window_t* window, uint32_t new_width, uint32_t new_height) {
   if (!window || window->is_destroyed || !window->plat) return;
@@ -2297,26 +3575,31 @@ void cj_window__dispatch_resize_callback(cj_window_t* window, uint32_t new_width
    * to avoid blocking the window message handler during resize drag. The flag should be set
    * by the caller (WM_SIZE/ConfigureNotify handler) before calling this function. */
 
-  /* Dispatch user callback */
-  if (window->resize_callback) {
-    window->resize_callback(window, new_width, new_height, window->resize_callback_user_data);
-  }
+  /* The callback runs at the next dispatch, once for a run of resizes */
+  cj_input_event_t event = {0};
+  event.kind = CJ_INPUT_RESIZE;
+  event.u.size.width = new_width;
+  event.u.size.height = new_height;
+  window_queueInput(window, &event);
 }
 
 /* Internal helper to dispatch move callback. */
 void cj_window__dispatch_move_callback(cj_window_t* window, int32_t new_x, int32_t new_y) {
   if (!window || window->is_destroyed || !window->plat) return;
-  if (window->move_callback) {
-    window->move_callback(window, new_x, new_y, window->move_callback_user_data);
-  }
+  cj_input_event_t event = {0};
+  event.kind = CJ_INPUT_MOVE;
+  event.u.position.x = new_x;
+  event.u.position.y = new_y;
+  window_queueInput(window, &event);
 }
 
 /* Internal helper to dispatch state change callback. */
 void cj_window__dispatch_state_callback(cj_window_t* window, cj_window_state_t new_state) {
   if (!window || window->is_destroyed || !window->plat) return;
-  if (window->state_callback) {
-    window->state_callback(window, new_state, window->state_callback_user_data);
-  }
+  cj_input_event_t event = {0};
+  event.kind = CJ_INPUT_STATE;
+  event.u.state = new_state;
+  window_queueInput(window, &event);
 }
 
 /* Internal helper functions for key state tracking (for repeat detection on X11) */
@@ -2347,30 +3630,32 @@ void cj_window__dispatch_key_callback(cj_window_t* window,
                                      bool is_repeat) {
   if (!window || window->is_destroyed) return;
 
-  if (window->key_callback) {
-    cj_key_event_t event = {0};
-    event.keycode = keycode;
-    event.scancode = scancode;
-    event.action = action;
-    event.modifiers = modifiers;
-    event.is_repeat = is_repeat;
-
-    window->key_callback(window, &event, window->key_callback_user_data);
-  }
+  cj_input_event_t event = {0};
+  event.kind = CJ_INPUT_KEY;
+  event.u.key.keycode = keycode;
+  event.u.key.scancode = scancode;
+  event.u.key.action = action;
+  event.u.key.modifiers = modifiers;
+  event.u.key.is_repeat = is_repeat;
+  window_queueInput(window, &event);
 }
 
 /* Mouse callback registration */
 CJ_API void cj_window_on_mouse(cj_window_t* window, cj_mouse_callback_t callback, void* user_data) {
   if (!window) return;
+  bool paused = window_pauseInput(window);
   window->mouse_callback = callback;
   window->mouse_callback_user_data = user_data;
+  window_resumeInput(window, paused);
 }
 
 /* Focus callback registration */
 CJ_API void cj_window_on_focus(cj_window_t* window, cj_focus_callback_t callback, void* user_data) {
   if (!window) return;
+  bool paused = window_pauseInput(window);
   window->focus_callback = callback;
   window->focus_callback_user_data = user_data;
+  window_resumeInput(window, paused);
 }
 
 /* Internal helper functions for mouse button state tracking */
@@ -2405,9 +3690,12 @@ void cj_window__dispatch_mouse_callback(cj_window_t* window, const cj_mouse_even
     cj_window__set_mouse_button_pressed(window, event->button, false);
   }
 
-  if (window->mouse_callback) {
-    window->mouse_callback(window, event, window->mouse_callback_user_data);
-  }
+  /* State above is the platform's view and is updated now; the callback waits for the
+   * next dispatch, which merges runs of motion into one event */
+  cj_input_event_t queued = {0};
+  queued.kind = CJ_INPUT_MOUSE;
+  queued.u.mouse = *event;
+  window_queueInput(window, &queued);
 }
 
 /* Internal helper to dispatch focus callback. */
@@ -2419,11 +3707,76 @@ void cj_window__dispatch_focus_callback(cj_window_t* window, cj_focus_action_t a
     cj_window__clear_input_state(window);
   }
 
-  if (window->focus_callback) {
-    cj_focus_event_t event = {0};
-    event.action = action;
-    window->focus_callback(window, &event, window->focus_callback_user_data);
+  cj_input_event_t event = {0};
+  event.kind = CJ_INPUT_FOCUS;
+  event.u.focus = action;
+  window_queueInput(window, &event);
+}
+
+/* Deliver a queued (and possibly coalesced) event to the window's callbacks */
+static void window_deliverInput(void * target, const cj_input_event_t * event) {
+  cj_window_t * window = (cj_window_t *)target;
+  if (window->is_destroyed || atomic_load(&window->destroy_requested)) return;
+  switch (event->kind) {
+    case CJ_INPUT_MOUSE:
+      /* The callback may destroy the window, so nothing touches it afterwards */
+      if (window->mouse_callback) window->mouse_callback(window, &event->u.mouse, window->mouse_callback_user_data);
+      break;
+    case CJ_INPUT_KEY:
+      if (window->key_callback) window->key_callback(window, &event->u.key, window->key_callback_user_data);
+      break;
+    case CJ_INPUT_FOCUS:
+      if (window->focus_callback) {
+        cj_focus_event_t focus = {0};
+        focus.action = event->u.focus;
+        window->focus_callback(window, &focus, window->focus_callback_user_data);
+      }
+      break;
+    case CJ_INPUT_RESIZE:
+      if (window->resize_callback) {
+        window->resize_callback(window, event->u.size.width, event->u.size.height, window->resize_callback_user_data);
+      }
+      break;
+    case CJ_INPUT_MOVE:
+      if (window->move_callback) {
+        window->move_callback(window, event->u.position.x, event->u.position.y, window->move_callback_user_data);
+      }
+      break;
+    case CJ_INPUT_STATE:
+      if (window->state_callback) window->state_callback(window, event->u.state, window->state_callback_user_data);
+      break;
+  }
+}
+
+/* Internal helper to deliver the input queued since the last dispatch. */
+void cj_window__dispatch_input(cj_window_t* window) {
+  if (!window || window->is_destroyed) return;
+  if (atomic_load(&window->destroy_requested)) {
+    cj_window_destroy(window);
+    return;
   }
+  if (!window->input) return;
+  /* With an input thread this only wakes it */
+  cj_input_queue_notify(window->input);
+  cj_input_queue_dispatch(window->input);
+}
+
+CJ_API void cj_window_set_input_history(cj_window_t* window, bool enabled) {
+  if (!window || !window->input) return;
+  cj_input_queue_set_history(window->input, enabled);
+}
+
+CJ_API uint32_t cj_window_get_input_history(cj_window_t* window, const cj_mouse_event_t** out_samples) {
+  if (out_samples) *out_samples = NULL;
+  if (!window || !window->input) return 0u;
+  return cj_input_queue_history(window->input, out_samples);
+}
+
+CJ_API cj_result_t cj_window_set_input_thread(cj_window_t* window, bool enabled) {
+  if (!window || window->is_destroyed) return CJ_E_INVALID_ARGUMENT;
+  if (!window->input) return CJ_E_UNSUPPORTED;
+  if (cj_input_queue_on_thread(window->input)) return CJ_E_INVALID_ARGUMENT;  /* It would wait for itself */
+  return cj_input_queue_set_thread(window->input, enabled) ? CJ_SUCCESS : CJ_E_UNKNOWN;
 }
 
 /* Internal helper to clear all input state (keys and mouse buttons) on focus loss. */
@@ -2642,6 +3995,41 @@ bool cj_window__can_render_at_fps(cj_window_t* window, uint64_t current_time_us)
   return (time_since_last_render >= min_frame_time_us);
 }
 
+/* Internal helper to turn a cross-thread redraw request into a dirty mark. */
+bool cj_window__take_posted_redraw(cj_window_t* window) {
+  if (!window || window->is_destroyed) return false;
+  if (!atomic_exchange(&window->redraw_posted, false)) return false;
+  cj_window_mark_dirty_with_reason(window, CJ_RENDER_REASON_FORCED);
+  return true;
+}
+
+/* Internal helper to find when the event loop next has work for a window. */
+uint64_t cj_window__next_wake_time_us(cj_window_t* window, uint64_t current_time_us, uint64_t loop_interval_us) {
+  if (!window || !window->plat || window->is_destroyed) return UINT64_MAX;
+
+  if (cj_window__needs_redraw(window)) {
+    /* Renders as soon as its FPS limit allows */
+    if (cj_window__should_bypass_fps_limit(cj_window__get_pending_render_reason(window)) ||
+        cj_window__can_render_at_fps(window, current_time_us)) {
+      return current_time_us;
+    }
+    return window->last_render_time_us + 1000000ULL / (uint64_t)window->max_fps;
+  }
+
+  /* Clean CJ_REDRAW_ON_EVENTS windows poll their callback at the loop rate */
+  if (window->redraw_policy == CJ_REDRAW_ON_EVENTS && window->frame_callback && loop_interval_us > 0) {
+    return current_time_us + loop_interval_us;
+  }
+  /* Nothing to do until an event or a posted redraw */
+  return UINT64_MAX;
+}
+
+/* Internal helper to read a window's frame timing. */
+const cj_frame_timing_t* cj_window__frame_timing(cj_window_t* window) {
+  if (!window || !window->plat || window->is_destroyed) return NULL;
+  return &window->plat->timing;
+}
+
 /* Internal helper to update the last render time for a window (used for FPS limiting). */
 void cj_window__update_last_render_time(cj_window_t* window, uint64_t render_time_us) {
   if (!window || window->is_destroyed) return;
@@ -2692,10 +4080,14 @@ bool cj_window__should_bypass_fps_limit(cj_render_reason_t reason) {
 static void cj_window__render_frame_immediate(cj_window_t* window) {
   if (!window || window->is_destroyed || !window->plat) return;
 
+  /* The main loop is not running, so deliver the input queued during the drag here */
+  cj_window__dispatch_input(window);
+  if (window->is_destroyed) return;
+
   /* Recreate swapchain if needed */
   if (window->plat->needs_swapchain_recreate) {
     plat_recreateSwapChainForWindow(window->plat);
-    window->plat->needs_swapchain_recreate = false;
+    if (window->plat->needs_swapchain_recreate) return;
   }
 
   /* Skip if minimized */
@@ -2791,9 +4183,11 @@ static bool createTexturedCommandBuffersForWindowCtx(CJPlatformWindow * win, con
       exit(EXIT_FAILURE);
     }
 
+    /* Legacy pipelines are built for ctx->renderPass; other surface formats only get the clear */
+    VkRenderPass renderPass = win->renderPass ? win->renderPass : ctx->renderPass;
     VkRenderPassBeginInfo renderPassInfo = {0};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = ctx->renderPass;
+    renderPassInfo.renderPass = renderPass;
     renderPassInfo.framebuffer = win->swapChainFramebuffers[i];
     renderPassInfo.renderArea.offset = (VkOffset2D){0, 0};
     renderPassInfo.renderArea.extent = win->swapChainExtent;
@@ -2816,17 +4210,19 @@ static bool createTexturedCommandBuffersForWindowCtx(CJPlatformWindow * win, con
     scissor.extent = win->swapChainExtent;
     vkCmdSetScissor(win->commandBuffers[i], 0, 1, &scissor);
 
-  CJellyTexturedResources* tx = cj_engine_textured(cj_engine_get_current());
-  VkDeviceSize offsets[] = {0};
-  vkCmdBindVertexBuffers(win->commandBuffers[i], 0, 1, &tx->vertexBuffer, offsets);
+  if (renderPass == ctx->renderPass) {
+    CJellyTexturedResources* tx = cj_engine_textured(cj_engine_get_current());
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(win->commandBuffers[i], 0, 1, &tx->vertexBuffer, offsets);
 
-  vkCmdBindPipeline(win->commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, tx->pipeline);
+    vkCmdBindPipeline(win->commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, tx->pipeline);
 
-  assert(tx->descriptorSet != VK_NULL_HANDLE);
-  assert(tx->pipelineLayout != VK_NULL_HANDLE);
-  vkCmdBindDescriptorSets(win->commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, tx->pipelineLayout, 0, 1, &tx->descriptorSet, 0, NULL);
+    assert(tx->descriptorSet != VK_NULL_HANDLE);
+    assert(tx->pipelineLayout != VK_NULL_HANDLE);
+    vkCmdBindDescriptorSets(win->commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, tx->pipelineLayout, 0, 1, &tx->descriptorSet, 0, NULL);
 
     vkCmdDraw(win->commandBuffers[i], 6, 1, 0, 0);
+  }
     vkCmdEndRenderPass(win->commandBuffers[i]);
 
     if (vkEndCommandBuffer(win->commandBuffers[i]) != VK_SUCCESS) {
@@ -2891,9 +4287,11 @@ static void createBindlessCommandBuffersForWindowCtx(CJPlatformWindow * win, con
       exit(EXIT_FAILURE);
     }
 
+    /* As for the textured buffers: other surface formats only get the clear */
+    VkRenderPass renderPass = win->renderPass ? win->renderPass : ctx->renderPass;
     VkRenderPassBeginInfo renderPassInfo = {0};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = ctx->renderPass;
+    renderPassInfo.renderPass = renderPass;
     renderPassInfo.framebuffer = win->swapChainFramebuffers[i];
     renderPassInfo.renderArea.offset = (VkOffset2D){0, 0};
     renderPassInfo.renderArea.extent = win->swapChainExtent;
@@ -2918,16 +4316,18 @@ static void createBindlessCommandBuffersForWindowCtx(CJPlatformWindow * win, con
     if (ctx->device == VK_NULL_HANDLE) { fprintf(stderr, "ERROR: device is NULL!\n"); exit(EXIT_FAILURE); }
     if (ctx->commandPool == VK_NULL_HANDLE) { fprintf(stderr, "ERROR: commandPool is NULL!\n"); exit(EXIT_FAILURE); }
 
-    vkCmdBindPipeline(win->commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, resources->pipeline);
+    if (renderPass == ctx->renderPass) {
+      vkCmdBindPipeline(win->commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, resources->pipeline);
 
-    float push[8] = { resources->uv[0], resources->uv[1], resources->uv[2], resources->uv[3],
-                      resources->colorMul[0], resources->colorMul[1], resources->colorMul[2], resources->colorMul[3] };
-    vkCmdPushConstants(win->commandBuffers[i], resources->pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), push);
+      float push[8] = { resources->uv[0], resources->uv[1], resources->uv[2], resources->uv[3],
+                        resources->colorMul[0], resources->colorMul[1], resources->colorMul[2], resources->colorMul[3] };
+      vkCmdPushConstants(win->commandBuffers[i], resources->pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), push);
 
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(win->commandBuffers[i], 0, 1, &resources->vertexBuffer, offsets);
+      VkDeviceSize offsets[] = {0};
+      vkCmdBindVertexBuffers(win->commandBuffers[i], 0, 1, &resources->vertexBuffer, offsets);
 
-    vkCmdDraw(win->commandBuffers[i], 6, 1, 0, 0);
+      vkCmdDraw(win->commandBuffers[i], 6, 1, 0, 0);
+    }
 
     vkCmdEndRenderPass(win->commandBuffers[i]);
 
@@ -0,0 +1,421 @@
+/* CJelly worker pool: a fixed set of threads running indexed work items and background jobs */
+
+#ifndef _WIN32
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#endif
+
+#include <cjelly/worker_pool_internal.h>
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define CJ_WORKER_POOL_MAX_DEFAULT_THREADS 8u
+/* Jobs a queue holds before it first grows (power of two) */
+#define CJ_WORKER_JOB_QUEUE_INITIAL 64u
+
+typedef struct pool_job_t {
+  cj_worker_job_fn_t fn;
+  void* user;
+} pool_job_t;
+
+/* A worker's jobs: the worker pops the newest, thieves take the oldest. Jobs
+ * run for milliseconds, so a lock per queue costs nothing next to them. */
+typedef struct pool_queue_t {
+#ifdef _WIN32
+  CRITICAL_SECTION lock;
+#else
+  pthread_mutex_t lock;
+#endif
+  pool_job_t* jobs;
+  uint32_t capacity;            /* Power of two */
+  uint32_t head;                /* Oldest job */
+  uint32_t count;
+} pool_queue_t;
+
+/* A worker thread and its job queue */
+typedef struct pool_worker_t {
+  cj_worker_pool_t* pool;
+  uint32_t index;
+#ifdef _WIN32
+  HANDLE thread;
+#else
+  pthread_t thread;
+#endif
+  pool_queue_t queue;
+} pool_worker_t;
+
+struct cj_worker_pool_t {
+  uint32_t thread_count;        /* Workers that started; only their queues are used */
+  uint32_t worker_count;        /* Workers allocated */
+  pool_worker_t* workers;
+#ifdef _WIN32
+  CRITICAL_SECTION lock;
+  CONDITION_VARIABLE work_cv;   /* Signaled when work is posted or the pool stops */
+  CONDITION_VARIABLE done_cv;   /* Signaled when the last worker leaves a job */
+#else
+  pthread_mutex_t lock;
+  pthread_cond_t work_cv;
+  pthread_cond_t done_cv;
+#endif
+
+  /* Current job, guarded by lock except for the index counter */
+  uint64_t generation;          /* Bumped for every posted job */
+  cj_worker_fn_t fn;
+  void* user;
+  uint32_t count;
+  atomic_uint next;             /* Next unclaimed work item */
+  uint32_t active;              /* Workers running items of the current job */
+  bool open;                    /* Workers may still join the current job */
+  bool stop;
+
+  atomic_uint queued;           /* Background jobs in all queues */
+  atomic_uint next_queue;       /* Round robin for jobs submitted from other threads */
+};
+
+/* Worker the calling thread is, so its submissions stay on its own queue */
+static _Thread_local const pool_worker_t* t_worker;
+
+static void pool_lock(cj_worker_pool_t* pool) {
+#ifdef _WIN32
+  EnterCriticalSection(&pool->lock);
+#else
+  pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+static void pool_unlock(cj_worker_pool_t* pool) {
+#ifdef _WIN32
+  LeaveCriticalSection(&pool->lock);
+#else
+  pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+static void pool_wait(cj_worker_pool_t* pool, bool done) {
+#ifdef _WIN32
+  SleepConditionVariableCS(done ? &pool->done_cv : &pool->work_cv, &pool->lock, INFINITE);
+#else
+  pthread_cond_wait(done ? &pool->done_cv : &pool->work_cv, &pool->lock);
+#endif
+}
+
+static void pool_wake_workers(cj_worker_pool_t* pool) {
+#ifdef _WIN32
+  WakeAllConditionVariable(&pool->work_cv);
+#else
+  pthread_cond_broadcast(&pool->work_cv);
+#endif
+}
+
+static void pool_wake_caller(cj_worker_pool_t* pool) {
+#ifdef _WIN32
+  WakeConditionVariable(&pool->done_cv);
+#else
+  pthread_cond_signal(&pool->done_cv);
+#endif
+}
+
+static void queue_lock(pool_queue_t* q) {
+#ifdef _WIN32
+  EnterCriticalSection(&q->lock);
+#else
+  pthread_mutex_lock(&q->lock);
+#endif
+}
+
+static void queue_unlock(pool_queue_t* q) {
+#ifdef _WIN32
+  LeaveCriticalSection(&q->lock);
+#else
+  pthread_mutex_unlock(&q->lock);
+#endif
+}
+
+static bool queue_push(pool_queue_t* q, pool_job_t job) {
+  queue_lock(q);
+  if (q->count == q->capacity) {
+    uint32_t capacity = q->capacity ? q->capacity * 2u : CJ_WORKER_JOB_QUEUE_INITIAL;
+    pool_job_t* grown = (pool_job_t*)malloc(sizeof(pool_job_t) * capacity);
+    if (!grown) {
+      queue_unlock(q);
+      return false;
+    }
+    for (uint32_t i = 0; i < q->count; i++) grown[i] = q->jobs[(q->head + i) & (q->capacity - 1u)];
+    free(q->jobs);
+    q->jobs = grown;
+    q->capacity = capacity;
+    q->head = 0;
+  }
+  q->jobs[(q->head + q->count) & (q->capacity - 1u)] = job;
+  q->count++;
+  queue_unlock(q);
+  return true;
+}
+
+/* Take the newest job (the owner, whose caches still hold it) or the oldest (a thief) */
+static bool queue_take(pool_queue_t* q, bool newest, pool_job_t* out) {
+  queue_lock(q);
+  bool taken = q->count > 0;
+  if (taken) {
+    if (newest) {
+      *out = q->jobs[(q->head + q->count - 1u) & (q->capacity - 1u)];
+    } else {
+      *out = q->jobs[q->head];
+      q->head = (q->head + 1u) & (q->capacity - 1u);
+    }
+    q->count--;
+  }
+  queue_unlock(q);
+  return taken;
+}
+
+/* A job from queue first, else stolen from the others in turn */
+static bool pool_take_job(cj_worker_pool_t* pool, uint32_t first, bool own, pool_job_t* out) {
+  if (atomic_load_explicit(&pool->queued, memory_order_acquire) == 0) return false;
+  for (uint32_t i = 0; i < pool->thread_count; i++) {
+    if (queue_take(&pool->workers[(first + i) % pool->thread_count].queue, own && i == 0, out)) {
+      atomic_fetch_sub_explicit(&pool->queued, 1u, memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Claim and run work items until the current job is exhausted */
+static void pool_drain(cj_worker_pool_t* pool, cj_worker_fn_t fn, void* user, uint32_t count) {
+  for (;;) {
+    uint32_t index = atomic_fetch_add(&pool->next, 1u);
+    if (index >= count) break;
+    fn(user, index);
+  }
+}
+
+/* Frame work first, since its caller is waiting; background jobs in between */
+static void pool_worker_loop(pool_worker_t* self) {
+  cj_worker_pool_t* pool = self->pool;
+  t_worker = self;
+  uint64_t seen = 0;
+  pool_lock(pool);
+  for (;;) {
+    while (!pool->stop && pool->generation == seen && atomic_load_explicit(&pool->queued, memory_order_acquire) == 0) {
+      pool_wait(pool, false);
+    }
+    if (pool->stop) break;
+    if (pool->generation != seen) {
+      seen = pool->generation;
+      /* A job posted while this worker ran a background job may already be over */
+      if (!pool->open) continue;
+      cj_worker_fn_t fn = pool->fn;
+      void* user = pool->user;
+      uint32_t count = pool->count;
+      pool->active++;
+      pool_unlock(pool);
+
+      pool_drain(pool, fn, user, count);
+
+      pool_lock(pool);
+      if (--pool->active == 0) pool_wake_caller(pool);
+      continue;
+    }
+    pool_unlock(pool);
+
+    pool_job_t job;
+    if (pool_take_job(pool, self->index, true, &job)) job.fn(job.user);
+
+    pool_lock(pool);
+  }
+  pool_unlock(pool);
+  t_worker = NULL;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI pool_thread_main(LPVOID arg) {
+  pool_worker_loop((pool_worker_t*)arg);
+  return 0;
+}
+#else
+static void* pool_thread_main(void* arg) {
+  pool_worker_loop((pool_worker_t*)arg);
+  return NULL;
+}
+#endif
+
+uint32_t cj_worker_pool_default_threads(void) {
+  long cpus = 1;
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  cpus = (long)info.dwNumberOfProcessors;
+#else
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (cpus <= 1) return 1u;
+  uint32_t threads = (uint32_t)(cpus - 1);
+  return threads > CJ_WORKER_POOL_MAX_DEFAULT_THREADS ? CJ_WORKER_POOL_MAX_DEFAULT_THREADS : threads;
+}
+
+cj_worker_pool_t* cj_worker_pool_create(uint32_t thread_count) {
+  if (thread_count == 0) return NULL;
+  cj_worker_pool_t* pool = (cj_worker_pool_t*)calloc(1, sizeof(*pool));
+  if (!pool) return NULL;
+  pool->workers = (pool_worker_t*)calloc(thread_count, sizeof(pool_worker_t));
+  if (!pool->workers) {
+    free(pool);
+    return NULL;
+  }
+  atomic_init(&pool->next, 0u);
+  atomic_init(&pool->queued, 0u);
+  atomic_init(&pool->next_queue, 0u);
+
+#ifdef _WIN32
+  InitializeCriticalSection(&pool->lock);
+  InitializeConditionVariable(&pool->work_cv);
+  InitializeConditionVariable(&pool->done_cv);
+  for (uint32_t i = 0; i < thread_count; i++) InitializeCriticalSection(&pool->workers[i].queue.lock);
+#else
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work_cv, NULL);
+  pthread_cond_init(&pool->done_cv, NULL);
+  for (uint32_t i = 0; i < thread_count; i++) pthread_mutex_init(&pool->workers[i].queue.lock, NULL);
+#endif
+  pool->worker_count = thread_count;
+
+  /* Workers read thread_count only once work was posted, after this returned */
+  for (uint32_t i = 0; i < thread_count; i++) {
+    pool_worker_t* worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->index = i;
+#ifdef _WIN32
+    worker->thread = CreateThread(NULL, 0, pool_thread_main, worker, 0, NULL);
+    bool started = (worker->thread != NULL);
+#else
+    bool started = (pthread_create(&worker->thread, NULL, pool_thread_main, worker) == 0);
+#endif
+    if (!started) {
+      fprintf(stderr, "cj_worker_pool_create: failed to start worker thread %u\n", i);
+      break;
+    }
+    pool->thread_count++;
+  }
+
+  if (pool->thread_count == 0) {
+    cj_worker_pool_destroy(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+void cj_worker_pool_destroy(cj_worker_pool_t* pool) {
+  if (!pool) return;
+  pool_lock(pool);
+  pool->stop = true;
+  pool_wake_workers(pool);
+  pool_unlock(pool);
+
+  for (uint32_t i = 0; i < pool->thread_count; i++) {
+#ifdef _WIN32
+    WaitForSingleObject(pool->workers[i].thread, INFINITE);
+    CloseHandle(pool->workers[i].thread);
+#else
+    pthread_join(pool->workers[i].thread, NULL);
+#endif
+  }
+
+  for (uint32_t i = 0; i < pool->worker_count; i++) {
+#ifdef _WIN32
+    DeleteCriticalSection(&pool->workers[i].queue.lock);
+#else
+    pthread_mutex_destroy(&pool->workers[i].queue.lock);
+#endif
+    free(pool->workers[i].queue.jobs);
+  }
+#ifdef _WIN32
+  DeleteCriticalSection(&pool->lock);
+#else
+  pthread_cond_destroy(&pool->done_cv);
+  pthread_cond_destroy(&pool->work_cv);
+  pthread_mutex_destroy(&pool->lock);
+#endif
+  free(pool->workers);
+  free(pool);
+}
+
+uint32_t cj_worker_pool_size(const cj_worker_pool_t* pool) {
+  return pool ? pool->thread_count : 0u;
+}
+
+void cj_worker_pool_parallel_for(cj_worker_pool_t* pool, uint32_t count, cj_worker_fn_t fn, void* user) {
+  if (!fn || count == 0) return;
+
+  /* Not worth waking anyone for a single item */
+  if (!pool || count == 1) {
+    for (uint32_t i = 0; i < count; i++) fn(user, i);
+    return;
+  }
+
+  pool_lock(pool);
+  pool->fn = fn;
+  pool->user = user;
+  pool->count = count;
+  atomic_store(&pool->next, 0u);
+  pool->active = 0;
+  pool->open = true;
+  pool->generation++;
+  pool_wake_workers(pool);
+  pool_unlock(pool);
+
+  /* Workers busy with a background job join late or not at all; the caller finishes the rest */
+  pool_drain(pool, fn, user, count);
+
+  /* Items may still be running on workers that claimed them before the counter ran out */
+  pool_lock(pool);
+  pool->open = false;
+  while (pool->active > 0) pool_wait(pool, true);
+  pool_unlock(pool);
+}
+
+bool cj_worker_pool_submit(cj_worker_pool_t* pool, cj_worker_job_fn_t fn, void* user) {
+  if (!pool || !fn) return false;
+  uint32_t queue = (t_worker && t_worker->pool == pool)
+                       ? t_worker->index
+                       : atomic_fetch_add_explicit(&pool->next_queue, 1u, memory_order_relaxed) % pool->thread_count;
+  /* Counted first, so a thief taking the job at once never sees the count go below zero */
+  atomic_fetch_add_explicit(&pool->queued, 1u, memory_order_release);
+  pool_job_t job = { fn, user };
+  if (!queue_push(&pool->workers[queue].queue, job)) {
+    atomic_fetch_sub_explicit(&pool->queued, 1u, memory_order_relaxed);
+    return false;
+  }
+
+  /* Under the lock, so a worker about to sleep sees the job or the signal */
+  pool_lock(pool);
+#ifdef _WIN32
+  WakeConditionVariable(&pool->work_cv);
+#else
+  pthread_cond_signal(&pool->work_cv);
+#endif
+  pool_unlock(pool);
+  return true;
+}
+
+bool cj_worker_pool_run_one(cj_worker_pool_t* pool) {
+  if (!pool) return false;
+  bool own = t_worker && t_worker->pool == pool;
+  uint32_t first = own ? t_worker->index
+                       : atomic_load_explicit(&pool->next_queue, memory_order_relaxed) % pool->thread_count;
+  pool_job_t job;
+  if (!pool_take_job(pool, first, own, &job)) return false;
+  job.fn(job.user);
+  return true;
+}